@@ -0,0 +1,285 @@
+/**
+ * Benchmark nen message lon (MSG_COMPRESSED)
+ *
+ * Cach dung:
+ *   make compress-bench
+ *   ./compress_bench                   # payload tong hop cho tung loai message
+ *
+ * Moi loai message du dieu kien nen (xem compress_type_eligible) duoc dung
+ * bang codec giong server, sau do nen bang raw deflate voi nhieu muc level /
+ * cua so, do so byte tiet kiem va chi phi nen + giai nen moi message.
+ * Dong danh dau '*' la cau hinh server dang dung (COMPRESS_LEVEL, COMPRESS_WINDOW_BITS).
+ */
+#include "../include/compress.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 2000
+#define BENCH_BUFFER_SIZE (256 * 1024)
+
+typedef struct {
+    const char *name;
+    uint8_t *payload;
+    size_t len;
+} bench_message_t;
+
+typedef struct {
+    int level;
+    int window_bits;
+} bench_config_t;
+
+static const char *usernames[] = {"alice", "bob", "charlie", "dung", "minh_anh", "tran_van_b", "player42", "hoa"};
+static const char *avatars[] = {"avatar1.png", "avatar2.png", "cat.png", "default.png"};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint8_t *bench_alloc(void)
+{
+    uint8_t *buf = malloc(BENCH_BUFFER_SIZE);
+    if (!buf)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        exit(1);
+    }
+    return buf;
+}
+
+// ROOM_LIST_RESPONSE: [count:2] + count x room_info (giong room_list_frame)
+static bench_message_t build_room_list(const char *name, int room_count)
+{
+    uint8_t *buf = bench_alloc();
+    wire_writer_t w;
+    wire_writer_init(&w, buf, BENCH_BUFFER_SIZE);
+    wire_put_u16(&w, (uint16_t)room_count);
+    for (int i = 0; i < room_count; i++)
+    {
+        msg_room_info_t info = {
+            .room_id = 1000 + i,
+            .player_count = (uint8_t)(1 + i % 8),
+            .max_players = 8,
+            .state = (uint8_t)(i % 3 == 0),
+            .owner_id = 10 + i,
+        };
+        snprintf(info.room_name, sizeof(info.room_name), "Phong %d", i + 1);
+        snprintf(info.owner_username, sizeof(info.owner_username), "%s", usernames[i % 8]);
+        msg_room_info_write(&info, &w);
+    }
+
+    bench_message_t msg = {name, buf, w.len};
+    return msg;
+}
+
+// ROOM_PLAYERS_UPDATE day du, ban char[N] (v1) hoac chuoi gon (v2)
+static bench_message_t build_room_players(int compact)
+{
+    uint8_t *buf = bench_alloc();
+    wire_writer_t w;
+    wire_writer_init(&w, buf, BENCH_BUFFER_SIZE);
+    const int player_count = 8;
+
+    if (compact)
+    {
+        msg_room_players_header_v2_t header = {.room_id = 1001, .max_players = 8, .owner_id = 10, .player_count = player_count};
+        strcpy(header.room_name, "Phong ve tranh vui");
+        strcpy(header.changed_username, "alice");
+        msg_room_players_header_v2_write(&header, &w);
+    }
+    else
+    {
+        msg_room_players_header_t header = {.room_id = 1001, .max_players = 8, .owner_id = 10, .player_count = player_count};
+        strcpy(header.room_name, "Phong ve tranh vui");
+        strcpy(header.changed_username, "alice");
+        msg_room_players_header_write(&header, &w);
+    }
+
+    for (int i = 0; i < player_count; i++)
+    {
+        if (compact)
+        {
+            msg_player_info_v2_t player = {.user_id = 10 + i, .is_owner = (uint8_t)(i == 0), .is_active = 1};
+            strcpy(player.username, usernames[i % 8]);
+            strcpy(player.avatar, avatars[i % 4]);
+            msg_player_info_v2_write(&player, &w);
+        }
+        else
+        {
+            msg_player_info_t player = {.user_id = 10 + i, .is_owner = (uint8_t)(i == 0), .is_active = 1};
+            strcpy(player.username, usernames[i % 8]);
+            strcpy(player.avatar, avatars[i % 4]);
+            msg_player_info_write(&player, &w);
+        }
+    }
+
+    bench_message_t msg = {compact ? "PLAYERS_V2(8)" : "PLAYERS(8)", buf, w.len};
+    return msg;
+}
+
+// GAME_HISTORY_RESPONSE: [count:2] + count x history_entry (toi da 100 nhu protocol_history.c)
+static bench_message_t build_history(int count)
+{
+    uint8_t *buf = bench_alloc();
+    wire_writer_t w;
+    wire_writer_init(&w, buf, BENCH_BUFFER_SIZE);
+    msg_history_header_t header = {.count = (uint16_t)count};
+    msg_history_header_write(&header, &w);
+    for (int i = 0; i < count; i++)
+    {
+        msg_history_entry_t entry = {.score = (i * 37) % 500, .rank = 1 + i % 8};
+        snprintf(entry.finished_at, sizeof(entry.finished_at), "2024-%02d-%02d %02d:%02d:%02d",
+                 1 + i % 12, 1 + i % 28, i % 24, (i * 7) % 60, (i * 13) % 60);
+        msg_history_entry_write(&entry, &w);
+    }
+
+    bench_message_t msg = {"HISTORY(100)", buf, w.len};
+    return msg;
+}
+
+// ROUND_END: word + bang diem 8 nguoi
+static bench_message_t build_round_end(void)
+{
+    uint8_t *buf = bench_alloc();
+    wire_writer_t w;
+    wire_writer_init(&w, buf, BENCH_BUFFER_SIZE);
+    msg_round_end_header_t header = {.score_count = 8};
+    strcpy(header.word, "con meo");
+    msg_round_end_header_write(&header, &w);
+    for (int i = 0; i < 8; i++)
+    {
+        msg_score_entry_t entry = {.user_id = 10 + i, .score = 100 - i * 10};
+        msg_score_entry_write(&entry, &w);
+    }
+
+    bench_message_t msg = {"ROUND_END(8)", buf, w.len};
+    return msg;
+}
+
+// Nen mot payload, tra ve so byte deflate (0 neu loi)
+static size_t deflate_once(z_stream *zs, const bench_message_t *msg, uint8_t *out, size_t capacity)
+{
+    if (deflateReset(zs) != Z_OK)
+    {
+        return 0;
+    }
+    zs->next_in = msg->payload;
+    zs->avail_in = (uInt)msg->len;
+    zs->next_out = out;
+    zs->avail_out = (uInt)capacity;
+    if (deflate(zs, Z_FINISH) != Z_STREAM_END)
+    {
+        return 0;
+    }
+    return zs->total_out;
+}
+
+static int inflate_once(z_stream *zs, const uint8_t *in, size_t in_len, uint8_t *out, size_t raw_len)
+{
+    if (inflateReset(zs) != Z_OK)
+    {
+        return -1;
+    }
+    zs->next_in = (Bytef *)in;
+    zs->avail_in = (uInt)in_len;
+    zs->next_out = out;
+    zs->avail_out = (uInt)raw_len;
+    return inflate(zs, Z_FINISH) == Z_STREAM_END && zs->total_out == raw_len ? 0 : -1;
+}
+
+static int bench_config(const bench_message_t *msg, bench_config_t config, uint8_t *zbuf, uint8_t *rawbuf)
+{
+    z_stream dz, iz;
+    memset(&dz, 0, sizeof(dz));
+    memset(&iz, 0, sizeof(iz));
+    if (deflateInit2(&dz, config.level, Z_DEFLATED, -config.window_bits, COMPRESS_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK ||
+        inflateInit2(&iz, -config.window_bits) != Z_OK)
+    {
+        fprintf(stderr, "Loi: khoi tao zlib that bai\n");
+        return -1;
+    }
+
+    size_t zlen = 0;
+    double start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        zlen = deflate_once(&dz, msg, zbuf, BENCH_BUFFER_SIZE);
+    }
+    double deflate_us = (now_ns() - start) / BENCH_ITERATIONS / 1000.0;
+
+    start = now_ns();
+    int ok = zlen > 0;
+    for (int i = 0; ok && i < BENCH_ITERATIONS; i++)
+    {
+        ok = inflate_once(&iz, zbuf, zlen, rawbuf, msg->len) == 0;
+    }
+    double inflate_us = (now_ns() - start) / BENCH_ITERATIONS / 1000.0;
+
+    deflateEnd(&dz);
+    inflateEnd(&iz);
+    if (!ok || memcmp(rawbuf, msg->payload, msg->len) != 0)
+    {
+        fprintf(stderr, "Loi: giai nen %s khong khop ban goc\n", msg->name);
+        return -1;
+    }
+
+    size_t wire = COMPRESS_HEADER_SIZE + zlen;
+    int is_server = config.level == COMPRESS_LEVEL && config.window_bits == COMPRESS_WINDOW_BITS;
+    printf("%-14s %6zu %3d %4d %8zu %8.1f%% %10.2f %10.2f %s\n",
+           msg->name, msg->len, config.level, config.window_bits, wire,
+           100.0 * (1.0 - (double)wire / (double)msg->len), deflate_us, inflate_us,
+           is_server ? "*" : (msg->len < COMPRESS_MIN_PAYLOAD ? "(duoi nguong)" : ""));
+    return 0;
+}
+
+int main(void)
+{
+    bench_message_t messages[] = {
+        build_room_list("ROOM_LIST(10)", 10),
+        build_room_list("ROOM_LIST(100)", 100),
+        build_room_players(0),
+        build_room_players(1),
+        build_history(100),
+        build_round_end(),
+    };
+    const int message_count = (int)(sizeof(messages) / sizeof(messages[0]));
+
+    const bench_config_t configs[] = {
+        {1, COMPRESS_WINDOW_BITS},
+        {COMPRESS_LEVEL, COMPRESS_WINDOW_BITS},
+        {9, COMPRESS_WINDOW_BITS},
+        {COMPRESS_LEVEL, 15},
+    };
+    const int config_count = (int)(sizeof(configs) / sizeof(configs[0]));
+
+    uint8_t *zbuf = bench_alloc();
+    uint8_t *rawbuf = bench_alloc();
+
+    printf("Nguong nen: %d bytes | %d lan lap moi dong | '*' = cau hinh server\n\n", COMPRESS_MIN_PAYLOAD, BENCH_ITERATIONS);
+    printf("%-14s %6s %3s %4s %8s %9s %10s %10s\n",
+           "message", "raw", "lvl", "win", "wire", "tiet kiem", "nen (us)", "giai (us)");
+
+    int result = 0;
+    for (int m = 0; m < message_count; m++)
+    {
+        for (int c = 0; c < config_count; c++)
+        {
+            if (bench_config(&messages[m], configs[c], zbuf, rawbuf) != 0)
+            {
+                result = 1;
+            }
+        }
+        printf("\n");
+        free(messages[m].payload);
+    }
+
+    free(zbuf);
+    free(rawbuf);
+    return result;
+}
@@ -0,0 +1,927 @@
+/**
+ * Mo phong tron van game trong tien trinh: server that, dong ho ao, khong database
+ *
+ * Cach dung:
+ *   make sim
+ *   ./game_sim --games=5000 --players=4 --rounds=2 --seed=7
+ *   ./game_sim --games=200 --disconnect=30 --verbose > sim.log   # kem log server
+ *
+ * Toan bo server (room.c, game.c, protocol_*.c) chay trong tien trinh nay, moi nguoi
+ * choi la mot dau socketpair duoc dang ky bang server_add_client. Bench goi thang
+ * server_handle_client_data sau moi frame va server_tick sau moi buoc, nen khong co
+ * select() hay cho doi: dong ho ao (utils_clock_set_virtual) nhay --step-ms moi buoc,
+ * round 30 giay het gio ma khong ton 30 giay that. Server chay che do --no-db
+ * (guest_login), tu luon la tu du phong cua game.c.
+ *
+ * Moi van: dang nhap -> CREATE_ROOM -> JOIN_ROOM -> START_GAME -> cac round
+ * (drawer gui DRAW_DATA, nguoi doan chat sai hoac doan dung tu ma drawer nhan duoc
+ * trong GAME_START) -> GAME_END -> LEAVE_ROOM. --disconnect la ti le van co mot nguoi
+ * (khong phai nguoi quan sat) rot mang giua van.
+ *
+ * Kiem tra bat bien sau moi van (ma thoat 1 neu vi pham):
+ *   - Moi nguoi con lai nhan dung mot GAME_END, van khong ket qua han
+ *   - So round bat dau <= nguoi * --rounds, moi round co ROUND_END (khong ai rot: bang nhau,
+ *     rot mang co the cat ngang round cuoi)
+ *   - Khong ai rot: tong diem GAME_END = tong diem cac CORRECT_GUESS da broadcast
+ *   - Phong bien mat sau khi moi nguoi roi, cuoi cung server khong con phong/client
+ * Cung --seed cho cung digest (bam moi frame client nhan): kiem tra tinh tat dinh.
+ */
+#include "../include/server.h"
+#include "../include/protocol.h"
+#include "../include/ratelimit.h"
+#include "../include/stall.h"
+#include "../include/utils.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MAX_PLAYERS         (MAX_PLAYERS_PER_ROOM - 1)  // Chua mot cho: phong day tu bat dau game
+#define SIM_RX_SIZE             (64 * 1024)
+#define SIM_START_WALL_MS       1700000000000ull    // Epoch ao (2023-11-14), co dinh de digest tat dinh
+#define SIM_ROUND_SLACK_MS      5000                // Them vao moi round khi tinh han ket cua van
+#define SIM_MAX_REPORTED        20                  // So vi pham in chi tiet
+
+// Chay trong tien trinh: khong mo storage nao (storage_available() == 0)
+static server_t server;
+
+// ============================================
+// Cau hinh
+// ============================================
+
+typedef struct {
+    int games;
+    int players;
+    int rounds;
+    int concurrent;             // So van chay dong thoi (<= MAX_ROOMS, players * concurrent <= MAX_CLIENTS)
+    int guess_pct;              // Xac suat moi nguoi doan dung trong mot round
+    int disconnect_pct;         // Xac suat van co nguoi rot mang
+    int step_ms;                // Buoc dong ho ao
+    unsigned int seed;
+    int verbose;                // Giu log server tren stdout
+} sim_config_t;
+
+static sim_config_t config = {
+    .games = 1000,
+    .players = 4,
+    .rounds = 2,
+    .concurrent = 0,
+    .guess_pct = 70,
+    .disconnect_pct = 10,
+    .step_ms = 100,
+    .seed = 1,
+};
+
+// ============================================
+// Trang thai mo phong
+// ============================================
+
+typedef struct {
+    int fd;                     // Dau client cua socketpair, -1 = da dong
+    int index;                  // Slot client tren server
+    int server_fd;              // Dau server cua socketpair (slot co the da duoc cap cho nguoi khac)
+    uint32_t caps;
+    char username[MAX_USERNAME_LEN];
+    int32_t user_id;
+    uint8_t rx[SIM_RX_SIZE];
+    size_t rx_len;
+    uint64_t guess_at_ms;       // Thoi diem doan dung round nay, 0 = khong doan
+    uint64_t next_chat_ms;      // Chat sai tiep theo
+    int game_ends;
+} sim_player_t;
+
+typedef enum {
+    GAME_FREE = 0,
+    GAME_PLAYING,
+} sim_game_state_t;
+
+typedef struct {
+    sim_game_state_t state;
+    int number;
+    sim_player_t players[SIM_MAX_PLAYERS];
+    int observer;               // Nguoi khong bao gio rot: nguon dem round/diem
+    int32_t room_id;
+    int32_t drawer_id;
+    char word[MAX_WORD_LEN];    // Tu drawer nhan trong GAME_START, "ke" cho nguoi doan
+    int word_round;             // Round cua word (drawer co the nhan GAME_START truoc nguoi quan sat)
+    int round;                  // Round hien tai theo nguoi quan sat
+    int round_open;             // 1 = giua GAME_START va ROUND_END
+    int time_limit;
+    int rounds_started;
+    int rounds_ended;
+    int64_t correct_points;     // Tong diem guesser + drawer tu CORRECT_GUESS
+    int64_t end_score_sum;
+    int end_score_count;
+    int victim;                 // -1 = khong ai rot
+    uint64_t drop_at_ms;
+    uint64_t deadline_ms;
+} sim_game_t;
+
+typedef struct {
+    uint64_t games_started;
+    uint64_t games_finished;
+    uint64_t disconnects;
+    uint64_t rounds;
+    uint64_t correct_guesses;
+    uint64_t wrong_guesses;
+    uint64_t draws;
+    uint64_t frames_out;
+    uint64_t frames_in;
+    uint64_t bytes_in;
+    uint64_t violations;
+} sim_stats_t;
+
+static sim_game_t *games = NULL;
+static sim_stats_t stats;
+static uint64_t rng_state = 88172645463325252ull;
+static uint64_t digest = 1469598103934665603ull;   // FNV-1a 64 cua moi frame client nhan
+static FILE *report = NULL;
+
+static uint32_t sim_rand(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static int chance(int pct)
+{
+    return (int)(sim_rand() % 100) < pct;
+}
+
+static uint64_t real_ns(void)
+{
+    // utils_now_ns dang tra dong ho ao: do thoi gian that truc tiep
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void digest_bytes(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        digest ^= data[i];
+        digest *= 1099511628211ull;
+    }
+}
+
+static void violation(const sim_game_t *g, const char *what)
+{
+    stats.violations++;
+    if (stats.violations <= SIM_MAX_REPORTED)
+    {
+        fprintf(report, "VI PHAM van %d (phong %d): %s\n", g->number, g->room_id, what);
+    }
+}
+
+// ============================================
+// Giao tiep voi server qua socketpair
+// ============================================
+
+static void player_receive(sim_game_t *g, int p);
+
+// Gui mot frame roi cho server xu ly ngay (dong bo, khong co vong lap select)
+static void player_send(sim_game_t *g, int p, uint8_t type, const uint8_t *payload, size_t len)
+{
+    sim_player_t *pl = &g->players[p];
+    if (pl->fd < 0 || len > 0xFFFE)
+    {
+        return;
+    }
+    uint8_t frame[MSG_HEADER_SIZE + BUFFER_SIZE];
+    if (len > sizeof(frame) - MSG_HEADER_SIZE)
+    {
+        return;
+    }
+    frame[0] = type;
+    frame[1] = (uint8_t)(len >> 8);
+    frame[2] = (uint8_t)len;
+    if (len > 0)
+    {
+        memcpy(frame + MSG_HEADER_SIZE, payload, len);
+    }
+    if (send(pl->fd, frame, MSG_HEADER_SIZE + len, MSG_NOSIGNAL) != (ssize_t)(MSG_HEADER_SIZE + len))
+    {
+        violation(g, "gui frame len server that bai");
+        return;
+    }
+    stats.frames_out++;
+    if (server.clients[pl->index].active && server.clients[pl->index].fd == pl->server_fd)
+    {
+        server_handle_client_data(&server, pl->index);
+    }
+}
+
+// Nguoi choi dong ket noi, server xu ly ngat ket noi ngay
+static void player_close(sim_game_t *g, int p)
+{
+    sim_player_t *pl = &g->players[p];
+    if (pl->fd < 0)
+    {
+        return;
+    }
+    close(pl->fd);
+    pl->fd = -1;
+    if (server.clients[pl->index].active && server.clients[pl->index].fd == pl->server_fd)
+    {
+        server_handle_client_data(&server, pl->index);  // recv() = 0 -> server_handle_disconnect
+    }
+}
+
+static void game_receive_all(sim_game_t *g)
+{
+    for (int p = 0; p < config.players; p++)
+    {
+        player_receive(g, p);
+    }
+}
+
+// ============================================
+// Xu ly frame server gui cho nguoi choi
+// ============================================
+
+static int32_t read_i32(const uint8_t *payload, size_t len, size_t offset)
+{
+    if (len < offset + 4)
+    {
+        return 0;
+    }
+    return (int32_t)(((uint32_t)payload[offset] << 24) | ((uint32_t)payload[offset + 1] << 16) |
+                     ((uint32_t)payload[offset + 2] << 8) | payload[offset + 3]);
+}
+
+// GAME_START moi round: drawer nhan tu, nguoi quan sat len lich doan cho ca phong
+static void handle_game_start(sim_game_t *g, int p, const uint8_t *payload, size_t len)
+{
+    msg_game_start_t start;
+    int rc;
+    if (g->players[p].caps & CAP_COMPACT_STRINGS)
+    {
+        msg_game_start_v2_t start_v2;
+        rc = msg_game_start_v2_decode(payload, len, &start_v2);
+        memcpy(&start, &start_v2, sizeof(start));
+    }
+    else
+    {
+        rc = msg_game_start_decode(payload, len, &start);
+    }
+    if (rc < 0)
+    {
+        violation(g, "GAME_START khong giai ma duoc");
+        return;
+    }
+    if (start.word[0] != '\0')
+    {
+        if (start.drawer_id != g->players[p].user_id)
+        {
+            violation(g, "nguoi khong ve nhan duoc tu khoa");
+        }
+        snprintf(g->word, sizeof(g->word), "%s", start.word);
+        g->word_round = start.current_round;
+    }
+    if (p != g->observer)
+    {
+        return;
+    }
+
+    uint64_t now = utils_now_ms();
+    g->rounds_started++;
+    stats.rounds++;
+    g->drawer_id = start.drawer_id;
+    g->round = start.current_round;
+    g->round_open = 1;
+    g->time_limit = start.time_limit > 0 ? start.time_limit : 30;
+    uint64_t window_ms = (uint64_t)g->time_limit * 1000u;
+    for (int i = 0; i < config.players; i++)
+    {
+        sim_player_t *pl = &g->players[i];
+        pl->guess_at_ms = 0;
+        if (pl->fd >= 0 && pl->user_id != start.drawer_id && chance(config.guess_pct))
+        {
+            // Doan dung trong khoang [1s, het gio - 1s)
+            pl->guess_at_ms = now + 1000 + sim_rand() % (window_ms > 2000 ? window_ms - 2000 : 1);
+        }
+        pl->next_chat_ms = now + 500 + sim_rand() % 5000;
+    }
+}
+
+static void handle_correct_guess(sim_game_t *g, int p, const uint8_t *payload, size_t len)
+{
+    msg_correct_guess_t guess;
+    int rc;
+    if (g->players[p].caps & CAP_COMPACT_STRINGS)
+    {
+        msg_correct_guess_v2_t guess_v2;
+        rc = msg_correct_guess_v2_decode(payload, len, &guess_v2);
+        memcpy(&guess, &guess_v2, sizeof(guess));
+    }
+    else
+    {
+        rc = msg_correct_guess_decode(payload, len, &guess);
+    }
+    if (rc < 0)
+    {
+        violation(g, "CORRECT_GUESS khong giai ma duoc");
+        return;
+    }
+    if (p == g->observer)
+    {
+        g->correct_points += guess.guesser_points + guess.drawer_points;
+        stats.correct_guesses++;
+    }
+}
+
+static void handle_game_end(sim_game_t *g, int p, const uint8_t *payload, size_t len)
+{
+    g->players[p].game_ends++;
+    if (p != g->observer)
+    {
+        return;
+    }
+    wire_reader_t r;
+    wire_reader_init(&r, payload, len);
+    msg_game_end_header_t header;
+    msg_game_end_header_read(&r, &header);
+    int64_t sum = 0;
+    for (int i = 0; i < header.score_count; i++)
+    {
+        msg_score_entry_t entry;
+        msg_score_entry_read(&r, &entry);
+        sum += entry.score;
+    }
+    if (r.overflow)
+    {
+        violation(g, "GAME_END bi cat cut");
+        return;
+    }
+    g->end_score_sum = sum;
+    g->end_score_count = header.score_count;
+}
+
+static void handle_message(sim_game_t *g, int p, uint8_t type, const uint8_t *payload, size_t len)
+{
+    sim_player_t *pl = &g->players[p];
+    stats.frames_in++;
+    stats.bytes_in += MSG_HEADER_SIZE + len;
+    digest_bytes(&type, 1);
+    digest_bytes(payload, len);
+
+    switch (type)
+    {
+    case MSG_LOGIN_RESPONSE:
+        if (len < 5 || payload[0] != STATUS_SUCCESS)
+        {
+            violation(g, "dang nhap guest that bai");
+            break;
+        }
+        pl->user_id = read_i32(payload, len, 1);
+        break;
+
+    case MSG_CREATE_ROOM:
+        if (len < 5 || payload[0] != STATUS_SUCCESS)
+        {
+            violation(g, "tao phong that bai");
+            break;
+        }
+        g->room_id = read_i32(payload, len, 1);
+        break;
+
+    case MSG_JOIN_ROOM:
+    case MSG_LEAVE_ROOM:
+        if (len < 1 || payload[0] != STATUS_SUCCESS)
+        {
+            violation(g, type == MSG_JOIN_ROOM ? "vao phong that bai" : "roi phong that bai");
+        }
+        break;
+
+    case MSG_GAME_START:
+        handle_game_start(g, p, payload, len);
+        break;
+
+    case MSG_CORRECT_GUESS:
+        handle_correct_guess(g, p, payload, len);
+        break;
+
+    case MSG_ROUND_END:
+        if (p == g->observer)
+        {
+            g->rounds_ended++;
+            g->round_open = 0;
+        }
+        break;
+
+    case MSG_GAME_END:
+        handle_game_end(g, p, payload, len);
+        break;
+
+    case MSG_ACCOUNT_LOGGED_IN_ELSEWHERE:
+    case MSG_SERVER_SHUTDOWN:
+        violation(g, "server day nguoi choi ra");
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Doc het du lieu server da gui (dau client non-blocking) va tach frame
+static void player_receive(sim_game_t *g, int p)
+{
+    sim_player_t *pl = &g->players[p];
+    while (pl->fd >= 0)
+    {
+        ssize_t n = recv(pl->fd, pl->rx + pl->rx_len, sizeof(pl->rx) - pl->rx_len, 0);
+        if (n <= 0)
+        {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                violation(g, "loi doc socket");
+            }
+            return;
+        }
+        pl->rx_len += (size_t)n;
+
+        size_t pos = 0;
+        while (pl->rx_len - pos >= MSG_HEADER_SIZE)
+        {
+            size_t payload_len = ((size_t)pl->rx[pos + 1] << 8) | pl->rx[pos + 2];
+            if (payload_len == MSG_EXTENDED_LENGTH_MARKER)
+            {
+                violation(g, "frame mo rong gui cho client khong co CAP_EXTENDED_FRAMES");
+                pl->rx_len = 0;
+                return;
+            }
+            if (pl->rx_len - pos < MSG_HEADER_SIZE + payload_len)
+            {
+                break;
+            }
+            handle_message(g, p, pl->rx[pos], pl->rx + pos + MSG_HEADER_SIZE, payload_len);
+            pos += MSG_HEADER_SIZE + payload_len;
+        }
+        memmove(pl->rx, pl->rx + pos, pl->rx_len - pos);
+        pl->rx_len -= pos;
+    }
+}
+
+// ============================================
+// Vong doi mot van
+// ============================================
+
+static void send_room_id(sim_game_t *g, int p, uint8_t type)
+{
+    msg_room_id_t req = {.room_id = g->room_id};
+    uint8_t payload[CODEC_ROOM_ID_MAX_SIZE];
+    size_t len = msg_room_id_encode(&req, payload, sizeof(payload));
+    player_send(g, p, type, payload, len);
+}
+
+static int game_start(sim_game_t *g, int number)
+{
+    memset(g, 0, sizeof(*g));
+    g->number = number;
+    g->observer = config.players - 1;
+    g->victim = -1;
+    g->room_id = -1;
+    for (int p = 0; p < config.players; p++)
+    {
+        g->players[p].fd = -1;
+    }
+
+    for (int p = 0; p < config.players; p++)
+    {
+        sim_player_t *pl = &g->players[p];
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        {
+            fprintf(report, "socketpair() failed: %s\n", strerror(errno));
+            return -1;
+        }
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+        pl->index = server_add_client(&server, sv[1]);
+        if (pl->index < 0)
+        {
+            close(sv[0]);   // server_add_client da dong sv[1]
+            return -1;
+        }
+        pl->fd = sv[0];
+        pl->server_fd = sv[1];
+        snprintf(pl->username, sizeof(pl->username), "sim%d_%d", number, p);
+
+        // Nguoi choi le giu giao thuc cu (khong HELLO) de phu ca hai duong ma hoa
+        if (p % 2 == 0)
+        {
+            pl->caps = CAP_ROOM_LIST_DELTA | CAP_PLAYER_DELTA | CAP_COMPACT_STRINGS | CAP_ROUND_DEADLINE;
+            msg_hello_t hello = {.version = PROTOCOL_VERSION, .caps = pl->caps};
+            uint8_t payload[CODEC_HELLO_MAX_SIZE];
+            size_t len = msg_hello_encode(&hello, payload, sizeof(payload));
+            player_send(g, p, MSG_HELLO, payload, len);
+        }
+
+        msg_login_request_t login;
+        memset(&login, 0, sizeof(login));
+        snprintf(login.username, sizeof(login.username), "%s", pl->username);
+        snprintf(login.password, sizeof(login.password), "sim12345");
+        snprintf(login.avatar, sizeof(login.avatar), "avt%d.jpg", p % 8 + 1);
+        uint8_t payload[CODEC_LOGIN_REQUEST_MAX_SIZE];
+        size_t len = msg_login_request_encode(&login, payload, sizeof(payload));
+        player_send(g, p, MSG_LOGIN_REQUEST, payload, len);
+        player_receive(g, p);
+        if (pl->user_id <= 0)
+        {
+            return -1;
+        }
+    }
+
+    msg_create_room_request_t create;
+    memset(&create, 0, sizeof(create));
+    snprintf(create.room_name, sizeof(create.room_name), "sim room %d", number);
+    create.max_players = (uint8_t)(config.players + 1);
+    create.rounds = (uint8_t)config.rounds;
+    snprintf(create.difficulty, sizeof(create.difficulty), "easy");
+    uint8_t payload[CODEC_CREATE_ROOM_REQUEST_MAX_SIZE];
+    size_t len = msg_create_room_request_encode(&create, payload, sizeof(payload));
+    player_send(g, 0, MSG_CREATE_ROOM, payload, len);
+    game_receive_all(g);
+    if (g->room_id <= 0)
+    {
+        return -1;
+    }
+    for (int p = 1; p < config.players; p++)
+    {
+        send_room_id(g, p, MSG_JOIN_ROOM);
+    }
+    player_send(g, 0, MSG_START_GAME, NULL, 0);
+    game_receive_all(g);
+    if (g->rounds_started != 1)
+    {
+        return -1;
+    }
+
+    uint64_t now = utils_now_ms();
+    int total_rounds = config.players * config.rounds;
+    g->deadline_ms = now + (uint64_t)total_rounds * ((uint64_t)g->time_limit * 1000u + SIM_ROUND_SLACK_MS);
+    if (chance(config.disconnect_pct))
+    {
+        g->victim = (int)(sim_rand() % (uint32_t)g->observer);
+        g->drop_at_ms = now + sim_rand() % (g->deadline_ms - now - SIM_ROUND_SLACK_MS);
+    }
+    g->state = GAME_PLAYING;
+    stats.games_started++;
+    return 0;
+}
+
+static void send_draw(sim_game_t *g, int p)
+{
+    uint8_t payload[14];
+    payload[0] = (uint8_t)(sim_rand() % 4 == 0 ? 1 : 2);   // DRAW_ACTION_MOVE / LINE
+    for (int i = 1; i < 9; i += 2)
+    {
+        uint16_t v = (uint16_t)(sim_rand() % 1080);
+        payload[i] = (uint8_t)(v >> 8);
+        payload[i + 1] = (uint8_t)v;
+    }
+    payload[9] = 0;
+    payload[10] = 0;
+    payload[11] = 0;
+    payload[12] = 0;
+    payload[13] = 4;
+    player_send(g, p, MSG_DRAW_DATA, payload, sizeof(payload));
+    stats.draws++;
+}
+
+// Mot buoc cua van dang choi (dong ho ao dung yen trong buoc)
+static void game_step(sim_game_t *g, uint64_t now)
+{
+    if (g->victim >= 0 && g->players[g->victim].fd >= 0 && now >= g->drop_at_ms)
+    {
+        player_close(g, g->victim);
+        stats.disconnects++;
+    }
+
+    for (int p = 0; p < config.players; p++)
+    {
+        if (!g->round_open || g->word_round != g->round)
+        {
+            break;      // Giua hai round hoac van da het: client that cung dung lai
+        }
+        sim_player_t *pl = &g->players[p];
+        if (pl->fd < 0)
+        {
+            continue;
+        }
+        if (pl->user_id == g->drawer_id)
+        {
+            send_draw(g, p);
+            continue;
+        }
+        if (pl->guess_at_ms && now >= pl->guess_at_ms)
+        {
+            // Doan qua GUESS_WORD hoac chat (chat trung tu khoa duoc xu ly nhu doan)
+            pl->guess_at_ms = 0;
+            uint8_t type = sim_rand() % 2 ? MSG_GUESS_WORD : MSG_CHAT_MESSAGE;
+            player_send(g, p, type, (const uint8_t *)g->word, strlen(g->word));
+            game_receive_all(g);    // Doan dung cuoi cung ket thuc round ngay: nhan truoc khi hanh dong tiep
+        }
+        else if (now >= pl->next_chat_ms)
+        {
+            char text[32];
+            int len = snprintf(text, sizeof(text), "doan sai %u", sim_rand() % 1000);
+            player_send(g, p, MSG_CHAT_MESSAGE, (const uint8_t *)text, (size_t)len);
+            pl->next_chat_ms = now + 2000 + sim_rand() % 4000;
+            stats.wrong_guesses++;
+        }
+    }
+}
+
+// Moi nguoi con lai roi phong va ngat ket noi, phong phai bien mat khoi server
+static void game_release(sim_game_t *g)
+{
+    for (int p = 0; p < config.players; p++)
+    {
+        if (g->players[p].fd >= 0 && g->room_id > 0)
+        {
+            send_room_id(g, p, MSG_LEAVE_ROOM);
+            player_receive(g, p);
+        }
+    }
+    for (int p = 0; p < config.players; p++)
+    {
+        player_close(g, p);
+    }
+    for (int r = 0; r < MAX_ROOMS; r++)
+    {
+        if (g->room_id > 0 && server.rooms[r] && server.rooms[r]->room_id == g->room_id)
+        {
+            violation(g, "phong con lai sau khi moi nguoi roi");
+        }
+    }
+    g->state = GAME_FREE;
+}
+
+// Van ket thuc (hoac ket): kiem tra bat bien, moi nguoi roi phong va ngat ket noi
+static void game_finish(sim_game_t *g, int stuck)
+{
+    sim_player_t *observer = &g->players[g->observer];
+    int dropped = g->victim >= 0 && g->players[g->victim].fd < 0;
+    int total_rounds = config.players * config.rounds;
+    char what[128];
+
+    if (stuck)
+    {
+        violation(g, "van khong ket thuc truoc han");
+    }
+    for (int p = 0; p < config.players; p++)
+    {
+        if (g->players[p].fd >= 0 && g->players[p].game_ends != 1)
+        {
+            snprintf(what, sizeof(what), "nguoi choi %d nhan %d GAME_END", p, g->players[p].game_ends);
+            violation(g, what);
+        }
+    }
+    // Rot mang co the ket thuc van giua round (con mot nguoi): round do khong co ROUND_END
+    int missing_ends = g->rounds_started - g->rounds_ended;
+    if (missing_ends < 0 || missing_ends > dropped || g->rounds_started > total_rounds ||
+        (!dropped && g->rounds_started != total_rounds))
+    {
+        snprintf(what, sizeof(what), "%d round bat dau, %d ROUND_END, du kien %d", g->rounds_started,
+                 g->rounds_ended, total_rounds);
+        violation(g, what);
+    }
+    if (!dropped && observer->game_ends == 1 &&
+        (g->end_score_sum != g->correct_points || g->end_score_count != config.players))
+    {
+        snprintf(what, sizeof(what), "tong diem GAME_END %lld (%d nguoi) != CORRECT_GUESS %lld",
+                 (long long)g->end_score_sum, g->end_score_count, (long long)g->correct_points);
+        violation(g, what);
+    }
+
+    if (!stuck)
+    {
+        stats.games_finished++;
+    }
+    game_release(g);
+}
+
+// ============================================
+// Vong lap mo phong
+// ============================================
+
+static double run_sim(uint64_t *virtual_ms_out)
+{
+    uint64_t start_ns = real_ns();
+    uint64_t virtual_start = utils_now_ms();
+    int next_game = 1;
+    int running = 0;
+
+    while (next_game <= config.games || running > 0)
+    {
+        uint64_t now = utils_now_ms();
+        running = 0;
+        for (int i = 0; i < config.concurrent; i++)
+        {
+            sim_game_t *g = &games[i];
+            if (g->state == GAME_FREE && next_game <= config.games)
+            {
+                if (game_start(g, next_game++) != 0)
+                {
+                    violation(g, "khong dung duoc van (dang nhap/tao phong/bat dau)");
+                    game_release(g);
+                    continue;
+                }
+            }
+            if (g->state != GAME_PLAYING)
+            {
+                continue;
+            }
+            running++;
+            game_step(g, now);
+        }
+
+        server_tick(&server, now);
+        protocol_broadcast_room_list(&server);
+
+        for (int i = 0; i < config.concurrent; i++)
+        {
+            sim_game_t *g = &games[i];
+            if (g->state != GAME_PLAYING)
+            {
+                continue;
+            }
+            game_receive_all(g);
+            if (g->players[g->observer].game_ends > 0)
+            {
+                game_finish(g, 0);
+            }
+            else if (now >= g->deadline_ms)
+            {
+                game_finish(g, 1);
+            }
+        }
+        utils_clock_advance_ms((uint64_t)config.step_ms);
+    }
+
+    *virtual_ms_out = utils_now_ms() - virtual_start;
+    return (double)(real_ns() - start_ns) / 1e9;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Cach dung: %s [--games=N] [--players=N] [--rounds=N] [--concurrent=N] [--guess=PCT]\n"
+            "           [--disconnect=PCT] [--step-ms=MS] [--seed=N] [--verbose]\n",
+            prog);
+}
+
+static int parse_int_option(const char *arg, const char *name, int min, int max, int *out)
+{
+    size_t name_len = strlen(name);
+    if (strncmp(arg, name, name_len) != 0)
+    {
+        return 0;
+    }
+    char *end = NULL;
+    long value = strtol(arg + name_len, &end, 10);
+    if (end == arg + name_len || *end != '\0' || value < min || value > max)
+    {
+        fprintf(stderr, "Gia tri khong hop le: %s (%d..%d)\n", arg, min, max);
+        exit(2);
+    }
+    *out = (int)value;
+    return 1;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    int seed = (int)config.seed;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--verbose") == 0)
+        {
+            config.verbose = 1;
+        }
+        else if (parse_int_option(arg, "--games=", 1, 100000000, &config.games) ||
+                 parse_int_option(arg, "--players=", 2, SIM_MAX_PLAYERS, &config.players) ||
+                 parse_int_option(arg, "--rounds=", 1, 10, &config.rounds) ||
+                 parse_int_option(arg, "--concurrent=", 1, MAX_ROOMS, &config.concurrent) ||
+                 parse_int_option(arg, "--guess=", 0, 100, &config.guess_pct) ||
+                 parse_int_option(arg, "--disconnect=", 0, 100, &config.disconnect_pct) ||
+                 parse_int_option(arg, "--step-ms=", 1, 10000, &config.step_ms) ||
+                 parse_int_option(arg, "--seed=", 0, 2147483647, &seed))
+        {
+            continue;
+        }
+        else
+        {
+            fprintf(stderr, "Tuy chon khong hop le: %s\n", arg);
+            usage(argv[0]);
+            exit(2);
+        }
+    }
+    config.seed = (unsigned int)seed;
+
+    int max_concurrent = MAX_CLIENTS / config.players;
+    if (max_concurrent > MAX_ROOMS)
+    {
+        max_concurrent = MAX_ROOMS;
+    }
+    if (config.concurrent == 0 || config.concurrent > max_concurrent)
+    {
+        config.concurrent = max_concurrent;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    // Bao cao ra stdout goc, log server (stdout/stderr) vao /dev/null tru khi --verbose
+    report = stdout;
+    if (!config.verbose)
+    {
+        int fd = dup(STDOUT_FILENO);
+        report = fd >= 0 ? fdopen(fd, "w") : NULL;
+        if (!report || !freopen("/dev/null", "w", stdout) || !freopen("/dev/null", "w", stderr))
+        {
+            fprintf(stderr, "Khong the chuyen huong log server\n");
+            return 2;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    srand(config.seed);
+    rng_state ^= (uint64_t)config.seed * 0x9E3779B97F4A7C15ull;
+    utils_clock_set_virtual(SIM_START_WALL_MS);
+
+    if (server_init(&server, 0) < 0)
+    {
+        fprintf(report, "Khong the khoi tao server\n");
+        return 2;
+    }
+    memset(&server.config, 0, sizeof(server.config));
+    ratelimit_default_policies(server.config.rate_limits);
+    server.config.idle_timeout_ms = DEFAULT_IDLE_TIMEOUT_MS;
+    server.config.guest_login = 1;
+    stall_configure(0);
+
+    games = calloc((size_t)config.concurrent, sizeof(sim_game_t));
+    if (!games)
+    {
+        fprintf(report, "Het bo nho\n");
+        return 2;
+    }
+
+    fprintf(report, "=== Game sim: %d van x %d nguoi x %d vong, %d van dong thoi, doan %d%%, rot mang %d%%, seed %u ===\n",
+            config.games, config.players, config.rounds, config.concurrent, config.guess_pct,
+            config.disconnect_pct, config.seed);
+    fflush(report);
+
+    uint64_t virtual_ms = 0;
+    double elapsed_s = run_sim(&virtual_ms);
+    if (elapsed_s <= 0)
+    {
+        elapsed_s = 1e-9;
+    }
+
+    if (server.room_count != 0 || server.client_count != 0)
+    {
+        stats.violations++;
+        fprintf(report, "VI PHAM: cuoi mo phong server con %d phong, %d client\n", server.room_count,
+                server.client_count);
+    }
+
+    fprintf(report, "Van:         %llu bat dau, %llu ket thuc, %llu co nguoi rot mang\n",
+            (unsigned long long)stats.games_started, (unsigned long long)stats.games_finished,
+            (unsigned long long)stats.disconnects);
+    fprintf(report, "Round:       %llu, doan dung %llu, chat sai %llu, net ve %llu\n",
+            (unsigned long long)stats.rounds, (unsigned long long)stats.correct_guesses,
+            (unsigned long long)stats.wrong_guesses, (unsigned long long)stats.draws);
+    fprintf(report, "Frame:       %llu gui, %llu nhan (%.1f MB)\n", (unsigned long long)stats.frames_out,
+            (unsigned long long)stats.frames_in, (double)stats.bytes_in / 1e6);
+    uint64_t rate_dropped = 0;
+    for (int c = 0; c < RATE_CLASS_COUNT; c++)
+    {
+        rate_dropped += server.rate_dropped[c];
+    }
+    fprintf(report, "Rate limit:  %llu message bi bo\n", (unsigned long long)rate_dropped);
+    fprintf(report, "Thoi gian:   %.3fs that, %.1f gio ao (nhanh x%.0f)\n", elapsed_s,
+            (double)virtual_ms / 3600000.0, (double)virtual_ms / 1000.0 / elapsed_s);
+    fprintf(report, "Thong luong: %.1f van/s, %.1f round/s, %.0f frame/s\n",
+            (double)stats.games_finished / elapsed_s, (double)stats.rounds / elapsed_s,
+            (double)(stats.frames_in + stats.frames_out) / elapsed_s);
+    fprintf(report, "Digest:      %016llx\n", (unsigned long long)digest);
+    fprintf(report, "Vi pham:     %llu\n", (unsigned long long)stats.violations);
+
+    free(games);
+    server_cleanup(&server);
+    return stats.violations ? 1 : 0;
+}
@@ -0,0 +1,1404 @@
+/**
+ * Load generator nhieu ket noi cho TCP server
+ *
+ * Cach dung:
+ *   make loadgen
+ *   ./main 8080 &
+ *   ./load_generator --port=8080 --rooms=10 --guessers=4 --lobby=20 --duration=60
+ *
+ * Mo hang nghin ket noi non-blocking trong mot tien trinh (epoll tren Linux,
+ * poll() tren he dieu hanh khac) va chay cac persona theo kich ban:
+ *   - lobby:   LOBBY_SUBSCRIBE, xin ROOM_LIST dinh ky, thinh thoang xem lich su
+ *   - owner:   tao phong, START_GAME khi du guesser, bat dau lai sau GAME_END
+ *   - guesser: vao phong cua owner, chat/doan dinh ky
+ * Ai dang la drawer cua round (theo GAME_START) thi gui DRAW_DATA voi toc do
+ * --draw-rate thay vi chat.
+ *
+ * Do tre:
+ *   - request/response (login, room list, tao/vao phong...): tu luc gui den luc nhan response
+ *   - chat: noi dung chua thoi diem gui, do tai nguoi gui (echo) va nguoi nhan (fan-out)
+ *   - net ve: truong color chua 32 bit thap cua thoi diem gui (us), do tai nguoi nhan
+ * Moi nguoi choi nam trong cung tien trinh nen dung chung dong ho monotonic.
+ *
+ * Luu y: server gioi han MAX_CLIENTS ket noi, ket noi vuot qua bi tu choi va
+ * duoc bao cao la "bi dong". Rate limit mac dinh cua server (lobby 2/s, chat 5/s)
+ * cung ap dung cho moi ket noi; noi long bang --rate-limit=... khi can.
+ * Ma thoat 1 neu co bat ky loi/timeout/ket noi bi dong nao (dung duoc trong CI).
+ */
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#define LG_MAX_CONNS            20000
+#define LG_MAX_ROOM_PLAYERS     10          // = MAX_PLAYERS_PER_ROOM cua server
+#define LG_RX_SIZE              (64 * 1024)
+#define LG_TX_SIZE              (16 * 1024)
+#define LG_REQUEST_TIMEOUT_NS   (5000ull * 1000000ull)
+#define LG_RETRY_NS             (2000ull * 1000000ull)
+#define LG_RESTART_NS           (3000ull * 1000000ull)
+#define LG_STROKE_SEGMENTS      40          // So doan LINE moi net truoc khi nhac but
+#define LG_MAX_EVENTS           1024
+
+// ============================================
+// Cau hinh
+// ============================================
+
+typedef struct {
+    const char *host;
+    int port;
+    int rooms;                  // So phong (moi phong 1 owner)
+    int guessers;               // Guesser moi phong
+    int lobby;                  // Ket noi chi xem sanh
+    int duration_s;
+    int draw_rate;              // DRAW_DATA/giay cua drawer
+    int chat_interval_ms;       // Khoang cach trung binh giua hai tin chat
+    int lobby_interval_ms;      // Khoang cach trung binh giua hai ROOM_LIST_REQUEST
+    int ramp;                   // Ket noi moi mo moi giay
+    int rounds;
+    const char *prefix;         // Tien to username
+    const char *password;
+} lg_config_t;
+
+static lg_config_t config = {
+    .host = "127.0.0.1",
+    .port = 8080,
+    .rooms = 5,
+    .guessers = 3,
+    .lobby = 10,
+    .duration_s = 30,
+    .draw_rate = 60,
+    .chat_interval_ms = 3000,
+    .lobby_interval_ms = 2000,
+    .ramp = 200,
+    .rounds = 3,
+    .prefix = "lg",
+    .password = "loadgen123",
+};
+
+// ============================================
+// Thong ke
+// ============================================
+
+typedef enum {
+    OP_CONNECT = 0,
+    OP_REGISTER,
+    OP_LOGIN,
+    OP_ROOM_LIST,
+    OP_HISTORY,
+    OP_CREATE_ROOM,
+    OP_JOIN_ROOM,
+    OP_START_GAME,
+    OP_CHAT_ECHO,               // Nguoi gui nhan lai CHAT_BROADCAST cua chinh minh
+    OP_CHAT_FANOUT,             // Nguoi khac trong phong nhan CHAT_BROADCAST
+    OP_DRAW_FANOUT,             // Nguoi khac trong phong nhan DRAW_BROADCAST
+    OP_COUNT
+} lg_op_t;
+
+static const char *op_names[OP_COUNT] = {
+    "connect", "register", "login", "room_list", "history", "create_room",
+    "join_room", "start_game", "chat_echo", "chat_fanout", "draw_fanout",
+};
+
+typedef struct {
+    uint64_t sent;              // Request da gui (fan-out: so mau)
+    uint64_t errors;            // Response co status loi
+    uint64_t timeouts;          // Khong co response sau LG_REQUEST_TIMEOUT_NS
+    latency_hist_t hist;
+} lg_op_stats_t;
+
+typedef struct {
+    lg_op_stats_t ops[OP_COUNT];
+    uint64_t msgs_out;
+    uint64_t msgs_in;
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint64_t recv_by_type[256];
+    uint64_t connects_started;
+    uint64_t connects_ok;
+    uint64_t connect_failed;
+    uint64_t disconnected;      // Server dong ket noi truoc khi ket thuc
+    uint64_t protocol_errors;   // Frame khong hop le / qua lon
+    uint64_t tx_overflow;       // Buffer gui day, message bi bo
+} lg_stats_t;
+
+static lg_stats_t stats;
+
+// ============================================
+// Ket noi va persona
+// ============================================
+
+typedef enum {
+    PERSONA_LOBBY = 0,
+    PERSONA_OWNER,
+    PERSONA_GUESSER,
+} lg_persona_t;
+
+typedef enum {
+    CONN_IDLE = 0,              // Chua mo
+    CONN_CONNECTING,
+    CONN_AUTH,                  // Dang register/login
+    CONN_LOBBY,
+    CONN_WAIT_ROOM,             // Owner cho tao phong / guesser cho vao phong
+    CONN_IN_ROOM,
+    CONN_CLOSED,
+} lg_conn_state_t;
+
+typedef struct {
+    int fd;
+    lg_persona_t persona;
+    int group;                  // Phong cua owner/guesser, -1 voi lobby
+    lg_conn_state_t state;
+    int user_id;
+    char username[MAX_USERNAME_LEN];
+    uint64_t pending_ns[OP_COUNT];  // Thoi diem gui request dang cho (0 = khong cho)
+    uint64_t next_action_ns;
+    uint64_t next_draw_ns;
+    uint32_t actions;           // So hanh dong persona da lam (chon request lobby)
+    int drawing;                // La drawer cua round hien tai
+    int stroke_left;
+    uint16_t pen_x;
+    uint16_t pen_y;
+    int want_write;
+    uint8_t *rx;
+    size_t rx_len;
+    uint8_t *tx;
+    size_t tx_len;
+} lg_conn_t;
+
+typedef struct {
+    int room_id;                // 0 = chua tao
+    int joined;                 // Guesser da vao phong
+    int playing;
+} lg_group_t;
+
+static lg_conn_t *conns = NULL;
+static int conn_count = 0;
+static lg_group_t *groups = NULL;
+static volatile sig_atomic_t stop_requested = 0;
+static uint64_t seed = 88172645463325252ull;
+
+static void signal_handler(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint32_t lg_rand(void)
+{
+    // xorshift64: du cho kich ban tai, khong can chat luong mat ma
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return (uint32_t)(seed >> 32);
+}
+
+// Khoang thoi gian trung binh mean_ms, dao dong +-25% de cac ket noi khong dong bo pha
+static uint64_t jitter_ns(int mean_ms)
+{
+    uint64_t base = (uint64_t)mean_ms * 1000000ull;
+    uint64_t spread = base / 2;
+    return base - spread / 2 + (spread ? (uint64_t)lg_rand() % spread : 0);
+}
+
+static uint64_t now_us(void)
+{
+    return utils_now_ns() / 1000;
+}
+
+// ============================================
+// Poller: epoll (Linux) hoac poll()
+// ============================================
+
+typedef struct {
+    int index;
+    int readable;
+    int writable;
+    int failed;
+} lg_event_t;
+
+#ifdef __linux__
+static int epoll_fd = -1;
+
+static int poller_init(int max_conns)
+{
+    (void)max_conns;
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0)
+    {
+        perror("epoll_create1");
+        return -1;
+    }
+    return 0;
+}
+
+static int poller_set(lg_conn_t *c, int index, int add)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (c->want_write ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)index;
+    return epoll_ctl(epoll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void poller_remove(lg_conn_t *c, int index)
+{
+    (void)index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+}
+
+static int poller_wait(lg_event_t *out, int max, int timeout_ms)
+{
+    struct epoll_event events[LG_MAX_EVENTS];
+    if (max > LG_MAX_EVENTS)
+    {
+        max = LG_MAX_EVENTS;
+    }
+    int n = epoll_wait(epoll_fd, events, max, timeout_ms);
+    for (int i = 0; i < n; i++)
+    {
+        out[i].index = (int)events[i].data.u32;
+        out[i].readable = (events[i].events & (EPOLLIN | EPOLLHUP)) != 0;
+        out[i].writable = (events[i].events & EPOLLOUT) != 0;
+        out[i].failed = (events[i].events & EPOLLERR) != 0;
+    }
+    return n;
+}
+
+static void poller_close(void)
+{
+    if (epoll_fd >= 0)
+    {
+        close(epoll_fd);
+    }
+}
+#else
+static struct pollfd *poll_fds = NULL;
+static int poll_cursor = 0;     // Quet tiep tu day o lan sau de khong bo doi ket noi cuoi mang
+
+static int poller_init(int max_conns)
+{
+    poll_fds = calloc((size_t)max_conns, sizeof(struct pollfd));
+    if (!poll_fds)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        return -1;
+    }
+    for (int i = 0; i < max_conns; i++)
+    {
+        poll_fds[i].fd = -1;
+    }
+    return 0;
+}
+
+static int poller_set(lg_conn_t *c, int index, int add)
+{
+    (void)add;
+    poll_fds[index].fd = c->fd;
+    poll_fds[index].events = POLLIN | (c->want_write ? POLLOUT : 0);
+    return 0;
+}
+
+static void poller_remove(lg_conn_t *c, int index)
+{
+    (void)c;
+    poll_fds[index].fd = -1;
+}
+
+static int poller_wait(lg_event_t *out, int max, int timeout_ms)
+{
+    int ready = poll(poll_fds, (nfds_t)conn_count, timeout_ms);
+    int n = 0;
+    for (int k = 0; k < conn_count && ready > 0 && n < max; k++)
+    {
+        int i = (poll_cursor + k) % conn_count;
+        short re = poll_fds[i].revents;
+        if (poll_fds[i].fd < 0 || re == 0)
+        {
+            continue;
+        }
+        ready--;
+        out[n].index = i;
+        out[n].readable = (re & (POLLIN | POLLHUP)) != 0;
+        out[n].writable = (re & POLLOUT) != 0;
+        out[n].failed = (re & (POLLERR | POLLNVAL)) != 0;
+        n++;
+        poll_cursor = (i + 1) % conn_count;
+    }
+    return ready < 0 ? -1 : n;
+}
+
+static void poller_close(void)
+{
+    free(poll_fds);
+}
+#endif
+
+// ============================================
+// Gui / nhan frame
+// ============================================
+
+static void conn_close(int index, int by_server)
+{
+    lg_conn_t *c = &conns[index];
+    if (c->fd >= 0)
+    {
+        poller_remove(c, index);
+        close(c->fd);
+        c->fd = -1;
+    }
+    if (by_server && c->state != CONN_CLOSED)
+    {
+        stats.disconnected++;
+    }
+    if (c->state == CONN_IN_ROOM && c->group >= 0 && c->persona == PERSONA_GUESSER)
+    {
+        groups[c->group].joined--;
+    }
+    c->state = CONN_CLOSED;
+}
+
+static void conn_update_interest(int index)
+{
+    lg_conn_t *c = &conns[index];
+    int want = c->tx_len > 0;
+    if (want != c->want_write)
+    {
+        c->want_write = want;
+        poller_set(c, index, 0);
+    }
+}
+
+static int conn_flush(int index)
+{
+    lg_conn_t *c = &conns[index];
+    size_t sent = 0;
+    while (sent < c->tx_len)
+    {
+        ssize_t n = send(c->fd, c->tx + sent, c->tx_len - sent, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            conn_close(index, 1);
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    stats.bytes_out += sent;
+    if (sent > 0)
+    {
+        memmove(c->tx, c->tx + sent, c->tx_len - sent);
+        c->tx_len -= sent;
+    }
+    conn_update_interest(index);
+    return 0;
+}
+
+// Dong goi frame [TYPE][LEN:2] vao buffer gui va thu gui ngay
+static int conn_send(int index, uint8_t type, const uint8_t *payload, size_t len)
+{
+    lg_conn_t *c = &conns[index];
+    if (c->fd < 0 || len >= MSG_EXTENDED_LENGTH_MARKER)
+    {
+        return -1;
+    }
+    if (c->tx_len + MSG_HEADER_SIZE + len > LG_TX_SIZE)
+    {
+        stats.tx_overflow++;
+        return -1;
+    }
+
+    uint8_t *p = c->tx + c->tx_len;
+    p[0] = type;
+    p[1] = (uint8_t)(len >> 8);
+    p[2] = (uint8_t)len;
+    if (len > 0)
+    {
+        memcpy(p + MSG_HEADER_SIZE, payload, len);
+    }
+    c->tx_len += MSG_HEADER_SIZE + len;
+    stats.msgs_out++;
+    return conn_flush(index);
+}
+
+static void request_begin(lg_conn_t *c, lg_op_t op, uint64_t now)
+{
+    c->pending_ns[op] = now;
+    stats.ops[op].sent++;
+}
+
+// Ghi do tre request dang cho (bo qua response khong ai doi, vd. ROOM_LIST day tu server)
+static void request_end(lg_conn_t *c, lg_op_t op, int ok)
+{
+    if (!c->pending_ns[op])
+    {
+        return;
+    }
+    latency_hist_record(&stats.ops[op].hist, utils_now_ns() - c->pending_ns[op]);
+    if (!ok)
+    {
+        stats.ops[op].errors++;
+    }
+    c->pending_ns[op] = 0;
+}
+
+// ============================================
+// Hanh dong cua persona
+// ============================================
+
+static void send_hello(int index)
+{
+    msg_hello_t hello = {
+        .version = PROTOCOL_VERSION,
+        .caps = CAP_EXTENDED_FRAMES | CAP_ROOM_LIST_DELTA | CAP_PLAYER_DELTA |
+                CAP_COMPACT_STRINGS | CAP_ROUND_DEADLINE | CAP_PING | CAP_CANVAS_SNAPSHOT,
+    };
+    uint8_t payload[CODEC_HELLO_MAX_SIZE];
+    size_t len = msg_hello_encode(&hello, payload, sizeof(payload));
+    conn_send(index, MSG_HELLO, payload, len);
+}
+
+static void send_register(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    msg_register_request_t req;
+    memset(&req, 0, sizeof(req));
+    snprintf(req.username, sizeof(req.username), "%s", c->username);
+    snprintf(req.password, sizeof(req.password), "%s", config.password);
+    snprintf(req.email, sizeof(req.email), "%s@loadgen.local", c->username);
+    uint8_t payload[CODEC_REGISTER_REQUEST_MAX_SIZE];
+    size_t len = msg_register_request_encode(&req, payload, sizeof(payload));
+    request_begin(c, OP_REGISTER, now);
+    conn_send(index, MSG_REGISTER_REQUEST, payload, len);
+}
+
+static void send_login(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    msg_login_request_t req;
+    memset(&req, 0, sizeof(req));
+    snprintf(req.username, sizeof(req.username), "%s", c->username);
+    snprintf(req.password, sizeof(req.password), "%s", config.password);
+    snprintf(req.avatar, sizeof(req.avatar), "avatar%d", index % 8);
+    uint8_t payload[CODEC_LOGIN_REQUEST_MAX_SIZE];
+    size_t len = msg_login_request_encode(&req, payload, sizeof(payload));
+    request_begin(c, OP_LOGIN, now);
+    conn_send(index, MSG_LOGIN_REQUEST, payload, len);
+}
+
+static void send_create_room(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    msg_create_room_request_t req;
+    memset(&req, 0, sizeof(req));
+    snprintf(req.room_name, sizeof(req.room_name), "%s room %d", config.prefix, c->group);
+    // Chua mot cho trong: phong day se tu bat dau game ma khong co GAME_START,
+    // owner can tu gui START_GAME de co round that
+    req.max_players = (uint8_t)(config.guessers + 2);
+    req.rounds = (uint8_t)config.rounds;
+    snprintf(req.difficulty, sizeof(req.difficulty), "easy");
+    uint8_t payload[CODEC_CREATE_ROOM_REQUEST_MAX_SIZE];
+    size_t len = msg_create_room_request_encode(&req, payload, sizeof(payload));
+    request_begin(c, OP_CREATE_ROOM, now);
+    conn_send(index, MSG_CREATE_ROOM, payload, len);
+}
+
+static void send_join_room(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    msg_room_id_t req = {.room_id = groups[c->group].room_id};
+    uint8_t payload[CODEC_ROOM_ID_MAX_SIZE];
+    size_t len = msg_room_id_encode(&req, payload, sizeof(payload));
+    request_begin(c, OP_JOIN_ROOM, now);
+    conn_send(index, MSG_JOIN_ROOM, payload, len);
+}
+
+static void send_chat(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    char text[64];
+    // Khong bao gio trung tu can doan: chat duoc broadcast nhu doan sai
+    int len = snprintf(text, sizeof(text), "lg %llu %u", (unsigned long long)now_us(), c->actions);
+    request_begin(c, OP_CHAT_ECHO, now);
+    conn_send(index, MSG_CHAT_MESSAGE, (const uint8_t *)text, (size_t)len);
+}
+
+static void send_draw(int index)
+{
+    lg_conn_t *c = &conns[index];
+    uint8_t payload[14];
+    uint8_t action = 2; // DRAW_ACTION_LINE
+    uint16_t x1 = c->pen_x, y1 = c->pen_y;
+
+    if (c->stroke_left <= 0)
+    {
+        // Nhac but: bat dau net moi o vi tri ngau nhien
+        action = 1; // DRAW_ACTION_MOVE
+        c->pen_x = (uint16_t)(lg_rand() % 1920);
+        c->pen_y = (uint16_t)(lg_rand() % 1080);
+        x1 = c->pen_x;
+        y1 = c->pen_y;
+        c->stroke_left = LG_STROKE_SEGMENTS;
+    }
+    else
+    {
+        int x = (int)c->pen_x + (int)(lg_rand() % 31) - 15;
+        int y = (int)c->pen_y + (int)(lg_rand() % 31) - 15;
+        c->pen_x = (uint16_t)(x < 0 ? 0 : x > 1919 ? 1919 : x);
+        c->pen_y = (uint16_t)(y < 0 ? 0 : y > 1079 ? 1079 : y);
+        c->stroke_left--;
+    }
+
+    // Color = 32 bit thap cua thoi diem gui (us), nguoi nhan tinh do tre tu day
+    uint32_t stamp = (uint32_t)now_us();
+    payload[0] = action;
+    payload[1] = (uint8_t)(x1 >> 8);
+    payload[2] = (uint8_t)x1;
+    payload[3] = (uint8_t)(y1 >> 8);
+    payload[4] = (uint8_t)y1;
+    payload[5] = (uint8_t)(c->pen_x >> 8);
+    payload[6] = (uint8_t)c->pen_x;
+    payload[7] = (uint8_t)(c->pen_y >> 8);
+    payload[8] = (uint8_t)c->pen_y;
+    payload[9] = (uint8_t)(stamp >> 24);
+    payload[10] = (uint8_t)(stamp >> 16);
+    payload[11] = (uint8_t)(stamp >> 8);
+    payload[12] = (uint8_t)stamp;
+    payload[13] = 4;
+    conn_send(index, MSG_DRAW_DATA, payload, sizeof(payload));
+}
+
+// Persona sau khi dang nhap thanh cong
+static void persona_start(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    switch (c->persona)
+    {
+    case PERSONA_LOBBY:
+        c->state = CONN_LOBBY;
+        conn_send(index, MSG_LOBBY_SUBSCRIBE, NULL, 0);
+        c->next_action_ns = now + jitter_ns(config.lobby_interval_ms);
+        break;
+    case PERSONA_OWNER:
+        c->state = CONN_WAIT_ROOM;
+        send_create_room(index, now);
+        break;
+    case PERSONA_GUESSER:
+        c->state = CONN_WAIT_ROOM;
+        c->next_action_ns = now;
+        break;
+    }
+}
+
+// Hanh dong dinh ky, goi moi vong lap
+static void persona_tick(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        if (c->pending_ns[op] && now > c->pending_ns[op] + LG_REQUEST_TIMEOUT_NS)
+        {
+            stats.ops[op].timeouts++;
+            c->pending_ns[op] = 0;
+        }
+    }
+
+    switch (c->state)
+    {
+    case CONN_LOBBY:
+        if (now >= c->next_action_ns)
+        {
+            // 4/5 lan xin danh sach phong, 1/5 lan xem lich su
+            if (++c->actions % 5 == 0)
+            {
+                if (!c->pending_ns[OP_HISTORY])
+                {
+                    request_begin(c, OP_HISTORY, now);
+                    conn_send(index, MSG_GET_GAME_HISTORY, NULL, 0);
+                }
+            }
+            else if (!c->pending_ns[OP_ROOM_LIST])
+            {
+                request_begin(c, OP_ROOM_LIST, now);
+                conn_send(index, MSG_ROOM_LIST_REQUEST, NULL, 0);
+            }
+            c->next_action_ns = now + jitter_ns(config.lobby_interval_ms);
+        }
+        break;
+
+    case CONN_WAIT_ROOM:
+        if (now < c->next_action_ns)
+        {
+            break;
+        }
+        if (c->persona == PERSONA_OWNER && !c->pending_ns[OP_CREATE_ROOM])
+        {
+            send_create_room(index, now);
+            c->next_action_ns = now + LG_RETRY_NS;
+        }
+        else if (c->persona == PERSONA_GUESSER && groups[c->group].room_id > 0 && !c->pending_ns[OP_JOIN_ROOM])
+        {
+            send_join_room(index, now);
+            c->next_action_ns = now + LG_RETRY_NS;
+        }
+        break;
+
+    case CONN_IN_ROOM:
+    {
+        lg_group_t *group = &groups[c->group];
+        if (c->drawing)
+        {
+            // Giu nhip deu; neu bi tre (vong lap cham) chi bu toi da mot giay
+            uint64_t interval = 1000000000ull / (uint64_t)config.draw_rate;
+            if (now > c->next_draw_ns + 1000000000ull)
+            {
+                c->next_draw_ns = now - 1000000000ull;
+            }
+            while (c->next_draw_ns <= now && c->fd >= 0)
+            {
+                send_draw(index);
+                c->next_draw_ns += interval;
+            }
+        }
+        else if (now >= c->next_action_ns && (group->playing || c->persona == PERSONA_GUESSER))
+        {
+            c->actions++;
+            send_chat(index, now);
+            c->next_action_ns = now + jitter_ns(config.chat_interval_ms);
+        }
+
+        if (c->persona == PERSONA_OWNER && !group->playing && now >= c->next_action_ns &&
+            group->joined >= config.guessers && !c->pending_ns[OP_START_GAME])
+        {
+            request_begin(c, OP_START_GAME, now);
+            conn_send(index, MSG_START_GAME, NULL, 0);
+            c->next_action_ns = now + LG_RETRY_NS;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// ============================================
+// Xu ly message tu server
+// ============================================
+
+static uint8_t read_status(const uint8_t *payload, size_t len)
+{
+    return len > 0 ? payload[0] : STATUS_ERROR;
+}
+
+static int32_t read_i32(const uint8_t *payload, size_t len, size_t offset)
+{
+    if (len < offset + 4)
+    {
+        return 0;
+    }
+    return (int32_t)(((uint32_t)payload[offset] << 24) | ((uint32_t)payload[offset + 1] << 16) |
+                     ((uint32_t)payload[offset + 2] << 8) | payload[offset + 3]);
+}
+
+static void handle_chat_broadcast(lg_conn_t *c, const uint8_t *payload, size_t len)
+{
+    msg_chat_broadcast_v2_t chat;
+    if (msg_chat_broadcast_v2_decode(payload, len, &chat) < 0)
+    {
+        stats.protocol_errors++;
+        return;
+    }
+    unsigned long long sent_us = 0;
+    if (sscanf(chat.message, "lg %llu", &sent_us) != 1)
+    {
+        return;
+    }
+    uint64_t elapsed_ns = (now_us() - sent_us) * 1000;
+    if (strcmp(chat.username, c->username) == 0)
+    {
+        if (c->pending_ns[OP_CHAT_ECHO])
+        {
+            latency_hist_record(&stats.ops[OP_CHAT_ECHO].hist, elapsed_ns);
+            c->pending_ns[OP_CHAT_ECHO] = 0;
+        }
+    }
+    else
+    {
+        stats.ops[OP_CHAT_FANOUT].sent++;
+        latency_hist_record(&stats.ops[OP_CHAT_FANOUT].hist, elapsed_ns);
+    }
+}
+
+static void handle_message(int index, uint8_t type, const uint8_t *payload, size_t len)
+{
+    lg_conn_t *c = &conns[index];
+    uint64_t now = utils_now_ns();
+    stats.msgs_in++;
+    stats.recv_by_type[type]++;
+
+    switch (type)
+    {
+    case MSG_REGISTER_RESPONSE:
+    {
+        // Tai khoan da ton tai tu lan chay truoc khong phai loi
+        uint8_t status = read_status(payload, len);
+        request_end(c, OP_REGISTER, status == STATUS_SUCCESS || status == STATUS_USER_EXISTS);
+        send_login(index, now);
+        break;
+    }
+
+    case MSG_LOGIN_RESPONSE:
+    {
+        int ok = read_status(payload, len) == STATUS_SUCCESS;
+        request_end(c, OP_LOGIN, ok);
+        if (!ok)
+        {
+            // Khong dang nhap duoc thi persona khong lam gi duoc nua
+            conn_close(index, 0);
+            return;
+        }
+        c->user_id = read_i32(payload, len, 1);
+        persona_start(index, now);
+        break;
+    }
+
+    case MSG_ROOM_LIST_RESPONSE:
+        request_end(c, OP_ROOM_LIST, 1);
+        break;
+
+    case MSG_GAME_HISTORY_RESPONSE:
+        request_end(c, OP_HISTORY, 1);
+        break;
+
+    case MSG_CREATE_ROOM:
+    {
+        int ok = read_status(payload, len) == STATUS_SUCCESS;
+        request_end(c, OP_CREATE_ROOM, ok);
+        if (ok && c->persona == PERSONA_OWNER)
+        {
+            groups[c->group].room_id = read_i32(payload, len, 1);
+            c->state = CONN_IN_ROOM;
+            c->next_action_ns = now;
+        }
+        break;
+    }
+
+    case MSG_JOIN_ROOM:
+    {
+        int ok = read_status(payload, len) == STATUS_SUCCESS;
+        request_end(c, OP_JOIN_ROOM, ok);
+        if (ok && c->state == CONN_WAIT_ROOM)
+        {
+            c->state = CONN_IN_ROOM;
+            groups[c->group].joined++;
+            c->next_action_ns = now + jitter_ns(config.chat_interval_ms);
+        }
+        break;
+    }
+
+    case MSG_GAME_START:
+    {
+        // Moi round co mot GAME_START; drawer_id la truong dau tien o ca v1 va v2
+        int32_t drawer_id = read_i32(payload, len, 0);
+        request_end(c, OP_START_GAME, 1);
+        if (c->group >= 0)
+        {
+            groups[c->group].playing = 1;
+        }
+        c->drawing = drawer_id == c->user_id;
+        c->next_draw_ns = now;
+        c->stroke_left = 0;
+        break;
+    }
+
+    case MSG_ROUND_END:
+        c->drawing = 0;
+        break;
+
+    case MSG_GAME_END:
+        c->drawing = 0;
+        if (c->group >= 0)
+        {
+            groups[c->group].playing = 0;
+        }
+        if (c->persona == PERSONA_OWNER)
+        {
+            c->next_action_ns = now + LG_RESTART_NS;
+        }
+        break;
+
+    case MSG_DRAW_BROADCAST:
+        if (len >= 14)
+        {
+            uint32_t stamp = ((uint32_t)payload[9] << 24) | ((uint32_t)payload[10] << 16) |
+                             ((uint32_t)payload[11] << 8) | payload[12];
+            // Phep tru mod 2^32: dung voi do tre < 71 phut
+            uint32_t elapsed_us = (uint32_t)now_us() - stamp;
+            stats.ops[OP_DRAW_FANOUT].sent++;
+            latency_hist_record(&stats.ops[OP_DRAW_FANOUT].hist, (uint64_t)elapsed_us * 1000);
+        }
+        break;
+
+    case MSG_CHAT_BROADCAST:
+        handle_chat_broadcast(c, payload, len);
+        break;
+
+    case MSG_PING:
+    {
+        msg_ping_t ping;
+        if (msg_ping_decode(payload, len, &ping) < 0)
+        {
+            stats.protocol_errors++;
+            break;
+        }
+        uint64_t ms = utils_wall_ms();
+        msg_pong_t pong = {.seq = ping.seq, .origin_ms = ping.origin_ms, .recv_ms = ms, .send_ms = ms};
+        uint8_t out[CODEC_PONG_MAX_SIZE];
+        size_t out_len = msg_pong_encode(&pong, out, sizeof(out));
+        conn_send(index, MSG_PONG, out, out_len);
+        break;
+    }
+
+    case MSG_SERVER_SHUTDOWN:
+        stop_requested = 1;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void conn_read(int index)
+{
+    lg_conn_t *c = &conns[index];
+    for (;;)
+    {
+        ssize_t n = recv(c->fd, c->rx + c->rx_len, LG_RX_SIZE - c->rx_len, 0);
+        if (n == 0)
+        {
+            conn_close(index, 1);
+            return;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                conn_close(index, 1);
+            }
+            return;
+        }
+        stats.bytes_in += (uint64_t)n;
+        c->rx_len += (size_t)n;
+
+        // Tach frame: [TYPE][LEN:2] hoac [TYPE][0xFFFF][LEN:4]
+        size_t pos = 0;
+        while (c->fd >= 0 && c->rx_len - pos >= MSG_HEADER_SIZE)
+        {
+            const uint8_t *p = c->rx + pos;
+            size_t header = MSG_HEADER_SIZE;
+            size_t payload_len = ((size_t)p[1] << 8) | p[2];
+            if (payload_len == MSG_EXTENDED_LENGTH_MARKER)
+            {
+                if (c->rx_len - pos < MSG_EXTENDED_HEADER_SIZE)
+                {
+                    break;
+                }
+                header = MSG_EXTENDED_HEADER_SIZE;
+                payload_len = ((size_t)p[3] << 24) | ((size_t)p[4] << 16) | ((size_t)p[5] << 8) | p[6];
+            }
+            if (header + payload_len > LG_RX_SIZE)
+            {
+                stats.protocol_errors++;
+                conn_close(index, 0);
+                return;
+            }
+            if (c->rx_len - pos < header + payload_len)
+            {
+                break;
+            }
+            handle_message(index, p[0], p + header, payload_len);
+            pos += header + payload_len;
+        }
+        if (c->fd < 0)
+        {
+            return;
+        }
+        memmove(c->rx, c->rx + pos, c->rx_len - pos);
+        c->rx_len -= pos;
+    }
+}
+
+// ============================================
+// Mo ket noi
+// ============================================
+
+static int conn_open(int index, const struct sockaddr_in *addr, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    stats.connects_started++;
+
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (c->fd < 0)
+    {
+        stats.connect_failed++;
+        c->state = CONN_CLOSED;
+        return -1;
+    }
+    int flags = fcntl(c->fd, F_GETFL, 0);
+    fcntl(c->fd, F_SETFL, flags | O_NONBLOCK);
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    c->state = CONN_CONNECTING;
+    c->pending_ns[OP_CONNECT] = now;
+    stats.ops[OP_CONNECT].sent++;
+    if (connect(c->fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS)
+    {
+        stats.connect_failed++;
+        close(c->fd);
+        c->fd = -1;
+        c->state = CONN_CLOSED;
+        return -1;
+    }
+    // Cho ghi duoc = ket noi xong (hoac loi)
+    c->want_write = 1;
+    if (poller_set(c, index, 1) != 0)
+    {
+        stats.connect_failed++;
+        close(c->fd);
+        c->fd = -1;
+        c->state = CONN_CLOSED;
+        return -1;
+    }
+    return 0;
+}
+
+static void conn_connected(int index, uint64_t now)
+{
+    lg_conn_t *c = &conns[index];
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0)
+    {
+        stats.connect_failed++;
+        c->state = CONN_CLOSED;
+        conn_close(index, 0);
+        return;
+    }
+    stats.connects_ok++;
+    request_end(c, OP_CONNECT, 1);
+    c->state = CONN_AUTH;
+    conn_update_interest(index);
+    send_hello(index);
+    if (c->fd >= 0)
+    {
+        send_register(index, now);
+    }
+}
+
+// ============================================
+// Bao cao
+// ============================================
+
+#define LG_MESSAGE_NAMES(X) \
+    X(MSG_LOGIN_RESPONSE) X(MSG_REGISTER_RESPONSE) X(MSG_ROOM_LIST_RESPONSE) X(MSG_CREATE_ROOM) \
+    X(MSG_JOIN_ROOM) X(MSG_ROOM_UPDATE) X(MSG_ROOM_PLAYERS_UPDATE) X(MSG_ROOM_LIST_DELTA) \
+    X(MSG_ROOM_PLAYER_DELTA) X(MSG_GAME_START) X(MSG_GAME_STATE) X(MSG_DRAW_BROADCAST) \
+    X(MSG_CORRECT_GUESS) X(MSG_WRONG_GUESS) X(MSG_ROUND_END) X(MSG_GAME_END) X(MSG_HINT) \
+    X(MSG_TIMER_UPDATE) X(MSG_CANVAS_SNAPSHOT) X(MSG_CHAT_BROADCAST) X(MSG_GAME_HISTORY_RESPONSE) \
+    X(MSG_SERVER_SHUTDOWN) X(MSG_ACCOUNT_LOGGED_IN_ELSEWHERE) X(MSG_HELLO_ACK) X(MSG_COMPRESSED) \
+    X(MSG_ROUND_DEADLINE) X(MSG_PING) X(MSG_PONG)
+
+static const char *message_name(uint8_t type)
+{
+#define LG_NAME_CASE(name) case name: return #name;
+    switch (type)
+    {
+        LG_MESSAGE_NAMES(LG_NAME_CASE)
+    default:
+        return "-";
+    }
+#undef LG_NAME_CASE
+}
+
+static double ms(uint64_t ns)
+{
+    return (double)ns / 1e6;
+}
+
+static int count_active(void)
+{
+    int active = 0;
+    for (int i = 0; i < conn_count; i++)
+    {
+        if (conns[i].state >= CONN_AUTH && conns[i].state < CONN_CLOSED)
+        {
+            active++;
+        }
+    }
+    return active;
+}
+
+static void print_progress(double elapsed_s, const lg_stats_t *prev)
+{
+    const latency_hist_t *draw = &stats.ops[OP_DRAW_FANOUT].hist;
+    const latency_hist_t *chat = &stats.ops[OP_CHAT_FANOUT].hist;
+    printf("[%5.1fs] ket noi %d/%d  out %llu msg/s  in %llu msg/s  draw p99 %.2fms  chat p99 %.2fms  roi %llu\n",
+           elapsed_s, count_active(), conn_count,
+           (unsigned long long)(stats.msgs_out - prev->msgs_out),
+           (unsigned long long)(stats.msgs_in - prev->msgs_in),
+           ms(latency_hist_quantile(draw, 0.99)), ms(latency_hist_quantile(chat, 0.99)),
+           (unsigned long long)stats.disconnected);
+    fflush(stdout);
+}
+
+static int print_report(double elapsed_s)
+{
+    printf("\n=== Ket qua sau %.1fs ===\n", elapsed_s);
+    printf("Ket noi: %llu mo, %llu thanh cong, %llu loi connect, %llu bi server dong, %d con hoat dong\n",
+           (unsigned long long)stats.connects_started, (unsigned long long)stats.connects_ok,
+           (unsigned long long)stats.connect_failed, (unsigned long long)stats.disconnected, count_active());
+    printf("Gui:  %llu msg (%.1f msg/s), %.2f MB\n", (unsigned long long)stats.msgs_out,
+           (double)stats.msgs_out / elapsed_s, (double)stats.bytes_out / (1024.0 * 1024.0));
+    printf("Nhan: %llu msg (%.1f msg/s), %.2f MB\n", (unsigned long long)stats.msgs_in,
+           (double)stats.msgs_in / elapsed_s, (double)stats.bytes_in / (1024.0 * 1024.0));
+
+    printf("\n%-12s %9s %7s %7s %9s %9s %9s %9s %9s\n", "Do tre (ms)", "count", "loi", "timeout",
+           "mean", "p50", "p90", "p99", "max");
+    uint64_t failures = stats.connect_failed + stats.disconnected + stats.protocol_errors + stats.tx_overflow;
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        const lg_op_stats_t *s = &stats.ops[op];
+        if (s->sent == 0 && s->hist.count == 0)
+        {
+            continue;
+        }
+        printf("%-12s %9llu %7llu %7llu %9.3f %9.3f %9.3f %9.3f %9.3f\n", op_names[op],
+               (unsigned long long)s->hist.count, (unsigned long long)s->errors,
+               (unsigned long long)s->timeouts,
+               s->hist.count ? ms(s->hist.sum_ns / s->hist.count) : 0.0,
+               ms(latency_hist_quantile(&s->hist, 0.5)), ms(latency_hist_quantile(&s->hist, 0.9)),
+               ms(latency_hist_quantile(&s->hist, 0.99)), ms(s->hist.max_ns));
+        failures += s->errors + s->timeouts;
+    }
+
+    printf("\nMessage nhan theo loai:\n");
+    for (int type = 0; type < 256; type++)
+    {
+        if (stats.recv_by_type[type])
+        {
+            printf("  0x%02X %-32s %10llu\n", type, message_name((uint8_t)type),
+                   (unsigned long long)stats.recv_by_type[type]);
+        }
+    }
+
+    if (stats.protocol_errors || stats.tx_overflow)
+    {
+        printf("\nLoi khac: %llu frame khong hop le, %llu message bi bo do buffer gui day\n",
+               (unsigned long long)stats.protocol_errors, (unsigned long long)stats.tx_overflow);
+    }
+    printf("\nTong loi: %llu\n", (unsigned long long)failures);
+    return failures > 0 ? 1 : 0;
+}
+
+// ============================================
+// main
+// ============================================
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Cach dung: %s [--host=IP] [--port=N] [--rooms=N] [--guessers=N] [--lobby=N] [--duration=SEC]\n"
+            "           [--draw-rate=N] [--chat-interval=MS] [--lobby-interval=MS] [--ramp=N] [--rounds=N]\n"
+            "           [--prefix=TEN] [--password=MK]\n",
+            prog);
+}
+
+static int parse_int_option(const char *arg, const char *name, int min, int max, int *out)
+{
+    size_t name_len = strlen(name);
+    if (strncmp(arg, name, name_len) != 0)
+    {
+        return 0;
+    }
+    char *end = NULL;
+    long value = strtol(arg + name_len, &end, 10);
+    if (end == arg + name_len || *end != '\0' || value < min || value > max)
+    {
+        fprintf(stderr, "Gia tri khong hop le: %s (%d..%d)\n", arg, min, max);
+        exit(2);
+    }
+    *out = (int)value;
+    return 1;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--host=", 7) == 0)
+        {
+            config.host = arg + 7;
+        }
+        else if (strncmp(arg, "--prefix=", 9) == 0)
+        {
+            config.prefix = arg + 9;
+        }
+        else if (strncmp(arg, "--password=", 11) == 0)
+        {
+            config.password = arg + 11;
+        }
+        else if (parse_int_option(arg, "--port=", 1, 65535, &config.port) ||
+                 parse_int_option(arg, "--rooms=", 0, LG_MAX_CONNS, &config.rooms) ||
+                 parse_int_option(arg, "--guessers=", 1, LG_MAX_ROOM_PLAYERS - 2, &config.guessers) ||
+                 parse_int_option(arg, "--lobby=", 0, LG_MAX_CONNS, &config.lobby) ||
+                 parse_int_option(arg, "--duration=", 1, 86400, &config.duration_s) ||
+                 parse_int_option(arg, "--draw-rate=", 1, 1000, &config.draw_rate) ||
+                 parse_int_option(arg, "--chat-interval=", 10, 3600000, &config.chat_interval_ms) ||
+                 parse_int_option(arg, "--lobby-interval=", 10, 3600000, &config.lobby_interval_ms) ||
+                 parse_int_option(arg, "--ramp=", 1, 100000, &config.ramp) ||
+                 parse_int_option(arg, "--rounds=", 1, 10, &config.rounds))
+        {
+            continue;
+        }
+        else
+        {
+            fprintf(stderr, "Tuy chon khong hop le: %s\n", arg);
+            usage(argv[0]);
+            exit(2);
+        }
+    }
+
+    // Username: tien to + '_' + 5 chu so phai vua MAX_USERNAME_LEN va bat dau bang chu cai
+    if (strlen(config.prefix) == 0 || strlen(config.prefix) > MAX_USERNAME_LEN - 8)
+    {
+        fprintf(stderr, "Tien to username phai co 1-%d ky tu\n", MAX_USERNAME_LEN - 8);
+        exit(2);
+    }
+}
+
+// Nang gioi han file descriptor cho hang nghin ket noi (toi da hard limit)
+static void raise_fd_limit(int needed)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur >= (rlim_t)needed)
+    {
+        return;
+    }
+    rl.rlim_cur = rl.rlim_max == RLIM_INFINITY || rl.rlim_max >= (rlim_t)needed ? (rlim_t)needed : rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur < (rlim_t)needed)
+    {
+        fprintf(stderr, "Canh bao: gioi han fd %llu < %d, mot so ket noi se loi\n",
+                (unsigned long long)rl.rlim_cur, needed);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+
+    conn_count = config.rooms * (1 + config.guessers) + config.lobby;
+    if (conn_count == 0 || conn_count > LG_MAX_CONNS)
+    {
+        fprintf(stderr, "So ket noi phai tu 1-%d (hien tai %d)\n", LG_MAX_CONNS, conn_count);
+        return 2;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)config.port);
+    if (inet_pton(AF_INET, config.host, &addr.sin_addr) != 1)
+    {
+        fprintf(stderr, "Dia chi khong hop le: %s\n", config.host);
+        return 2;
+    }
+
+    raise_fd_limit(conn_count + 64);
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    seed ^= (uint64_t)getpid() << 16;
+
+    conns = calloc((size_t)conn_count, sizeof(lg_conn_t));
+    groups = calloc((size_t)(config.rooms > 0 ? config.rooms : 1), sizeof(lg_group_t));
+    if (!conns || !groups || poller_init(conn_count) != 0)
+    {
+        fprintf(stderr, "Khong the khoi tao load generator\n");
+        return 2;
+    }
+
+    // Thu tu mo: owner truoc (tao phong), roi guesser, cuoi cung lobby
+    int index = 0;
+    for (int g = 0; g < config.rooms; g++)
+    {
+        conns[index].persona = PERSONA_OWNER;
+        conns[index++].group = g;
+    }
+    for (int k = 0; k < config.guessers; k++)
+    {
+        for (int g = 0; g < config.rooms; g++)
+        {
+            conns[index].persona = PERSONA_GUESSER;
+            conns[index++].group = g;
+        }
+    }
+    for (int l = 0; l < config.lobby; l++)
+    {
+        conns[index].persona = PERSONA_LOBBY;
+        conns[index++].group = -1;
+    }
+    for (int i = 0; i < conn_count; i++)
+    {
+        conns[i].fd = -1;
+        conns[i].rx = malloc(LG_RX_SIZE);
+        conns[i].tx = malloc(LG_TX_SIZE);
+        if (!conns[i].rx || !conns[i].tx)
+        {
+            fprintf(stderr, "Het bo nho\n");
+            return 2;
+        }
+        snprintf(conns[i].username, sizeof(conns[i].username), "%s_%05d", config.prefix, i);
+    }
+
+    printf("=== Load generator: %s:%d, %ds, %d phong x (1 owner + %d guesser), %d lobby = %d ket noi ===\n",
+           config.host, config.port, config.duration_s, config.rooms, config.guessers, config.lobby, conn_count);
+    printf("Drawer %d DRAW_DATA/s, chat moi ~%dms, lobby moi ~%dms, mo %d ket noi/s\n\n",
+           config.draw_rate, config.chat_interval_ms, config.lobby_interval_ms, config.ramp);
+
+    uint64_t start = utils_now_ns();
+    uint64_t end = start + (uint64_t)config.duration_s * 1000000000ull;
+    uint64_t next_progress = start + 1000000000ull;
+    lg_stats_t prev = stats;
+    int opened = 0;
+    lg_event_t events[LG_MAX_EVENTS];
+
+    while (!stop_requested)
+    {
+        uint64_t now = utils_now_ns();
+        if (now >= end)
+        {
+            break;
+        }
+
+        // Mo dan ket noi theo --ramp de khong tran backlog accept cua server
+        int target = (int)((now - start) / 1000 * (uint64_t)config.ramp / 1000000) + 1;
+        while (opened < conn_count && opened < target)
+        {
+            conn_open(opened++, &addr, now);
+        }
+
+        int n = poller_wait(events, LG_MAX_EVENTS, 1);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+        now = utils_now_ns();
+        for (int e = 0; e < n; e++)
+        {
+            int i = events[e].index;
+            lg_conn_t *c = &conns[i];
+            if (c->fd < 0)
+            {
+                continue;
+            }
+            if (c->state == CONN_CONNECTING)
+            {
+                if (events[e].writable || events[e].failed)
+                {
+                    conn_connected(i, now);
+                }
+                continue;
+            }
+            if (events[e].readable || events[e].failed)
+            {
+                conn_read(i);
+            }
+            if (c->fd >= 0 && events[e].writable)
+            {
+                conn_flush(i);
+            }
+        }
+
+        for (int i = 0; i < opened; i++)
+        {
+            if (conns[i].fd >= 0 && conns[i].state > CONN_AUTH)
+            {
+                persona_tick(i, now);
+            }
+            else if (conns[i].fd >= 0)
+            {
+                // Chi kiem tra timeout khi dang register/login
+                for (int op = 0; op < OP_COUNT; op++)
+                {
+                    if (conns[i].pending_ns[op] && now > conns[i].pending_ns[op] + LG_REQUEST_TIMEOUT_NS)
+                    {
+                        stats.ops[op].timeouts++;
+                        conns[i].pending_ns[op] = 0;
+                    }
+                }
+            }
+        }
+
+        if (now >= next_progress)
+        {
+            print_progress((double)(now - start) / 1e9, &prev);
+            prev = stats;
+            next_progress += 1000000000ull;
+        }
+    }
+
+    double elapsed_s = (double)(utils_now_ns() - start) / 1e9;
+    for (int i = 0; i < conn_count; i++)
+    {
+        if (conns[i].fd >= 0)
+        {
+            conns[i].state = CONN_CLOSED;
+            conn_close(i, 0);
+        }
+    }
+    int result = print_report(elapsed_s);
+
+    for (int i = 0; i < conn_count; i++)
+    {
+        free(conns[i].rx);
+        free(conns[i].tx);
+    }
+    free(conns);
+    free(groups);
+    poller_close();
+    return result;
+}
@@ -0,0 +1,691 @@
+/**
+ * Microbenchmark cac kernel protocol / ve / xac thuc
+ *
+ * Cach dung:
+ *   make bench
+ *   ./micro_bench                              # bang ket qua cho nguoi doc
+ *   ./micro_bench --format=csv > base.csv      # luu moc truoc khi toi uu
+ *   ./micro_bench --baseline=base.csv          # so sanh, ma thoat 1 neu cham hon nguong
+ *   ./micro_bench --filter=drawing --samples=30 --format=json
+ *
+ * Dieu khien so vong lap: moi case duoc hieu chinh (gap doi so vong lap) cho den
+ * khi mot mau dai it nhat --min-time-ms, chay mot mau khoi dong roi do --samples mau.
+ * Bao cao trung vi ns/op (on dinh hon trung binh khi may bi nhieu) va do phan tan
+ * MAD/trung vi de biet mot thay doi co vuot nhieu hay khong.
+ * --iterations=N bo qua hieu chinh; voi --baseline moi case chay dung so vong lap
+ * da ghi trong baseline de hai lan do lam cung mot luong viec.
+ *
+ * Room list: payload dung giong room_list_frame (protocol_room.c) bang codec,
+ * vi ham do doc phong tu server_t.
+ */
+#include "../include/protocol.h"
+#include "../include/drawing.h"
+#include "../include/sha256.h"
+#include "../include/auth.h"
+#include "../include/utils.h"
+#include "../common/codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_CASES         64
+#define BENCH_MAX_SAMPLES       1000
+#define BENCH_NAME_LEN          64
+#define BENCH_FRAME_MAX         (64 * 1024 + MSG_EXTENDED_HEADER_SIZE)
+
+typedef struct {
+    const char *name;
+    void (*run)(uint64_t iterations);
+    size_t bytes_per_op;        // > 0: bao cao them MB/s
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    uint64_t iterations;        // Vong lap moi mau
+    int samples;
+    double median_ns;           // ns/op
+    double min_ns;
+    double max_ns;
+    double mad_pct;             // Median absolute deviation / trung vi (%)
+    double mb_per_s;
+} bench_result_t;
+
+typedef struct {
+    const char *filter;
+    const char *format;         // text | csv | json
+    const char *baseline;
+    int samples;
+    int min_time_ms;
+    uint64_t iterations;        // 0 = tu hieu chinh
+    double threshold_pct;       // Cham hon baseline qua nguong nay = hoi quy
+} bench_options_t;
+
+static bench_options_t options = {
+    .filter = NULL,
+    .format = "text",
+    .baseline = NULL,
+    .samples = 15,
+    .min_time_ms = 20,
+    .iterations = 0,
+    .threshold_pct = 10.0,
+};
+
+// Ket qua ghi vao day de compiler khong loai bo phep tinh
+static volatile uint64_t bench_sink;
+
+// ============================================
+// Du lieu dau vao
+// ============================================
+
+static uint8_t frame_small[MSG_HEADER_SIZE + 16];
+static uint8_t frame_medium[MSG_HEADER_SIZE + 1024];
+static uint8_t frame_large[BENCH_FRAME_MAX];
+static size_t frame_large_len;
+static uint8_t payload_buf[64 * 1024];
+static uint8_t out_buf[BENCH_FRAME_MAX];
+
+#define BENCH_DRAW_ACTIONS 256
+static uint8_t draw_payloads[BENCH_DRAW_ACTIONS][14];
+static draw_action_t draw_actions[BENCH_DRAW_ACTIONS];
+
+static uint8_t sha_data[1024];
+
+#define BENCH_GUESSES 8
+static const char *guess_words[BENCH_GUESSES] = {"con meo", "Con Meo", "CON MEO", "con cho", "meo", "con meo ", "ConMeo", "con MEO"};
+static const char *guess_target = "con meo";
+
+static room_info_t room_infos[MAX_ROOMS];
+
+static void setup_inputs(void)
+{
+    for (size_t i = 0; i < sizeof(payload_buf); i++)
+    {
+        payload_buf[i] = (uint8_t)(i * 31 + 7);
+    }
+    protocol_create_message(MSG_CHAT_MESSAGE, payload_buf, 16, frame_small);
+    protocol_create_message(MSG_DRAW_DATA, payload_buf, 1024, frame_medium);
+    size_t header = protocol_write_header(MSG_CANVAS_SNAPSHOT, 64 * 1024, frame_large);
+    memcpy(frame_large + header, payload_buf, 64 * 1024);
+    frame_large_len = header + 64 * 1024;
+
+    // Net ve hop le voi toa do/mau/do rong thay doi (giong mousemove)
+    for (int i = 0; i < BENCH_DRAW_ACTIONS; i++)
+    {
+        draw_action_t action = {
+            .action = i % 16 == 0 ? DRAW_ACTION_MOVE : DRAW_ACTION_LINE,
+            .x1 = (uint16_t)((i * 7) % MAX_CANVAS_WIDTH),
+            .y1 = (uint16_t)((i * 5) % MAX_CANVAS_HEIGHT),
+            .x2 = (uint16_t)((i * 7 + 3) % MAX_CANVAS_WIDTH),
+            .y2 = (uint16_t)((i * 5 + 2) % MAX_CANVAS_HEIGHT),
+            .color = 0xFF000000u | (uint32_t)(i * 0x010203),
+            .width = (uint8_t)(MIN_BRUSH_WIDTH + i % MAX_BRUSH_WIDTH),
+        };
+        draw_actions[i] = action;
+        drawing_serialize_action(&action, draw_payloads[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(sha_data); i++)
+    {
+        sha_data[i] = (uint8_t)(i ^ 0x5A);
+    }
+
+    for (int i = 0; i < MAX_ROOMS; i++)
+    {
+        room_info_t *info = &room_infos[i];
+        memset(info, 0, sizeof(*info));
+        info->room_id = 1000 + i;
+        snprintf(info->room_name, sizeof(info->room_name), "Phong so %d", i + 1);
+        info->player_count = 1 + i % 8;
+        info->max_players = 8;
+        info->state = i % 3 == 0 ? ROOM_PLAYING : ROOM_WAITING;
+        info->owner_id = 10 + i;
+        snprintf(info->owner_username, sizeof(info->owner_username), "player_%d", i);
+    }
+}
+
+// ============================================
+// Cac case
+// ============================================
+
+static void run_parse(const uint8_t *frame, size_t len, uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        message_t msg;
+        if (protocol_parse_message(frame, len, &msg) == 0)
+        {
+            acc += msg.length + (msg.payload ? msg.payload[0] : 0);
+            free(msg.payload);
+        }
+    }
+    bench_sink += acc;
+}
+
+static void bench_parse_16(uint64_t iterations)
+{
+    run_parse(frame_small, sizeof(frame_small), iterations);
+}
+
+static void bench_parse_1k(uint64_t iterations)
+{
+    run_parse(frame_medium, sizeof(frame_medium), iterations);
+}
+
+static void bench_parse_64k(uint64_t iterations)
+{
+    run_parse(frame_large, frame_large_len, iterations);
+}
+
+static void run_create(uint16_t len, uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        acc += (uint64_t)protocol_create_message(MSG_CHAT_BROADCAST, payload_buf, len, out_buf);
+        acc += out_buf[(i & 15) + 1];
+    }
+    bench_sink += acc;
+}
+
+static void bench_create_16(uint64_t iterations)
+{
+    run_create(16, iterations);
+}
+
+static void bench_create_1k(uint64_t iterations)
+{
+    run_create(1024, iterations);
+}
+
+static void bench_draw_parse(uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        draw_action_t action;
+        if (drawing_parse_action(draw_payloads[i % BENCH_DRAW_ACTIONS], 14, &action) == 0)
+        {
+            acc += action.x2 + action.color;
+        }
+    }
+    bench_sink += acc;
+}
+
+static void bench_draw_serialize(uint64_t iterations)
+{
+    uint64_t acc = 0;
+    uint8_t out[14];
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        acc += (uint64_t)drawing_serialize_action(&draw_actions[i % BENCH_DRAW_ACTIONS], out);
+        acc += out[9];
+    }
+    bench_sink += acc;
+}
+
+static void bench_draw_validate(uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        acc += drawing_validate_action(&draw_actions[i % BENCH_DRAW_ACTIONS]);
+    }
+    bench_sink += acc;
+}
+
+static void run_sha256(size_t len, uint64_t iterations)
+{
+    uint64_t acc = 0;
+    uint8_t hash[32];
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        sha_data[0] = (uint8_t)i;
+        sha256(sha_data, len, hash);
+        acc += hash[0];
+    }
+    bench_sink += acc;
+}
+
+static void bench_sha256_64(uint64_t iterations)
+{
+    run_sha256(64, iterations);
+}
+
+static void bench_sha256_1k(uint64_t iterations)
+{
+    run_sha256(1024, iterations);
+}
+
+static void bench_hash_password(uint64_t iterations)
+{
+    uint64_t acc = 0;
+    char hash[65];
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        if (auth_hash_password("matkhau_123", hash) == 0)
+        {
+            acc += (uint8_t)hash[i & 63];
+        }
+    }
+    bench_sink += acc;
+}
+
+static void bench_guess_match(uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        acc += (uint64_t)utils_words_equal_ci(guess_words[i % BENCH_GUESSES], guess_target);
+    }
+    bench_sink += acc;
+}
+
+// Giong room_list_frame: header + [count:2] + count x room_info + [seq:4]
+static size_t write_room_list(int room_count, uint32_t seq, uint8_t *frame)
+{
+    size_t payload_size = 2 + (size_t)room_count * CODEC_ROOM_INFO_MAX_SIZE + 4;
+    size_t header_len = protocol_write_header(MSG_ROOM_LIST_RESPONSE, payload_size, frame);
+
+    wire_writer_t w;
+    wire_writer_init(&w, frame + header_len, payload_size);
+    wire_put_u16(&w, (uint16_t)room_count);
+    for (int i = 0; i < room_count; i++)
+    {
+        const room_info_t *info = &room_infos[i];
+        msg_room_info_t proto = {
+            .room_id = info->room_id,
+            .player_count = (uint8_t)info->player_count,
+            .max_players = (uint8_t)info->max_players,
+            .state = (uint8_t)info->state,
+            .owner_id = info->owner_id,
+        };
+        snprintf(proto.room_name, sizeof(proto.room_name), "%s", info->room_name);
+        snprintf(proto.owner_username, sizeof(proto.owner_username), "%s",
+                 info->owner_username[0] ? info->owner_username : "Unknown");
+        msg_room_info_write(&proto, &w);
+    }
+    wire_put_u32(&w, seq);
+    return header_len + w.len;
+}
+
+static void run_room_list(int room_count, uint64_t iterations)
+{
+    uint64_t acc = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        acc += write_room_list(room_count, (uint32_t)i, out_buf);
+    }
+    bench_sink += acc;
+}
+
+static void bench_room_list_10(uint64_t iterations)
+{
+    run_room_list(10, iterations);
+}
+
+static void bench_room_list_50(uint64_t iterations)
+{
+    run_room_list(MAX_ROOMS, iterations);
+}
+
+static const bench_case_t cases[] = {
+    {"protocol_parse_message/16B", bench_parse_16, 16},
+    {"protocol_parse_message/1KB", bench_parse_1k, 1024},
+    {"protocol_parse_message/64KB", bench_parse_64k, 64 * 1024},
+    {"protocol_create_message/16B", bench_create_16, 16},
+    {"protocol_create_message/1KB", bench_create_1k, 1024},
+    {"drawing_parse_action", bench_draw_parse, 14},
+    {"drawing_serialize_action", bench_draw_serialize, 14},
+    {"drawing_validate_action", bench_draw_validate, 0},
+    {"sha256/64B", bench_sha256_64, 64},
+    {"sha256/1KB", bench_sha256_1k, 1024},
+    {"auth_hash_password", bench_hash_password, 0},
+    {"guess_match", bench_guess_match, 0},
+    {"room_list_serialize/10", bench_room_list_10, 0},
+    {"room_list_serialize/50", bench_room_list_50, 0},
+};
+
+#define BENCH_CASE_COUNT ((int)(sizeof(cases) / sizeof(cases[0])))
+
+// ============================================
+// Baseline (CSV do chinh chuong trinh nay xuat)
+// ============================================
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    uint64_t iterations;
+    double median_ns;
+} baseline_entry_t;
+
+static baseline_entry_t baseline[BENCH_MAX_CASES];
+static int baseline_count = 0;
+
+static int load_baseline(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return -1;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f) && baseline_count < BENCH_MAX_CASES)
+    {
+        baseline_entry_t *entry = &baseline[baseline_count];
+        unsigned long long iterations = 0;
+        int samples = 0;
+        // name,iterations,samples,median_ns,... (dong tieu de khong khop va bi bo qua)
+        if (sscanf(line, "%63[^,],%llu,%d,%lf", entry->name, &iterations, &samples, &entry->median_ns) == 4)
+        {
+            entry->iterations = (uint64_t)iterations;
+            baseline_count++;
+        }
+    }
+    fclose(f);
+    if (baseline_count == 0)
+    {
+        fprintf(stderr, "Baseline %s khong co dong hop le (can --format=csv)\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static const baseline_entry_t *find_baseline(const char *name)
+{
+    for (int i = 0; i < baseline_count; i++)
+    {
+        if (strcmp(baseline[i].name, name) == 0)
+        {
+            return &baseline[i];
+        }
+    }
+    return NULL;
+}
+
+// Phan tram thay doi so voi baseline (duong = cham hon)
+static int baseline_delta(const bench_result_t *r, double *delta_pct)
+{
+    const baseline_entry_t *base = find_baseline(r->name);
+    if (!base || base->median_ns <= 0)
+    {
+        return 0;
+    }
+    *delta_pct = (r->median_ns - base->median_ns) / base->median_ns * 100.0;
+    return 1;
+}
+
+// ============================================
+// Do va thong ke
+// ============================================
+
+static uint64_t time_run(const bench_case_t *c, uint64_t iterations)
+{
+    uint64_t start = utils_now_ns();
+    c->run(iterations);
+    return utils_now_ns() - start;
+}
+
+// Gap doi so vong lap den khi mot mau dai it nhat min_time_ms
+static uint64_t calibrate(const bench_case_t *c)
+{
+    uint64_t target_ns = (uint64_t)options.min_time_ms * 1000000u;
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        uint64_t elapsed = time_run(c, iterations);
+        if (elapsed >= target_ns || iterations >= (1ull << 40))
+        {
+            return iterations;
+        }
+        // Nhay thang toi uoc luong khi con xa, tranh hang chuc lan gap doi voi case rat nhanh
+        if (elapsed > 0 && elapsed * 8 < target_ns)
+        {
+            iterations = iterations * (target_ns / elapsed);
+        }
+        else
+        {
+            iterations *= 2;
+        }
+    }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double median_sorted(const double *values, int count)
+{
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+static bench_result_t run_case(const bench_case_t *c)
+{
+    static double samples[BENCH_MAX_SAMPLES];
+    static double deviations[BENCH_MAX_SAMPLES];
+    bench_result_t result = {.name = c->name, .samples = options.samples};
+
+    // Co baseline thi chay dung so vong lap cua lan do de hai ket qua so sanh duoc
+    const baseline_entry_t *base = find_baseline(c->name);
+    if (options.iterations)
+    {
+        result.iterations = options.iterations;
+    }
+    else if (base && base->iterations)
+    {
+        result.iterations = base->iterations;
+    }
+    else
+    {
+        result.iterations = calibrate(c);
+    }
+    time_run(c, result.iterations); // Khoi dong cache/branch predictor
+
+    for (int s = 0; s < options.samples; s++)
+    {
+        samples[s] = (double)time_run(c, result.iterations) / (double)result.iterations;
+    }
+    qsort(samples, (size_t)options.samples, sizeof(double), compare_double);
+    result.median_ns = median_sorted(samples, options.samples);
+    result.min_ns = samples[0];
+    result.max_ns = samples[options.samples - 1];
+
+    for (int s = 0; s < options.samples; s++)
+    {
+        double d = samples[s] - result.median_ns;
+        deviations[s] = d < 0 ? -d : d;
+    }
+    qsort(deviations, (size_t)options.samples, sizeof(double), compare_double);
+    result.mad_pct = result.median_ns > 0 ? median_sorted(deviations, options.samples) / result.median_ns * 100.0 : 0.0;
+    result.mb_per_s = c->bytes_per_op && result.median_ns > 0
+                          ? (double)c->bytes_per_op / result.median_ns * 1e9 / (1024.0 * 1024.0)
+                          : 0.0;
+    return result;
+}
+
+// ============================================
+// Xuat ket qua
+// ============================================
+
+static void print_header(void)
+{
+    if (strcmp(options.format, "csv") == 0)
+    {
+        printf("name,iterations,samples,median_ns,min_ns,max_ns,mad_pct,mb_per_s\n");
+    }
+    else if (strcmp(options.format, "json") == 0)
+    {
+        printf("{\"samples\": %d, \"min_time_ms\": %d, \"benchmarks\": [", options.samples, options.min_time_ms);
+    }
+    else
+    {
+        printf("%-30s %12s %12s %12s %12s %7s %10s%s\n", "Benchmark", "iterations", "median ns", "min ns",
+               "max ns", "MAD%", "MB/s", options.baseline ? "    vs base" : "");
+    }
+}
+
+static void print_result(const bench_result_t *r, int index)
+{
+    double delta = 0;
+    int has_delta = baseline_delta(r, &delta);
+
+    if (strcmp(options.format, "csv") == 0)
+    {
+        printf("%s,%llu,%d,%.3f,%.3f,%.3f,%.2f,%.1f\n", r->name, (unsigned long long)r->iterations, r->samples,
+               r->median_ns, r->min_ns, r->max_ns, r->mad_pct, r->mb_per_s);
+    }
+    else if (strcmp(options.format, "json") == 0)
+    {
+        printf("%s\n  {\"name\": \"%s\", \"iterations\": %llu, \"samples\": %d, \"median_ns\": %.3f, "
+               "\"min_ns\": %.3f, \"max_ns\": %.3f, \"mad_pct\": %.2f, \"mb_per_s\": %.1f",
+               index ? "," : "", r->name, (unsigned long long)r->iterations, r->samples, r->median_ns,
+               r->min_ns, r->max_ns, r->mad_pct, r->mb_per_s);
+        if (has_delta)
+        {
+            printf(", \"baseline_delta_pct\": %.2f", delta);
+        }
+        printf("}");
+    }
+    else
+    {
+        printf("%-30s %12llu %12.2f %12.2f %12.2f %7.2f %10.1f", r->name, (unsigned long long)r->iterations,
+               r->median_ns, r->min_ns, r->max_ns, r->mad_pct, r->mb_per_s);
+        if (has_delta)
+        {
+            printf("  %+8.1f%%%s", delta, delta > options.threshold_pct ? " CHAM" : "");
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+static void print_footer(void)
+{
+    if (strcmp(options.format, "json") == 0)
+    {
+        printf("\n]}\n");
+    }
+    fflush(stdout);
+}
+
+// ============================================
+// main
+// ============================================
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Cach dung: %s [--filter=CHUOI] [--samples=N] [--min-time-ms=MS] [--iterations=N]\n"
+            "           [--format=text|csv|json] [--baseline=FILE.csv] [--threshold=PCT] [--list]\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
+{
+    int list_only = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--filter=", 9) == 0)
+        {
+            options.filter = arg + 9;
+        }
+        else if (strncmp(arg, "--samples=", 10) == 0)
+        {
+            options.samples = atoi(arg + 10);
+        }
+        else if (strncmp(arg, "--min-time-ms=", 14) == 0)
+        {
+            options.min_time_ms = atoi(arg + 14);
+        }
+        else if (strncmp(arg, "--iterations=", 13) == 0)
+        {
+            options.iterations = strtoull(arg + 13, NULL, 10);
+        }
+        else if (strncmp(arg, "--format=", 9) == 0)
+        {
+            options.format = arg + 9;
+        }
+        else if (strncmp(arg, "--baseline=", 11) == 0)
+        {
+            options.baseline = arg + 11;
+        }
+        else if (strncmp(arg, "--threshold=", 12) == 0)
+        {
+            options.threshold_pct = atof(arg + 12);
+        }
+        else if (strcmp(arg, "--list") == 0)
+        {
+            list_only = 1;
+        }
+        else
+        {
+            fprintf(stderr, "Tuy chon khong hop le: %s\n", arg);
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (options.samples < 1 || options.samples > BENCH_MAX_SAMPLES || options.min_time_ms < 1 ||
+        (strcmp(options.format, "text") != 0 && strcmp(options.format, "csv") != 0 &&
+         strcmp(options.format, "json") != 0))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    if (options.baseline && load_baseline(options.baseline) != 0)
+    {
+        return 2;
+    }
+
+    if (list_only)
+    {
+        for (int i = 0; i < BENCH_CASE_COUNT; i++)
+        {
+            printf("%s\n", cases[i].name);
+        }
+        return 0;
+    }
+
+    int matched = 0;
+    for (int i = 0; i < BENCH_CASE_COUNT; i++)
+    {
+        matched += !options.filter || strstr(cases[i].name, options.filter) != NULL;
+    }
+    if (matched == 0)
+    {
+        fprintf(stderr, "Khong co benchmark nao khop filter '%s'\n", options.filter);
+        return 2;
+    }
+
+    setup_inputs();
+    print_header();
+
+    int printed = 0;
+    int regressions = 0;
+    for (int i = 0; i < BENCH_CASE_COUNT; i++)
+    {
+        if (options.filter && !strstr(cases[i].name, options.filter))
+        {
+            continue;
+        }
+        bench_result_t result = run_case(&cases[i]);
+        print_result(&result, printed++);
+
+        double delta = 0;
+        if (baseline_delta(&result, &delta) && delta > options.threshold_pct)
+        {
+            regressions++;
+        }
+    }
+    print_footer();
+
+    if (regressions > 0)
+    {
+        fprintf(stderr, "%d benchmark cham hon baseline qua %.1f%%\n", regressions, options.threshold_pct);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1595 @@
+/**
+ * Phat lai capture traffic (./main --capture=FILE) vao mot server moi
+ *
+ * Cach dung:
+ *   make replay
+ *   ./main 8080 --capture=prod.dgcap [--capture-anonymize]   # ghi lai traffic that
+ *   ./main 9090 &                                              # server can do (DB rieng)
+ *   ./traffic_replay prod.dgcap --port=9090 --speed=max --format=csv > base.csv
+ *   ./traffic_replay prod.dgcap --port=9090 --speed=max --baseline=base.csv
+ *
+ * Moi phien trong capture thanh mot ket noi, frame duoc gui dung thoi diem ghi
+ * chia cho --speed (1 = thoi gian thuc, N = nhanh N lan). --speed=max bo thoi gian
+ * cho giua cac ban ghi nhung giu thu tu toan cuc: ban ghi tiep theo duoc gui ngay
+ * khi moi request truoc do da co response (hoac qua RP_RESPONSE_WAIT_NS), nen
+ * START_GAME van di truoc DRAW_DATA cua drawer nhu luc ghi. Khi phat lai:
+ *   - LOGIN duoc gui kem REGISTER truoc do (cung username, mat khau CAPTURE_REPLAY_PASSWORD)
+ *     de DB rong cua server do van dang nhap duoc; loi "da ton tai" bi bo qua
+ *   - PONG trong capture bi bo, replayer tu tra loi PING cua server
+ *   - room_id trong JOIN_ROOM/LEAVE_ROOM duoc anh xa tu phong goc sang phong server moi
+ *     tao (ghi chu CAPTURE_ROOM), JOIN cho den khi CREATE_ROOM tuong ung co response
+ *
+ * Do tre request/response (cung kieu loadgen.c), tre lich (frame gui muon hon
+ * lich bao nhieu) va thong luong; --baseline so sanh voi ket qua CSV lan truoc,
+ * ma thoat 1 neu p99 hoac thong luong nhan te hon --threshold phan tram.
+ *
+ * Cong cu offline:
+ *   ./traffic_replay prod.dgcap --info                        # thong ke capture
+ *   ./traffic_replay prod.dgcap --anonymize=share.dgcap       # an danh capture da ghi
+ */
+#include "../include/capture.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define RP_RX_INITIAL           (64 * 1024)
+#define RP_PENDING_DEPTH        8           // Request cung loai dang cho response moi phien
+#define RP_ROOM_NOTES           8
+#define RP_ROOM_WAIT_NS         (2000ull * 1000000ull)  // JOIN cho anh xa phong toi da
+#define RP_RESPONSE_WAIT_NS     (1000ull * 1000000ull)  // Request khong co response sau chung nay = timeout
+#define RP_MAX_BASELINE         64
+
+// ============================================
+// Cau hinh
+// ============================================
+
+typedef enum {
+    FORMAT_TEXT = 0,
+    FORMAT_CSV,
+} rp_format_t;
+
+typedef struct {
+    const char *capture_path;
+    const char *host;
+    int port;
+    double speed;               // 0 = max
+    int max_conns;              // Ket noi dong thoi toi da (server gioi han MAX_CLIENTS)
+    int drain_ms;               // Cho response sau frame cuoi
+    rp_format_t format;
+    const char *baseline_path;
+    double threshold_pct;
+    const char *anonymize_out;
+    int info;
+} rp_config_t;
+
+static rp_config_t config = {
+    .host = "127.0.0.1",
+    .port = 8080,
+    .speed = 1.0,
+    .max_conns = 95,
+    .drain_ms = 1000,
+    .format = FORMAT_TEXT,
+    .threshold_pct = 10.0,
+};
+
+// ============================================
+// Thong ke
+// ============================================
+
+typedef enum {
+    OP_CONNECT = 0,
+    OP_HELLO,
+    OP_REGISTER,
+    OP_LOGIN,
+    OP_ROOM_LIST,
+    OP_CREATE_ROOM,
+    OP_JOIN_ROOM,
+    OP_LEAVE_ROOM,
+    OP_START_GAME,
+    OP_HISTORY,
+    OP_CHANGE_PASSWORD,
+    OP_PING,
+    OP_COUNT
+} rp_op_t;
+
+static const char *op_names[OP_COUNT] = {
+    "connect", "hello", "register", "login", "room_list", "create_room", "join_room",
+    "leave_room", "start_game", "history", "change_password", "ping",
+};
+
+typedef struct {
+    uint64_t sent;
+    uint64_t errors;            // Response co status loi (register: khong tinh, trung ten la binh thuong)
+    uint64_t timeouts;          // Khong co response sau RP_RESPONSE_WAIT_NS
+    latency_hist_t hist;
+} rp_op_stats_t;
+
+typedef struct {
+    rp_op_stats_t ops[OP_COUNT];
+    latency_hist_t lag;         // Thoi diem gui thuc te - thoi diem theo lich
+    uint64_t frames_out;
+    uint64_t frames_in;
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint64_t pong_dropped;      // PONG trong capture (replayer tu tra loi PING)
+    uint64_t register_added;    // REGISTER chen truoc LOGIN
+    uint64_t room_remapped;
+    uint64_t room_unmapped;     // JOIN/LEAVE het thoi gian cho anh xa, gui room_id goc
+    uint64_t connect_failed;
+    uint64_t disconnected;      // Server dong ket noi truoc CAPTURE_CLOSE
+    uint64_t protocol_errors;
+} rp_stats_t;
+
+static rp_stats_t stats;
+
+// ============================================
+// Capture trong bo nho
+// ============================================
+
+typedef struct {
+    capture_kind_t kind;
+    uint32_t session;
+    uint64_t t_us;
+    uint8_t type;
+    uint32_t len;
+    uint8_t *payload;
+    int32_t room_id;
+} rp_record_t;
+
+static rp_record_t *records = NULL;
+static size_t record_count = 0;
+static uint32_t session_count = 0;     // Id phien lon nhat
+static uint64_t capture_duration_us = 0;
+static uint8_t capture_flags = 0;
+
+static int load_capture(const char *path)
+{
+    capture_reader_t reader;
+    if (capture_reader_open(&reader, path) != 0)
+    {
+        return -1;
+    }
+    capture_flags = reader.flags;
+
+    size_t capacity = 0;
+    capture_record_t rec;
+    int status;
+    while ((status = capture_reader_next(&reader, &rec)) == 1)
+    {
+        if (record_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 4096;
+            rp_record_t *grown = realloc(records, capacity * sizeof(rp_record_t));
+            if (!grown)
+            {
+                fprintf(stderr, "Het bo nho\n");
+                capture_reader_close(&reader);
+                return -1;
+            }
+            records = grown;
+        }
+        rp_record_t *r = &records[record_count++];
+        r->kind = rec.kind;
+        r->session = rec.session;
+        r->t_us = rec.t_us;
+        r->type = rec.type;
+        r->len = rec.len;
+        r->room_id = rec.room_id;
+        r->payload = NULL;
+        if (rec.kind == CAPTURE_FRAME && rec.len > 0)
+        {
+            r->payload = malloc(rec.len);
+            if (!r->payload)
+            {
+                fprintf(stderr, "Het bo nho\n");
+                capture_reader_close(&reader);
+                return -1;
+            }
+            memcpy(r->payload, rec.payload, rec.len);
+        }
+        if (rec.session > session_count)
+        {
+            session_count = rec.session;
+        }
+        capture_duration_us = rec.t_us;
+    }
+    capture_reader_close(&reader);
+    if (status < 0)
+    {
+        // Server bi kill giua chung: van phat lai phan doc duoc
+        fprintf(stderr, "Canh bao: %s bi cat cut sau %zu ban ghi\n", path, record_count);
+    }
+    return 0;
+}
+
+// ============================================
+// Anh xa phong goc -> phong moi
+// ============================================
+
+typedef struct {
+    int32_t orig;
+    int32_t mapped;
+    int created;                // Phong goc duoc tao trong capture (co ghi chu CAPTURE_ROOM)
+    int has_mapping;
+} rp_room_t;
+
+static rp_room_t *rooms = NULL;
+static size_t room_count = 0;
+
+static rp_room_t *room_find(int32_t orig)
+{
+    for (size_t i = 0; i < room_count; i++)
+    {
+        if (rooms[i].orig == orig)
+        {
+            return &rooms[i];
+        }
+    }
+    return NULL;
+}
+
+static void room_prepare(void)
+{
+    size_t notes = 0;
+    for (size_t i = 0; i < record_count; i++)
+    {
+        notes += records[i].kind == CAPTURE_ROOM;
+    }
+    rooms = calloc(notes ? notes : 1, sizeof(rp_room_t));
+    for (size_t i = 0; rooms && i < record_count; i++)
+    {
+        if (records[i].kind == CAPTURE_ROOM && !room_find(records[i].room_id))
+        {
+            rooms[room_count].orig = records[i].room_id;
+            rooms[room_count++].created = 1;
+        }
+    }
+}
+
+// ============================================
+// Phien
+// ============================================
+
+typedef enum {
+    SESSION_IDLE = 0,
+    SESSION_CONNECTING,
+    SESSION_OPEN,
+    SESSION_CLOSED,
+} rp_session_state_t;
+
+typedef struct {
+    uint64_t sent_ns[RP_PENDING_DEPTH];
+    int head;
+    int count;
+} rp_pending_t;
+
+typedef struct {
+    int fd;
+    rp_session_state_t state;
+    size_t *queue;              // Chi so ban ghi FRAME da den lich nhung chua gui
+    size_t queue_head;
+    size_t queue_len;
+    size_t queue_capacity;
+    int close_pending;          // Da den CAPTURE_CLOSE, dong khi gui het
+    uint64_t blocked_since;     // JOIN dang cho anh xa phong (0 = khong)
+    uint64_t connect_ns;
+    rp_pending_t pending[OP_COUNT];
+    int32_t notes_orig[RP_ROOM_NOTES];  // Phong goc tu ghi chu chua co response
+    int notes_orig_count;
+    int32_t notes_new[RP_ROOM_NOTES];   // Phong moi tu response chua co ghi chu
+    int notes_new_count;
+    uint8_t *rx;
+    size_t rx_len;
+    size_t rx_capacity;
+    uint8_t *tx;
+    size_t tx_len;
+    size_t tx_capacity;
+} rp_session_t;
+
+static rp_session_t *sessions = NULL;  // Chi so = id phien
+static int open_count = 0;
+static uint64_t replay_start_ns = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static char (*registered)[MAX_USERNAME_LEN] = NULL;   // Username da REGISTER trong lan phat lai
+static size_t registered_count = 0;
+static size_t registered_capacity = 0;
+
+static void signal_handler(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void pending_push(rp_session_t *s, rp_op_t op, uint64_t now)
+{
+    rp_pending_t *p = &s->pending[op];
+    if (p->count == RP_PENDING_DEPTH)
+    {
+        // Bo request cu nhat (server khong tra loi), giu do tre cua request moi
+        p->head = (p->head + 1) % RP_PENDING_DEPTH;
+        p->count--;
+    }
+    p->sent_ns[(p->head + p->count) % RP_PENDING_DEPTH] = now;
+    p->count++;
+    stats.ops[op].sent++;
+}
+
+// Response khop request cu nhat cung loai (server tra loi theo thu tu trong mot ket noi)
+static void pending_pop(rp_session_t *s, rp_op_t op, int ok, uint64_t now)
+{
+    rp_pending_t *p = &s->pending[op];
+    if (p->count == 0)
+    {
+        return;
+    }
+    latency_hist_record(&stats.ops[op].hist, now - p->sent_ns[p->head]);
+    p->head = (p->head + 1) % RP_PENDING_DEPTH;
+    p->count--;
+    if (!ok && op != OP_REGISTER)
+    {
+        stats.ops[op].errors++;
+    }
+}
+
+// Bo request qua RP_RESPONSE_WAIT_NS (server khong tra loi, vd. START_GAME bi tu choi)
+static void pending_expire(rp_session_t *s, uint64_t now)
+{
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        rp_pending_t *p = &s->pending[op];
+        while (p->count > 0 && now - p->sent_ns[p->head] > RP_RESPONSE_WAIT_NS)
+        {
+            p->head = (p->head + 1) % RP_PENDING_DEPTH;
+            p->count--;
+            stats.ops[op].timeouts++;
+        }
+    }
+}
+
+static int session_waiting(const rp_session_t *s)
+{
+    for (int op = 0; op < OP_COUNT; op++)
+    {
+        if (s->pending[op].count > 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int op_for_request(uint8_t type)
+{
+    switch (type)
+    {
+    case MSG_HELLO: return OP_HELLO;
+    case MSG_REGISTER_REQUEST: return OP_REGISTER;
+    case MSG_LOGIN_REQUEST: return OP_LOGIN;
+    case MSG_ROOM_LIST_REQUEST: return OP_ROOM_LIST;
+    case MSG_CREATE_ROOM: return OP_CREATE_ROOM;
+    case MSG_JOIN_ROOM: return OP_JOIN_ROOM;
+    case MSG_LEAVE_ROOM: return OP_LEAVE_ROOM;
+    case MSG_START_GAME: return OP_START_GAME;
+    case MSG_GET_GAME_HISTORY: return OP_HISTORY;
+    case MSG_CHANGE_PASSWORD_REQUEST: return OP_CHANGE_PASSWORD;
+    case MSG_PING: return OP_PING;
+    default: return -1;
+    }
+}
+
+static int op_for_response(uint8_t type)
+{
+    switch (type)
+    {
+    case MSG_HELLO_ACK: return OP_HELLO;
+    case MSG_REGISTER_RESPONSE: return OP_REGISTER;
+    case MSG_LOGIN_RESPONSE: return OP_LOGIN;
+    case MSG_ROOM_LIST_RESPONSE: return OP_ROOM_LIST;
+    case MSG_CREATE_ROOM: return OP_CREATE_ROOM;
+    case MSG_JOIN_ROOM: return OP_JOIN_ROOM;
+    case MSG_LEAVE_ROOM: return OP_LEAVE_ROOM;
+    case MSG_GAME_START: return OP_START_GAME;
+    case MSG_GAME_HISTORY_RESPONSE: return OP_HISTORY;
+    case MSG_CHANGE_PASSWORD_RESPONSE: return OP_CHANGE_PASSWORD;
+    case MSG_PONG: return OP_PING;
+    default: return -1;
+    }
+}
+
+// Response bat dau bang byte status (cac loai con lai luon tinh la thanh cong)
+static int response_has_status(uint8_t type)
+{
+    return type == MSG_LOGIN_RESPONSE || type == MSG_REGISTER_RESPONSE || type == MSG_CREATE_ROOM ||
+           type == MSG_JOIN_ROOM || type == MSG_LEAVE_ROOM || type == MSG_CHANGE_PASSWORD_RESPONSE;
+}
+
+// ============================================
+// Gui / nhan
+// ============================================
+
+static void session_close(uint32_t id, int by_server)
+{
+    rp_session_t *s = &sessions[id];
+    if (s->fd >= 0)
+    {
+        close(s->fd);
+        s->fd = -1;
+        open_count--;
+    }
+    if (by_server && s->state != SESSION_CLOSED && !s->close_pending)
+    {
+        stats.disconnected++;
+    }
+    s->state = SESSION_CLOSED;
+    s->queue_len = 0;
+}
+
+static int session_flush(uint32_t id)
+{
+    rp_session_t *s = &sessions[id];
+    size_t sent = 0;
+    while (sent < s->tx_len)
+    {
+        ssize_t n = send(s->fd, s->tx + sent, s->tx_len - sent, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            session_close(id, 1);
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    stats.bytes_out += sent;
+    if (sent > 0)
+    {
+        memmove(s->tx, s->tx + sent, s->tx_len - sent);
+        s->tx_len -= sent;
+    }
+    return 0;
+}
+
+// Dong goi frame vao buffer gui (frame mo rong neu payload >= 0xFFFF, nhu client goc da gui)
+static int session_queue_frame(uint32_t id, uint8_t type, const uint8_t *payload, size_t len)
+{
+    rp_session_t *s = &sessions[id];
+    size_t header = len >= MSG_EXTENDED_LENGTH_MARKER ? MSG_EXTENDED_HEADER_SIZE : MSG_HEADER_SIZE;
+    if (s->tx_len + header + len > s->tx_capacity)
+    {
+        size_t capacity = s->tx_capacity ? s->tx_capacity : 16 * 1024;
+        while (capacity < s->tx_len + header + len)
+        {
+            capacity *= 2;
+        }
+        uint8_t *grown = realloc(s->tx, capacity);
+        if (!grown)
+        {
+            return -1;
+        }
+        s->tx = grown;
+        s->tx_capacity = capacity;
+    }
+    uint8_t *p = s->tx + s->tx_len;
+    p[0] = type;
+    if (header == MSG_HEADER_SIZE)
+    {
+        p[1] = (uint8_t)(len >> 8);
+        p[2] = (uint8_t)len;
+    }
+    else
+    {
+        p[1] = 0xFF;
+        p[2] = 0xFF;
+        p[3] = (uint8_t)(len >> 24);
+        p[4] = (uint8_t)(len >> 16);
+        p[5] = (uint8_t)(len >> 8);
+        p[6] = (uint8_t)len;
+    }
+    if (len > 0)
+    {
+        memcpy(p + header, payload, len);
+    }
+    s->tx_len += header + len;
+    stats.frames_out++;
+    return 0;
+}
+
+static int username_registered(const char *username)
+{
+    for (size_t i = 0; i < registered_count; i++)
+    {
+        if (strncmp(registered[i], username, MAX_USERNAME_LEN) == 0)
+        {
+            return 1;
+        }
+    }
+    if (registered_count == registered_capacity)
+    {
+        size_t capacity = registered_capacity ? registered_capacity * 2 : 256;
+        char (*grown)[MAX_USERNAME_LEN] = realloc(registered, capacity * MAX_USERNAME_LEN);
+        if (!grown)
+        {
+            return 0;
+        }
+        registered = grown;
+        registered_capacity = capacity;
+    }
+    strncpy(registered[registered_count], username, MAX_USERNAME_LEN);
+    registered_count++;
+    return 0;
+}
+
+// Tao tai khoan truoc LOGIN: server do thuong co DB rong
+static void send_register_for(uint32_t id, const uint8_t *login_payload, size_t len, uint64_t now)
+{
+    msg_login_request_t login;
+    if (msg_login_request_decode(login_payload, len, &login) < 0 || login.username[0] == '\0' ||
+        username_registered(login.username))
+    {
+        return;
+    }
+    msg_register_request_t reg;
+    memset(&reg, 0, sizeof(reg));
+    memcpy(reg.username, login.username, sizeof(reg.username));
+    snprintf(reg.password, sizeof(reg.password), "%s", CAPTURE_REPLAY_PASSWORD);
+    snprintf(reg.email, sizeof(reg.email), "%.*s@replay.invalid", MAX_USERNAME_LEN - 1, login.username);
+    uint8_t out[CODEC_REGISTER_REQUEST_MAX_SIZE];
+    size_t out_len = msg_register_request_encode(&reg, out, sizeof(out));
+    if (session_queue_frame(id, MSG_REGISTER_REQUEST, out, out_len) == 0)
+    {
+        pending_push(&sessions[id], OP_REGISTER, now);
+        stats.register_added++;
+    }
+}
+
+// room_id goc -> room_id tren server dang phat lai
+// @return 1 neu gui duoc ngay, 0 neu phai cho CREATE_ROOM tuong ung
+static int remap_room(rp_session_t *s, uint8_t *payload, size_t len, uint64_t now)
+{
+    if (len < 4)
+    {
+        return 1;
+    }
+    int32_t orig = (int32_t)(((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) |
+                             ((uint32_t)payload[2] << 8) | payload[3]);
+    rp_room_t *room = room_find(orig);
+    if (!room)
+    {
+        // Phong co tu truoc khi bat dau capture: khong co gi de anh xa
+        return 1;
+    }
+    if (!room->has_mapping)
+    {
+        if (!s->blocked_since)
+        {
+            s->blocked_since = now;
+        }
+        if (now - s->blocked_since < RP_ROOM_WAIT_NS)
+        {
+            return 0;
+        }
+        stats.room_unmapped++;
+        s->blocked_since = 0;
+        return 1;
+    }
+    uint32_t mapped = (uint32_t)room->mapped;
+    payload[0] = (uint8_t)(mapped >> 24);
+    payload[1] = (uint8_t)(mapped >> 16);
+    payload[2] = (uint8_t)(mapped >> 8);
+    payload[3] = (uint8_t)mapped;
+    s->blocked_since = 0;
+    stats.room_remapped++;
+    return 1;
+}
+
+// Ghep ghi chu CAPTURE_ROOM voi response CREATE_ROOM theo thu tu (khong phu thuoc cai nao den truoc)
+static void match_room_notes(rp_session_t *s)
+{
+    while (s->notes_orig_count > 0 && s->notes_new_count > 0)
+    {
+        rp_room_t *room = room_find(s->notes_orig[0]);
+        if (room)
+        {
+            room->mapped = s->notes_new[0];
+            room->has_mapping = 1;
+        }
+        memmove(s->notes_orig, s->notes_orig + 1, (size_t)(--s->notes_orig_count) * sizeof(int32_t));
+        memmove(s->notes_new, s->notes_new + 1, (size_t)(--s->notes_new_count) * sizeof(int32_t));
+    }
+}
+
+static uint64_t scheduled_ns(uint64_t t_us)
+{
+    if (config.speed <= 0)
+    {
+        return replay_start_ns;
+    }
+    return replay_start_ns + (uint64_t)((double)t_us * 1000.0 / config.speed);
+}
+
+// Gui cac frame da den lich cua phien theo thu tu, dung lai o JOIN dang cho anh xa
+static void session_pump(uint32_t id, uint64_t now)
+{
+    rp_session_t *s = &sessions[id];
+    if (s->state != SESSION_OPEN)
+    {
+        return;
+    }
+    while (s->queue_len > 0)
+    {
+        rp_record_t *r = &records[s->queue[s->queue_head]];
+        if (r->type == MSG_JOIN_ROOM || r->type == MSG_LEAVE_ROOM)
+        {
+            if (!remap_room(s, r->payload, r->len, now))
+            {
+                break;
+            }
+        }
+        s->queue_head++;
+        s->queue_len--;
+
+        if (r->type == MSG_PONG)
+        {
+            stats.pong_dropped++;
+            continue;
+        }
+        if (r->type == MSG_LOGIN_REQUEST)
+        {
+            send_register_for(id, r->payload, r->len, now);
+            // Capture ghi truoc khi co capture_scrub bat buoc van co the chua mat khau that
+            if (r->len >= MAX_USERNAME_LEN + MAX_PASSWORD_LEN)
+            {
+                memset(r->payload + MAX_USERNAME_LEN, 0, MAX_PASSWORD_LEN);
+                memcpy(r->payload + MAX_USERNAME_LEN, CAPTURE_REPLAY_PASSWORD, strlen(CAPTURE_REPLAY_PASSWORD));
+            }
+        }
+        else if (r->type == MSG_REGISTER_REQUEST && r->len >= MAX_USERNAME_LEN)
+        {
+            char username[MAX_USERNAME_LEN + 1];
+            memcpy(username, r->payload, MAX_USERNAME_LEN);
+            username[MAX_USERNAME_LEN] = '\0';
+            username_registered(username);
+        }
+        if (session_queue_frame(id, r->type, r->payload, r->len) != 0)
+        {
+            stats.protocol_errors++;
+            continue;
+        }
+        int op = op_for_request(r->type);
+        if (op >= 0)
+        {
+            pending_push(s, (rp_op_t)op, now);
+        }
+        if (config.speed > 0)
+        {
+            uint64_t due = scheduled_ns(r->t_us);
+            latency_hist_record(&stats.lag, now > due ? now - due : 0);
+        }
+    }
+    if (s->queue_len == 0)
+    {
+        s->queue_head = 0;
+    }
+    if (s->tx_len > 0 && session_flush(id) != 0)
+    {
+        return;
+    }
+    // Dong sau khi nhan du response (capture ghi CLOSE sau khi client da nhan chung)
+    if (s->queue_len == 0 && s->close_pending && s->tx_len == 0 && !session_waiting(s))
+    {
+        session_close(id, 0);
+    }
+}
+
+static void session_enqueue(uint32_t id, size_t record_index)
+{
+    rp_session_t *s = &sessions[id];
+    if (s->state == SESSION_CLOSED)
+    {
+        return;
+    }
+    if (s->queue_head + s->queue_len == s->queue_capacity)
+    {
+        if (s->queue_head > 0)
+        {
+            memmove(s->queue, s->queue + s->queue_head, s->queue_len * sizeof(size_t));
+            s->queue_head = 0;
+        }
+        else
+        {
+            size_t capacity = s->queue_capacity ? s->queue_capacity * 2 : 64;
+            size_t *grown = realloc(s->queue, capacity * sizeof(size_t));
+            if (!grown)
+            {
+                stats.protocol_errors++;
+                return;
+            }
+            s->queue = grown;
+            s->queue_capacity = capacity;
+        }
+    }
+    s->queue[s->queue_head + s->queue_len++] = record_index;
+}
+
+static void session_open(uint32_t id, const struct sockaddr_in *addr, uint64_t now)
+{
+    rp_session_t *s = &sessions[id];
+    s->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (s->fd < 0)
+    {
+        stats.connect_failed++;
+        s->state = SESSION_CLOSED;
+        return;
+    }
+    int flags = fcntl(s->fd, F_GETFL, 0);
+    fcntl(s->fd, F_SETFL, flags | O_NONBLOCK);
+    int one = 1;
+    setsockopt(s->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    open_count++;
+    s->state = SESSION_CONNECTING;
+    s->connect_ns = now;
+    stats.ops[OP_CONNECT].sent++;
+    if (connect(s->fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0 && errno != EINPROGRESS)
+    {
+        stats.connect_failed++;
+        session_close(id, 0);
+    }
+}
+
+static void session_connected(uint32_t id, uint64_t now)
+{
+    rp_session_t *s = &sessions[id];
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0)
+    {
+        stats.connect_failed++;
+        session_close(id, 0);
+        return;
+    }
+    latency_hist_record(&stats.ops[OP_CONNECT].hist, now - s->connect_ns);
+    s->state = SESSION_OPEN;
+    session_pump(id, now);
+}
+
+static void handle_message(uint32_t id, uint8_t type, const uint8_t *payload, size_t len, uint64_t now)
+{
+    rp_session_t *s = &sessions[id];
+    stats.frames_in++;
+
+    if (type == MSG_PING)
+    {
+        msg_ping_t ping;
+        if (msg_ping_decode(payload, len, &ping) < 0)
+        {
+            stats.protocol_errors++;
+            return;
+        }
+        uint64_t ms = utils_wall_ms();
+        msg_pong_t pong = {.seq = ping.seq, .origin_ms = ping.origin_ms, .recv_ms = ms, .send_ms = ms};
+        uint8_t out[CODEC_PONG_MAX_SIZE];
+        size_t out_len = msg_pong_encode(&pong, out, sizeof(out));
+        if (session_queue_frame(id, MSG_PONG, out, out_len) == 0)
+        {
+            session_flush(id);
+        }
+        return;
+    }
+
+    // MSG_COMPRESSED: chi can loai message ben trong de khop request, khong giai nen
+    uint8_t inner = type;
+    if (type == MSG_COMPRESSED && len >= 1)
+    {
+        inner = payload[0];
+    }
+    int op = op_for_response(inner);
+    if (op < 0)
+    {
+        return;
+    }
+    int ok = 1;
+    if (type == inner && response_has_status(type))
+    {
+        ok = len >= 1 && payload[0] == STATUS_SUCCESS;
+    }
+    if (type == MSG_CREATE_ROOM && ok && len >= 5 && s->notes_new_count < RP_ROOM_NOTES)
+    {
+        s->notes_new[s->notes_new_count++] = (int32_t)(((uint32_t)payload[1] << 24) | ((uint32_t)payload[2] << 16) |
+                                                       ((uint32_t)payload[3] << 8) | payload[4]);
+        match_room_notes(s);
+    }
+    pending_pop(s, (rp_op_t)op, ok, now);
+}
+
+static void session_read(uint32_t id, uint64_t now)
+{
+    rp_session_t *s = &sessions[id];
+    for (;;)
+    {
+        if (s->rx_len == s->rx_capacity)
+        {
+            size_t capacity = s->rx_capacity ? s->rx_capacity * 2 : RP_RX_INITIAL;
+            if (capacity > MSG_MAX_PAYLOAD_SIZE + MSG_EXTENDED_HEADER_SIZE)
+            {
+                stats.protocol_errors++;
+                session_close(id, 0);
+                return;
+            }
+            uint8_t *grown = realloc(s->rx, capacity);
+            if (!grown)
+            {
+                session_close(id, 0);
+                return;
+            }
+            s->rx = grown;
+            s->rx_capacity = capacity;
+        }
+        ssize_t n = recv(s->fd, s->rx + s->rx_len, s->rx_capacity - s->rx_len, 0);
+        if (n == 0)
+        {
+            session_close(id, 1);
+            return;
+        }
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                session_close(id, 1);
+            }
+            return;
+        }
+        stats.bytes_in += (uint64_t)n;
+        s->rx_len += (size_t)n;
+
+        // Tach frame: [TYPE][LEN:2] hoac [TYPE][0xFFFF][LEN:4]
+        size_t pos = 0;
+        while (s->fd >= 0 && s->rx_len - pos >= MSG_HEADER_SIZE)
+        {
+            const uint8_t *p = s->rx + pos;
+            size_t header = MSG_HEADER_SIZE;
+            size_t payload_len = ((size_t)p[1] << 8) | p[2];
+            if (payload_len == MSG_EXTENDED_LENGTH_MARKER)
+            {
+                if (s->rx_len - pos < MSG_EXTENDED_HEADER_SIZE)
+                {
+                    break;
+                }
+                header = MSG_EXTENDED_HEADER_SIZE;
+                payload_len = ((size_t)p[3] << 24) | ((size_t)p[4] << 16) | ((size_t)p[5] << 8) | p[6];
+                if (payload_len > MSG_MAX_PAYLOAD_SIZE)
+                {
+                    stats.protocol_errors++;
+                    session_close(id, 0);
+                    return;
+                }
+            }
+            if (s->rx_len - pos < header + payload_len)
+            {
+                break;
+            }
+            handle_message(id, p[0], p + header, payload_len, now);
+            pos += header + payload_len;
+        }
+        if (s->fd < 0)
+        {
+            return;
+        }
+        memmove(s->rx, s->rx + pos, s->rx_len - pos);
+        s->rx_len -= pos;
+    }
+}
+
+// ============================================
+// Lich phat lai
+// ============================================
+
+static void dispatch(size_t index, const struct sockaddr_in *addr, uint64_t now)
+{
+    rp_record_t *r = &records[index];
+    if (r->session == 0 || r->session > session_count)
+    {
+        return;
+    }
+    rp_session_t *s = &sessions[r->session];
+    switch (r->kind)
+    {
+    case CAPTURE_OPEN:
+        if (s->state == SESSION_IDLE)
+        {
+            session_open(r->session, addr, now);
+        }
+        break;
+    case CAPTURE_FRAME:
+        session_enqueue(r->session, index);
+        session_pump(r->session, now);
+        break;
+    case CAPTURE_CLOSE:
+        s->close_pending = 1;
+        session_pump(r->session, now);
+        break;
+    case CAPTURE_ROOM:
+        if (s->notes_orig_count < RP_ROOM_NOTES)
+        {
+            s->notes_orig[s->notes_orig_count++] = r->room_id;
+            match_room_notes(s);
+        }
+        break;
+    }
+}
+
+static int replay_idle(void)
+{
+    for (uint32_t id = 1; id <= session_count; id++)
+    {
+        const rp_session_t *s = &sessions[id];
+        if (s->state == SESSION_CONNECTING || s->queue_len > 0 || s->tx_len > 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int requests_outstanding(void)
+{
+    for (uint32_t id = 1; id <= session_count; id++)
+    {
+        if (sessions[id].fd >= 0 && session_waiting(&sessions[id]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static double run_replay(const struct sockaddr_in *addr)
+{
+    struct pollfd *fds = calloc(session_count + 1, sizeof(struct pollfd));
+    uint32_t *fd_session = calloc(session_count + 1, sizeof(uint32_t));
+    if (!fds || !fd_session)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        exit(2);
+    }
+
+    replay_start_ns = utils_now_ns();
+    uint64_t idle_since = 0;
+    size_t next = 0;
+    while (!stop_requested)
+    {
+        uint64_t now = utils_now_ns();
+        for (uint32_t id = 1; id <= session_count; id++)
+        {
+            if (sessions[id].fd >= 0)
+            {
+                pending_expire(&sessions[id], now);
+                if (sessions[id].close_pending)
+                {
+                    session_pump(id, now);
+                }
+            }
+        }
+        int gated = 0;
+        while (next < record_count && scheduled_ns(records[next].t_us) <= now)
+        {
+            // Khong mo qua --max-conns ket noi: cho phien khac dong (giu thu tu ban ghi)
+            if (records[next].kind == CAPTURE_OPEN && open_count >= config.max_conns)
+            {
+                break;
+            }
+            // --speed=max: cho moi request truoc do co response roi moi gui ban ghi tiep
+            if (config.speed <= 0 && (!replay_idle() || requests_outstanding()))
+            {
+                gated = 1;
+                break;
+            }
+            dispatch(next++, addr, now);
+        }
+
+        int nfds = 0;
+        int blocked = 0;
+        for (uint32_t id = 1; id <= session_count; id++)
+        {
+            rp_session_t *s = &sessions[id];
+            if (s->state == SESSION_OPEN && s->queue_len > 0)
+            {
+                session_pump(id, now);
+                blocked |= s->blocked_since != 0;
+            }
+            if (s->fd < 0)
+            {
+                continue;
+            }
+            fds[nfds].fd = s->fd;
+            fds[nfds].events = POLLIN;
+            if (s->state == SESSION_CONNECTING || s->tx_len > 0)
+            {
+                fds[nfds].events |= POLLOUT;
+            }
+            fds[nfds].revents = 0;
+            fd_session[nfds++] = id;
+        }
+
+        // Het lich va da gui het: dung khi moi request co response hoac qua --drain
+        // (khong doi "im lang" vi server van day PING/TIMER_UPDATE dinh ky)
+        if (next == record_count && replay_idle())
+        {
+            if (!idle_since)
+            {
+                idle_since = now;
+            }
+            if (!requests_outstanding() || now - idle_since >= (uint64_t)config.drain_ms * 1000000ull)
+            {
+                break;
+            }
+        }
+        else
+        {
+            idle_since = 0;
+        }
+
+        int timeout_ms = 50;
+        if (next < record_count)
+        {
+            uint64_t due = scheduled_ns(records[next].t_us);
+            if (records[next].kind == CAPTURE_OPEN && open_count >= config.max_conns)
+            {
+                timeout_ms = 10;
+            }
+            else
+            {
+                timeout_ms = due > now ? (int)((due - now + 999999) / 1000000) : 0;
+                if (timeout_ms > 50)
+                {
+                    timeout_ms = 50;
+                }
+            }
+        }
+        if ((blocked || gated) && timeout_ms > 10)
+        {
+            timeout_ms = 10;
+        }
+
+        int n = poll(fds, (nfds_t)nfds, timeout_ms);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("poll");
+            break;
+        }
+        now = utils_now_ns();
+        for (int i = 0; n > 0 && i < nfds; i++)
+        {
+            if (!fds[i].revents)
+            {
+                continue;
+            }
+            uint32_t id = fd_session[i];
+            rp_session_t *s = &sessions[id];
+            if (s->state == SESSION_CONNECTING)
+            {
+                session_connected(id, now);
+                continue;
+            }
+            if (s->fd >= 0 && (fds[i].revents & (POLLIN | POLLERR | POLLHUP)))
+            {
+                session_read(id, now);
+            }
+            if (s->fd >= 0 && (fds[i].revents & POLLOUT))
+            {
+                session_flush(id);
+                session_pump(id, now);
+            }
+        }
+    }
+
+    double elapsed_s = (double)(utils_now_ns() - replay_start_ns) / 1e9;
+    for (uint32_t id = 1; id <= session_count; id++)
+    {
+        if (sessions[id].fd >= 0)
+        {
+            sessions[id].close_pending = 1;
+            session_close(id, 0);
+        }
+    }
+    free(fds);
+    free(fd_session);
+    return elapsed_s;
+}
+
+// ============================================
+// Bao cao va so sanh
+// ============================================
+
+typedef struct {
+    char name[32];
+    uint64_t count;
+    uint64_t errors;
+    uint64_t timeouts;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+    double per_s;
+} rp_row_t;
+
+static int build_rows(double elapsed_s, rp_row_t *rows, int max)
+{
+    int n = 0;
+    for (int op = 0; op < OP_COUNT && n < max; op++)
+    {
+        const rp_op_stats_t *s = &stats.ops[op];
+        if (s->hist.count == 0)
+        {
+            continue;
+        }
+        rp_row_t *row = &rows[n++];
+        memset(row, 0, sizeof(*row));
+        snprintf(row->name, sizeof(row->name), "%s", op_names[op]);
+        row->count = s->hist.count;
+        row->errors = s->errors;
+        row->timeouts = s->timeouts;
+        row->p50_us = (double)latency_hist_quantile(&s->hist, 0.5) / 1e3;
+        row->p90_us = (double)latency_hist_quantile(&s->hist, 0.9) / 1e3;
+        row->p99_us = (double)latency_hist_quantile(&s->hist, 0.99) / 1e3;
+        row->max_us = (double)s->hist.max_ns / 1e3;
+        row->per_s = (double)s->hist.count / elapsed_s;
+    }
+    if (stats.lag.count > 0 && n < max)
+    {
+        rp_row_t *row = &rows[n++];
+        memset(row, 0, sizeof(*row));
+        snprintf(row->name, sizeof(row->name), "schedule_lag");
+        row->count = stats.lag.count;
+        row->p50_us = (double)latency_hist_quantile(&stats.lag, 0.5) / 1e3;
+        row->p90_us = (double)latency_hist_quantile(&stats.lag, 0.9) / 1e3;
+        row->p99_us = (double)latency_hist_quantile(&stats.lag, 0.99) / 1e3;
+        row->max_us = (double)stats.lag.max_ns / 1e3;
+    }
+    if (n + 2 <= max)
+    {
+        memset(&rows[n], 0, 2 * sizeof(rp_row_t));
+        snprintf(rows[n].name, sizeof(rows[n].name), "frames_out");
+        rows[n].count = stats.frames_out;
+        rows[n].per_s = (double)stats.frames_out / elapsed_s;
+        n++;
+        snprintf(rows[n].name, sizeof(rows[n].name), "frames_in");
+        rows[n].count = stats.frames_in;
+        rows[n].per_s = (double)stats.frames_in / elapsed_s;
+        n++;
+    }
+    return n;
+}
+
+static void print_text(const rp_row_t *rows, int n, double elapsed_s)
+{
+    double capture_s = (double)capture_duration_us / 1e6;
+    printf("\n=== Ket qua sau %.2fs (capture %.2fs, nhanh x%.2f) ===\n", elapsed_s, capture_s,
+           elapsed_s > 0 ? capture_s / elapsed_s : 0.0);
+    printf("Gui:  %llu frame (%.1f frame/s), %.2f MB\n", (unsigned long long)stats.frames_out,
+           (double)stats.frames_out / elapsed_s, (double)stats.bytes_out / (1024.0 * 1024.0));
+    printf("Nhan: %llu frame (%.1f frame/s), %.2f MB\n", (unsigned long long)stats.frames_in,
+           (double)stats.frames_in / elapsed_s, (double)stats.bytes_in / (1024.0 * 1024.0));
+    printf("Chen REGISTER: %llu, bo PONG: %llu, anh xa phong: %llu (het han cho: %llu)\n",
+           (unsigned long long)stats.register_added, (unsigned long long)stats.pong_dropped,
+           (unsigned long long)stats.room_remapped, (unsigned long long)stats.room_unmapped);
+
+    printf("\n%-16s %9s %7s %7s %10s %10s %10s %10s\n", "Do tre (ms)", "count", "loi", "timeout",
+           "p50", "p90", "p99", "max");
+    for (int i = 0; i < n; i++)
+    {
+        if (strncmp(rows[i].name, "frames_", 7) == 0)
+        {
+            continue;
+        }
+        printf("%-16s %9llu %7llu %7llu %10.3f %10.3f %10.3f %10.3f\n", rows[i].name,
+               (unsigned long long)rows[i].count, (unsigned long long)rows[i].errors,
+               (unsigned long long)rows[i].timeouts, rows[i].p50_us / 1e3,
+               rows[i].p90_us / 1e3, rows[i].p99_us / 1e3, rows[i].max_us / 1e3);
+    }
+    if (stats.connect_failed || stats.disconnected || stats.protocol_errors)
+    {
+        printf("\nLoi: %llu connect, %llu bi server dong, %llu frame khong hop le\n",
+               (unsigned long long)stats.connect_failed, (unsigned long long)stats.disconnected,
+               (unsigned long long)stats.protocol_errors);
+    }
+}
+
+static void print_csv(const rp_row_t *rows, int n)
+{
+    printf("name,count,errors,timeouts,p50_us,p90_us,p99_us,max_us,per_s\n");
+    for (int i = 0; i < n; i++)
+    {
+        printf("%s,%llu,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.2f\n", rows[i].name, (unsigned long long)rows[i].count,
+               (unsigned long long)rows[i].errors, (unsigned long long)rows[i].timeouts, rows[i].p50_us, rows[i].p90_us, rows[i].p99_us,
+               rows[i].max_us, rows[i].per_s);
+    }
+}
+
+static int load_baseline(const char *path, rp_row_t *rows, int max)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return -1;
+    }
+    char line[256];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), f))
+    {
+        rp_row_t *row = &rows[n];
+        unsigned long long count, errors, timeouts;
+        if (sscanf(line, "%31[^,],%llu,%llu,%llu,%lf,%lf,%lf,%lf,%lf", row->name, &count, &errors, &timeouts,
+                   &row->p50_us, &row->p90_us, &row->p99_us, &row->max_us, &row->per_s) == 9)
+        {
+            row->count = count;
+            row->errors = errors;
+            row->timeouts = timeouts;
+            n++;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static double delta_pct(double before, double after)
+{
+    return before > 0 ? (after - before) * 100.0 / before : 0.0;
+}
+
+// So sanh voi lan chay truoc: p99 tang hoac frames_in/s giam qua nguong = cham di
+// (chi xet dong co du mau, p99 cua vai mau chi la nhieu)
+static int compare_baseline(const rp_row_t *rows, int n)
+{
+    rp_row_t base[RP_MAX_BASELINE];
+    int base_n = load_baseline(config.baseline_path, base, RP_MAX_BASELINE);
+    if (base_n < 0)
+    {
+        return -1;
+    }
+    FILE *out = config.format == FORMAT_CSV ? stderr : stdout;
+    fprintf(out, "\nSo voi %s (nguong %.0f%%):\n", config.baseline_path, config.threshold_pct);
+    fprintf(out, "%-16s %12s %12s %9s %12s %12s %9s %8s\n", "", "p50 cu", "p50 moi", "delta", "p99 cu",
+            "p99 moi", "delta", "");
+    int regressions = 0;
+    for (int i = 0; i < n; i++)
+    {
+        const rp_row_t *b = NULL;
+        for (int k = 0; k < base_n; k++)
+        {
+            if (strcmp(base[k].name, rows[i].name) == 0)
+            {
+                b = &base[k];
+                break;
+            }
+        }
+        if (!b)
+        {
+            continue;
+        }
+        const char *verdict = "";
+        if (strncmp(rows[i].name, "frames_", 7) == 0)
+        {
+            double d = delta_pct(b->per_s, rows[i].per_s);
+            if (strcmp(rows[i].name, "frames_in") == 0 && d < -config.threshold_pct)
+            {
+                verdict = "CHAM HON";
+                regressions++;
+            }
+            fprintf(out, "%-16s %10.1f/s %10.1f/s %+8.1f%% %12s %12s %9s %8s\n", rows[i].name, b->per_s,
+                    rows[i].per_s, d, "", "", "", verdict);
+            continue;
+        }
+        double d50 = delta_pct(b->p50_us, rows[i].p50_us);
+        double d99 = delta_pct(b->p99_us, rows[i].p99_us);
+        if (strcmp(rows[i].name, "schedule_lag") != 0 && rows[i].count >= 20 && b->count >= 20 &&
+            d99 > config.threshold_pct)
+        {
+            verdict = "CHAM HON";
+            regressions++;
+        }
+        fprintf(out, "%-16s %10.3fms %10.3fms %+8.1f%% %10.3fms %10.3fms %+8.1f%% %8s\n", rows[i].name,
+                b->p50_us / 1e3, rows[i].p50_us / 1e3, d50, b->p99_us / 1e3, rows[i].p99_us / 1e3, d99, verdict);
+    }
+    return regressions;
+}
+
+// ============================================
+// Cong cu offline
+// ============================================
+
+static void print_info(void)
+{
+    uint64_t frames = 0, bytes = 0, opens = 0, notes = 0;
+    uint64_t by_type[256] = {0};
+    for (size_t i = 0; i < record_count; i++)
+    {
+        opens += records[i].kind == CAPTURE_OPEN;
+        notes += records[i].kind == CAPTURE_ROOM;
+        if (records[i].kind == CAPTURE_FRAME)
+        {
+            frames++;
+            bytes += records[i].len;
+            by_type[records[i].type]++;
+        }
+    }
+    printf("Capture %s: %s\n", config.capture_path,
+           capture_flags & CAPTURE_FLAG_ANONYMIZED ? "da an danh" : "chua an danh (chi xoa mat khau)");
+    printf("Thoi luong: %.2fs, %llu phien, %llu frame (%.2f MB payload), %llu phong duoc tao\n",
+           (double)capture_duration_us / 1e6, (unsigned long long)opens, (unsigned long long)frames,
+           (double)bytes / (1024.0 * 1024.0), (unsigned long long)notes);
+    printf("\nFrame theo loai:\n");
+    for (int type = 0; type < 256; type++)
+    {
+        if (by_type[type])
+        {
+            printf("  0x%02X %10llu\n", type, (unsigned long long)by_type[type]);
+        }
+    }
+}
+
+static int anonymize_capture(const char *out_path)
+{
+    capture_anonymizer_t anonymizer;
+    capture_anonymizer_init(&anonymizer);
+    capture_writer_t writer;
+    if (capture_writer_open(&writer, out_path, capture_flags | CAPTURE_FLAG_ANONYMIZED) != 0)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < record_count; i++)
+    {
+        rp_record_t *r = &records[i];
+        if (r->kind == CAPTURE_FRAME)
+        {
+            capture_scrub(&anonymizer, r->type, r->payload, r->len);
+        }
+        capture_record_t rec = {
+            .kind = r->kind,
+            .session = r->session,
+            .t_us = r->t_us,
+            .type = r->type,
+            .len = r->len,
+            .payload = r->payload,
+            .room_id = r->room_id,
+        };
+        capture_writer_write(&writer, &rec);
+    }
+    int result = capture_writer_close(&writer);
+    if (result == 0)
+    {
+        printf("Da ghi %s (%zu ban ghi, an danh)\n", out_path, record_count);
+    }
+    return result;
+}
+
+// ============================================
+// main
+// ============================================
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Cach dung: %s CAPTURE [--host=IP] [--port=N] [--speed=1|N|max] [--max-conns=N] [--drain=MS]\n"
+            "           [--format=text|csv] [--baseline=FILE.csv] [--threshold=PCT]\n"
+            "       %s CAPTURE --info | --anonymize=OUT\n",
+            prog, prog);
+}
+
+static int parse_int_option(const char *arg, const char *name, int min, int max, int *out)
+{
+    size_t name_len = strlen(name);
+    if (strncmp(arg, name, name_len) != 0)
+    {
+        return 0;
+    }
+    char *end = NULL;
+    long value = strtol(arg + name_len, &end, 10);
+    if (end == arg + name_len || *end != '\0' || value < min || value > max)
+    {
+        fprintf(stderr, "Gia tri khong hop le: %s (%d..%d)\n", arg, min, max);
+        exit(2);
+    }
+    *out = (int)value;
+    return 1;
+}
+
+static void parse_args(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--host=", 7) == 0)
+        {
+            config.host = arg + 7;
+        }
+        else if (strncmp(arg, "--speed=", 8) == 0)
+        {
+            if (strcmp(arg + 8, "max") == 0)
+            {
+                config.speed = 0;
+            }
+            else
+            {
+                char *end = NULL;
+                config.speed = strtod(arg + 8, &end);
+                if (end == arg + 8 || *end != '\0' || !(config.speed > 0) || !isfinite(config.speed))
+                {
+                    fprintf(stderr, "Toc do khong hop le: %s (so > 0 hoac max)\n", arg + 8);
+                    exit(2);
+                }
+            }
+        }
+        else if (strcmp(arg, "--format=text") == 0)
+        {
+            config.format = FORMAT_TEXT;
+        }
+        else if (strcmp(arg, "--format=csv") == 0)
+        {
+            config.format = FORMAT_CSV;
+        }
+        else if (strncmp(arg, "--baseline=", 11) == 0)
+        {
+            config.baseline_path = arg + 11;
+        }
+        else if (strncmp(arg, "--threshold=", 12) == 0)
+        {
+            config.threshold_pct = atof(arg + 12);
+        }
+        else if (strncmp(arg, "--anonymize=", 12) == 0)
+        {
+            config.anonymize_out = arg + 12;
+        }
+        else if (strcmp(arg, "--info") == 0)
+        {
+            config.info = 1;
+        }
+        else if (parse_int_option(arg, "--port=", 1, 65535, &config.port) ||
+                 parse_int_option(arg, "--max-conns=", 1, 100000, &config.max_conns) ||
+                 parse_int_option(arg, "--drain=", 0, 600000, &config.drain_ms))
+        {
+            continue;
+        }
+        else if (arg[0] != '-' && !config.capture_path)
+        {
+            config.capture_path = arg;
+        }
+        else
+        {
+            fprintf(stderr, "Tuy chon khong hop le: %s\n", arg);
+            usage(argv[0]);
+            exit(2);
+        }
+    }
+    if (!config.capture_path)
+    {
+        usage(argv[0]);
+        exit(2);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parse_args(argc, argv);
+    if (load_capture(config.capture_path) != 0)
+    {
+        return 2;
+    }
+    if (config.info)
+    {
+        print_info();
+        return 0;
+    }
+    if (config.anonymize_out)
+    {
+        return anonymize_capture(config.anonymize_out) == 0 ? 0 : 2;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)config.port);
+    if (inet_pton(AF_INET, config.host, &addr.sin_addr) != 1)
+    {
+        fprintf(stderr, "Dia chi khong hop le: %s\n", config.host);
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    sessions = calloc(session_count + 1, sizeof(rp_session_t));
+    if (!sessions)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        return 2;
+    }
+    for (uint32_t id = 0; id <= session_count; id++)
+    {
+        sessions[id].fd = -1;
+    }
+    room_prepare();
+
+    FILE *log = config.format == FORMAT_CSV ? stderr : stdout;
+    char speed_text[32];
+    if (config.speed > 0)
+    {
+        snprintf(speed_text, sizeof(speed_text), "x%g", config.speed);
+    }
+    else
+    {
+        snprintf(speed_text, sizeof(speed_text), "max");
+    }
+    fprintf(log, "=== Replay %s -> %s:%d, %u phien, %zu ban ghi, %.2fs capture, toc do %s ===\n",
+            config.capture_path, config.host, config.port, session_count, record_count,
+            (double)capture_duration_us / 1e6, speed_text);
+
+    double elapsed_s = run_replay(&addr);
+    if (elapsed_s <= 0)
+    {
+        elapsed_s = 1e-9;
+    }
+
+    rp_row_t rows[RP_MAX_BASELINE];
+    int n = build_rows(elapsed_s, rows, RP_MAX_BASELINE);
+    if (config.format == FORMAT_CSV)
+    {
+        print_csv(rows, n);
+    }
+    else
+    {
+        print_text(rows, n, elapsed_s);
+    }
+
+    int result = stats.connect_failed || stats.protocol_errors ? 1 : 0;
+    if (config.baseline_path)
+    {
+        int regressions = compare_baseline(rows, n);
+        if (regressions != 0)
+        {
+            result = 1;
+        }
+    }
+
+    for (uint32_t id = 0; id <= session_count; id++)
+    {
+        free(sessions[id].queue);
+        free(sessions[id].rx);
+        free(sessions[id].tx);
+    }
+    for (size_t i = 0; i < record_count; i++)
+    {
+        free(records[i].payload);
+    }
+    free(sessions);
+    free(records);
+    free(rooms);
+    free(registered);
+    return result;
+}
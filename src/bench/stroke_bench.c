@@ -0,0 +1,289 @@
+/**
+ * Benchmark don gian hoa net ve (RDP)
+ *
+ * Cach dung:
+ *   make stroke-bench
+ *   ./stroke_bench server.log          # doc net ve that tu log server
+ *   ./main | tee server.log            # (log server in moi DRAW_DATA nhan duoc)
+ *   ./stroke_bench                     # khong co file: dung net ve tong hop
+ *
+ * Moi dong "Nhan DRAW_DATA tu client N ..." trong log duoc gom theo client
+ * thanh cac net (giong stroke_log_append tren server), sau do do ty le giam
+ * so diem va chi phi RDP moi net voi nhieu muc tolerance.
+ */
+#include "../include/stroke.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_MAX_CLIENTS 100
+#define BENCH_ITERATIONS 20
+
+// Tat ca cac net tho (chua don gian hoa) thu duoc
+typedef struct {
+    stroke_point_t *points;
+    int *offsets;       // offsets[i] = vi tri bat dau net i trong points
+    int stroke_count;
+    int point_count;
+    int stroke_capacity;
+    int point_capacity;
+} stroke_set_t;
+
+static void set_add_stroke(stroke_set_t *set, const stroke_t *stroke)
+{
+    if (stroke->point_count < 2)
+    {
+        return;
+    }
+
+    if (set->stroke_count + 2 > set->stroke_capacity)
+    {
+        set->stroke_capacity = set->stroke_capacity ? set->stroke_capacity * 2 : 1024;
+        set->offsets = realloc(set->offsets, (size_t)set->stroke_capacity * sizeof(int));
+    }
+    while (set->point_count + stroke->point_count > set->point_capacity)
+    {
+        set->point_capacity = set->point_capacity ? set->point_capacity * 2 : 65536;
+        set->points = realloc(set->points, (size_t)set->point_capacity * sizeof(stroke_point_t));
+    }
+    if (!set->offsets || !set->points)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        exit(1);
+    }
+
+    set->offsets[set->stroke_count++] = set->point_count;
+    memcpy(set->points + set->point_count, stroke->points, (size_t)stroke->point_count * sizeof(stroke_point_t));
+    set->point_count += stroke->point_count;
+    set->offsets[set->stroke_count] = set->point_count;
+}
+
+static void set_add_log(stroke_set_t *set, stroke_log_t *log)
+{
+    for (int i = 0; i < log->stroke_count; i++)
+    {
+        set_add_stroke(set, &log->strokes[i]);
+    }
+    stroke_log_reset(log);
+}
+
+/**
+ * Doc net ve tu log server
+ * @return So dong DRAW_DATA da doc, -1 neu khong mo duoc file
+ */
+static int load_server_log(const char *path, stroke_set_t *set)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return -1;
+    }
+
+    // Tolerance 0: log chi gom doan thanh net, khong don gian hoa
+    stroke_log_t *logs[BENCH_MAX_CLIENTS] = {0};
+    char line[512];
+    int actions = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        const char *p = strstr(line, "Nhan DRAW_DATA tu client ");
+        if (!p)
+        {
+            continue;
+        }
+
+        int client, user_id, action, x1, y1, x2, y2, width;
+        unsigned int color;
+        if (sscanf(p, "Nhan DRAW_DATA tu client %d (user_id=%d): action=%d, x1=%d, y1=%d, x2=%d, y2=%d, color=0x%X, width=%d",
+                   &client, &user_id, &action, &x1, &y1, &x2, &y2, &color, &width) != 9)
+        {
+            continue;
+        }
+        if (client < 0 || client >= BENCH_MAX_CLIENTS)
+        {
+            continue;
+        }
+
+        if (!logs[client])
+        {
+            logs[client] = stroke_log_create(0.0);
+        }
+
+        draw_action_t a;
+        a.action = (draw_action_type_t)action;
+        a.x1 = (uint16_t)x1;
+        a.y1 = (uint16_t)y1;
+        a.x2 = (uint16_t)x2;
+        a.y2 = (uint16_t)y2;
+        a.color = color;
+        a.width = (uint8_t)width;
+
+        // CLEAR xoa log tren server; o day giu lai cac net da ve truoc do
+        if (a.action == DRAW_ACTION_CLEAR)
+        {
+            stroke_log_finish(logs[client]);
+            set_add_log(set, logs[client]);
+            continue;
+        }
+
+        if (stroke_log_append(logs[client], &a) != 0 && logs[client]->overflow)
+        {
+            set_add_log(set, logs[client]);
+            stroke_log_append(logs[client], &a);
+        }
+        actions++;
+    }
+    fclose(f);
+
+    for (int i = 0; i < BENCH_MAX_CLIENTS; i++)
+    {
+        if (logs[i])
+        {
+            stroke_log_finish(logs[i]);
+            set_add_log(set, logs[i]);
+            stroke_log_destroy(logs[i]);
+        }
+    }
+    return actions;
+}
+
+/**
+ * Sinh net ve tong hop: duong cong muot lay mau nhu mousemove
+ * (buoc 2-6 px, toa do da lam tron ve luoi canvas chuan)
+ */
+static void generate_synthetic(stroke_set_t *set, int strokes)
+{
+    srand(12345);
+    stroke_t stroke;
+    memset(&stroke, 0, sizeof(stroke));
+    stroke.capacity = 4096;
+    stroke.points = malloc((size_t)stroke.capacity * sizeof(stroke_point_t));
+
+    for (int s = 0; s < strokes; s++)
+    {
+        double x = 100 + rand() % (MAX_CANVAS_WIDTH - 200);
+        double y = 100 + rand() % (MAX_CANVAS_HEIGHT - 200);
+        double heading = (rand() % 628) / 100.0;
+        double turn = ((rand() % 200) - 100) / 2000.0;
+        int n = 30 + rand() % 300;
+
+        stroke.point_count = 0;
+        for (int i = 0; i < n && stroke.point_count < stroke.capacity; i++)
+        {
+            double step = 2.0 + (rand() % 400) / 100.0;
+            heading += turn + ((rand() % 200) - 100) / 4000.0;
+            x += cos(heading) * step;
+            y += sin(heading) * step;
+            if (x < 0 || y < 0 || x >= MAX_CANVAS_WIDTH || y >= MAX_CANVAS_HEIGHT)
+            {
+                break;
+            }
+
+            uint16_t px = (uint16_t)lround(x);
+            uint16_t py = (uint16_t)lround(y);
+            if (stroke.point_count > 0 &&
+                stroke.points[stroke.point_count - 1].x == px &&
+                stroke.points[stroke.point_count - 1].y == py)
+            {
+                continue;
+            }
+            stroke.points[stroke.point_count].x = px;
+            stroke.points[stroke.point_count].y = py;
+            stroke.point_count++;
+        }
+        set_add_stroke(set, &stroke);
+    }
+    free(stroke.points);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    stroke_set_t set;
+    memset(&set, 0, sizeof(set));
+    const char *source = "synthetic";
+
+    if (argc > 1)
+    {
+        int actions = load_server_log(argv[1], &set);
+        if (actions < 0)
+        {
+            return 1;
+        }
+        printf("Doc %d DRAW_DATA tu %s\n", actions, argv[1]);
+        source = argv[1];
+    }
+    else
+    {
+        generate_synthetic(&set, 2000);
+        printf("Khong co file log, dung %d net tong hop (lay mau kieu mousemove)\n", set.stroke_count);
+    }
+
+    if (set.stroke_count == 0)
+    {
+        fprintf(stderr, "Khong co net ve nao de benchmark\n");
+        return 1;
+    }
+
+    const double tolerances[] = {0.5, 1.0, 1.5, 2.0, 3.0, 5.0};
+    const int tolerance_count = (int)(sizeof(tolerances) / sizeof(tolerances[0]));
+
+    stroke_point_t *work = malloc((size_t)set.point_count * sizeof(stroke_point_t));
+    if (!work)
+    {
+        fprintf(stderr, "Het bo nho\n");
+        return 1;
+    }
+
+    // Moi doan DRAW_BROADCAST = 3 byte header + 14 byte payload
+    size_t raw_segments = (size_t)(set.point_count - set.stroke_count);
+
+    printf("\nNguon: %s | %d net, %d diem, %zu doan (%zu bytes khi phat lai)\n\n",
+           source, set.stroke_count, set.point_count, raw_segments, raw_segments * 17);
+    printf("%-10s %12s %10s %12s %14s %12s\n",
+           "tolerance", "diem giu", "giam %", "bytes replay", "ns/net", "ns/diem");
+
+    for (int t = 0; t < tolerance_count; t++)
+    {
+        size_t kept = 0;
+        double elapsed = 0.0;
+
+        for (int iter = 0; iter < BENCH_ITERATIONS; iter++)
+        {
+            memcpy(work, set.points, (size_t)set.point_count * sizeof(stroke_point_t));
+
+            size_t kept_iter = 0;
+            double start = now_ns();
+            for (int s = 0; s < set.stroke_count; s++)
+            {
+                int begin = set.offsets[s];
+                int count = set.offsets[s + 1] - begin;
+                kept_iter += (size_t)stroke_simplify_rdp(work + begin, count, tolerances[t]);
+            }
+            elapsed += now_ns() - start;
+            kept = kept_iter;
+        }
+
+        double per_stroke = elapsed / BENCH_ITERATIONS / set.stroke_count;
+        double per_point = elapsed / BENCH_ITERATIONS / set.point_count;
+        size_t kept_segments = kept - (size_t)set.stroke_count;
+        printf("%-10.1f %12zu %9.1f%% %12zu %14.1f %12.2f\n",
+               tolerances[t], kept,
+               100.0 * (1.0 - (double)kept / (double)set.point_count),
+               kept_segments * 17, per_stroke, per_point);
+    }
+
+    free(work);
+    free(set.points);
+    free(set.offsets);
+    return 0;
+}
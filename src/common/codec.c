@@ -0,0 +1,71 @@
+#include "codec.h"
+
+// Cac struct packed trong common/protocol.h phai khop voi schema (loi bien dich neu lech)
+_Static_assert(sizeof(hello_t) == CODEC_HELLO_MAX_SIZE, "hello_t lech schema");
+_Static_assert(sizeof(login_request_t) == CODEC_LOGIN_REQUEST_MAX_SIZE, "login_request_t lech schema");
+_Static_assert(sizeof(login_response_t) == CODEC_LOGIN_RESPONSE_MAX_SIZE, "login_response_t lech schema");
+_Static_assert(sizeof(register_request_t) == CODEC_REGISTER_REQUEST_MAX_SIZE, "register_request_t lech schema");
+_Static_assert(sizeof(register_response_t) == CODEC_STATUS_RESPONSE_MAX_SIZE, "register_response_t lech schema");
+_Static_assert(sizeof(change_password_request_t) == CODEC_CHANGE_PASSWORD_REQUEST_MAX_SIZE, "change_password_request_t lech schema");
+_Static_assert(sizeof(create_room_request_t) == CODEC_CREATE_ROOM_REQUEST_MAX_SIZE, "create_room_request_t lech schema");
+_Static_assert(sizeof(create_room_response_t) == CODEC_ROOM_RESPONSE_MAX_SIZE, "create_room_response_t lech schema");
+_Static_assert(sizeof(leave_room_response_t) == CODEC_STATUS_RESPONSE_MAX_SIZE, "leave_room_response_t lech schema");
+_Static_assert(sizeof(room_info_protocol_t) == CODEC_ROOM_INFO_MAX_SIZE, "room_info_protocol_t lech schema");
+_Static_assert(sizeof(room_players_update_t) == CODEC_ROOM_PLAYERS_HEADER_MAX_SIZE, "room_players_update_t lech schema");
+_Static_assert(sizeof(player_info_protocol_t) == CODEC_PLAYER_INFO_MAX_SIZE, "player_info_protocol_t lech schema");
+
+// Cap v1/v2 co cung truong (FSTR va STR cung la char[size]) nen server copy struct v1 sang v2
+_Static_assert(sizeof(msg_room_players_header_t) == sizeof(msg_room_players_header_v2_t), "room_players_header v1/v2 lech");
+_Static_assert(sizeof(msg_player_info_t) == sizeof(msg_player_info_v2_t), "player_info v1/v2 lech");
+_Static_assert(sizeof(msg_game_start_t) == sizeof(msg_game_start_v2_t), "game_start v1/v2 lech");
+_Static_assert(sizeof(msg_correct_guess_t) == sizeof(msg_correct_guess_v2_t), "correct_guess v1/v2 lech");
+_Static_assert(sizeof(msg_round_end_header_t) == sizeof(msg_round_end_header_v2_t), "round_end_header v1/v2 lech");
+_Static_assert(sizeof(msg_chat_broadcast_t) == sizeof(msg_chat_broadcast_v2_t), "chat_broadcast v1/v2 lech");
+
+// Moi truong -> mot lenh ghi/doc, encoder/decoder la chuoi lenh thang khong re nhanh theo offset
+#define CODEC_WRITE_U8(name, size)   wire_put_u8(w, m->name);
+#define CODEC_WRITE_U16(name, size)  wire_put_u16(w, m->name);
+#define CODEC_WRITE_U32(name, size)  wire_put_u32(w, m->name);
+#define CODEC_WRITE_I32(name, size)  wire_put_i32(w, m->name);
+#define CODEC_WRITE_U64(name, size)  wire_put_u64(w, m->name);
+#define CODEC_WRITE_FSTR(name, size) wire_put_fixed_string(w, m->name, size);
+#define CODEC_WRITE_STR(name, size)  wire_put_string(w, m->name, (size) - 1);
+#define CODEC_WRITE(kind, name, size) CODEC_WRITE_##kind(name, size)
+
+#define CODEC_READ_U8(name, size)   m->name = wire_get_u8(r);
+#define CODEC_READ_U16(name, size)  m->name = wire_get_u16(r);
+#define CODEC_READ_U32(name, size)  m->name = wire_get_u32(r);
+#define CODEC_READ_I32(name, size)  m->name = wire_get_i32(r);
+#define CODEC_READ_U64(name, size)  m->name = wire_get_u64(r);
+#define CODEC_READ_FSTR(name, size) wire_get_fixed_string(r, m->name, size);
+#define CODEC_READ_STR(name, size)  wire_get_string(r, m->name, size);
+#define CODEC_READ(kind, name, size) CODEC_READ_##kind(name, size)
+
+#define CODEC_DEFINE(name, NAME) \
+    void msg_##name##_write(const msg_##name##_t *m, wire_writer_t *w) \
+    { \
+        SCHEMA_##NAME(CODEC_WRITE) \
+    } \
+    \
+    void msg_##name##_read(wire_reader_t *r, msg_##name##_t *m) \
+    { \
+        SCHEMA_##NAME(CODEC_READ) \
+    } \
+    \
+    size_t msg_##name##_encode(const msg_##name##_t *m, uint8_t *buf, size_t capacity) \
+    { \
+        wire_writer_t w; \
+        wire_writer_init(&w, buf, capacity); \
+        msg_##name##_write(m, &w); \
+        return w.overflow ? 0 : w.len; \
+    } \
+    \
+    int msg_##name##_decode(const uint8_t *buf, size_t len, msg_##name##_t *m) \
+    { \
+        wire_reader_t r; \
+        wire_reader_init(&r, buf, len); \
+        msg_##name##_read(&r, m); \
+        return r.overflow ? -1 : (int)r.pos; \
+    }
+
+PROTOCOL_SCHEMAS(CODEC_DEFINE)
@@ -0,0 +1,48 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "schema.h"
+#include "wire.h"
+
+// ============================================
+// CODEC SINH TỪ common/schema.h
+// ============================================
+// Với mỗi S(name, NAME) trong PROTOCOL_SCHEMAS:
+//   msg_<name>_t                  struct giữ giá trị đã decode (số nguyên theo host order, chuỗi null-terminated)
+//   CODEC_<NAME>_MAX_SIZE         số byte tối đa trên wire (= kích thước chính xác nếu không có STR)
+//   msg_<name>_write(m, w)        ghi vào wire_writer_t (dùng cho danh sách header + phần tử)
+//   msg_<name>_read(r, m)         đọc từ wire_reader_t
+//   msg_<name>_encode(m, buf, n)  trả về số byte đã ghi, 0 nếu buffer không đủ
+//   msg_<name>_decode(buf, n, m)  trả về số byte đã đọc, -1 nếu payload thiếu dữ liệu
+
+#define CODEC_CTYPE_U8(name, size)   uint8_t name;
+#define CODEC_CTYPE_U16(name, size)  uint16_t name;
+#define CODEC_CTYPE_U32(name, size)  uint32_t name;
+#define CODEC_CTYPE_I32(name, size)  int32_t name;
+#define CODEC_CTYPE_U64(name, size)  uint64_t name;
+#define CODEC_CTYPE_FSTR(name, size) char name[size];
+#define CODEC_CTYPE_STR(name, size)  char name[size];
+#define CODEC_CTYPE(kind, name, size) CODEC_CTYPE_##kind(name, size)
+
+#define CODEC_WIRE_SIZE_U8(size)   1
+#define CODEC_WIRE_SIZE_U16(size)  2
+#define CODEC_WIRE_SIZE_U32(size)  4
+#define CODEC_WIRE_SIZE_I32(size)  4
+#define CODEC_WIRE_SIZE_U64(size)  8
+#define CODEC_WIRE_SIZE_FSTR(size) (size)
+#define CODEC_WIRE_SIZE_STR(size)  (size)   // 1 byte độ dài + tối đa size - 1 bytes
+#define CODEC_WIRE_SIZE(kind, name, size) + CODEC_WIRE_SIZE_##kind(size)
+
+#define CODEC_DECLARE(name, NAME) \
+    typedef struct { SCHEMA_##NAME(CODEC_CTYPE) } msg_##name##_t; \
+    enum { CODEC_##NAME##_MAX_SIZE = 0 SCHEMA_##NAME(CODEC_WIRE_SIZE) }; \
+    void msg_##name##_write(const msg_##name##_t *m, wire_writer_t *w); \
+    void msg_##name##_read(wire_reader_t *r, msg_##name##_t *m); \
+    size_t msg_##name##_encode(const msg_##name##_t *m, uint8_t *buf, size_t capacity); \
+    int msg_##name##_decode(const uint8_t *buf, size_t len, msg_##name##_t *m);
+
+PROTOCOL_SCHEMAS(CODEC_DECLARE)
+
+#endif // CODEC_H
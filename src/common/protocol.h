@@ -8,6 +8,13 @@
 // ============================================
 // [TYPE:1 byte][LENGTH:2 bytes][PAYLOAD:variable]
 // LENGTH được lưu dưới dạng network byte order (big-endian)
+//
+// Frame mở rộng cho payload lớn (>= 0xFFFF bytes):
+// [TYPE:1 byte][0xFFFF:2 bytes][LENGTH:4 bytes][PAYLOAD:variable]
+#define MSG_HEADER_SIZE             3
+#define MSG_EXTENDED_HEADER_SIZE    7
+#define MSG_EXTENDED_LENGTH_MARKER  0xFFFF
+#define MSG_MAX_PAYLOAD_SIZE        (16u * 1024u * 1024u)  // Giới hạn an toàn cho một message
 
 // ============================================
 // MESSAGE TYPES
@@ -31,6 +38,10 @@
 #define MSG_ROOM_UPDATE          0x15
 #define MSG_START_GAME           0x16
 #define MSG_ROOM_PLAYERS_UPDATE  0x17  // Broadcast danh sách người chơi khi có thay đổi
+#define MSG_ROOM_LIST_DELTA      0x18  // Thay đổi danh sách phòng (upsert/remove) kèm số thứ tự
+#define MSG_LOBBY_SUBSCRIBE      0x19  // Client đang xem sảnh, nhận cập nhật danh sách phòng (không payload)
+#define MSG_LOBBY_UNSUBSCRIBE    0x1A  // Client rời sảnh, ngừng nhận danh sách phòng (không payload)
+#define MSG_ROOM_PLAYER_DELTA    0x1B  // Chỉ người chơi vừa join/leave (bản ghi gọn), thay cho danh sách đầy đủ
 
 // Game Play (0x20 - 0x2F)
 #define MSG_GAME_START           0x20
@@ -44,6 +55,7 @@
 #define MSG_GAME_END             0x28
 #define MSG_HINT                 0x29
 #define MSG_TIMER_UPDATE         0x2A  // Server gửi thời gian còn lại định kỳ
+#define MSG_CANVAS_SNAPSHOT      0x2B  // Server gửi snapshot canvas (đã nén zstd) cho người vào giữa round
 
 // Chat (0x30 - 0x3F)
 #define MSG_CHAT_MESSAGE         0x30
@@ -56,6 +68,29 @@
 // System/Server (0x50 - 0x5F)
 #define MSG_SERVER_SHUTDOWN      0x50  // Server thông báo shutdown đến tất cả clients
 #define MSG_ACCOUNT_LOGGED_IN_ELSEWHERE 0x51  // Server thông báo tài khoản đang được đăng nhập ở nơi khác
+#define MSG_HELLO                0x52  // Client gửi phiên bản + capability ngay sau khi kết nối
+#define MSG_HELLO_ACK            0x53  // Server trả về capability đã thỏa thuận
+#define MSG_COMPRESSED           0x54  // Server gửi message khác đã nén deflate (chỉ client có CAP_COMPRESSION)
+#define MSG_ROUND_DEADLINE       0x55  // Server gửi hạn chót round (sau GAME_START và resync định kỳ, CAP_ROUND_DEADLINE)
+#define MSG_PING                 0x56  // Hai chiều: [seq:4][origin_ms:8], bên nhận trả PONG ngay
+#define MSG_PONG                 0x57  // Trả lời PING: [seq:4][origin_ms:8][recv_ms:8][send_ms:8]
+#define MSG_ERROR                0x58  // Request bị từ chối (vd rate limit) mà response riêng không có status: [request_type:1][message]
+
+// ============================================
+// PROTOCOL VERSION / CAPABILITIES
+// ============================================
+// Client không gửi HELLO được coi là phiên bản 1 (không có capability nào)
+#define PROTOCOL_VERSION_LEGACY  1
+#define PROTOCOL_VERSION         2
+
+#define CAP_EXTENDED_FRAMES      (1u << 0)  // Nhận được frame mở rộng (payload >= 0xFFFF bytes)
+#define CAP_ROOM_LIST_DELTA      (1u << 1)  // Hiểu ROOM_LIST_DELTA (0x18)
+#define CAP_PLAYER_DELTA         (1u << 2)  // Hiểu ROOM_PLAYER_DELTA (0x1B)
+#define CAP_COMPACT_STRINGS      (1u << 3)  // Nhận chuỗi dạng [len:1][UTF-8] thay cho char[N] (xem COMPACT PAYLOADS)
+#define CAP_COMPRESSION          (1u << 4)  // Nhận MSG_COMPRESSED cho danh sách/bảng điểm lớn (xem COMPRESSED FRAMES)
+#define CAP_ROUND_DEADLINE       (1u << 5)  // Tự đếm ngược từ ROUND_DEADLINE, không nhận TIMER_UPDATE mỗi giây
+#define CAP_PING                 (1u << 6)  // Trả PONG cho PING server gửi định kỳ (đo RTT/lệch đồng hồ)
+#define CAP_CANVAS_SNAPSHOT      (1u << 7)  // Vẽ được CANVAS_SNAPSHOT (zstd) khi vào giữa round, thay cho phát lại nét vẽ
 
 // ============================================
 // CONSTANTS
@@ -84,7 +119,7 @@
 // Cấu trúc message tổng quát
 typedef struct {
     uint8_t type;
-    uint16_t length;
+    uint32_t length;        // Độ dài payload (có thể > 0xFFFF với frame mở rộng)
     uint8_t* payload;
 } message_t;
 
@@ -201,8 +236,22 @@ typedef struct {
 typedef struct {
     uint16_t room_count;          // Số lượng phòng
     // Sau đó là mảng room_info_protocol_t[room_count]
+    // và seq (uint32_t) của danh sách ở cuối payload
 } room_list_response_t;
 
+// ROOM_LIST_DELTA: [seq:4][count:2] + count bản ghi
+// Bản ghi UPSERT: [op:1][room_info_protocol_t], REMOVE: [op:1][room_id:4]
+// Client chỉ áp dụng delta có seq = seq đang có + 1, ngược lại gửi lại ROOM_LIST_REQUEST
+#define ROOM_DELTA_UPSERT        0x01
+#define ROOM_DELTA_REMOVE        0x02
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t seq;                 // Số thứ tự của danh sách sau khi áp dụng delta
+    uint16_t count;               // Số bản ghi
+} room_list_delta_header_t;
+#pragma pack(pop)
+
 // ROOM_UPDATE payload structure (giống room_info_protocol_t)
 // Sử dụng room_info_protocol_t trực tiếp
 
@@ -234,5 +283,88 @@ typedef struct {
 } room_players_update_t;
 #pragma pack()
 
+// ROOM_PLAYER_DELTA payload: room_player_delta_t + [ulen:1][username] + [alen:1][avatar]
+// Người vừa join nhận ROOM_PLAYERS_UPDATE đầy đủ, những người còn lại chỉ nhận delta này.
+// LEAVE với is_active = 255: người chơi vẫn ở bảng điểm (đang chơi), ngược lại xóa khỏi danh sách
+#pragma pack(1)
+typedef struct {
+    int32_t room_id;
+    uint8_t action;              // 0 = JOIN, 1 = LEAVE
+    uint8_t state;               // room_state_protocol_t
+    int32_t owner_id;            // Owner hiện tại (có thể đã đổi khi owner rời phòng)
+    uint16_t player_count;       // Số người trong phòng sau thay đổi
+    int32_t user_id;
+    uint8_t is_active;           // Như player_info_protocol_t
+} room_player_delta_t;
+#pragma pack()
+
+// HELLO / HELLO_ACK payload
+// HELLO: phiên bản và capability client hỗ trợ; HELLO_ACK: phiên bản và capability cả hai cùng hỗ trợ
+#pragma pack(1)
+typedef struct {
+    uint16_t version;
+    uint32_t caps;               // Tổ hợp CAP_*
+} hello_t;
+#pragma pack()
+
+// ============================================
+// COMPACT PAYLOADS (CAP_COMPACT_STRINGS, protocol v2)
+// ============================================
+// str = [len:1][UTF-8 bytes] (common/wire.h), số nguyên big-endian, thứ tự trường giữ như bản cố định.
+// Client không có capability này vẫn nhận các struct char[N] ở trên.
+// Nguồn chuẩn là các schema *_V2 trong common/schema.h (server encode qua common/codec.h).
+//
+// CREATE_ROOM / JOIN_ROOM response: [status:1][room_id:4][message:str]
+// LEAVE_ROOM response:              [status:1][message:str]
+// ROOM_PLAYERS_UPDATE: [room_id:4][room_name:str][max_players:1][state:1][owner_id:4][action:1]
+//                      [changed_user_id:4][changed_username:str][player_count:2]
+//                      + player_count x [user_id:4][username:str][avatar:str][is_owner:1][is_active:1]
+// CHAT_BROADCAST:      [username:str][message:str][timestamp_ms:8]
+// GAME_START:          [drawer_id:4][word_length:1][time_limit:2][round_start_ms:8][current_round:4]
+//                      [player_count:1][total_rounds:1][word:str][category:str]
+// CORRECT_GUESS:       [player_id:4][word:str][guesser_points:2][drawer_points:2][username:str]
+// ROUND_END:           [word:str][score_count:2] + score_count x [user_id:4][score:4]
+
+// ============================================
+// COMPRESSED FRAMES (CAP_COMPRESSION)
+// ============================================
+// MSG_COMPRESSED: [type:1][raw_len:4][raw deflate stream] (schema compressed_header trong common/schema.h)
+// Giải nén được payload raw_len byte của message type gốc, xử lý như frame type đó.
+// Server chỉ nén danh sách phòng/người chơi, bảng điểm và lịch sử khi payload >= COMPRESS_MIN_PAYLOAD
+// và bản nén nhỏ hơn; mỗi frame là một stream deflate độc lập (không phụ thuộc frame trước).
+
+// ============================================
+// ROUND CLOCK (CAP_ROUND_DEADLINE)
+// ============================================
+// MSG_ROUND_DEADLINE: [deadline_ms:8][server_now_ms:8] (schema round_deadline trong common/schema.h)
+// Cả hai là CLOCK_MONOTONIC của server; client chỉ dùng hiệu deadline_ms - server_now_ms (thời gian còn lại)
+// cộng vào đồng hồ của mình lúc nhận. Gửi ngay sau GAME_START và resync mỗi ROUND_DEADLINE_RESYNC_MS.
+// Client không có capability này nhận MSG_TIMER_UPDATE mỗi giây như trước.
+
+// ============================================
+// PING / PONG
+// ============================================
+// PING: [seq:4][origin_ms:8]  PONG: [seq:4][origin_ms:8][recv_ms:8][send_ms:8] (schema ping/pong)
+// Bên nhận PING chép seq/origin_ms, ghi đồng hồ của mình lúc nhận/gửi. Bên gửi PING tính lúc nhận PONG (now):
+//   rtt = (now - origin_ms) - (send_ms - recv_ms)
+//   offset (đồng hồ bên kia - đồng hồ mình) = ((recv_ms - origin_ms) + (send_ms - now)) / 2
+// Mọi thời điểm trong PING/PONG là đồng hồ thực (epoch ms) để offset so sánh được giữa hai máy;
+// RTT mỗi bên tự đo bằng đồng hồ monotonic nếu có. Mọi client được gửi PING; server chỉ PING client có CAP_PING.
+
+// CANVAS_SNAPSHOT payload
+// [room_id:4][total_len:4][offset:4][data: phần snapshot từ offset]
+// Chỉ gửi cho client CAP_CANVAS_SNAPSHOT (server chạy --canvas); client khác nhận phát lại DRAW_BROADCAST.
+// Client có CAP_EXTENDED_FRAMES nhận cả snapshot trong một frame (offset = 0),
+// client cũ nhận nhiều frame nhỏ và ghép các phần theo offset cho đến khi đủ total_len.
+// Format snapshot xem canvas_get_snapshot() trong include/canvas.h
+#pragma pack(1)
+typedef struct {
+    int32_t room_id;
+    uint32_t total_len;          // Tổng độ dài snapshot
+    uint32_t offset;             // Vị trí của phần dữ liệu trong frame này
+    // Sau đó là dữ liệu snapshot
+} canvas_snapshot_chunk_t;
+#pragma pack()
+
 #endif // PROTOCOL_H
 
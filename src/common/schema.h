@@ -0,0 +1,273 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include "protocol.h"
+
+// ============================================
+// MESSAGE SCHEMA (nguồn duy nhất cho layout payload)
+// ============================================
+// Mỗi schema là một X-macro liệt kê các trường theo thứ tự trên wire: F(kind, name, size)
+//   U8, U16, U32, I32, U64  số nguyên big-endian (size bỏ qua)
+//   FSTR                    char[size] cố định, đệm '\0' (layout v1)
+//   STR                     [len:1][UTF-8 bytes], tối đa size - 1 bytes (CAP_COMPACT_STRINGS)
+//
+// common/codec.h sinh struct msg_<name>_t + encoder/decoder C từ các schema này,
+// tools/gen_codec_js.c sinh gateway/codec.js cho gateway (make codec-js).
+// Danh sách có số phần tử (người chơi, điểm, lịch sử) = schema header + schema phần tử lặp lại.
+
+// --- Hệ thống ---
+#define SCHEMA_HELLO(F) \
+    F(U16, version, 0) \
+    F(U32, caps, 0)
+
+// MSG_ERROR: request_type là type của request bị từ chối (START_GAME, ROOM_LIST_REQUEST, GET_GAME_HISTORY)
+#define SCHEMA_ERROR(F) \
+    F(U8, request_type, 0) \
+    F(STR, message, 128)
+
+// MSG_COMPRESSED: header trước dữ liệu deflate
+#define SCHEMA_COMPRESSED_HEADER(F) \
+    F(U8, type, 0) \
+    F(U32, raw_len, 0)
+
+// --- Xác thực ---
+#define SCHEMA_LOGIN_REQUEST(F) \
+    F(FSTR, username, MAX_USERNAME_LEN) \
+    F(FSTR, password, MAX_PASSWORD_LEN) \
+    F(FSTR, avatar, 32)
+
+#define SCHEMA_LOGIN_RESPONSE(F) \
+    F(U8, status, 0) \
+    F(I32, user_id, 0) \
+    F(FSTR, username, MAX_USERNAME_LEN)
+
+#define SCHEMA_REGISTER_REQUEST(F) \
+    F(FSTR, username, MAX_USERNAME_LEN) \
+    F(FSTR, password, MAX_PASSWORD_LEN) \
+    F(FSTR, email, MAX_EMAIL_LEN)
+
+#define SCHEMA_CHANGE_PASSWORD_REQUEST(F) \
+    F(FSTR, old_password, MAX_PASSWORD_LEN) \
+    F(FSTR, new_password, MAX_PASSWORD_LEN)
+
+// REGISTER_RESPONSE, CHANGE_PASSWORD_RESPONSE, LEAVE_ROOM response
+#define SCHEMA_STATUS_RESPONSE(F) \
+    F(U8, status, 0) \
+    F(FSTR, message, 128)
+
+#define SCHEMA_STATUS_RESPONSE_V2(F) \
+    F(U8, status, 0) \
+    F(STR, message, 256)
+
+// --- Phòng ---
+#define SCHEMA_CREATE_ROOM_REQUEST(F) \
+    F(FSTR, room_name, MAX_ROOM_NAME_LEN) \
+    F(U8, max_players, 0) \
+    F(U8, rounds, 0) \
+    F(FSTR, difficulty, 16)
+
+// JOIN_ROOM / LEAVE_ROOM request
+#define SCHEMA_ROOM_ID(F) \
+    F(I32, room_id, 0)
+
+// CREATE_ROOM / JOIN_ROOM response
+#define SCHEMA_ROOM_RESPONSE(F) \
+    F(U8, status, 0) \
+    F(I32, room_id, 0) \
+    F(FSTR, message, 128)
+
+#define SCHEMA_ROOM_RESPONSE_V2(F) \
+    F(U8, status, 0) \
+    F(I32, room_id, 0) \
+    F(STR, message, 256)
+
+// Một phòng trong ROOM_LIST_RESPONSE / ROOM_LIST_DELTA (UPSERT) / ROOM_UPDATE
+#define SCHEMA_ROOM_INFO(F) \
+    F(I32, room_id, 0) \
+    F(FSTR, room_name, MAX_ROOM_NAME_LEN) \
+    F(U8, player_count, 0) \
+    F(U8, max_players, 0) \
+    F(U8, state, 0) \
+    F(I32, owner_id, 0) \
+    F(FSTR, owner_username, MAX_USERNAME_LEN)
+
+// ROOM_PLAYERS_UPDATE = header + player_count x player_info
+#define SCHEMA_ROOM_PLAYERS_HEADER(F) \
+    F(I32, room_id, 0) \
+    F(FSTR, room_name, MAX_ROOM_NAME_LEN) \
+    F(U8, max_players, 0) \
+    F(U8, state, 0) \
+    F(I32, owner_id, 0) \
+    F(U8, action, 0) \
+    F(I32, changed_user_id, 0) \
+    F(FSTR, changed_username, MAX_USERNAME_LEN) \
+    F(U16, player_count, 0)
+
+#define SCHEMA_ROOM_PLAYERS_HEADER_V2(F) \
+    F(I32, room_id, 0) \
+    F(STR, room_name, MAX_ROOM_NAME_LEN) \
+    F(U8, max_players, 0) \
+    F(U8, state, 0) \
+    F(I32, owner_id, 0) \
+    F(U8, action, 0) \
+    F(I32, changed_user_id, 0) \
+    F(STR, changed_username, MAX_USERNAME_LEN) \
+    F(U16, player_count, 0)
+
+#define SCHEMA_PLAYER_INFO(F) \
+    F(I32, user_id, 0) \
+    F(FSTR, username, MAX_USERNAME_LEN) \
+    F(FSTR, avatar, 32) \
+    F(U8, is_owner, 0) \
+    F(U8, is_active, 0)
+
+#define SCHEMA_PLAYER_INFO_V2(F) \
+    F(I32, user_id, 0) \
+    F(STR, username, MAX_USERNAME_LEN) \
+    F(STR, avatar, 32) \
+    F(U8, is_owner, 0) \
+    F(U8, is_active, 0)
+
+#define SCHEMA_ROOM_PLAYER_DELTA(F) \
+    F(I32, room_id, 0) \
+    F(U8, action, 0) \
+    F(U8, state, 0) \
+    F(I32, owner_id, 0) \
+    F(U16, player_count, 0) \
+    F(I32, user_id, 0) \
+    F(U8, is_active, 0) \
+    F(STR, username, MAX_USERNAME_LEN) \
+    F(STR, avatar, 32)
+
+// --- Game ---
+#define SCHEMA_GAME_START(F) \
+    F(I32, drawer_id, 0) \
+    F(U8, word_length, 0) \
+    F(U16, time_limit, 0) \
+    F(U64, round_start_ms, 0) \
+    F(I32, current_round, 0) \
+    F(U8, player_count, 0) \
+    F(U8, total_rounds, 0) \
+    F(FSTR, word, MAX_WORD_LEN) \
+    F(FSTR, category, MAX_WORD_LEN)
+
+#define SCHEMA_GAME_START_V2(F) \
+    F(I32, drawer_id, 0) \
+    F(U8, word_length, 0) \
+    F(U16, time_limit, 0) \
+    F(U64, round_start_ms, 0) \
+    F(I32, current_round, 0) \
+    F(U8, player_count, 0) \
+    F(U8, total_rounds, 0) \
+    F(STR, word, MAX_WORD_LEN) \
+    F(STR, category, MAX_WORD_LEN)
+
+#define SCHEMA_CORRECT_GUESS(F) \
+    F(I32, player_id, 0) \
+    F(FSTR, word, MAX_WORD_LEN) \
+    F(U16, guesser_points, 0) \
+    F(U16, drawer_points, 0) \
+    F(FSTR, username, MAX_USERNAME_LEN)
+
+#define SCHEMA_CORRECT_GUESS_V2(F) \
+    F(I32, player_id, 0) \
+    F(STR, word, MAX_WORD_LEN) \
+    F(U16, guesser_points, 0) \
+    F(U16, drawer_points, 0) \
+    F(STR, username, MAX_USERNAME_LEN)
+
+// ROUND_END = header + score_count x score_entry
+#define SCHEMA_ROUND_END_HEADER(F) \
+    F(FSTR, word, MAX_WORD_LEN) \
+    F(U16, score_count, 0)
+
+#define SCHEMA_ROUND_END_HEADER_V2(F) \
+    F(STR, word, MAX_WORD_LEN) \
+    F(U16, score_count, 0)
+
+// GAME_END = header + score_count x score_entry
+#define SCHEMA_GAME_END_HEADER(F) \
+    F(I32, winner_id, 0) \
+    F(U16, score_count, 0)
+
+#define SCHEMA_SCORE_ENTRY(F) \
+    F(I32, user_id, 0) \
+    F(I32, score, 0)
+
+#define SCHEMA_TIMER_UPDATE(F) \
+    F(U16, time_left, 0)
+
+#define SCHEMA_PING(F) \
+    F(U32, seq, 0) \
+    F(U64, origin_ms, 0)
+
+#define SCHEMA_PONG(F) \
+    F(U32, seq, 0) \
+    F(U64, origin_ms, 0) \
+    F(U64, recv_ms, 0) \
+    F(U64, send_ms, 0)
+
+#define SCHEMA_ROUND_DEADLINE(F) \
+    F(U64, deadline_ms, 0) \
+    F(U64, server_now_ms, 0)
+
+// --- Chat ---
+#define SCHEMA_CHAT_BROADCAST(F) \
+    F(FSTR, username, MAX_USERNAME_LEN) \
+    F(FSTR, message, MAX_MESSAGE_LEN) \
+    F(U64, timestamp, 0)
+
+#define SCHEMA_CHAT_BROADCAST_V2(F) \
+    F(STR, username, MAX_USERNAME_LEN) \
+    F(STR, message, MAX_MESSAGE_LEN) \
+    F(U64, timestamp, 0)
+
+// --- Lịch sử ---
+// GAME_HISTORY_RESPONSE = header + count x history_entry
+#define SCHEMA_HISTORY_HEADER(F) \
+    F(U16, count, 0)
+
+#define SCHEMA_HISTORY_ENTRY(F) \
+    F(I32, score, 0) \
+    F(I32, rank, 0) \
+    F(FSTR, finished_at, 32)
+
+// Danh sách schema: S(tên, TÊN) -> msg_<tên>_t, SCHEMA_<TÊN>
+#define PROTOCOL_SCHEMAS(S) \
+    S(hello, HELLO) \
+    S(error, ERROR) \
+    S(compressed_header, COMPRESSED_HEADER) \
+    S(login_request, LOGIN_REQUEST) \
+    S(login_response, LOGIN_RESPONSE) \
+    S(register_request, REGISTER_REQUEST) \
+    S(change_password_request, CHANGE_PASSWORD_REQUEST) \
+    S(status_response, STATUS_RESPONSE) \
+    S(status_response_v2, STATUS_RESPONSE_V2) \
+    S(create_room_request, CREATE_ROOM_REQUEST) \
+    S(room_id, ROOM_ID) \
+    S(room_response, ROOM_RESPONSE) \
+    S(room_response_v2, ROOM_RESPONSE_V2) \
+    S(room_info, ROOM_INFO) \
+    S(room_players_header, ROOM_PLAYERS_HEADER) \
+    S(room_players_header_v2, ROOM_PLAYERS_HEADER_V2) \
+    S(player_info, PLAYER_INFO) \
+    S(player_info_v2, PLAYER_INFO_V2) \
+    S(room_player_delta, ROOM_PLAYER_DELTA) \
+    S(game_start, GAME_START) \
+    S(game_start_v2, GAME_START_V2) \
+    S(correct_guess, CORRECT_GUESS) \
+    S(correct_guess_v2, CORRECT_GUESS_V2) \
+    S(round_end_header, ROUND_END_HEADER) \
+    S(round_end_header_v2, ROUND_END_HEADER_V2) \
+    S(game_end_header, GAME_END_HEADER) \
+    S(score_entry, SCORE_ENTRY) \
+    S(timer_update, TIMER_UPDATE) \
+    S(round_deadline, ROUND_DEADLINE) \
+    S(ping, PING) \
+    S(pong, PONG) \
+    S(chat_broadcast, CHAT_BROADCAST) \
+    S(chat_broadcast_v2, CHAT_BROADCAST_V2) \
+    S(history_header, HISTORY_HEADER) \
+    S(history_entry, HISTORY_ENTRY)
+
+#endif // SCHEMA_H
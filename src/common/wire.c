@@ -0,0 +1,209 @@
+#include "wire.h"
+#include <string.h>
+
+void wire_writer_init(wire_writer_t *w, uint8_t *buf, size_t capacity)
+{
+    w->buf = buf;
+    w->capacity = buf ? capacity : 0;
+    w->len = 0;
+    w->overflow = 0;
+}
+
+// Dat cho n byte, tra ve con tro ghi hoac NULL neu khong du cho
+static uint8_t *writer_reserve(wire_writer_t *w, size_t n)
+{
+    if (w->overflow || w->capacity - w->len < n)
+    {
+        w->overflow = 1;
+        return NULL;
+    }
+    uint8_t *p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+void wire_put_u8(wire_writer_t *w, uint8_t v)
+{
+    uint8_t *p = writer_reserve(w, 1);
+    if (p)
+    {
+        p[0] = v;
+    }
+}
+
+void wire_put_u16(wire_writer_t *w, uint16_t v)
+{
+    uint8_t *p = writer_reserve(w, 2);
+    if (p)
+    {
+        p[0] = (uint8_t)(v >> 8);
+        p[1] = (uint8_t)v;
+    }
+}
+
+void wire_put_u32(wire_writer_t *w, uint32_t v)
+{
+    uint8_t *p = writer_reserve(w, 4);
+    if (p)
+    {
+        p[0] = (uint8_t)(v >> 24);
+        p[1] = (uint8_t)(v >> 16);
+        p[2] = (uint8_t)(v >> 8);
+        p[3] = (uint8_t)v;
+    }
+}
+
+void wire_put_i32(wire_writer_t *w, int32_t v)
+{
+    wire_put_u32(w, (uint32_t)v);
+}
+
+void wire_put_u64(wire_writer_t *w, uint64_t v)
+{
+    wire_put_u32(w, (uint32_t)(v >> 32));
+    wire_put_u32(w, (uint32_t)(v & 0xFFFFFFFFULL));
+}
+
+void wire_put_bytes(wire_writer_t *w, const void *data, size_t len)
+{
+    uint8_t *p = writer_reserve(w, len);
+    if (p && len > 0)
+    {
+        memcpy(p, data, len);
+    }
+}
+
+void wire_put_string(wire_writer_t *w, const char *s, size_t max_len)
+{
+    size_t len = s ? strlen(s) : 0;
+    if (max_len > WIRE_MAX_STRING_LEN)
+    {
+        max_len = WIRE_MAX_STRING_LEN;
+    }
+    if (len > max_len)
+    {
+        // Lui ve dau ky tu UTF-8 (byte tiep noi co dang 10xxxxxx)
+        len = max_len;
+        while (len > 0 && ((uint8_t)s[len] & 0xC0) == 0x80)
+        {
+            len--;
+        }
+    }
+
+    wire_put_u8(w, (uint8_t)len);
+    wire_put_bytes(w, s, len);
+}
+
+void wire_put_fixed_string(wire_writer_t *w, const char *s, size_t size)
+{
+    uint8_t *p = writer_reserve(w, size);
+    if (!p || size == 0)
+    {
+        return;
+    }
+
+    size_t len = s ? strnlen(s, size - 1) : 0;
+    if (len > 0)
+    {
+        memcpy(p, s, len);
+    }
+    memset(p + len, 0, size - len);
+}
+
+void wire_reader_init(wire_reader_t *r, const uint8_t *buf, size_t len)
+{
+    r->buf = buf;
+    r->len = buf ? len : 0;
+    r->pos = 0;
+    r->overflow = 0;
+}
+
+// Lay n byte tiep theo, NULL neu payload khong du
+static const uint8_t *reader_take(wire_reader_t *r, size_t n)
+{
+    if (r->overflow || r->len - r->pos < n)
+    {
+        r->overflow = 1;
+        return NULL;
+    }
+    const uint8_t *p = r->buf + r->pos;
+    r->pos += n;
+    return p;
+}
+
+uint8_t wire_get_u8(wire_reader_t *r)
+{
+    const uint8_t *p = reader_take(r, 1);
+    return p ? p[0] : 0;
+}
+
+uint16_t wire_get_u16(wire_reader_t *r)
+{
+    const uint8_t *p = reader_take(r, 2);
+    return p ? (uint16_t)((p[0] << 8) | p[1]) : 0;
+}
+
+uint32_t wire_get_u32(wire_reader_t *r)
+{
+    const uint8_t *p = reader_take(r, 4);
+    if (!p)
+    {
+        return 0;
+    }
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+int32_t wire_get_i32(wire_reader_t *r)
+{
+    return (int32_t)wire_get_u32(r);
+}
+
+uint64_t wire_get_u64(wire_reader_t *r)
+{
+    uint64_t hi = wire_get_u32(r);
+    uint64_t lo = wire_get_u32(r);
+    return (hi << 32) | lo;
+}
+
+int wire_get_string(wire_reader_t *r, char *out, size_t out_size)
+{
+    if (out && out_size > 0)
+    {
+        out[0] = '\0';
+    }
+
+    size_t len = wire_get_u8(r);
+    const uint8_t *p = reader_take(r, len);
+    if (r->overflow)
+    {
+        return -1;
+    }
+    if (!out || out_size == 0)
+    {
+        return 0;
+    }
+
+    size_t copy = len < out_size - 1 ? len : out_size - 1;
+    memcpy(out, p, copy);
+    out[copy] = '\0';
+    return (int)copy;
+}
+
+int wire_get_fixed_string(wire_reader_t *r, char *out, size_t size)
+{
+    const uint8_t *p = reader_take(r, size);
+    if (!p)
+    {
+        if (size > 0)
+        {
+            out[0] = '\0';
+        }
+        return -1;
+    }
+    if (size > 0)
+    {
+        memcpy(out, p, size);
+        out[size - 1] = '\0';
+    }
+    return 0;
+}
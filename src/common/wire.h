@@ -0,0 +1,103 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================
+// WIRE ENCODING (dùng chung server và client C)
+// ============================================
+// Số nguyên: big-endian (network byte order)
+// Chuỗi:     [len:1][UTF-8 bytes], không có '\0' kết thúc, tối đa WIRE_MAX_STRING_LEN bytes
+// Chuỗi dài hơn giới hạn bị cắt tại ranh giới ký tự UTF-8 (không cắt đôi một ký tự nhiều byte)
+#define WIRE_MAX_STRING_LEN      255
+
+// Con trỏ ghi vào buffer có sẵn
+// Ghi vượt capacity không làm hỏng bộ nhớ: dữ liệu bị bỏ và overflow = 1
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t len;                 // Số byte đã ghi
+    int overflow;               // 1 nếu buffer không đủ chỗ
+} wire_writer_t;
+
+// Con trỏ đọc từ payload đã nhận
+// Đọc vượt cuối payload trả về 0/chuỗi rỗng và đặt overflow = 1
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;                 // Vị trí đọc tiếp theo
+    int overflow;               // 1 nếu payload bị thiếu dữ liệu
+} wire_reader_t;
+
+/**
+ * Khởi tạo writer
+ * @param w Writer
+ * @param buf Buffer đích
+ * @param capacity Kích thước buffer
+ */
+void wire_writer_init(wire_writer_t *w, uint8_t *buf, size_t capacity);
+
+void wire_put_u8(wire_writer_t *w, uint8_t v);
+void wire_put_u16(wire_writer_t *w, uint16_t v);
+void wire_put_u32(wire_writer_t *w, uint32_t v);
+void wire_put_i32(wire_writer_t *w, int32_t v);
+void wire_put_u64(wire_writer_t *w, uint64_t v);
+
+/**
+ * Ghi dãy byte thô
+ * @param w Writer
+ * @param data Dữ liệu
+ * @param len Số byte
+ */
+void wire_put_bytes(wire_writer_t *w, const void *data, size_t len);
+
+/**
+ * Ghi chuỗi dạng [len:1][bytes]
+ * @param w Writer
+ * @param s Chuỗi null-terminated (NULL = chuỗi rỗng)
+ * @param max_len Độ dài tối đa (bytes) của chuỗi trên wire, bị giới hạn ở WIRE_MAX_STRING_LEN
+ */
+void wire_put_string(wire_writer_t *w, const char *s, size_t max_len);
+
+/**
+ * Ghi chuỗi cố định size byte (đệm '\0', luôn có '\0' kết thúc), dùng cho layout v1 char[N]
+ * @param w Writer
+ * @param s Chuỗi null-terminated (NULL = chuỗi rỗng)
+ * @param size Số byte trên wire
+ */
+void wire_put_fixed_string(wire_writer_t *w, const char *s, size_t size);
+
+/**
+ * Khởi tạo reader
+ * @param r Reader
+ * @param buf Payload
+ * @param len Độ dài payload
+ */
+void wire_reader_init(wire_reader_t *r, const uint8_t *buf, size_t len);
+
+uint8_t wire_get_u8(wire_reader_t *r);
+uint16_t wire_get_u16(wire_reader_t *r);
+uint32_t wire_get_u32(wire_reader_t *r);
+int32_t wire_get_i32(wire_reader_t *r);
+uint64_t wire_get_u64(wire_reader_t *r);
+
+/**
+ * Đọc chuỗi [len:1][bytes] vào buffer, luôn null-terminated
+ * @param r Reader
+ * @param out Buffer đích
+ * @param out_size Kích thước buffer đích (chuỗi dài hơn bị cắt)
+ * @return Độ dài chuỗi đã ghi vào out, -1 nếu payload thiếu dữ liệu
+ */
+int wire_get_string(wire_reader_t *r, char *out, size_t out_size);
+
+/**
+ * Đọc chuỗi cố định size byte vào buffer size byte, luôn null-terminated
+ * @param r Reader
+ * @param out Buffer đích (ít nhất size byte)
+ * @param size Số byte trên wire
+ * @return 0 nếu thành công, -1 nếu payload thiếu dữ liệu
+ */
+int wire_get_fixed_string(wire_reader_t *r, char *out, size_t size);
+
+#endif // WIRE_H
@@ -54,6 +54,7 @@ export default function GameRoom({
   const [leaderboardPlayers, setLeaderboardPlayers] = useState([]); // Lưu leaderboard data riêng
   const timerRef = useRef(null);
   const [serverTimeLeft, setServerTimeLeft] = useState(null); // Thời gian từ server (authoritative)
+  const [roundDeadlineMs, setRoundDeadlineMs] = useState(null); // Hạn chót round theo Date.now() (ROUND_DEADLINE)
   const [displayTimeLeft, setDisplayTimeLeft] = useState(DEFAULT_ROUND_TIME); // Thời gian hiển thị (smoothed)
 
   const isOwner = useMemo(() => {
@@ -167,8 +168,9 @@ export default function GameRoom({
       setRoundStartMs(startMs);
       setTimeLimit(tl);
       setTimeLeft(tl);
-      // Reset server time khi bắt đầu round mới
+      // Reset server time khi bắt đầu round mới (ROUND_DEADLINE đến ngay sau GAME_START)
       setServerTimeLeft(null);
+      setRoundDeadlineMs(null);
       setDisplayTimeLeft(tl);
 
       // Cập nhật thông tin vòng
@@ -219,6 +221,12 @@ export default function GameRoom({
       setServerTimeLeft(data.time_left);
     };
 
+    const handleRoundDeadline = (data) => {
+      // data: { time_left_ms, deadline_ms } - gateway đã đổi hạn chót sang Date.now()
+      if (!data || typeof data.deadline_ms !== 'number') return;
+      setRoundDeadlineMs(data.deadline_ms);
+    };
+
     const handleCorrectGuess = (data) => {
       if (!data) return;
       console.log('[GameRoom] handleCorrectGuess received:', data);
@@ -362,6 +370,7 @@ export default function GameRoom({
       services.subscribe('room_update', handleRoomUpdate);
       services.subscribe('game_start', handleGameStart);
       services.subscribe('timer_update', handleTimerUpdate);
+      services.subscribe('round_deadline', handleRoundDeadline);
       services.subscribe('draw_broadcast', handleDrawBroadcast);
       services.subscribe('correct_guess', handleCorrectGuess);
       services.subscribe('chat_broadcast', handleChatBroadcast);
@@ -376,6 +385,7 @@ export default function GameRoom({
       services.unsubscribe('room_update', handleRoomUpdate);
       services.unsubscribe('game_start', handleGameStart);
       services.unsubscribe('timer_update', handleTimerUpdate);
+      services.unsubscribe('round_deadline', handleRoundDeadline);
       services.unsubscribe('draw_broadcast', handleDrawBroadcast);
       services.unsubscribe('correct_guess', handleCorrectGuess);
       services.unsubscribe('chat_broadcast', handleChatBroadcast);
@@ -430,11 +440,13 @@ export default function GameRoom({
   }, [roomId]);
 
   // Hybrid timer: Server authority + Client smoothing
-  // Server gửi timer update mỗi 1 giây, client làm mượt giữa các updates
+  // Có ROUND_DEADLINE thì tự đếm ngược tới hạn chót (server chỉ resync thưa),
+  // nếu không thì server gửi timer update mỗi 1 giây, client làm mượt giữa các updates
   useEffect(() => {
     if (gameState !== 'playing') {
       // Reset khi không chơi
       setServerTimeLeft(null);
+      setRoundDeadlineMs(null);
       setDisplayTimeLeft(DEFAULT_ROUND_TIME);
       if (timerRef.current) {
         clearInterval(timerRef.current);
@@ -450,8 +462,10 @@ export default function GameRoom({
       setDisplayTimeLeft(prev => {
         let newValue;
         
-        // Nếu có server time, ưu tiên dùng server time
-        if (serverTimeLeft !== null) {
+        if (roundDeadlineMs !== null) {
+          newValue = Math.max(0, (roundDeadlineMs - Date.now()) / 1000);
+        } else if (serverTimeLeft !== null) {
+          // Nếu có server time, ưu tiên dùng server time
           // Nếu lệch quá nhiều (> 1 giây), nhảy ngay để đồng bộ
           if (Math.abs(prev - serverTimeLeft) > 1) {
             newValue = serverTimeLeft;
@@ -486,7 +500,7 @@ export default function GameRoom({
       if (timerRef.current) clearInterval(timerRef.current);
       timerRef.current = null;
     };
-  }, [gameState, roundStartMs, timeLimit, serverTimeLeft]);
+  }, [gameState, roundStartMs, timeLimit, serverTimeLeft, roundDeadlineMs]);
 
   const handleLeaveRoom = () => {
     console.log('[GameRoom] User explicitly leaving room:', roomId);
@@ -18,6 +18,7 @@ export default function Lobby({ onJoinRoom, onCreateRoom, rooms = [] }) {
   const [dropdownPosition, setDropdownPosition] = useState({ top: 0, left: 0 });
   const userInfoRef = useRef(null);
   const timeoutRef = useRef(null); 
+  const roomListSeqRef = useRef(0); // seq danh sách phòng đang hiển thị (0 = chưa có)
   const { user } = useAuth();
   const navigate = useNavigate();
 
@@ -69,6 +70,35 @@ export default function Lobby({ onJoinRoom, onCreateRoom, rooms = [] }) {
       }
     };
 
+    const formatRoom = (room) => {
+      const getStateText = (state) => {
+        switch (state) {
+          case 0: return 'Chờ';
+          case 1: return 'Đang chơi';
+          case 2: return 'Kết thúc';
+          default: return 'Không xác định';
+        }
+      };
+      // Xử lý owner_username: nếu rỗng, null, undefined, hoặc "Unknown" thì fallback
+      const ownerUsername = room.owner_username && 
+                            room.owner_username.trim() !== '' && 
+                            room.owner_username !== 'Unknown' 
+                            ? room.owner_username 
+                            : `User ${room.owner_id}`;
+      
+      return {
+        id: room.room_id.toString(),
+        name: room.room_name,
+        currentPlayers: room.player_count,
+        maxPlayers: room.max_players,
+        state: room.state,
+        stateText: getStateText(room.state),
+        ownerId: room.owner_id,
+        ownerUsername: ownerUsername, // Username của chủ phòng
+        canJoin: room.state === 0 && room.player_count < room.max_players
+      };
+    };
+
     const handleRoomListResponse = (data) => {
       // clear timeout khi có phản hồi
       if (timeoutRef.current) {
@@ -77,51 +107,47 @@ export default function Lobby({ onJoinRoom, onCreateRoom, rooms = [] }) {
       }
       setIsLoadingRooms(false);
       setError(null);
+      roomListSeqRef.current = data.seq || 0;
       if (data.rooms) {
-        const formattedRooms = data.rooms.map(room => {
-          const getStateText = (state) => {
-            switch (state) {
-              case 0: return 'Chờ';
-              case 1: return 'Đang chơi';
-              case 2: return 'Kết thúc';
-              default: return 'Không xác định';
-            }
-          };
-          // Xử lý owner_username: nếu rỗng, null, undefined, hoặc "Unknown" thì fallback
-          const ownerUsername = room.owner_username && 
-                                room.owner_username.trim() !== '' && 
-                                room.owner_username !== 'Unknown' 
-                                ? room.owner_username 
-                                : `User ${room.owner_id}`;
-          
-          // Debug log
-          if (room.owner_username) {
-            console.log('Room owner info:', { 
-              room_id: room.room_id, 
-              owner_id: room.owner_id, 
-              owner_username: room.owner_username,
-              final_ownerUsername: ownerUsername 
-            });
-          }
-          
-          return {
-            id: room.room_id.toString(),
-            name: room.room_name,
-            currentPlayers: room.player_count,
-            maxPlayers: room.max_players,
-            state: room.state,
-            stateText: getStateText(room.state),
-            ownerId: room.owner_id,
-            ownerUsername: ownerUsername, // Username của chủ phòng
-            canJoin: room.state === 0 && room.player_count < room.max_players
-          };
-        });
-        setRoomsList(formattedRooms);
+        setRoomsList(data.rooms.map(formatRoom));
       } else {
         setRoomsList([]);
       }
     };
 
+    // Áp dụng delta danh sách phòng; lệch seq thì xin lại danh sách đầy đủ
+    const handleRoomListDelta = (data) => {
+      if (!data.changes) {
+        return;
+      }
+      if (roomListSeqRef.current === 0 || data.seq !== roomListSeqRef.current + 1) {
+        console.warn('[Lobby] Room list delta out of sequence:', data.seq, 'have', roomListSeqRef.current);
+        services.getRoomList();
+        return;
+      }
+      roomListSeqRef.current = data.seq;
+      setRoomsList(prev => {
+        const next = [...prev];
+        data.changes.forEach(change => {
+          if (change.op === 'remove') {
+            const index = next.findIndex(room => room.id === change.room_id.toString());
+            if (index >= 0) {
+              next.splice(index, 1);
+            }
+          } else if (change.op === 'upsert') {
+            const room = formatRoom(change.room);
+            const index = next.findIndex(r => r.id === room.id);
+            if (index >= 0) {
+              next[index] = room;
+            } else {
+              next.push(room);
+            }
+          }
+        });
+        return next;
+      });
+    };
+
     const handleError = (data) => {
       // clear timeout khi có lỗi
       if (timeoutRef.current) {
@@ -136,6 +162,7 @@ export default function Lobby({ onJoinRoom, onCreateRoom, rooms = [] }) {
     services.subscribe('create_room_response', handleCreateRoomResponse);
     services.subscribe('join_room_response', handleJoinRoomResponse);
     services.subscribe('room_list_response', handleRoomListResponse);
+    services.subscribe('room_list_delta', handleRoomListDelta);
     services.subscribe('error', handleError);
 
     // Kết nối và load danh sách phòng
@@ -217,6 +244,9 @@ export default function Lobby({ onJoinRoom, onCreateRoom, rooms = [] }) {
       services.unsubscribe('create_room_response', handleCreateRoomResponse);
       services.unsubscribe('join_room_response', handleJoinRoomResponse);
       services.unsubscribe('room_list_response', handleRoomListResponse);
+      services.unsubscribe('room_list_delta', handleRoomListDelta);
+      // Rời trang lobby: ngừng nhận cập nhật danh sách phòng
+      services.unsubscribeLobby();
       services.unsubscribe('error', handleError);
       if (timeoutRef.current) {
         clearTimeout(timeoutRef.current);
@@ -648,6 +648,7 @@ class Services {
 
     /**
      * Lấy danh sách phòng
+     * Server đồng thời đăng ký client theo dõi sảnh (nhận ROOM_LIST_DELTA)
      */
     getRoomList() {
         const message = {
@@ -657,6 +658,13 @@ class Services {
         return this.send(message);
     }
 
+    /**
+     * Ngừng theo dõi sảnh (rời trang lobby)
+     */
+    unsubscribeLobby() {
+        return this.send({ type: 'lobby_unsubscribe', data: {} });
+    }
+
     /**
      * Lấy cached room players update nếu có
      */
@@ -0,0 +1,320 @@
+// FILE SINH TU DONG tu common/schema.h boi tools/gen_codec_js.c - KHONG SUA TAY
+// Chay lai: make codec-js
+//
+// Moi schema la danh sach [kind, name, size] theo thu tu tren wire:
+//   U8, U16, U32, I32, U64  so nguyen big-endian (U64 tra ve Number)
+//   FSTR                    char[size] co dinh, dem '\0'
+//   STR                     [len:1][UTF-8 bytes], toi da size - 1 bytes
+'use strict';
+
+const SCHEMAS = {
+    hello: [
+        ['U16', 'version', 0],
+        ['U32', 'caps', 0],
+    ],
+    error: [
+        ['U8', 'request_type', 0],
+        ['STR', 'message', 128],
+    ],
+    compressed_header: [
+        ['U8', 'type', 0],
+        ['U32', 'raw_len', 0],
+    ],
+    login_request: [
+        ['FSTR', 'username', 32],
+        ['FSTR', 'password', 32],
+        ['FSTR', 'avatar', 32],
+    ],
+    login_response: [
+        ['U8', 'status', 0],
+        ['I32', 'user_id', 0],
+        ['FSTR', 'username', 32],
+    ],
+    register_request: [
+        ['FSTR', 'username', 32],
+        ['FSTR', 'password', 32],
+        ['FSTR', 'email', 64],
+    ],
+    change_password_request: [
+        ['FSTR', 'old_password', 32],
+        ['FSTR', 'new_password', 32],
+    ],
+    status_response: [
+        ['U8', 'status', 0],
+        ['FSTR', 'message', 128],
+    ],
+    status_response_v2: [
+        ['U8', 'status', 0],
+        ['STR', 'message', 256],
+    ],
+    create_room_request: [
+        ['FSTR', 'room_name', 32],
+        ['U8', 'max_players', 0],
+        ['U8', 'rounds', 0],
+        ['FSTR', 'difficulty', 16],
+    ],
+    room_id: [
+        ['I32', 'room_id', 0],
+    ],
+    room_response: [
+        ['U8', 'status', 0],
+        ['I32', 'room_id', 0],
+        ['FSTR', 'message', 128],
+    ],
+    room_response_v2: [
+        ['U8', 'status', 0],
+        ['I32', 'room_id', 0],
+        ['STR', 'message', 256],
+    ],
+    room_info: [
+        ['I32', 'room_id', 0],
+        ['FSTR', 'room_name', 32],
+        ['U8', 'player_count', 0],
+        ['U8', 'max_players', 0],
+        ['U8', 'state', 0],
+        ['I32', 'owner_id', 0],
+        ['FSTR', 'owner_username', 32],
+    ],
+    room_players_header: [
+        ['I32', 'room_id', 0],
+        ['FSTR', 'room_name', 32],
+        ['U8', 'max_players', 0],
+        ['U8', 'state', 0],
+        ['I32', 'owner_id', 0],
+        ['U8', 'action', 0],
+        ['I32', 'changed_user_id', 0],
+        ['FSTR', 'changed_username', 32],
+        ['U16', 'player_count', 0],
+    ],
+    room_players_header_v2: [
+        ['I32', 'room_id', 0],
+        ['STR', 'room_name', 32],
+        ['U8', 'max_players', 0],
+        ['U8', 'state', 0],
+        ['I32', 'owner_id', 0],
+        ['U8', 'action', 0],
+        ['I32', 'changed_user_id', 0],
+        ['STR', 'changed_username', 32],
+        ['U16', 'player_count', 0],
+    ],
+    player_info: [
+        ['I32', 'user_id', 0],
+        ['FSTR', 'username', 32],
+        ['FSTR', 'avatar', 32],
+        ['U8', 'is_owner', 0],
+        ['U8', 'is_active', 0],
+    ],
+    player_info_v2: [
+        ['I32', 'user_id', 0],
+        ['STR', 'username', 32],
+        ['STR', 'avatar', 32],
+        ['U8', 'is_owner', 0],
+        ['U8', 'is_active', 0],
+    ],
+    room_player_delta: [
+        ['I32', 'room_id', 0],
+        ['U8', 'action', 0],
+        ['U8', 'state', 0],
+        ['I32', 'owner_id', 0],
+        ['U16', 'player_count', 0],
+        ['I32', 'user_id', 0],
+        ['U8', 'is_active', 0],
+        ['STR', 'username', 32],
+        ['STR', 'avatar', 32],
+    ],
+    game_start: [
+        ['I32', 'drawer_id', 0],
+        ['U8', 'word_length', 0],
+        ['U16', 'time_limit', 0],
+        ['U64', 'round_start_ms', 0],
+        ['I32', 'current_round', 0],
+        ['U8', 'player_count', 0],
+        ['U8', 'total_rounds', 0],
+        ['FSTR', 'word', 64],
+        ['FSTR', 'category', 64],
+    ],
+    game_start_v2: [
+        ['I32', 'drawer_id', 0],
+        ['U8', 'word_length', 0],
+        ['U16', 'time_limit', 0],
+        ['U64', 'round_start_ms', 0],
+        ['I32', 'current_round', 0],
+        ['U8', 'player_count', 0],
+        ['U8', 'total_rounds', 0],
+        ['STR', 'word', 64],
+        ['STR', 'category', 64],
+    ],
+    correct_guess: [
+        ['I32', 'player_id', 0],
+        ['FSTR', 'word', 64],
+        ['U16', 'guesser_points', 0],
+        ['U16', 'drawer_points', 0],
+        ['FSTR', 'username', 32],
+    ],
+    correct_guess_v2: [
+        ['I32', 'player_id', 0],
+        ['STR', 'word', 64],
+        ['U16', 'guesser_points', 0],
+        ['U16', 'drawer_points', 0],
+        ['STR', 'username', 32],
+    ],
+    round_end_header: [
+        ['FSTR', 'word', 64],
+        ['U16', 'score_count', 0],
+    ],
+    round_end_header_v2: [
+        ['STR', 'word', 64],
+        ['U16', 'score_count', 0],
+    ],
+    game_end_header: [
+        ['I32', 'winner_id', 0],
+        ['U16', 'score_count', 0],
+    ],
+    score_entry: [
+        ['I32', 'user_id', 0],
+        ['I32', 'score', 0],
+    ],
+    timer_update: [
+        ['U16', 'time_left', 0],
+    ],
+    round_deadline: [
+        ['U64', 'deadline_ms', 0],
+        ['U64', 'server_now_ms', 0],
+    ],
+    ping: [
+        ['U32', 'seq', 0],
+        ['U64', 'origin_ms', 0],
+    ],
+    pong: [
+        ['U32', 'seq', 0],
+        ['U64', 'origin_ms', 0],
+        ['U64', 'recv_ms', 0],
+        ['U64', 'send_ms', 0],
+    ],
+    chat_broadcast: [
+        ['FSTR', 'username', 32],
+        ['FSTR', 'message', 256],
+        ['U64', 'timestamp', 0],
+    ],
+    chat_broadcast_v2: [
+        ['STR', 'username', 32],
+        ['STR', 'message', 256],
+        ['U64', 'timestamp', 0],
+    ],
+    history_header: [
+        ['U16', 'count', 0],
+    ],
+    history_entry: [
+        ['I32', 'score', 0],
+        ['I32', 'rank', 0],
+        ['FSTR', 'finished_at', 32],
+    ],
+};
+
+function fieldSize(kind, size) {
+    switch (kind) {
+        case 'U8': return 1;
+        case 'U16': return 2;
+        case 'U32': case 'I32': return 4;
+        case 'U64': return 8;
+        default: return size;
+    }
+}
+
+// So byte toi da tren wire (= chinh xac neu schema khong co STR)
+function maxSize(name) {
+    return SCHEMAS[name].reduce((sum, [kind, , size]) => sum + fieldSize(kind, size), 0);
+}
+
+// Cat chuoi UTF-8 toi da maxBytes, khong cat doi ky tu nhieu byte
+function utf8Truncate(value, maxBytes) {
+    let bytes = Buffer.from(value == null ? '' : String(value), 'utf8');
+    if (bytes.length <= maxBytes) return bytes;
+    let len = maxBytes;
+    while (len > 0 && (bytes[len] & 0xC0) === 0x80) len--;
+    return bytes.subarray(0, len);
+}
+
+// Doc mot schema tu payload bat dau tai state.offset (state.offset duoc cap nhat)
+// Nem RangeError neu payload thieu du lieu
+function read(name, payload, state) {
+    const out = {};
+    for (const [kind, field, size] of SCHEMAS[name]) {
+        const need = kind === 'STR' ? 1 : fieldSize(kind, size);
+        if (state.offset + need > payload.length) {
+            throw new RangeError(`${name}.${field} exceeds payload`);
+        }
+        switch (kind) {
+            case 'U8': out[field] = payload.readUInt8(state.offset); break;
+            case 'U16': out[field] = payload.readUInt16BE(state.offset); break;
+            case 'U32': out[field] = payload.readUInt32BE(state.offset); break;
+            case 'I32': out[field] = payload.readInt32BE(state.offset); break;
+            case 'U64':
+                out[field] = payload.readUInt32BE(state.offset) * 4294967296 +
+                    payload.readUInt32BE(state.offset + 4);
+                break;
+            case 'FSTR': {
+                const raw = payload.subarray(state.offset, state.offset + size);
+                const end = raw.indexOf(0);
+                out[field] = raw.subarray(0, end < 0 ? raw.length : end).toString('utf8');
+                break;
+            }
+            case 'STR': {
+                const len = payload.readUInt8(state.offset);
+                if (state.offset + 1 + len > payload.length) {
+                    throw new RangeError(`${name}.${field} exceeds payload`);
+                }
+                out[field] = payload.subarray(state.offset + 1, state.offset + 1 + len).toString('utf8');
+                state.offset += len;
+                break;
+            }
+        }
+        state.offset += need;
+    }
+    return out;
+}
+
+function decode(name, payload) {
+    return read(name, payload, { offset: 0 });
+}
+
+// Ma hoa mot schema thanh Buffer (truong thieu = 0 / chuoi rong)
+function encode(name, values) {
+    const buffer = Buffer.alloc(maxSize(name));
+    let offset = 0;
+    for (const [kind, field, size] of SCHEMAS[name]) {
+        const value = values[field];
+        switch (kind) {
+            case 'U8': buffer.writeUInt8((value || 0) & 0xFF, offset); break;
+            case 'U16': buffer.writeUInt16BE((value || 0) & 0xFFFF, offset); break;
+            case 'U32': buffer.writeUInt32BE((value || 0) >>> 0, offset); break;
+            case 'I32': buffer.writeInt32BE((value || 0) | 0, offset); break;
+            case 'U64': {
+                const v = value || 0;
+                buffer.writeUInt32BE(Math.floor(v / 4294967296) >>> 0, offset);
+                buffer.writeUInt32BE(v >>> 0, offset + 4);
+                break;
+            }
+            case 'FSTR':
+                utf8Truncate(value, size - 1).copy(buffer, offset);
+                break;
+            case 'STR': {
+                const bytes = utf8Truncate(value, size - 1);
+                buffer.writeUInt8(bytes.length, offset);
+                bytes.copy(buffer, offset + 1);
+                offset += bytes.length + 1;
+                continue;
+            }
+        }
+        offset += fieldSize(kind, size);
+    }
+    return buffer.subarray(0, offset);
+}
+
+module.exports = {
+    SCHEMAS,
+    maxSize,
+    read,
+    decode,
+    encode
+};
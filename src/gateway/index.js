@@ -1,13 +1,19 @@
 const WebSocket = require('ws');
 const net = require('net');
 const http = require('http');
+const zlib = require('zlib');
 const {
     MessageBuffer,
+    CanvasSnapshotAssembler,
+    RoomRosterCache,
+    readFrameHeader,
+    CAP_COMPACT_STRINGS,
     Logger,
     TcpConnectionManager,
     MessageValidator,
     PerformanceMonitor
 } = require('./utils');
+const codec = require('./codec');
 
 class Gateway {
     constructor(wsPort = 3000, tcpHost = 'localhost', tcpPort = 8080) {
@@ -47,6 +53,9 @@ class Gateway {
         let isConnected = false;
         let connectingPromise = null; // Promise để đợi quá trình kết nối hoàn tất
         const messageBuffer = new MessageBuffer();
+        const canvasAssembler = new CanvasSnapshotAssembler();
+        const roomRoster = new RoomRosterCache();
+        let tcpCaps = 0; // Capability đã thỏa thuận qua HELLO_ACK
         let pingInterval = null; // Interval cho WebSocket ping
         
         // Tạo TcpConnectionManager riêng cho mỗi WebSocket client
@@ -97,6 +106,9 @@ class Gateway {
                     tcpClient.setKeepAlive(true, 60000);
                     Logger.debug('TCP keepalive enabled for connection');
 
+                    // Thỏa thuận phiên bản/capability trước mọi message khác
+                    tcpClient.write(this.createTcpMessage({ type: 'hello', data: {} }));
+
                     tcpClient.on('data', (data) => {
                         try {
                             Logger.info(`[Gateway] Received raw TCP data: ${data.length} bytes, hex: ${data.toString('hex').substring(0, 100)}...`);
@@ -106,7 +118,41 @@ class Gateway {
 
                             messages.forEach((messageData, index) => {
                                 Logger.info(`[Gateway] Parsing message ${index + 1}/${messages.length}, length: ${messageData.length}`);
-                                const message = this.parseTcpMessage(messageData);
+                                let message = this.parseTcpMessage(messageData, tcpCaps);
+                                if (message.type === 'ping') {
+                                    // Server đo RTT tới gateway: trả PONG ngay, không chuyển lên frontend
+                                    const now = Date.now();
+                                    tcpClient.write(this.createTcpMessage({
+                                        type: 'pong',
+                                        data: { ...message.data, recv_ms: now, send_ms: now }
+                                    }));
+                                    return;
+                                }
+                                if (message.type === 'hello_ack') {
+                                    tcpCaps = message.data.caps;
+                                    Logger.info(`[Gateway] Negotiated protocol v${message.data.version}, caps=0x${message.data.caps.toString(16)}`);
+                                    return;
+                                }
+                                if (message.type === 'canvas_snapshot') {
+                                    // Snapshot bị chia nhỏ, chỉ gửi cho frontend khi đã ghép đủ
+                                    const snapshot = canvasAssembler.add(message.data);
+                                    if (!snapshot) {
+                                        return;
+                                    }
+                                    message = {
+                                        type: 'canvas_snapshot',
+                                        data: this.parseCanvasSnapshot(message.data.room_id, snapshot)
+                                    };
+                                } else if (message.type === 'room_players_update') {
+                                    roomRoster.setFull(message.data);
+                                } else if (message.type === 'room_player_delta') {
+                                    // Dựng lại danh sách đầy đủ từ delta
+                                    const update = roomRoster.applyDelta(message.data);
+                                    if (!update) {
+                                        return;
+                                    }
+                                    message = { type: 'room_players_update', data: update };
+                                }
                                 Logger.info(`[Gateway] Sending message to WebSocket client: ${message.type}`, message);
                                 if (ws.readyState === WebSocket.OPEN) {
                                     ws.send(JSON.stringify(message));
@@ -251,6 +297,20 @@ class Gateway {
         let payload = Buffer.alloc(0);
 
         switch (message.type) {
+            case 'hello':
+                // caps: EXTENDED_FRAMES | ROOM_LIST_DELTA | PLAYER_DELTA | COMPACT_STRINGS | COMPRESSION | ROUND_DEADLINE | PING
+                // (không CANVAS_SNAPSHOT: frontend chưa giải nén/vẽ snapshot, người vào giữa round nhận phát lại nét vẽ)
+                payload = codec.encode('hello', { version: 2, caps: 0x7F });
+                break;
+            case 'ping': {
+                // Client (frontend) đo RTT/lệch đồng hồ với server: origin_ms theo đồng hồ của client
+                const ping = message.data || {};
+                payload = codec.encode('ping', { seq: ping.seq, origin_ms: ping.origin_ms || Date.now() });
+                break;
+            }
+            case 'pong':
+                payload = codec.encode('pong', message.data);
+                break;
             case 'login':
                 payload = this.createLoginPayload(message.data);
                 break;
@@ -263,6 +323,10 @@ class Gateway {
             case 'room_list':
                 payload = this.createRoomListPayload(message.data);
                 break;
+            case 'lobby_subscribe':
+            case 'lobby_unsubscribe':
+                payload = Buffer.alloc(0);
+                break;
             case 'create_room':
                 payload = this.createCreateRoomPayload(message.data);
                 break;
@@ -305,101 +369,128 @@ class Gateway {
         return Buffer.concat([header, payload]);
     }
 
+    // Giải nén payload MSG_COMPRESSED, trả về message type và payload gốc
+    inflateMessage(payload) {
+        const header = codec.decode('compressed_header', payload);
+        const raw = zlib.inflateRawSync(payload.subarray(codec.maxSize('compressed_header')), {
+            maxOutputLength: header.raw_len
+        });
+        if (raw.length !== header.raw_len) {
+            throw new Error(`Compressed message size mismatch: ${raw.length} != ${header.raw_len}`);
+        }
+        return { type: header.type, payload: raw };
+    }
+
     // Parse binary message từ TCP server thành JSON
-    parseTcpMessage(data) {
+    parseTcpMessage(data, caps = 0) {
         Logger.info(`[Gateway] parseTcpMessage: data length=${data.length}`);
-        if (data.length < 3) {
+        const header = readFrameHeader(data);
+        if (!header) {
             throw new Error('Message too short');
         }
 
-        const type = data.readUInt8(0);
-        const length = data.readUInt16BE(1);
-        Logger.info(`[Gateway] parseTcpMessage: type=0x${type.toString(16)}, payload_length=${length}, total_expected=${3 + length}`);
+        let { type, length, headerLength } = header;
+        Logger.info(`[Gateway] parseTcpMessage: type=0x${type.toString(16)}, payload_length=${length}, total_expected=${headerLength + length}`);
 
-        if (data.length < 3 + length) {
-            throw new Error(`Incomplete message: have ${data.length} bytes, need ${3 + length} bytes`);
+        if (data.length < headerLength + length) {
+            throw new Error(`Incomplete message: have ${data.length} bytes, need ${headerLength + length} bytes`);
         }
 
-        const payload = data.slice(3, 3 + length);
+        let payload = data.slice(headerLength, headerLength + length);
+        if (type === 0x54) {
+            // MSG_COMPRESSED: [type:1][raw_len:4][raw deflate], mỗi message là một stream độc lập
+            ({ type, payload } = this.inflateMessage(payload));
+        }
         const messageType = this.getMessageTypeName(type);
         Logger.info(`[Gateway] parseTcpMessage: messageType="${messageType}", payload.length=${payload.length}`);
 
         let parsedData = {};
+        // Server gửi chuỗi [len:1][bytes] thay cho char[N] khi đã thỏa thuận CAP_COMPACT_STRINGS
+        const compact = (caps & CAP_COMPACT_STRINGS) !== 0;
+
+        try {
+            parsedData = this.parsePayload(type, payload, compact);
+        } catch (e) {
+            if (!(e instanceof RangeError)) {
+                throw e;
+            }
+            Logger.warn(`[Gateway] ${messageType} payload invalid: ${e.message}`);
+            parsedData = { error: 'Invalid payload' };
+        }
 
+        return {
+            type: messageType,
+            data: parsedData
+        };
+    }
+
+    // Parse payload theo message type (compact = CAP_COMPACT_STRINGS đã thỏa thuận)
+    parsePayload(type, payload, compact) {
         switch (type) {
             case 0x02: // LOGIN_RESPONSE
-                parsedData = this.parseLoginResponse(payload);
-                break;
+                return this.parseLoginResponse(payload);
             case 0x04: // REGISTER_RESPONSE
-                parsedData = this.parseRegisterResponse(payload);
-                break;
+                return this.parseStatusResponse(payload);
             case 0x11: // ROOM_LIST_RESPONSE
-                parsedData = this.parseRoomListResponse(payload);
-                break;
+                return this.parseRoomListResponse(payload);
             case 0x12: // CREATE_ROOM_RESPONSE
-                parsedData = this.parseCreateRoomResponse(payload);
-                break;
+                return this.parseRoomResponse(payload, compact);
             case 0x13: // JOIN_ROOM_RESPONSE
-                parsedData = this.parseJoinRoomResponse(payload);
-                break;
+                return this.parseRoomResponse(payload, compact);
             case 0x14: // LEAVE_ROOM_RESPONSE
-                parsedData = this.parseLeaveRoomResponse(payload);
-                break;
+                return this.parseStatusResponse(payload, compact);
             case 0x15: // ROOM_UPDATE
-                parsedData = this.parseRoomUpdate(payload);
-                break;
+                return this.parseRoomUpdate(payload);
             case 0x17: // ROOM_PLAYERS_UPDATE
-                parsedData = this.parseRoomPlayersUpdate(payload);
-                break;
+                return this.parseRoomPlayersUpdate(payload, compact);
+            case 0x18: // ROOM_LIST_DELTA
+                return this.parseRoomListDelta(payload);
+            case 0x1B: // ROOM_PLAYER_DELTA (ghép vào danh sách trong handleWebSocketConnection)
+                return this.parseRoomPlayerDelta(payload);
+            case 0x53: // HELLO_ACK
+                return payload.length >= codec.maxSize('hello')
+                    ? codec.decode('hello', payload)
+                    : { version: 1, caps: 0 };
             case 0x23: // DRAW_BROADCAST
-                parsedData = this.parseDrawBroadcast(payload);
-                break;
+                return this.parseDrawBroadcast(payload);
             case 0x20: // GAME_START
                 Logger.info(`[Gateway] Received GAME_START, payload length: ${payload.length}`);
-                parsedData = this.parseGameStart(payload);
-                if (parsedData.error) {
-                    Logger.error(`[Gateway] Error parsing GAME_START: ${parsedData.error}`);
-                }
-                break;
+                return this.parseGameStart(payload, compact);
             case 0x25: // CORRECT_GUESS
-                parsedData = this.parseCorrectGuess(payload);
-                break;
+                return this.parseCorrectGuess(payload, compact);
             case 0x26: // WRONG_GUESS
-                parsedData = this.parseWrongGuess(payload);
-                break;
+                return this.parseWrongGuess(payload);
             case 0x27: // ROUND_END
-                parsedData = this.parseRoundEnd(payload);
-                break;
+                return this.parseRoundEnd(payload, compact);
             case 0x28: // GAME_END
-                parsedData = this.parseGameEnd(payload);
-                break;
+                return this.parseGameEnd(payload);
             case 0x2A: // TIMER_UPDATE
-                parsedData = this.parseTimerUpdate(payload);
-                break;
+                return this.parseTimerUpdate(payload);
+            case 0x55: // ROUND_DEADLINE
+                return this.parseRoundDeadline(payload);
+            case 0x56: // PING
+                return codec.decode('ping', payload);
+            case 0x57: // PONG
+                return codec.decode('pong', payload);
+            case 0x58: // ERROR (request bị từ chối, vd rate limit)
+                return codec.decode('error', payload);
+            case 0x2B: // CANVAS_SNAPSHOT (một phần, được ghép lại trong handleWebSocketConnection)
+                return this.parseCanvasSnapshotChunk(payload);
             case 0x31: // CHAT_BROADCAST
-                parsedData = this.parseChatBroadcast(payload);
-                break;
+                return this.parseChatBroadcast(payload, compact);
             case 0x41: // GAME_HISTORY_RESPONSE
-                parsedData = this.parseGameHistoryResponse(payload);
-                break;
+                return this.parseGameHistoryResponse(payload);
             case 0x50: // SERVER_SHUTDOWN
-                parsedData = { message: 'Server đang tắt. Vui lòng đăng nhập lại sau.' };
-                break;
+                return { message: 'Server đang tắt. Vui lòng đăng nhập lại sau.' };
             case 0x51: // ACCOUNT_LOGGED_IN_ELSEWHERE
-                parsedData = { message: 'Tài khoản của bạn đang được đăng nhập ở nơi khác.' };
-                break;
+                return { message: 'Tài khoản của bạn đang được đăng nhập ở nơi khác.' };
             case 0x07: // CHANGE_PASSWORD_RESPONSE
-                parsedData = this.parseChangePasswordResponse(payload);
-                break;
+                return this.parseStatusResponse(payload);
             default:
                 Logger.warn('Unknown message type from server:', type);
-                parsedData = { raw: payload.toString('hex') };
+                return { raw: payload.toString('hex') };
         }
 
-        return {
-            type: messageType,
-            data: parsedData
-        };
     }
 
     // Message type mapping
@@ -409,6 +500,8 @@ class Gateway {
             'logout': 0x05,
             'register': 0x03,
             'room_list': 0x10,
+            'lobby_subscribe': 0x19,
+            'lobby_unsubscribe': 0x1A,
             'create_room': 0x12,
             'join_room': 0x13,
             'leave_room': 0x14,
@@ -418,6 +511,9 @@ class Gateway {
             'chat_message': 0x30,
             'get_game_history': 0x40,
             'change_password': 0x06,
+            'hello': 0x52,
+            'ping': 0x56,
+            'pong': 0x57,
             // import các message khác ở đây
         };
 
@@ -439,37 +535,42 @@ class Gateway {
             0x14: 'leave_room_response',
             0x15: 'room_update',
             0x17: 'room_players_update',
+            0x18: 'room_list_delta',
+            0x1B: 'room_player_delta',
             0x20: 'game_start',
             0x25: 'correct_guess',
             0x26: 'wrong_guess',
             0x27: 'round_end',
             0x28: 'game_end',
             0x2A: 'timer_update',
+            0x55: 'round_deadline',
+            0x56: 'ping',
+            0x57: 'pong',
+            0x58: 'error',
+            0x2B: 'canvas_snapshot',
             0x23: 'draw_broadcast',
             0x41: 'game_history_response',
             0x31: 'chat_broadcast',
             0x50: 'server_shutdown',
             0x51: 'account_logged_in_elsewhere',
+            0x53: 'hello_ack',
             0x07: 'change_password_response',
             // import các message khác ở đây
         };
         return types[type] || 'unknown';
     }
 
-    // Payload creators
+    // Payload creators (layout từ gateway/codec.js, sinh từ common/schema.h)
     createLoginPayload(data) {
-        const buffer = Buffer.alloc(96); // 32 + 32 + 32 (username + password + avatar)
-        buffer.write(data.username || '', 0, 32, 'utf8');
-        buffer.write(data.password || '', 32, 32, 'utf8');
-        buffer.write(data.avatar || 'avt1.jpg', 64, 32, 'utf8'); // Thêm avatar
-        return buffer;
+        return codec.encode('login_request', {
+            username: data.username,
+            password: data.password,
+            avatar: data.avatar || 'avt1.jpg'
+        });
     }
 
     createRegisterPayload(data) {
-        const buffer = Buffer.alloc(128); // 32 + 32 + 64
-        buffer.write(data.username || '', 0, 32, 'utf8');
-        buffer.write(data.password || '', 32, 32, 'utf8');
-        return buffer;
+        return codec.encode('register_request', { username: data.username, password: data.password });
     }
 
     createLogoutPayload() {
@@ -481,25 +582,20 @@ class Gateway {
     }
 
     createCreateRoomPayload(data) {
-        // create_room_request_t: room_name(32) + max_players(1) + rounds(1) + difficulty(16) = 50 bytes
-        const buffer = Buffer.alloc(50);
-        buffer.write(data.room_name || '', 0, 32, 'utf8');
-        buffer.writeUInt8(data.max_players || 2, 32);
-        buffer.writeUInt8(data.rounds || 1, 33);
-        buffer.write(data.difficulty || 'easy', 34, 16, 'utf8');
-        return buffer;
+        return codec.encode('create_room_request', {
+            room_name: data.room_name,
+            max_players: data.max_players || 2,
+            rounds: data.rounds || 1,
+            difficulty: data.difficulty || 'easy'
+        });
     }
 
     createJoinRoomPayload(data) {
-        const buffer = Buffer.alloc(4);
-        buffer.writeInt32BE(data.room_id, 0);
-        return buffer;
+        return codec.encode('room_id', { room_id: data.room_id });
     }
 
     createLeaveRoomPayload(data) {
-        const buffer = Buffer.alloc(4);
-        buffer.writeInt32BE(data.room_id, 0);
-        return buffer;
+        return codec.encode('room_id', { room_id: data.room_id });
     }
 
     createDrawDataPayload(data) {
@@ -537,176 +633,107 @@ class Gateway {
     }
 
     createChangePasswordPayload(data) {
-        // Payload: old_password(32) + new_password(32) = 64 bytes
-        const buffer = Buffer.alloc(64);
-        buffer.write((data && data.old_password) ? String(data.old_password) : '', 0, 32, 'utf8');
-        buffer.write((data && data.new_password) ? String(data.new_password) : '', 32, 32, 'utf8');
-        return buffer;
+        return codec.encode('change_password_request', {
+            old_password: data && data.old_password,
+            new_password: data && data.new_password
+        });
     }
 
     // import các play load khác ở đây
 
     // Payload parsers
+    // Payload thiếu dữ liệu: codec ném RangeError, parseTcpMessage trả về { error: 'Invalid payload' }
     parseLoginResponse(payload) {
-        const status = payload.readUInt8(0);
-        const userId = payload.readInt32BE(1);  // NodeJS handle signed automatically
-        const username = payload.toString('utf8', 5, 37).replace(/\0/g, '');
+        const m = codec.decode('login_response', payload);
         return {
-            status: status === 0 ? 'success' : 'error',
-            userId,
-            username
+            status: m.status === 0 ? 'success' : 'error',
+            userId: m.user_id,
+            username: m.username
         };
     }
 
-    parseRegisterResponse(payload) {
-        const status = payload.readUInt8(0);
-        const message = payload.slice(1, 129).toString('utf8').replace(/\0/g, '');
-
-        return {
-            status: status === 0 ? 'success' : 'error',
-            message: message
-        };
+    // REGISTER_RESPONSE, CHANGE_PASSWORD_RESPONSE, LEAVE_ROOM_RESPONSE
+    parseStatusResponse(payload, compact = false) {
+        const m = codec.decode(compact ? 'status_response_v2' : 'status_response', payload);
+        return { status: m.status === 0 ? 'success' : 'error', message: m.message };
     }
 
-    parseChangePasswordResponse(payload) {
-        const status = payload.readUInt8(0);
-        const message = payload.slice(1, 129).toString('utf8').replace(/\0/g, '');
-
-        return {
-            status: status === 0 ? 'success' : 'error',
-            message: message
-        };
+    // Đọc một room_info tại state.offset
+    readRoomInfo(payload, state) {
+        const room = codec.read('room_info', payload, state);
+        room.owner_username = room.owner_username.trim();
+        return room;
     }
 
     parseRoomListResponse(payload) {
         const roomCount = payload.readUInt16BE(0);
+        const state = { offset: 2 };
         const rooms = [];
-        let offset = 2;
 
         for (let i = 0; i < roomCount; i++) {
-            // Read room_id as UInt32BE and convert to signed if needed
-            const room_id_raw = payload.readUInt32BE(offset);
-            const room_id = room_id_raw > 0x7FFFFFFF ? room_id_raw - 0x100000000 : room_id_raw;
-
-            const room_name = payload.slice(offset + 4, offset + 36).toString('utf8').replace(/\0/g, '');
-            const player_count = payload.readUInt8(offset + 36);
-            const max_players = payload.readUInt8(offset + 37);
-            const state = payload.readUInt8(offset + 38);
-
-            // Read owner_id similarly
-            const owner_id_raw = payload.readUInt32BE(offset + 39);
-            const owner_id = owner_id_raw > 0x7FFFFFFF ? owner_id_raw - 0x100000000 : owner_id_raw;
-
-            // Read owner_username (32 bytes)
-            const owner_username = payload.slice(offset + 43, offset + 75).toString('utf8').replace(/\0/g, '').trim();
-
-            Logger.info('Parsed room:', { room_id, room_name, owner_id, owner_username });
-            rooms.push({ room_id, room_name, player_count, max_players, state, owner_id, owner_username });
-            offset += 75; // 4 + 32 + 1 + 1 + 1 + 4 + 32 = 75 bytes
+            const room = this.readRoomInfo(payload, state);
+            Logger.info('Parsed room:', { room_id: room.room_id, room_name: room.room_name, owner_id: room.owner_id, owner_username: room.owner_username });
+            rooms.push(room);
         }
-        return { room_count: roomCount, rooms };
-    }
-
-    parseCreateRoomResponse(payload) {
-        const status = payload.readUInt8(0);
-        // C server sends htonl((uint32_t)room_id), so read as UInt32BE then convert to signed
-        const room_id_raw = payload.readUInt32BE(1);
-        const room_id = room_id_raw > 0x7FFFFFFF ? room_id_raw - 0x100000000 : room_id_raw;
-        const message = payload.slice(5, 133).toString('utf8').replace(/\0/g, '');
 
-        return { status: status === 0 ? 'success' : 'error', room_id, message };
+        // seq của danh sách ở cuối payload (server cũ không gửi)
+        const seq = payload.length >= state.offset + 4 ? payload.readUInt32BE(state.offset) : 0;
+        return { room_count: roomCount, rooms, seq };
     }
 
-    parseJoinRoomResponse(payload) {
-        const status = payload.readUInt8(0);
-        // C server sends htonl((uint32_t)room_id), so read as UInt32BE then convert to signed
-        const room_id_raw = payload.readUInt32BE(1);
-        const room_id = room_id_raw > 0x7FFFFFFF ? room_id_raw - 0x100000000 : room_id_raw;
-        const message = payload.slice(5, 133).toString('utf8').replace(/\0/g, '');
-        return { status: status === 0 ? 'success' : 'error', room_id, message };
+    // ROOM_LIST_DELTA: [seq:4][count:2] + bản ghi [op:1][room_info] (upsert) hoặc [op:1][room_id:4] (remove)
+    parseRoomListDelta(payload) {
+        if (payload.length < 6) {
+            return { error: 'Invalid room list delta' };
+        }
+        const seq = payload.readUInt32BE(0);
+        const count = payload.readUInt16BE(4);
+        const changes = [];
+        const state = { offset: 6 };
+
+        for (let i = 0; i < count && state.offset < payload.length; i++) {
+            const op = payload.readUInt8(state.offset);
+            state.offset += 1;
+            if (op === 0x01) {
+                changes.push({ op: 'upsert', room: this.readRoomInfo(payload, state) });
+            } else if (op === 0x02) {
+                changes.push({ op: 'remove', room_id: codec.read('room_id', payload, state).room_id });
+            } else {
+                return { error: `Invalid room list delta record op=${op}` };
+            }
+        }
+        return { seq, changes };
     }
 
-    parseLeaveRoomResponse(payload) {
-        const status = payload.readUInt8(0);
-        const message = payload.slice(1, 129).toString('utf8').replace(/\0/g, '');
-        return { status: status === 0 ? 'success' : 'error', message };
+    // CREATE_ROOM_RESPONSE, JOIN_ROOM_RESPONSE
+    parseRoomResponse(payload, compact = false) {
+        const m = codec.decode(compact ? 'room_response_v2' : 'room_response', payload);
+        return { status: m.status === 0 ? 'success' : 'error', room_id: m.room_id, message: m.message };
     }
 
     parseRoomUpdate(payload) {
-        // room_info_protocol_t structure
-        const room_id_raw = payload.readUInt32BE(0);
-        const room_id = room_id_raw > 0x7FFFFFFF ? room_id_raw - 0x100000000 : room_id_raw;
-
-        const room_name = payload.slice(4, 36).toString('utf8').replace(/\0/g, '');
-        const player_count = payload.readUInt8(36);
-        const max_players = payload.readUInt8(37);
-        const state = payload.readUInt8(38);
-
-        const owner_id_raw = payload.readUInt32BE(39);
-        const owner_id = owner_id_raw > 0x7FFFFFFF ? owner_id_raw - 0x100000000 : owner_id_raw;
-
-        // Read owner_username (32 bytes)
-        const owner_username = payload.slice(43, 75).toString('utf8').replace(/\0/g, '');
-
-        return { room_id, room_name, player_count, max_players, state, owner_id, owner_username };
+        return codec.decode('room_info', payload);
     }
 
-    parseRoomPlayersUpdate(payload) {
-        let offset = 0;
-
-        // room_players_update_t structure
-        const room_id_raw = payload.readUInt32BE(offset);
-        const room_id = room_id_raw > 0x7FFFFFFF ? room_id_raw - 0x100000000 : room_id_raw;
-        offset += 4;
-
-        const room_name = payload.slice(offset, offset + 32).toString('utf8').replace(/\0/g, '');
-        offset += 32;
-
-        const max_players = payload.readUInt8(offset++);
-        const state = payload.readUInt8(offset++);
-
-        const owner_id_raw = payload.readUInt32BE(offset);
-        const owner_id = owner_id_raw > 0x7FFFFFFF ? owner_id_raw - 0x100000000 : owner_id_raw;
-        offset += 4;
-
-        const action = payload.readUInt8(offset++); // 0 = JOIN, 1 = LEAVE
-
-        const changed_user_id_raw = payload.readUInt32BE(offset);
-        const changed_user_id = changed_user_id_raw > 0x7FFFFFFF ? changed_user_id_raw - 0x100000000 : changed_user_id_raw;
-        offset += 4;
-
-        const changed_username = payload.slice(offset, offset + 32).toString('utf8').replace(/\0/g, '');
-        offset += 32;
+    parseRoomPlayersUpdate(payload, compact = false) {
+        const state = { offset: 0 };
+        const header = codec.read(compact ? 'room_players_header_v2' : 'room_players_header', payload, state);
+        const { room_id, room_name, max_players, state: room_state, owner_id, action, changed_user_id, changed_username, player_count } = header;
 
-        const player_count = payload.readUInt16BE(offset);
-        offset += 2;
-
-        // Parse players list
         const players = [];
         for (let i = 0; i < player_count; i++) {
-            const user_id_raw = payload.readUInt32BE(offset);
-            const user_id = user_id_raw > 0x7FFFFFFF ? user_id_raw - 0x100000000 : user_id_raw;
-            offset += 4;
-
-            const username = payload.slice(offset, offset + 32).toString('utf8').replace(/\0/g, '');
-            offset += 32;
-
-            const avatar = payload.slice(offset, offset + 32).toString('utf8').replace(/\0/g, '') || 'avt1.jpg';
-            offset += 32;
-
-            const is_owner = payload.readUInt8(offset++);
-            const is_active = payload.readUInt8(offset++); // 1 = active, 0 = đang chờ, 255 = đã rời phòng
-
-            players.push({ user_id, username, avatar, is_owner, is_active });
+            const player = codec.read(compact ? 'player_info_v2' : 'player_info', payload, state);
+            player.avatar = player.avatar || 'avt1.jpg';
+            players.push(player); // is_active: 1 = active, 0 = đang chờ, 255 = đã rời phòng
         }
 
-        Logger.info('room infor and data players:', { room_id, room_name, max_players, state, owner_id, action, changed_user_id, changed_username, player_count, players });
+        Logger.info('room infor and data players:', { room_id, room_name, max_players, state: room_state, owner_id, action, changed_user_id, changed_username, player_count, players });
 
         return {
             room_id,
             room_name,
             max_players,
-            state,
+            state: room_state,
             owner_id,
             action, // 0 = JOIN, 1 = LEAVE
             changed_user_id,
@@ -716,6 +743,51 @@ class Gateway {
         };
     }
 
+    // ROOM_PLAYER_DELTA luôn dùng chuỗi gọn (chỉ gửi cho client CAP_PLAYER_DELTA)
+    parseRoomPlayerDelta(payload) {
+        return codec.decode('room_player_delta', payload);
+    }
+
+    parseCanvasSnapshotChunk(payload) {
+        if (payload.length < 12) {
+            Logger.warn('CANVAS_SNAPSHOT payload too short');
+            return { error: 'Invalid payload' };
+        }
+
+        return {
+            room_id: payload.readInt32BE(0),
+            total_len: payload.readUInt32BE(4),
+            offset: payload.readUInt32BE(8),
+            data: payload.slice(12)
+        };
+    }
+
+    // Snapshot: [width:2][height:2][palette_count:2][palette: RGBA x palette_count][zstd frame]
+    // Dữ liệu pixel (chỉ số màu) giữ nguyên dạng nén zstd, frontend tự giải nén
+    parseCanvasSnapshot(roomId, snapshot) {
+        if (snapshot.length < 6) {
+            return { error: 'Invalid snapshot' };
+        }
+
+        const width = snapshot.readUInt16BE(0);
+        const height = snapshot.readUInt16BE(2);
+        const paletteCount = snapshot.readUInt16BE(4);
+        const palette = [];
+        let offset = 6;
+        for (let i = 0; i < paletteCount && offset + 4 <= snapshot.length; i++) {
+            palette.push(snapshot.readUInt32BE(offset));
+            offset += 4;
+        }
+
+        return {
+            room_id: roomId,
+            width,
+            height,
+            palette,
+            pixels_zstd: snapshot.slice(offset).toString('base64')
+        };
+    }
+
     parseDrawBroadcast(payload) {
         if (payload.length < 14) {
             Logger.warn('DRAW_BROADCAST payload too short');
@@ -751,75 +823,36 @@ class Gateway {
     // --------------------------
     // Game payload parsers
     // --------------------------
-    parseGameStart(payload) {
-        // drawer_id(4) + word_length(1) + time_limit(2) + round_start_ms(8) 
-        // + current_round(4) + player_count(1) + total_rounds(1) + word(64) + category(64) = 149 bytes
-        Logger.info(`[Gateway] parseGameStart: payload length=${payload.length}, expected=149`);
-        if (payload.length < 85) {
-            Logger.warn(`[Gateway] GAME_START payload too short: ${payload.length} < 85`);
-            Logger.warn(`[Gateway] Payload hex: ${payload.toString('hex').substring(0, 100)}...`);
-            return { error: 'Invalid payload' };
-        }
-        const drawer_id_raw = payload.readUInt32BE(0);
-        const drawer_id = drawer_id_raw > 0x7FFFFFFF ? drawer_id_raw - 0x100000000 : drawer_id_raw;
-        const word_length = payload.readUInt8(4);
-        const time_limit = payload.readUInt16BE(5);
-        let round_start_ms = 0;
-        try {
-            round_start_ms = Number(payload.readBigUInt64BE(7));
-        } catch (_) {
-            // fallback (older node)
-            const hi = payload.readUInt32BE(7);
-            const lo = payload.readUInt32BE(11);
-            round_start_ms = hi * 4294967296 + lo;
-        }
-        const current_round_raw = payload.readUInt32BE(15);
-        const current_round = current_round_raw > 0x7FFFFFFF ? current_round_raw - 0x100000000 : current_round_raw;
-        const player_count = payload.readUInt8(19);
-        const total_rounds = payload.readUInt8(20);
-        const word = payload.slice(21, 85).toString('utf8').replace(/\0/g, '');
-        // Parse category (64 bytes starting at offset 85)
-        let category = '';
-        if (payload.length >= 149) {
-            category = payload.slice(85, 149).toString('utf8').replace(/\0/g, '');
-        }
-        Logger.info(`[Gateway] Parsed GAME_START: current_round=${current_round}, player_count=${player_count}, total_rounds=${total_rounds}, category=${category}`);
-        return { drawer_id, word_length, time_limit, round_start_ms, current_round, player_count, total_rounds, word, category };
+    parseGameStart(payload, compact = false) {
+        Logger.info(`[Gateway] parseGameStart: payload length=${payload.length}, max=${codec.maxSize('game_start')}`);
+        const m = codec.decode(compact ? 'game_start_v2' : 'game_start', payload);
+        Logger.info(`[Gateway] Parsed GAME_START: current_round=${m.current_round}, player_count=${m.player_count}, total_rounds=${m.total_rounds}, category=${m.category}`);
+        return m;
     }
 
     parseTimerUpdate(payload) {
-        // Payload: time_left(2 bytes) - thời gian còn lại tính bằng giây
-        if (payload.length < 2) {
-            Logger.warn('[Gateway] TIMER_UPDATE payload too short');
-            return { error: 'Invalid payload' };
-        }
-        const time_left = payload.readUInt16BE(0);
-        return { time_left };
-    }
-
-    parseCorrectGuess(payload) {
-        // player_id(4) + word(64) + guesser_points(2) + drawer_points(2) + username(32) = 104 bytes
-        if (payload.length < 104) {
-            // Fallback cho payload cũ (72 bytes) nếu server chưa update
-            if (payload.length >= 72) {
-                const player_id_raw = payload.readUInt32BE(0);
-                const player_id = player_id_raw > 0x7FFFFFFF ? player_id_raw - 0x100000000 : player_id_raw;
-                const word = payload.slice(4, 68).toString('utf8').replace(/\0/g, '');
-                const guesser_points = payload.readUInt16BE(68);
-                const drawer_points = payload.readUInt16BE(70);
-                return { player_id, word, points: guesser_points, guesser_points, drawer_points, username: null };
-            }
-            Logger.warn('CORRECT_GUESS payload too short');
-            return { error: 'Invalid payload' };
-        }
-        const player_id_raw = payload.readUInt32BE(0);
-        const player_id = player_id_raw > 0x7FFFFFFF ? player_id_raw - 0x100000000 : player_id_raw;
-        const word = payload.slice(4, 68).toString('utf8').replace(/\0/g, '');
-        const guesser_points = payload.readUInt16BE(68);
-        const drawer_points = payload.readUInt16BE(70);
-        const username = payload.slice(72, 104).toString('utf8').replace(/\0/g, '').trim();
-        Logger.info(`[Gateway] Parsed CORRECT_GUESS: player_id=${player_id}, username="${username}", points=${guesser_points}`);
-        return { player_id, word, points: guesser_points, guesser_points, drawer_points, username: username || null };
+        // time_left: thời gian còn lại tính bằng giây
+        return codec.decode('timer_update', payload);
+    }
+
+    // Hạn chót theo đồng hồ monotonic của server -> đổi sang Date.now() của gateway
+    parseRoundDeadline(payload) {
+        const m = codec.decode('round_deadline', payload);
+        const time_left_ms = Math.max(0, m.deadline_ms - m.server_now_ms);
+        return { time_left_ms, deadline_ms: Date.now() + time_left_ms };
+    }
+
+    parseCorrectGuess(payload, compact = false) {
+        const m = codec.decode(compact ? 'correct_guess_v2' : 'correct_guess', payload);
+        Logger.info(`[Gateway] Parsed CORRECT_GUESS: player_id=${m.player_id}, username="${m.username}", points=${m.guesser_points}`);
+        return {
+            player_id: m.player_id,
+            word: m.word,
+            points: m.guesser_points,
+            guesser_points: m.guesser_points,
+            drawer_points: m.drawer_points,
+            username: m.username.trim() || null
+        };
     }
 
     parseWrongGuess(payload) {
@@ -834,99 +867,39 @@ class Gateway {
         return { player_id, guess };
     }
 
-    parseRoundEnd(payload) {
-        // word(64) + score_count(2) + pairs(user_id(4), score(4))...
-        if (payload.length < 66) {
-            Logger.warn('ROUND_END payload too short');
-            return { error: 'Invalid payload' };
-        }
-        const word = payload.slice(0, 64).toString('utf8').replace(/\0/g, '');
-        const score_count = payload.readUInt16BE(64);
-        let offset = 66;
+    // Danh sách score_entry nối sau header
+    readScores(payload, state, count) {
         const scores = [];
-        for (let i = 0; i < score_count; i++) {
-            if (offset + 8 > payload.length) break;
-            const uid_raw = payload.readUInt32BE(offset);
-            const user_id = uid_raw > 0x7FFFFFFF ? uid_raw - 0x100000000 : uid_raw;
-            const score_raw = payload.readUInt32BE(offset + 4);
-            const score = score_raw > 0x7FFFFFFF ? score_raw - 0x100000000 : score_raw;
-            scores.push({ user_id, score });
-            offset += 8;
+        for (let i = 0; i < count; i++) {
+            scores.push(codec.read('score_entry', payload, state));
         }
-        return { word, score_count, scores };
+        return scores;
+    }
+
+    parseRoundEnd(payload, compact = false) {
+        const state = { offset: 0 };
+        const { word, score_count } = codec.read(compact ? 'round_end_header_v2' : 'round_end_header', payload, state);
+        return { word, score_count, scores: this.readScores(payload, state, score_count) };
     }
 
     parseGameEnd(payload) {
-        // winner_id(4) + score_count(2) + pairs(user_id(4), score(4))...
-        if (payload.length < 6) {
-            Logger.warn('GAME_END payload too short');
-            return { error: 'Invalid payload' };
-        }
-        const winner_id_raw = payload.readUInt32BE(0);
-        const winner_id = winner_id_raw > 0x7FFFFFFF ? winner_id_raw - 0x100000000 : winner_id_raw;
-        const score_count = payload.readUInt16BE(4);
-        let offset = 6;
-        const scores = [];
-        for (let i = 0; i < score_count; i++) {
-            if (offset + 8 > payload.length) break;
-            const uid_raw = payload.readUInt32BE(offset);
-            const user_id = uid_raw > 0x7FFFFFFF ? uid_raw - 0x100000000 : uid_raw;
-            const score_raw = payload.readUInt32BE(offset + 4);
-            const score = score_raw > 0x7FFFFFFF ? score_raw - 0x100000000 : score_raw;
-            scores.push({ user_id, score });
-            offset += 8;
-        }
-        return { winner_id, score_count, scores };
+        const state = { offset: 0 };
+        const { winner_id, score_count } = codec.read('game_end_header', payload, state);
+        return { winner_id, score_count, scores: this.readScores(payload, state, score_count) };
     }
 
-    parseChatBroadcast(payload) {
-        // username(32) + message(256) + timestamp(8)
-        if (payload.length < 296) {
-            Logger.warn('CHAT_BROADCAST payload too short');
-            return { error: 'Invalid payload' };
-        }
-        const username = payload.slice(0, 32).toString('utf8').replace(/\0/g, '');
-        const message = payload.slice(32, 288).toString('utf8').replace(/\0/g, '');
-        let timestamp = 0;
-        try {
-            timestamp = Number(payload.readBigUInt64BE(288));
-        } catch (_) {
-            const hi = payload.readUInt32BE(288);
-            const lo = payload.readUInt32BE(292);
-            timestamp = hi * 4294967296 + lo;
-        }
-        return { username, message, timestamp };
+    parseChatBroadcast(payload, compact = false) {
+        return codec.decode(compact ? 'chat_broadcast_v2' : 'chat_broadcast', payload);
     }
 
     parseGameHistoryResponse(payload) {
-        // count(2) + entries (score(4) + rank(4) + finished_at(32)) * count
-        if (payload.length < 2) {
-            Logger.warn('GAME_HISTORY_RESPONSE payload too short');
-            return { error: 'Invalid payload', history: [] };
-        }
-        
-        const count = payload.readUInt16BE(0);
+        const state = { offset: 0 };
+        const { count } = codec.read('history_header', payload, state);
         const history = [];
-        let offset = 2;
-        
         for (let i = 0; i < count; i++) {
-            if (offset + 40 > payload.length) break;
-            
-            // Read score (4 bytes, signed int32)
-            const score_raw = payload.readUInt32BE(offset);
-            const score = score_raw > 0x7FFFFFFF ? score_raw - 0x100000000 : score_raw;
-            
-            // Read rank (4 bytes, signed int32)
-            const rank_raw = payload.readUInt32BE(offset + 4);
-            const rank = rank_raw > 0x7FFFFFFF ? rank_raw - 0x100000000 : rank_raw;
-            
-            // Read finished_at (32 bytes, null-terminated string)
-            const finished_at = payload.slice(offset + 8, offset + 40).toString('utf8').replace(/\0/g, '');
-            
-            history.push({ score, rank, finished_at });
-            offset += 40;
+            history.push(codec.read('history_entry', payload, state));
         }
-        
+
         Logger.info(`[Gateway] Parsed game history: ${count} entries`);
         return { history };
     }
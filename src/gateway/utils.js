@@ -1,3 +1,31 @@
+// Frame mở rộng: [TYPE:1][0xFFFF][LENGTH:4][PAYLOAD] cho payload >= 0xFFFF bytes
+const EXTENDED_LENGTH_MARKER = 0xFFFF;
+const MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+
+// Đọc header frame, trả về null nếu chưa đủ byte header
+function readFrameHeader(buffer) {
+    if (buffer.length < 3) {
+        return null;
+    }
+    const type = buffer.readUInt8(0);
+    let length = buffer.readUInt16BE(1);
+    let headerLength = 3;
+    if (length === EXTENDED_LENGTH_MARKER) {
+        if (buffer.length < 7) {
+            return null;
+        }
+        length = buffer.readUInt32BE(3);
+        headerLength = 7;
+        if (length > MAX_PAYLOAD_SIZE) {
+            throw new Error(`Frame too large: ${length} bytes`);
+        }
+    }
+    return { type, length, headerLength };
+}
+
+// Capability chuỗi gọn (CAP_COMPACT_STRINGS trong common/protocol.h)
+const CAP_COMPACT_STRINGS = 1 << 3;
+
 // Message buffer để xử lý TCP messages có thể bị phân mảnh
 class MessageBuffer {
     constructor() {
@@ -13,9 +41,12 @@ class MessageBuffer {
         const messages = [];
         
         while (this.buffer.length >= 3) {
-            const type = this.buffer.readUInt8(0);
-            const length = this.buffer.readUInt16BE(1);
-            const totalLength = 3 + length;
+            const header = readFrameHeader(this.buffer);
+            if (!header) {
+                break;
+            }
+            const { type, length } = header;
+            const totalLength = header.headerLength + length;
             
             Logger.debug(`[MessageBuffer] Checking message: type=0x${type.toString(16)}, length=${length}, total=${totalLength}, buffer=${this.buffer.length}`);
             
@@ -42,6 +73,105 @@ class MessageBuffer {
     }
 }
 
+// Ghép các frame CANVAS_SNAPSHOT (0x2B) thành một snapshot hoàn chỉnh
+// Mỗi frame: [room_id:4][total_len:4][offset:4][data]
+class CanvasSnapshotAssembler {
+    constructor() {
+        this.reset();
+    }
+
+    reset() {
+        this.roomId = -1;
+        this.buffer = null;
+        this.received = 0;
+    }
+
+    // Trả về snapshot đã ghép (Buffer) khi nhận đủ, null nếu còn thiếu
+    add(chunk) {
+        if (!this.buffer || this.roomId !== chunk.room_id ||
+            this.buffer.length !== chunk.total_len || chunk.offset === 0) {
+            this.roomId = chunk.room_id;
+            this.buffer = Buffer.alloc(chunk.total_len);
+            this.received = 0;
+        }
+
+        if (chunk.offset + chunk.data.length > this.buffer.length) {
+            Logger.warn('[CanvasSnapshot] Chunk vượt quá total_len, bỏ qua snapshot');
+            this.reset();
+            return null;
+        }
+
+        chunk.data.copy(this.buffer, chunk.offset);
+        this.received += chunk.data.length;
+
+        if (this.received < this.buffer.length) {
+            return null;
+        }
+
+        const snapshot = this.buffer;
+        this.reset();
+        return snapshot;
+    }
+}
+
+// Giữ danh sách người chơi đầy đủ của phòng hiện tại để áp dụng ROOM_PLAYER_DELTA (0x1B)
+// Frontend vẫn nhận room_players_update với danh sách đầy đủ như trước
+class RoomRosterCache {
+    constructor() {
+        this.roster = null; // Bản room_players_update gần nhất
+    }
+
+    setFull(update) {
+        this.roster = {
+            ...update,
+            players: update.players.map(player => ({ ...player }))
+        };
+    }
+
+    // Trả về room_players_update đầy đủ sau khi áp dụng delta, null nếu chưa có danh sách của phòng
+    applyDelta(delta) {
+        if (!this.roster || this.roster.room_id !== delta.room_id) {
+            Logger.warn(`[RoomRoster] Nhận delta phòng ${delta.room_id} nhưng chưa có danh sách đầy đủ`);
+            return null;
+        }
+
+        const roster = this.roster;
+        let players = roster.players.filter(player => player.user_id !== delta.user_id);
+        const previous = roster.players.find(player => player.user_id === delta.user_id);
+
+        // JOIN, hoặc LEAVE trong lúc chơi (vẫn hiển thị ở bảng điểm với is_active = 255)
+        if (delta.action === 0 || delta.is_active === 255) {
+            const index = roster.players.findIndex(player => player.user_id === delta.user_id);
+            const player = {
+                user_id: delta.user_id,
+                username: delta.username || (previous && previous.username) || '',
+                avatar: delta.avatar || (previous && previous.avatar) || 'avt1.jpg',
+                is_owner: 0,
+                is_active: delta.is_active
+            };
+            if (index >= 0) {
+                players.splice(index, 0, player);
+            } else {
+                players.push(player);
+            }
+        }
+
+        players = players.map(player => ({ ...player, is_owner: player.user_id === delta.owner_id ? 1 : 0 }));
+
+        this.roster = {
+            ...roster,
+            state: delta.state,
+            owner_id: delta.owner_id,
+            action: delta.action,
+            changed_user_id: delta.user_id,
+            changed_username: delta.username || (previous && previous.username) || '',
+            player_count: players.length,
+            players
+        };
+        return this.roster;
+    }
+}
+
 // Logger với màu sắc
 class Logger {
     static info(message, ...args) {
@@ -235,6 +365,10 @@ class PerformanceMonitor {
 
 module.exports = {
     MessageBuffer,
+    CanvasSnapshotAssembler,
+    RoomRosterCache,
+    readFrameHeader,
+    CAP_COMPACT_STRINGS,
     Logger,
     TcpConnectionManager,
     MessageValidator,
@@ -0,0 +1,93 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "drawing.h"
+
+// Canvas raster phía server (tùy chọn, mỗi phòng một canvas)
+// Mỗi pixel lưu 1 byte chỉ số màu trong bảng palette, index 0 = nền (đã xóa)
+#define CANVAS_PALETTE_SIZE 256
+#define CANVAS_BACKGROUND_INDEX 0
+#define CANVAS_SNAPSHOT_ZSTD_LEVEL 3
+
+// Kích thước header snapshot trước dữ liệu zstd (không tính palette)
+// [width:2][height:2][palette_count:2]
+#define CANVAS_SNAPSHOT_HEADER_SIZE 6
+
+typedef struct canvas {
+    uint16_t width;
+    uint16_t height;
+    uint8_t *pixels;                         // width * height chỉ số màu
+    uint32_t palette[CANVAS_PALETTE_SIZE];   // Màu RGBA tương ứng từng chỉ số
+    int palette_count;                       // Số màu đang dùng (bao gồm index 0)
+    uint32_t stroke_count;                   // Số nét đã vẽ kể từ lần clear gần nhất
+    uint8_t *snapshot;                       // Snapshot đã nén (cache), NULL nếu chưa tạo
+    size_t snapshot_len;
+    bool snapshot_dirty;                     // true nếu có nét mới sau lần tạo snapshot
+} canvas_t;
+
+/**
+ * Tạo canvas mới, toàn bộ pixel là nền
+ * @param width Chiều rộng (1..MAX_CANVAS_WIDTH)
+ * @param height Chiều cao (1..MAX_CANVAS_HEIGHT)
+ * @return Con trỏ đến canvas_t nếu thành công, NULL nếu thất bại
+ */
+canvas_t *canvas_create(uint16_t width, uint16_t height);
+
+/**
+ * Hủy canvas và giải phóng bộ nhớ (kể cả snapshot cache)
+ * @param canvas Con trỏ đến canvas_t
+ */
+void canvas_destroy(canvas_t *canvas);
+
+/**
+ * Xóa toàn bộ canvas về nền và reset palette
+ * @param canvas Con trỏ đến canvas_t
+ */
+void canvas_clear(canvas_t *canvas);
+
+/**
+ * Lấy chỉ số màu trong palette cho màu RGBA, thêm mới nếu chưa có.
+ * Khi palette đầy, trả về chỉ số của màu gần nhất.
+ * @param canvas Con trỏ đến canvas_t
+ * @param color Màu RGBA
+ * @return Chỉ số màu (1..CANVAS_PALETTE_SIZE-1)
+ */
+uint8_t canvas_color_index(canvas_t *canvas, uint32_t color);
+
+/**
+ * Vẽ đoạn thẳng có độ dày (hình viên thuốc) bằng cách tô từng hàng ngang.
+ * Mỗi hàng chỉ tính một khoảng [x_start, x_end] rồi memset, nên vòng lặp
+ * trong cùng là thao tác ghi liên tục trên bộ nhớ.
+ * @param canvas Con trỏ đến canvas_t
+ * @param x1, y1 Điểm bắt đầu
+ * @param x2, y2 Điểm kết thúc
+ * @param width Độ rộng bút (pixel)
+ * @param color_index Chỉ số màu cần tô
+ */
+void canvas_draw_line(canvas_t *canvas, int x1, int y1, int x2, int y2,
+                      uint8_t width, uint8_t color_index);
+
+/**
+ * Áp dụng một hành động vẽ lên canvas (LINE, ERASE, CLEAR; MOVE bị bỏ qua)
+ * @param canvas Con trỏ đến canvas_t
+ * @param action Hành động vẽ đã được validate
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int canvas_apply_action(canvas_t *canvas, const draw_action_t *action);
+
+/**
+ * Lấy snapshot đã nén của canvas. Snapshot được cache và chỉ nén lại
+ * khi có nét vẽ mới kể từ lần gọi trước.
+ * Format: [width:2][height:2][palette_count:2][palette: palette_count x RGBA:4][zstd frame]
+ * (tất cả số nguyên ở network byte order, zstd frame chứa width*height chỉ số màu)
+ * @param canvas Con trỏ đến canvas_t
+ * @param data_out Con trỏ nhận địa chỉ snapshot (thuộc sở hữu của canvas)
+ * @param len_out Con trỏ nhận độ dài snapshot
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int canvas_get_snapshot(canvas_t *canvas, const uint8_t **data_out, size_t *len_out);
+
+#endif // CANVAS_H
@@ -0,0 +1,176 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Ghi lại traffic vào server (--capture=FILE) để phát lại bằng bench/replay.c
+//
+// File: [magic "DGCAP":5][version:1][flags:1][reserved:1][start_wall_ms:8 BE]
+// rồi các bản ghi liên tiếp, số nguyên kiểu varint LEB128 (7 bit/byte, byte thấp trước):
+//   [kind:1][session:varint][dt_us:varint] + phần riêng
+//   CAPTURE_FRAME: [type:1][len:varint][payload:len]
+//   CAPTURE_ROOM:  [room_id:varint]
+// dt_us là khoảng cách (µs) so với bản ghi trước nên file tăng ~3 byte/frame ngoài payload.
+// session là số phiên tăng dần từ 1, không tái sử dụng như chỉ số client của server.
+#define CAPTURE_MAGIC               "DGCAP"
+#define CAPTURE_MAGIC_LEN           5
+#define CAPTURE_VERSION             1
+#define CAPTURE_HEADER_SIZE         16
+#define CAPTURE_FLAG_ANONYMIZED     0x01    // Username/email/chat/tên phòng đã được thay thế
+#define CAPTURE_MAX_SLOTS           1024    // >= MAX_CLIENTS của server
+#define CAPTURE_REPLAY_PASSWORD     "replay123"     // Thay mọi mật khẩu trong capture (có chữ và số như auth yêu cầu)
+
+typedef enum {
+    CAPTURE_OPEN = 1,               // Client kết nối
+    CAPTURE_FRAME,                  // Một frame client gửi lên (trước khi dispatch)
+    CAPTURE_CLOSE,                  // Client ngắt kết nối
+    CAPTURE_ROOM                    // Ghi chú: CREATE_ROOM của phiên này tạo ra room_id (để ánh xạ khi phát lại)
+} capture_kind_t;
+
+typedef struct {
+    capture_kind_t kind;
+    uint32_t session;
+    uint64_t t_us;                  // Thời điểm kể từ lúc bắt đầu capture
+    uint8_t type;                   // CAPTURE_FRAME
+    uint32_t len;
+    const uint8_t *payload;         // Trỏ vào buffer của reader, hợp lệ đến lần đọc kế tiếp
+    int32_t room_id;                // CAPTURE_ROOM
+} capture_record_t;
+
+typedef struct {
+    FILE *f;
+    uint64_t last_t_us;
+    uint64_t records;
+    int failed;                     // 1 nếu fwrite lỗi (đĩa đầy...), các bản ghi sau bị bỏ
+} capture_writer_t;
+
+typedef struct {
+    FILE *f;
+    uint8_t version;
+    uint8_t flags;
+    uint64_t start_wall_ms;
+    uint64_t t_us;
+    uint8_t *buf;                   // Payload của bản ghi hiện tại
+    size_t capacity;
+} capture_reader_t;
+
+// Khóa ẩn danh: salt ngẫu nhiên chỉ nằm trong bộ nhớ, cùng một username cho cùng
+// một bí danh trong một capture nhưng không thể tra ngược bằng từ điển tên
+typedef struct {
+    uint8_t salt[16];
+} capture_anonymizer_t;
+
+/**
+ * Tạo file capture và ghi header
+ * @param w Writer
+ * @param path Đường dẫn file (ghi đè nếu đã có)
+ * @param flags CAPTURE_FLAG_*
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int capture_writer_open(capture_writer_t *w, const char *path, uint8_t flags);
+
+/**
+ * Ghi một bản ghi (t_us phải không giảm)
+ * @param w Writer
+ * @param rec Bản ghi
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int capture_writer_write(capture_writer_t *w, const capture_record_t *rec);
+
+/**
+ * Flush và đóng file
+ * @param w Writer
+ * @return 0 nếu thành công, -1 nếu có lỗi ghi trong suốt capture
+ */
+int capture_writer_close(capture_writer_t *w);
+
+/**
+ * Mở file capture và kiểm tra header
+ * @param r Reader
+ * @param path Đường dẫn file
+ * @return 0 nếu thành công, -1 nếu lỗi (không phải capture hoặc khác phiên bản)
+ */
+int capture_reader_open(capture_reader_t *r, const char *path);
+
+/**
+ * Đọc bản ghi tiếp theo
+ * @param r Reader
+ * @param rec Bản ghi đọc được
+ * @return 1 nếu có bản ghi, 0 nếu hết file, -1 nếu file hỏng/cắt cụt
+ */
+int capture_reader_next(capture_reader_t *r, capture_record_t *rec);
+
+/**
+ * Đóng reader
+ * @param r Reader
+ */
+void capture_reader_close(capture_reader_t *r);
+
+/**
+ * Khởi tạo khóa ẩn danh với salt ngẫu nhiên (/dev/urandom, dự phòng thời gian + pid)
+ * @param a Khóa ẩn danh
+ */
+void capture_anonymizer_init(capture_anonymizer_t *a);
+
+/**
+ * Xóa dữ liệu nhạy cảm khỏi payload một frame client, tại chỗ, giữ nguyên độ dài
+ * Mật khẩu (LOGIN/REGISTER/CHANGE_PASSWORD) luôn được thay bằng CAPTURE_REPLAY_PASSWORD.
+ * Với a != NULL: username -> "u_<hash>", email -> "<hash>@example.invalid",
+ * tên phòng -> "room_<hash>", nội dung chat/đoán từ -> chữ giả cùng độ dài (giữ khoảng trắng).
+ * @param a Khóa ẩn danh, NULL = chỉ xóa mật khẩu
+ * @param type Loại message
+ * @param payload Payload
+ * @param len Độ dài payload
+ */
+void capture_scrub(const capture_anonymizer_t *a, uint8_t type, uint8_t *payload, size_t len);
+
+/**
+ * Bắt đầu capture phía server (trạng thái toàn cục của module)
+ * @param path Đường dẫn file
+ * @param anonymize 1 = ẩn danh username/chat/tên phòng, 0 = chỉ xóa mật khẩu
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int capture_start(const char *path, int anonymize);
+
+/**
+ * Capture có đang bật không
+ * @return 1 nếu đang ghi
+ */
+int capture_active(void);
+
+/**
+ * Ghi bản ghi CAPTURE_OPEN và gán số phiên mới cho slot client
+ * @param client_index Chỉ số client trên server
+ */
+void capture_session_open(int client_index);
+
+/**
+ * Ghi bản ghi CAPTURE_CLOSE cho slot client
+ * @param client_index Chỉ số client trên server
+ */
+void capture_session_close(int client_index);
+
+/**
+ * Ghi một frame client gửi lên (payload được sao chép trước khi xóa dữ liệu nhạy cảm)
+ * @param client_index Chỉ số client trên server
+ * @param type Loại message
+ * @param payload Payload
+ * @param len Độ dài payload
+ */
+void capture_frame(int client_index, uint8_t type, const uint8_t *payload, uint32_t len);
+
+/**
+ * Ghi chú phòng vừa được tạo bởi client (CREATE_ROOM thành công)
+ * @param client_index Chỉ số client trên server
+ * @param room_id ID phòng server cấp
+ */
+void capture_room_created(int client_index, int room_id);
+
+/**
+ * Dừng capture, flush và đóng file
+ */
+void capture_stop(void);
+
+#endif // CAPTURE_H
@@ -0,0 +1,62 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <stdint.h>
+
+// Chu kỳ server gửi PING cho client CAP_PING
+#define CLOCKSYNC_PING_INTERVAL_MS  5000
+
+// Thống kê RTT và lệch đồng hồ của một client, cập nhật từ mỗi cặp PING/PONG
+typedef struct {
+    uint32_t ping_seq;          // Seq của PING server gửi gần nhất
+    uint64_t ping_sent_ms;      // Thời điểm gửi PING đang chờ (monotonic, đo RTT), 0 = không chờ
+    uint64_t ping_origin_ms;    // origin_ms của PING đang chờ (đồng hồ thực epoch, tính lệch đồng hồ)
+    uint64_t next_ping_ms;      // Lần gửi PING tiếp theo
+    uint32_t rtt_ms;            // Mẫu RTT gần nhất
+    uint32_t srtt_ms;           // RTT làm mượt (EWMA 1/8 như TCP)
+    uint32_t rttvar_ms;         // Độ dao động RTT (EWMA 1/4)
+    uint32_t min_rtt_ms;
+    int64_t offset_ms;          // Đồng hồ thực client - đồng hồ thực server (từ mẫu có RTT thấp)
+    uint32_t samples;           // Số PONG hợp lệ
+    uint32_t lost;              // Số PING không có PONG trước lần gửi tiếp theo
+} clocksync_t;
+
+/**
+ * Đặt lại thống kê (client mới kết nối)
+ * @param cs Thống kê của client
+ */
+void clocksync_reset(clocksync_t *cs);
+
+/**
+ * Ghi nhận một PING sắp gửi; PING trước chưa có PONG được tính là mất
+ * RTT đo bằng đồng hồ monotonic, còn lệch đồng hồ so với client phải dùng đồng hồ thực ở cả hai phía
+ * @param cs Thống kê của client
+ * @param now_ms Thời gian monotonic hiện tại
+ * @param wall_ms Thời gian thực hiện tại (epoch ms, ghi vào origin_ms của PING)
+ * @return Seq ghi vào PING
+ */
+uint32_t clocksync_start_ping(clocksync_t *cs, uint64_t now_ms, uint64_t wall_ms);
+
+/**
+ * Cập nhật RTT/lệch đồng hồ từ PONG của client
+ * rtt = (now - sent) - (remote_send - remote_recv), offset = ((remote_recv - origin) + (remote_send - wall)) / 2
+ * @param cs Thống kê của client
+ * @param seq Seq trong PONG
+ * @param origin_ms origin_ms trong PONG (đồng hồ thực server lúc gửi PING)
+ * @param remote_recv_ms Đồng hồ thực client lúc nhận PING
+ * @param remote_send_ms Đồng hồ thực client lúc gửi PONG
+ * @param now_ms Thời gian monotonic hiện tại
+ * @param wall_ms Thời gian thực hiện tại (epoch ms)
+ * @return 0 nếu mẫu hợp lệ, -1 nếu không khớp PING đang chờ
+ */
+int clocksync_on_pong(clocksync_t *cs, uint32_t seq, uint64_t origin_ms, uint64_t remote_recv_ms,
+                      uint64_t remote_send_ms, uint64_t now_ms, uint64_t wall_ms);
+
+/**
+ * RTT làm mượt của client (dùng cho lập lịch, phát hiện client chậm, metrics)
+ * @param cs Thống kê của client
+ * @return srtt tính bằng ms, 0 nếu chưa có mẫu
+ */
+uint32_t clocksync_rtt_ms(const clocksync_t *cs);
+
+#endif // CLOCKSYNC_H
@@ -0,0 +1,60 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zlib.h>
+
+// Nén payload lớn trong MSG_COMPRESSED (chỉ gửi cho client đã thỏa thuận CAP_COMPRESSION)
+// Payload nhỏ hơn ngưỡng (DRAW_BROADCAST, TIMER_UPDATE, ...) luôn gửi nguyên
+#define COMPRESS_MIN_PAYLOAD     512
+#define COMPRESS_LEVEL           6      // Mức deflate (xem bench/compress_bench.c)
+#define COMPRESS_WINDOW_BITS     13     // Cửa sổ 8 KB: đủ cho payload danh sách, state ~48 KB mỗi client
+#define COMPRESS_MEM_LEVEL       5
+
+// Kích thước header MSG_COMPRESSED trước dữ liệu deflate: [type:1][raw_len:4]
+#define COMPRESS_HEADER_SIZE     5
+
+// Context nén của một client, tạo khi client nhận message nén đầu tiên
+typedef struct {
+    z_stream stream;
+    int initialized;
+    uint64_t raw_bytes;             // Tổng payload gốc của các message đã nén
+    uint64_t wire_bytes;            // Tổng payload MSG_COMPRESSED đã tạo
+    uint32_t messages;              // Số message đã nén
+} compress_ctx_t;
+
+/**
+ * Message type có nên nén không (danh sách/bảng điểm nhiều chuỗi đệm '\0')
+ * @param msg_type Message type gốc
+ * @return 1 nếu có, 0 nếu không
+ */
+int compress_type_eligible(uint8_t msg_type);
+
+/**
+ * Kích thước buffer tối đa cần cho payload MSG_COMPRESSED
+ * @param payload_len Độ dài payload gốc
+ * @return Số byte tối đa (header + dữ liệu deflate)
+ */
+size_t compress_bound(size_t payload_len);
+
+/**
+ * Nén payload thành payload MSG_COMPRESSED: [type:1][raw_len:4][raw deflate]
+ * @param ctx Context nén của client (tự khởi tạo lần đầu)
+ * @param msg_type Message type gốc
+ * @param payload Payload gốc
+ * @param payload_len Độ dài payload gốc
+ * @param out Buffer đích (ít nhất compress_bound(payload_len) byte)
+ * @param out_capacity Kích thước buffer đích
+ * @return Độ dài payload MSG_COMPRESSED, 0 nếu lỗi hoặc nén không nhỏ hơn bản gốc
+ */
+size_t compress_payload(compress_ctx_t *ctx, uint8_t msg_type, const uint8_t *payload, size_t payload_len,
+                        uint8_t *out, size_t out_capacity);
+
+/**
+ * Giải phóng context nén (khi client ngắt kết nối)
+ * @param ctx Context nén
+ */
+void compress_ctx_free(compress_ctx_t *ctx);
+
+#endif // COMPRESS_H
@@ -4,6 +4,8 @@
 #include <mysql/mysql.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "storage.h"
 
 // Cấu trúc lưu thông tin kết nối database
 typedef struct {
@@ -12,8 +14,13 @@ typedef struct {
     char user[32];
     char password[64];
     char database[32];
+    uint64_t reconnect_failed_ms;   // Lần kết nối lại thất bại gần nhất (utils_now_ms), 0 nếu không có
 } db_connection_t;
 
+#define DB_CONNECT_TIMEOUT_SEC      2       // mysql_real_connect không chặn vòng lặp sự kiện quá lâu
+#define DB_IO_TIMEOUT_SEC           5       // Đọc/ghi trên kết nối đã mở (MySQL treo, mạng đứt)
+#define DB_RECONNECT_BACKOFF_MS     1000    // Không thử kết nối lại ngay sau một lần thất bại
+
 /**
  * Kết nối đến MySQL database
  * @param host Địa chỉ host MySQL
@@ -125,6 +132,9 @@ int db_ensure_schema(db_connection_t* db);
 // Create a persistent room record. Returns rooms.id or -1.
 int db_create_room(db_connection_t* db, const char* room_code, int host_id, int max_players, int total_rounds);
 
+// Set rooms.status ('waiting' | 'in_progress' | 'finished'). Returns 0 or -1.
+int db_set_room_status(db_connection_t* db, int db_room_id, const char* status);
+
 // Add a player to room_players; returns room_players.id or -1.
 int db_add_room_player(db_connection_t* db, int db_room_id, int user_id, int join_order);
 
@@ -137,6 +147,9 @@ int db_save_guess(db_connection_t* db, int db_round_id, int player_db_id, const
 // Save score detail row (score_details); returns id or -1.
 int db_save_score_detail(db_connection_t* db, int db_round_id, int player_db_id, int score);
 
+// Save a chat_messages row; returns chat_messages.id or -1.
+int db_save_chat_message(db_connection_t* db, int db_room_id, int player_db_id, const char* message_text);
+
 // Update final scores in room_players for a room.
 int db_update_room_player_score(db_connection_t* db, int player_db_id, int score);
 
@@ -150,13 +163,7 @@ int db_update_user_stats(db_connection_t* db, int user_id, int score, int is_win
 // @return 1 nếu thành công, 0 nếu thất bại
 int db_save_game_history(db_connection_t* db, int user_id, int score, int rank);
 
-// Cấu trúc để lưu 1 entry lịch sử
-typedef struct {
-    int score;
-    int rank;
-    char finished_at[32]; // YYYY-MM-DD HH:MM:SS format
-} game_history_entry_t;
-
+// game_history_entry_t: xem storage.h
 // Lấy lịch sử chơi của người dùng (sắp xếp theo thời gian mới nhất)
 // @param user_id ID của người dùng
 // @param entries Mảng để lưu lịch sử (phải được cấp phát trước)
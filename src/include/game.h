@@ -2,6 +2,7 @@
 #define GAME_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 #include "room.h"
 
@@ -38,7 +39,9 @@ typedef struct game_state {
     char current_category[64]; // Category của từ hiện tại
     int word_length;
     bool word_guessed;
-    time_t round_start_time;
+    uint64_t round_start_ms;    // CLOCK_MONOTONIC (utils_now_ms), 0 = không có round đang chạy
+    uint64_t round_deadline_ms; // round_start_ms + time_limit * 1000
+    uint64_t next_clock_sync_ms; // Lần gửi ROUND_DEADLINE resync tiếp theo
     int time_limit; // seconds
     int db_round_id; // game_rounds.id hiện tại (0 nếu chưa persist)
     player_score_t scores[MAX_PLAYERS_PER_ROOM];
@@ -75,9 +78,10 @@ bool game_start_round(game_state_t* game);
 /**
  * Kiểm tra timeout round; nếu quá hạn thì tự end round (success=false).
  *
+ * @param now_ms Thời gian monotonic hiện tại (utils_now_ms)
  * @return true nếu round đã bị timeout và bị end, false nếu chưa.
  */
-bool game_check_timeout(game_state_t* game);
+bool game_check_timeout(game_state_t* game, uint64_t now_ms);
 
 /**
  * Xử lý guess word của 1 user.
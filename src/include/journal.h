@@ -0,0 +1,80 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Journal ghi trước (write-ahead) cục bộ: file append-only các bản ghi có CRC, dùng để giữ
+// những ghi persistence không thực hiện được khi database mất kết nối và phát lại sau.
+// Trạng thái là toàn cục của module như capture; nội dung bản ghi do caller (storage.c) định nghĩa.
+//
+// File: [magic "DGJNL":5][version:1][reserved:2][replay_offset:8 BE]
+// rồi các bản ghi liên tiếp: [len:4 BE][crc32(payload):4 BE][payload:len]
+// replay_offset là vị trí bản ghi đầu tiên chưa phát lại, cập nhật sau mỗi đợt phát lại.
+// Phát lại hết thì file được cắt về header. Bản ghi cuối bị ghi dở (crash giữa chừng)
+// bị cắt bỏ khi mở lại. Phát lại là at-least-once: crash giữa một đợt có thể lặp lại đợt đó.
+#define JOURNAL_MAGIC               "DGJNL"
+#define JOURNAL_MAGIC_LEN           5
+#define JOURNAL_VERSION             1
+#define JOURNAL_HEADER_SIZE         16
+#define JOURNAL_RECORD_HEADER_SIZE  8
+#define JOURNAL_MAX_PAYLOAD         4096
+#define JOURNAL_BUFFER_SIZE         (64 * 1024)     // Bản ghi gom trong bộ nhớ trước một lần write + fdatasync
+
+/**
+ * Áp dụng một bản ghi khi phát lại
+ * @param payload Nội dung bản ghi
+ * @param len Độ dài
+ * @param arg Tham số của caller
+ * @return 0 nếu đã xử lý (kể cả bỏ qua bản ghi hỏng), -1 để dừng và thử lại bản ghi này lần sau
+ */
+typedef int (*journal_apply_fn)(const uint8_t *payload, uint32_t len, void *arg);
+
+/**
+ * Mở (hoặc tạo) journal, kiểm tra header, đếm bản ghi chưa phát lại, cắt phần đuôi hỏng
+ * @param path Đường dẫn file
+ * @return 0 nếu thành công, -1 nếu lỗi (không mở được, không phải journal, khác phiên bản)
+ */
+int journal_open(const char *path);
+
+/**
+ * Journal có đang mở không
+ * @return 1 nếu đang mở
+ */
+int journal_active(void);
+
+/**
+ * Số bản ghi chưa phát lại (trên đĩa và trong buffer)
+ * @return Số bản ghi, 0 nếu journal trống hoặc chưa mở
+ */
+uint64_t journal_pending(void);
+
+/**
+ * Thêm bản ghi vào buffer (chỉ ghi xuống đĩa khi journal_flush hoặc buffer đầy)
+ * @param payload Nội dung bản ghi
+ * @param len Độ dài, tối đa JOURNAL_MAX_PAYLOAD
+ * @return 0 nếu thành công, -1 nếu lỗi (chưa mở, quá dài, ghi đĩa lỗi)
+ */
+int journal_append(const uint8_t *payload, uint32_t len);
+
+/**
+ * Ghi buffer xuống file bằng một lần write rồi fdatasync (group commit)
+ * @return 0 nếu thành công hoặc buffer trống, -1 nếu lỗi (buffer được giữ để thử lại)
+ */
+int journal_flush(void);
+
+/**
+ * Phát lại bản ghi theo thứ tự ghi đến khi hết, fn trả về -1 hoặc hết thời gian
+ * @param fn Hàm áp dụng bản ghi
+ * @param arg Tham số cho fn
+ * @param budget_ns Thời gian tối đa cho đợt này (ít nhất một bản ghi được thử)
+ * @return Số bản ghi đã xử lý, -1 nếu lỗi đọc/ghi file
+ */
+int journal_replay(journal_apply_fn fn, void *arg, uint64_t budget_ns);
+
+/**
+ * Flush buffer và đóng journal (bản ghi chưa phát lại nằm lại trong file cho lần chạy sau)
+ */
+void journal_close(void);
+
+#endif // JOURNAL_H
@@ -0,0 +1,184 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Histogram độ trễ kiểu HDR (log-linear): mỗi khoảng [2^k, 2^(k+1)) chia thành
+// LATENCY_SUB_COUNT bucket đều nhau, sai số tương đối tối đa 1/LATENCY_SUB_COUNT (12.5%)
+// Ghi một mẫu O(1) (một lệnh clz), không cấp phát, đủ rẻ để bật thường trực
+#define LATENCY_SUB_BITS        3
+#define LATENCY_SUB_COUNT       (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_MSB         39      // 2^40 ns ~ 18 phút, lớn hơn dồn vào bucket cuối
+#define LATENCY_BUCKETS         ((LATENCY_MAX_MSB - LATENCY_SUB_BITS + 2) * LATENCY_SUB_COUNT)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint32_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+// Thống kê theo message type (nhận từ client và gửi đi)
+typedef struct {
+    uint64_t calls;                 // Số lần dispatch tới handler
+    uint64_t errors;                // Handler trả về < 0
+    uint64_t rejected;              // Bị rate limit hoặc không có handler
+    uint64_t bytes_in;              // Tổng payload nhận
+    uint64_t db_queries;            // Truy vấn DB phát sinh trong handler
+    uint64_t db_ns;                 // Thời gian DB trong handler (đã gồm trong latency)
+    uint64_t sent;                  // Số frame gửi đi (type trên wire, MSG_COMPRESSED tính riêng)
+    uint64_t bytes_out;             // Tổng byte frame gửi đi (gồm header)
+    latency_hist_t latency;         // Thời gian handler (ns)
+} msg_type_stats_t;
+
+typedef struct {
+    msg_type_stats_t types[256];
+    latency_hist_t db_latency;      // Mọi truy vấn db_execute_query (ns)
+    latency_hist_t loop_latency;    // Thời gian một vòng lặp sự kiện sau select() (ns)
+    latency_hist_t fanout;          // Số client nhận mỗi lần broadcast
+    uint64_t db_queries;
+    uint64_t db_errors;
+    uint64_t dispatched;            // Tổng message đã dispatch (mọi type)
+    uint32_t dispatch_db_queries;   // Truy vấn DB của message đang/vừa dispatch
+    uint64_t dispatch_db_ns;
+    uint64_t started_ms;            // Mốc monotonic khi bắt đầu đo
+} metrics_t;
+
+// Buffer văn bản tự giãn (xuất định dạng Prometheus)
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+    int failed;                     // Hết bộ nhớ, nội dung không đầy đủ
+} metrics_text_t;
+
+/**
+ * Chỉ số bucket của một giá trị
+ * @param value_ns Giá trị (ns)
+ * @return Chỉ số trong 0..LATENCY_BUCKETS-1
+ */
+int latency_bucket_index(uint64_t value_ns);
+
+/**
+ * Cận dưới của một bucket
+ * @param index Chỉ số bucket
+ * @return Giá trị nhỏ nhất (ns) rơi vào bucket
+ */
+uint64_t latency_bucket_lower(int index);
+
+/**
+ * Ghi một mẫu vào histogram
+ * @param hist Histogram
+ * @param value_ns Giá trị (ns)
+ */
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns);
+
+/**
+ * Ước lượng phân vị (giữa bucket chứa phân vị, không vượt max)
+ * @param hist Histogram
+ * @param quantile Phân vị trong [0, 1], ví dụ 0.99
+ * @return Giá trị (ns), 0 nếu histogram rỗng
+ */
+uint64_t latency_hist_quantile(const latency_hist_t *hist, double quantile);
+
+/**
+ * Đặt lại toàn bộ số liệu
+ */
+void metrics_reset(void);
+
+/**
+ * Số liệu hiện tại (chỉ đọc)
+ * @return Con trỏ đến metrics toàn cục
+ */
+const metrics_t *metrics_get(void);
+
+/**
+ * Bắt đầu đo một message: truy vấn DB sau đó được tính cho type này
+ * @param type Message type
+ * @return Mốc thời gian (ns) truyền lại cho metrics_dispatch_end
+ */
+uint64_t metrics_dispatch_begin(uint8_t type);
+
+/**
+ * Kết thúc đo một message đã dispatch
+ * @param type Message type
+ * @param payload_len Độ dài payload
+ * @param start_ns Giá trị trả về từ metrics_dispatch_begin
+ * @param result Kết quả handler (< 0 là lỗi)
+ * @return Thời gian handler (ns)
+ */
+uint64_t metrics_dispatch_end(uint8_t type, uint32_t payload_len, uint64_t start_ns, int result);
+
+/**
+ * Ghi nhận message bị bỏ trước khi tới handler (rate limit, type lạ)
+ * @param type Message type
+ * @param payload_len Độ dài payload
+ */
+void metrics_record_rejected(uint8_t type, uint32_t payload_len);
+
+/**
+ * Ghi nhận một truy vấn DB (gọi từ db_execute_query)
+ * @param elapsed_ns Thời gian truy vấn (ns)
+ * @param ok 1 nếu thành công, 0 nếu lỗi
+ */
+void metrics_record_db_query(uint64_t elapsed_ns, int ok);
+
+/**
+ * Ghi nhận một frame đã gửi thành công
+ * @param type Message type trên wire
+ * @param frame_len Độ dài frame (header + payload)
+ */
+void metrics_record_sent(uint8_t type, size_t frame_len);
+
+/**
+ * Ghi nhận một lần broadcast
+ * @param recipients Số client đã nhận
+ */
+void metrics_record_broadcast(int recipients);
+
+/**
+ * Ghi nhận thời gian xử lý một vòng lặp sự kiện
+ * @param elapsed_ns Thời gian từ lúc select() trả về tới cuối vòng lặp (ns)
+ */
+void metrics_record_loop(uint64_t elapsed_ns);
+
+/**
+ * Nối chuỗi định dạng printf vào buffer
+ * @param text Buffer
+ * @param fmt Chuỗi định dạng
+ */
+void metrics_text_appendf(metrics_text_t *text, const char *fmt, ...);
+
+/**
+ * Giải phóng buffer
+ * @param text Buffer
+ */
+void metrics_text_free(metrics_text_t *text);
+
+/**
+ * Xuất counter và summary theo message type, DB, vòng lặp, broadcast (Prometheus text 0.0.4)
+ * @param text Buffer đích
+ * @param type_name Hàm đặt tên message type cho nhãn name (có thể NULL)
+ */
+void metrics_write_prometheus(metrics_text_t *text, const char *(*type_name)(uint8_t type));
+
+/**
+ * Yêu cầu in số liệu ở vòng lặp sự kiện kế tiếp (an toàn trong signal handler)
+ */
+void metrics_request_dump(void);
+
+/**
+ * Lấy và xóa yêu cầu in số liệu
+ * @return 1 nếu có yêu cầu đang chờ
+ */
+int metrics_take_dump_request(void);
+
+/**
+ * In bảng số liệu theo message type (calls, bytes, p50/p90/p99/max, thời gian DB)
+ * @param out Luồng đích
+ * @param type_name Hàm đặt tên message type (có thể NULL, khi đó chỉ in mã hex)
+ */
+void metrics_dump(FILE *out, const char *(*type_name)(uint8_t type));
+
+#endif // METRICS_H
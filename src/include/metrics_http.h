@@ -0,0 +1,82 @@
+#ifndef METRICS_HTTP_H
+#define METRICS_HTTP_H
+
+#include <stdint.h>
+#include <sys/select.h>
+#include "metrics.h"
+
+// Endpoint số liệu dạng Prometheus text (GET /metrics) trên port local hoặc UNIX socket riêng
+// GET /stalls trả về flight recorder các lần nghẽn (stall.h) dạng văn bản
+// Chạy trong vòng lặp select() của server: socket non-blocking, không bao giờ chặn game traffic
+#define METRICS_HTTP_MAX_CONNS      4       // Scraper đồng thời, thêm nữa bị đóng ngay
+#define METRICS_HTTP_REQUEST_MAX    1024    // Chỉ cần dòng request + header ngắn
+#define METRICS_HTTP_TIMEOUT_MS     5000    // Kết nối chưa xong sau thời gian này bị đóng
+#define METRICS_HTTP_PATH_MAX       108     // sizeof(sockaddr_un.sun_path)
+
+struct server;
+
+// Một kết nối scrape: đọc request, dựng response một lần rồi gửi dần khi socket ghi được
+typedef struct {
+    int fd;                         // -1 = slot trống
+    char request[METRICS_HTTP_REQUEST_MAX];
+    size_t request_len;
+    metrics_text_t response;        // Header + body, dựng khi đủ request
+    size_t sent;                    // Số byte response đã gửi
+    uint64_t accepted_ms;
+} metrics_http_conn_t;
+
+typedef struct {
+    int listen_fd;                  // -1 = tắt
+    char unix_path[METRICS_HTTP_PATH_MAX]; // Khác rỗng nếu nghe trên UNIX socket (xóa khi đóng)
+    uint64_t scrapes;               // Số response /metrics đã dựng
+    metrics_http_conn_t conns[METRICS_HTTP_MAX_CONNS];
+} metrics_http_t;
+
+/**
+ * Khởi tạo trạng thái tắt (không nghe)
+ * @param http Endpoint
+ */
+void metrics_http_init(metrics_http_t *http);
+
+/**
+ * Mở socket nghe
+ * @param http Endpoint
+ * @param address "PORT" (127.0.0.1:PORT) hoặc "unix:/duong/dan.sock"
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int metrics_http_listen(metrics_http_t *http, const char *address);
+
+/**
+ * Thêm socket nghe và kết nối scrape vào tập fd của select()
+ * @param http Endpoint
+ * @param read_fds Tập fd chờ đọc
+ * @param write_fds Tập fd chờ ghi (kết nối còn response chưa gửi hết)
+ * @param max_fd Fd lớn nhất (cập nhật nếu cần)
+ */
+void metrics_http_fill_fds(metrics_http_t *http, fd_set *read_fds, fd_set *write_fds, int *max_fd);
+
+/**
+ * Xử lý kết nối mới, request và response sau select() (không chặn)
+ * @param http Endpoint
+ * @param server Server cung cấp gauge (client, phòng, hàng đợi gửi)
+ * @param read_fds Tập fd đọc được
+ * @param write_fds Tập fd ghi được
+ * @param now_ms Thời gian monotonic hiện tại
+ */
+void metrics_http_handle(metrics_http_t *http, struct server *server, const fd_set *read_fds,
+                         const fd_set *write_fds, uint64_t now_ms);
+
+/**
+ * Dựng toàn bộ số liệu dạng Prometheus text
+ * @param server Server
+ * @param text Buffer đích
+ */
+void metrics_http_render(struct server *server, metrics_text_t *text);
+
+/**
+ * Đóng socket nghe và mọi kết nối scrape
+ * @param http Endpoint
+ */
+void metrics_http_close(metrics_http_t *http);
+
+#endif // METRICS_HTTP_H
@@ -17,6 +17,15 @@
  */
 int protocol_parse_message(const uint8_t* buffer, size_t buffer_len, message_t* msg_out);
 
+/**
+ * Kiểm tra buffer nhận được đã chứa trọn một frame chưa (hỗ trợ cả frame mở rộng)
+ * @param buffer Dữ liệu đã nhận
+ * @param buffer_len Độ dài dữ liệu
+ * @param frame_len_out Tổng độ dài frame (header + payload) nếu đã đọc được header
+ * @return 1 nếu đủ một frame, 0 nếu cần thêm dữ liệu, -1 nếu header không hợp lệ
+ */
+int protocol_peek_frame(const uint8_t* buffer, size_t buffer_len, size_t* frame_len_out);
+
 /**
  * Tạo message theo format protocol
  * @param type Message type
@@ -36,9 +45,17 @@ int protocol_create_message(uint8_t type, const uint8_t* payload, uint16_t paylo
  */
 int protocol_handle_message(server_t* server, int client_index, const message_t* msg);
 
+/**
+ * Tên message type client gửi lên (theo bảng dispatch)
+ * @param type Message type
+ * @return Tên hằng MSG_*, NULL nếu type không có handler
+ */
+const char* protocol_message_name(uint8_t type);
+
 /**
  * Gửi LOGIN_RESPONSE đến client
  * @param client_fd File descriptor của client socket
+ * @param caps Capability của client (CAP_COMPACT_STRINGS: message dạng [len:1][bytes])
  * @param status Status code (STATUS_SUCCESS hoặc STATUS_ERROR)
  * @param user_id User ID (hoặc -1 nếu thất bại)
  * @param username Username
@@ -49,12 +66,31 @@ int protocol_send_login_response(int client_fd, uint8_t status, int32_t user_id,
 /**
  * Gửi REGISTER_RESPONSE đến client
  * @param client_fd File descriptor của client socket
+ * @param caps Capability của client (CAP_COMPACT_STRINGS: message dạng [len:1][bytes])
  * @param status Status code (STATUS_SUCCESS hoặc STATUS_ERROR)
  * @param message Thông báo (lỗi hoặc thành công)
  * @return 0 nếu thành công, -1 nếu lỗi
  */
 int protocol_send_register_response(int client_fd, uint8_t status, const char* message);
 
+/**
+ * Gửi CHANGE_PASSWORD_RESPONSE đến client
+ * @param client_fd File descriptor của client socket
+ * @param status Status code (STATUS_SUCCESS, STATUS_ERROR, STATUS_AUTH_FAILED)
+ * @param message Thông báo (lỗi hoặc thành công)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_change_password_response(int client_fd, uint8_t status, const char* message);
+
+/**
+ * Gửi MSG_ERROR: báo request bị từ chối khi response của request đó không có trường status
+ * @param client_fd File descriptor của client socket
+ * @param request_type Type của request bị từ chối
+ * @param message Lý do
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_error(int client_fd, uint8_t request_type, const char* message);
+
 /**
  * Gửi thông báo tài khoản đang được đăng nhập ở nơi khác
  * @param client_fd File descriptor của client socket
@@ -72,6 +108,48 @@ int protocol_send_account_logged_in_elsewhere(int client_fd);
  */
 int protocol_send_message(int client_fd, uint8_t type, const uint8_t* payload, uint16_t payload_len);
 
+/**
+ * Gửi message với payload tùy ý (tối đa MSG_MAX_PAYLOAD_SIZE)
+ * Dùng frame mở rộng khi payload >= 0xFFFF bytes; chỉ cấp phát heap khi
+ * frame không vừa buffer trên stack (BUFFER_SIZE)
+ * @param client_fd File descriptor của client socket
+ * @param type Message type
+ * @param payload Payload data
+ * @param payload_len Payload length
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_large_message(int client_fd, uint8_t type, const uint8_t* payload, size_t payload_len);
+
+/**
+ * Gửi message đến client, nén thành MSG_COMPRESSED nếu client có CAP_COMPRESSION,
+ * type thuộc compress_type_eligible() và payload >= COMPRESS_MIN_PAYLOAD
+ * @param client Client nhận (dùng context nén của client)
+ * @param type Message type
+ * @param payload Payload data
+ * @param payload_len Payload length
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_client_message(client_t* client, uint8_t type, const uint8_t* payload, size_t payload_len);
+
+/**
+ * Ghi header frame vào buffer
+ * @param type Message type
+ * @param payload_len Độ dài payload
+ * @param buffer_out Buffer đích (ít nhất MSG_EXTENDED_HEADER_SIZE bytes)
+ * @return Độ dài header đã ghi (MSG_HEADER_SIZE hoặc MSG_EXTENDED_HEADER_SIZE)
+ */
+size_t protocol_write_header(uint8_t type, size_t payload_len, uint8_t* buffer_out);
+
+/**
+ * Gửi một frame đã serialize sẵn (header + payload), ví dụ frame danh sách phòng đã cache,
+ * hoặc nhiều frame nối tiếp nhau trong một lần send (metrics vẫn đếm từng frame)
+ * @param client_fd File descriptor của client socket
+ * @param frame Frame hoàn chỉnh (hoặc các frame liên tiếp)
+ * @param frame_len Tổng độ dài
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_frame(int client_fd, const uint8_t* frame, size_t frame_len);
+
 /**
  * Gửi ROOM_LIST_RESPONSE đến client
  * @param client_fd File descriptor của client socket
@@ -92,35 +170,39 @@ int protocol_broadcast_room_update(server_t* server, room_t* room, int exclude_c
 /**
  * Gửi CREATE_ROOM_RESPONSE đến client
  * @param client_fd File descriptor của client socket
+ * @param caps Capability của client (CAP_COMPACT_STRINGS: message dạng [len:1][bytes])
  * @param status Status code (STATUS_SUCCESS hoặc STATUS_ERROR)
  * @param room_id Room ID (hoặc -1 nếu thất bại)
  * @param message Thông báo (lỗi hoặc thành công)
  * @return 0 nếu thành công, -1 nếu lỗi
  */
-int protocol_send_create_room_response(int client_fd, uint8_t status, int32_t room_id, const char* message);
+int protocol_send_create_room_response(int client_fd, uint32_t caps, uint8_t status, int32_t room_id, const char* message);
 
 /**
  * Gửi JOIN_ROOM_RESPONSE đến client
  * @param client_fd File descriptor của client socket
+ * @param caps Capability của client (CAP_COMPACT_STRINGS: message dạng [len:1][bytes])
  * @param status Status code (STATUS_SUCCESS hoặc STATUS_ERROR)
  * @param room_id Room ID (hoặc -1 nếu thất bại)
  * @param message Thông báo (lỗi hoặc thành công)
  * @return 0 nếu thành công, -1 nếu lỗi
  */
-int protocol_send_join_room_response(int client_fd, uint8_t status, int32_t room_id, const char* message);
+int protocol_send_join_room_response(int client_fd, uint32_t caps, uint8_t status, int32_t room_id, const char* message);
 
 /**
  * Gửi LEAVE_ROOM_RESPONSE đến client
  * @param client_fd File descriptor của client socket
+ * @param caps Capability của client (CAP_COMPACT_STRINGS: message dạng [len:1][bytes])
  * @param status Status code (STATUS_SUCCESS hoặc STATUS_ERROR)
  * @param message Thông báo (lỗi hoặc thành công)
  * @return 0 nếu thành công, -1 nếu lỗi
  */
-int protocol_send_leave_room_response(int client_fd, uint8_t status, const char* message);
+int protocol_send_leave_room_response(int client_fd, uint32_t caps, uint8_t status, const char* message);
 
 /**
- * Broadcast ROOM_PLAYERS_UPDATE đến tất cả clients trong phòng
- * Gửi danh sách đầy đủ người chơi khi có thay đổi
+ * Broadcast thay đổi người chơi đến tất cả clients trong phòng
+ * Người vừa join nhận ROOM_PLAYERS_UPDATE đầy đủ, những người còn lại nhận ROOM_PLAYER_DELTA
+ * (chỉ người chơi thay đổi, chuỗi có tiền tố độ dài)
  * @param server Con trỏ đến server_t
  * @param room Con trỏ đến room_t
  * @param action 0 = JOIN, 1 = LEAVE
@@ -135,8 +217,9 @@ int protocol_broadcast_room_players_update(server_t* server, room_t* room,
                                            int exclude_client_index);
 
 /**
- * Broadcast ROOM_LIST_RESPONSE đến tất cả clients đã đăng nhập
- * Gọi khi có phòng mới được tạo hoặc phòng bị xóa
+ * Công bố thay đổi danh sách phòng đến tất cả clients đã đăng nhập
+ * Client có seq liền trước nhận ROOM_LIST_DELTA, client chưa có hoặc lệch seq nhận ROOM_LIST_RESPONSE đầy đủ.
+ * Không gửi gì nếu danh sách không đổi (được gọi mỗi vòng lặp sự kiện)
  * @param server Con trỏ đến server_t
  * @return Số lượng clients đã nhận được message
  */
@@ -148,10 +231,49 @@ int protocol_broadcast_room_list(server_t* server);
 int protocol_handle_start_game(server_t* server, int client_index, const message_t* msg);
 int protocol_handle_guess_word(server_t* server, int client_index, const message_t* msg);
 int protocol_handle_round_timeout(server_t* server, room_t* room, const char* word_before_clear);
+int protocol_broadcast_timer_update(server_t* server, room_t* room, uint64_t now_ms);
+
+/**
+ * Gửi ROUND_DEADLINE cho một client CAP_ROUND_DEADLINE (sau GAME_START, khi vào giữa round, resync)
+ * @param client Client nhận
+ * @param game Trạng thái game của phòng
+ * @param now_ms Thời gian monotonic hiện tại
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int protocol_send_round_deadline(client_t* client, const game_state_t* game, uint64_t now_ms);
+
+/**
+ * Gửi PING cho các client CAP_PING đã đến hạn (mỗi CLOCKSYNC_PING_INTERVAL_MS)
+ * PONG trả về cập nhật client->clock (RTT, lệch đồng hồ)
+ * @param server Con trỏ đến server_t
+ * @param now_ms Thời gian monotonic hiện tại
+ * @return Số PING đã gửi
+ */
+int protocol_ping_clients(server_t* server, uint64_t now_ms);
 int protocol_handle_logout(server_t* server, int client_index, const message_t* msg);
 int protocol_handle_chat_message(server_t* server, int client_index, const message_t* msg);
 int protocol_process_guess(server_t* server, int client_index, room_t* room, const char* guess);
 int protocol_handle_get_game_history(server_t* server, int client_index, const message_t* msg);
 
+/**
+ * Gửi snapshot canvas của phòng cho một client
+ * Client có CAP_EXTENDED_FRAMES nhận một frame CANVAS_SNAPSHOT, client cũ nhận nhiều frame vừa BUFFER_SIZE
+ * Không làm gì nếu phòng không bật canvas raster
+ * @param client_fd File descriptor của client socket
+ * @param caps Capability đã thỏa thuận của client
+ * @param room Con trỏ đến room_t
+ * @return 0 nếu thành công hoặc không có canvas, -1 nếu lỗi
+ */
+int protocol_send_canvas_snapshot(int client_fd, uint32_t caps, room_t* room);
+
+/**
+ * Phát lại log nét vẽ (đã đơn giản hóa) của round hiện tại cho một client
+ * dưới dạng các frame DRAW_BROADCAST, gom thành các lần send 64 KB
+ * @param client_fd File descriptor của client socket
+ * @param room Con trỏ đến room_t
+ * @return Số đoạn đã gửi, -1 nếu lỗi
+ */
+int protocol_send_stroke_replay(int client_fd, room_t* room);
+
 #endif // PROTOCOL_HANDLER_H
 
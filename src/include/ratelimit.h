@@ -0,0 +1,84 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Nhóm message dùng chung một token bucket
+// Các message không thuộc nhóm nào (LOGOUT, PING/PONG: O(1), bỏ PING làm sai RTT) không bị giới hạn
+typedef enum {
+    RATE_CLASS_DRAW = 0,        // DRAW_DATA (mỗi frame broadcast O(clients))
+    RATE_CLASS_CHAT,            // CHAT_MESSAGE, GUESS_WORD
+    RATE_CLASS_LOBBY,           // ROOM_LIST_REQUEST, LOBBY_(UN)SUBSCRIBE, GET_GAME_HISTORY
+    RATE_CLASS_ROOM,            // CREATE_ROOM, JOIN_ROOM, LEAVE_ROOM, START_GAME
+    RATE_CLASS_AUTH,            // LOGIN, REGISTER, CHANGE_PASSWORD (mỗi lần là một truy vấn DB)
+    RATE_CLASS_COUNT
+} rate_class_t;
+
+#define RATE_CLASS_NONE (-1)
+
+// Chính sách cho một nhóm: nạp rate_per_sec token/giây, tối đa burst token
+// rate_per_sec = 0 nghĩa là không giới hạn
+typedef struct {
+    uint32_t rate_per_sec;
+    uint32_t burst;
+} rate_limit_policy_t;
+
+// Token bucket, token lưu dạng fixed-point (1 token = 1000 đơn vị)
+typedef struct {
+    uint32_t tokens_milli;
+    uint64_t last_refill_ms;
+} rate_bucket_t;
+
+// Trạng thái rate limit của một client
+typedef struct {
+    rate_bucket_t buckets[RATE_CLASS_COUNT];
+    uint32_t dropped[RATE_CLASS_COUNT];     // Số message bị bỏ theo nhóm
+} client_rate_state_t;
+
+/**
+ * Xác định nhóm rate limit của một message type
+ * @param msg_type Message type
+ * @return rate_class_t hoặc RATE_CLASS_NONE nếu không giới hạn
+ */
+int ratelimit_class_for(uint8_t msg_type);
+
+/**
+ * Tên nhóm (dùng cho log và tham số dòng lệnh)
+ * @param rate_class Nhóm
+ * @return Tên nhóm, "none" nếu không hợp lệ
+ */
+const char *ratelimit_class_name(int rate_class);
+
+/**
+ * Gán chính sách mặc định cho tất cả các nhóm
+ * @param policies Mảng RATE_CLASS_COUNT phần tử
+ */
+void ratelimit_default_policies(rate_limit_policy_t *policies);
+
+/**
+ * Parse tùy chọn dạng "nhom=rate/burst" (ví dụ "draw=120/240", "chat=0" để tắt)
+ * @param spec Chuỗi tùy chọn
+ * @param policies Mảng RATE_CLASS_COUNT phần tử cần cập nhật
+ * @return 0 nếu thành công, -1 nếu chuỗi không hợp lệ
+ */
+int ratelimit_parse_option(const char *spec, rate_limit_policy_t *policies);
+
+/**
+ * Khởi tạo trạng thái rate limit cho client mới (mọi bucket đầy)
+ * @param state Trạng thái cần khởi tạo
+ * @param policies Chính sách hiện tại
+ * @param now_ms Thời gian monotonic hiện tại
+ */
+void ratelimit_init_client(client_rate_state_t *state, const rate_limit_policy_t *policies, uint64_t now_ms);
+
+/**
+ * Nạp token theo thời gian đã trôi qua và lấy 1 token nếu có
+ * @param bucket Bucket của client
+ * @param policy Chính sách của nhóm
+ * @param now_ms Thời gian monotonic hiện tại
+ * @return true nếu message được phép, false nếu phải bỏ
+ */
+bool ratelimit_consume(rate_bucket_t *bucket, const rate_limit_policy_t *policy, uint64_t now_ms);
+
+#endif // RATELIMIT_H
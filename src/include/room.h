@@ -7,11 +7,14 @@
 // Forward declarations
 typedef struct game_state game_state_t;
 typedef struct server server_t;
+typedef struct canvas canvas_t;
+typedef struct stroke_log stroke_log_t;
 
 // Constants
 #define MAX_PLAYERS_PER_ROOM 10
 #define MIN_PLAYERS_PER_ROOM 2
 #define ROOM_NAME_MAX_LENGTH 32
+#define ROOM_USERNAME_MAX_LENGTH 32
 #define MAX_ROUNDS 10
 
 // Room states
@@ -29,7 +32,9 @@ typedef struct
     int db_room_id;                            // ID phòng trong database (0 nếu chưa tạo/persist)
     char room_name[ROOM_NAME_MAX_LENGTH];
     int owner_id;                             // User ID của người tạo phòng
+    char owner_username[ROOM_USERNAME_MAX_LENGTH]; // Username của chủ phòng (cập nhật khi chuyển owner)
     int players[MAX_PLAYERS_PER_ROOM];        // Mảng user IDs (bao gồm cả người chờ)
+    char player_names[MAX_PLAYERS_PER_ROOM][ROOM_USERNAME_MAX_LENGTH]; // Username tương ứng từng slot players[]
     int db_player_ids[MAX_PLAYERS_PER_ROOM];  // room_players.id tương ứng từng slot players[]
     int player_count;                         // Tổng số người trong phòng
     int active_players[MAX_PLAYERS_PER_ROOM]; // Mảng đánh dấu người chơi đang active (1) hay đang chờ (0)
@@ -38,7 +43,10 @@ typedef struct
     char difficulty[16];                      // Mức độ khó: "easy", "medium", "hard" (mặc định "easy")
     room_state_t state;                       // Trạng thái phòng
     game_state_t *game;                       // Con trỏ đến game state (NULL nếu chưa chơi)
+    canvas_t *canvas;                         // Canvas raster phía server (NULL nếu không bật)
+    stroke_log_t *strokes;                    // Log nét vẽ của round hiện tại (đã đơn giản hóa)
     time_t created_at;                        // Thời gian tạo phòng
+    unsigned int version;                     // Tăng mỗi khi thông tin hiển thị ở sảnh chờ thay đổi
 } room_t;
 
 /**
@@ -74,6 +82,15 @@ bool room_add_player(room_t *room, int user_id);
  */
 bool room_remove_player(room_t *room, int user_id);
 
+/**
+ * Gán username cho người chơi trong phòng (dùng cho danh sách phòng, không cần duyệt clients)
+ * Gọi sau room_create/room_add_player
+ * @param room Con trỏ đến room_t
+ * @param user_id User ID của người chơi
+ * @param username Username hiển thị
+ */
+void room_set_player_name(room_t *room, int user_id, const char *username);
+
 /**
  * Kiểm tra xem người chơi có trong phòng không
  * @param room Con trỏ đến room_t
@@ -140,6 +157,7 @@ typedef struct
     int max_players;
     room_state_t state;
     int owner_id;
+    char owner_username[ROOM_USERNAME_MAX_LENGTH];
 } room_info_t;
 
 void room_get_info(room_t *room, room_info_t *room_info);
@@ -153,4 +171,11 @@ void room_get_info(room_t *room, room_info_t *room_info);
  */
 int room_get_list(server_t *server, room_info_t *room_info_array, int max_rooms);
 
+/**
+ * Thế hệ của danh sách phòng: tăng khi có phòng được tạo, bị hủy hoặc thay đổi thông tin hiển thị
+ * Dùng để biết frame danh sách phòng đã cache còn hợp lệ hay không
+ * @return Giá trị thế hệ hiện tại
+ */
+unsigned long room_list_generation(void);
+
 #endif // ROOM_H
@@ -5,11 +5,26 @@
 #include <netinet/in.h>
 #include <sys/select.h>
 #include "room.h"
+#include "ratelimit.h"
+#include "compress.h"
+#include "clocksync.h"
+#include "timerheap.h"
+#include "metrics_http.h"
 
 #define MAX_CLIENTS 100
 #define MAX_ROOMS 50
 #define BUFFER_SIZE 1024
+#define CLIENT_RX_BUFFER_SIZE (BUFFER_SIZE * 4)  // Buffer nhận mỗi client (giới hạn độ dài frame client gửi lên)
 #define DEFAULT_PORT 8080
+#define DEFAULT_IDLE_TIMEOUT_MS 20000   // ~3 chu kỳ PING: đủ để bỏ qua một PONG trễ
+#define DEFAULT_JOURNAL_PATH "draw_guess.journal"    // Tương đối với thư mục chạy server
+
+// Capability server hỗ trợ (HELLO_ACK trả về phần giao với capability của client)
+#define SERVER_CAPS (CAP_EXTENDED_FRAMES | CAP_ROOM_LIST_DELTA | CAP_PLAYER_DELTA | CAP_COMPACT_STRINGS | \
+                     CAP_COMPRESSION | CAP_ROUND_DEADLINE | CAP_PING | CAP_CANVAS_SNAPSHOT)
+
+// Client đã thỏa thuận capability này qua HELLO chưa
+#define CLIENT_HAS_CAP(client, cap) (((client)->caps & (cap)) != 0)
 
 // Trạng thái client
 typedef enum {
@@ -27,8 +42,55 @@ typedef struct {
     char username[32];              // Username (null-terminated)
     char avatar[32];                 // Avatar filename (null-terminated)
     client_state_t state;           // Trạng thái hiện tại
+    client_rate_state_t rate;       // Token bucket theo nhóm message + bộ đếm message bị bỏ
+    uint8_t rx_buf[CLIENT_RX_BUFFER_SIZE]; // Dữ liệu đã nhận nhưng chưa đủ một frame
+    size_t rx_len;
+    uint32_t room_list_seq;         // Seq danh sách phòng client đang có (0 = chưa nhận)
+    int lobby_slot;                 // Vị trí trong server->lobby_subscribers, -1 nếu không theo dõi sảnh
+    uint16_t protocol_version;      // PROTOCOL_VERSION_LEGACY nếu client chưa gửi HELLO
+    uint32_t caps;                  // Capability đã thỏa thuận (CAP_*), 0 với client cũ
+    compress_ctx_t compress;        // Context nén MSG_COMPRESSED (khởi tạo khi cần)
+    clocksync_t clock;              // RTT/lệch đồng hồ đo bằng PING/PONG (client CAP_PING)
+    uint64_t last_activity_ms;      // Lần cuối nhận dữ liệu (ms monotonic), kể cả PONG
 } client_t;
 
+// Cấu hình runtime của server (đọc từ tham số dòng lệnh trong main.c)
+typedef struct {
+    int canvas_enabled;             // 1 = mỗi phòng giữ canvas raster phía server để gửi snapshot cho người vào sau
+    double stroke_tolerance;        // Sai số RDP khi đơn giản hóa log nét vẽ (pixel), <= 0 = giữ nguyên
+    rate_limit_policy_t rate_limits[RATE_CLASS_COUNT]; // Token bucket mỗi client theo nhóm message
+    uint32_t idle_timeout_ms;       // Ngắt client CAP_PING im lặng quá lâu (kết nối nửa mở), 0 = tắt
+    const char *metrics_address;    // Endpoint Prometheus: "PORT" hoặc "unix:PATH", NULL = tắt
+    uint32_t stall_threshold_ms;    // Handler/vòng lặp chậm hơn ngưỡng vào flight recorder, 0 = tắt
+    const char *capture_path;       // Ghi frame client vào file để phát lại (bench/replay.c), NULL = tắt
+    int capture_anonymize;          // 1 = ẩn danh username/email/chat/tên phòng trong capture
+    int guest_login;                // 1 = chạy không database (--no-db): LOGIN nhận mọi username, id suy từ tên
+    const char *storage;            // Backend lưu trữ (--storage=mysql|memory|sqlite[:PATH]), mặc định "mysql"
+    const char *journal_path;       // Journal ghi khi mất database (--journal=FILE), NULL = tắt (--no-journal)
+} server_config_t;
+
+// Frame ROOM_LIST_RESPONSE đã serialize sẵn, chỉ dựng lại khi room_list_generation() thay đổi
+typedef struct {
+    uint8_t *frame;                 // Header + payload
+    size_t frame_len;
+    size_t capacity;
+    unsigned long generation;       // Thế hệ danh sách lúc dựng frame (0 = chưa dựng)
+    uint32_t seq;                   // Seq ghi trong frame
+    int room_count;
+    uint8_t *zframe;                // Frame MSG_COMPRESSED của cùng danh sách (client CAP_COMPRESSION)
+    size_t zframe_len;              // 0 = chưa nén hoặc nén không nhỏ hơn
+    size_t zcapacity;
+    int zbuilt;                     // 1 = đã thử nén frame hiện tại
+} room_list_cache_t;
+
+// Danh sách phòng đã công bố cho lobby, dùng để tính ROOM_LIST_DELTA
+typedef struct {
+    uint32_t seq;                   // Seq của delta gần nhất (bắt đầu từ 1)
+    unsigned long generation;       // room_list_generation() lúc công bố
+    int room_ids[MAX_ROOMS];        // Phòng đã công bố theo slot server->rooms (0 = trống)
+    unsigned int versions[MAX_ROOMS]; // room->version lúc công bố
+} room_list_published_t;
+
 // Cấu trúc server
 typedef struct server {
     int socket_fd;
@@ -40,6 +102,15 @@ typedef struct server {
     int room_count;                  // Số phòng hiện tại
     fd_set read_fds;
     int max_fd;
+    server_config_t config;         // Cấu hình runtime (gán sau server_init)
+    uint64_t rate_dropped[RATE_CLASS_COUNT]; // Tổng số message bị bỏ do rate limit
+    room_list_cache_t room_list_cache; // Frame danh sách phòng đã cache
+    room_list_published_t room_list_pub; // Trạng thái đã gửi cho lobby
+    int lobby_subscribers[MAX_CLIENTS]; // Client index đang xem sảnh (nhận danh sách phòng)
+    int lobby_subscriber_count;
+    timerheap_t idle_timers;        // Hạn idle của từng client (id = client index)
+    uint64_t idle_reaped;           // Tổng số client bị ngắt do idle
+    metrics_http_t metrics_http;    // Endpoint GET /metrics (phục vụ trong vòng lặp select)
 } server_t;
 
 // Khởi tạo server
@@ -54,6 +125,15 @@ int server_accept_client(server_t *server);
 // Xử lý vòng lặp sự kiện với select()
 void server_event_loop(server_t *server);
 
+/**
+ * Tick định kỳ của vòng lặp sự kiện: ngắt client idle, kết thúc round hết giờ,
+ * đồng bộ đồng hồ round và PING mỗi giây.
+ * Tách riêng để bench/game_sim.c chạy game trong tiến trình với đồng hồ ảo.
+ * @param server Server
+ * @param now_ms Thời gian monotonic hiện tại (utils_now_ms)
+ */
+void server_tick(server_t *server, uint64_t now_ms);
+
 // Xử lý dữ liệu từ client
 void server_handle_client_data(server_t *server, int client_index);
 
@@ -69,6 +149,20 @@ void server_remove_client(server_t *server, int client_index);
 // Dọn dẹp và đóng server
 void server_cleanup(server_t *server);
 
+/**
+ * Đăng ký client nhận cập nhật danh sách phòng (đang xem sảnh), O(1)
+ * @param server Con trỏ đến server_t
+ * @param client_index Index của client
+ */
+void server_lobby_subscribe(server_t *server, int client_index);
+
+/**
+ * Hủy đăng ký nhận cập nhật danh sách phòng (vào phòng, đăng xuất, ngắt kết nối), O(1)
+ * @param server Con trỏ đến server_t
+ * @param client_index Index của client
+ */
+void server_lobby_unsubscribe(server_t *server, int client_index);
+
 /**
  * Tìm room mà client đang ở trong
  * @param server Con trỏ đến server_t
@@ -91,6 +185,24 @@ int server_broadcast_to_room(server_t* server, int room_id, uint8_t msg_type,
                              const uint8_t* payload, uint16_t payload_len, 
                              int exclude_user_id);
 
+/**
+ * Broadcast message đến tất cả clients trong phòng, chọn payload theo capability của từng client
+ * @param server Con trỏ đến server_t
+ * @param room_id Room ID cần broadcast
+ * @param msg_type Message type
+ * @param cap Capability (CAP_*) quyết định client nhận cap_payload
+ * @param cap_payload Payload cho client có cap
+ * @param cap_len Độ dài cap_payload
+ * @param payload Payload cho client không có cap
+ * @param payload_len Độ dài payload
+ * @param exclude_user_id User ID cần loại trừ (hoặc -1 nếu không loại trừ)
+ * @return Số lượng clients đã nhận được message, -1 nếu lỗi
+ */
+int server_broadcast_to_room_by_cap(server_t* server, int room_id, uint8_t msg_type, uint32_t cap,
+                                    const uint8_t* cap_payload, uint16_t cap_len,
+                                    const uint8_t* payload, uint16_t payload_len,
+                                    int exclude_user_id);
+
 /**
  * Broadcast thông báo server shutdown đến tất cả clients đang kết nối
  * @param server Con trỏ đến server_t
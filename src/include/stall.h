@@ -0,0 +1,107 @@
+#ifndef STALL_H
+#define STALL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "metrics.h"
+
+// Bộ phát hiện nghẽn vòng lặp sự kiện: message hoặc vòng lặp xử lý lâu hơn ngưỡng
+// được ghi vào ring buffer trong bộ nhớ, in ra bằng SIGUSR1 hoặc GET /stalls
+#define STALL_DEFAULT_THRESHOLD_MS  50
+#define STALL_RING_SIZE             128     // Giữ các bản ghi mới nhất, ghi đè bản cũ
+
+typedef enum {
+    STALL_KIND_MESSAGE = 0,         // Một handler chạy quá ngưỡng
+    STALL_KIND_LOOP                 // Một vòng lặp (sau select()) quá ngưỡng
+} stall_kind_t;
+
+// Các pha của một vòng lặp sự kiện
+typedef enum {
+    STALL_PHASE_CLIENTS = 0,        // accept + đọc/dispatch message của client
+    STALL_PHASE_TICK,               // Idle reaper, timeout round, TIMER_UPDATE, PING
+    STALL_PHASE_LOBBY,              // Đẩy danh sách phòng cho sảnh, ping DB, metrics
+    STALL_PHASE_COUNT
+} stall_phase_t;
+
+typedef struct {
+    uint64_t seq;                   // Số thứ tự bản ghi (tăng dần từ 1)
+    uint64_t wall_ms;               // Thời điểm ghi (epoch ms) để đối chiếu với log
+    uint64_t duration_ns;
+    uint64_t db_ns;                 // Thời gian DB trong khoảng đo
+    uint32_t db_queries;            // Số truy vấn DB trong khoảng đo
+    stall_kind_t kind;
+    // STALL_KIND_MESSAGE
+    uint8_t msg_type;
+    uint32_t payload_len;
+    int client_index;
+    int user_id;
+    int room_id;                    // 0 nếu client không ở phòng nào
+    // STALL_KIND_LOOP
+    uint32_t messages;              // Số message đã dispatch trong vòng lặp
+    uint64_t phase_ns[STALL_PHASE_COUNT];
+} stall_record_t;
+
+/**
+ * Đặt ngưỡng ghi nhận
+ * @param threshold_ms Ngưỡng (ms), 0 = tắt
+ */
+void stall_configure(uint32_t threshold_ms);
+
+/**
+ * Khoảng thời gian có vượt ngưỡng không (gọi trên mọi message, chỉ một phép so sánh)
+ * @param elapsed_ns Thời gian đo được (ns)
+ * @return 1 nếu cần ghi bản ghi
+ */
+int stall_exceeds(uint64_t elapsed_ns);
+
+/**
+ * Ghi bản ghi vào ring buffer (gán seq và wall_ms)
+ * @param record Bản ghi
+ */
+void stall_push(const stall_record_t *record);
+
+/**
+ * Sao chép các bản ghi hiện có, mới nhất trước
+ * @param out Mảng đích
+ * @param max Số phần tử tối đa
+ * @return Số bản ghi đã sao chép
+ */
+int stall_snapshot(stall_record_t *out, int max);
+
+/**
+ * Tổng số bản ghi từng ghi (kể cả đã bị ghi đè)
+ * @return Số bản ghi
+ */
+uint64_t stall_total(void);
+
+/**
+ * Xóa ring buffer
+ */
+void stall_reset(void);
+
+/**
+ * Xuất ring buffer dạng văn bản (mới nhất trước)
+ * @param text Buffer đích
+ * @param type_name Hàm đặt tên message type (có thể NULL)
+ */
+void stall_write_text(metrics_text_t *text, const char *(*type_name)(uint8_t type));
+
+/**
+ * Yêu cầu in ring buffer ở vòng lặp sự kiện kế tiếp (an toàn trong signal handler)
+ */
+void stall_request_dump(void);
+
+/**
+ * Lấy và xóa yêu cầu in ring buffer
+ * @return 1 nếu có yêu cầu đang chờ
+ */
+int stall_take_dump_request(void);
+
+/**
+ * In ring buffer ra luồng
+ * @param out Luồng đích
+ * @param type_name Hàm đặt tên message type (có thể NULL)
+ */
+void stall_dump(FILE *out, const char *(*type_name)(uint8_t type));
+
+#endif // STALL_H
@@ -0,0 +1,269 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lớp lưu trữ: mọi thao tác persistence của server đi qua đây thay vì gọi thẳng database.c.
+// Backend được chọn một lần lúc khởi động (--storage=mysql|memory|sqlite), trạng thái là toàn cục
+// của module như capture/metrics. Chưa mở backend nào thì mọi hàm trả về lỗi như khi mất DB,
+// caller giữ nguyên kiểu best-effort cũ (game vẫn chạy, chỉ không lưu).
+//
+// Id trả về (user, room, room_player, round) do backend cấp, > 0 nếu thành công.
+//
+// Journal (storage_journal_open): khi backend có ping (MySQL) mất kết nối, các ghi không cần id
+// trả về (đoán, điểm, chat, lịch sử, trạng thái phòng, điểm người chơi, thống kê) được ghi vào
+// journal cục bộ (journal.h) thay vì mất, và được phát lại theo đúng thứ tự từ storage_flush()
+// khi ping thành công trở lại. Trong lúc đó các hàm này trả về "thành công, chưa có id" (0, hoặc 1
+// với lịch sử) và đọc (lịch sử) chưa thấy các ghi đang chờ. Các hàm còn lại (đăng nhập, tạo
+// phòng/round, đọc) trả về lỗi ngay mà không chạm backend: chỉ storage_flush() thử kết nối lại,
+// mỗi 5 giây, để vòng lặp sự kiện không bị chặn bởi timeout kết nối MySQL.
+//
+// Giới hạn: journal chỉ giữ ghi tham chiếu id đã có trong DB. Phòng, người chơi và round tạo trong
+// lúc mất kết nối không có id nên không được lưu, kể cả đoán/điểm/chat của chúng (caller bỏ qua ghi
+// khi id <= 0, game vẫn chạy bình thường); chỉ lịch sử và thống kê theo user_id được giữ. MySQL
+// không kết nối được lúc khởi động thì server chạy không storage, không có journal.
+
+// Cấu trúc để lưu 1 entry lịch sử
+typedef struct {
+    int score;
+    int rank;
+    char finished_at[32]; // YYYY-MM-DD HH:MM:SS format
+} game_history_entry_t;
+
+// Bảng hàm của một backend. ctx là trạng thái riêng do open() trả về.
+// Quy ước giá trị trả về giống các hàm db_* tương ứng trong database.h.
+typedef struct {
+    const char* name;
+    void* (*open)(const char* arg);                 // arg: phần sau "name:" trong --storage, có thể NULL
+    void (*close)(void* ctx);
+    int (*ping)(void* ctx);                         // Giữ kết nối sống, 0 nếu OK (NULL = không cần)
+    int (*flush)(void* ctx);                        // Commit ghi đang gom nếu đến hạn, 0 nếu OK (NULL = ghi ngay)
+    uint64_t (*next_deadline_ms)(void* ctx);        // Hạn flush kế tiếp (utils_now_ms), 0 nếu không có gì chờ
+
+    int (*register_user)(void* ctx, const char* username, const char* password_hash);
+    int (*authenticate_user)(void* ctx, const char* username, const char* password_hash);
+    int (*change_password)(void* ctx, int user_id, const char* old_password_hash, const char* new_password_hash);
+    int (*update_user_stats)(void* ctx, int user_id, int score, int is_win);
+
+    int (*load_words_from_file)(void* ctx, const char* filepath);
+    int (*get_random_word)(void* ctx, const char* difficulty, char* out_word, size_t out_word_size);
+    int (*get_all_words_by_difficulty)(void* ctx, const char* difficulty,
+                                       char words[][64], char categories[][64], int max_words);
+
+    int (*create_room)(void* ctx, const char* room_code, int host_id, int max_players, int total_rounds);
+    int (*set_room_status)(void* ctx, int db_room_id, const char* status);
+    int (*add_room_player)(void* ctx, int db_room_id, int user_id, int join_order);
+    int (*update_room_player_score)(void* ctx, int player_db_id, int score);
+
+    int (*create_game_round)(void* ctx, int db_room_id, int round_number, int turn_index,
+                             int draw_player_db_id, const char* word);
+    int (*save_guess)(void* ctx, int db_round_id, int player_db_id, const char* guess_text, int is_correct);
+    int (*save_score_detail)(void* ctx, int db_round_id, int player_db_id, int score);
+    int (*save_chat_message)(void* ctx, int db_room_id, int player_db_id, const char* message_text);
+
+    int (*save_game_history)(void* ctx, int user_id, int score, int rank);
+    int (*get_game_history)(void* ctx, int user_id, game_history_entry_t* entries, int max_entries);
+} storage_backend_t;
+
+// MySQL qua database.c (storage_mysql.c)
+extern const storage_backend_t storage_mysql_backend;
+
+// Toàn bộ bảng trong bộ nhớ, mất khi dừng server (storage_memory.c): benchmark, CI, demo
+extern const storage_backend_t storage_memory_backend;
+
+// SQLite nhúng, WAL, ghi gom theo giao dịch (storage_sqlite.c): cài đặt một máy không cần MySQL
+extern const storage_backend_t storage_sqlite_backend;
+
+/**
+ * Kiểm tra difficulty của từ
+ * @param difficulty Chuỗi cần kiểm tra
+ * @return 1 nếu là "easy", "medium" hoặc "hard"
+ */
+int storage_difficulty_is_valid(const char* difficulty);
+
+/**
+ * Tách một dòng file từ "word|difficulty|category" tại chỗ (dùng chung cho mọi backend)
+ * Bỏ khoảng trắng hai đầu; thiếu/sai difficulty -> "medium", thiếu category -> "general".
+ * @param line Dòng đọc từ file (bị sửa)
+ * @param word Nhận con trỏ tới từ
+ * @param difficulty Nhận con trỏ tới difficulty
+ * @param category Nhận con trỏ tới category
+ * @return 1 nếu dòng có từ, 0 nếu là dòng trống/ghi chú (#)
+ */
+int storage_parse_word_line(char* line, char** word, char** difficulty, char** category);
+
+/**
+ * Mở backend theo tên, đóng backend đang mở (nếu có)
+ * @param spec "mysql", "memory", "sqlite" hoặc "name:arg" (vd "sqlite:/var/lib/draw_guess.db")
+ * @return 0 nếu thành công, -1 nếu tên không hợp lệ hoặc backend không mở được
+ */
+int storage_open(const char* spec);
+
+/**
+ * Đóng backend đang mở
+ */
+void storage_close(void);
+
+/**
+ * Có backend đang mở không
+ * @return 1 nếu có, 0 nếu server chạy không lưu trữ
+ */
+int storage_available(void);
+
+/**
+ * Tên backend đang mở
+ * @return "mysql", "memory"... hoặc "none"
+ */
+const char* storage_backend_name(void);
+
+/**
+ * Giữ kết nối backend sống (gọi định kỳ từ vòng lặp sự kiện)
+ * @return 0 nếu OK hoặc backend không cần, -1 nếu lỗi hoặc đang mất kết nối (journal tự thử lại)
+ */
+int storage_ping(void);
+
+/**
+ * Commit các ghi đang gom nếu đã đủ lâu (gọi mỗi vòng lặp sự kiện, rẻ khi không có gì để làm)
+ * Có journal: ghi các sự kiện mới xuống đĩa (một write + fdatasync), thử kết nối lại mỗi 5 giây
+ * khi backend đang mất kết nối, rồi phát lại journal tối đa ~5 ms mỗi lần gọi.
+ * @return 0 nếu OK hoặc không có gì để commit, -1 nếu commit lỗi (sẽ thử lại lần sau)
+ */
+int storage_flush(void);
+
+/**
+ * Hạn chót để gọi storage_flush() lần tới (vòng lặp sự kiện rút ngắn timeout select() theo hạn này)
+ * @return Thời điểm monotonic (ms), 0 nếu backend không có ghi nào đang chờ commit
+ */
+uint64_t storage_next_deadline_ms(void);
+
+/**
+ * Mở journal cho backend đang mở (bỏ qua với backend cục bộ không có ping: memory, sqlite)
+ * Còn sự kiện từ lần chạy trước thì ping backend ngay: trả lời được thì phát lại từ storage_flush(),
+ * không thì coi như mất kết nối (thao tác không vào journal được sẽ thất bại đến khi kết nối lại).
+ * @param path Đường dẫn file journal
+ * @return 0 nếu thành công hoặc không cần journal, -1 nếu lỗi (server vẫn chạy, không có journal)
+ */
+int storage_journal_open(const char* path);
+
+/**
+ * Số sự kiện trong journal chưa phát lại vào backend
+ * @return Số sự kiện, 0 nếu không có journal
+ */
+uint64_t storage_journal_pending(void);
+
+/**
+ * Đăng ký người dùng mới
+ * @param username Tên người dùng
+ * @param password_hash Mật khẩu đã hash (SHA256)
+ * @return user_id nếu thành công, -1 nếu thất bại (trùng tên, lỗi backend)
+ */
+int storage_register_user(const char* username, const char* password_hash);
+
+/**
+ * Xác thực người dùng (login)
+ * @param username Tên người dùng
+ * @param password_hash Mật khẩu đã hash (SHA256)
+ * @return user_id nếu thành công, -1 nếu thất bại
+ */
+int storage_authenticate_user(const char* username, const char* password_hash);
+
+/**
+ * Đổi mật khẩu của người dùng
+ * @param user_id ID của người dùng
+ * @param old_password_hash Mật khẩu cũ đã hash
+ * @param new_password_hash Mật khẩu mới đã hash
+ * @return 0 nếu thành công, -1 nếu thất bại
+ */
+int storage_change_password(int user_id, const char* old_password_hash, const char* new_password_hash);
+
+/**
+ * Cộng dồn thống kê người dùng (total_games/total_wins/total_score)
+ * @return 0 nếu thành công (hoặc đã vào journal), -1 nếu thất bại
+ */
+int storage_update_user_stats(int user_id, int score, int is_win);
+
+/**
+ * Nạp danh sách từ từ file (word|difficulty|category mỗi dòng, xem db_load_words_from_file)
+ * @param filepath Đường dẫn file
+ * @return số từ insert/update thành công, -1 nếu lỗi (kể cả không mở được file)
+ */
+int storage_load_words_from_file(const char* filepath);
+
+/**
+ * Lấy 1 từ ngẫu nhiên theo difficulty (NULL/rỗng = bất kỳ), tăng times_used
+ * @return 0 nếu thành công, -1 nếu thất bại
+ */
+int storage_get_random_word(const char* difficulty, char* out_word, size_t out_word_size);
+
+/**
+ * Lấy tất cả từ theo difficulty (NULL/rỗng = tất cả), theo thứ tự nạp
+ * @return Số lượng từ lấy được, -1 nếu lỗi
+ */
+int storage_get_all_words_by_difficulty(const char* difficulty, char words[][64], char categories[][64], int max_words);
+
+/**
+ * Tạo bản ghi phòng
+ * @return rooms.id nếu thành công, -1 nếu thất bại
+ */
+int storage_create_room(const char* room_code, int host_id, int max_players, int total_rounds);
+
+/**
+ * Đổi trạng thái phòng
+ * @param status "waiting", "in_progress" hoặc "finished"
+ * @return 0 nếu thành công (hoặc đã vào journal), -1 nếu thất bại
+ */
+int storage_set_room_status(int db_room_id, const char* status);
+
+/**
+ * Thêm người chơi vào phòng
+ * @return room_players.id nếu thành công, -1 nếu thất bại
+ */
+int storage_add_room_player(int db_room_id, int user_id, int join_order);
+
+/**
+ * Cập nhật điểm cuối của người chơi trong phòng
+ * @return 0 nếu thành công (hoặc đã vào journal), -1 nếu thất bại
+ */
+int storage_update_room_player_score(int player_db_id, int score);
+
+/**
+ * Tạo bản ghi round
+ * @return game_rounds.id nếu thành công, -1 nếu thất bại
+ */
+int storage_create_game_round(int db_room_id, int round_number, int turn_index, int draw_player_db_id, const char* word);
+
+/**
+ * Lưu một lần đoán
+ * @return guesses.id nếu thành công, 0 nếu đã vào journal, -1 nếu thất bại
+ */
+int storage_save_guess(int db_round_id, int player_db_id, const char* guess_text, int is_correct);
+
+/**
+ * Lưu điểm được cộng trong round
+ * @return score_details.id nếu thành công, 0 nếu đã vào journal, -1 nếu thất bại
+ */
+int storage_save_score_detail(int db_round_id, int player_db_id, int score);
+
+/**
+ * Lưu tin nhắn chat trong phòng
+ * @return chat_messages.id nếu thành công, 0 nếu đã vào journal, -1 nếu thất bại
+ */
+int storage_save_chat_message(int db_room_id, int player_db_id, const char* message_text);
+
+/**
+ * Lưu lịch sử chơi của người dùng
+ * @param rank Thứ hạng (1 = thắng, 2 = hạng 2, ...)
+ * @return 1 nếu thành công (hoặc đã vào journal), 0 nếu thất bại
+ */
+int storage_save_game_history(int user_id, int score, int rank);
+
+/**
+ * Lấy lịch sử chơi của người dùng, mới nhất trước
+ * @param entries Mảng để lưu lịch sử (phải được cấp phát trước)
+ * @param max_entries Số lượng entry tối đa
+ * @return Số lượng entry thực tế lấy được, -1 nếu lỗi
+ */
+int storage_get_game_history(int user_id, game_history_entry_t* entries, int max_entries);
+
+#endif // STORAGE_H
@@ -0,0 +1,99 @@
+#ifndef STROKE_H
+#define STROKE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "drawing.h"
+
+// Log nét vẽ theo round: gom các đoạn LINE/ERASE liên tiếp (điểm đầu đoạn sau
+// trùng điểm cuối đoạn trước, cùng màu và độ rộng) thành một nét (polyline),
+// rồi đơn giản hóa bằng Ramer–Douglas–Peucker khi nét kết thúc.
+#define STROKE_DEFAULT_TOLERANCE 1.0   // Sai số tối đa (pixel canvas chuẩn)
+#define STROKE_LOG_MAX_POINTS 200000   // Giới hạn số điểm mỗi round để chặn bộ nhớ
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} stroke_point_t;
+
+typedef struct {
+    draw_action_type_t action;     // DRAW_ACTION_LINE hoặc DRAW_ACTION_ERASE
+    uint32_t color;
+    uint8_t width;
+    stroke_point_t *points;
+    int point_count;
+    int capacity;
+} stroke_t;
+
+typedef struct stroke_log {
+    stroke_t *strokes;
+    int stroke_count;
+    int capacity;
+    bool last_open;                // Nét cuối cùng còn đang vẽ (chưa đơn giản hóa)
+    double tolerance;              // <= 0 thì không đơn giản hóa
+    size_t raw_points;             // Tổng số điểm nhận được (trước khi đơn giản hóa)
+    size_t stored_points;          // Tổng số điểm đang lưu
+    bool overflow;                 // true nếu đã vượt STROKE_LOG_MAX_POINTS
+} stroke_log_t;
+
+/**
+ * Hàm callback cho stroke_log_replay, nhận từng đoạn thẳng đã tái tạo
+ * @return 0 để tiếp tục, khác 0 để dừng
+ */
+typedef int (*stroke_segment_cb)(const draw_action_t *action, void *ctx);
+
+/**
+ * Tạo log nét vẽ rỗng
+ * @param tolerance Sai số RDP (pixel), <= 0 để giữ nguyên mọi điểm
+ * @return Con trỏ đến stroke_log_t nếu thành công, NULL nếu thất bại
+ */
+stroke_log_t *stroke_log_create(double tolerance);
+
+/**
+ * Hủy log nét vẽ và giải phóng bộ nhớ
+ * @param log Con trỏ đến stroke_log_t
+ */
+void stroke_log_destroy(stroke_log_t *log);
+
+/**
+ * Xóa toàn bộ nét trong log (giữ lại bộ nhớ đã cấp phát để dùng cho round sau)
+ * @param log Con trỏ đến stroke_log_t
+ */
+void stroke_log_reset(stroke_log_t *log);
+
+/**
+ * Ghi một hành động vẽ vào log
+ * LINE/ERASE nối tiếp nét đang mở hoặc mở nét mới, MOVE đóng nét, CLEAR xóa log
+ * @param log Con trỏ đến stroke_log_t
+ * @param action Hành động vẽ đã được validate
+ * @return 0 nếu thành công, -1 nếu lỗi hoặc log đã đầy
+ */
+int stroke_log_append(stroke_log_t *log, const draw_action_t *action);
+
+/**
+ * Đóng nét đang mở (nếu có) và đơn giản hóa nó
+ * @param log Con trỏ đến stroke_log_t
+ */
+void stroke_log_finish(stroke_log_t *log);
+
+/**
+ * Tái tạo các đoạn thẳng từ log theo đúng thứ tự đã vẽ
+ * @param log Con trỏ đến stroke_log_t
+ * @param cb Hàm nhận từng đoạn
+ * @param ctx Con trỏ ngữ cảnh truyền cho cb
+ * @return Số đoạn đã gửi cho cb
+ */
+int stroke_log_replay(const stroke_log_t *log, stroke_segment_cb cb, void *ctx);
+
+/**
+ * Đơn giản hóa polyline bằng Ramer–Douglas–Peucker (tại chỗ, không đệ quy)
+ * Luôn giữ điểm đầu và điểm cuối.
+ * @param points Mảng điểm (bị ghi đè bằng các điểm được giữ lại)
+ * @param count Số điểm đầu vào
+ * @param tolerance Khoảng cách tối đa cho phép từ điểm bị bỏ tới đoạn thay thế
+ * @return Số điểm còn lại
+ */
+int stroke_simplify_rdp(stroke_point_t *points, int count, double tolerance);
+
+#endif // STROKE_H
@@ -0,0 +1,67 @@
+#ifndef TIMERHEAP_H
+#define TIMERHEAP_H
+
+#include <stdint.h>
+
+// Min-heap hạn chót theo id (0..capacity-1), mỗi id tối đa một timer
+// Đặt/xóa/lấy timer sớm nhất O(log n), không cần quét toàn bộ client
+typedef struct {
+    uint64_t deadline_ms;
+    int id;
+} timerheap_entry_t;
+
+typedef struct {
+    timerheap_entry_t *entries;     // entries[0] là timer sớm nhất
+    int *pos;                       // pos[id] = vị trí trong entries, -1 nếu id không có timer
+    int size;
+    int capacity;
+} timerheap_t;
+
+/**
+ * Khởi tạo heap cho các id 0..capacity-1
+ * @param heap Heap cần khởi tạo
+ * @param capacity Số id tối đa
+ * @return 0 nếu thành công, -1 nếu hết bộ nhớ
+ */
+int timerheap_init(timerheap_t *heap, int capacity);
+
+/**
+ * Giải phóng heap
+ * @param heap Heap
+ */
+void timerheap_free(timerheap_t *heap);
+
+/**
+ * Đặt (hoặc dời) hạn chót cho id
+ * @param heap Heap
+ * @param id Id của timer
+ * @param deadline_ms Hạn chót (ms monotonic)
+ * @return 0 nếu thành công, -1 nếu id không hợp lệ
+ */
+int timerheap_set(timerheap_t *heap, int id, uint64_t deadline_ms);
+
+/**
+ * Hủy timer của id (không làm gì nếu id không có timer)
+ * @param heap Heap
+ * @param id Id của timer
+ */
+void timerheap_remove(timerheap_t *heap, int id);
+
+/**
+ * Xem timer sớm nhất
+ * @param heap Heap
+ * @param id_out Id của timer (có thể NULL)
+ * @param deadline_out Hạn chót (có thể NULL)
+ * @return 0 nếu có timer, -1 nếu heap rỗng
+ */
+int timerheap_peek(const timerheap_t *heap, int *id_out, uint64_t *deadline_out);
+
+/**
+ * Lấy ra timer sớm nhất nếu đã đến hạn
+ * @param heap Heap
+ * @param now_ms Thời gian hiện tại
+ * @return Id của timer đến hạn, -1 nếu không có
+ */
+int timerheap_pop_expired(timerheap_t *heap, uint64_t now_ms);
+
+#endif // TIMERHEAP_H
@@ -0,0 +1,52 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdint.h>
+
+/**
+ * Lấy thời gian monotonic hiện tại (không bị ảnh hưởng khi đổi giờ hệ thống)
+ * @return Số mili giây kể từ một mốc cố định
+ */
+uint64_t utils_now_ms(void);
+
+/**
+ * Lấy thời gian thực hiện tại (epoch), chỉ dùng để gửi cho client
+ * @return Số mili giây kể từ 1970-01-01 UTC
+ */
+uint64_t utils_wall_ms(void);
+
+/**
+ * Lấy thời gian monotonic độ phân giải nano giây (đo độ trễ xử lý)
+ * @return Số nano giây kể từ một mốc cố định
+ */
+uint64_t utils_now_ns(void);
+
+/**
+ * Chuyển sang đồng hồ ảo (mô phỏng trong tiến trình, bench/game_sim.c):
+ * utils_now_* / utils_wall_ms chỉ đổi khi gọi utils_clock_advance_ms.
+ * Monotonic ảo bắt đầu từ 1 giây (0 là giá trị "chưa đặt" của các timer).
+ * @param wall_start_ms Thời gian thực ảo lúc bắt đầu (epoch ms)
+ */
+void utils_clock_set_virtual(uint64_t wall_start_ms);
+
+/**
+ * Tiến đồng hồ ảo (không làm gì nếu đang dùng đồng hồ hệ thống)
+ * @param ms Số mili giây
+ */
+void utils_clock_advance_ms(uint64_t ms);
+
+/**
+ * Quay lại đồng hồ hệ thống
+ */
+void utils_clock_set_real(void);
+
+/**
+ * So sánh từ đoán với từ khóa, không phân biệt hoa thường (ASCII)
+ * Mỗi chuỗi chỉ xét tối đa 127 byte đầu
+ * @param a Chuỗi thứ nhất
+ * @param b Chuỗi thứ hai
+ * @return 1 nếu bằng nhau, 0 nếu khác hoặc một chuỗi NULL
+ */
+int utils_words_equal_ci(const char *a, const char *b);
+
+#endif // UTILS_H
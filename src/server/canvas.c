@@ -0,0 +1,340 @@
+#include "../include/canvas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <zstd.h>
+
+// Tao canvas moi
+canvas_t *canvas_create(uint16_t width, uint16_t height)
+{
+    if (width == 0 || height == 0 || width > MAX_CANVAS_WIDTH || height > MAX_CANVAS_HEIGHT)
+    {
+        fprintf(stderr, "Kich thuoc canvas khong hop le: %ux%u\n", width, height);
+        return NULL;
+    }
+
+    canvas_t *canvas = (canvas_t *)calloc(1, sizeof(canvas_t));
+    if (!canvas)
+    {
+        fprintf(stderr, "Khong the cap phat bo nho cho canvas\n");
+        return NULL;
+    }
+
+    canvas->pixels = (uint8_t *)malloc((size_t)width * height);
+    if (!canvas->pixels)
+    {
+        fprintf(stderr, "Khong the cap phat bo nho pixel cho canvas %ux%u\n", width, height);
+        free(canvas);
+        return NULL;
+    }
+
+    canvas->width = width;
+    canvas->height = height;
+    canvas->snapshot = NULL;
+    canvas->snapshot_len = 0;
+    canvas_clear(canvas);
+
+    return canvas;
+}
+
+// Huy canvas
+void canvas_destroy(canvas_t *canvas)
+{
+    if (!canvas)
+    {
+        return;
+    }
+
+    free(canvas->pixels);
+    free(canvas->snapshot);
+    free(canvas);
+}
+
+// Xoa canvas ve nen
+void canvas_clear(canvas_t *canvas)
+{
+    if (!canvas)
+    {
+        return;
+    }
+
+    memset(canvas->pixels, CANVAS_BACKGROUND_INDEX, (size_t)canvas->width * canvas->height);
+
+    // Index 0 la nen trong suot (giong clearRect o frontend)
+    memset(canvas->palette, 0, sizeof(canvas->palette));
+    canvas->palette_count = 1;
+    canvas->stroke_count = 0;
+    canvas->snapshot_dirty = true;
+}
+
+// Lay chi so mau, them vao palette neu chua co
+uint8_t canvas_color_index(canvas_t *canvas, uint32_t color)
+{
+    // Bo qua index 0 (nen) khi tim kiem
+    for (int i = 1; i < canvas->palette_count; i++)
+    {
+        if (canvas->palette[i] == color)
+        {
+            return (uint8_t)i;
+        }
+    }
+
+    if (canvas->palette_count < CANVAS_PALETTE_SIZE)
+    {
+        canvas->palette[canvas->palette_count] = color;
+        return (uint8_t)canvas->palette_count++;
+    }
+
+    // Palette day: chon mau gan nhat theo khoang cach RGBA
+    int best = 1;
+    uint32_t best_dist = UINT32_MAX;
+    for (int i = 1; i < canvas->palette_count; i++)
+    {
+        uint32_t dist = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            int a = (int)((color >> shift) & 0xFF);
+            int b = (int)((canvas->palette[i] >> shift) & 0xFF);
+            dist += (uint32_t)((a - b) * (a - b));
+        }
+        if (dist < best_dist)
+        {
+            best_dist = dist;
+            best = i;
+        }
+    }
+    return (uint8_t)best;
+}
+
+/**
+ * Thu hep khoang [lo, hi] theo rang buoc a <= c*x + k <= b
+ * Tra ve false neu khoang rong
+ */
+static bool clip_linear(double c, double k, double a, double b, double *lo, double *hi)
+{
+    if (c == 0.0)
+    {
+        return k >= a && k <= b;
+    }
+
+    double t1 = (a - k) / c;
+    double t2 = (b - k) / c;
+    if (t1 > t2)
+    {
+        double tmp = t1;
+        t1 = t2;
+        t2 = tmp;
+    }
+    if (t1 > *lo)
+        *lo = t1;
+    if (t2 < *hi)
+        *hi = t2;
+    return *lo <= *hi;
+}
+
+/**
+ * Khoang x bi hinh tron (cx, cy, r) cat tai hang y
+ */
+static bool disc_span(double cx, double cy, double r, double y, double *lo, double *hi)
+{
+    double dy = y - cy;
+    double rem = r * r - dy * dy;
+    if (rem < 0.0)
+    {
+        return false;
+    }
+    double half = sqrt(rem);
+    *lo = cx - half;
+    *hi = cx + half;
+    return true;
+}
+
+// Ve doan thang day bang cach to tung hang ngang
+void canvas_draw_line(canvas_t *canvas, int x1, int y1, int x2, int y2,
+                      uint8_t width, uint8_t color_index)
+{
+    if (!canvas)
+    {
+        return;
+    }
+
+    // Hinh vien thuoc = hinh chu nhat quanh doan thang + 2 hinh tron o hai dau
+    // (tuong duong lineCap = 'round' o frontend)
+    double r = width / 2.0;
+    if (r < 0.5)
+    {
+        r = 0.5;
+    }
+
+    double dx = (double)(x2 - x1);
+    double dy = (double)(y2 - y1);
+    double len2 = dx * dx + dy * dy;
+    double len = sqrt(len2);
+
+    int y_min = (int)floor((y1 < y2 ? y1 : y2) - r);
+    int y_max = (int)ceil((y1 > y2 ? y1 : y2) + r);
+    if (y_min < 0)
+        y_min = 0;
+    if (y_max > canvas->height - 1)
+        y_max = canvas->height - 1;
+
+    for (int y = y_min; y <= y_max; y++)
+    {
+        double row_lo = INFINITY, row_hi = -INFINITY;
+        double lo, hi;
+
+        if (disc_span(x1, y1, r, y, &lo, &hi))
+        {
+            row_lo = fmin(row_lo, lo);
+            row_hi = fmax(row_hi, hi);
+        }
+        if (disc_span(x2, y2, r, y, &lo, &hi))
+        {
+            row_lo = fmin(row_lo, lo);
+            row_hi = fmax(row_hi, hi);
+        }
+
+        if (len2 > 0.0)
+        {
+            // Diem (x, y) thuoc hinh chu nhat khi:
+            //   0 <= (x - x1)*dx + (y - y1)*dy <= len2      (hinh chieu nam trong doan)
+            //   |(x - x1)*dy - (y - y1)*dx| <= r * len      (khoang cach toi duong thang)
+            lo = -INFINITY;
+            hi = INFINITY;
+            double ry = (double)(y - y1);
+            if (clip_linear(dx, ry * dy - x1 * dx, 0.0, len2, &lo, &hi) &&
+                clip_linear(dy, -x1 * dy - ry * dx, -r * len, r * len, &lo, &hi))
+            {
+                row_lo = fmin(row_lo, lo);
+                row_hi = fmax(row_hi, hi);
+            }
+        }
+
+        if (row_lo > row_hi)
+        {
+            continue;
+        }
+
+        // Hinh vien thuoc la loi nen giao voi moi hang la mot khoang lien tuc
+        int xs = (int)ceil(row_lo - 1e-9);
+        int xe = (int)floor(row_hi + 1e-9);
+        if (xs < 0)
+            xs = 0;
+        if (xe > canvas->width - 1)
+            xe = canvas->width - 1;
+        if (xs > xe)
+        {
+            continue;
+        }
+
+        memset(canvas->pixels + (size_t)y * canvas->width + xs, color_index, (size_t)(xe - xs + 1));
+    }
+}
+
+// Ap dung hanh dong ve len canvas
+int canvas_apply_action(canvas_t *canvas, const draw_action_t *action)
+{
+    if (!canvas || !action)
+    {
+        return -1;
+    }
+
+    switch (action->action)
+    {
+    case DRAW_ACTION_MOVE:
+        return 0;
+
+    case DRAW_ACTION_CLEAR:
+        canvas_clear(canvas);
+        return 0;
+
+    case DRAW_ACTION_LINE:
+        canvas_draw_line(canvas, action->x1, action->y1, action->x2, action->y2,
+                         action->width, canvas_color_index(canvas, action->color));
+        break;
+
+    case DRAW_ACTION_ERASE:
+        canvas_draw_line(canvas, action->x1, action->y1, action->x2, action->y2,
+                         action->width, CANVAS_BACKGROUND_INDEX);
+        break;
+
+    default:
+        return -1;
+    }
+
+    canvas->stroke_count++;
+    canvas->snapshot_dirty = true;
+    return 0;
+}
+
+// Lay snapshot da nen (tao lai neu co net moi)
+int canvas_get_snapshot(canvas_t *canvas, const uint8_t **data_out, size_t *len_out)
+{
+    if (!canvas || !data_out || !len_out)
+    {
+        return -1;
+    }
+
+    if (!canvas->snapshot_dirty && canvas->snapshot)
+    {
+        *data_out = canvas->snapshot;
+        *len_out = canvas->snapshot_len;
+        return 0;
+    }
+
+    size_t raw_len = (size_t)canvas->width * canvas->height;
+    size_t header_len = CANVAS_SNAPSHOT_HEADER_SIZE + (size_t)canvas->palette_count * 4;
+    size_t bound = ZSTD_compressBound(raw_len);
+
+    uint8_t *buffer = (uint8_t *)malloc(header_len + bound);
+    if (!buffer)
+    {
+        fprintf(stderr, "Khong the cap phat bo nho cho snapshot canvas\n");
+        return -1;
+    }
+
+    // Header: [width:2][height:2][palette_count:2] (big-endian)
+    buffer[0] = (uint8_t)(canvas->width >> 8);
+    buffer[1] = (uint8_t)(canvas->width & 0xFF);
+    buffer[2] = (uint8_t)(canvas->height >> 8);
+    buffer[3] = (uint8_t)(canvas->height & 0xFF);
+    buffer[4] = (uint8_t)((canvas->palette_count >> 8) & 0xFF);
+    buffer[5] = (uint8_t)(canvas->palette_count & 0xFF);
+
+    uint8_t *p = buffer + CANVAS_SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < canvas->palette_count; i++)
+    {
+        uint32_t c = canvas->palette[i];
+        p[0] = (uint8_t)(c >> 24);
+        p[1] = (uint8_t)(c >> 16);
+        p[2] = (uint8_t)(c >> 8);
+        p[3] = (uint8_t)c;
+        p += 4;
+    }
+
+    size_t compressed = ZSTD_compress(buffer + header_len, bound, canvas->pixels, raw_len,
+                                      CANVAS_SNAPSHOT_ZSTD_LEVEL);
+    if (ZSTD_isError(compressed))
+    {
+        fprintf(stderr, "Loi nen snapshot canvas: %s\n", ZSTD_getErrorName(compressed));
+        free(buffer);
+        return -1;
+    }
+
+    // Thu gon buffer ve dung kich thuoc (bound co the lon hon nhieu)
+    uint8_t *shrunk = (uint8_t *)realloc(buffer, header_len + compressed);
+    if (shrunk)
+    {
+        buffer = shrunk;
+    }
+
+    free(canvas->snapshot);
+    canvas->snapshot = buffer;
+    canvas->snapshot_len = header_len + compressed;
+    canvas->snapshot_dirty = false;
+
+    *data_out = canvas->snapshot;
+    *len_out = canvas->snapshot_len;
+    return 0;
+}
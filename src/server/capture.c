@@ -0,0 +1,541 @@
+#include "../include/capture.h"
+#include "../include/sha256.h"
+#include "../include/utils.h"
+#include "../common/protocol.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// ============================================
+// Varint LEB128
+// ============================================
+
+static size_t varint_encode(uint64_t value, uint8_t out[10])
+{
+    size_t n = 0;
+    do
+    {
+        uint8_t byte = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        out[n++] = value ? (uint8_t)(byte | 0x80) : byte;
+    } while (value);
+    return n;
+}
+
+// Tra ve 1 neu doc duoc, 0 neu EOF ngay byte dau, -1 neu cat cut/qua dai
+static int varint_read(FILE *f, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int c = fgetc(f);
+        if (c == EOF)
+        {
+            return shift == 0 ? 0 : -1;
+        }
+        result |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+        {
+            *value = result;
+            return 1;
+        }
+    }
+    return -1;
+}
+
+// ============================================
+// Writer / Reader
+// ============================================
+
+int capture_writer_open(capture_writer_t *w, const char *path, uint8_t flags)
+{
+    memset(w, 0, sizeof(*w));
+    w->f = fopen(path, "wb");
+    if (!w->f)
+    {
+        perror("capture fopen");
+        return -1;
+    }
+    // Buffer lon: server ghi moi frame, flush theo buffer thay vi theo ban ghi
+    setvbuf(w->f, NULL, _IOFBF, 64 * 1024);
+
+    uint8_t header[CAPTURE_HEADER_SIZE] = {0};
+    memcpy(header, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN);
+    header[5] = CAPTURE_VERSION;
+    header[6] = flags;
+    uint64_t wall_ms = utils_wall_ms();
+    for (int i = 0; i < 8; i++)
+    {
+        header[8 + i] = (uint8_t)(wall_ms >> (56 - 8 * i));
+    }
+    if (fwrite(header, 1, sizeof(header), w->f) != sizeof(header))
+    {
+        perror("capture fwrite");
+        fclose(w->f);
+        w->f = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int capture_writer_write(capture_writer_t *w, const capture_record_t *rec)
+{
+    if (!w->f || w->failed)
+    {
+        return -1;
+    }
+    uint8_t head[1 + 10 + 10 + 1 + 10];
+    size_t n = 0;
+    uint64_t dt = rec->t_us > w->last_t_us ? rec->t_us - w->last_t_us : 0;
+    head[n++] = (uint8_t)rec->kind;
+    n += varint_encode(rec->session, head + n);
+    n += varint_encode(dt, head + n);
+    if (rec->kind == CAPTURE_FRAME)
+    {
+        head[n++] = rec->type;
+        n += varint_encode(rec->len, head + n);
+    }
+    else if (rec->kind == CAPTURE_ROOM)
+    {
+        n += varint_encode((uint32_t)rec->room_id, head + n);
+    }
+
+    if (fwrite(head, 1, n, w->f) != n ||
+        (rec->kind == CAPTURE_FRAME && rec->len > 0 && fwrite(rec->payload, 1, rec->len, w->f) != rec->len))
+    {
+        perror("capture fwrite");
+        w->failed = 1;
+        return -1;
+    }
+    w->last_t_us += dt;
+    w->records++;
+    return 0;
+}
+
+int capture_writer_close(capture_writer_t *w)
+{
+    if (!w->f)
+    {
+        return -1;
+    }
+    int failed = w->failed;
+    if (fclose(w->f) != 0)
+    {
+        perror("capture fclose");
+        failed = 1;
+    }
+    w->f = NULL;
+    return failed ? -1 : 0;
+}
+
+int capture_reader_open(capture_reader_t *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+    r->f = fopen(path, "rb");
+    if (!r->f)
+    {
+        perror("capture fopen");
+        return -1;
+    }
+    uint8_t header[CAPTURE_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), r->f) != sizeof(header) ||
+        memcmp(header, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN) != 0)
+    {
+        fprintf(stderr, "%s: khong phai file capture\n", path);
+        capture_reader_close(r);
+        return -1;
+    }
+    if (header[5] != CAPTURE_VERSION)
+    {
+        fprintf(stderr, "%s: phien ban capture %u khong ho tro (can %u)\n", path, header[5], CAPTURE_VERSION);
+        capture_reader_close(r);
+        return -1;
+    }
+    r->version = header[5];
+    r->flags = header[6];
+    for (int i = 0; i < 8; i++)
+    {
+        r->start_wall_ms = (r->start_wall_ms << 8) | header[8 + i];
+    }
+    return 0;
+}
+
+int capture_reader_next(capture_reader_t *r, capture_record_t *rec)
+{
+    int kind = fgetc(r->f);
+    if (kind == EOF)
+    {
+        return 0;
+    }
+    memset(rec, 0, sizeof(*rec));
+    rec->kind = (capture_kind_t)kind;
+
+    uint64_t session, dt;
+    if (varint_read(r->f, &session) != 1 || varint_read(r->f, &dt) != 1 || session > UINT32_MAX)
+    {
+        return -1;
+    }
+    rec->session = (uint32_t)session;
+    r->t_us += dt;
+    rec->t_us = r->t_us;
+
+    switch (rec->kind)
+    {
+    case CAPTURE_OPEN:
+    case CAPTURE_CLOSE:
+        return 1;
+    case CAPTURE_ROOM:
+    {
+        uint64_t room_id;
+        if (varint_read(r->f, &room_id) != 1 || room_id > UINT32_MAX)
+        {
+            return -1;
+        }
+        rec->room_id = (int32_t)(uint32_t)room_id;
+        return 1;
+    }
+    case CAPTURE_FRAME:
+    {
+        int type = fgetc(r->f);
+        uint64_t len;
+        if (type == EOF || varint_read(r->f, &len) != 1 || len > MSG_MAX_PAYLOAD_SIZE)
+        {
+            return -1;
+        }
+        if (len > r->capacity)
+        {
+            uint8_t *grown = realloc(r->buf, (size_t)len);
+            if (!grown)
+            {
+                return -1;
+            }
+            r->buf = grown;
+            r->capacity = (size_t)len;
+        }
+        if (len > 0 && fread(r->buf, 1, (size_t)len, r->f) != len)
+        {
+            return -1;
+        }
+        rec->type = (uint8_t)type;
+        rec->len = (uint32_t)len;
+        rec->payload = r->buf;
+        return 1;
+    }
+    }
+    return -1;
+}
+
+void capture_reader_close(capture_reader_t *r)
+{
+    if (r->f)
+    {
+        fclose(r->f);
+    }
+    free(r->buf);
+    memset(r, 0, sizeof(*r));
+}
+
+// ============================================
+// Xoa du lieu nhay cam
+// ============================================
+
+void capture_anonymizer_init(capture_anonymizer_t *a)
+{
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t got = f ? fread(a->salt, 1, sizeof(a->salt), f) : 0;
+    if (f)
+    {
+        fclose(f);
+    }
+    if (got != sizeof(a->salt))
+    {
+        uint64_t seed = utils_now_ns() ^ ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL);
+        for (size_t i = 0; i < sizeof(a->salt); i++)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            a->salt[i] = (uint8_t)(seed >> 56);
+        }
+    }
+}
+
+// sha256(salt || tag || value): tag tach khong gian ten (username "abc" va phong "abc" khac bi danh)
+static void anon_hash(const capture_anonymizer_t *a, char tag, const uint8_t *value, size_t len, uint8_t out[32])
+{
+    uint8_t input[16 + 1 + 256];
+    if (len > 256)
+    {
+        len = 256;
+    }
+    memcpy(input, a->salt, 16);
+    input[16] = (uint8_t)tag;
+    memcpy(input + 17, value, len);
+    sha256(input, 17 + len, out);
+}
+
+// Truong FSTR [off, off+size): doc chuoi (toi da size - 1 byte), bo qua neu payload ngan hon
+static int fstr_get(const uint8_t *payload, size_t len, size_t off, size_t size, char *out)
+{
+    if (off + size > len)
+    {
+        return -1;
+    }
+    memcpy(out, payload + off, size - 1);
+    out[size - 1] = '\0';
+    return 0;
+}
+
+static void fstr_set(uint8_t *payload, size_t len, size_t off, size_t size, const char *value)
+{
+    if (off + size > len)
+    {
+        return;
+    }
+    memset(payload + off, 0, size);
+    size_t n = strlen(value);
+    memcpy(payload + off, value, n < size - 1 ? n : size - 1);
+}
+
+static void scrub_password(uint8_t *payload, size_t len, size_t off)
+{
+    fstr_set(payload, len, off, MAX_PASSWORD_LEN, CAPTURE_REPLAY_PASSWORD);
+}
+
+// Thay truong bang prefix + 10 ky tu hex cua hash + suffix (chuoi rong giu nguyen)
+static void scrub_alias(const capture_anonymizer_t *a, char tag, uint8_t *payload, size_t len,
+                        size_t off, size_t size, const char *prefix, const char *suffix)
+{
+    char value[256];
+    if (fstr_get(payload, len, off, size, value) != 0 || value[0] == '\0')
+    {
+        return;
+    }
+    uint8_t hash[32];
+    anon_hash(a, tag, (const uint8_t *)value, strlen(value), hash);
+    char alias[256];
+    snprintf(alias, sizeof(alias), "%s%02x%02x%02x%02x%02x%s", prefix,
+             hash[0], hash[1], hash[2], hash[3], hash[4], suffix);
+    fstr_set(payload, len, off, size, alias);
+}
+
+// Moi tu (chuoi byte khong phai khoang trang) thanh chu cai gia cung do dai,
+// cung tu cho cung ket qua nen ty le lap tu/do dai tin nhan van giong ban goc
+static void scrub_text(const capture_anonymizer_t *a, uint8_t *text, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        if (text[i] <= ' ')
+        {
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < len && text[i] > ' ')
+        {
+            i++;
+        }
+        uint8_t hash[32];
+        anon_hash(a, 't', text + start, i - start, hash);
+        for (size_t k = start; k < i; k++)
+        {
+            text[k] = (uint8_t)('a' + hash[(k - start) % 32] % 26);
+        }
+    }
+}
+
+void capture_scrub(const capture_anonymizer_t *a, uint8_t type, uint8_t *payload, size_t len)
+{
+    if (!payload)
+    {
+        return;
+    }
+    switch (type)
+    {
+    case MSG_LOGIN_REQUEST:
+        scrub_password(payload, len, MAX_USERNAME_LEN);
+        if (a)
+        {
+            scrub_alias(a, 'u', payload, len, 0, MAX_USERNAME_LEN, "u_", "");
+        }
+        break;
+    case MSG_REGISTER_REQUEST:
+        scrub_password(payload, len, MAX_USERNAME_LEN);
+        if (a)
+        {
+            scrub_alias(a, 'u', payload, len, 0, MAX_USERNAME_LEN, "u_", "");
+            scrub_alias(a, 'e', payload, len, MAX_USERNAME_LEN + MAX_PASSWORD_LEN, MAX_EMAIL_LEN,
+                        "", "@example.invalid");
+        }
+        break;
+    case MSG_CHANGE_PASSWORD_REQUEST:
+        scrub_password(payload, len, 0);
+        scrub_password(payload, len, MAX_PASSWORD_LEN);
+        break;
+    case MSG_CREATE_ROOM:
+        if (a)
+        {
+            scrub_alias(a, 'r', payload, len, 0, MAX_ROOM_NAME_LEN, "room_", "");
+        }
+        break;
+    case MSG_CHAT_MESSAGE:
+    case MSG_GUESS_WORD:
+        if (a)
+        {
+            scrub_text(a, payload, len);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// ============================================
+// Capture phia server
+// ============================================
+
+static capture_writer_t writer;
+static capture_anonymizer_t anonymizer;
+static int active = 0;
+static int anonymize_enabled = 0;
+static uint64_t start_ns = 0;
+static uint32_t sessions[CAPTURE_MAX_SLOTS];    // Phien hien tai cua tung slot client, 0 = chua mo
+static uint32_t next_session = 1;
+static uint8_t *scratch = NULL;                 // Ban sao payload de xoa du lieu nhay cam
+static size_t scratch_capacity = 0;
+
+int capture_start(const char *path, int anonymize)
+{
+    if (active)
+    {
+        capture_stop();
+    }
+    if (capture_writer_open(&writer, path, anonymize ? CAPTURE_FLAG_ANONYMIZED : 0) != 0)
+    {
+        return -1;
+    }
+    if (anonymize)
+    {
+        capture_anonymizer_init(&anonymizer);
+    }
+    anonymize_enabled = anonymize;
+    memset(sessions, 0, sizeof(sessions));
+    next_session = 1;
+    start_ns = utils_now_ns();
+    active = 1;
+    return 0;
+}
+
+int capture_active(void)
+{
+    return active;
+}
+
+static uint64_t elapsed_us(void)
+{
+    return (utils_now_ns() - start_ns) / 1000u;
+}
+
+static void write_or_stop(const capture_record_t *rec)
+{
+    if (capture_writer_write(&writer, rec) != 0)
+    {
+        // Khong dung server vi capture: bao mot lan va tat
+        fprintf(stderr, "Capture: loi ghi file, dung capture sau %llu ban ghi\n",
+                (unsigned long long)writer.records);
+        capture_stop();
+    }
+}
+
+void capture_session_open(int client_index)
+{
+    if (!active || client_index < 0 || client_index >= CAPTURE_MAX_SLOTS)
+    {
+        return;
+    }
+    sessions[client_index] = next_session++;
+    capture_record_t rec = {.kind = CAPTURE_OPEN, .session = sessions[client_index], .t_us = elapsed_us()};
+    write_or_stop(&rec);
+}
+
+void capture_session_close(int client_index)
+{
+    if (!active || client_index < 0 || client_index >= CAPTURE_MAX_SLOTS || sessions[client_index] == 0)
+    {
+        return;
+    }
+    capture_record_t rec = {.kind = CAPTURE_CLOSE, .session = sessions[client_index], .t_us = elapsed_us()};
+    sessions[client_index] = 0;
+    write_or_stop(&rec);
+    // Ngat ket noi it xay ra: flush de file dung duoc ngay ca khi server bi kill
+    if (active)
+    {
+        fflush(writer.f);
+    }
+}
+
+void capture_frame(int client_index, uint8_t type, const uint8_t *payload, uint32_t len)
+{
+    if (!active || client_index < 0 || client_index >= CAPTURE_MAX_SLOTS || sessions[client_index] == 0)
+    {
+        return;
+    }
+    if (len > scratch_capacity)
+    {
+        uint8_t *grown = realloc(scratch, len);
+        if (!grown)
+        {
+            return;
+        }
+        scratch = grown;
+        scratch_capacity = len;
+    }
+    if (len > 0)
+    {
+        memcpy(scratch, payload, len);
+    }
+    capture_scrub(anonymize_enabled ? &anonymizer : NULL, type, scratch, len);
+
+    capture_record_t rec = {
+        .kind = CAPTURE_FRAME,
+        .session = sessions[client_index],
+        .t_us = elapsed_us(),
+        .type = type,
+        .len = len,
+        .payload = scratch,
+    };
+    write_or_stop(&rec);
+}
+
+void capture_room_created(int client_index, int room_id)
+{
+    if (!active || client_index < 0 || client_index >= CAPTURE_MAX_SLOTS || sessions[client_index] == 0)
+    {
+        return;
+    }
+    capture_record_t rec = {
+        .kind = CAPTURE_ROOM,
+        .session = sessions[client_index],
+        .t_us = elapsed_us(),
+        .room_id = room_id,
+    };
+    write_or_stop(&rec);
+}
+
+void capture_stop(void)
+{
+    if (!active)
+    {
+        return;
+    }
+    active = 0;
+    uint64_t records = writer.records;
+    if (capture_writer_close(&writer) == 0)
+    {
+        printf("Capture: da ghi %llu ban ghi\n", (unsigned long long)records);
+    }
+    free(scratch);
+    scratch = NULL;
+    scratch_capacity = 0;
+    memset(&anonymizer, 0, sizeof(anonymizer));
+}
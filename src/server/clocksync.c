@@ -0,0 +1,74 @@
+#include "../include/clocksync.h"
+#include <string.h>
+
+void clocksync_reset(clocksync_t *cs)
+{
+    memset(cs, 0, sizeof(*cs));
+}
+
+uint32_t clocksync_start_ping(clocksync_t *cs, uint64_t now_ms, uint64_t wall_ms)
+{
+    if (cs->ping_sent_ms != 0)
+    {
+        cs->lost++;
+    }
+    cs->ping_seq++;
+    cs->ping_sent_ms = now_ms;
+    cs->ping_origin_ms = wall_ms;
+    cs->next_ping_ms = now_ms + CLOCKSYNC_PING_INTERVAL_MS;
+    return cs->ping_seq;
+}
+
+int clocksync_on_pong(clocksync_t *cs, uint32_t seq, uint64_t origin_ms, uint64_t remote_recv_ms,
+                      uint64_t remote_send_ms, uint64_t now_ms, uint64_t wall_ms)
+{
+    // Chi nhan PONG cua PING dang cho (PONG tre/gia mao bi bo qua)
+    if (cs->ping_sent_ms == 0 || seq != cs->ping_seq || origin_ms != cs->ping_origin_ms || now_ms < cs->ping_sent_ms)
+    {
+        return -1;
+    }
+    uint64_t sent_ms = cs->ping_sent_ms;
+    cs->ping_sent_ms = 0;
+
+    // Thoi gian client giu PING khong tinh vao RTT; dong ho client sai thi coi nhu 0
+    int64_t hold = (int64_t)(remote_send_ms - remote_recv_ms);
+    int64_t rtt = (int64_t)(now_ms - sent_ms);
+    if (hold > 0 && hold < rtt)
+    {
+        rtt -= hold;
+    }
+    // Lech dong ho tinh tren dong ho thuc: monotonic cua server khong so sanh duoc voi dong ho client
+    int64_t offset = ((int64_t)(remote_recv_ms - origin_ms) + (int64_t)(remote_send_ms - wall_ms)) / 2;
+
+    uint32_t sample = rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)rtt;
+    cs->rtt_ms = sample;
+    if (cs->samples == 0)
+    {
+        cs->srtt_ms = sample;
+        cs->rttvar_ms = sample / 2;
+        cs->min_rtt_ms = sample;
+        cs->offset_ms = offset;
+    }
+    else
+    {
+        // Mau co RTT thap hon trung binh it bi hang doi lech mot chieu, offset dang tin hon
+        if (sample <= cs->srtt_ms)
+        {
+            cs->offset_ms = offset;
+        }
+        uint32_t diff = sample > cs->srtt_ms ? sample - cs->srtt_ms : cs->srtt_ms - sample;
+        cs->rttvar_ms = (3 * cs->rttvar_ms + diff) / 4;
+        cs->srtt_ms = (uint32_t)((7 * (uint64_t)cs->srtt_ms + sample) / 8);
+        if (sample < cs->min_rtt_ms)
+        {
+            cs->min_rtt_ms = sample;
+        }
+    }
+    cs->samples++;
+    return 0;
+}
+
+uint32_t clocksync_rtt_ms(const clocksync_t *cs)
+{
+    return cs->samples > 0 ? cs->srtt_ms : 0;
+}
@@ -0,0 +1,103 @@
+#include "../include/compress.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <stdio.h>
+#include <string.h>
+
+// Message dang danh sach/bang diem: nhieu chuoi char[N] dem '\0' va truong lap lai
+int compress_type_eligible(uint8_t msg_type)
+{
+    switch (msg_type)
+    {
+    case MSG_ROOM_LIST_RESPONSE:
+    case MSG_ROOM_LIST_DELTA:
+    case MSG_ROOM_PLAYERS_UPDATE:
+    case MSG_ROUND_END:
+    case MSG_GAME_END:
+    case MSG_GAME_HISTORY_RESPONSE:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+size_t compress_bound(size_t payload_len)
+{
+    return COMPRESS_HEADER_SIZE + (size_t)compressBound((uLong)payload_len);
+}
+
+// Khoi tao z_stream deflate raw (khong header zlib, gateway dung inflateRaw)
+static int ctx_init(compress_ctx_t *ctx)
+{
+    memset(&ctx->stream, 0, sizeof(ctx->stream));
+    int ret = deflateInit2(&ctx->stream, COMPRESS_LEVEL, Z_DEFLATED, -COMPRESS_WINDOW_BITS,
+                           COMPRESS_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK)
+    {
+        fprintf(stderr, "Loi: deflateInit2 that bai (%d)\n", ret);
+        return -1;
+    }
+    ctx->initialized = 1;
+    return 0;
+}
+
+size_t compress_payload(compress_ctx_t *ctx, uint8_t msg_type, const uint8_t *payload, size_t payload_len,
+                        uint8_t *out, size_t out_capacity)
+{
+    if (!ctx || !payload || !out || out_capacity <= COMPRESS_HEADER_SIZE || payload_len > UINT32_MAX)
+    {
+        return 0;
+    }
+
+    if (!ctx->initialized)
+    {
+        if (ctx_init(ctx) != 0)
+        {
+            return 0;
+        }
+    }
+    else if (deflateReset(&ctx->stream) != Z_OK)
+    {
+        return 0;
+    }
+
+    // Moi message la mot stream deflate doc lap: gateway giai nen dong bo, khong can giu trang thai
+    z_stream *zs = &ctx->stream;
+    zs->next_in = (Bytef *)payload;
+    zs->avail_in = (uInt)payload_len;
+    zs->next_out = out + COMPRESS_HEADER_SIZE;
+    zs->avail_out = (uInt)(out_capacity - COMPRESS_HEADER_SIZE);
+
+    if (deflate(zs, Z_FINISH) != Z_STREAM_END)
+    {
+        return 0;
+    }
+
+    size_t total = COMPRESS_HEADER_SIZE + zs->total_out;
+    if (total >= payload_len)
+    {
+        return 0; // Khong dang nen, gui nguyen
+    }
+
+    msg_compressed_header_t header = {.type = msg_type, .raw_len = (uint32_t)payload_len};
+    msg_compressed_header_encode(&header, out, COMPRESS_HEADER_SIZE);
+
+    ctx->raw_bytes += payload_len;
+    ctx->wire_bytes += total;
+    ctx->messages++;
+    return total;
+}
+
+void compress_ctx_free(compress_ctx_t *ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+    if (ctx->initialized)
+    {
+        deflateEnd(&ctx->stream);
+    }
+    memset(ctx, 0, sizeof(*ctx));
+}
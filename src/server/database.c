@@ -1,9 +1,30 @@
 #include "../include/database.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>  // <== them dong nay
-#include <ctype.h>
+
+// mysql_init kem timeout: mac dinh cua libmysqlclient co the chan hang phut khi MySQL mat
+static MYSQL* db_init_handle(void) {
+    MYSQL* conn = mysql_init(NULL);
+    if (!conn) {
+        return NULL;
+    }
+    unsigned int connect_timeout = DB_CONNECT_TIMEOUT_SEC;
+    unsigned int io_timeout = DB_IO_TIMEOUT_SEC;
+    mysql_options(conn, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+    mysql_options(conn, MYSQL_OPT_READ_TIMEOUT, &io_timeout);
+    mysql_options(conn, MYSQL_OPT_WRITE_TIMEOUT, &io_timeout);
+    return conn;
+}
+
+// Vua thu ket noi lai that bai: query va ping ke tiep tra ve loi ngay thay vi thu lai lan nua
+static int db_reconnect_backoff(db_connection_t* db) {
+    return db->reconnect_failed_ms != 0 &&
+           utils_now_ms() - db->reconnect_failed_ms < DB_RECONNECT_BACKOFF_MS;
+}
 
 db_connection_t* db_connect(const char* host, const char* user, 
                            const char* password, const char* database) {
@@ -15,7 +36,8 @@ db_connection_t* db_connect(const char* host, const char* user,
     }
     
     // Khoi tao MySQL connection
-    db->conn = mysql_init(NULL);
+    db->reconnect_failed_ms = 0;
+    db->conn = db_init_handle();
     if (!db->conn) {
         fprintf(stderr, "Loi: Khong the khoi tao MySQL connection\n");
         free(db);
@@ -83,10 +105,13 @@ int db_check_and_reconnect(db_connection_t* db) {
     
     // Nếu connection là NULL, tạo mới
     if (!db->conn) {
+        if (db_reconnect_backoff(db)) {
+            return 0;
+        }
         fprintf(stderr, "MySQL connection is NULL, attempting to reconnect...\n");
         
         // Tạo connection mới
-        db->conn = mysql_init(NULL);
+        db->conn = db_init_handle();
         if (!db->conn) {
             fprintf(stderr, "Loi: Khong the khoi tao MySQL connection\n");
             return 0;
@@ -96,8 +121,9 @@ int db_check_and_reconnect(db_connection_t* db) {
         if (!mysql_real_connect(db->conn, db->host, db->user, db->password, 
                                db->database, 3308, NULL, 0)) {
             fprintf(stderr, "Loi ket noi MySQL: %s\n", mysql_error(db->conn));
-            mysql_close(db->conn);
-            db->conn = NULL;
+            db->reconnect_failed_ms = utils_now_ms();
+            // Giu handle loi thay vi NULL: caller van doc duoc mysql_errno(db->conn),
+            // lan goi sau ping that bai va thu ket noi lai
             return 0;
         }
         
@@ -108,18 +134,22 @@ int db_check_and_reconnect(db_connection_t* db) {
         }
         
         printf("Da ket noi lai thanh cong den MySQL database: %s\n", db->database);
+        db->reconnect_failed_ms = 0;
         return 1;
     }
     
     // Kiểm tra connection còn sống
     if (mysql_ping(db->conn) != 0) {
+        if (db_reconnect_backoff(db)) {
+            return 0;
+        }
         fprintf(stderr, "MySQL connection lost, attempting to reconnect...\n");
         
         // Đóng connection cũ
         mysql_close(db->conn);
         
         // Tạo connection mới
-        db->conn = mysql_init(NULL);
+        db->conn = db_init_handle();
         if (!db->conn) {
             fprintf(stderr, "Loi: Khong the khoi tao MySQL connection\n");
             return 0;
@@ -129,8 +159,9 @@ int db_check_and_reconnect(db_connection_t* db) {
         if (!mysql_real_connect(db->conn, db->host, db->user, db->password, 
                                db->database, 3308, NULL, 0)) {
             fprintf(stderr, "Loi ket noi MySQL: %s\n", mysql_error(db->conn));
-            mysql_close(db->conn);
-            db->conn = NULL;
+            db->reconnect_failed_ms = utils_now_ms();
+            // Giu handle loi thay vi NULL: caller van doc duoc mysql_errno(db->conn),
+            // lan goi sau ping that bai va thu ket noi lai
             return 0;
         }
         
@@ -141,13 +172,14 @@ int db_check_and_reconnect(db_connection_t* db) {
         }
         
         printf("Da ket noi lai thanh cong den MySQL database: %s\n", db->database);
+        db->reconnect_failed_ms = 0;
         return 1;
     }
     
     return 1; // Connection vẫn OK
 }
 
-MYSQL_RES* db_execute_query(db_connection_t* db, const char* query, ...) {
+static MYSQL_RES* db_execute_query_v(db_connection_t* db, const char* query, va_list args) {
     if (!db || !query) {
         fprintf(stderr, "Loi: Tham so khong hop le\n");
         return NULL;
@@ -177,16 +209,12 @@ MYSQL_RES* db_execute_query(db_connection_t* db, const char* query, ...) {
     }
 
     // Thu thap tham so dang chuoi
-    va_list args;
-    va_start(args, query);
-
     const char** param_vals = (const char**)calloc(param_count, sizeof(char*));
     unsigned long* param_lens = (unsigned long*)calloc(param_count, sizeof(unsigned long));
     if (!param_vals || !param_lens) {
         fprintf(stderr, "Loi: Khong the cap phat bo nho cho parameters\n");
         if (param_vals) free(param_vals);
         if (param_lens) free(param_lens);
-        va_end(args);
         return NULL;
     }
 
@@ -196,7 +224,6 @@ MYSQL_RES* db_execute_query(db_connection_t* db, const char* query, ...) {
         param_vals[i] = v;
         param_lens[i] = (unsigned long)strlen(v);
     }
-    va_end(args);
 
     // Uoc luong kich thuoc buffer (escape toi da ~ gap doi) + 2 dau '
     size_t qlen = strlen(query);
@@ -247,6 +274,21 @@ MYSQL_RES* db_execute_query(db_connection_t* db, const char* query, ...) {
     return res;
 }
 
+MYSQL_RES* db_execute_query(db_connection_t* db, const char* query, ...) {
+    // Do thoi gian ca reconnect + query + store_result, tinh cho message dang xu ly (metrics)
+    uint64_t start_ns = utils_now_ns();
+
+    va_list args;
+    va_start(args, query);
+    MYSQL_RES* res = db_execute_query_v(db, query, args);
+    va_end(args);
+
+    // INSERT/UPDATE thanh cong cung tra ve NULL: phan biet loi bang mysql_errno
+    int ok = res != NULL || (db && db->conn && mysql_errno(db->conn) == 0);
+    metrics_record_db_query(utils_now_ns() - start_ns, ok);
+    return res;
+}
+
 int db_register_user(db_connection_t* db, const char* username, 
                   const char* password_hash) {
     if (!db) {
@@ -386,21 +428,7 @@ int db_change_password(db_connection_t* db, int user_id,
 // Words system (Phase 5 - #17)
 // ---------------------------
 
-static void str_trim_inplace(char* s) {
-    if (!s) return;
-    size_t len = strlen(s);
-    size_t start = 0;
-    while (start < len && isspace((unsigned char)s[start])) start++;
-    size_t end = len;
-    while (end > start && isspace((unsigned char)s[end - 1])) end--;
-    if (start > 0) memmove(s, s + start, end - start);
-    s[end - start] = '\0';
-}
-
-static int difficulty_is_valid(const char* d) {
-    if (!d) return 0;
-    return strcmp(d, "easy") == 0 || strcmp(d, "medium") == 0 || strcmp(d, "hard") == 0;
-}
+// Tach dong va kiem tra difficulty: storage_parse_word_line, storage_difficulty_is_valid (storage.c)
 
 int db_load_words_from_file(db_connection_t* db, const char* filepath) {
     if (!db || !db->conn || !filepath) {
@@ -419,30 +447,10 @@ int db_load_words_from_file(db_connection_t* db, const char* filepath) {
     int inserted = 0;
 
     while (fgets(line, sizeof(line), f)) {
-        // strip newline
-        line[strcspn(line, "\r\n")] = '\0';
-        str_trim_inplace(line);
-        if (line[0] == '\0' || line[0] == '#') continue;
-
-        // Parse: word|difficulty|category
-        char* word = line;
-        char* diff = strchr(word, '|');
-        char* cat = NULL;
-
-        if (diff) {
-            *diff++ = '\0';
-            cat = strchr(diff, '|');
-            if (cat) *cat++ = '\0';
-        }
-
-        str_trim_inplace(word);
-        if (diff) str_trim_inplace(diff);
-        if (cat) str_trim_inplace(cat);
-
-        if (word[0] == '\0') continue;
-        if (!diff || diff[0] == '\0') diff = "medium";
-        if (!difficulty_is_valid(diff)) diff = "medium";
-        if (!cat || cat[0] == '\0') cat = "general";
+        char* word;
+        char* diff;
+        char* cat;
+        if (!storage_parse_word_line(line, &word, &diff, &cat)) continue;
 
         // Upsert theo word
         // Luu y: db_execute_query chi bind string, nen ta truyen chuoi cho ENUM/difficulty luon duoc.
@@ -474,7 +482,7 @@ int db_get_random_word(db_connection_t* db, const char* difficulty, char* out_wo
 
     out_word[0] = '\0';
 
-    const int filter_by_diff = (difficulty && difficulty[0] != '\0' && difficulty_is_valid(difficulty));
+    const int filter_by_diff = (difficulty && difficulty[0] != '\0' && storage_difficulty_is_valid(difficulty));
 
     MYSQL_RES* res = NULL;
     if (filter_by_diff) {
@@ -516,7 +524,7 @@ int db_get_all_words_by_difficulty(db_connection_t* db, const char* difficulty,
         return -1;
     }
 
-    const int filter_by_diff = (difficulty && difficulty[0] != '\0' && difficulty_is_valid(difficulty));
+    const int filter_by_diff = (difficulty && difficulty[0] != '\0' && storage_difficulty_is_valid(difficulty));
 
     MYSQL_RES* res = NULL;
     if (filter_by_diff) {
@@ -687,6 +695,15 @@ int db_create_room(db_connection_t* db, const char* room_code, int host_id, int
     return (int)mysql_insert_id(db->conn);
 }
 
+int db_set_room_status(db_connection_t* db, int db_room_id, const char* status) {
+    if (!db || !db->conn || db_room_id <= 0 || !status) return -1;
+    char rid_buf[32];
+    snprintf(rid_buf, sizeof(rid_buf), "%d", db_room_id);
+    MYSQL_RES* r = db_execute_query(db, "UPDATE rooms SET status = ? WHERE id = ?", status, rid_buf);
+    if (r) mysql_free_result(r);
+    return mysql_errno(db->conn) ? -1 : 0;
+}
+
 int db_add_room_player(db_connection_t* db, int db_room_id, int user_id, int join_order) {
     if (!db || !db->conn || db_room_id <= 0 || user_id <= 0) return -1;
     char room_buf[32], user_buf[32], order_buf[32];
@@ -752,6 +769,21 @@ int db_save_score_detail(db_connection_t* db, int db_round_id, int player_db_id,
     return (int)mysql_insert_id(db->conn);
 }
 
+int db_save_chat_message(db_connection_t* db, int db_room_id, int player_db_id, const char* message_text) {
+    if (!db || !db->conn || db_room_id <= 0 || player_db_id <= 0 || !message_text) return -1;
+    char room_buf[32], player_buf[32];
+    snprintf(room_buf, sizeof(room_buf), "%d", db_room_id);
+    snprintf(player_buf, sizeof(player_buf), "%d", player_db_id);
+
+    MYSQL_RES* r = db_execute_query(db,
+        "INSERT INTO chat_messages (room_id, player_id, message_text) VALUES (?, ?, ?)",
+        room_buf, player_buf, message_text
+    );
+    if (r) mysql_free_result(r);
+    if (mysql_errno(db->conn)) return -1;
+    return (int)mysql_insert_id(db->conn);
+}
+
 int db_update_room_player_score(db_connection_t* db, int player_db_id, int score) {
     if (!db || !db->conn || player_db_id <= 0) return -1;
     char pid_buf[32], score_buf[32];
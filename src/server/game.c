@@ -1,18 +1,11 @@
 #include "../include/game.h"
-#include "../include/database.h"
+#include "../include/storage.h"
+#include "../include/canvas.h"
+#include "../include/stroke.h"
+#include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <time.h>
-
-// db global dang duoc khai bao trong main.c (server hien chua nhung db vao server_t)
-extern db_connection_t* db;
-
-static void str_to_lower_ascii(char* s) {
-    if (!s) return;
-    for (; *s; s++) *s = (char)tolower((unsigned char)*s);
-}
 
 static void safe_copy_word(char* dst, size_t dst_sz, const char* src) {
     if (!dst || dst_sz == 0) return;
@@ -74,7 +67,9 @@ game_state_t* game_init(room_t* room, int total_rounds, int time_limit_seconds)
     game->current_category[0] = '\0';
     game->word_length = 0;
     game->word_guessed = false;
-    game->round_start_time = 0;
+    game->round_start_ms = 0;
+    game->round_deadline_ms = 0;
+    game->next_clock_sync_ms = 0;
     game->game_ended = false;
     game->db_round_id = 0;
     game->word_stack_top = 0;
@@ -82,10 +77,10 @@ game_state_t* game_init(room_t* room, int total_rounds, int time_limit_seconds)
     game->guessed_count = 0;
 
     // Pre-select từ: lấy tất cả từ theo difficulty, shuffle 5 lần, lấy n từ đầu
-    if (db) {
+    if (storage_available()) {
         char all_words[500][64];
         char all_categories[500][64];
-        int word_count = db_get_all_words_by_difficulty(db, room->difficulty, all_words, all_categories, 500);
+        int word_count = storage_get_all_words_by_difficulty(room->difficulty, all_words, all_categories, 500);
         
         if (word_count > 0) {
             // Chuyển sang word_entry_t để shuffle
@@ -97,8 +92,7 @@ game_state_t* game_init(room_t* room, int total_rounds, int time_limit_seconds)
                 temp_words[i].category[63] = '\0';
             }
             
-            // Shuffle 5 lần
-            srand((unsigned int)time(NULL));
+            // Shuffle 5 lần (rand() được seed một lần lúc khởi động: main.c, game_sim --seed)
             for (int t = 0; t < 5; t++) {
                 for (int i = 0; i < word_count; i++) {
                     int j = rand() % word_count;
@@ -241,7 +235,16 @@ bool game_start_round(game_state_t* game) {
 
     assign_new_word(game);
     game->word_guessed = false;
-    game->round_start_time = time(NULL);
+    game->round_start_ms = utils_now_ms();
+    game->round_deadline_ms = game->round_start_ms + (uint64_t)game->time_limit * 1000u;
+
+    // Round moi bat dau voi canvas trang (frontend cung clear khi nhan GAME_START)
+    if (game->room->canvas) {
+        canvas_clear(game->room->canvas);
+    }
+    if (game->room->strokes) {
+        stroke_log_reset(game->room->strokes);
+    }
     // Reset tracking cho round mới
     game->guessed_count = 0;
     
@@ -255,12 +258,11 @@ bool game_start_round(game_state_t* game) {
     return true;
 }
 
-bool game_check_timeout(game_state_t* game) {
+bool game_check_timeout(game_state_t* game, uint64_t now_ms) {
     if (!game || game->game_ended) return false;
-    if (game->round_start_time == 0) return false;
+    if (game->round_start_ms == 0) return false;
 
-    time_t now = time(NULL);
-    if ((int)(now - game->round_start_time) > game->time_limit) {
+    if (now_ms >= game->round_deadline_ms) {
         // timeout → end round that bai (khong ai thang round)
         game_end_round(game, false, -1);
         return true;
@@ -268,16 +270,6 @@ bool game_check_timeout(game_state_t* game) {
     return false;
 }
 
-static bool words_equal_case_insensitive(const char* a, const char* b) {
-    if (!a || !b) return false;
-    char aa[128], bb[128];
-    safe_copy_word(aa, sizeof(aa), a);
-    safe_copy_word(bb, sizeof(bb), b);
-    str_to_lower_ascii(aa);
-    str_to_lower_ascii(bb);
-    return strcmp(aa, bb) == 0;
-}
-
 bool game_handle_guess(game_state_t* game, int guesser_user_id, const char* guess_word) {
     if (!game || !game->room || game->game_ended) {
         printf("[GAME] ERROR: game_handle_guess called with invalid game\n");
@@ -304,7 +296,7 @@ bool game_handle_guess(game_state_t* game, int guesser_user_id, const char* gues
         return false;
     }
 
-    if (!words_equal_case_insensitive(guess_word, game->current_word)) {
+    if (!utils_words_equal_ci(guess_word, game->current_word)) {
         return false;
     }
 
@@ -409,11 +401,25 @@ void game_end_round(game_state_t* game, bool success, int winner_user_id) {
     printf("[GAME] Room %d end round %d: %s, word='%s'\n",
            game->room->room_id, game->current_round, success ? "SUCCESS" : "TIMEOUT", game->current_word);
 
+    // Dong net cuoi va in thong ke don gian hoa net ve cua round
+    stroke_log_t* strokes = game->room->strokes;
+    if (strokes) {
+        stroke_log_finish(strokes);
+        if (strokes->raw_points > 0) {
+            printf("[GAME] Room %d round %d: %d net, %zu -> %zu diem (giam %.1f%%)%s\n",
+                   game->room->room_id, game->current_round, strokes->stroke_count,
+                   strokes->raw_points, strokes->stored_points,
+                   100.0 * (1.0 - (double)strokes->stored_points / (double)strokes->raw_points),
+                   strokes->overflow ? " [log day]" : "");
+        }
+    }
+
     // reset word/timer cho round hien tai (round moi se set lai)
     game->current_word[0] = '\0';
     game->current_category[0] = '\0';
     game->word_length = 0;
-    game->round_start_time = 0;
+    game->round_start_ms = 0;
+    game->round_deadline_ms = 0;
 
     // het game?
     if (game->current_round >= game->total_rounds) {
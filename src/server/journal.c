@@ -0,0 +1,355 @@
+#include "../include/journal.h"
+#include "../include/utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static int journal_fd = -1;
+static uint64_t replay_offset;          // Ban ghi dau tien chua phat lai
+static uint64_t file_end;               // Het phan da ghi xuong file
+static uint64_t file_records;           // Ban ghi tu replay_offset den file_end
+static uint8_t buffer[JOURNAL_BUFFER_SIZE];
+static size_t buffer_len;
+static uint64_t buffer_records;
+static uint8_t scratch[JOURNAL_MAX_PAYLOAD];
+
+// ============================================
+// Ma hoa / doc ghi file
+// ============================================
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (uint8_t)(v >> (24 - 8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t payload_crc(const uint8_t *payload, uint32_t len)
+{
+    return (uint32_t)crc32(crc32(0L, Z_NULL, 0), payload, len);
+}
+
+static int write_all(const uint8_t *data, size_t len, uint64_t offset)
+{
+    while (len > 0)
+    {
+        ssize_t n = pwrite(journal_fd, data, len, (off_t)offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+// Tra ve 1 neu doc du, 0 neu het file truoc khi du, -1 neu loi doc
+static int read_all(uint8_t *data, size_t len, uint64_t offset)
+{
+    while (len > 0)
+    {
+        ssize_t n = pread(journal_fd, data, len, (off_t)offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0)
+        {
+            return 0;
+        }
+        data += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 1;
+}
+
+static int write_header(void)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE] = {0};
+    memcpy(header, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN);
+    header[5] = JOURNAL_VERSION;
+    for (int i = 0; i < 8; i++)
+    {
+        header[8 + i] = (uint8_t)(replay_offset >> (56 - 8 * i));
+    }
+    return write_all(header, sizeof(header), 0);
+}
+
+// Doc ban ghi tai offset vao scratch
+// Tra ve 1 neu hop le, 0 neu cat cut/sai CRC (duoi ghi do), -1 neu loi doc
+static int read_record(uint64_t offset, uint64_t end, uint32_t *len)
+{
+    uint8_t head[JOURNAL_RECORD_HEADER_SIZE];
+    if (offset + JOURNAL_RECORD_HEADER_SIZE > end)
+    {
+        return 0;
+    }
+    int rc = read_all(head, sizeof(head), offset);
+    if (rc != 1)
+    {
+        return rc;
+    }
+    uint32_t n = get_u32(head);
+    if (n > JOURNAL_MAX_PAYLOAD || offset + JOURNAL_RECORD_HEADER_SIZE + n > end)
+    {
+        return 0;
+    }
+    rc = read_all(scratch, n, offset + JOURNAL_RECORD_HEADER_SIZE);
+    if (rc != 1)
+    {
+        return rc;
+    }
+    if (payload_crc(scratch, n) != get_u32(head + 4))
+    {
+        return 0;
+    }
+    *len = n;
+    return 1;
+}
+
+// ============================================
+// API
+// ============================================
+
+int journal_open(const char *path)
+{
+    journal_close();
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        perror("journal open");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror("journal fstat");
+        close(fd);
+        return -1;
+    }
+    journal_fd = fd;
+    uint64_t size = (uint64_t)st.st_size;
+
+    if (size == 0)
+    {
+        replay_offset = file_end = JOURNAL_HEADER_SIZE;
+        if (write_header() != 0 || fdatasync(journal_fd) != 0)
+        {
+            perror("journal write");
+            journal_close();
+            return -1;
+        }
+        return 0;
+    }
+
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    if (read_all(header, sizeof(header), 0) != 1 || memcmp(header, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) != 0)
+    {
+        fprintf(stderr, "%s: khong phai file journal\n", path);
+        journal_close();
+        return -1;
+    }
+    if (header[5] != JOURNAL_VERSION)
+    {
+        fprintf(stderr, "%s: phien ban journal %u khong ho tro (can %u)\n", path, header[5], JOURNAL_VERSION);
+        journal_close();
+        return -1;
+    }
+    replay_offset = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        replay_offset = (replay_offset << 8) | header[8 + i];
+    }
+    // Crash giua luc cat file (da phat lai het) va ghi lai header: offset cu vuot qua cuoi file.
+    // Phai ghi lai header ngay, neu khong ban ghi moi nam truoc offset cu va bi bo qua lan mo sau
+    if (replay_offset < JOURNAL_HEADER_SIZE || replay_offset > size)
+    {
+        replay_offset = JOURNAL_HEADER_SIZE;
+        size = JOURNAL_HEADER_SIZE;
+        if (write_header() != 0 || fdatasync(journal_fd) != 0)
+        {
+            perror("journal write");
+            journal_close();
+            return -1;
+        }
+    }
+
+    uint64_t offset = replay_offset;
+    uint32_t len;
+    int rc;
+    while ((rc = read_record(offset, size, &len)) == 1)
+    {
+        offset += JOURNAL_RECORD_HEADER_SIZE + len;
+        file_records++;
+    }
+    if (rc < 0)
+    {
+        perror("journal read");
+        journal_close();
+        return -1;
+    }
+    if (offset < (uint64_t)st.st_size)
+    {
+        // Ban ghi cuoi ghi do khi crash: cat bo de ghi tiep tu cho hop le cuoi cung
+        fprintf(stderr, "Journal: cat %llu byte hong o cuoi %s\n",
+                (unsigned long long)((uint64_t)st.st_size - offset), path);
+        if (ftruncate(journal_fd, (off_t)offset) != 0 || write_header() != 0 || fdatasync(journal_fd) != 0)
+        {
+            perror("journal truncate");
+            journal_close();
+            return -1;
+        }
+    }
+    file_end = offset;
+    return 0;
+}
+
+int journal_active(void)
+{
+    return journal_fd >= 0;
+}
+
+uint64_t journal_pending(void)
+{
+    return file_records + buffer_records;
+}
+
+int journal_append(const uint8_t *payload, uint32_t len)
+{
+    if (journal_fd < 0 || len > JOURNAL_MAX_PAYLOAD)
+    {
+        return -1;
+    }
+    size_t need = JOURNAL_RECORD_HEADER_SIZE + len;
+    if (buffer_len + need > sizeof(buffer) && journal_flush() != 0)
+    {
+        return -1;
+    }
+    put_u32(buffer + buffer_len, len);
+    put_u32(buffer + buffer_len + 4, payload_crc(payload, len));
+    memcpy(buffer + buffer_len + JOURNAL_RECORD_HEADER_SIZE, payload, len);
+    buffer_len += need;
+    buffer_records++;
+    return 0;
+}
+
+int journal_flush(void)
+{
+    if (journal_fd < 0 || buffer_len == 0)
+    {
+        return 0;
+    }
+    // Loi giua chung: giu buffer, lan sau ghi de lai tu file_end
+    if (write_all(buffer, buffer_len, file_end) != 0 || fdatasync(journal_fd) != 0)
+    {
+        perror("journal write");
+        return -1;
+    }
+    file_end += buffer_len;
+    file_records += buffer_records;
+    buffer_len = 0;
+    buffer_records = 0;
+    return 0;
+}
+
+int journal_replay(journal_apply_fn fn, void *arg, uint64_t budget_ns)
+{
+    if (journal_fd < 0)
+    {
+        return 0;
+    }
+    // Ban ghi dang trong buffer phai xuong file truoc: phat lai chi doc tu file
+    journal_flush();
+
+    uint64_t start_ns = utils_now_ns();
+    uint64_t offset = replay_offset;
+    int done = 0;
+    while (offset < file_end)
+    {
+        if (done > 0 && utils_now_ns() - start_ns >= budget_ns)
+        {
+            break;
+        }
+        uint32_t len;
+        int rc = read_record(offset, file_end, &len);
+        if (rc < 0)
+        {
+            perror("journal read");
+            return -1;
+        }
+        if (rc == 0)
+        {
+            // Chi xay ra neu file bi sua tu ben ngoai: khong the tim ban ghi ke tiep
+            fprintf(stderr, "Journal: ban ghi hong tai offset %llu, bo %llu ban ghi con lai\n",
+                    (unsigned long long)offset, (unsigned long long)file_records);
+            offset = file_end;
+            file_records = 0;
+            break;
+        }
+        if (fn(scratch, len, arg) != 0)
+        {
+            break;
+        }
+        offset += JOURNAL_RECORD_HEADER_SIZE + len;
+        file_records--;
+        done++;
+    }
+
+    if (offset == replay_offset)
+    {
+        return done;
+    }
+    replay_offset = offset;
+    if (replay_offset == file_end && buffer_len == 0)
+    {
+        // Phat lai het: cat ve header de file khong lon mai
+        if (ftruncate(journal_fd, JOURNAL_HEADER_SIZE) != 0)
+        {
+            perror("journal truncate");
+            return -1;
+        }
+        replay_offset = file_end = JOURNAL_HEADER_SIZE;
+    }
+    if (write_header() != 0 || fdatasync(journal_fd) != 0)
+    {
+        perror("journal write");
+        return -1;
+    }
+    return done;
+}
+
+void journal_close(void)
+{
+    if (journal_fd >= 0)
+    {
+        journal_flush();
+        close(journal_fd);
+    }
+    journal_fd = -1;
+    replay_offset = 0;
+    file_end = 0;
+    file_records = 0;
+    buffer_len = 0;
+    buffer_records = 0;
+}
@@ -1,13 +1,18 @@
 #include "../include/server.h"
-#include "../include/database.h"
+#include "../include/storage.h"
 #include "../include/auth.h"
+#include "../include/stroke.h"
+#include "../include/metrics.h"
+#include "../include/stall.h"
+#include "../include/capture.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
 
 server_t server;
-db_connection_t* db = NULL;
 
 // Xu ly tin hieu de dung server mot cach an toan
 void signal_handler(int sig) {
@@ -21,39 +26,125 @@ void signal_handler(int sig) {
     usleep(100000); // 100ms
     
     printf("Dang dong server...\n");
-    if (db) {
-        db_disconnect(db);
-        db = NULL;
-    }
+    storage_close();
     server_cleanup(&server);
     exit(0);
 }
 
+// SIGUSR2: in histogram do tre theo message type (kill -USR2 <pid>)
+// SIGUSR1: in flight recorder cac lan nghen (kill -USR1 <pid>)
+// Chi dat co, vong lap su kien in ra ngoai signal handler
+void metrics_signal_handler(int sig) {
+    if (sig == SIGUSR1) {
+        stall_request_dump();
+    } else {
+        metrics_request_dump();
+    }
+}
+
 int main(int argc, char *argv[]) {
     int port = DEFAULT_PORT;
+    server_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.stroke_tolerance = STROKE_DEFAULT_TOLERANCE;
+    ratelimit_default_policies(config.rate_limits);
+    config.idle_timeout_ms = DEFAULT_IDLE_TIMEOUT_MS;
+    config.stall_threshold_ms = STALL_DEFAULT_THRESHOLD_MS;
+    config.storage = "mysql";
+    config.journal_path = DEFAULT_JOURNAL_PATH;
     
-    // Doc port tu tham so dong lenh neu co
-    if (argc > 1) {
-        port = atoi(argv[1]);
-        if (port <= 0 || port > 65535) {
-            fprintf(stderr, "Port khong hop le. Su dung port mac dinh: %d\n", DEFAULT_PORT);
-            port = DEFAULT_PORT;
+    // Doc port va cac tuy chon tu tham so dong lenh
+    // Cach dung: ./main [port] [--canvas] [--stroke-tolerance=PX] [--rate-limit=nhom=rate/burst ...] [--idle-timeout=SEC]
+    //                  [--metrics=PORT|unix:PATH] [--stall-threshold=MS] [--capture=FILE] [--capture-anonymize] [--no-db]
+    //                  [--storage=mysql|memory|sqlite[:PATH]] [--journal=FILE] [--no-journal]
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--canvas") == 0) {
+            config.canvas_enabled = 1;
+        } else if (strncmp(argv[i], "--stroke-tolerance=", 19) == 0) {
+            config.stroke_tolerance = atof(argv[i] + 19);
+        } else if (strncmp(argv[i], "--rate-limit=", 13) == 0) {
+            // Vi du: --rate-limit=draw=200/400, --rate-limit=chat=0 (tat gioi han)
+            if (ratelimit_parse_option(argv[i] + 13, config.rate_limits) != 0) {
+                fprintf(stderr, "Tuy chon rate limit khong hop le: %s (nhom: draw, chat, lobby, room, auth)\n",
+                        argv[i] + 13);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--idle-timeout=", 15) == 0) {
+            // 0 = tat, chi dua vao TCP keepalive nhu truoc
+            int seconds = atoi(argv[i] + 15);
+            if (seconds < 0) {
+                fprintf(stderr, "Idle timeout khong hop le: %s\n", argv[i] + 15);
+                return 1;
+            }
+            config.idle_timeout_ms = (uint32_t)seconds * 1000u;
+            if (config.idle_timeout_ms > 0 && config.idle_timeout_ms < 2 * CLOCKSYNC_PING_INTERVAL_MS) {
+                // Client chi gui PONG moi chu ky PING, timeout ngan hon se ngat client con song
+                config.idle_timeout_ms = 2 * CLOCKSYNC_PING_INTERVAL_MS;
+                fprintf(stderr, "Idle timeout toi thieu %d giay\n", 2 * CLOCKSYNC_PING_INTERVAL_MS / 1000);
+            }
+        } else if (strncmp(argv[i], "--metrics=", 10) == 0) {
+            // Vi du: --metrics=9100 (127.0.0.1:9100), --metrics=unix:/tmp/drawguess-metrics.sock
+            config.metrics_address = argv[i] + 10;
+        } else if (strncmp(argv[i], "--stall-threshold=", 18) == 0) {
+            // Handler/vong lap cham hon nguong duoc ghi vao flight recorder, 0 = tat
+            int threshold_ms = atoi(argv[i] + 18);
+            if (threshold_ms < 0) {
+                fprintf(stderr, "Stall threshold khong hop le: %s\n", argv[i] + 18);
+                return 1;
+            }
+            config.stall_threshold_ms = (uint32_t)threshold_ms;
+        } else if (strncmp(argv[i], "--capture=", 10) == 0) {
+            // Ghi frame client de phat lai: ./traffic_replay FILE --port=PORT
+            config.capture_path = argv[i] + 10;
+        } else if (strcmp(argv[i], "--capture-anonymize") == 0) {
+            config.capture_anonymize = 1;
+        } else if (strcmp(argv[i], "--no-db") == 0) {
+            // Chay khong MySQL: dang nhap guest, khong luu lich su (demo, load test)
+            config.guest_login = 1;
+        } else if (strncmp(argv[i], "--storage=", 10) == 0) {
+            // memory: du lieu mat khi dung server (benchmark, CI khong co MySQL)
+            // sqlite[:PATH]: file SQLite nhung, mac dinh draw_guess.db trong thu muc hien tai
+            config.storage = argv[i] + 10;
+        } else if (strncmp(argv[i], "--journal=", 10) == 0) {
+            // Su kien ghi khong thanh cong khi MySQL mat ket noi, phat lai khi ket noi lai
+            config.journal_path = argv[i] + 10;
+        } else if (strcmp(argv[i], "--no-journal") == 0) {
+            config.journal_path = NULL;
+        } else if (argv[i][0] != '-') {
+            port = atoi(argv[i]);
+            if (port <= 0 || port > 65535) {
+                fprintf(stderr, "Port khong hop le. Su dung port mac dinh: %d\n", DEFAULT_PORT);
+                port = DEFAULT_PORT;
+            }
+        } else {
+            fprintf(stderr, "Tuy chon khong hop le: %s\n", argv[i]);
+            fprintf(stderr, "Cach dung: %s [port] [--canvas] [--stroke-tolerance=PX] [--rate-limit=nhom=rate/burst] [--idle-timeout=SEC] [--metrics=PORT|unix:PATH] [--stall-threshold=MS] [--capture=FILE] [--capture-anonymize] [--no-db] [--storage=mysql|memory|sqlite[:PATH]] [--journal=FILE] [--no-journal]\n", argv[0]);
+            return 1;
         }
     }
     
     // Dang ky xu ly tin hieu
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, metrics_signal_handler);
+    signal(SIGUSR2, metrics_signal_handler);
+    
+    // Seed mot lan cho ca tien trinh (xao tu trong game_init)
+    srand((unsigned int)time(NULL));
     
-    // Ket noi den database
-    // NOTE: pass the hostname (here localhost) as the first argument.
-    // The code in database.c currently uses port 3308 when calling mysql_real_connect
-    // so we connect to 127.0.0.1 (host) and port 3308 will be used inside db_connect.
-    db = db_connect("127.0.0.1", "root", "123456", "draw_guess");
-    if (!db) {
+    // Mo backend luu tru (MySQL: 127.0.0.1 port 3308, xem storage_mysql.c)
+    if (config.guest_login) {
+        printf("Chay khong database (--no-db): dang nhap guest, khong luu lich su\n");
+    } else if (storage_open(config.storage) != 0) {
+        if (strcmp(config.storage, "mysql") != 0) {
+            // Backend duoc chon tuong minh: khong mo duoc thi dung han
+            fprintf(stderr, "Khong the mo storage: %s\n", config.storage);
+            return 1;
+        }
         fprintf(stderr, "Khong the ket noi den database. Server van se chay nhung khong co database.\n");
         // Tiep tuc chay server du khong co database
     } else {
+        printf("Storage: %s\n", storage_backend_name());
         // Phase 5 - #17: load words vao database tu file
         // Thu mot vai path pho bien tuy theo working directory khi chay binary
         const char* candidates[] = {
@@ -65,7 +156,7 @@ int main(int argc, char *argv[]) {
         int loaded = -1;
         int tried = 0;
         for (int i = 0; candidates[i]; i++) {
-            loaded = db_load_words_from_file(db, candidates[i]);
+            loaded = storage_load_words_from_file(candidates[i]);
             tried++;
             if (loaded >= 0) {
                 // Thanh cong, khong can thu tiep
@@ -83,6 +174,33 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Khong the khoi tao server\n");
         return 1;
     }
+    server.config = config;
+    if (config.canvas_enabled) {
+        printf("Canvas raster phia server: BAT\n");
+    }
+    if (config.idle_timeout_ms > 0) {
+        printf("Idle timeout (client CAP_PING): %u giay\n", config.idle_timeout_ms / 1000);
+    }
+    stall_configure(config.stall_threshold_ms);
+    if (config.metrics_address) {
+        // Loi endpoint metrics khong dung server: game van chay, chi mat so lieu
+        if (metrics_http_listen(&server.metrics_http, config.metrics_address) == 0) {
+            printf("Metrics Prometheus: GET /metrics tai %s\n", config.metrics_address);
+        } else {
+            fprintf(stderr, "Canh bao: Khong the mo endpoint metrics %s\n", config.metrics_address);
+        }
+    }
+    
+    if (config.capture_path) {
+        // Nguoi dung chu dong yeu cau capture: khong mo duoc file thi dung han
+        if (capture_start(config.capture_path, config.capture_anonymize) != 0) {
+            fprintf(stderr, "Khong the mo file capture %s\n", config.capture_path);
+            server_cleanup(&server);
+            return 1;
+        }
+        printf("Capture traffic: %s%s\n", config.capture_path,
+               config.capture_anonymize ? " (an danh)" : "");
+    }
     
     // Bat dau lang nghe
     if (server_listen(&server) < 0) {
@@ -92,12 +210,12 @@ int main(int argc, char *argv[]) {
     }
     
     // Test authentication module
-    if (db) {
+    if (storage_available()) {
         
         // Test dang ky cho demo_user
         char hash[65];
         auth_hash_password("mypass123", hash);
-        int user_id = db_register_user(db, "demo_user", hash);
+        int user_id = storage_register_user("demo_user", hash);
         if(user_id > 0) {
             printf("Dang ky thanh cong: ID=%d\n", user_id);
         } else {
@@ -107,22 +225,25 @@ int main(int argc, char *argv[]) {
         // Dang ky them tai khoan taphuc1 voi mat khau phuc1234
         char hash2[65];
         auth_hash_password("phuc1234", hash2);
-        int user_id2 = db_register_user(db, "taphuc1", hash2);
+        int user_id2 = storage_register_user("taphuc1", hash2);
         if(user_id2 > 0) {
             printf("Dang ky thanh cong: ID=%d cho tai khoan taphuc1\n", user_id2);
         } else {
             printf("Dang ky that bai cho tai khoan taphuc1\n");
         }
+
+        // Mo journal sau cac buoc khoi dong (nap tu, tai khoan demo) de chung khong phu thuoc
+        // vao trang thai phat lai journal cua lan chay truoc
+        if (config.journal_path && storage_journal_open(config.journal_path) != 0) {
+            fprintf(stderr, "Khong the mo journal %s, ghi that bai khi mat database se bi bo\n", config.journal_path);
+        }
     }
 
     // Bat dau vong lap su kien
     server_event_loop(&server);
     
     // Don dep (thuong khong den day vi vong lap vo han)
-    if (db) {
-        db_disconnect(db);
-        db = NULL;
-    }
+    storage_close();
     server_cleanup(&server);
     
     return 0;
@@ -0,0 +1,394 @@
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static metrics_t metrics;
+
+// Message type dang dispatch (-1 = ngoai handler), de truy van DB biet tinh cho ai
+static int current_type = -1;
+
+// Dat tu signal handler, doc trong vong lap su kien
+static volatile sig_atomic_t dump_requested = 0;
+
+int latency_bucket_index(uint64_t value_ns)
+{
+    if (value_ns < LATENCY_SUB_COUNT)
+    {
+        return (int)value_ns;
+    }
+    int msb = 63 - __builtin_clzll(value_ns);
+    if (msb > LATENCY_MAX_MSB)
+    {
+        return LATENCY_BUCKETS - 1;
+    }
+    // [2^msb, 2^(msb+1)) chia LATENCY_SUB_COUNT phan theo cac bit ngay sau msb
+    int shift = msb - LATENCY_SUB_BITS;
+    return (shift + 1) * LATENCY_SUB_COUNT + (int)((value_ns >> shift) & (LATENCY_SUB_COUNT - 1));
+}
+
+uint64_t latency_bucket_lower(int index)
+{
+    if (index < LATENCY_SUB_COUNT)
+    {
+        return (uint64_t)index;
+    }
+    int shift = index / LATENCY_SUB_COUNT - 1;
+    return (uint64_t)(LATENCY_SUB_COUNT + index % LATENCY_SUB_COUNT) << shift;
+}
+
+static uint64_t bucket_width(int index)
+{
+    return index < LATENCY_SUB_COUNT ? 1 : (uint64_t)1 << (index / LATENCY_SUB_COUNT - 1);
+}
+
+void latency_hist_record(latency_hist_t *hist, uint64_t value_ns)
+{
+    hist->buckets[latency_bucket_index(value_ns)]++;
+    hist->count++;
+    hist->sum_ns += value_ns;
+    if (value_ns > hist->max_ns)
+    {
+        hist->max_ns = value_ns;
+    }
+}
+
+uint64_t latency_hist_quantile(const latency_hist_t *hist, double quantile)
+{
+    if (!hist || hist->count == 0)
+    {
+        return 0;
+    }
+    if (quantile < 0.0)
+    {
+        quantile = 0.0;
+    }
+    if (quantile > 1.0)
+    {
+        quantile = 1.0;
+    }
+
+    uint64_t rank = (uint64_t)(quantile * (double)hist->count + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t mid = latency_bucket_lower(i) + bucket_width(i) / 2;
+            return mid < hist->max_ns ? mid : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+void metrics_reset(void)
+{
+    memset(&metrics, 0, sizeof(metrics));
+    metrics.started_ms = utils_now_ms();
+}
+
+const metrics_t *metrics_get(void)
+{
+    return &metrics;
+}
+
+uint64_t metrics_dispatch_begin(uint8_t type)
+{
+    if (metrics.started_ms == 0)
+    {
+        metrics.started_ms = utils_now_ms();
+    }
+    current_type = type;
+    metrics.dispatch_db_queries = 0;
+    metrics.dispatch_db_ns = 0;
+    return utils_now_ns();
+}
+
+uint64_t metrics_dispatch_end(uint8_t type, uint32_t payload_len, uint64_t start_ns, int result)
+{
+    uint64_t now_ns = utils_now_ns();
+    uint64_t elapsed_ns = now_ns > start_ns ? now_ns - start_ns : 0;
+    msg_type_stats_t *stats = &metrics.types[type];
+    stats->calls++;
+    stats->bytes_in += payload_len;
+    if (result < 0)
+    {
+        stats->errors++;
+    }
+    latency_hist_record(&stats->latency, elapsed_ns);
+    metrics.dispatched++;
+    current_type = -1;
+    return elapsed_ns;
+}
+
+void metrics_record_rejected(uint8_t type, uint32_t payload_len)
+{
+    metrics.types[type].rejected++;
+    metrics.types[type].bytes_in += payload_len;
+}
+
+void metrics_record_db_query(uint64_t elapsed_ns, int ok)
+{
+    metrics.db_queries++;
+    if (!ok)
+    {
+        metrics.db_errors++;
+    }
+    latency_hist_record(&metrics.db_latency, elapsed_ns);
+
+    // Truy van ngoai handler (nap tu dien luc khoi dong, ...) chi tinh vao tong DB
+    if (current_type >= 0)
+    {
+        metrics.types[current_type].db_queries++;
+        metrics.types[current_type].db_ns += elapsed_ns;
+        metrics.dispatch_db_queries++;
+        metrics.dispatch_db_ns += elapsed_ns;
+    }
+}
+
+void metrics_record_sent(uint8_t type, size_t frame_len)
+{
+    metrics.types[type].sent++;
+    metrics.types[type].bytes_out += frame_len;
+}
+
+void metrics_record_broadcast(int recipients)
+{
+    latency_hist_record(&metrics.fanout, recipients > 0 ? (uint64_t)recipients : 0);
+}
+
+void metrics_record_loop(uint64_t elapsed_ns)
+{
+    latency_hist_record(&metrics.loop_latency, elapsed_ns);
+}
+
+void metrics_text_appendf(metrics_text_t *text, const char *fmt, ...)
+{
+    if (!text || text->failed)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        size_t room = text->capacity - text->len;
+        if (room > 0)
+        {
+            va_list args;
+            va_start(args, fmt);
+            int n = vsnprintf(text->data + text->len, room, fmt, args);
+            va_end(args);
+            if (n < 0)
+            {
+                text->failed = 1;
+                return;
+            }
+            if ((size_t)n < room)
+            {
+                text->len += (size_t)n;
+                return;
+            }
+        }
+
+        // Khong du cho: gap doi buffer roi ghi lai dong nay
+        size_t capacity = text->capacity ? text->capacity * 2 : 4096;
+        char *data = realloc(text->data, capacity);
+        if (!data)
+        {
+            text->failed = 1;
+            return;
+        }
+        text->data = data;
+        text->capacity = capacity;
+    }
+}
+
+void metrics_text_free(metrics_text_t *text)
+{
+    if (!text)
+    {
+        return;
+    }
+    free(text->data);
+    memset(text, 0, sizeof(*text));
+}
+
+// Nhan {type="0x01",name="MSG_..."} (name bo qua neu khong biet)
+static void type_labels(char *out, size_t size, int type, const char *(*type_name)(uint8_t type))
+{
+    const char *name = type_name ? type_name((uint8_t)type) : NULL;
+    if (name)
+    {
+        snprintf(out, size, "type=\"0x%02X\",name=\"%s\"", type, name);
+    }
+    else
+    {
+        snprintf(out, size, "type=\"0x%02X\"", type);
+    }
+}
+
+// Summary Prometheus tu histogram: phan vi + _sum + _count, scale doi ns sang giay (hoac 1 cho so dem)
+static void write_summary(metrics_text_t *text, const char *name, const char *labels,
+                          const latency_hist_t *hist, double scale)
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    const char *sep = labels[0] ? "," : "";
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++)
+    {
+        metrics_text_appendf(text, "%s{%s%squantile=\"%g\"} %.9g\n", name, labels, sep, quantiles[i],
+                             (double)latency_hist_quantile(hist, quantiles[i]) * scale);
+    }
+    if (labels[0])
+    {
+        metrics_text_appendf(text, "%s_sum{%s} %.9g\n%s_count{%s} %llu\n", name, labels,
+                             (double)hist->sum_ns * scale, name, labels, (unsigned long long)hist->count);
+    }
+    else
+    {
+        metrics_text_appendf(text, "%s_sum %.9g\n%s_count %llu\n", name, (double)hist->sum_ns * scale,
+                             name, (unsigned long long)hist->count);
+    }
+}
+
+// Mot counter theo type (chi type co so lieu), field lay bang offset trong msg_type_stats_t
+static void write_type_counter(metrics_text_t *text, const char *name, const char *help, size_t offset,
+                               double scale, const char *(*type_name)(uint8_t type))
+{
+    metrics_text_appendf(text, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for (int t = 0; t < 256; t++)
+    {
+        uint64_t value = *(const uint64_t *)((const char *)&metrics.types[t] + offset);
+        if (value == 0)
+        {
+            continue;
+        }
+        char labels[96];
+        type_labels(labels, sizeof(labels), t, type_name);
+        metrics_text_appendf(text, "%s{%s} %.9g\n", name, labels, (double)value * scale);
+    }
+}
+
+void metrics_write_prometheus(metrics_text_t *text, const char *(*type_name)(uint8_t type))
+{
+    write_type_counter(text, "drawguess_messages_received_total", "Messages dispatched to a handler",
+                       offsetof(msg_type_stats_t, calls), 1.0, type_name);
+    write_type_counter(text, "drawguess_message_errors_total", "Handlers that returned an error",
+                       offsetof(msg_type_stats_t, errors), 1.0, type_name);
+    write_type_counter(text, "drawguess_messages_rejected_total", "Messages rejected by rate limit or unknown type",
+                       offsetof(msg_type_stats_t, rejected), 1.0, type_name);
+    write_type_counter(text, "drawguess_received_bytes_total", "Payload bytes received",
+                       offsetof(msg_type_stats_t, bytes_in), 1.0, type_name);
+    write_type_counter(text, "drawguess_messages_sent_total", "Frames sent, by wire type",
+                       offsetof(msg_type_stats_t, sent), 1.0, type_name);
+    write_type_counter(text, "drawguess_sent_bytes_total", "Frame bytes sent including header, by wire type",
+                       offsetof(msg_type_stats_t, bytes_out), 1.0, type_name);
+    write_type_counter(text, "drawguess_handler_db_queries_total", "DB queries issued by handlers",
+                       offsetof(msg_type_stats_t, db_queries), 1.0, type_name);
+    write_type_counter(text, "drawguess_handler_db_seconds_total", "DB time spent inside handlers",
+                       offsetof(msg_type_stats_t, db_ns), 1e-9, type_name);
+
+    metrics_text_appendf(text, "# HELP drawguess_handler_seconds Handler latency\n"
+                               "# TYPE drawguess_handler_seconds summary\n");
+    for (int t = 0; t < 256; t++)
+    {
+        if (metrics.types[t].latency.count == 0)
+        {
+            continue;
+        }
+        char labels[96];
+        type_labels(labels, sizeof(labels), t, type_name);
+        write_summary(text, "drawguess_handler_seconds", labels, &metrics.types[t].latency, 1e-9);
+    }
+
+    metrics_text_appendf(text, "# HELP drawguess_db_query_seconds db_execute_query latency\n"
+                               "# TYPE drawguess_db_query_seconds summary\n");
+    write_summary(text, "drawguess_db_query_seconds", "", &metrics.db_latency, 1e-9);
+    metrics_text_appendf(text, "# HELP drawguess_db_query_errors_total Failed DB queries\n"
+                               "# TYPE drawguess_db_query_errors_total counter\n"
+                               "drawguess_db_query_errors_total %llu\n",
+                         (unsigned long long)metrics.db_errors);
+
+    metrics_text_appendf(text, "# HELP drawguess_event_loop_seconds Event loop iteration time after select()\n"
+                               "# TYPE drawguess_event_loop_seconds summary\n");
+    write_summary(text, "drawguess_event_loop_seconds", "", &metrics.loop_latency, 1e-9);
+
+    metrics_text_appendf(text, "# HELP drawguess_broadcast_fanout Clients reached per broadcast\n"
+                               "# TYPE drawguess_broadcast_fanout summary\n");
+    write_summary(text, "drawguess_broadcast_fanout", "", &metrics.fanout, 1.0);
+}
+
+void metrics_request_dump(void)
+{
+    dump_requested = 1;
+}
+
+int metrics_take_dump_request(void)
+{
+    if (!dump_requested)
+    {
+        return 0;
+    }
+    dump_requested = 0;
+    return 1;
+}
+
+static double ns_to_us(uint64_t ns)
+{
+    return (double)ns / 1000.0;
+}
+
+void metrics_dump(FILE *out, const char *(*type_name)(uint8_t type))
+{
+    if (!out)
+    {
+        return;
+    }
+
+    uint64_t uptime_ms = metrics.started_ms ? utils_now_ms() - metrics.started_ms : 0;
+    fprintf(out, "=== Metrics theo message type (%llu giay) ===\n", (unsigned long long)(uptime_ms / 1000));
+    fprintf(out, "%-4s %-28s %9s %6s %6s %11s %9s %9s %9s %10s %7s %9s\n",
+            "type", "ten", "calls", "loi", "bo", "bytes_in", "p50(us)", "p90(us)", "p99(us)", "max(us)",
+            "db_q", "db(ms)");
+
+    for (int t = 0; t < 256; t++)
+    {
+        const msg_type_stats_t *stats = &metrics.types[t];
+        if (stats->calls == 0 && stats->rejected == 0)
+        {
+            continue;
+        }
+        const char *name = type_name ? type_name((uint8_t)t) : NULL;
+        fprintf(out, "0x%02X %-28s %9llu %6llu %6llu %11llu %9.1f %9.1f %9.1f %10.1f %7llu %9.1f\n",
+                t, name ? name : "-",
+                (unsigned long long)stats->calls, (unsigned long long)stats->errors,
+                (unsigned long long)stats->rejected, (unsigned long long)stats->bytes_in,
+                ns_to_us(latency_hist_quantile(&stats->latency, 0.50)),
+                ns_to_us(latency_hist_quantile(&stats->latency, 0.90)),
+                ns_to_us(latency_hist_quantile(&stats->latency, 0.99)),
+                ns_to_us(stats->latency.max_ns),
+                (unsigned long long)stats->db_queries, (double)stats->db_ns / 1e6);
+    }
+
+    const latency_hist_t *loop = &metrics.loop_latency;
+    fprintf(out, "Vong lap: %llu lan, p50 %.1fus, p99 %.1fus, max %.1fus | broadcast: %llu lan, p99 %llu client\n",
+            (unsigned long long)loop->count, ns_to_us(latency_hist_quantile(loop, 0.50)),
+            ns_to_us(latency_hist_quantile(loop, 0.99)), ns_to_us(loop->max_ns),
+            (unsigned long long)metrics.fanout.count,
+            (unsigned long long)latency_hist_quantile(&metrics.fanout, 0.99));
+
+    const latency_hist_t *db = &metrics.db_latency;
+    fprintf(out, "DB: %llu truy van, %llu loi, p50 %.1fus, p99 %.1fus, max %.1fus, tong %.1fms\n",
+            (unsigned long long)metrics.db_queries, (unsigned long long)metrics.db_errors,
+            ns_to_us(latency_hist_quantile(db, 0.50)), ns_to_us(latency_hist_quantile(db, 0.99)),
+            ns_to_us(db->max_ns), (double)db->sum_ns / 1e6);
+    fflush(out);
+}
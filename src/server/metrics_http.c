@@ -0,0 +1,441 @@
+#include "../include/metrics_http.h"
+#include "../include/server.h"
+#include "../include/protocol.h"
+#include "../include/stall.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/un.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: khong co co nay, scraper dong som chi lam send() loi
+#endif
+
+static void conn_close(metrics_http_conn_t *conn)
+{
+    if (conn->fd >= 0)
+    {
+        close(conn->fd);
+    }
+    metrics_text_free(&conn->response);
+    conn->fd = -1;
+    conn->request_len = 0;
+    conn->sent = 0;
+}
+
+void metrics_http_init(metrics_http_t *http)
+{
+    memset(http, 0, sizeof(*http));
+    http->listen_fd = -1;
+    for (int i = 0; i < METRICS_HTTP_MAX_CONNS; i++)
+    {
+        http->conns[i].fd = -1;
+    }
+}
+
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int listen_unix(metrics_http_t *http, const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "Loi: Duong dan metrics socket qua dai: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        perror("metrics socket() failed");
+        return -1;
+    }
+    unlink(path); // Socket cu con sot lai khi server bi kill
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("metrics bind() failed");
+        close(fd);
+        return -1;
+    }
+    snprintf(http->unix_path, sizeof(http->unix_path), "%s", path);
+    return fd;
+}
+
+static int listen_tcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        perror("metrics socket() failed");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Chi nghe loopback: so lieu noi bo, khong mo ra ngoai
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("metrics bind() failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int metrics_http_listen(metrics_http_t *http, const char *address)
+{
+    if (!http || !address)
+    {
+        return -1;
+    }
+
+    int fd;
+    if (strncmp(address, "unix:", 5) == 0)
+    {
+        fd = listen_unix(http, address + 5);
+    }
+    else
+    {
+        int port = atoi(address);
+        if (port <= 0 || port > 65535)
+        {
+            fprintf(stderr, "Loi: Port metrics khong hop le: %s\n", address);
+            return -1;
+        }
+        fd = listen_tcp(port);
+    }
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (set_nonblocking(fd) < 0 || listen(fd, METRICS_HTTP_MAX_CONNS) < 0)
+    {
+        perror("metrics listen() failed");
+        close(fd);
+        return -1;
+    }
+    http->listen_fd = fd;
+    return 0;
+}
+
+void metrics_http_fill_fds(metrics_http_t *http, fd_set *read_fds, fd_set *write_fds, int *max_fd)
+{
+    if (http->listen_fd < 0)
+    {
+        return;
+    }
+
+    FD_SET(http->listen_fd, read_fds);
+    if (http->listen_fd > *max_fd)
+    {
+        *max_fd = http->listen_fd;
+    }
+
+    for (int i = 0; i < METRICS_HTTP_MAX_CONNS; i++)
+    {
+        metrics_http_conn_t *conn = &http->conns[i];
+        if (conn->fd < 0)
+        {
+            continue;
+        }
+        // Chua dung response thi cho doc request, da dung thi cho ghi
+        FD_SET(conn->fd, conn->response.len > 0 ? write_fds : read_fds);
+        if (conn->fd > *max_fd)
+        {
+            *max_fd = conn->fd;
+        }
+    }
+}
+
+static void accept_conns(metrics_http_t *http, uint64_t now_ms)
+{
+    for (;;)
+    {
+        int fd = accept(http->listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                perror("metrics accept() failed");
+            }
+            return;
+        }
+
+        metrics_http_conn_t *slot = NULL;
+        for (int i = 0; i < METRICS_HTTP_MAX_CONNS && !slot; i++)
+        {
+            if (http->conns[i].fd < 0)
+            {
+                slot = &http->conns[i];
+            }
+        }
+        if (!slot || set_nonblocking(fd) < 0)
+        {
+            close(fd); // Qua nhieu scraper cung luc
+            continue;
+        }
+        slot->fd = fd;
+        slot->request_len = 0;
+        slot->sent = 0;
+        slot->accepted_ms = now_ms;
+    }
+}
+
+// Tong du lieu chua gui trong kernel (hang doi gui) cua mot client socket, -1 neu khong do duoc
+static long outbound_queue_bytes(int fd)
+{
+#if defined(SO_NWRITE)
+    int pending = 0;
+    socklen_t len = sizeof(pending);
+    if (getsockopt(fd, SOL_SOCKET, SO_NWRITE, &pending, &len) == 0)
+    {
+        return pending;
+    }
+#elif defined(TIOCOUTQ)
+    int pending = 0;
+    if (ioctl(fd, TIOCOUTQ, &pending) == 0)
+    {
+        return pending;
+    }
+#else
+    (void)fd;
+#endif
+    return -1;
+}
+
+static void write_gauge(metrics_text_t *text, const char *name, const char *help, double value)
+{
+    metrics_text_appendf(text, "# HELP %s %s\n# TYPE %s gauge\n%s %.9g\n", name, help, name, name, value);
+}
+
+void metrics_http_render(server_t *server, metrics_text_t *text)
+{
+    int connected = 0;
+    int authenticated = 0;
+    long queue_total = 0;
+    long queue_max = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        client_t *client = &server->clients[i];
+        if (!client->active)
+        {
+            continue;
+        }
+        connected++;
+        if (client->user_id > 0)
+        {
+            authenticated++;
+        }
+        long pending = outbound_queue_bytes(client->fd);
+        if (pending > 0)
+        {
+            queue_total += pending;
+            if (pending > queue_max)
+            {
+                queue_max = pending;
+            }
+        }
+    }
+
+    int rooms = 0;
+    int games = 0;
+    for (int r = 0; r < MAX_ROOMS; r++)
+    {
+        room_t *room = server->rooms[r];
+        if (!room)
+        {
+            continue;
+        }
+        rooms++;
+        if (room->state == ROOM_PLAYING && room->game)
+        {
+            games++;
+        }
+    }
+
+    write_gauge(text, "drawguess_clients_connected", "Open client connections", connected);
+    write_gauge(text, "drawguess_clients_authenticated", "Logged-in clients", authenticated);
+    write_gauge(text, "drawguess_lobby_subscribers", "Clients watching the room list", server->lobby_subscriber_count);
+    write_gauge(text, "drawguess_rooms_active", "Open rooms", rooms);
+    write_gauge(text, "drawguess_games_active", "Rooms with a game in progress", games);
+    write_gauge(text, "drawguess_outbound_queue_bytes", "Unsent bytes in client socket send queues", (double)queue_total);
+    write_gauge(text, "drawguess_outbound_queue_max_bytes", "Largest client socket send queue", (double)queue_max);
+
+    metrics_text_appendf(text, "# HELP drawguess_rate_limited_total Messages rejected by rate limit\n"
+                               "# TYPE drawguess_rate_limited_total counter\n");
+    for (int c = 0; c < RATE_CLASS_COUNT; c++)
+    {
+        metrics_text_appendf(text, "drawguess_rate_limited_total{class=\"%s\"} %llu\n",
+                             ratelimit_class_name(c), (unsigned long long)server->rate_dropped[c]);
+    }
+    metrics_text_appendf(text, "# HELP drawguess_idle_reaped_total Clients disconnected by idle timeout\n"
+                               "# TYPE drawguess_idle_reaped_total counter\n"
+                               "drawguess_idle_reaped_total %llu\n",
+                         (unsigned long long)server->idle_reaped);
+    metrics_text_appendf(text, "# HELP drawguess_stalls_total Handlers or loop iterations over the stall threshold\n"
+                               "# TYPE drawguess_stalls_total counter\n"
+                               "drawguess_stalls_total %llu\n",
+                         (unsigned long long)stall_total());
+
+    metrics_write_prometheus(text, protocol_message_name);
+}
+
+// Dung response khi da doc xong header request
+static void build_response(metrics_http_t *http, metrics_http_conn_t *conn, server_t *server)
+{
+    const char *status = "404 Not Found";
+    metrics_text_t body = {0};
+    if (strncmp(conn->request, "GET /metrics ", 13) == 0 || strncmp(conn->request, "GET /metrics?", 13) == 0)
+    {
+        status = "200 OK";
+        metrics_http_render(server, &body);
+        http->scrapes++;
+    }
+    else if (strncmp(conn->request, "GET /stalls ", 12) == 0)
+    {
+        status = "200 OK";
+        stall_write_text(&body, protocol_message_name);
+    }
+    else
+    {
+        metrics_text_appendf(&body, "Chi ho tro GET /metrics, GET /stalls\n");
+    }
+
+    if (body.failed)
+    {
+        status = "500 Internal Server Error";
+        body.len = 0;
+    }
+    metrics_text_appendf(&conn->response,
+                         "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                         "Content-Length: %zu\r\nConnection: close\r\n\r\n%.*s",
+                         status, body.len, (int)body.len, body.data ? body.data : "");
+    metrics_text_free(&body);
+}
+
+static void handle_read(metrics_http_t *http, metrics_http_conn_t *conn, server_t *server)
+{
+    size_t room = sizeof(conn->request) - 1 - conn->request_len;
+    ssize_t n = recv(conn->fd, conn->request + conn->request_len, room, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if (n <= 0)
+    {
+        conn_close(conn);
+        return;
+    }
+    conn->request_len += (size_t)n;
+    conn->request[conn->request_len] = '\0';
+
+    // Du header (dong trong) hoac buffer day: tra loi luon, bo qua phan con lai
+    if (strstr(conn->request, "\r\n\r\n") || strstr(conn->request, "\n\n") ||
+        conn->request_len == sizeof(conn->request) - 1)
+    {
+        build_response(http, conn, server);
+        if (conn->response.failed || conn->response.len == 0)
+        {
+            conn_close(conn);
+        }
+    }
+}
+
+static void handle_write(metrics_http_conn_t *conn)
+{
+    ssize_t n = send(conn->fd, conn->response.data + conn->sent, conn->response.len - conn->sent, MSG_NOSIGNAL);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if (n <= 0)
+    {
+        conn_close(conn);
+        return;
+    }
+    conn->sent += (size_t)n;
+    if (conn->sent == conn->response.len)
+    {
+        conn_close(conn);
+    }
+}
+
+void metrics_http_handle(metrics_http_t *http, server_t *server, const fd_set *read_fds,
+                         const fd_set *write_fds, uint64_t now_ms)
+{
+    if (http->listen_fd < 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < METRICS_HTTP_MAX_CONNS; i++)
+    {
+        metrics_http_conn_t *conn = &http->conns[i];
+        if (conn->fd < 0)
+        {
+            continue;
+        }
+        if (conn->response.len > 0)
+        {
+            if (FD_ISSET(conn->fd, write_fds))
+            {
+                handle_write(conn);
+            }
+        }
+        else if (FD_ISSET(conn->fd, read_fds))
+        {
+            handle_read(http, conn, server);
+        }
+
+        // Scraper cham/treo khong giu slot mai
+        if (conn->fd >= 0 && now_ms - conn->accepted_ms > METRICS_HTTP_TIMEOUT_MS)
+        {
+            conn_close(conn);
+        }
+    }
+
+    if (FD_ISSET(http->listen_fd, read_fds))
+    {
+        accept_conns(http, now_ms);
+    }
+}
+
+void metrics_http_close(metrics_http_t *http)
+{
+    if (!http)
+    {
+        return;
+    }
+    for (int i = 0; i < METRICS_HTTP_MAX_CONNS; i++)
+    {
+        conn_close(&http->conns[i]);
+    }
+    if (http->listen_fd >= 0)
+    {
+        close(http->listen_fd);
+        http->listen_fd = -1;
+    }
+    if (http->unix_path[0])
+    {
+        unlink(http->unix_path);
+        http->unix_path[0] = '\0';
+    }
+}
@@ -1,73 +1,153 @@
 #include "../include/protocol.h"
 #include "../common/protocol.h"
+#include "../include/ratelimit.h"
+#include "../include/utils.h"
+#include "../include/metrics.h"
+#include "../include/stall.h"
 #include <stdio.h>
 
-// Forward declarations cho cac handlers tu cac module khac
-extern int protocol_handle_login(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_register(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_room_list_request(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_create_room(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_join_room(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_leave_room(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_draw_data(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_start_game(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_guess_word(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_logout(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_chat_message(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_get_game_history(server_t* server, int client_index, const message_t* msg);
-extern int protocol_handle_change_password(server_t* server, int client_index, const message_t* msg);
+// Bang dispatch: message type -> handler (them message moi chi can them mot dong)
+#define PROTOCOL_HANDLERS(X) \
+    X(MSG_LOGIN_REQUEST, protocol_handle_login) \
+    X(MSG_REGISTER_REQUEST, protocol_handle_register) \
+    X(MSG_LOGOUT, protocol_handle_logout) \
+    X(MSG_CHANGE_PASSWORD_REQUEST, protocol_handle_change_password) \
+    X(MSG_ROOM_LIST_REQUEST, protocol_handle_room_list_request) \
+    X(MSG_LOBBY_SUBSCRIBE, protocol_handle_lobby_subscribe) \
+    X(MSG_LOBBY_UNSUBSCRIBE, protocol_handle_lobby_unsubscribe) \
+    X(MSG_CREATE_ROOM, protocol_handle_create_room) \
+    X(MSG_JOIN_ROOM, protocol_handle_join_room) \
+    X(MSG_LEAVE_ROOM, protocol_handle_leave_room) \
+    X(MSG_DRAW_DATA, protocol_handle_draw_data) \
+    X(MSG_START_GAME, protocol_handle_start_game) \
+    X(MSG_GUESS_WORD, protocol_handle_guess_word) \
+    X(MSG_CHAT_MESSAGE, protocol_handle_chat_message) \
+    X(MSG_GET_GAME_HISTORY, protocol_handle_get_game_history) \
+    X(MSG_HELLO, protocol_handle_hello) \
+    X(MSG_PING, protocol_handle_ping) \
+    X(MSG_PONG, protocol_handle_pong)
 
-/**
- * Xu ly message nhan duoc tu client
- */
-int protocol_handle_message(server_t* server, int client_index, const message_t* msg) {
-    if (!server || !msg) {
-        return -1;
-    }
+typedef int (*protocol_handler_t)(server_t* server, int client_index, const message_t* msg);
 
-    switch (msg->type) {
-        case MSG_LOGIN_REQUEST:
-            return protocol_handle_login(server, client_index, msg);
-            
-        case MSG_REGISTER_REQUEST:
-            return protocol_handle_register(server, client_index, msg);
-            
-        case MSG_LOGOUT:
-            return protocol_handle_logout(server, client_index, msg);
+// Forward declarations cho cac handlers tu cac module khac
+#define PROTOCOL_DECLARE_HANDLER(type, fn) extern int fn(server_t* server, int client_index, const message_t* msg);
+PROTOCOL_HANDLERS(PROTOCOL_DECLARE_HANDLER)
 
-        case MSG_CHANGE_PASSWORD_REQUEST:
-            return protocol_handle_change_password(server, client_index, msg);
+// Tra bang theo type (1 byte) thay vi switch, o trong = message khong ho tro
+#define PROTOCOL_HANDLER_ENTRY(type, fn) [type] = fn,
+static const protocol_handler_t protocol_handlers[256] = {
+    PROTOCOL_HANDLERS(PROTOCOL_HANDLER_ENTRY)
+};
 
-        case MSG_ROOM_LIST_REQUEST:
-            return protocol_handle_room_list_request(server, client_index, msg);
+// Ten message type co handler (metrics, log), NULL neu khong co
+#define PROTOCOL_HANDLER_NAME(type, fn) [type] = #type,
+static const char* const protocol_handler_names[256] = {
+    PROTOCOL_HANDLERS(PROTOCOL_HANDLER_NAME)
+};
 
-        case MSG_CREATE_ROOM:
-            return protocol_handle_create_room(server, client_index, msg);
+const char* protocol_message_name(uint8_t type) {
+    return protocol_handler_names[type];
+}
 
-        case MSG_JOIN_ROOM:
-            return protocol_handle_join_room(server, client_index, msg);
+// Ghi handler cham vao flight recorder (chi khi vuot nguong, tim phong O(MAX_ROOMS))
+static void record_slow_message(server_t* server, int client_index, const message_t* msg, uint64_t elapsed_ns) {
+    const metrics_t* m = metrics_get();
+    stall_record_t record = {
+        .kind = STALL_KIND_MESSAGE,
+        .duration_ns = elapsed_ns,
+        .db_queries = m->dispatch_db_queries,
+        .db_ns = m->dispatch_db_ns,
+        .msg_type = msg->type,
+        .payload_len = msg->length,
+        .client_index = client_index,
+        .user_id = -1,
+    };
+    if (client_index >= 0 && client_index < MAX_CLIENTS) {
+        record.user_id = server->clients[client_index].user_id;
+        room_t* room = record.user_id > 0 ? server_find_room_by_user(server, record.user_id) : NULL;
+        record.room_id = room ? room->room_id : 0;
+    }
+    stall_push(&record);
+}
 
-        case MSG_LEAVE_ROOM:
-            return protocol_handle_leave_room(server, client_index, msg);
+#define RATE_LIMITED_MESSAGE "Qua nhieu yeu cau, vui long thu lai sau"
 
-        case MSG_DRAW_DATA:
-            return protocol_handle_draw_data(server, client_index, msg);
+// Request co response thi tra loi loi de client/gateway khong cho mai;
+// DRAW_DATA, CHAT, GUESS, LOBBY_(UN)SUBSCRIBE la fire-and-forget nen bo im lang
+static void reply_rate_limited(client_t* client, uint8_t type) {
+    switch (type) {
+    case MSG_LOGIN_REQUEST:
+        protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
+        break;
+    case MSG_REGISTER_REQUEST:
+        protocol_send_register_response(client->fd, STATUS_ERROR, RATE_LIMITED_MESSAGE);
+        break;
+    case MSG_CHANGE_PASSWORD_REQUEST:
+        protocol_send_change_password_response(client->fd, STATUS_ERROR, RATE_LIMITED_MESSAGE);
+        break;
+    case MSG_CREATE_ROOM:
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1, RATE_LIMITED_MESSAGE);
+        break;
+    case MSG_JOIN_ROOM:
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1, RATE_LIMITED_MESSAGE);
+        break;
+    case MSG_LEAVE_ROOM:
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR, RATE_LIMITED_MESSAGE);
+        break;
+    case MSG_START_GAME:
+    case MSG_ROOM_LIST_REQUEST:
+    case MSG_GET_GAME_HISTORY:
+        // Response cua cac request nay khong co status
+        protocol_send_error(client->fd, type, RATE_LIMITED_MESSAGE);
+        break;
+    default:
+        break;
+    }
+}
 
-        case MSG_START_GAME:
-            return protocol_handle_start_game(server, client_index, msg);
+/**
+ * Xu ly message nhan duoc tu client
+ */
+int protocol_handle_message(server_t* server, int client_index, const message_t* msg) {
+    if (!server || !msg) {
+        return -1;
+    }
 
-        case MSG_GUESS_WORD:
-            return protocol_handle_guess_word(server, client_index, msg);
+    // Kiem tra token bucket cua client truoc khi dispatch, de mot client
+    // spam DRAW_DATA/CHAT/ROOM_LIST khong lam nghen vong lap su kien
+    int rate_class = ratelimit_class_for(msg->type);
+    if (rate_class != RATE_CLASS_NONE && client_index >= 0 && client_index < MAX_CLIENTS) {
+        client_t* client = &server->clients[client_index];
+        if (!ratelimit_consume(&client->rate.buckets[rate_class],
+                               &server->config.rate_limits[rate_class], utils_now_ms())) {
+            client->rate.dropped[rate_class]++;
+            server->rate_dropped[rate_class]++;
+            // Chi log lan dau va moi 100 lan de log khong thanh nguon tai
+            if (client->rate.dropped[rate_class] == 1 || client->rate.dropped[rate_class] % 100 == 0) {
+                fprintf(stderr, "Rate limit: bo message 0x%02X tu client %d (nhom '%s', da bo %u)\n",
+                        msg->type, client_index, ratelimit_class_name(rate_class),
+                        client->rate.dropped[rate_class]);
+            }
+            metrics_record_rejected(msg->type, msg->length);
+            reply_rate_limited(client, msg->type);
+            return -1;
+        }
+    }
 
-        case MSG_CHAT_MESSAGE:
-            return protocol_handle_chat_message(server, client_index, msg);
+    protocol_handler_t handler = protocol_handlers[msg->type];
+    if (!handler) {
+        fprintf(stderr, "Unknown message type: 0x%02X tu client %d\n",
+                msg->type, client_index);
+        metrics_record_rejected(msg->type, msg->length);
+        return -1;
+    }
 
-        case MSG_GET_GAME_HISTORY:
-            return protocol_handle_get_game_history(server, client_index, msg);
-            
-        default:
-            fprintf(stderr, "Unknown message type: 0x%02X tu client %d\n", 
-                    msg->type, client_index);
-            return -1;
+    // Do thoi gian handler (gom ca truy van DB) vao histogram cua type
+    uint64_t start_ns = metrics_dispatch_begin(msg->type);
+    int result = handler(server, client_index, msg);
+    uint64_t elapsed_ns = metrics_dispatch_end(msg->type, msg->length, start_ns, result);
+    if (stall_exceeds(elapsed_ns)) {
+        record_slow_message(server, client_index, msg, elapsed_ns);
     }
+    return result;
 }
@@ -1,8 +1,9 @@
 #include "../include/protocol.h"
 #include "../include/auth.h"
-#include "../include/database.h"
+#include "../include/storage.h"
 #include "../include/game.h"
 #include "../common/protocol.h"
+#include "../common/codec.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,7 +11,6 @@
 #include <unistd.h>
 
 // External database connection (tu main.c)
-extern db_connection_t* db;
 
 // Forward declaration from protocol_game.c
 extern int protocol_handle_round_timeout(server_t* server, room_t* room, const char* word_before_clear);
@@ -19,55 +19,51 @@ extern int protocol_handle_round_timeout(server_t* server, room_t* room, const c
  * Gui LOGIN_RESPONSE
  */
 int protocol_send_login_response(int client_fd, uint8_t status, int32_t user_id, const char* username) {
-    login_response_t response;
+    msg_login_response_t response;
     memset(&response, 0, sizeof(response));
     
     response.status = status;
-    response.user_id = (int32_t)htonl((uint32_t)user_id);  // Convert to network byte order
+    response.user_id = user_id;
     
     if (username) {
         strncpy(response.username, username, MAX_USERNAME_LEN - 1);
-        response.username[MAX_USERNAME_LEN - 1] = '\0';
     }
 
-    return protocol_send_message(client_fd, MSG_LOGIN_RESPONSE, 
-                                (uint8_t*)&response, sizeof(response));
+    uint8_t payload[CODEC_LOGIN_RESPONSE_MAX_SIZE];
+    size_t len = msg_login_response_encode(&response, payload, sizeof(payload));
+    return protocol_send_message(client_fd, MSG_LOGIN_RESPONSE, payload, (uint16_t)len);
 }
 
 /**
- * Gui REGISTER_RESPONSE
+ * Gui response chi gom status + message (REGISTER, CHANGE_PASSWORD)
  */
-int protocol_send_register_response(int client_fd, uint8_t status, const char* message) {
-    register_response_t response;
+static int send_status_response(int client_fd, uint8_t type, uint8_t status, const char* message) {
+    msg_status_response_t response;
     memset(&response, 0, sizeof(response));
     
     response.status = status;
     
     if (message) {
         strncpy(response.message, message, sizeof(response.message) - 1);
-        response.message[sizeof(response.message) - 1] = '\0';
     }
 
-    return protocol_send_message(client_fd, MSG_REGISTER_RESPONSE, 
-                                (uint8_t*)&response, sizeof(response));
+    uint8_t payload[CODEC_STATUS_RESPONSE_MAX_SIZE];
+    size_t len = msg_status_response_encode(&response, payload, sizeof(payload));
+    return protocol_send_message(client_fd, type, payload, (uint16_t)len);
+}
+
+/**
+ * Gui REGISTER_RESPONSE
+ */
+int protocol_send_register_response(int client_fd, uint8_t status, const char* message) {
+    return send_status_response(client_fd, MSG_REGISTER_RESPONSE, status, message);
 }
 
 /**
  * Gui CHANGE_PASSWORD_RESPONSE
  */
 int protocol_send_change_password_response(int client_fd, uint8_t status, const char* message) {
-    change_password_response_t response;
-    memset(&response, 0, sizeof(response));
-    
-    response.status = status;
-    
-    if (message) {
-        strncpy(response.message, message, sizeof(response.message) - 1);
-        response.message[sizeof(response.message) - 1] = '\0';
-    }
-
-    return protocol_send_message(client_fd, MSG_CHANGE_PASSWORD_RESPONSE, 
-                                (uint8_t*)&response, sizeof(response));
+    return send_status_response(client_fd, MSG_CHANGE_PASSWORD_RESPONSE, status, message);
 }
 
 /**
@@ -79,6 +75,19 @@ int protocol_send_account_logged_in_elsewhere(int client_fd) {
 }
 
 
+// Id guest (--no-db): FNV-1a cua username, nam ngoai day id AUTO_INCREMENT cua bang users
+// Cung ten luon cung id nen dang nhap lai van vao dung ghe trong phong
+#define GUEST_USER_ID_BASE 1000000000u
+
+static int guest_user_id(const char* username) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = username; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+    return (int)(GUEST_USER_ID_BASE + hash % GUEST_USER_ID_BASE);
+}
+
 /**
  * Xu ly LOGIN_REQUEST
  */
@@ -92,48 +101,43 @@ int protocol_handle_login(server_t* server, int client_index, const message_t* m
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(login_request_t)) {
+    // Parse payload (decoder kiem tra do dai va dam bao null-terminated)
+    msg_login_request_t req;
+    if (msg_login_request_decode(msg->payload, msg->length, &req) < 0) {
         protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
         return -1;
     }
-
-    // Parse payload
-    login_request_t* req = (login_request_t*)msg->payload;
-    
-    // Dam bao null-terminated
-    char username[MAX_USERNAME_LEN];
-    char password[MAX_PASSWORD_LEN];
-    char avatar[32];
-    strncpy(username, req->username, MAX_USERNAME_LEN - 1);
-    username[MAX_USERNAME_LEN - 1] = '\0';
-    strncpy(password, req->password, MAX_PASSWORD_LEN - 1);
-    password[MAX_PASSWORD_LEN - 1] = '\0';
-    strncpy(avatar, req->avatar, sizeof(avatar) - 1);
-    avatar[sizeof(avatar) - 1] = '\0';
+    char* username = req.username;
+    char* password = req.password;
+    char* avatar = req.avatar;
     // Default avatar nếu không có
     if (avatar[0] == '\0') {
-        strncpy(avatar, "avt1.jpg", sizeof(avatar) - 1);
-        avatar[sizeof(avatar) - 1] = '\0';
+        strncpy(avatar, "avt1.jpg", sizeof(req.avatar) - 1);
     }
 
     printf("Nhan LOGIN_REQUEST tu client %d: username=%s, avatar=%s\n", client_index, username, avatar);
 
-    // Kiem tra database connection
-    if (!db) {
-        protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
-        return -1;
-    }
+    int user_id;
+    if (!storage_available() && server->config.guest_login) {
+        // Khong co database (--no-db): chi kiem tra username, bo qua mat khau
+        user_id = auth_validate_username(username) ? guest_user_id(username) : -1;
+    } else {
+        // Kiem tra database connection
+        if (!storage_available()) {
+            protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
+            return -1;
+        }
 
-    // Hash password
-    char password_hash[65];
-    if (auth_hash_password(password, password_hash) != 0) {
-        protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
-        return -1;
-    }
+        // Hash password
+        char password_hash[65];
+        if (auth_hash_password(password, password_hash) != 0) {
+            protocol_send_login_response(client->fd, STATUS_ERROR, -1, "");
+            return -1;
+        }
 
-    // Xac thuc user
-    int user_id = db_authenticate_user(db, username, password_hash);
+        // Xac thuc user
+        user_id = storage_authenticate_user(username, password_hash);
+    }
     
     if (user_id > 0) {
         // Kiem tra user da dang nhap va dang active chua
@@ -210,25 +214,15 @@ int protocol_handle_register(server_t* server, int client_index, const message_t
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(register_request_t)) {
+    // Parse payload (decoder kiem tra do dai va dam bao null-terminated)
+    msg_register_request_t req;
+    if (msg_register_request_decode(msg->payload, msg->length, &req) < 0) {
         protocol_send_register_response(client->fd, STATUS_ERROR, "Du lieu khong hop le");
         return -1;
     }
-
-    // Parse payload
-    register_request_t* req = (register_request_t*)msg->payload;
-    
-    // Dam bao null-terminated
-    char username[MAX_USERNAME_LEN];
-    char password[MAX_PASSWORD_LEN];
-    char email[MAX_EMAIL_LEN];
-    strncpy(username, req->username, MAX_USERNAME_LEN - 1);
-    username[MAX_USERNAME_LEN - 1] = '\0';
-    strncpy(password, req->password, MAX_PASSWORD_LEN - 1);
-    password[MAX_PASSWORD_LEN - 1] = '\0';
-    strncpy(email, req->email, MAX_EMAIL_LEN - 1);
-    email[MAX_EMAIL_LEN - 1] = '\0';
+    const char* username = req.username;
+    const char* password = req.password;
+    const char* email = req.email;
 
     printf("Nhan REGISTER_REQUEST tu client %d: username=%s, email=%s\n", 
            client_index, username, email);
@@ -247,8 +241,14 @@ int protocol_handle_register(server_t* server, int client_index, const message_t
         return -1;
     }
 
+    // Khong database (--no-db): khong co gi de luu, moi username hop le deu dang nhap duoc
+    if (!storage_available() && server->config.guest_login) {
+        protocol_send_register_response(client->fd, STATUS_SUCCESS, "Che do guest: dang nhap bang username bat ky");
+        return 0;
+    }
+
     // Kiem tra database connection
-    if (!db) {
+    if (!storage_available()) {
         protocol_send_register_response(client->fd, STATUS_ERROR, 
                                        "Loi ket noi database");
         return -1;
@@ -263,7 +263,7 @@ int protocol_handle_register(server_t* server, int client_index, const message_t
     }
 
     // Dang ky user
-    int user_id = db_register_user(db, username, password_hash);
+    int user_id = storage_register_user(username, password_hash);
     
     if (user_id > 0) {
         // Dang ky thanh cong
@@ -383,6 +383,7 @@ int protocol_handle_logout(server_t* server, int client_index, const message_t*
     }
 
     // Reset client state
+    server_lobby_unsubscribe(server, client_index);
     client->user_id = -1;
     client->username[0] = '\0';
     client->state = CLIENT_STATE_LOGGED_OUT;
@@ -411,23 +412,15 @@ int protocol_handle_change_password(server_t* server, int client_index, const me
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(change_password_request_t)) {
+    // Parse payload (decoder kiem tra do dai va dam bao null-terminated)
+    msg_change_password_request_t req;
+    if (msg_change_password_request_decode(msg->payload, msg->length, &req) < 0) {
         protocol_send_change_password_response(client->fd, STATUS_ERROR, 
                                              "Du lieu khong hop le");
         return -1;
     }
-
-    // Parse payload
-    change_password_request_t* req = (change_password_request_t*)msg->payload;
-    
-    // Dam bao null-terminated
-    char old_password[MAX_PASSWORD_LEN];
-    char new_password[MAX_PASSWORD_LEN];
-    strncpy(old_password, req->old_password, MAX_PASSWORD_LEN - 1);
-    old_password[MAX_PASSWORD_LEN - 1] = '\0';
-    strncpy(new_password, req->new_password, MAX_PASSWORD_LEN - 1);
-    new_password[MAX_PASSWORD_LEN - 1] = '\0';
+    const char* old_password = req.old_password;
+    const char* new_password = req.new_password;
 
     printf("Nhan CHANGE_PASSWORD_REQUEST tu client %d: user_id=%d\n", 
            client_index, client->user_id);
@@ -440,7 +433,7 @@ int protocol_handle_change_password(server_t* server, int client_index, const me
     }
 
     // Kiem tra database connection
-    if (!db) {
+    if (!storage_available()) {
         protocol_send_change_password_response(client->fd, STATUS_ERROR, 
                                              "Loi ket noi database");
         return -1;
@@ -463,7 +456,7 @@ int protocol_handle_change_password(server_t* server, int client_index, const me
     }
 
     // Doi mat khau
-    int result = db_change_password(db, client->user_id, old_password_hash, new_password_hash);
+    int result = storage_change_password(client->user_id, old_password_hash, new_password_hash);
     
     if (result == 0) {
         // Doi mat khau thanh cong
@@ -2,25 +2,15 @@
 #include "../include/server.h"
 #include "../include/room.h"
 #include "../include/game.h"
-#include "../include/database.h"
+#include "../include/storage.h"
+#include "../include/utils.h"
 #include "../common/protocol.h"
+#include "../common/codec.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <arpa/inet.h>
 
-extern db_connection_t* db;
-
-static void write_u64_be(uint8_t* p, uint64_t v) {
-    uint32_t hi = (uint32_t)(v >> 32);
-    uint32_t lo = (uint32_t)(v & 0xFFFFFFFFULL);
-    uint32_t hi_be = htonl(hi);
-    uint32_t lo_be = htonl(lo);
-    memcpy(p, &hi_be, 4);
-    memcpy(p + 4, &lo_be, 4);
-}
-
 static int room_player_db_id(room_t* room, int user_id) {
     if (!room) return 0;
     for (int i = 0; i < room->player_count; i++) {
@@ -66,32 +56,28 @@ int protocol_handle_chat_message(server_t* server, int client_index, const messa
         }
     }
 
-    // Build CHAT_BROADCAST payload: username(32) + message(256) + timestamp(8 ms)
-    uint8_t payload[MAX_USERNAME_LEN + MAX_MESSAGE_LEN + 8];
-    memset(payload, 0, sizeof(payload));
-    strncpy((char*)payload, client->username, MAX_USERNAME_LEN - 1);
-    ((char*)payload)[MAX_USERNAME_LEN - 1] = '\0';
-    strncpy((char*)(payload + MAX_USERNAME_LEN), text, MAX_MESSAGE_LEN - 1);
-    ((char*)(payload + MAX_USERNAME_LEN))[MAX_MESSAGE_LEN - 1] = '\0';
+    // Build CHAT_BROADCAST payload (schema chat_broadcast / chat_broadcast_v2 cho CAP_COMPACT_STRINGS)
+    msg_chat_broadcast_t chat = {.timestamp = utils_wall_ms()};
+    snprintf(chat.username, sizeof(chat.username), "%s", client->username);
+    snprintf(chat.message, sizeof(chat.message), "%.*s", (int)sizeof(chat.message) - 1, text);
+    msg_chat_broadcast_v2_t chat_v2;
+    memcpy(&chat_v2, &chat, sizeof(chat_v2));
 
-    uint64_t ts_ms = (uint64_t)time(NULL) * 1000ULL;
-    write_u64_be(payload + MAX_USERNAME_LEN + MAX_MESSAGE_LEN, ts_ms);
+    uint8_t payload[CODEC_CHAT_BROADCAST_MAX_SIZE];
+    uint8_t compact[CODEC_CHAT_BROADCAST_V2_MAX_SIZE];
+    size_t payload_len = msg_chat_broadcast_encode(&chat, payload, sizeof(payload));
+    size_t compact_len = msg_chat_broadcast_v2_encode(&chat_v2, compact, sizeof(compact));
 
     // Persist (best-effort): chat_messages uses room_id/player_id
-    if (db && room->db_room_id > 0) {
+    if (storage_available() && room->db_room_id > 0) {
         int pid = room_player_db_id(room, client->user_id);
         if (pid > 0) {
-            char room_buf[32], pid_buf[32];
-            snprintf(room_buf, sizeof(room_buf), "%d", room->db_room_id);
-            snprintf(pid_buf, sizeof(pid_buf), "%d", pid);
-            MYSQL_RES* r = db_execute_query(db, "INSERT INTO chat_messages (room_id, player_id, message_text) VALUES (?, ?, ?)",
-                room_buf, pid_buf, text
-            );
-            if (r) mysql_free_result(r);
+            storage_save_chat_message(room->db_room_id, pid, text);
         }
     }
 
-    return server_broadcast_to_room(server, room->room_id, MSG_CHAT_BROADCAST, payload, (uint16_t)sizeof(payload), -1);
+    return server_broadcast_to_room_by_cap(server, room->room_id, MSG_CHAT_BROADCAST, CAP_COMPACT_STRINGS,
+                                           compact, (uint16_t)compact_len, payload, (uint16_t)payload_len, -1);
 }
 
 
@@ -1,5 +1,6 @@
 #include "../include/protocol.h"
 #include "../common/protocol.h"
+#include "../include/metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,26 +8,82 @@
 #include <unistd.h>
 #include <errno.h>
 
+/**
+ * Doc header cua frame (thuong hoac mo rong)
+ * @return 1 neu doc duoc header, 0 neu chua du byte
+ */
+static int read_frame_header(const uint8_t* buffer, size_t buffer_len,
+                             uint32_t* payload_len_out, size_t* header_len_out) {
+    if (buffer_len < MSG_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint16_t length_network;
+    memcpy(&length_network, buffer + 1, 2);
+    uint16_t length = ntohs(length_network);
+
+    if (length != MSG_EXTENDED_LENGTH_MARKER) {
+        *payload_len_out = length;
+        *header_len_out = MSG_HEADER_SIZE;
+        return 1;
+    }
+
+    // Frame mo rong: do dai that nam trong 4 byte tiep theo
+    if (buffer_len < MSG_EXTENDED_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint32_t length32_network;
+    memcpy(&length32_network, buffer + 3, 4);
+    *payload_len_out = ntohl(length32_network);
+    *header_len_out = MSG_EXTENDED_HEADER_SIZE;
+    return 1;
+}
+
+/**
+ * Kiem tra buffer da co tron mot frame chua
+ */
+int protocol_peek_frame(const uint8_t* buffer, size_t buffer_len, size_t* frame_len_out) {
+    if (!buffer || !frame_len_out) {
+        return -1;
+    }
+
+    uint32_t payload_len = 0;
+    size_t header_len = 0;
+    if (!read_frame_header(buffer, buffer_len, &payload_len, &header_len)) {
+        return 0;
+    }
+
+    if (payload_len > MSG_MAX_PAYLOAD_SIZE) {
+        fprintf(stderr, "Loi: Payload length (%u) vuot qua gioi han\n", payload_len);
+        return -1;
+    }
+
+    *frame_len_out = header_len + payload_len;
+    return buffer_len >= *frame_len_out ? 1 : 0;
+}
+
 /**
  * Parse message tu buffer nhan duoc
  */
 int protocol_parse_message(const uint8_t* buffer, size_t buffer_len, message_t* msg_out) {
-    if (!buffer || !msg_out || buffer_len < 3) {
+    if (!buffer || !msg_out) {
         return -1;
     }
 
-    // Doc type (1 byte)
+    // Doc type (1 byte) va length (2 bytes, hoac 2 + 4 bytes voi frame mo rong)
+    uint32_t payload_len = 0;
+    size_t header_len = 0;
+    if (!read_frame_header(buffer, buffer_len, &payload_len, &header_len)) {
+        return -1;
+    }
     msg_out->type = buffer[0];
-
-    // Doc length (2 bytes, network byte order)
-    uint16_t length_network;
-    memcpy(&length_network, buffer + 1, 2);
-    msg_out->length = ntohs(length_network);
+    msg_out->length = payload_len;
 
     // Kiem tra do dai hop le
-    if (msg_out->length > buffer_len - 3) {
-        fprintf(stderr, "Loi: Payload length (%d) vuot qua buffer con lai (%zu)\n", 
-                msg_out->length, buffer_len - 3);
+    if (msg_out->length > buffer_len - header_len) {
+        fprintf(stderr, "Loi: Payload length (%u) vuot qua buffer con lai (%zu)\n", 
+                msg_out->length, buffer_len - header_len);
         return -1;
     }
 
@@ -37,7 +94,7 @@ int protocol_parse_message(const uint8_t* buffer, size_t buffer_len, message_t*
             fprintf(stderr, "Loi: Khong the cap phat bo nho cho payload\n");
             return -1;
         }
-        memcpy(msg_out->payload, buffer + 3, msg_out->length);
+        memcpy(msg_out->payload, buffer + header_len, msg_out->length);
     } else {
         msg_out->payload = NULL;
     }
@@ -68,32 +125,147 @@ int protocol_create_message(uint8_t type, const uint8_t* payload, uint16_t paylo
     return 3 + payload_len;
 }
 
+/**
+ * Gui toan bo buffer, send() co the chi gui duoc mot phan voi frame lon
+ */
+static int send_all(int client_fd, const uint8_t* data, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(client_fd, data + total, len - total, 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("send() failed");
+            return -1;
+        }
+        if (sent == 0) {
+            fprintf(stderr, "Canh bao: Chi gui duoc %zu/%zu bytes\n", total, len);
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+/**
+ * Ghi header frame (3 byte, hoac 7 byte voi frame mo rong)
+ */
+size_t protocol_write_header(uint8_t type, size_t payload_len, uint8_t* buffer_out) {
+    buffer_out[0] = type;
+    if (payload_len < MSG_EXTENDED_LENGTH_MARKER) {
+        uint16_t length_network = htons((uint16_t)payload_len);
+        memcpy(buffer_out + 1, &length_network, 2);
+        return MSG_HEADER_SIZE;
+    }
+
+    uint16_t marker = htons(MSG_EXTENDED_LENGTH_MARKER);
+    uint32_t length_network = htonl((uint32_t)payload_len);
+    memcpy(buffer_out + 1, &marker, 2);
+    memcpy(buffer_out + 3, &length_network, 4);
+    return MSG_EXTENDED_HEADER_SIZE;
+}
+
+/**
+ * Gui mot hoac nhieu frame da serialize san bang mot lan send_all
+ * Metrics van tinh theo tung frame
+ */
+int protocol_send_frame(int client_fd, const uint8_t* frame, size_t frame_len) {
+    if (!frame || frame_len < MSG_HEADER_SIZE) {
+        return -1;
+    }
+    if (send_all(client_fd, frame, frame_len) != 0) {
+        return -1;
+    }
+    size_t offset = 0;
+    uint32_t payload_len;
+    size_t header_len;
+    while (read_frame_header(frame + offset, frame_len - offset, &payload_len, &header_len) &&
+           offset + header_len + payload_len <= frame_len) {
+        metrics_record_sent(frame[offset], header_len + payload_len);
+        offset += header_len + payload_len;
+    }
+    return 0;
+}
+
 /**
  * Gui message den client
  */
 int protocol_send_message(int client_fd, uint8_t type, const uint8_t* payload, uint16_t payload_len) {
-    uint8_t buffer[BUFFER_SIZE];
-    
-    if (3 + payload_len > BUFFER_SIZE) {
-        fprintf(stderr, "Loi: Message qua lon (%d bytes)\n", 3 + payload_len);
+    return protocol_send_large_message(client_fd, type, payload, payload_len);
+}
+
+/**
+ * Gui message den client, nen neu da thoa thuan CAP_COMPRESSION va payload du lon
+ */
+int protocol_send_client_message(client_t* client, uint8_t type, const uint8_t* payload, size_t payload_len) {
+    if (!client) {
         return -1;
     }
 
-    int msg_len = protocol_create_message(type, payload, payload_len, buffer);
-    if (msg_len < 0) {
-        return -1;
+    if (!CLIENT_HAS_CAP(client, CAP_COMPRESSION) || payload_len < COMPRESS_MIN_PAYLOAD ||
+        !compress_type_eligible(type)) {
+        return protocol_send_large_message(client->fd, type, payload, payload_len);
     }
 
-    ssize_t sent = send(client_fd, buffer, msg_len, 0);
-    if (sent < 0) {
-        perror("send() failed");
-        return -1;
+    uint8_t stack_buffer[BUFFER_SIZE * 2];
+    size_t capacity = compress_bound(payload_len);
+    uint8_t* buffer = stack_buffer;
+    if (capacity > sizeof(stack_buffer)) {
+        buffer = (uint8_t*)malloc(capacity);
+        if (!buffer) {
+            return protocol_send_large_message(client->fd, type, payload, payload_len);
+        }
+    }
+
+    size_t compressed_len = compress_payload(&client->compress, type, payload, payload_len, buffer, capacity);
+    int result = compressed_len > 0
+        ? protocol_send_large_message(client->fd, MSG_COMPRESSED, buffer, compressed_len)
+        : protocol_send_large_message(client->fd, type, payload, payload_len);
+
+    if (buffer != stack_buffer) {
+        free(buffer);
     }
+    return result;
+}
 
-    if (sent != msg_len) {
-        fprintf(stderr, "Canh bao: Chi gui duoc %zd/%d bytes\n", sent, msg_len);
+/**
+ * Gui message voi payload tuy y
+ * Frame nho dung buffer tren stack nhu truoc, chi frame lon moi cap phat heap
+ */
+int protocol_send_large_message(int client_fd, uint8_t type, const uint8_t* payload, size_t payload_len) {
+    uint8_t stack_buffer[BUFFER_SIZE];
+
+    if (payload_len > MSG_MAX_PAYLOAD_SIZE) {
+        fprintf(stderr, "Loi: Message qua lon (%zu bytes)\n", payload_len);
         return -1;
     }
 
-    return 0;
+    size_t header_len = payload_len >= MSG_EXTENDED_LENGTH_MARKER ? MSG_EXTENDED_HEADER_SIZE : MSG_HEADER_SIZE;
+    size_t frame_len = header_len + payload_len;
+
+    uint8_t* buffer = stack_buffer;
+    if (frame_len > sizeof(stack_buffer)) {
+        buffer = (uint8_t*)malloc(frame_len);
+        if (!buffer) {
+            fprintf(stderr, "Loi: Khong the cap phat %zu bytes cho message lon\n", frame_len);
+            return -1;
+        }
+    }
+
+    protocol_write_header(type, payload_len, buffer);
+
+    if (payload && payload_len > 0) {
+        memcpy(buffer + header_len, payload, payload_len);
+    }
+
+    int result = send_all(client_fd, buffer, frame_len);
+    if (result == 0) {
+        metrics_record_sent(type, frame_len);
+    }
+
+    if (buffer != stack_buffer) {
+        free(buffer);
+    }
+    return result;
 }
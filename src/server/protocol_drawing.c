@@ -2,6 +2,9 @@
 #include "../include/room.h"
 #include "../include/server.h"
 #include "../include/game.h"
+#include "../include/canvas.h"
+#include "../include/stroke.h"
+#include "../include/protocol.h"
 #include "../common/protocol.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -59,6 +62,16 @@ int protocol_handle_draw_data(server_t* server, int client_index, const message_
            client_index, client->user_id, action.action, action.x1, action.y1, 
            action.x2, action.y2, action.color, action.width);
 
+    // Cap nhat canvas raster (neu phong bat) de phuc vu snapshot cho nguoi vao sau
+    if (room->canvas) {
+        canvas_apply_action(room->canvas, &action);
+    }
+
+    // Ghi vao log net ve cua round (bo qua khi log da day)
+    if (room->strokes) {
+        stroke_log_append(room->strokes, &action);
+    }
+
     // Serialize lai action de broadcast (payload da dung format)
     // Hoac co the dung lai payload goc neu da dung format
     uint8_t draw_payload[14];
@@ -84,6 +97,146 @@ int protocol_handle_draw_data(server_t* server, int client_index, const message_
     return 0;
 }
 
+/**
+ * Gui snapshot canvas cho client
+ * Payload: [room_id:4][total_len:4][offset:4][data]
+ * Client co CAP_EXTENDED_FRAMES nhan mot frame duy nhat (offset = 0),
+ * client cu nhan nhieu frame vua BUFFER_SIZE
+ */
+int protocol_send_canvas_snapshot(int client_fd, uint32_t caps, room_t* room) {
+    if (client_fd < 0 || !room) {
+        return -1;
+    }
+
+    if (!room->canvas) {
+        return 0;
+    }
+
+    const uint8_t* snapshot = NULL;
+    size_t snapshot_len = 0;
+    if (canvas_get_snapshot(room->canvas, &snapshot, &snapshot_len) != 0) {
+        fprintf(stderr, "Loi: Khong the tao snapshot canvas cho phong %d\n", room->room_id);
+        return -1;
+    }
+
+    const size_t header_len = sizeof(canvas_snapshot_chunk_t);
+    size_t chunk_max = snapshot_len;
+    if (!(caps & CAP_EXTENDED_FRAMES)) {
+        chunk_max = BUFFER_SIZE - MSG_HEADER_SIZE - header_len;
+    }
+
+    uint8_t* payload = (uint8_t*)malloc(header_len + (chunk_max < snapshot_len ? chunk_max : snapshot_len));
+    if (!payload) {
+        fprintf(stderr, "Loi: Khong the cap phat payload CANVAS_SNAPSHOT\n");
+        return -1;
+    }
+
+    uint32_t room_id_net = htonl((uint32_t)room->room_id);
+    uint32_t total_net = htonl((uint32_t)snapshot_len);
+    memcpy(payload, &room_id_net, 4);
+    memcpy(payload + 4, &total_net, 4);
+
+    int frames = 0;
+    size_t offset = 0;
+    while (offset < snapshot_len) {
+        size_t chunk_len = snapshot_len - offset;
+        if (chunk_len > chunk_max) {
+            chunk_len = chunk_max;
+        }
+
+        uint32_t offset_net = htonl((uint32_t)offset);
+        memcpy(payload + 8, &offset_net, 4);
+        memcpy(payload + header_len, snapshot + offset, chunk_len);
+
+        if (protocol_send_large_message(client_fd, MSG_CANVAS_SNAPSHOT, payload, header_len + chunk_len) != 0) {
+            fprintf(stderr, "Loi: Gui CANVAS_SNAPSHOT that bai o offset %zu\n", offset);
+            free(payload);
+            return -1;
+        }
+        offset += chunk_len;
+        frames++;
+    }
+    free(payload);
+
+    printf("Da gui CANVAS_SNAPSHOT phong %d: %zu bytes (%u net ve), %d frame\n",
+           room->room_id, snapshot_len, room->canvas->stroke_count, frames);
+    return 0;
+}
+
+// Frame DRAW_BROADCAST phat lai duoc gom vao buffer nay roi gui mot lan (vai chuc lan send
+// cho ca log day thay vi mot lan moi doan)
+#define STROKE_REPLAY_BATCH_SIZE (64 * 1024)
+#define STROKE_REPLAY_FRAME_SIZE (MSG_HEADER_SIZE + 14)
+
+// Ngu canh cho callback phat lai net ve
+typedef struct {
+    int client_fd;
+    int failed;
+    uint8_t* batch;
+    size_t batch_len;
+} stroke_replay_ctx_t;
+
+static int flush_replay_batch(stroke_replay_ctx_t* replay) {
+    if (replay->batch_len == 0) {
+        return 0;
+    }
+    int result = protocol_send_frame(replay->client_fd, replay->batch, replay->batch_len);
+    replay->batch_len = 0;
+    return result;
+}
+
+static int send_replay_segment(const draw_action_t* action, void* ctx) {
+    stroke_replay_ctx_t* replay = (stroke_replay_ctx_t*)ctx;
+    if (replay->batch_len + STROKE_REPLAY_FRAME_SIZE > STROKE_REPLAY_BATCH_SIZE &&
+        flush_replay_batch(replay) != 0) {
+        replay->failed = 1;
+        return 1;
+    }
+    uint8_t* frame = replay->batch + replay->batch_len;
+    protocol_write_header(MSG_DRAW_BROADCAST, 14, frame);
+    if (drawing_serialize_action(action, frame + MSG_HEADER_SIZE) != 14) {
+        replay->failed = 1;
+        return 1;
+    }
+    replay->batch_len += STROKE_REPLAY_FRAME_SIZE;
+    return 0;
+}
+
+/**
+ * Phat lai log net ve cho client vao giua round
+ * Net da dong duoc don gian hoa (RDP) nen so frame it hon nhieu so DRAW_DATA goc;
+ * log day (STROKE_LOG_MAX_POINTS) la khoang 3.4 MB frame, gui trong khoang 55 lan send
+ */
+int protocol_send_stroke_replay(int client_fd, room_t* room) {
+    if (client_fd < 0 || !room) {
+        return -1;
+    }
+
+    if (!room->strokes) {
+        return 0;
+    }
+
+    stroke_replay_ctx_t replay = { client_fd, 0, NULL, 0 };
+    replay.batch = (uint8_t*)malloc(STROKE_REPLAY_BATCH_SIZE);
+    if (!replay.batch) {
+        fprintf(stderr, "Loi: Khong the cap phat buffer phat lai net ve\n");
+        return -1;
+    }
+    int segments = stroke_log_replay(room->strokes, send_replay_segment, &replay);
+    if (!replay.failed && flush_replay_batch(&replay) != 0) {
+        replay.failed = 1;
+    }
+    free(replay.batch);
+    if (replay.failed) {
+        fprintf(stderr, "Loi: Phat lai net ve cho client fd=%d that bai\n", client_fd);
+        return -1;
+    }
+
+    printf("Da phat lai %d doan (%d net) cho client fd=%d trong phong %d\n",
+           segments, room->strokes->stroke_count, client_fd, room->room_id);
+    return segments;
+}
+
 /**
  * Gui DRAW_BROADCAST den client
  * (Ham nay duoc goi boi server_broadcast_to_room, khong can implement rieng)
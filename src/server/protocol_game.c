@@ -2,50 +2,22 @@
 #include "../include/game.h"
 #include "../include/room.h"
 #include "../include/server.h"
-#include "../include/database.h"
+#include "../include/storage.h"
+#include "../include/utils.h"
 #include "../common/protocol.h"
+#include "../common/codec.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <stdint.h>
 
-extern db_connection_t* db;
+// Payload formats: xem common/schema.h (game_start, correct_guess, round_end_header,
+// game_end_header, score_entry, timer_update, round_deadline). Client CAP_COMPACT_STRINGS nhan ban _v2
+// cua GAME_START, CORRECT_GUESS, ROUND_END voi chuoi [len:1][bytes].
 
-// Payload formats (binary protocol):
-// - GAME_START: drawer_id(4) + word_length(1) + time_limit(2) + round_start_ms(8) + current_round(4) + player_count(1) + total_rounds(1) + word(64) + category(64) = 149 bytes
-// - CORRECT_GUESS: player_id(4) + word(64) + guesser_points(2) + drawer_points(2) + username(32) = 104 bytes
-// - WRONG_GUESS: player_id(4) + guess(64) = 68 bytes (không còn dùng nữa)
-// - ROUND_END: word(64) + score_count(2) + pairs(user_id(4), score(4))...
-// - GAME_END: winner_id(4) + score_count(2) + pairs(user_id(4), score(4))...
-
-static void write_i32_be(uint8_t* p, int32_t v) {
-    uint32_t u = (uint32_t)v;
-    uint32_t be = htonl(u);
-    memcpy(p, &be, sizeof(be));
-}
-
-static void write_u16_be(uint8_t* p, uint16_t v) {
-    uint16_t be = htons(v);
-    memcpy(p, &be, sizeof(be));
-}
-
-static void write_u64_be(uint8_t* p, uint64_t v) {
-    // htonll portable
-    uint32_t hi = (uint32_t)(v >> 32);
-    uint32_t lo = (uint32_t)(v & 0xFFFFFFFFULL);
-    uint32_t hi_be = htonl(hi);
-    uint32_t lo_be = htonl(lo);
-    memcpy(p, &hi_be, 4);
-    memcpy(p + 4, &lo_be, 4);
-}
-
-static void write_fixed_string(uint8_t* p, size_t n, const char* s) {
-    memset(p, 0, n);
-    if (!s) return;
-    strncpy((char*)p, s, n - 1);
-    ((char*)p)[n - 1] = '\0';
-}
+// Client CAP_ROUND_DEADLINE tu dem nguoc, chi can resync thua de bu lech dong ho
+#define ROUND_DEADLINE_RESYNC_MS 15000
 
 static int find_client_index_by_user(server_t* server, int user_id) {
     if (!server || user_id <= 0) return -1;
@@ -77,47 +49,64 @@ static int room_player_db_id(room_t* room, int user_id) {
     return 0;
 }
 
+// Gui ROUND_DEADLINE cho mot client, tra ve 0 neu thanh cong
+int protocol_send_round_deadline(client_t* client, const game_state_t* game, uint64_t now_ms) {
+    msg_round_deadline_t deadline = {.deadline_ms = game->round_deadline_ms, .server_now_ms = now_ms};
+    uint8_t payload[CODEC_ROUND_DEADLINE_MAX_SIZE];
+    size_t len = msg_round_deadline_encode(&deadline, payload, sizeof(payload));
+    return protocol_send_message(client->fd, MSG_ROUND_DEADLINE, payload, (uint16_t)len);
+}
+
 static int broadcast_game_start(server_t* server, room_t* room) {
     if (!server || !room || !room->game) return -1;
 
     game_state_t* game = room->game;
-    // Payload: drawer_id(4) + word_length(1) + time_limit(2) + round_start_ms(8) 
-    //          + current_round(4) + player_count(1) + total_rounds(1) + word(64) + category(64) = 149 bytes
-    uint8_t payload[149];
-    memset(payload, 0, sizeof(payload));
-    write_i32_be(payload + 0, (int32_t)game->drawer_id);
-    payload[4] = (uint8_t)game->word_length;
-    write_u16_be(payload + 5, (uint16_t)game->time_limit);
-    // round_start_time is seconds in game_state -> convert to ms
-    uint64_t start_ms = (uint64_t)game->round_start_time * 1000ULL;
-    write_u64_be(payload + 7, start_ms);
-    // Thêm current_round, player_count và total_rounds để tính vòng hiện tại
-    write_i32_be(payload + 15, (int32_t)game->current_round);
-    payload[19] = (uint8_t)room->player_count;
-    payload[20] = (uint8_t)room->total_rounds; // Số vòng gốc (trước khi nhân với player_count)
+    uint64_t now_ms = utils_now_ms();
+    msg_game_start_t start = {
+        .drawer_id = game->drawer_id,
+        .word_length = (uint8_t)game->word_length,
+        .time_limit = (uint16_t)game->time_limit,
+        // Client cu tinh thoi gian theo Date.now(): doi moc monotonic sang epoch ms
+        .round_start_ms = utils_wall_ms() - (now_ms - game->round_start_ms),
+        // Thêm current_round, player_count và total_rounds để tính vòng hiện tại
+        .current_round = game->current_round,
+        .player_count = (uint8_t)room->player_count,
+        .total_rounds = (uint8_t)room->total_rounds, // Số vòng gốc (trước khi nhân với player_count)
+    };
+    // Category được gửi cho tất cả người chơi
+    snprintf(start.category, sizeof(start.category), "%s", game->current_category);
     printf("[PROTOCOL] GAME_START payload: current_round=%d, player_count=%d, total_rounds=%d\n",
            game->current_round, room->player_count, room->total_rounds);
 
     // Send to each client in room; drawer gets the word, others empty
-    // Tất cả đều nhận category
     int sent = 0;
     for (int i = 0; i < MAX_CLIENTS; i++) {
         client_t* c = &server->clients[i];
         if (!c->active || c->user_id <= 0) continue;
         if (!room_has_player(room, c->user_id)) continue;
 
-        if (c->user_id == game->drawer_id) {
-            write_fixed_string(payload + 21, 64, game->current_word);
+        snprintf(start.word, sizeof(start.word), "%s",
+                 c->user_id == game->drawer_id ? game->current_word : "");
+
+        uint8_t payload[CODEC_GAME_START_MAX_SIZE];
+        size_t len;
+        if (CLIENT_HAS_CAP(c, CAP_COMPACT_STRINGS)) {
+            // Cùng trường với bản cố định, chỉ khác cách mã hoá chuỗi
+            msg_game_start_v2_t start_v2;
+            memcpy(&start_v2, &start, sizeof(start_v2));
+            len = msg_game_start_v2_encode(&start_v2, payload, sizeof(payload));
         } else {
-            write_fixed_string(payload + 21, 64, "");
+            len = msg_game_start_encode(&start, payload, sizeof(payload));
         }
-        // Category được gửi cho tất cả người chơi
-        write_fixed_string(payload + 85, 64, game->current_category);
 
-        if (protocol_send_message(c->fd, MSG_GAME_START, payload, (uint16_t)sizeof(payload)) == 0) {
+        if (protocol_send_message(c->fd, MSG_GAME_START, payload, (uint16_t)len) == 0) {
             sent++;
         }
+        if (CLIENT_HAS_CAP(c, CAP_ROUND_DEADLINE)) {
+            protocol_send_round_deadline(c, game, now_ms);
+        }
     }
+    game->next_clock_sync_ms = now_ms + ROUND_DEADLINE_RESYNC_MS;
     return sent;
 }
 
@@ -127,23 +116,28 @@ static int broadcast_round_end(server_t* server, room_t* room, const char* word)
 
     // header + score pairs
     const uint16_t score_count = (uint16_t)game->score_count;
-    const size_t payload_size = 64 + 2 + (size_t)score_count * (sizeof(int32_t) + sizeof(int32_t));
-    if (payload_size > BUFFER_SIZE - 3) return -1;
+    msg_round_end_header_t header = {.score_count = score_count};
+    snprintf(header.word, sizeof(header.word), "%s", word ? word : "");
+    msg_round_end_header_v2_t header_v2;
+    memcpy(&header_v2, &header, sizeof(header_v2));
 
     uint8_t payload[BUFFER_SIZE];
-    memset(payload, 0, payload_size);
-    write_fixed_string(payload + 0, 64, word ? word : "");
-    write_u16_be(payload + 64, score_count);
+    uint8_t compact[BUFFER_SIZE];
+    wire_writer_t w, cw;
+    wire_writer_init(&w, payload, BUFFER_SIZE - 3);
+    wire_writer_init(&cw, compact, BUFFER_SIZE - 3);
+    msg_round_end_header_write(&header, &w);
+    msg_round_end_header_v2_write(&header_v2, &cw);
 
-    uint8_t* p = payload + 66;
     for (int i = 0; i < game->score_count; i++) {
-        write_i32_be(p, (int32_t)game->scores[i].user_id);
-        p += 4;
-        write_i32_be(p, (int32_t)game->scores[i].score);
-        p += 4;
+        msg_score_entry_t entry = {.user_id = game->scores[i].user_id, .score = game->scores[i].score};
+        msg_score_entry_write(&entry, &w);
+        msg_score_entry_write(&entry, &cw);
     }
+    if (w.overflow || cw.overflow) return -1;
 
-    return server_broadcast_to_room(server, room->room_id, MSG_ROUND_END, payload, (uint16_t)payload_size, -1);
+    return server_broadcast_to_room_by_cap(server, room->room_id, MSG_ROUND_END, CAP_COMPACT_STRINGS,
+                                           compact, (uint16_t)cw.len, payload, (uint16_t)w.len, -1);
 }
 
 int protocol_broadcast_game_end(server_t* server, room_t* room) {
@@ -161,7 +155,7 @@ int protocol_broadcast_game_end(server_t* server, room_t* room) {
     }
 
     // Lưu lịch sử chơi cho tất cả người chơi
-    if (db && game->score_count > 0) {
+    if (storage_available() && game->score_count > 0) {
         // Tạo mảng tạm để sắp xếp theo điểm giảm dần (để tính rank)
         typedef struct {
             int user_id;
@@ -188,30 +182,25 @@ int protocol_broadcast_game_end(server_t* server, room_t* room) {
         // Lưu lịch sử với rank
         for (int i = 0; i < game->score_count; i++) {
             int rank = i + 1; // rank từ 1, 2, 3, ...
-            db_save_game_history(db, sorted_scores[i].user_id, sorted_scores[i].score, rank);
+            storage_save_game_history(sorted_scores[i].user_id, sorted_scores[i].score, rank);
         }
         
         printf("[GAME_END] Saved game history for %d players\n", game->score_count);
     }
 
-    const uint16_t score_count = (uint16_t)game->score_count;
-    const size_t payload_size = 4 + 2 + (size_t)score_count * (sizeof(int32_t) + sizeof(int32_t));
-    if (payload_size > BUFFER_SIZE - 3) return -1;
+    msg_game_end_header_t header = {.winner_id = winner_id, .score_count = (uint16_t)game->score_count};
 
     uint8_t payload[BUFFER_SIZE];
-    memset(payload, 0, payload_size);
-    write_i32_be(payload + 0, (int32_t)winner_id);
-    write_u16_be(payload + 4, score_count);
-
-    uint8_t* p = payload + 6;
+    wire_writer_t w;
+    wire_writer_init(&w, payload, BUFFER_SIZE - 3);
+    msg_game_end_header_write(&header, &w);
     for (int i = 0; i < game->score_count; i++) {
-        write_i32_be(p, (int32_t)game->scores[i].user_id);
-        p += 4;
-        write_i32_be(p, (int32_t)game->scores[i].score);
-        p += 4;
+        msg_score_entry_t entry = {.user_id = game->scores[i].user_id, .score = game->scores[i].score};
+        msg_score_entry_write(&entry, &w);
     }
+    if (w.overflow) return -1;
 
-    return server_broadcast_to_room(server, room->room_id, MSG_GAME_END, payload, (uint16_t)payload_size, -1);
+    return server_broadcast_to_room(server, room->room_id, MSG_GAME_END, payload, (uint16_t)w.len, -1);
 }
 
 int protocol_handle_start_game(server_t* server, int client_index, const message_t* msg) {
@@ -248,16 +237,13 @@ int protocol_handle_start_game(server_t* server, int client_index, const message
     if (!game_start_round(room->game)) return -1;
 
     // Create db game_round for first round (best-effort)
-    if (db && room->db_room_id > 0) {
+    if (storage_available() && room->db_room_id > 0) {
         int drawer_pid = room_player_db_id(room, room->game->drawer_id);
         if (drawer_pid > 0) {
-            room->game->db_round_id = db_create_game_round(db, room->db_room_id, room->game->current_round, room->game->drawer_index, drawer_pid, room->game->current_word);
+            room->game->db_round_id = storage_create_game_round(room->db_room_id, room->game->current_round, room->game->drawer_index, drawer_pid, room->game->current_word);
         }
         // mark room in progress
-        char rid_buf[32];
-        snprintf(rid_buf, sizeof(rid_buf), "%d", room->db_room_id);
-        MYSQL_RES* r = db_execute_query(db, "UPDATE rooms SET status='in_progress' WHERE id = ?", rid_buf);
-        if (r) mysql_free_result(r);
+        storage_set_room_status(room->db_room_id, "in_progress");
     }
 
     broadcast_game_start(server, room);
@@ -321,10 +307,10 @@ int protocol_process_guess(server_t* server, int client_index, room_t* room, con
     }
 
     // Persist guess (best-effort)
-    if (db && room->game && room->game->db_round_id > 0 && room->db_room_id > 0) {
+    if (storage_available() && room->game && room->game->db_round_id > 0 && room->db_room_id > 0) {
         int pid = room_player_db_id(room, client->user_id);
         if (pid > 0) {
-            db_save_guess(db, room->game->db_round_id, pid, guess, correct ? 1 : 0);
+            storage_save_guess(room->game->db_round_id, pid, guess, correct ? 1 : 0);
         }
     }
 
@@ -369,30 +355,37 @@ int protocol_process_guess(server_t* server, int client_index, room_t* room, con
         return -1;
     }
 
-    // correct guess broadcast: player_id(4) + word(64) + guesser_points(2) + drawer_points(2) + username(32) = 104 bytes
-    uint8_t cp[104];
-    memset(cp, 0, sizeof(cp));
-    write_i32_be(cp + 0, (int32_t)client->user_id);
-    write_fixed_string(cp + 4, 64, current_word);
-    write_u16_be(cp + 68, (uint16_t)guesser_points);
-    write_u16_be(cp + 70, (uint16_t)drawer_points);
-    write_fixed_string(cp + 72, 32, client->username);
+    msg_correct_guess_t broadcast = {
+        .player_id = client->user_id,
+        .guesser_points = (uint16_t)guesser_points,
+        .drawer_points = (uint16_t)drawer_points,
+    };
+    snprintf(broadcast.word, sizeof(broadcast.word), "%s", current_word);
+    snprintf(broadcast.username, sizeof(broadcast.username), "%s", client->username);
+    msg_correct_guess_v2_t broadcast_v2;
+    memcpy(&broadcast_v2, &broadcast, sizeof(broadcast_v2));
     printf("[PROTOCOL] Broadcasting CORRECT_GUESS: user_id=%d, username=%s, guesser_points=%d, drawer_points=%d\n",
            client->user_id, client->username, guesser_points, drawer_points);
-    server_broadcast_to_room(server, room->room_id, MSG_CORRECT_GUESS, cp, (uint16_t)sizeof(cp), -1);
+
+    uint8_t cp[CODEC_CORRECT_GUESS_MAX_SIZE];
+    uint8_t compact[CODEC_CORRECT_GUESS_V2_MAX_SIZE];
+    size_t cp_len = msg_correct_guess_encode(&broadcast, cp, sizeof(cp));
+    size_t compact_len = msg_correct_guess_v2_encode(&broadcast_v2, compact, sizeof(compact));
+    server_broadcast_to_room_by_cap(server, room->room_id, MSG_CORRECT_GUESS, CAP_COMPACT_STRINGS,
+                                    compact, (uint16_t)compact_len, cp, (uint16_t)cp_len, -1);
 
     // Persist score details (best-effort)
-    if (db && room->game && room->game->db_round_id > 0 && room->db_room_id > 0) {
+    if (storage_available() && room->game && room->game->db_round_id > 0 && room->db_room_id > 0) {
         int guesser_pid = room_player_db_id(room, client->user_id);
         int drawer_pid = 0;
         if (room->game && room->game->drawer_id > 0) {
             drawer_pid = room_player_db_id(room, room->game->drawer_id);
         }
         if (guesser_pid > 0) {
-            db_save_score_detail(db, room->game->db_round_id, guesser_pid, guesser_points);
+            storage_save_score_detail(room->game->db_round_id, guesser_pid, guesser_points);
         }
         if (drawer_pid > 0) {
-            db_save_score_detail(db, room->game->db_round_id, drawer_pid, drawer_points);
+            storage_save_score_detail(room->game->db_round_id, drawer_pid, drawer_points);
         }
     }
 
@@ -507,29 +500,44 @@ int protocol_handle_round_timeout(server_t* server, room_t* room, const char* wo
 }
 
 /**
- * Broadcast TIMER_UPDATE đến tất cả clients trong phòng
- * Payload: time_left(2 bytes) - thời gian còn lại tính bằng giây
+ * Đồng bộ đồng hồ round cho các client trong phòng (gọi mỗi giây)
+ * Client cũ nhận TIMER_UPDATE: time_left(2 bytes) - thời gian còn lại tính bằng giây.
+ * Client CAP_ROUND_DEADLINE chỉ nhận ROUND_DEADLINE mỗi ROUND_DEADLINE_RESYNC_MS.
  */
-int protocol_broadcast_timer_update(server_t* server, room_t* room) {
+int protocol_broadcast_timer_update(server_t* server, room_t* room, uint64_t now_ms) {
     if (!server || !room || !room->game) return -1;
-    
+
     game_state_t* game = room->game;
-    if (game->game_ended || game->round_start_time == 0) return -1;
-    
-    // Tính thời gian còn lại
-    time_t now = time(NULL);
-    int elapsed = (int)(now - game->round_start_time);
-    int time_left = game->time_limit - elapsed;
-    
-    // Đảm bảo time_left không âm
-    if (time_left < 0) time_left = 0;
-    
-    // Payload: time_left(2 bytes)
-    uint8_t payload[2];
-    write_u16_be(payload, (uint16_t)time_left);
-    
-    // Broadcast đến tất cả clients trong phòng
-    return server_broadcast_to_room(server, room->room_id, MSG_TIMER_UPDATE, payload, 2, -1);
+    if (game->game_ended || game->round_start_ms == 0) return -1;
+
+    // Làm tròn lên: còn 0.4s vẫn hiển thị 1s, về 0 đúng lúc hết giờ
+    uint64_t left_ms = game->round_deadline_ms > now_ms ? game->round_deadline_ms - now_ms : 0;
+    msg_timer_update_t timer = {.time_left = (uint16_t)((left_ms + 999) / 1000)};
+    uint8_t payload[CODEC_TIMER_UPDATE_MAX_SIZE];
+    size_t len = msg_timer_update_encode(&timer, payload, sizeof(payload));
+
+    int resync = now_ms >= game->next_clock_sync_ms;
+    if (resync) {
+        game->next_clock_sync_ms = now_ms + ROUND_DEADLINE_RESYNC_MS;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        client_t* c = &server->clients[i];
+        if (!c->active || c->user_id <= 0 || !room_has_player(room, c->user_id)) continue;
+
+        int result = 0;
+        if (CLIENT_HAS_CAP(c, CAP_ROUND_DEADLINE)) {
+            if (!resync) continue;
+            result = protocol_send_round_deadline(c, game, now_ms);
+        } else {
+            result = protocol_send_message(c->fd, MSG_TIMER_UPDATE, payload, (uint16_t)len);
+        }
+        if (result == 0) {
+            sent++;
+        }
+    }
+    return sent;
 }
 
 
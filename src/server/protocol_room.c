@@ -2,7 +2,13 @@
 #include "../include/room.h"
 #include "../include/game.h"
 #include "../include/server.h"
+#include "../include/canvas.h"
+#include "../include/stroke.h"
+#include "../include/metrics.h"
+#include "../include/capture.h"
+#include "../include/utils.h"
 #include "../common/protocol.h"
+#include "../common/codec.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,65 +18,207 @@
 int protocol_broadcast_game_end(server_t* server, room_t* room);
 
 /**
- * Gui CREATE_ROOM_RESPONSE
+ * Gui CREATE_ROOM / JOIN_ROOM response
+ * Client CAP_COMPACT_STRINGS nhan message dang [len:1][bytes] (room_response_v2)
  */
-int protocol_send_create_room_response(int client_fd, uint8_t status, int32_t room_id, const char *message)
+static int send_room_response(int client_fd, uint32_t caps, uint8_t type, uint8_t status,
+                              int32_t room_id, const char *message)
 {
-    create_room_response_t response;
-    memset(&response, 0, sizeof(response));
-
-    response.status = status;
-    response.room_id = (int32_t)htonl((uint32_t)room_id); // Convert to network byte order
+    uint8_t payload[(size_t)CODEC_ROOM_RESPONSE_V2_MAX_SIZE > (size_t)CODEC_ROOM_RESPONSE_MAX_SIZE
+                        ? CODEC_ROOM_RESPONSE_V2_MAX_SIZE
+                        : CODEC_ROOM_RESPONSE_MAX_SIZE];
+    size_t len;
 
-    if (message)
+    if (caps & CAP_COMPACT_STRINGS)
+    {
+        msg_room_response_v2_t response = {.status = status, .room_id = room_id};
+        snprintf(response.message, sizeof(response.message), "%s", message ? message : "");
+        len = msg_room_response_v2_encode(&response, payload, sizeof(payload));
+    }
+    else
     {
-        strncpy(response.message, message, sizeof(response.message) - 1);
-        response.message[sizeof(response.message) - 1] = '\0';
+        msg_room_response_t response = {.status = status, .room_id = room_id};
+        snprintf(response.message, sizeof(response.message), "%s", message ? message : "");
+        len = msg_room_response_encode(&response, payload, sizeof(payload));
     }
 
-    return protocol_send_message(client_fd, MSG_CREATE_ROOM,
-                                 (uint8_t *)&response, sizeof(response));
+    return protocol_send_message(client_fd, type, payload, (uint16_t)len);
+}
+
+/**
+ * Gui CREATE_ROOM_RESPONSE
+ */
+int protocol_send_create_room_response(int client_fd, uint32_t caps, uint8_t status, int32_t room_id, const char *message)
+{
+    return send_room_response(client_fd, caps, MSG_CREATE_ROOM, status, room_id, message);
 }
 
 /**
  * Gui JOIN_ROOM_RESPONSE
  */
-int protocol_send_join_room_response(int client_fd, uint8_t status, int32_t room_id, const char *message)
+int protocol_send_join_room_response(int client_fd, uint32_t caps, uint8_t status, int32_t room_id, const char *message)
 {
-    join_room_response_t response;
-    memset(&response, 0, sizeof(response));
+    return send_room_response(client_fd, caps, MSG_JOIN_ROOM, status, room_id, message);
+}
 
-    response.status = status;
-    response.room_id = (int32_t)htonl((uint32_t)room_id); // Convert to network byte order
+/**
+ * Gui LEAVE_ROOM_RESPONSE
+ */
+int protocol_send_leave_room_response(int client_fd, uint32_t caps, uint8_t status, const char *message)
+{
+    uint8_t payload[(size_t)CODEC_STATUS_RESPONSE_V2_MAX_SIZE > (size_t)CODEC_STATUS_RESPONSE_MAX_SIZE
+                        ? CODEC_STATUS_RESPONSE_V2_MAX_SIZE
+                        : CODEC_STATUS_RESPONSE_MAX_SIZE];
+    size_t len;
 
-    if (message)
+    if (caps & CAP_COMPACT_STRINGS)
     {
-        strncpy(response.message, message, sizeof(response.message) - 1);
-        response.message[sizeof(response.message) - 1] = '\0';
+        msg_status_response_v2_t response = {.status = status};
+        snprintf(response.message, sizeof(response.message), "%s", message ? message : "");
+        len = msg_status_response_v2_encode(&response, payload, sizeof(payload));
+    }
+    else
+    {
+        msg_status_response_t response = {.status = status};
+        snprintf(response.message, sizeof(response.message), "%s", message ? message : "");
+        len = msg_status_response_encode(&response, payload, sizeof(payload));
     }
 
-    return protocol_send_message(client_fd, MSG_JOIN_ROOM,
-                                 (uint8_t *)&response, sizeof(response));
+    return protocol_send_message(client_fd, MSG_LEAVE_ROOM, payload, (uint16_t)len);
 }
 
 /**
- * Gui LEAVE_ROOM_RESPONSE
+ * Ghi thong tin phong theo schema room_info
+ */
+static void write_room_info(const room_info_t *info, wire_writer_t *w)
+{
+    msg_room_info_t proto = {
+        .room_id = info->room_id,
+        .player_count = (uint8_t)info->player_count,
+        .max_players = (uint8_t)info->max_players,
+        .state = (uint8_t)info->state,
+        .owner_id = info->owner_id,
+    };
+    snprintf(proto.room_name, sizeof(proto.room_name), "%s", info->room_name);
+    snprintf(proto.owner_username, sizeof(proto.owner_username), "%s",
+             info->owner_username[0] ? info->owner_username : "Unknown");
+    msg_room_info_write(&proto, w);
+}
+
+/**
+ * Lay frame ROOM_LIST_RESPONSE da cache, dung lai neu danh sach phong hoac seq thay doi
+ * Username chu phong lay tu room->owner_username nen khong can duyet clients
  */
-int protocol_send_leave_room_response(int client_fd, uint8_t status, const char *message)
+static const uint8_t *room_list_frame(server_t *server, size_t *frame_len_out)
 {
-    leave_room_response_t response;
-    memset(&response, 0, sizeof(response));
+    room_list_cache_t *cache = &server->room_list_cache;
+    unsigned long generation = room_list_generation();
+    uint32_t seq = server->room_list_pub.seq;
+
+    if (cache->frame && cache->generation == generation && cache->seq == seq)
+    {
+        *frame_len_out = cache->frame_len;
+        return cache->frame;
+    }
 
-    response.status = status;
+    // Lay danh sach phong
+    room_info_t room_list[MAX_ROOMS];
+    int room_count = room_get_list(server, room_list, MAX_ROOMS);
+
+    size_t payload_size = sizeof(room_list_response_t) +
+                          (size_t)room_count * CODEC_ROOM_INFO_MAX_SIZE + sizeof(uint32_t);
+    size_t frame_len = MSG_EXTENDED_HEADER_SIZE + payload_size;
 
-    if (message)
+    if (frame_len > cache->capacity)
     {
-        strncpy(response.message, message, sizeof(response.message) - 1);
-        response.message[sizeof(response.message) - 1] = '\0';
+        uint8_t *frame = (uint8_t *)realloc(cache->frame, frame_len);
+        if (!frame)
+        {
+            fprintf(stderr, "Loi: Khong the cap phat frame room list (%zu bytes)\n", frame_len);
+            return NULL;
+        }
+        cache->frame = frame;
+        cache->capacity = frame_len;
     }
 
-    return protocol_send_message(client_fd, MSG_LEAVE_ROOM,
-                                 (uint8_t *)&response, sizeof(response));
+    size_t header_len = protocol_write_header(MSG_ROOM_LIST_RESPONSE, payload_size, cache->frame);
+    uint8_t *payload = cache->frame + header_len;
+
+    wire_writer_t w;
+    wire_writer_init(&w, payload, payload_size);
+    wire_put_u16(&w, (uint16_t)room_count);
+    for (int i = 0; i < room_count; i++)
+    {
+        write_room_info(&room_list[i], &w);
+    }
+    // Seq o cuoi payload (client cu bo qua)
+    wire_put_u32(&w, seq);
+
+    cache->frame_len = header_len + payload_size;
+    cache->zbuilt = 0; // Ban nen cu khong con dung
+    cache->generation = generation;
+    cache->seq = seq;
+    cache->room_count = room_count;
+
+    *frame_len_out = cache->frame_len;
+    return cache->frame;
+}
+
+/**
+ * Lay frame danh sach phong cho client
+ * Client CAP_COMPRESSION nhan ban MSG_COMPRESSED, nen mot lan moi the he danh sach va dung chung cho ca sanh
+ */
+static const uint8_t *room_list_frame_for(server_t *server, client_t *client, size_t *frame_len_out)
+{
+    size_t frame_len = 0;
+    const uint8_t *frame = room_list_frame(server, &frame_len);
+    *frame_len_out = frame_len;
+    if (!frame || !client || !CLIENT_HAS_CAP(client, CAP_COMPRESSION))
+    {
+        return frame;
+    }
+
+    room_list_cache_t *cache = &server->room_list_cache;
+    if (!cache->zbuilt)
+    {
+        cache->zbuilt = 1;
+        cache->zframe_len = 0;
+
+        size_t header_len = (frame[1] == 0xFF && frame[2] == 0xFF) ? MSG_EXTENDED_HEADER_SIZE : MSG_HEADER_SIZE;
+        size_t payload_len = frame_len - header_len;
+        size_t needed = MSG_EXTENDED_HEADER_SIZE + compress_bound(payload_len);
+        if (payload_len >= COMPRESS_MIN_PAYLOAD && needed > cache->zcapacity)
+        {
+            uint8_t *zframe = (uint8_t *)realloc(cache->zframe, needed);
+            if (zframe)
+            {
+                cache->zframe = zframe;
+                cache->zcapacity = needed;
+            }
+        }
+
+        if (payload_len >= COMPRESS_MIN_PAYLOAD && cache->zcapacity >= needed)
+        {
+            // Nen vao sau cho header lon nhat roi doi len neu header thuc te ngan hon
+            size_t zlen = compress_payload(&client->compress, MSG_ROOM_LIST_RESPONSE, frame + header_len, payload_len,
+                                           cache->zframe + MSG_EXTENDED_HEADER_SIZE,
+                                           cache->zcapacity - MSG_EXTENDED_HEADER_SIZE);
+            if (zlen > 0)
+            {
+                size_t zheader_len = zlen >= MSG_EXTENDED_LENGTH_MARKER ? MSG_EXTENDED_HEADER_SIZE : MSG_HEADER_SIZE;
+                memmove(cache->zframe + zheader_len, cache->zframe + MSG_EXTENDED_HEADER_SIZE, zlen);
+                protocol_write_header(MSG_COMPRESSED, zlen, cache->zframe);
+                cache->zframe_len = zheader_len + zlen;
+            }
+        }
+    }
+
+    if (cache->zframe_len > 0)
+    {
+        *frame_len_out = cache->zframe_len;
+        return cache->zframe;
+    }
+    return frame;
 }
 
 /**
@@ -83,58 +231,78 @@ int protocol_send_room_list(int client_fd, server_t *server)
         return -1;
     }
 
-    // Lay danh sach phong
-    room_info_t room_list[50]; // MAX_ROOMS
-    int room_count = room_get_list(server, room_list, 50);
+    client_t *client = NULL;
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        if (server->clients[i].active && server->clients[i].fd == client_fd)
+        {
+            client = &server->clients[i];
+            break;
+        }
+    }
 
-    // Tinh kich thuoc payload
-    uint16_t payload_size = sizeof(room_list_response_t) +
-                            room_count * sizeof(room_info_protocol_t);
+    size_t frame_len = 0;
+    const uint8_t *frame = room_list_frame_for(server, client, &frame_len);
+    if (!frame)
+    {
+        return -1;
+    }
 
-    if (payload_size > BUFFER_SIZE - 3)
+    if (protocol_send_frame(client_fd, frame, frame_len) != 0)
     {
-        fprintf(stderr, "Loi: Room list qua lon (%d bytes)\n", payload_size);
         return -1;
     }
 
-    // Tao payload
-    uint8_t payload[BUFFER_SIZE];
-    room_list_response_t *header = (room_list_response_t *)payload;
-    header->room_count = htons((uint16_t)room_count);
+    // Client nhan ban day du se ap dung duoc delta tiep theo
+    if (client)
+    {
+        client->room_list_seq = server->room_list_pub.seq;
+    }
+    return 0;
+}
+
+/**
+ * So sanh danh sach phong hien tai voi lan cong bo truoc va ghi cac ban ghi delta
+ * @return So ban ghi da ghi vao buffer
+ */
+static int build_room_list_delta(server_t *server, wire_writer_t *w)
+{
+    room_list_published_t *pub = &server->room_list_pub;
+    int count = 0;
 
-    // Chuyen doi room_info_t sang room_info_protocol_t
-    room_info_protocol_t *room_info_proto = (room_info_protocol_t *)(payload + sizeof(room_list_response_t));
-    for (int i = 0; i < room_count; i++)
+    for (int i = 0; i < MAX_ROOMS; i++)
     {
-        room_info_proto[i].room_id = htonl((uint32_t)room_list[i].room_id);
-        strncpy(room_info_proto[i].room_name, room_list[i].room_name, MAX_ROOM_NAME_LEN - 1);
-        room_info_proto[i].room_name[MAX_ROOM_NAME_LEN - 1] = '\0';
-        room_info_proto[i].player_count = room_list[i].player_count;
-        room_info_proto[i].max_players = room_list[i].max_players;
-        room_info_proto[i].state = (uint8_t)room_list[i].state;
-        room_info_proto[i].owner_id = htonl((uint32_t)room_list[i].owner_id);
-        
-        // Tim username cua chu phong tu server->clients
-        strncpy(room_info_proto[i].owner_username, "Unknown", MAX_USERNAME_LEN - 1);
-        for (int j = 0; j < MAX_CLIENTS; j++)
+        room_t *room = server->rooms[i];
+        int room_id = room ? room->room_id : 0;
+
+        // Phong cu o slot nay da bi xoa (hoac slot duoc dung cho phong khac)
+        if (pub->room_ids[i] != 0 && pub->room_ids[i] != room_id)
         {
-            if (server->clients[j].active &&
-                server->clients[j].user_id == room_list[i].owner_id)
-            {
-                strncpy(room_info_proto[i].owner_username, server->clients[j].username, MAX_USERNAME_LEN - 1);
-                room_info_proto[i].owner_username[MAX_USERNAME_LEN - 1] = '\0';
-                break;
-            }
+            wire_put_u8(w, ROOM_DELTA_REMOVE);
+            wire_put_i32(w, pub->room_ids[i]);
+            count++;
+            pub->room_ids[i] = 0;
+        }
+
+        if (room && (pub->room_ids[i] != room_id || pub->versions[i] != room->version))
+        {
+            room_info_t info;
+            room_get_info(room, &info);
+            wire_put_u8(w, ROOM_DELTA_UPSERT);
+            write_room_info(&info, w);
+            count++;
+            pub->room_ids[i] = room_id;
+            pub->versions[i] = room->version;
         }
     }
 
-    return protocol_send_message(client_fd, MSG_ROOM_LIST_RESPONSE,
-                                 payload, payload_size);
+    return count;
 }
 
 /**
- * Broadcast ROOM_LIST_RESPONSE den tat ca clients da dang nhap
- * Goi khi co phong moi duoc tao hoac phong bi xoa
+ * Broadcast thay doi danh sach phong den cac clients dang xem sanh
+ * Client dang co seq lien truoc nhan ROOM_LIST_DELTA, client chua co/lech seq nhan ban day du.
+ * Khong gui gi neu danh sach khong doi tu lan cong bo truoc.
  */
 int protocol_broadcast_room_list(server_t *server)
 {
@@ -143,167 +311,230 @@ int protocol_broadcast_room_list(server_t *server)
         return -1;
     }
 
-    // Lay danh sach phong
-    room_info_t room_list[50]; // MAX_ROOMS
-    int room_count = room_get_list(server, room_list, 50);
-
-    // Tinh kich thuoc payload
-    uint16_t payload_size = sizeof(room_list_response_t) +
-                            room_count * sizeof(room_info_protocol_t);
-
-    if (payload_size > BUFFER_SIZE - 3)
+    room_list_published_t *pub = &server->room_list_pub;
+    unsigned long generation = room_list_generation();
+    if (pub->generation == generation)
     {
-        fprintf(stderr, "Loi: Room list qua lon (%d bytes)\n", payload_size);
-        return -1;
+        return 0;
+    }
+    pub->generation = generation;
+
+    // Moi slot toi da mot REMOVE va mot UPSERT
+    uint8_t payload[sizeof(room_list_delta_header_t) +
+                    MAX_ROOMS * (2 + sizeof(int32_t) + CODEC_ROOM_INFO_MAX_SIZE)];
+    wire_writer_t w;
+    wire_writer_init(&w, payload, sizeof(payload));
+    w.len = sizeof(room_list_delta_header_t); // Header ghi sau khi biet so ban ghi
+    int record_count = build_room_list_delta(server, &w);
+    if (record_count == 0)
+    {
+        return 0;
     }
 
-    // Tao payload
-    uint8_t payload[BUFFER_SIZE];
-    room_list_response_t *header = (room_list_response_t *)payload;
-    header->room_count = htons((uint16_t)room_count);
+    uint32_t base_seq = pub->seq;
+    pub->seq++;
 
-    // Chuyen doi room_info_t sang room_info_protocol_t
-    room_info_protocol_t *room_info_proto = (room_info_protocol_t *)(payload + sizeof(room_list_response_t));
-    for (int i = 0; i < room_count; i++)
+    room_list_delta_header_t *header = (room_list_delta_header_t *)payload;
+    header->seq = htonl(pub->seq);
+    header->count = htons((uint16_t)record_count);
+    size_t payload_len = w.len;
+
+    int delta_count = 0;
+    int full_count = 0;
+
+    // Chi gui cho clients dang xem sanh
+    for (int n = 0; n < server->lobby_subscriber_count; n++)
     {
-        room_info_proto[i].room_id = htonl((uint32_t)room_list[i].room_id);
-        strncpy(room_info_proto[i].room_name, room_list[i].room_name, MAX_ROOM_NAME_LEN - 1);
-        room_info_proto[i].room_name[MAX_ROOM_NAME_LEN - 1] = '\0';
-        room_info_proto[i].player_count = room_list[i].player_count;
-        room_info_proto[i].max_players = room_list[i].max_players;
-        room_info_proto[i].state = (uint8_t)room_list[i].state;
-        room_info_proto[i].owner_id = htonl((uint32_t)room_list[i].owner_id);
-        
-        // Tim username cua chu phong tu server->clients
-        strncpy(room_info_proto[i].owner_username, "Unknown", MAX_USERNAME_LEN - 1);
-        for (int j = 0; j < MAX_CLIENTS; j++)
+        client_t *client = &server->clients[server->lobby_subscribers[n]];
+        if (!client->active || client->user_id <= 0)
         {
-            if (server->clients[j].active &&
-                server->clients[j].user_id == room_list[i].owner_id)
-            {
-                strncpy(room_info_proto[i].owner_username, server->clients[j].username, MAX_USERNAME_LEN - 1);
-                room_info_proto[i].owner_username[MAX_USERNAME_LEN - 1] = '\0';
-                break;
-            }
+            continue;
         }
-    }
-
-    // Gui den tat ca clients da dang nhap (LOGGED_IN tro len)
-    int sent_count = 0;
-    for (int i = 0; i < MAX_CLIENTS; i++)
-    {
-        client_t *client = &server->clients[i];
 
-        // Chi gui cho clients da dang nhap (khong gui cho clients trong phong)
-        if (client->active &&
-            client->state >= CLIENT_STATE_LOGGED_IN &&
-            client->user_id > 0)
+        if (CLIENT_HAS_CAP(client, CAP_ROOM_LIST_DELTA) && client->room_list_seq == base_seq)
         {
-            if (protocol_send_message(client->fd, MSG_ROOM_LIST_RESPONSE,
-                                      payload, payload_size) == 0)
+            if (protocol_send_client_message(client, MSG_ROOM_LIST_DELTA, payload, payload_len) == 0)
             {
-                sent_count++;
+                client->room_list_seq = pub->seq;
+                delta_count++;
             }
+            continue;
+        }
+
+        // Client cu, seq cu hoac chua co danh sach: gui lai ban day du (frame cache, khong dung lai moi client)
+        size_t frame_len = 0;
+        const uint8_t *frame = room_list_frame_for(server, client, &frame_len);
+        if (!frame)
+        {
+            continue;
+        }
+        if (protocol_send_frame(client->fd, frame, frame_len) == 0)
+        {
+            client->room_list_seq = pub->seq;
+            full_count++;
         }
     }
 
-    printf("Da broadcast ROOM_LIST_RESPONSE den %d clients (tong %d phong)\n",
-           sent_count, room_count);
+    metrics_record_broadcast(delta_count + full_count);
+    printf("Da broadcast ROOM_LIST_DELTA seq=%u (%d thay doi) den %d clients, %d clients nhan ban day du\n",
+           pub->seq, record_count, delta_count, full_count);
 
-    return sent_count;
+    return delta_count + full_count;
 }
 
 /**
- * Broadcast ROOM_PLAYERS_UPDATE den tat ca clients trong phong
- * Gui danh sach day du nguoi choi khi co thay doi
+ * Trang thai active cua nguoi choi theo dang protocol
  */
-int protocol_broadcast_room_players_update(server_t *server, room_t *room,
-                                           uint8_t action, int changed_user_id,
-                                           const char *changed_username,
-                                           int exclude_client_index)
+static uint8_t player_active_protocol(int active)
 {
-    if (!server || !room)
+    if (active == -1)
     {
-        return -1;
+        return 255; // 0xFF = da roi phong
     }
+    return active == 1 ? 1 : 0; // 0 = dang cho (join giua chung)
+}
 
-    // Tinh kich thuoc payload
-    uint16_t payload_size = sizeof(room_players_update_t) +
-                            room->player_count * sizeof(player_info_protocol_t);
-
-    if (payload_size > BUFFER_SIZE - 3)
+/**
+ * Tim avatar cua user tu server->clients
+ */
+static const char *find_player_avatar(server_t *server, int user_id)
+{
+    for (int j = 0; j < MAX_CLIENTS; j++)
     {
-        fprintf(stderr, "Loi: Room players update qua lon (%d bytes)\n", payload_size);
-        return -1;
+        if (server->clients[j].active && server->clients[j].user_id == user_id)
+        {
+            return server->clients[j].avatar;
+        }
     }
+    return "avt1.jpg"; // Default avatar
+}
 
-    // Tao payload
-    uint8_t payload[BUFFER_SIZE];
-    room_players_update_t *update = (room_players_update_t *)payload;
-
-    // Thong tin phong day du
-    update->room_id = htonl((uint32_t)room->room_id);
-    strncpy(update->room_name, room->room_name, MAX_ROOM_NAME_LEN - 1);
-    update->room_name[MAX_ROOM_NAME_LEN - 1] = '\0';
-    update->max_players = (uint8_t)room->max_players;
-    update->state = (uint8_t)room->state;
-    update->owner_id = htonl((uint32_t)room->owner_id);
-
-    // Thong tin thay doi nguoi choi
-    update->action = action; // 0 = JOIN, 1 = LEAVE
-    update->changed_user_id = htonl((uint32_t)changed_user_id);
-    if (changed_username) {
-        strncpy(update->changed_username, changed_username, MAX_USERNAME_LEN - 1);
-        update->changed_username[MAX_USERNAME_LEN - 1] = '\0';
-    } else {
-        // Nếu changed_username là NULL, set thành chuỗi rỗng
-        update->changed_username[0] = '\0';
+/**
+ * Tao payload ROOM_PLAYERS_UPDATE voi danh sach day du
+ * @param compact 1 = chuoi gon (room_players_header_v2 + player_info_v2, CAP_COMPACT_STRINGS)
+ * @return Do dai payload, 0 neu buffer khong du
+ */
+static size_t build_room_players(server_t *server, room_t *room, uint8_t action,
+                                 int changed_user_id, const char *changed_username,
+                                 int compact, uint8_t *payload, size_t capacity)
+{
+    wire_writer_t w;
+    wire_writer_init(&w, payload, capacity);
+
+    // Thong tin phong day du + thay doi nguoi choi (0 = JOIN, 1 = LEAVE)
+    msg_room_players_header_t header = {
+        .room_id = room->room_id,
+        .max_players = (uint8_t)room->max_players,
+        .state = (uint8_t)room->state,
+        .owner_id = room->owner_id,
+        .action = action,
+        .changed_user_id = changed_user_id,
+        .player_count = (uint16_t)room->player_count,
+    };
+    snprintf(header.room_name, sizeof(header.room_name), "%s", room->room_name);
+    snprintf(header.changed_username, sizeof(header.changed_username), "%s",
+             changed_username ? changed_username : "");
+    // Header v1/v2 co cung truong (cung struct layout), chi khac cach ma hoa chuoi
+    if (compact)
+    {
+        msg_room_players_header_v2_t header_v2;
+        memcpy(&header_v2, &header, sizeof(header_v2));
+        msg_room_players_header_v2_write(&header_v2, &w);
+    }
+    else
+    {
+        msg_room_players_header_write(&header, &w);
     }
-    update->player_count = htons((uint16_t)room->player_count);
-
-    // Lay danh sach nguoi choi hien tai
-    player_info_protocol_t *players = (player_info_protocol_t *)(payload + sizeof(room_players_update_t));
 
     for (int i = 0; i < room->player_count; i++)
     {
         int player_user_id = room->players[i];
-        players[i].user_id = htonl((uint32_t)player_user_id);
-        players[i].is_owner = (player_user_id == room->owner_id) ? 1 : 0;
-        
-        // Xác định trạng thái active
-        if (room->active_players[i] == -1) {
-            // Người chơi đã rời phòng
-            players[i].is_active = 255; // 0xFF = đã rời phòng
-        } else if (room->active_players[i] == 1) {
-            // Người chơi đang active
-            players[i].is_active = 1;
-        } else {
-            // Người chơi đang chờ (join giữa chừng)
-            players[i].is_active = 0;
+        msg_player_info_t player = {
+            .user_id = player_user_id,
+            .is_owner = (player_user_id == room->owner_id) ? 1 : 0,
+            .is_active = player_active_protocol(room->active_players[i]),
+        };
+        // Username luu theo slot trong phong (con giu khi nguoi choi da roi luc dang choi)
+        snprintf(player.username, sizeof(player.username), "%s",
+                 room->player_names[i][0] ? room->player_names[i] : "Unknown");
+        snprintf(player.avatar, sizeof(player.avatar), "%s", find_player_avatar(server, player_user_id));
+
+        if (compact)
+        {
+            msg_player_info_v2_t player_v2;
+            memcpy(&player_v2, &player, sizeof(player_v2));
+            msg_player_info_v2_write(&player_v2, &w);
+        }
+        else
+        {
+            msg_player_info_write(&player, &w);
         }
+    }
 
-        // Tim username va avatar tu server->clients
-        // Nếu người chơi đã rời (active_players[i] == -1), có thể không tìm thấy trong server->clients
-        strncpy(players[i].username, "Unknown", MAX_USERNAME_LEN - 1);
-        strncpy(players[i].avatar, "avt1.jpg", 32 - 1);  // Default avatar
-        players[i].avatar[31] = '\0';
-        
-        for (int j = 0; j < MAX_CLIENTS; j++)
+    return w.overflow ? 0 : w.len;
+}
+
+/**
+ * Tao payload ROOM_PLAYER_DELTA chi voi nguoi choi thay doi
+ * @return Do dai payload, 0 neu buffer khong du
+ */
+static size_t build_room_player_delta(server_t *server, room_t *room, uint8_t action,
+                                      int changed_user_id, const char *changed_username,
+                                      uint8_t *payload, size_t capacity)
+{
+    msg_room_player_delta_t delta = {
+        .room_id = room->room_id,
+        .action = action,
+        .state = (uint8_t)room->state,
+        .owner_id = room->owner_id,
+        .player_count = (uint16_t)room->player_count,
+        .user_id = changed_user_id,
+    };
+
+    // Nguoi roi phong luc dang choi van con trong mang players[] (active = -1)
+    for (int i = 0; i < room->player_count; i++)
+    {
+        if (room->players[i] == changed_user_id)
         {
-            if (server->clients[j].active &&
-                server->clients[j].user_id == player_user_id)
-            {
-                strncpy(players[i].username, server->clients[j].username, MAX_USERNAME_LEN - 1);
-                players[i].username[MAX_USERNAME_LEN - 1] = '\0';
-                strncpy(players[i].avatar, server->clients[j].avatar, 32 - 1);
-                players[i].avatar[31] = '\0';
-                break;
-            }
+            delta.is_active = player_active_protocol(room->active_players[i]);
+            break;
         }
     }
 
+    snprintf(delta.username, sizeof(delta.username), "%s", changed_username ? changed_username : "");
+    snprintf(delta.avatar, sizeof(delta.avatar), "%s",
+             action == 0 ? find_player_avatar(server, changed_user_id) : "");
+    return msg_room_player_delta_encode(&delta, payload, capacity);
+}
+
+/**
+ * Broadcast thay doi nguoi choi den tat ca clients trong phong
+ * Nguoi vua join (changed_user_id, action JOIN) va client khong co CAP_PLAYER_DELTA nhan
+ * ROOM_PLAYERS_UPDATE day du, nhung nguoi con lai chi nhan ROOM_PLAYER_DELTA
+ */
+int protocol_broadcast_room_players_update(server_t *server, room_t *room,
+                                           uint8_t action, int changed_user_id,
+                                           const char *changed_username,
+                                           int exclude_client_index)
+{
+    if (!server || !room)
+    {
+        return -1;
+    }
+
+    uint8_t full_payload[CODEC_ROOM_PLAYERS_HEADER_MAX_SIZE + MAX_PLAYERS_PER_ROOM * CODEC_PLAYER_INFO_MAX_SIZE];
+    size_t full_len = 0;
+
+    uint8_t compact_payload[CODEC_ROOM_PLAYERS_HEADER_V2_MAX_SIZE + MAX_PLAYERS_PER_ROOM * CODEC_PLAYER_INFO_V2_MAX_SIZE];
+    size_t compact_len = 0;
+
+    uint8_t delta_payload[CODEC_ROOM_PLAYER_DELTA_MAX_SIZE];
+    size_t delta_len = build_room_player_delta(server, room, action, changed_user_id,
+                                               changed_username, delta_payload, sizeof(delta_payload));
+
     // Gui den tat ca clients trong phong
     int sent_count = 0;
+    int full_count = 0;
     for (int i = 0; i < MAX_CLIENTS; i++)
     {
         client_t *client = &server->clients[i];
@@ -313,19 +544,53 @@ int protocol_broadcast_room_players_update(server_t *server, room_t *room,
             continue;
         }
 
-        if (room_has_player(room, client->user_id))
+        if (!room_has_player(room, client->user_id))
+        {
+            continue;
+        }
+
+        int result;
+        if ((action == 0 && client->user_id == changed_user_id) ||
+            !CLIENT_HAS_CAP(client, CAP_PLAYER_DELTA))
         {
-            if (protocol_send_message(client->fd, MSG_ROOM_PLAYERS_UPDATE,
-                                      payload, payload_size) == 0)
+            // Nguoi vua vao phong chua co danh sach, client cu khong hieu delta
+            if (CLIENT_HAS_CAP(client, CAP_COMPACT_STRINGS))
             {
-                sent_count++;
+                if (compact_len == 0)
+                {
+                    compact_len = build_room_players(server, room, action, changed_user_id,
+                                                     changed_username, 1, compact_payload,
+                                                     sizeof(compact_payload));
+                }
+                result = protocol_send_client_message(client, MSG_ROOM_PLAYERS_UPDATE, compact_payload, compact_len);
             }
+            else
+            {
+                if (full_len == 0)
+                {
+                    full_len = build_room_players(server, room, action, changed_user_id,
+                                                  changed_username, 0, full_payload,
+                                                  sizeof(full_payload));
+                }
+                result = protocol_send_client_message(client, MSG_ROOM_PLAYERS_UPDATE, full_payload, full_len);
+            }
+            full_count++;
+        }
+        else
+        {
+            result = protocol_send_message(client->fd, MSG_ROOM_PLAYER_DELTA, delta_payload, (uint16_t)delta_len);
+        }
+
+        if (result == 0)
+        {
+            sent_count++;
         }
     }
 
+    metrics_record_broadcast(sent_count);
     const char *action_str = (action == 0) ? "JOIN" : "LEAVE";
-    printf("Da gui ROOM_PLAYERS_UPDATE (action=%s, user_id=%d) cho phong '%s' den %d clients\n",
-           action_str, changed_user_id, room->room_name, sent_count);
+    printf("Da gui ROOM_PLAYERS_UPDATE (action=%s, user_id=%d) cho phong '%s' den %d clients (%d ban day du, delta %zu bytes)\n",
+           action_str, changed_user_id, room->room_name, sent_count, full_count, delta_len);
 
     return (sent_count > 0) ? 0 : -1;
 }
@@ -340,15 +605,17 @@ int protocol_broadcast_room_update(server_t *server, room_t *room, int exclude_c
         return -1;
     }
 
-    // Tao room_info_protocol_t tu room
-    room_info_protocol_t room_info;
-    room_info.room_id = htonl((uint32_t)room->room_id);
-    strncpy(room_info.room_name, room->room_name, MAX_ROOM_NAME_LEN - 1);
-    room_info.room_name[MAX_ROOM_NAME_LEN - 1] = '\0';
-    room_info.player_count = (uint8_t)room->player_count;
-    room_info.max_players = (uint8_t)room->max_players;
-    room_info.state = (uint8_t)room->state;
-    room_info.owner_id = htonl((uint32_t)room->owner_id);
+    msg_room_info_t room_info = {
+        .room_id = room->room_id,
+        .player_count = (uint8_t)room->player_count,
+        .max_players = (uint8_t)room->max_players,
+        .state = (uint8_t)room->state,
+        .owner_id = room->owner_id,
+    };
+    snprintf(room_info.room_name, sizeof(room_info.room_name), "%s", room->room_name);
+
+    uint8_t payload[CODEC_ROOM_INFO_MAX_SIZE];
+    size_t payload_len = msg_room_info_encode(&room_info, payload, sizeof(payload));
 
     // Gui den tat ca clients trong phong
     int sent_count = 0;
@@ -366,7 +633,7 @@ int protocol_broadcast_room_update(server_t *server, room_t *room, int exclude_c
         if (room_has_player(room, client->user_id))
         {
             if (protocol_send_message(client->fd, MSG_ROOM_UPDATE,
-                                      (uint8_t *)&room_info, sizeof(room_info)) == 0)
+                                      payload, (uint16_t)payload_len) == 0)
             {
                 sent_count++;
             }
@@ -478,9 +745,62 @@ int protocol_handle_room_list_request(server_t *server, int client_index, const
 
     printf("Nhan ROOM_LIST_REQUEST tu client %d (user_id=%d)\n", client_index, client->user_id);
 
+    // Client xin danh sach phong tuc la dang xem sanh
+    if (client->state == CLIENT_STATE_LOGGED_IN)
+    {
+        server_lobby_subscribe(server, client_index);
+    }
+
     return protocol_send_room_list(client->fd, server);
 }
 
+/**
+ * Xu ly LOBBY_SUBSCRIBE: client bat dau xem sanh
+ * Gui lai danh sach day du neu seq cua client da cu
+ */
+int protocol_handle_lobby_subscribe(server_t *server, int client_index, const message_t *msg)
+{
+    (void)msg; // Unused parameter
+    if (!server || client_index < 0 || client_index >= MAX_CLIENTS)
+    {
+        return -1;
+    }
+
+    client_t *client = &server->clients[client_index];
+    if (!client->active || client->state == CLIENT_STATE_LOGGED_OUT || client->user_id <= 0)
+    {
+        fprintf(stderr, "Client %d chua dang nhap, khong the theo doi sanh\n", client_index);
+        return -1;
+    }
+
+    server_lobby_subscribe(server, client_index);
+    printf("Client %d (user_id=%d) theo doi sanh (%d nguoi dang xem)\n",
+           client_index, client->user_id, server->lobby_subscriber_count);
+
+    if (client->room_list_seq != server->room_list_pub.seq)
+    {
+        return protocol_send_room_list(client->fd, server);
+    }
+    return 0;
+}
+
+/**
+ * Xu ly LOBBY_UNSUBSCRIBE: client roi man hinh sanh
+ */
+int protocol_handle_lobby_unsubscribe(server_t *server, int client_index, const message_t *msg)
+{
+    (void)msg; // Unused parameter
+    if (!server || client_index < 0 || client_index >= MAX_CLIENTS)
+    {
+        return -1;
+    }
+
+    server_lobby_unsubscribe(server, client_index);
+    printf("Client %d ngung theo doi sanh (%d nguoi dang xem)\n",
+           client_index, server->lobby_subscriber_count);
+    return 0;
+}
+
 /**
  * Xu ly CREATE_ROOM
  */
@@ -500,7 +820,7 @@ int protocol_handle_create_room(server_t *server, int client_index, const messag
     // Kiem tra client da dang nhap chua
     if (client->state == CLIENT_STATE_LOGGED_OUT || client->user_id <= 0)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Ban can dang nhap de tao phong");
         return -1;
     }
@@ -508,35 +828,27 @@ int protocol_handle_create_room(server_t *server, int client_index, const messag
     // Kiem tra client da trong phong chua
     if (client->state == CLIENT_STATE_IN_ROOM || client->state == CLIENT_STATE_IN_GAME)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Ban dang trong phong khac");
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(create_room_request_t))
+    // Parse payload (decoder kiem tra do dai va dam bao null-terminated)
+    msg_create_room_request_t req;
+    if (msg_create_room_request_decode(msg->payload, msg->length, &req) < 0)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Du lieu khong hop le");
         return -1;
     }
 
-    // Parse payload
-    create_room_request_t *req = (create_room_request_t *)msg->payload;
-
-    // Dam bao null-terminated
-    char room_name[MAX_ROOM_NAME_LEN];
-    strncpy(room_name, req->room_name, MAX_ROOM_NAME_LEN - 1);
-    room_name[MAX_ROOM_NAME_LEN - 1] = '\0';
+    char *room_name = req.room_name;
+    int max_players = (int)req.max_players;
+    int rounds = (int)req.rounds;
 
-    int max_players = (int)req->max_players;
-    int rounds = (int)req->rounds;
-    
-    char difficulty[16];
-    strncpy(difficulty, req->difficulty, sizeof(difficulty) - 1);
-    difficulty[sizeof(difficulty) - 1] = '\0';
+    char *difficulty = req.difficulty;
     if (difficulty[0] == '\0') {
-        strncpy(difficulty, "easy", sizeof(difficulty) - 1);
+        strncpy(difficulty, "easy", sizeof(req.difficulty) - 1);
     }
 
     printf("Nhan CREATE_ROOM tu client %d: room_name=%s, max_players=%d, rounds=%d, difficulty=%s\n",
@@ -545,21 +857,21 @@ int protocol_handle_create_room(server_t *server, int client_index, const messag
     // Validate
     if (strlen(room_name) == 0)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Ten phong khong duoc de trong");
         return -1;
     }
 
     if (max_players < 2 || max_players > 10)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "So nguoi choi phai tu 2-10");
         return -1;
     }
 
     if (rounds < 1 || rounds > 10)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "So round phai tu 1-10");
         return -1;
     }
@@ -567,7 +879,7 @@ int protocol_handle_create_room(server_t *server, int client_index, const messag
     // Kiem tra server da day phong chua
     if (server->room_count >= MAX_ROOMS)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Server da day phong");
         return -1;
     }
@@ -576,26 +888,43 @@ int protocol_handle_create_room(server_t *server, int client_index, const messag
     room_t *room = room_create(room_name, client->user_id, max_players, rounds, difficulty);
     if (!room)
     {
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Khong the tao phong");
         return -1;
     }
+    room_set_player_name(room, client->user_id, client->username);
+
+    // Tao canvas raster phia server neu duoc bat
+    if (server->config.canvas_enabled)
+    {
+        room->canvas = canvas_create(MAX_CANVAS_WIDTH, MAX_CANVAS_HEIGHT);
+        if (!room->canvas)
+        {
+            fprintf(stderr, "Canh bao: Khong the tao canvas cho phong %d, tiep tuc khong co snapshot\n",
+                    room->room_id);
+        }
+    }
+
+    // Log net ve theo round (de phat lai cho nguoi vao giua round)
+    room->strokes = stroke_log_create(server->config.stroke_tolerance);
 
     // Them phong vao server
     if (protocol_add_room_to_server(server, room) != 0)
     {
         room_destroy(room);
-        protocol_send_create_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_create_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                            "Khong the them phong vao server");
         return -1;
     }
 
-    // Cap nhat trang thai client
+    // Cap nhat trang thai client (roi sanh, khong nhan danh sach phong nua)
     client->state = CLIENT_STATE_IN_ROOM;
+    server_lobby_unsubscribe(server, client_index);
 
     // Gui response thanh cong
-    protocol_send_create_room_response(client->fd, STATUS_SUCCESS, room->room_id,
+    protocol_send_create_room_response(client->fd, client->caps, STATUS_SUCCESS, room->room_id,
                                        "Tao phong thanh cong");
+    capture_room_created(client_index, room->room_id);
 
     printf("Client %d da tao phong '%s' (ID: %d) thanh cong\n",
            client_index, room_name, room->room_id);
@@ -636,7 +965,7 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Kiem tra client da dang nhap chua
     if (client->state == CLIENT_STATE_LOGGED_OUT || client->user_id <= 0)
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Ban can dang nhap de tham gia phong");
         return -1;
     }
@@ -644,22 +973,20 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Kiem tra client da trong phong chua
     if (client->state == CLIENT_STATE_IN_ROOM || client->state == CLIENT_STATE_IN_GAME)
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Ban dang trong phong khac");
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(join_room_request_t))
+    // Parse payload
+    msg_room_id_t req;
+    if (msg_room_id_decode(msg->payload, msg->length, &req) < 0)
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Du lieu khong hop le");
         return -1;
     }
-
-    // Parse payload
-    join_room_request_t *req = (join_room_request_t *)msg->payload;
-    int room_id = (int)ntohl((uint32_t)req->room_id); // Convert from network byte order
+    int room_id = (int)req.room_id;
 
     printf("Nhan JOIN_ROOM tu client %d: room_id=%d\n", client_index, room_id);
 
@@ -667,7 +994,7 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     room_t *room = protocol_find_room(server, room_id);
     if (!room)
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Khong tim thay phong");
         return -1;
     }
@@ -675,7 +1002,7 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Kiem tra phong da day chua
     if (room_is_full(room))
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Phong da day");
         return -1;
     }
@@ -683,7 +1010,7 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Kiem tra nguoi choi da trong phong chua
     if (room_has_player(room, client->user_id))
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Ban da trong phong nay");
         return -1;
     }
@@ -691,13 +1018,15 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Them nguoi choi vao phong
     if (!room_add_player(room, client->user_id))
     {
-        protocol_send_join_room_response(client->fd, STATUS_ERROR, -1,
+        protocol_send_join_room_response(client->fd, client->caps, STATUS_ERROR, -1,
                                          "Khong the tham gia phong");
         return -1;
     }
+    room_set_player_name(room, client->user_id, client->username);
 
-    // Cap nhat trang thai client
+    // Cap nhat trang thai client (roi sanh, khong nhan danh sach phong nua)
     client->state = CLIENT_STATE_IN_ROOM;
+    server_lobby_unsubscribe(server, client_index);
 
     // Kiem tra neu phong da dat max players va dang WAITING, tu dong start game
     if (room->player_count >= room->max_players && room->state == ROOM_WAITING) {
@@ -724,7 +1053,7 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     }
 
     // Gui response thanh cong
-    protocol_send_join_room_response(client->fd, STATUS_SUCCESS, room_id,
+    protocol_send_join_room_response(client->fd, client->caps, STATUS_SUCCESS, room_id,
                                      "Tham gia phong thanh cong");
 
     // Broadcast ROOM_PLAYERS_UPDATE voi danh sach day du (da bao gom tat ca thong tin phong)
@@ -736,6 +1065,27 @@ int protocol_handle_join_room(server_t *server, int client_index, const message_
     // Broadcast ROOM_UPDATE de thong bao trang thai phong (co the da chuyen sang PLAYING)
     protocol_broadcast_room_update(server, room, -1);
 
+    // Vao giua round: gui snapshot canvas (neu bat va client ve duoc snapshot) hoac phat lai
+    // log net ve de client khong bi thieu cac net da ve truoc khi vao
+    if (room->state == ROOM_PLAYING)
+    {
+        // Client CAP_ROUND_DEADLINE khong nhan TIMER_UPDATE: gui han chot ngay thay vi cho resync
+        // (client cu nhan TIMER_UPDATE o tick 1 giay ke tiep)
+        if (room->game && !room->game->game_ended && room->game->round_start_ms != 0 &&
+            CLIENT_HAS_CAP(client, CAP_ROUND_DEADLINE))
+        {
+            protocol_send_round_deadline(client, room->game, utils_now_ms());
+        }
+        if (room->canvas && room->canvas->stroke_count > 0 && CLIENT_HAS_CAP(client, CAP_CANVAS_SNAPSHOT))
+        {
+            protocol_send_canvas_snapshot(client->fd, client->caps, room);
+        }
+        else if (room->strokes && room->strokes->stroke_count > 0)
+        {
+            protocol_send_stroke_replay(client->fd, room);
+        }
+    }
+
     printf("Client %d (user_id=%d, username=%s) da tham gia phong '%s' (ID: %d)\n",
            client_index, client->user_id, client->username, room->room_name, room_id);
 
@@ -761,7 +1111,7 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
     // Kiem tra client da dang nhap chua
     if (client->state == CLIENT_STATE_LOGGED_OUT || client->user_id <= 0)
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Ban chua dang nhap");
         return -1;
     }
@@ -769,22 +1119,20 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
     // Kiem tra client co trong phong khong
     if (client->state != CLIENT_STATE_IN_ROOM && client->state != CLIENT_STATE_IN_GAME)
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Ban khong trong phong nao");
         return -1;
     }
 
-    // Kiem tra payload size
-    if (msg->length < sizeof(leave_room_request_t))
+    // Parse payload
+    msg_room_id_t req;
+    if (msg_room_id_decode(msg->payload, msg->length, &req) < 0)
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Du lieu khong hop le");
         return -1;
     }
-
-    // Parse payload
-    leave_room_request_t *req = (leave_room_request_t *)msg->payload;
-    int room_id = (int)ntohl((uint32_t)req->room_id); // Convert from network byte order
+    int room_id = (int)req.room_id;
 
     printf("Nhan LEAVE_ROOM tu client %d: room_id=%d\n", client_index, room_id);
 
@@ -792,7 +1140,7 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
     room_t *room = protocol_find_room(server, room_id);
     if (!room)
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Khong tim thay phong");
         return -1;
     }
@@ -800,7 +1148,7 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
     // Kiem tra nguoi choi co trong phong khong
     if (!room_has_player(room, client->user_id))
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Ban khong trong phong nay");
         return -1;
     }
@@ -821,7 +1169,7 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
     // Xoa nguoi choi khoi phong
     if (!room_remove_player(room, client->user_id))
     {
-        protocol_send_leave_room_response(client->fd, STATUS_ERROR,
+        protocol_send_leave_room_response(client->fd, client->caps, STATUS_ERROR,
                                           "Khong the roi phong");
         return -1;
     }
@@ -879,7 +1227,8 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
                    room_name, room_id);
             protocol_broadcast_room_list(server);
             client->state = CLIENT_STATE_LOGGED_IN;
-            protocol_send_leave_room_response(client->fd, STATUS_SUCCESS,
+            server_lobby_subscribe(server, client_index);
+            protocol_send_leave_room_response(client->fd, client->caps, STATUS_SUCCESS,
                                               "Roi phong thanh cong");
             return 0;
         }
@@ -891,6 +1240,9 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
 
         printf("Client %d (user_id=%d, username=%s) da roi phong '%s' (ID: %d)\n",
                client_index, leaving_user_id, leaving_username, room_name, room_id);
+
+        // So nguoi/owner thay doi
+        protocol_broadcast_room_list(server);
     }
 
     // Xu ly drawer roi phong trong game (sau khi da broadcast danh sach players)
@@ -902,11 +1254,12 @@ int protocol_handle_leave_room(server_t *server, int client_index, const message
         protocol_handle_round_timeout(server, room, word_before);
     }
 
-    // Cap nhat trang thai client
+    // Cap nhat trang thai client (quay lai sanh)
     client->state = CLIENT_STATE_LOGGED_IN;
+    server_lobby_subscribe(server, client_index);
 
     // Gui response thanh cong
-    protocol_send_leave_room_response(client->fd, STATUS_SUCCESS,
+    protocol_send_leave_room_response(client->fd, client->caps, STATUS_SUCCESS,
                                       "Roi phong thanh cong");
 
     return 0;
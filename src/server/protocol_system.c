@@ -0,0 +1,122 @@
+#include "../include/protocol.h"
+#include "../include/server.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include "../include/utils.h"
+#include <stdio.h>
+
+/**
+ * Xu ly HELLO: thoa thuan phien ban va capability
+ * Client cu khong gui HELLO van dung format cu (caps = 0)
+ */
+int protocol_handle_hello(server_t* server, int client_index, const message_t* msg) {
+    if (!server || !msg || client_index < 0 || client_index >= MAX_CLIENTS) {
+        return -1;
+    }
+
+    client_t* client = &server->clients[client_index];
+    if (!client->active) {
+        return -1;
+    }
+
+    msg_hello_t hello;
+    if (msg_hello_decode(msg->payload, msg->length, &hello) < 0) {
+        fprintf(stderr, "Loi: HELLO payload khong hop le tu client %d\n", client_index);
+        return -1;
+    }
+    uint16_t client_version = hello.version;
+    uint32_t client_caps = hello.caps;
+
+    // Dung phien ban thap hon va chi cac capability ca hai cung ho tro
+    client->protocol_version = client_version < PROTOCOL_VERSION ? client_version : PROTOCOL_VERSION;
+    client->caps = client_caps & SERVER_CAPS;
+
+    printf("Nhan HELLO tu client %d: version=%u, caps=0x%08X -> version=%u, caps=0x%08X\n",
+           client_index, client_version, client_caps, client->protocol_version, client->caps);
+
+    msg_hello_t ack = {.version = client->protocol_version, .caps = client->caps};
+    uint8_t payload[CODEC_HELLO_MAX_SIZE];
+    size_t len = msg_hello_encode(&ack, payload, sizeof(payload));
+    return protocol_send_message(client->fd, MSG_HELLO_ACK, payload, (uint16_t)len);
+}
+
+int protocol_send_error(int client_fd, uint8_t request_type, const char* message) {
+    msg_error_t err = {.request_type = request_type};
+    snprintf(err.message, sizeof(err.message), "%s", message ? message : "");
+    uint8_t payload[CODEC_ERROR_MAX_SIZE];
+    size_t len = msg_error_encode(&err, payload, sizeof(payload));
+    return protocol_send_message(client_fd, MSG_ERROR, payload, (uint16_t)len);
+}
+
+/**
+ * Xu ly PING tu client: tra PONG ngay voi dong ho thuc (epoch ms) cua server
+ * Client dung PONG de tinh RTT va lech dong ho voi server (vd. dem nguoc ROUND_DEADLINE)
+ */
+int protocol_handle_ping(server_t* server, int client_index, const message_t* msg) {
+    uint64_t recv_ms = utils_wall_ms();
+    if (!server || !msg || client_index < 0 || client_index >= MAX_CLIENTS) {
+        return -1;
+    }
+
+    client_t* client = &server->clients[client_index];
+    msg_ping_t ping;
+    if (!client->active || msg_ping_decode(msg->payload, msg->length, &ping) < 0) {
+        return -1;
+    }
+
+    msg_pong_t pong = {
+        .seq = ping.seq,
+        .origin_ms = ping.origin_ms,
+        .recv_ms = recv_ms,
+        .send_ms = utils_wall_ms(),
+    };
+    uint8_t payload[CODEC_PONG_MAX_SIZE];
+    size_t len = msg_pong_encode(&pong, payload, sizeof(payload));
+    return protocol_send_message(client->fd, MSG_PONG, payload, (uint16_t)len);
+}
+
+/**
+ * Xu ly PONG tra loi PING cua server: cap nhat RTT/lech dong ho cua client
+ */
+int protocol_handle_pong(server_t* server, int client_index, const message_t* msg) {
+    uint64_t now_ms = utils_now_ms();
+    uint64_t wall_ms = utils_wall_ms();
+    if (!server || !msg || client_index < 0 || client_index >= MAX_CLIENTS) {
+        return -1;
+    }
+
+    client_t* client = &server->clients[client_index];
+    msg_pong_t pong;
+    if (!client->active || msg_pong_decode(msg->payload, msg->length, &pong) < 0) {
+        return -1;
+    }
+
+    if (clocksync_on_pong(&client->clock, pong.seq, pong.origin_ms, pong.recv_ms, pong.send_ms, now_ms,
+                          wall_ms) != 0) {
+        return -1; // PONG tre hoac khong khop PING dang cho
+    }
+    return 0;
+}
+
+int protocol_ping_clients(server_t* server, uint64_t now_ms) {
+    if (!server) {
+        return -1;
+    }
+
+    int sent = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        client_t* client = &server->clients[i];
+        if (!client->active || !CLIENT_HAS_CAP(client, CAP_PING) || now_ms < client->clock.next_ping_ms) {
+            continue;
+        }
+
+        uint64_t wall_ms = utils_wall_ms();
+        msg_ping_t ping = {.seq = clocksync_start_ping(&client->clock, now_ms, wall_ms), .origin_ms = wall_ms};
+        uint8_t payload[CODEC_PING_MAX_SIZE];
+        size_t len = msg_ping_encode(&ping, payload, sizeof(payload));
+        if (protocol_send_message(client->fd, MSG_PING, payload, (uint16_t)len) == 0) {
+            sent++;
+        }
+    }
+    return sent;
+}
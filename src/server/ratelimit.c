@@ -0,0 +1,181 @@
+#include "../include/ratelimit.h"
+#include "../common/protocol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *class_names[RATE_CLASS_COUNT] = {
+    "draw",
+    "chat",
+    "lobby",
+    "room",
+    "auth",
+};
+
+// Xac dinh nhom rate limit cua message
+int ratelimit_class_for(uint8_t msg_type)
+{
+    switch (msg_type)
+    {
+    case MSG_DRAW_DATA:
+        return RATE_CLASS_DRAW;
+
+    case MSG_CHAT_MESSAGE:
+    case MSG_GUESS_WORD:
+        return RATE_CLASS_CHAT;
+
+    case MSG_ROOM_LIST_REQUEST:
+    case MSG_LOBBY_SUBSCRIBE:
+    case MSG_LOBBY_UNSUBSCRIBE:
+    case MSG_GET_GAME_HISTORY:
+        return RATE_CLASS_LOBBY;
+
+    case MSG_CREATE_ROOM:
+    case MSG_JOIN_ROOM:
+    case MSG_LEAVE_ROOM:
+    case MSG_START_GAME:
+        return RATE_CLASS_ROOM;
+
+    case MSG_LOGIN_REQUEST:
+    case MSG_REGISTER_REQUEST:
+    case MSG_CHANGE_PASSWORD_REQUEST:
+        return RATE_CLASS_AUTH;
+
+    default:
+        return RATE_CLASS_NONE;
+    }
+}
+
+const char *ratelimit_class_name(int rate_class)
+{
+    if (rate_class < 0 || rate_class >= RATE_CLASS_COUNT)
+    {
+        return "none";
+    }
+    return class_names[rate_class];
+}
+
+// Chinh sach mac dinh
+void ratelimit_default_policies(rate_limit_policy_t *policies)
+{
+    if (!policies)
+    {
+        return;
+    }
+
+    // Frontend gui DRAW_DATA theo mousemove (~60 lan/giay khi dang ve)
+    policies[RATE_CLASS_DRAW].rate_per_sec = 120;
+    policies[RATE_CLASS_DRAW].burst = 240;
+
+    policies[RATE_CLASS_CHAT].rate_per_sec = 5;
+    policies[RATE_CLASS_CHAT].burst = 10;
+
+    policies[RATE_CLASS_LOBBY].rate_per_sec = 2;
+    policies[RATE_CLASS_LOBBY].burst = 5;
+
+    policies[RATE_CLASS_ROOM].rate_per_sec = 2;
+    policies[RATE_CLASS_ROOM].burst = 5;
+
+    policies[RATE_CLASS_AUTH].rate_per_sec = 1;
+    policies[RATE_CLASS_AUTH].burst = 5;
+}
+
+// Parse "nhom=rate/burst"
+int ratelimit_parse_option(const char *spec, rate_limit_policy_t *policies)
+{
+    if (!spec || !policies)
+    {
+        return -1;
+    }
+
+    const char *eq = strchr(spec, '=');
+    if (!eq)
+    {
+        return -1;
+    }
+
+    int rate_class = RATE_CLASS_NONE;
+    size_t name_len = (size_t)(eq - spec);
+    for (int i = 0; i < RATE_CLASS_COUNT; i++)
+    {
+        if (strlen(class_names[i]) == name_len && strncmp(spec, class_names[i], name_len) == 0)
+        {
+            rate_class = i;
+            break;
+        }
+    }
+    if (rate_class == RATE_CLASS_NONE)
+    {
+        return -1;
+    }
+
+    char *end = NULL;
+    long rate = strtol(eq + 1, &end, 10);
+    if (end == eq + 1 || rate < 0)
+    {
+        return -1;
+    }
+
+    // Burst mac dinh bang 2 giay token neu khong chi dinh
+    long burst = rate * 2;
+    if (*end == '/')
+    {
+        const char *burst_str = end + 1;
+        burst = strtol(burst_str, &end, 10);
+        if (end == burst_str || burst <= 0)
+        {
+            return -1;
+        }
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+
+    policies[rate_class].rate_per_sec = (uint32_t)rate;
+    policies[rate_class].burst = (uint32_t)(rate == 0 ? 0 : burst);
+    return 0;
+}
+
+// Khoi tao trang thai client
+void ratelimit_init_client(client_rate_state_t *state, const rate_limit_policy_t *policies, uint64_t now_ms)
+{
+    if (!state)
+    {
+        return;
+    }
+
+    memset(state, 0, sizeof(*state));
+    for (int i = 0; i < RATE_CLASS_COUNT; i++)
+    {
+        state->buckets[i].tokens_milli = policies ? policies[i].burst * 1000u : 0;
+        state->buckets[i].last_refill_ms = now_ms;
+    }
+}
+
+// Lay 1 token tu bucket
+bool ratelimit_consume(rate_bucket_t *bucket, const rate_limit_policy_t *policy, uint64_t now_ms)
+{
+    if (!bucket || !policy || policy->rate_per_sec == 0)
+    {
+        return true;
+    }
+
+    // Nap token: moi ms duoc rate_per_sec milli-token
+    uint64_t capacity = (uint64_t)policy->burst * 1000u;
+    if (now_ms > bucket->last_refill_ms)
+    {
+        uint64_t refill = (now_ms - bucket->last_refill_ms) * policy->rate_per_sec;
+        uint64_t tokens = (uint64_t)bucket->tokens_milli + refill;
+        bucket->tokens_milli = (uint32_t)(tokens > capacity ? capacity : tokens);
+        bucket->last_refill_ms = now_ms;
+    }
+
+    if (bucket->tokens_milli < 1000u)
+    {
+        return false;
+    }
+
+    bucket->tokens_milli -= 1000u;
+    return true;
+}
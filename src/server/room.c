@@ -1,17 +1,44 @@
 #include "../include/room.h"
 #include "../include/server.h"
 #include "../include/game.h"
-#include "../include/database.h"
+#include "../include/storage.h"
+#include "../include/canvas.h"
+#include "../include/stroke.h"
+#include "../include/utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-extern db_connection_t* db;
-
 // Room ID tu dong tang
 static int next_room_id = 1;
 
+// The he danh sach phong, tang moi khi co phong thay doi thong tin hien thi
+static unsigned long list_generation = 1;
+
+// Danh dau thong tin hien thi cua phong da thay doi
+static void room_touch(room_t *room)
+{
+    room->version++;
+    list_generation++;
+}
+
+// Doi owner va cap nhat username chu phong tu slot tuong ung
+static void room_set_owner(room_t *room, int new_owner_id)
+{
+    room->owner_id = new_owner_id;
+    room->owner_username[0] = '\0';
+    for (int i = 0; i < room->player_count; i++)
+    {
+        if (room->players[i] == new_owner_id)
+        {
+            memcpy(room->owner_username, room->player_names[i], ROOM_USERNAME_MAX_LENGTH);
+            break;
+        }
+    }
+    room_touch(room);
+}
+
 // Tao phong choi moi
 room_t *room_create(const char *room_name, int owner_id, int max_players, int rounds, const char *difficulty)
 {
@@ -49,6 +76,7 @@ room_t *room_create(const char *room_name, int owner_id, int max_players, int ro
     room->room_name[ROOM_NAME_MAX_LENGTH - 1] = '\0';
 
     room->owner_id = owner_id;
+    room->owner_username[0] = '\0';
     room->max_players = max_players;
     room->total_rounds = rounds;
     
@@ -68,13 +96,17 @@ room_t *room_create(const char *room_name, int owner_id, int max_players, int ro
     
     room->state = ROOM_WAITING;
     room->game = NULL;
-    room->created_at = time(NULL);
+    room->canvas = NULL;
+    room->strokes = NULL;
+    room->created_at = (time_t)(utils_wall_ms() / 1000);
+    room->version = 0;
 
     // Khoi tao array nguoi choi
     room->player_count = 0;
     for (int i = 0; i < MAX_PLAYERS_PER_ROOM; i++)
     {
         room->players[i] = 0;
+        room->player_names[i][0] = '\0';
         room->db_player_ids[i] = 0;
         room->active_players[i] = 0;
     }
@@ -85,19 +117,21 @@ room_t *room_create(const char *room_name, int owner_id, int max_players, int ro
     room->player_count = 1;
 
     // Persist room + owner player (best-effort)
-    if (db) {
+    if (storage_available()) {
         char code[16];
         snprintf(code, sizeof(code), "R%d", room->room_id);
-        int db_room_id = db_create_room(db, code, owner_id, max_players, rounds);
+        int db_room_id = storage_create_room(code, owner_id, max_players, rounds);
         if (db_room_id > 0) {
             room->db_room_id = db_room_id;
-            int db_player_id = db_add_room_player(db, db_room_id, owner_id, 1);
+            int db_player_id = storage_add_room_player(db_room_id, owner_id, 1);
             if (db_player_id > 0) {
                 room->db_player_ids[0] = db_player_id;
             }
         }
     }
 
+    room_touch(room);
+
     printf("Phong '%s' (ID: %d) da duoc tao boi user %d\n",
            room->room_name, room->room_id, owner_id);
 
@@ -114,6 +148,9 @@ void room_destroy(room_t *room)
 
     printf("Dang huy phong '%s' (ID: %d)\n", room->room_name, room->room_id);
 
+    // Phong bien mat khoi danh sach
+    list_generation++;
+
     // Free game state neu co
     if (room->game)
     {
@@ -121,6 +158,19 @@ void room_destroy(room_t *room)
         room->game = NULL;
     }
 
+    // Free canvas neu co
+    if (room->canvas)
+    {
+        canvas_destroy(room->canvas);
+        room->canvas = NULL;
+    }
+
+    if (room->strokes)
+    {
+        stroke_log_destroy(room->strokes);
+        room->strokes = NULL;
+    }
+
     free(room);
 }
 
@@ -148,14 +198,15 @@ bool room_add_player(room_t *room, int user_id)
 
     // Them player vao array nguoi choi
     room->players[room->player_count] = user_id;
+    room->player_names[room->player_count][0] = '\0';
 
     // Neu phong dang choi, danh dau la dang cho (inactive)
     // Se duoc active vao round tiep theo
     if (room->state == ROOM_PLAYING)
     {
         room->active_players[room->player_count] = 0; // Cho den round sau
-        if (db && room->db_room_id > 0) {
-            int db_player_id = db_add_room_player(db, room->db_room_id, user_id, room->player_count + 1);
+        if (storage_available() && room->db_room_id > 0) {
+            int db_player_id = storage_add_room_player(room->db_room_id, user_id, room->player_count + 1);
             if (db_player_id > 0) room->db_player_ids[room->player_count] = db_player_id;
         }
         room->player_count++;
@@ -167,8 +218,8 @@ bool room_add_player(room_t *room, int user_id)
     {
         // Phong chua choi, active ngay
         room->active_players[room->player_count] = 1;
-        if (db && room->db_room_id > 0) {
-            int db_player_id = db_add_room_player(db, room->db_room_id, user_id, room->player_count + 1);
+        if (storage_available() && room->db_room_id > 0) {
+            int db_player_id = storage_add_room_player(room->db_room_id, user_id, room->player_count + 1);
             if (db_player_id > 0) room->db_player_ids[room->player_count] = db_player_id;
         }
         room->player_count++;
@@ -177,6 +228,7 @@ bool room_add_player(room_t *room, int user_id)
                room->player_count, room->max_players);
     }
 
+    room_touch(room);
     return true;
 }
 
@@ -225,7 +277,7 @@ bool room_remove_player(room_t *room, int user_id)
                 }
             }
             if (new_owner_id > 0) {
-                room->owner_id = new_owner_id;
+                room_set_owner(room, new_owner_id);
                 printf("Quyen chu phong '%s' duoc chuyen cho user %d (owner cu roi phong trong luc choi)\n",
                        room->room_name, room->owner_id);
             } else {
@@ -256,14 +308,18 @@ bool room_remove_player(room_t *room, int user_id)
     for (int i = player_index; i < room->player_count - 1; i++)
     {
         room->players[i] = room->players[i + 1];
+        memcpy(room->player_names[i], room->player_names[i + 1], ROOM_USERNAME_MAX_LENGTH);
         room->active_players[i] = room->active_players[i + 1];
         room->db_player_ids[i] = room->db_player_ids[i + 1];
     }
     room->players[room->player_count - 1] = 0;
+    room->player_names[room->player_count - 1][0] = '\0';
     room->active_players[room->player_count - 1] = 0;
     room->db_player_ids[room->player_count - 1] = 0;
     room->player_count--;
 
+    room_touch(room);
+
     printf("User %d da roi phong '%s' (ID: %d). So nguoi con lai: %d\n",
            user_id, room->room_name, room->room_id, room->player_count);
 
@@ -282,7 +338,7 @@ bool room_remove_player(room_t *room, int user_id)
         }
         
         if (new_owner_id > 0) {
-            room->owner_id = new_owner_id;
+            room_set_owner(room, new_owner_id);
             printf("Quyen chu phong '%s' duoc chuyen cho user %d\n",
                    room->room_name, room->owner_id);
         } else {
@@ -295,6 +351,32 @@ bool room_remove_player(room_t *room, int user_id)
     return true;
 }
 
+// Gan username cho nguoi choi trong phong
+void room_set_player_name(room_t *room, int user_id, const char *username)
+{
+    if (!room || user_id <= 0 || !username)
+    {
+        return;
+    }
+
+    for (int i = 0; i < room->player_count; i++)
+    {
+        if (room->players[i] == user_id)
+        {
+            strncpy(room->player_names[i], username, ROOM_USERNAME_MAX_LENGTH - 1);
+            room->player_names[i][ROOM_USERNAME_MAX_LENGTH - 1] = '\0';
+            break;
+        }
+    }
+
+    if (user_id == room->owner_id && strcmp(room->owner_username, username) != 0)
+    {
+        strncpy(room->owner_username, username, ROOM_USERNAME_MAX_LENGTH - 1);
+        room->owner_username[ROOM_USERNAME_MAX_LENGTH - 1] = '\0';
+        room_touch(room);
+    }
+}
+
 // Kiem tra nguoi choi co trong phong khong
 bool room_has_player(room_t *room, int user_id)
 {
@@ -352,7 +434,7 @@ bool room_transfer_ownership(room_t *room, int new_owner_id)
     }
 
     int old_owner_id = room->owner_id;
-    room->owner_id = new_owner_id;
+    room_set_owner(room, new_owner_id);
 
     printf("Quyen chu phong '%s' duoc chuyen tu user %d sang user %d\n",
            room->room_name, old_owner_id, new_owner_id);
@@ -390,7 +472,7 @@ bool room_ensure_active_owner(room_t *room)
     
     if (new_owner_id > 0) {
         int old_owner_id = room->owner_id;
-        room->owner_id = new_owner_id;
+        room_set_owner(room, new_owner_id);
         printf("Owner cua phong '%s' (ID: %d) duoc chuyen tu user %d sang user %d (owner cu khong active)\n",
                room->room_name, room->room_id, old_owner_id, new_owner_id);
         return true;
@@ -429,6 +511,7 @@ bool room_start_game(room_t *room)
     }
 
     room->state = ROOM_PLAYING;
+    room_touch(room);
 
     printf("Game trong phong '%s' (ID: %d) da bat dau voi %d nguoi choi\n",
            room->room_name, room->room_id, room->player_count);
@@ -440,6 +523,7 @@ bool room_start_game(room_t *room)
         if (!room->game) {
             fprintf(stderr, "Khong the khoi tao game state\n");
             room->state = ROOM_WAITING;
+            room_touch(room);
             return false;
         }
     }
@@ -467,6 +551,7 @@ void room_end_game(room_t *room)
 
     // Ket thuc trang thai PLAYING
     room->state = ROOM_FINISHED;
+    room_touch(room);
 }
 
 // Lay thong tin co ban cua phong cho sanh cho
@@ -484,6 +569,7 @@ void room_get_info(room_t *room, room_info_t *room_info)
     room_info->max_players = room->max_players;
     room_info->state = room->state;
     room_info->owner_id = room->owner_id;
+    memcpy(room_info->owner_username, room->owner_username, ROOM_USERNAME_MAX_LENGTH);
 }
 
 // Lay danh sach tat ca phong trong server
@@ -508,3 +594,9 @@ int room_get_list(server_t *server, room_info_t *room_info_array, int max_rooms)
 
     return count;
 }
+
+// The he hien tai cua danh sach phong
+unsigned long room_list_generation(void)
+{
+    return list_generation;
+}
@@ -2,7 +2,11 @@
 #include "../include/protocol.h"
 #include "../include/room.h"
 #include "../include/game.h"
-#include "../include/database.h"
+#include "../include/storage.h"
+#include "../include/utils.h"
+#include "../include/metrics.h"
+#include "../include/stall.h"
+#include "../include/capture.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,13 +16,44 @@
 #include <netinet/tcp.h>
 #include <time.h>
 
-// External database connection (from main.c)
-extern db_connection_t* db;
+// Static variable để track last database ping (ms monotonic)
+static uint64_t last_db_ping_ms = 0;
+// Static variable để track thời gian gửi timer update cuối cùng (ms monotonic)
+static uint64_t last_timer_update_ms = 0;
+
+// Timeout select(): toi da 1 giay, ngan hon neu co round sap het gio hoac storage can commit
+static void next_tick_timeout(server_t *server, uint64_t now_ms, struct timeval *tv) {
+    uint64_t wait_ms = 1000;
+    for (int r = 0; r < MAX_ROOMS; r++) {
+        room_t* room = server->rooms[r];
+        if (!room || room->state != ROOM_PLAYING || !room->game || room->game->round_start_ms == 0) continue;
+
+        uint64_t deadline = room->game->round_deadline_ms;
+        uint64_t left = deadline > now_ms ? deadline - now_ms : 0;
+        if (left < wait_ms) {
+            wait_ms = left;
+        }
+    }
+
+    uint64_t idle_deadline;
+    if (timerheap_peek(&server->idle_timers, NULL, &idle_deadline) == 0) {
+        uint64_t left = idle_deadline > now_ms ? idle_deadline - now_ms : 0;
+        if (left < wait_ms) {
+            wait_ms = left;
+        }
+    }
 
-// Static variable để track last database ping
-static time_t last_db_ping = 0;
-// Static variable để track thời gian gửi timer update cuối cùng
-static time_t last_timer_update = 0;
+    // Batch SQLite phai commit dung han ke ca khi server ranh (gioi han du lieu mat khi crash)
+    uint64_t storage_deadline = storage_next_deadline_ms();
+    if (storage_deadline != 0) {
+        uint64_t left = storage_deadline > now_ms ? storage_deadline - now_ms : 0;
+        if (left < wait_ms) {
+            wait_ms = left;
+        }
+    }
+    tv->tv_sec = (time_t)(wait_ms / 1000);
+    tv->tv_usec = (suseconds_t)((wait_ms % 1000) * 1000);
+}
 
 // Khoi tao server
 int server_init(server_t *server, int port) {
@@ -27,6 +62,15 @@ int server_init(server_t *server, int port) {
     server->port = port;
     server->client_count = 0;
     server->max_fd = 0;
+    server->room_list_pub.seq = 1;  // Seq 0 danh cho client chua nhan danh sach
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        server->clients[i].lobby_slot = -1;
+    }
+    metrics_http_init(&server->metrics_http);
+    if (timerheap_init(&server->idle_timers, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "Loi: Khong the cap phat idle timer\n");
+        return -1;
+    }
 
     // Tao socket
     server->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -119,7 +163,21 @@ int server_add_client(server_t *server, int client_fd) {
             strncpy(server->clients[i].avatar, "avt1.jpg", sizeof(server->clients[i].avatar) - 1);
             server->clients[i].avatar[sizeof(server->clients[i].avatar) - 1] = '\0';
             server->clients[i].state = CLIENT_STATE_LOGGED_OUT;
+            ratelimit_init_client(&server->clients[i].rate, server->config.rate_limits, utils_now_ms());
+            server->clients[i].rx_len = 0;
+            server->clients[i].room_list_seq = 0;
+            server->clients[i].lobby_slot = -1;
+            server->clients[i].protocol_version = PROTOCOL_VERSION_LEGACY;
+            server->clients[i].caps = 0;
+            clocksync_reset(&server->clients[i].clock);
+            server->clients[i].last_activity_ms = utils_now_ms();
+            if (server->config.idle_timeout_ms > 0) {
+                // Client chua gui HELLO: het han ma khong co CAP_PING thi chi bo timer
+                timerheap_set(&server->idle_timers, i,
+                              server->clients[i].last_activity_ms + server->config.idle_timeout_ms);
+            }
             server->client_count++;
+            capture_session_open(i);
             
             // Cap nhat max_fd moi neu can de select() hoat dong dung
             if (client_fd > server->max_fd) {
@@ -140,7 +198,19 @@ int server_add_client(server_t *server, int client_fd) {
 void server_remove_client(server_t *server, int client_index) {
     if (client_index >= 0 && client_index < MAX_CLIENTS && server->clients[client_index].active) {
         int fd = server->clients[client_index].fd;
+
+        // In so message bi bo do rate limit (neu co) truoc khi xoa client
+        client_rate_state_t *rate = &server->clients[client_index].rate;
+        for (int c = 0; c < RATE_CLASS_COUNT; c++) {
+            if (rate->dropped[c] > 0) {
+                printf("Client %d bi bo %u message nhom '%s' do rate limit\n",
+                       client_index, rate->dropped[c], ratelimit_class_name(c));
+            }
+        }
         
+        server_lobby_unsubscribe(server, client_index);
+        capture_session_close(client_index);
+
         // Shutdown write để đảm bảo dữ liệu được gửi trước khi đóng
         // Điều này đảm bảo message được flush trước khi close
         shutdown(fd, SHUT_WR);
@@ -153,11 +223,67 @@ void server_remove_client(server_t *server, int client_index) {
         server->clients[client_index].user_id = -1;
         server->clients[client_index].username[0] = '\0';
         server->clients[client_index].state = CLIENT_STATE_LOGGED_OUT;
+        server->clients[client_index].rx_len = 0;
+        server->clients[client_index].room_list_seq = 0;
+        server->clients[client_index].protocol_version = PROTOCOL_VERSION_LEGACY;
+        server->clients[client_index].caps = 0;
+
+        compress_ctx_t *compress = &server->clients[client_index].compress;
+        if (compress->messages > 0) {
+            printf("Client %d: da nen %u message, %llu -> %llu bytes\n", client_index, compress->messages,
+                   (unsigned long long)compress->raw_bytes, (unsigned long long)compress->wire_bytes);
+        }
+        compress_ctx_free(compress);
+
+        clocksync_t *clock = &server->clients[client_index].clock;
+        if (clock->samples > 0) {
+            printf("Client %d: RTT srtt=%ums min=%ums var=%ums, lech dong ho %lldms (%u mau, mat %u PING)\n",
+                   client_index, clock->srtt_ms, clock->min_rtt_ms, clock->rttvar_ms,
+                   (long long)clock->offset_ms, clock->samples, clock->lost);
+        }
+        clocksync_reset(clock);
+        timerheap_remove(&server->idle_timers, client_index);
         server->client_count--;
         printf("Client da ngat ket noi (index: %d)\n", client_index);
     }
 }
 
+// Them client vao tap dang xem sanh
+void server_lobby_subscribe(server_t *server, int client_index) {
+    if (!server || client_index < 0 || client_index >= MAX_CLIENTS) {
+        return;
+    }
+
+    client_t *client = &server->clients[client_index];
+    if (!client->active || client->lobby_slot >= 0) {
+        return;
+    }
+
+    client->lobby_slot = server->lobby_subscriber_count;
+    server->lobby_subscribers[server->lobby_subscriber_count++] = client_index;
+}
+
+// Xoa client khoi tap dang xem sanh (doi cho voi phan tu cuoi)
+void server_lobby_unsubscribe(server_t *server, int client_index) {
+    if (!server || client_index < 0 || client_index >= MAX_CLIENTS) {
+        return;
+    }
+
+    client_t *client = &server->clients[client_index];
+    int slot = client->lobby_slot;
+    if (slot < 0) {
+        return;
+    }
+
+    int last = --server->lobby_subscriber_count;
+    if (slot != last) {
+        int moved = server->lobby_subscribers[last];
+        server->lobby_subscribers[slot] = moved;
+        server->clients[moved].lobby_slot = slot;
+    }
+    client->lobby_slot = -1;
+}
+
 // Chap nhan ket noi moi
 int server_accept_client(server_t *server) {
     struct sockaddr_in client_addr;
@@ -177,30 +303,65 @@ int server_accept_client(server_t *server) {
 }
 
 // Xu ly du lieu tu client
+// TCP la stream: mot lan recv() co the chua nhieu frame hoac chi mot phan frame,
+// nen du lieu duoc gom vao rx_buf cua client va tach thanh tung frame hoan chinh
 void server_handle_client_data(server_t *server, int client_index) {
-    uint8_t buffer[BUFFER_SIZE];
-    int client_fd = server->clients[client_index].fd;
+    client_t *client = &server->clients[client_index];
+    int client_fd = client->fd;
     
-    ssize_t bytes_read = recv(client_fd, buffer, BUFFER_SIZE, 0);
+    ssize_t bytes_read = recv(client_fd, client->rx_buf + client->rx_len,
+                              sizeof(client->rx_buf) - client->rx_len, 0);
     
     if (bytes_read <= 0) {
         // Loi hoac ket noi dong
         server_handle_disconnect(server, client_index);
         return;
     }
+    client->rx_len += (size_t)bytes_read;
+    client->last_activity_ms = utils_now_ms(); // Idle timer doi han khi het han (khong cap nhat heap moi lan nhan)
     
-    // Parse message
-    message_t msg;
-    if (protocol_parse_message(buffer, bytes_read, &msg) == 0) {
-        // Xu ly message
-        protocol_handle_message(server, client_index, &msg);
+    size_t offset = 0;
+    while (offset < client->rx_len) {
+        size_t frame_len = 0;
+        int status = protocol_peek_frame(client->rx_buf + offset, client->rx_len - offset, &frame_len);
+        if (status < 0 || (status == 0 && frame_len > sizeof(client->rx_buf))) {
+            // Header hong hoac frame lon hon buffer nhan: khong the dong bo lai stream
+            fprintf(stderr, "Loi framing tu client %d (frame %zu bytes), ngat ket noi\n",
+                    client_index, frame_len);
+            server_handle_disconnect(server, client_index);
+            return;
+        }
+        if (status == 0) {
+            break; // Chua du du lieu, cho lan recv tiep theo
+        }
         
-        // Giai phong payload
-        if (msg.payload) {
-            free(msg.payload);
+        // Parse message
+        message_t msg;
+        if (protocol_parse_message(client->rx_buf + offset, frame_len, &msg) == 0) {
+            // Ghi frame vao capture truoc khi dispatch (ke ca frame se bi rate limit)
+            capture_frame(client_index, msg.type, msg.payload, msg.length);
+            // Xu ly message
+            protocol_handle_message(server, client_index, &msg);
+            
+            // Giai phong payload
+            if (msg.payload) {
+                free(msg.payload);
+            }
+        } else {
+            fprintf(stderr, "Loi parse message tu client %d\n", client_index);
         }
-    } else {
-        fprintf(stderr, "Loi parse message tu client %d\n", client_index);
+        offset += frame_len;
+        
+        // Handler co the da ngat ket noi client nay (slot da bi xoa hoac tai su dung)
+        if (!client->active || client->fd != client_fd) {
+            return;
+        }
+    }
+    
+    // Giu lai phan frame chua tron o dau buffer
+    if (offset > 0) {
+        memmove(client->rx_buf, client->rx_buf + offset, client->rx_len - offset);
+        client->rx_len -= offset;
     }
 }
 
@@ -230,6 +391,18 @@ room_t* server_find_room_by_user(server_t* server, int user_id) {
 int server_broadcast_to_room(server_t* server, int room_id, uint8_t msg_type, 
                              const uint8_t* payload, uint16_t payload_len, 
                              int exclude_user_id) {
+    return server_broadcast_to_room_by_cap(server, room_id, msg_type, 0, NULL, 0,
+                                           payload, payload_len, exclude_user_id);
+}
+
+/**
+ * Broadcast message den tat ca clients trong phong
+ * Client co capability cap nhan cap_payload, client con lai nhan payload
+ */
+int server_broadcast_to_room_by_cap(server_t* server, int room_id, uint8_t msg_type, uint32_t cap,
+                                    const uint8_t* cap_payload, uint16_t cap_len,
+                                    const uint8_t* payload, uint16_t payload_len,
+                                    int exclude_user_id) {
     if (!server || room_id <= 0) {
         return -1;
     }
@@ -265,12 +438,16 @@ int server_broadcast_to_room(server_t* server, int room_id, uint8_t msg_type,
 
         // Kiem tra client co trong phong khong
         if (room_has_player(room, client->user_id)) {
-            if (protocol_send_message(client->fd, msg_type, payload, payload_len) == 0) {
+            int result = (cap && cap_payload && CLIENT_HAS_CAP(client, cap))
+                ? protocol_send_client_message(client, msg_type, cap_payload, cap_len)
+                : protocol_send_client_message(client, msg_type, payload, payload_len);
+            if (result == 0) {
                 sent_count++;
             }
         }
     }
 
+    metrics_record_broadcast(sent_count);
     printf("Da broadcast message type 0x%02X den phong '%s' (ID: %d) - %d clients nhan duoc\n",
            msg_type, room->room_name, room_id, sent_count);
     
@@ -427,9 +604,76 @@ void server_handle_disconnect(server_t *server, int client_index) {
     server_remove_client(server, client_index);
 }
 
+// Ngat client CAP_PING khong gui gi (ke ca PONG) trong idle_timeout_ms
+// Timer chi doi han khi het han: client con hoat dong duoc dat lai theo last_activity_ms
+static void server_reap_idle_clients(server_t *server, uint64_t now_ms) {
+    uint32_t timeout = server->config.idle_timeout_ms;
+    int client_index;
+    while ((client_index = timerheap_pop_expired(&server->idle_timers, now_ms)) >= 0) {
+        client_t *client = &server->clients[client_index];
+        if (!client->active || timeout == 0 || !CLIENT_HAS_CAP(client, CAP_PING)) {
+            continue; // Client cu khong tra PONG: van dua vao TCP keepalive
+        }
+
+        uint64_t deadline = client->last_activity_ms + timeout;
+        if (deadline > now_ms) {
+            timerheap_set(&server->idle_timers, client_index, deadline);
+            continue;
+        }
+
+        server->idle_reaped++;
+        printf("Client %d (user_id=%d) im lang %llums, ngat ket noi (idle timeout)\n", client_index,
+               client->user_id, (unsigned long long)(now_ms - client->last_activity_ms));
+        server_handle_disconnect(server, client_index);
+    }
+}
+
+// Tick dinh ky (goi sau khi doc du lieu client trong moi vong lap)
+void server_tick(server_t *server, uint64_t now_ms) {
+    // Ngat ket noi nua mo truoc khi tick game: giai phong ghe va ket thuc round cua drawer da mat
+    server_reap_idle_clients(server, now_ms);
+    for (int r = 0; r < MAX_ROOMS; r++) {
+        room_t* room = server->rooms[r];
+        if (!room || room->state != ROOM_PLAYING || !room->game) continue;
+
+        // giu lai word truoc khi game_end_round reset state
+        char word_before[64];
+        snprintf(word_before, sizeof(word_before), "%s", room->game->current_word);
+
+        if (word_before[0] == '\0') continue;
+
+        if (game_check_timeout(room->game, now_ms)) {
+            // broadcast round_end + next round/game end
+            protocol_handle_round_timeout(server, room, word_before);
+        }
+    }
+
+    // Đồng bộ đồng hồ round mỗi 1 giây (client CAP_ROUND_DEADLINE chỉ nhận resync thưa)
+    if (now_ms - last_timer_update_ms >= 1000) {
+        for (int r = 0; r < MAX_ROOMS; r++) {
+            room_t* room = server->rooms[r];
+            if (room && room->state == ROOM_PLAYING && room->game) {
+                protocol_broadcast_timer_update(server, room, now_ms);
+            }
+        }
+        last_timer_update_ms = now_ms;
+
+        // PING client CAP_PING den han (do RTT/lech dong ho)
+        protocol_ping_clients(server, now_ms);
+    }
+}
+
 // Xu ly vong lap su kien voi select()
 void server_event_loop(server_t *server) {
     while (1) {
+        // In metrics (SIGUSR2) / flight recorder (SIGUSR1) theo yeu cau, ngoai signal handler
+        if (metrics_take_dump_request()) {
+            metrics_dump(stdout, protocol_message_name);
+        }
+        if (stall_take_dump_request()) {
+            stall_dump(stdout, protocol_message_name);
+        }
+
         // Khoi tao tap hop file descriptor
         FD_ZERO(&server->read_fds);
         
@@ -447,17 +691,30 @@ void server_event_loop(server_t *server) {
             }
         }
         
+        // Endpoint metrics: socket nghe + scraper (cho ghi khi con response chua gui het)
+        fd_set write_fds;
+        FD_ZERO(&write_fds);
+        metrics_http_fill_fds(&server->metrics_http, &server->read_fds, &write_fds, &server->max_fd);
+        
         // Su dung select() de cho su kien
-        // Co timeout de tick game timeout (Phase 5 - #19)
+        // Co timeout de tick game timeout (Phase 5 - #19), thuc day dung luc round het gio
         struct timeval tv;
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
-        int activity = select(server->max_fd + 1, &server->read_fds, NULL, NULL, &tv);
+        next_tick_timeout(server, utils_now_ms(), &tv);
+        int activity = select(server->max_fd + 1, &server->read_fds, &write_fds, NULL, &tv);
         
         if (activity < 0) {
+            if (errno == EINTR) {
+                continue; // Bi tin hieu (SIGUSR1/SIGUSR2) danh thuc, yeu cau in xu ly o dau vong lap
+            }
             perror("select() failed");
             break;
         }
+        // Moc do vong lap: thoi gian tung pha + DB/message phat sinh (stall detector)
+        uint64_t loop_start_ns = utils_now_ns();
+        const metrics_t *loop_metrics = metrics_get();
+        uint64_t loop_db_queries = loop_metrics->db_queries;
+        uint64_t loop_db_ns = loop_metrics->db_latency.sum_ns;
+        uint64_t loop_dispatched = loop_metrics->dispatched;
         
         // Kiem tra ket noi moi tu server socket
         if (FD_ISSET(server->socket_fd, &server->read_fds)) {
@@ -471,43 +728,47 @@ void server_event_loop(server_t *server) {
             }
         }
 
+        uint64_t clients_done_ns = utils_now_ns();
+
         // Tick: kiem tra timeout cho tat ca phong dang choi
-        time_t now = time(NULL);
-        for (int r = 0; r < MAX_ROOMS; r++) {
-            room_t* room = server->rooms[r];
-            if (!room || room->state != ROOM_PLAYING || !room->game) continue;
+        uint64_t now_ms = utils_now_ms();
+        server_tick(server, now_ms);
 
-            // giu lai word truoc khi game_end_round reset state
-            char word_before[64];
-            memset(word_before, 0, sizeof(word_before));
-            strncpy(word_before, room->game->current_word, sizeof(word_before) - 1);
+        uint64_t tick_done_ns = utils_now_ns();
 
-            if (word_before[0] == '\0') continue;
+        // Day thay doi danh sach phong trong vong lap nay (join/leave/start/end) xuong lobby
+        protocol_broadcast_room_list(server);
 
-            if (game_check_timeout(room->game)) {
-                // broadcast round_end + next round/game end
-                protocol_handle_round_timeout(server, room, word_before);
-            }
-        }
+        // Commit ghi dang gom cua backend (SQLite) khi den han
+        storage_flush();
 
-        // Gửi timer update mỗi 1 giây cho tất cả phòng đang chơi
-        if (now - last_timer_update >= 1) {
-            extern int protocol_broadcast_timer_update(server_t* server, room_t* room);
-            for (int r = 0; r < MAX_ROOMS; r++) {
-                room_t* room = server->rooms[r];
-                if (room && room->state == ROOM_PLAYING && room->game) {
-                    protocol_broadcast_timer_update(server, room);
-                }
+        // Ping database mỗi 5 phút để giữ connection sống
+        if (now_ms - last_db_ping_ms > 300000) { // 5 phút = 300 giây
+            if (storage_available()) {
+                storage_ping();
+                last_db_ping_ms = now_ms;
             }
-            last_timer_update = now;
         }
 
-        // Ping database mỗi 5 phút để giữ connection sống
-        if (now - last_db_ping > 300) { // 5 phút = 300 giây
-            if (db && db->conn) {
-                mysql_ping(db->conn);
-                last_db_ping = now;
-            }
+        // Scrape metrics cuoi vong lap: so lieu phan anh vong lap nay
+        metrics_http_handle(&server->metrics_http, server, &server->read_fds, &write_fds, now_ms);
+
+        uint64_t loop_end_ns = utils_now_ns();
+        metrics_record_loop(loop_end_ns - loop_start_ns);
+        if (stall_exceeds(loop_end_ns - loop_start_ns)) {
+            stall_record_t record = {
+                .kind = STALL_KIND_LOOP,
+                .duration_ns = loop_end_ns - loop_start_ns,
+                .db_queries = (uint32_t)(loop_metrics->db_queries - loop_db_queries),
+                .db_ns = loop_metrics->db_latency.sum_ns - loop_db_ns,
+                .messages = (uint32_t)(loop_metrics->dispatched - loop_dispatched),
+                .phase_ns = {
+                    [STALL_PHASE_CLIENTS] = clients_done_ns - loop_start_ns,
+                    [STALL_PHASE_TICK] = tick_done_ns - clients_done_ns,
+                    [STALL_PHASE_LOBBY] = loop_end_ns - tick_done_ns,
+                },
+            };
+            stall_push(&record);
         }
     }
 }
@@ -525,6 +786,17 @@ void server_cleanup(server_t *server) {
     if (server->socket_fd >= 0) {
         close(server->socket_fd);
     }
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        compress_ctx_free(&server->clients[i].compress);
+    }
+
+    metrics_http_close(&server->metrics_http);
+    capture_stop();
+    timerheap_free(&server->idle_timers);
+    free(server->room_list_cache.frame);
+    free(server->room_list_cache.zframe);
+    memset(&server->room_list_cache, 0, sizeof(server->room_list_cache));
     
     printf("Server da dong\n");
 }
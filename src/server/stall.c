@@ -0,0 +1,128 @@
+#include "../include/stall.h"
+#include "../include/utils.h"
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+static stall_record_t ring[STALL_RING_SIZE];
+static uint64_t ring_total = 0;     // Ban ghi tiep theo nam o ring[ring_total % STALL_RING_SIZE]
+static uint64_t threshold_ns = (uint64_t)STALL_DEFAULT_THRESHOLD_MS * 1000000u;
+
+static volatile sig_atomic_t dump_requested = 0;
+
+static const char *phase_names[STALL_PHASE_COUNT] = {"clients", "tick", "lobby"};
+
+void stall_configure(uint32_t threshold_ms)
+{
+    threshold_ns = (uint64_t)threshold_ms * 1000000u;
+}
+
+int stall_exceeds(uint64_t elapsed_ns)
+{
+    return threshold_ns > 0 && elapsed_ns >= threshold_ns;
+}
+
+void stall_push(const stall_record_t *record)
+{
+    stall_record_t *slot = &ring[ring_total % STALL_RING_SIZE];
+    *slot = *record;
+    slot->seq = ++ring_total;
+    slot->wall_ms = utils_wall_ms();
+}
+
+int stall_snapshot(stall_record_t *out, int max)
+{
+    int count = 0;
+    uint64_t available = ring_total < STALL_RING_SIZE ? ring_total : STALL_RING_SIZE;
+    for (uint64_t i = 0; i < available && count < max; i++)
+    {
+        out[count++] = ring[(ring_total - 1 - i) % STALL_RING_SIZE];
+    }
+    return count;
+}
+
+uint64_t stall_total(void)
+{
+    return ring_total;
+}
+
+void stall_reset(void)
+{
+    memset(ring, 0, sizeof(ring));
+    ring_total = 0;
+}
+
+static void format_wall(uint64_t wall_ms, char *out, size_t size)
+{
+    time_t seconds = (time_t)(wall_ms / 1000);
+    struct tm tm_local;
+    localtime_r(&seconds, &tm_local);
+    size_t n = strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm_local);
+    snprintf(out + n, size - n, ".%03u", (unsigned)(wall_ms % 1000));
+}
+
+void stall_write_text(metrics_text_t *text, const char *(*type_name)(uint8_t type))
+{
+    uint64_t kept = ring_total < STALL_RING_SIZE ? ring_total : STALL_RING_SIZE;
+    metrics_text_appendf(text, "=== Stall (nguong %.1fms): %llu ban ghi, giu %llu moi nhat ===\n",
+                         (double)threshold_ns / 1e6, (unsigned long long)ring_total, (unsigned long long)kept);
+
+    for (uint64_t i = 0; i < kept; i++)
+    {
+        const stall_record_t *r = &ring[(ring_total - 1 - i) % STALL_RING_SIZE];
+        char when[40];
+        format_wall(r->wall_ms, when, sizeof(when));
+
+        if (r->kind == STALL_KIND_MESSAGE)
+        {
+            const char *name = type_name ? type_name(r->msg_type) : NULL;
+            metrics_text_appendf(text,
+                                 "#%llu %s message 0x%02X %s %.3fms client=%d user=%d room=%d payload=%u db=%u (%.3fms)\n",
+                                 (unsigned long long)r->seq, when, r->msg_type, name ? name : "-",
+                                 (double)r->duration_ns / 1e6, r->client_index, r->user_id, r->room_id,
+                                 r->payload_len, r->db_queries, (double)r->db_ns / 1e6);
+        }
+        else
+        {
+            metrics_text_appendf(text, "#%llu %s loop %.3fms messages=%u db=%u (%.3fms)",
+                                 (unsigned long long)r->seq, when, (double)r->duration_ns / 1e6,
+                                 r->messages, r->db_queries, (double)r->db_ns / 1e6);
+            for (int p = 0; p < STALL_PHASE_COUNT; p++)
+            {
+                metrics_text_appendf(text, " %s=%.3fms", phase_names[p], (double)r->phase_ns[p] / 1e6);
+            }
+            metrics_text_appendf(text, "\n");
+        }
+    }
+}
+
+void stall_request_dump(void)
+{
+    dump_requested = 1;
+}
+
+int stall_take_dump_request(void)
+{
+    if (!dump_requested)
+    {
+        return 0;
+    }
+    dump_requested = 0;
+    return 1;
+}
+
+void stall_dump(FILE *out, const char *(*type_name)(uint8_t type))
+{
+    if (!out)
+    {
+        return;
+    }
+    metrics_text_t text = {0};
+    stall_write_text(&text, type_name);
+    if (text.data)
+    {
+        fputs(text.data, out);
+    }
+    fflush(out);
+    metrics_text_free(&text);
+}
@@ -0,0 +1,571 @@
+#include "../include/storage.h"
+#include "../include/journal.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#define JOURNAL_RETRY_MS        5000    // Khoang cach ping lai backend khi dang mat ket noi
+#define JOURNAL_REPLAY_BUDGET_NS (5 * 1000 * 1000ULL)   // Thoi gian phat lai toi da moi vong lap su kien
+
+// Cac backend chon duoc bang --storage=NAME
+static const storage_backend_t *const backends[] = {
+    &storage_mysql_backend,
+    &storage_memory_backend,
+    &storage_sqlite_backend,
+};
+
+static const storage_backend_t *backend = NULL;
+static void *backend_ctx = NULL;
+
+// ============================================
+// Journal: ghi khong can id tra ve (doan, diem, chat, lich su, trang thai)
+// ============================================
+
+// Cac ghi nay chi tham chieu id da co trong DB nen co the hoan lai. Ghi tao ban ghi moi
+// (phong, nguoi choi, round) van goi thang backend vi caller can id ngay.
+typedef enum {
+    EVENT_SAVE_GUESS = 1,
+    EVENT_SAVE_SCORE_DETAIL,
+    EVENT_SAVE_CHAT_MESSAGE,
+    EVENT_SAVE_GAME_HISTORY,
+    EVENT_SET_ROOM_STATUS,
+    EVENT_UPDATE_ROOM_PLAYER_SCORE,
+    EVENT_UPDATE_USER_STATS
+} storage_event_op_t;
+
+typedef struct {
+    storage_event_op_t op;
+    int args[4];
+    const char *text;               // NULL neu op khong co chuoi
+} storage_event_t;
+
+// Ban ghi: [op:1][args: 4 x int32 BE][text_len:2 BE][text]
+#define EVENT_HEADER_SIZE       19
+#define EVENT_MAX_TEXT          (JOURNAL_MAX_PAYLOAD - EVENT_HEADER_SIZE)
+
+static int backend_down = 0;        // 1 sau khi mot ghi that bai va ping cung that bai
+static uint64_t next_retry_ms = 0;
+
+static int event_apply(const storage_event_t *ev)
+{
+    const int *a = ev->args;
+    switch (ev->op)
+    {
+    case EVENT_SAVE_GUESS:
+        return backend->save_guess(backend_ctx, a[0], a[1], ev->text, a[2]);
+    case EVENT_SAVE_SCORE_DETAIL:
+        return backend->save_score_detail(backend_ctx, a[0], a[1], a[2]);
+    case EVENT_SAVE_CHAT_MESSAGE:
+        return backend->save_chat_message(backend_ctx, a[0], a[1], ev->text);
+    case EVENT_SAVE_GAME_HISTORY:
+        return backend->save_game_history(backend_ctx, a[0], a[1], a[2]);
+    case EVENT_SET_ROOM_STATUS:
+        return backend->set_room_status(backend_ctx, a[0], ev->text);
+    case EVENT_UPDATE_ROOM_PLAYER_SCORE:
+        return backend->update_room_player_score(backend_ctx, a[0], a[1]);
+    case EVENT_UPDATE_USER_STATS:
+        return backend->update_user_stats(backend_ctx, a[0], a[1], a[2]);
+    }
+    return -1;
+}
+
+// save_game_history tra ve 1/0, cac ham khac id/0 hoac -1
+static int event_failed(const storage_event_t *ev, int result)
+{
+    return ev->op == EVENT_SAVE_GAME_HISTORY ? result != 1 : result < 0;
+}
+
+static int event_failure_result(const storage_event_t *ev)
+{
+    return ev->op == EVENT_SAVE_GAME_HISTORY ? 0 : -1;
+}
+
+// Ket qua bao cho caller khi su kien nam trong journal (khong co id)
+static int event_deferred_result(const storage_event_t *ev)
+{
+    return ev->op == EVENT_SAVE_GAME_HISTORY ? 1 : 0;
+}
+
+static int event_journal(const storage_event_t *ev)
+{
+    uint8_t record[JOURNAL_MAX_PAYLOAD];
+    size_t text_len = ev->text ? strlen(ev->text) : 0;
+    if (text_len > EVENT_MAX_TEXT)
+    {
+        text_len = EVENT_MAX_TEXT;
+    }
+    record[0] = (uint8_t)ev->op;
+    for (int i = 0; i < 4; i++)
+    {
+        uint32_t v = (uint32_t)ev->args[i];
+        record[1 + 4 * i] = (uint8_t)(v >> 24);
+        record[2 + 4 * i] = (uint8_t)(v >> 16);
+        record[3 + 4 * i] = (uint8_t)(v >> 8);
+        record[4 + 4 * i] = (uint8_t)v;
+    }
+    record[17] = (uint8_t)(text_len >> 8);
+    record[18] = (uint8_t)text_len;
+    memcpy(record + EVENT_HEADER_SIZE, ev->text ? ev->text : "", text_len);
+    if (journal_append(record, (uint32_t)(EVENT_HEADER_SIZE + text_len)) != 0)
+    {
+        return event_failure_result(ev);
+    }
+    return event_deferred_result(ev);
+}
+
+// Backend co ping (MySQL) moi co the mat ket noi; backend cuc bo khong bao gio vao journal
+static int backend_reachable(void)
+{
+    return !backend->ping || backend->ping(backend_ctx) == 0;
+}
+
+// Trong luc mat ket noi cac thao tac khong vao journal duoc tra loi ngay: moi query se thu
+// ket noi lai (chan vong lap den timeout), chi journal_drain moi JOURNAL_RETRY_MS tham do
+static int backend_usable(void)
+{
+    return backend && !backend_down;
+}
+
+static void mark_backend_down(void)
+{
+    if (!backend_down)
+    {
+        fprintf(stderr, "Storage: mat ket noi %s, ghi vao journal cho den khi ket noi lai\n", backend->name);
+    }
+    backend_down = 1;
+    next_retry_ms = utils_now_ms() + JOURNAL_RETRY_MS;
+}
+
+static int event_write(const storage_event_t *ev)
+{
+    if (!backend)
+    {
+        return event_failure_result(ev);
+    }
+    // Dang mat ket noi hoac con su kien cu chua phat lai: vao journal de giu thu tu
+    if (journal_active() && (backend_down || journal_pending() > 0))
+    {
+        return event_journal(ev);
+    }
+    int result = event_apply(ev);
+    if (event_failed(ev, result) && journal_active() && !backend_reachable())
+    {
+        mark_backend_down();
+        return event_journal(ev);
+    }
+    return result;
+}
+
+// Tra ve 0 neu da xu ly (ke ca bo ban ghi bi tu choi vinh vien), -1 de dung va thu lai sau
+static int replay_record(const uint8_t *payload, uint32_t len, void *arg)
+{
+    (void)arg;
+    char text[EVENT_MAX_TEXT + 1];
+    storage_event_t ev = {0};
+    size_t text_len = len >= EVENT_HEADER_SIZE ? ((size_t)payload[17] << 8) | payload[18] : 0;
+    if (len < EVENT_HEADER_SIZE || text_len != len - EVENT_HEADER_SIZE ||
+        payload[0] < EVENT_SAVE_GUESS || payload[0] > EVENT_UPDATE_USER_STATS)
+    {
+        fprintf(stderr, "Storage journal: bo ban ghi khong hop le (%u byte)\n", len);
+        return 0;
+    }
+    ev.op = (storage_event_op_t)payload[0];
+    for (int i = 0; i < 4; i++)
+    {
+        const uint8_t *p = payload + 1 + 4 * i;
+        ev.args[i] = (int)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+    }
+    memcpy(text, payload + EVENT_HEADER_SIZE, text_len);
+    text[text_len] = '\0';
+    ev.text = text;
+
+    if (!event_failed(&ev, event_apply(&ev)))
+    {
+        return 0;
+    }
+    if (!backend_reachable())
+    {
+        mark_backend_down();
+        return -1;
+    }
+    // Backend song nhung tu choi (vd khoa ngoai): thu lai cung khong thanh cong
+    fprintf(stderr, "Storage journal: backend tu choi su kien op=%d, bo qua\n", ev.op);
+    return 0;
+}
+
+static void journal_drain(void)
+{
+    if (journal_pending() == 0)
+    {
+        backend_down = 0;
+        return;
+    }
+    if (backend_down)
+    {
+        uint64_t now_ms = utils_now_ms();
+        if (now_ms < next_retry_ms)
+        {
+            return;
+        }
+        if (!backend_reachable())
+        {
+            next_retry_ms = now_ms + JOURNAL_RETRY_MS;
+            return;
+        }
+        backend_down = 0;
+        printf("Storage: da ket noi lai %s, phat lai %llu su kien tu journal\n", backend->name,
+               (unsigned long long)journal_pending());
+    }
+    journal_replay(replay_record, NULL, JOURNAL_REPLAY_BUDGET_NS);
+    if (journal_pending() == 0)
+    {
+        printf("Storage: journal da phat lai xong\n");
+    }
+}
+
+static void str_trim_inplace(char *s)
+{
+    size_t len = strlen(s);
+    size_t start = 0;
+    while (start < len && isspace((unsigned char)s[start]))
+    {
+        start++;
+    }
+    size_t end = len;
+    while (end > start && isspace((unsigned char)s[end - 1]))
+    {
+        end--;
+    }
+    if (start > 0)
+    {
+        memmove(s, s + start, end - start);
+    }
+    s[end - start] = '\0';
+}
+
+int storage_difficulty_is_valid(const char *difficulty)
+{
+    if (!difficulty)
+    {
+        return 0;
+    }
+    return strcmp(difficulty, "easy") == 0 || strcmp(difficulty, "medium") == 0 || strcmp(difficulty, "hard") == 0;
+}
+
+int storage_parse_word_line(char *line, char **word, char **difficulty, char **category)
+{
+    line[strcspn(line, "\r\n")] = '\0';
+    str_trim_inplace(line);
+    if (line[0] == '\0' || line[0] == '#')
+    {
+        return 0;
+    }
+
+    char *w = line;
+    char *diff = strchr(w, '|');
+    char *cat = NULL;
+    if (diff)
+    {
+        *diff++ = '\0';
+        cat = strchr(diff, '|');
+        if (cat)
+        {
+            *cat++ = '\0';
+        }
+        str_trim_inplace(diff);
+    }
+    if (cat)
+    {
+        str_trim_inplace(cat);
+    }
+    str_trim_inplace(w);
+
+    if (w[0] == '\0')
+    {
+        return 0;
+    }
+    if (!diff || !storage_difficulty_is_valid(diff))
+    {
+        diff = "medium";
+    }
+    if (!cat || cat[0] == '\0')
+    {
+        cat = "general";
+    }
+    *word = w;
+    *difficulty = diff;
+    *category = cat;
+    return 1;
+}
+
+int storage_open(const char *spec)
+{
+    if (!spec || spec[0] == '\0')
+    {
+        fprintf(stderr, "storage_open: thieu ten backend\n");
+        return -1;
+    }
+
+    // "name:arg": arg (duong dan file...) chuyen nguyen cho backend
+    const char *colon = strchr(spec, ':');
+    size_t name_len = colon ? (size_t)(colon - spec) : strlen(spec);
+    const char *arg = colon ? colon + 1 : NULL;
+
+    const storage_backend_t *found = NULL;
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++)
+    {
+        if (strlen(backends[i]->name) == name_len && strncmp(backends[i]->name, spec, name_len) == 0)
+        {
+            found = backends[i];
+            break;
+        }
+    }
+    if (!found)
+    {
+        fprintf(stderr, "storage_open: backend khong ho tro: %.*s\n", (int)name_len, spec);
+        return -1;
+    }
+
+    storage_close();
+    void *ctx = found->open(arg);
+    if (!ctx)
+    {
+        return -1;
+    }
+    backend = found;
+    backend_ctx = ctx;
+    return 0;
+}
+
+uint64_t storage_next_deadline_ms(void)
+{
+    if (!backend || !backend->next_deadline_ms)
+    {
+        return 0;
+    }
+    return backend->next_deadline_ms(backend_ctx);
+}
+
+int storage_journal_open(const char *path)
+{
+    if (!backend)
+    {
+        return -1;
+    }
+    if (!backend->ping)
+    {
+        // Backend cuc bo khong mat ket noi; journal cu cua MySQL cung khong ap dung duoc vao day
+        return 0;
+    }
+    if (journal_open(path) != 0)
+    {
+        return -1;
+    }
+    printf("Storage journal: %s (%llu su kien cho phat lai)\n", path, (unsigned long long)journal_pending());
+    if (journal_pending() > 0)
+    {
+        // Hoi backend ngay thay vi mac dinh la mat ket noi: backend song thi doc/ghi dung binh
+        // thuong, su kien cu phat lai tu storage_flush() va ghi moi xep sau chung
+        if (backend_reachable())
+        {
+            backend_down = 0;
+        }
+        else
+        {
+            mark_backend_down();
+        }
+    }
+    return 0;
+}
+
+uint64_t storage_journal_pending(void)
+{
+    return journal_pending();
+}
+
+void storage_close(void)
+{
+    journal_close();
+    backend_down = 0;
+    if (backend)
+    {
+        backend->close(backend_ctx);
+    }
+    backend = NULL;
+    backend_ctx = NULL;
+}
+
+int storage_available(void)
+{
+    return backend != NULL;
+}
+
+const char *storage_backend_name(void)
+{
+    return backend ? backend->name : "none";
+}
+
+int storage_ping(void)
+{
+    if (!backend || !backend->ping)
+    {
+        return 0;
+    }
+    if (backend_down)
+    {
+        return -1;
+    }
+    return backend->ping(backend_ctx);
+}
+
+int storage_flush(void)
+{
+    if (!backend)
+    {
+        return 0;
+    }
+    int rc = backend->flush ? backend->flush(backend_ctx) : 0;
+    if (journal_active())
+    {
+        // Mot lan write + fdatasync cho moi su kien vao journal trong vong lap nay
+        if (journal_flush() != 0)
+        {
+            rc = -1;
+        }
+        journal_drain();
+    }
+    return rc;
+}
+
+int storage_register_user(const char *username, const char *password_hash)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->register_user(backend_ctx, username, password_hash);
+}
+
+int storage_authenticate_user(const char *username, const char *password_hash)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->authenticate_user(backend_ctx, username, password_hash);
+}
+
+int storage_change_password(int user_id, const char *old_password_hash, const char *new_password_hash)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->change_password(backend_ctx, user_id, old_password_hash, new_password_hash);
+}
+
+int storage_update_user_stats(int user_id, int score, int is_win)
+{
+    storage_event_t ev = {EVENT_UPDATE_USER_STATS, {user_id, score, is_win, 0}, NULL};
+    return event_write(&ev);
+}
+
+int storage_load_words_from_file(const char *filepath)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->load_words_from_file(backend_ctx, filepath);
+}
+
+int storage_get_random_word(const char *difficulty, char *out_word, size_t out_word_size)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->get_random_word(backend_ctx, difficulty, out_word, out_word_size);
+}
+
+int storage_get_all_words_by_difficulty(const char *difficulty, char words[][64], char categories[][64], int max_words)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->get_all_words_by_difficulty(backend_ctx, difficulty, words, categories, max_words);
+}
+
+int storage_create_room(const char *room_code, int host_id, int max_players, int total_rounds)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->create_room(backend_ctx, room_code, host_id, max_players, total_rounds);
+}
+
+int storage_set_room_status(int db_room_id, const char *status)
+{
+    storage_event_t ev = {EVENT_SET_ROOM_STATUS, {db_room_id, 0, 0, 0}, status};
+    return event_write(&ev);
+}
+
+int storage_add_room_player(int db_room_id, int user_id, int join_order)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->add_room_player(backend_ctx, db_room_id, user_id, join_order);
+}
+
+int storage_update_room_player_score(int player_db_id, int score)
+{
+    storage_event_t ev = {EVENT_UPDATE_ROOM_PLAYER_SCORE, {player_db_id, score, 0, 0}, NULL};
+    return event_write(&ev);
+}
+
+int storage_create_game_round(int db_room_id, int round_number, int turn_index, int draw_player_db_id, const char *word)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->create_game_round(backend_ctx, db_room_id, round_number, turn_index, draw_player_db_id, word);
+}
+
+int storage_save_guess(int db_round_id, int player_db_id, const char *guess_text, int is_correct)
+{
+    storage_event_t ev = {EVENT_SAVE_GUESS, {db_round_id, player_db_id, is_correct ? 1 : 0, 0}, guess_text};
+    return event_write(&ev);
+}
+
+int storage_save_score_detail(int db_round_id, int player_db_id, int score)
+{
+    storage_event_t ev = {EVENT_SAVE_SCORE_DETAIL, {db_round_id, player_db_id, score, 0}, NULL};
+    return event_write(&ev);
+}
+
+int storage_save_chat_message(int db_room_id, int player_db_id, const char *message_text)
+{
+    storage_event_t ev = {EVENT_SAVE_CHAT_MESSAGE, {db_room_id, player_db_id, 0, 0}, message_text};
+    return event_write(&ev);
+}
+
+int storage_save_game_history(int user_id, int score, int rank)
+{
+    storage_event_t ev = {EVENT_SAVE_GAME_HISTORY, {user_id, score, rank, 0}, NULL};
+    return event_write(&ev);
+}
+
+int storage_get_game_history(int user_id, game_history_entry_t *entries, int max_entries)
+{
+    if (!backend_usable())
+    {
+        return -1;
+    }
+    return backend->get_game_history(backend_ctx, user_id, entries, max_entries);
+}
@@ -0,0 +1,682 @@
+#include "../include/storage.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+
+// Backend trong bo nho: cung bang va rang buoc voi database/schema.sql (ten duy nhat,
+// khoa ngoai toi users/rooms/room_players/game_rounds) nhung khong co I/O.
+// Id la vi tri trong bang + 1 (AUTO_INCREMENT, khong bao gio xoa dong). So sanh username/word
+// khong phan biet hoa thuong (ASCII) nhu collation mac dinh cua MySQL.
+// Bang chi ghi (rounds, guesses, score_details, chat) lon dan theo so van choi, giai phong khi dong.
+
+#define MEM_TABLE_INITIAL_CAPACITY  64
+
+// Do dai cot VARCHAR trong schema.sql (+1 cho '\0')
+#define MEM_USERNAME_SIZE   51
+#define MEM_HASH_SIZE       65
+#define MEM_WORD_SIZE       101
+#define MEM_CATEGORY_SIZE   51
+#define MEM_ROOM_CODE_SIZE  11
+#define MEM_STATUS_SIZE     12
+
+// Khoa tra cuu theo ten (username, word) luon la truong dau tien cua dong
+typedef struct
+{
+    char username[MEM_USERNAME_SIZE];
+    char password_hash[MEM_HASH_SIZE];
+    int total_games;
+    int total_wins;
+    int total_score;
+    int last_history;               // Id game_history moi nhat cua user, 0 = chua co
+} mem_user_t;
+
+typedef struct
+{
+    char word[MEM_WORD_SIZE];
+    char difficulty[8];
+    char category[MEM_CATEGORY_SIZE];
+    int times_used;
+} mem_word_t;
+
+typedef struct
+{
+    char room_code[MEM_ROOM_CODE_SIZE];
+    int host_id;
+    int max_players;
+    int total_rounds;
+    char status[MEM_STATUS_SIZE];
+} mem_room_t;
+
+typedef struct
+{
+    int room_id;
+    int user_id;
+    int join_order;
+    int score;
+} mem_room_player_t;
+
+typedef struct
+{
+    int room_id;
+    int round_number;
+    int turn_index;
+    int draw_id;
+    char word[MEM_WORD_SIZE];
+} mem_round_t;
+
+typedef struct
+{
+    int round_id;
+    int player_id;
+    int is_correct;
+    char guess_text[MEM_WORD_SIZE];
+} mem_guess_t;
+
+typedef struct
+{
+    int round_id;
+    int player_id;
+    int score;
+} mem_score_detail_t;
+
+typedef struct
+{
+    int room_id;
+    int player_id;
+    char *message_text;             // strdup, do dai tuy tin nhan (toi da 500 nhu schema)
+} mem_chat_t;
+
+typedef struct
+{
+    int user_id;
+    int score;
+    int rank;
+    int prev;                       // Id ban ghi truoc cua cung user (danh sach moi nhat truoc)
+    char finished_at[32];
+} mem_history_t;
+
+// Mang dong cac dong cung kich thuoc
+typedef struct
+{
+    uint8_t *rows;
+    size_t row_size;
+    int count;
+    int capacity;
+} mem_table_t;
+
+// Bang bam dia chi mo: slot chua id dong (0 = trong), khoa la chuoi dau dong
+typedef struct
+{
+    int *slots;
+    size_t mask;
+} mem_index_t;
+
+typedef struct
+{
+    mem_table_t users;
+    mem_table_t words;
+    mem_table_t rooms;
+    mem_table_t room_players;
+    mem_table_t rounds;
+    mem_table_t guesses;
+    mem_table_t score_details;
+    mem_table_t chat;
+    mem_table_t history;
+    mem_index_t user_index;
+    mem_index_t word_index;
+} mem_store_t;
+
+static void table_init(mem_table_t *t, size_t row_size)
+{
+    t->rows = NULL;
+    t->row_size = row_size;
+    t->count = 0;
+    t->capacity = 0;
+}
+
+static void *table_row(const mem_table_t *t, int id)
+{
+    if (id <= 0 || id > t->count)
+    {
+        return NULL;
+    }
+    return t->rows + (size_t)(id - 1) * t->row_size;
+}
+
+// Them dong moi (da xoa 0), tra ve id hoac -1 neu het bo nho
+static int table_append(mem_table_t *t)
+{
+    if (t->count == t->capacity)
+    {
+        int capacity = t->capacity ? t->capacity * 2 : MEM_TABLE_INITIAL_CAPACITY;
+        uint8_t *rows = (uint8_t *)realloc(t->rows, (size_t)capacity * t->row_size);
+        if (!rows)
+        {
+            fprintf(stderr, "storage memory: khong the cap phat bang (%d dong)\n", capacity);
+            return -1;
+        }
+        t->rows = rows;
+        t->capacity = capacity;
+    }
+    t->count++;
+    memset(table_row(t, t->count), 0, t->row_size);
+    return t->count;
+}
+
+static uint32_t hash_key(const char *key)
+{
+    uint32_t hash = 2166136261u;
+    for (const char *p = key; *p; p++)
+    {
+        hash ^= (uint8_t)tolower((unsigned char)*p);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Id dong co khoa key, 0 neu khong co
+static int index_find(const mem_index_t *index, const mem_table_t *t, const char *key)
+{
+    if (!index->slots)
+    {
+        return 0;
+    }
+    for (size_t i = hash_key(key) & index->mask;; i = (i + 1) & index->mask)
+    {
+        int id = index->slots[i];
+        if (id == 0 || strcasecmp((const char *)table_row(t, id), key) == 0)
+        {
+            return id;
+        }
+    }
+}
+
+static void index_place(mem_index_t *index, const mem_table_t *t, int id)
+{
+    size_t i = hash_key((const char *)table_row(t, id)) & index->mask;
+    while (index->slots[i] != 0)
+    {
+        i = (i + 1) & index->mask;
+    }
+    index->slots[i] = id;
+}
+
+// Goi sau table_append: giu he so tai <= 1/2, xay lai ca bang khi gap doi
+static int index_add(mem_index_t *index, const mem_table_t *t, int id)
+{
+    size_t capacity = index->slots ? index->mask + 1 : 0;
+    if ((size_t)t->count * 2 > capacity)
+    {
+        size_t new_capacity = capacity ? capacity * 2 : MEM_TABLE_INITIAL_CAPACITY * 2;
+        int *slots = (int *)calloc(new_capacity, sizeof(int));
+        if (!slots)
+        {
+            fprintf(stderr, "storage memory: khong the cap phat chi muc\n");
+            return -1;
+        }
+        free(index->slots);
+        index->slots = slots;
+        index->mask = new_capacity - 1;
+        for (int other = 1; other < id; other++)
+        {
+            index_place(index, t, other);
+        }
+    }
+    index_place(index, t, id);
+    return 0;
+}
+
+static void *memory_open(const char *arg)
+{
+    (void)arg;
+    mem_store_t *store = (mem_store_t *)calloc(1, sizeof(mem_store_t));
+    if (!store)
+    {
+        fprintf(stderr, "storage memory: khong the cap phat\n");
+        return NULL;
+    }
+    table_init(&store->users, sizeof(mem_user_t));
+    table_init(&store->words, sizeof(mem_word_t));
+    table_init(&store->rooms, sizeof(mem_room_t));
+    table_init(&store->room_players, sizeof(mem_room_player_t));
+    table_init(&store->rounds, sizeof(mem_round_t));
+    table_init(&store->guesses, sizeof(mem_guess_t));
+    table_init(&store->score_details, sizeof(mem_score_detail_t));
+    table_init(&store->chat, sizeof(mem_chat_t));
+    table_init(&store->history, sizeof(mem_history_t));
+    return store;
+}
+
+static void memory_close(void *ctx)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    for (int id = 1; id <= store->chat.count; id++)
+    {
+        free(((mem_chat_t *)table_row(&store->chat, id))->message_text);
+    }
+    mem_table_t *tables[] = {&store->users, &store->words, &store->rooms, &store->room_players, &store->rounds,
+                             &store->guesses, &store->score_details, &store->chat, &store->history};
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++)
+    {
+        free(tables[i]->rows);
+    }
+    free(store->user_index.slots);
+    free(store->word_index.slots);
+    free(store);
+}
+
+static int memory_register_user(void *ctx, const char *username, const char *password_hash)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!username || !password_hash || strlen(username) >= MEM_USERNAME_SIZE ||
+        strlen(password_hash) >= MEM_HASH_SIZE)
+    {
+        return -1;
+    }
+    if (index_find(&store->user_index, &store->users, username))
+    {
+        return -1;
+    }
+    int id = table_append(&store->users);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, id);
+    strcpy(user->username, username);
+    strcpy(user->password_hash, password_hash);
+    if (index_add(&store->user_index, &store->users, id) != 0)
+    {
+        store->users.count--;
+        return -1;
+    }
+    return id;
+}
+
+static int memory_authenticate_user(void *ctx, const char *username, const char *password_hash)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!username || !password_hash)
+    {
+        return -1;
+    }
+    int id = index_find(&store->user_index, &store->users, username);
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, id);
+    if (!user || strcmp(user->password_hash, password_hash) != 0)
+    {
+        return -1;
+    }
+    return id;
+}
+
+static int memory_change_password(void *ctx, int user_id, const char *old_password_hash, const char *new_password_hash)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, user_id);
+    if (!user || !old_password_hash || !new_password_hash || strlen(new_password_hash) >= MEM_HASH_SIZE ||
+        strcmp(user->password_hash, old_password_hash) != 0)
+    {
+        return -1;
+    }
+    strcpy(user->password_hash, new_password_hash);
+    return 0;
+}
+
+static int memory_update_user_stats(void *ctx, int user_id, int score, int is_win)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, user_id);
+    if (!user)
+    {
+        return -1;
+    }
+    user->total_games++;
+    user->total_wins += is_win ? 1 : 0;
+    user->total_score += score;
+    return 0;
+}
+
+static int memory_load_words_from_file(void *ctx, const char *filepath)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!filepath)
+    {
+        return -1;
+    }
+    FILE *f = fopen(filepath, "r");
+    if (!f)
+    {
+        // Caller thu nhieu duong dan, tu in canh bao neu tat ca deu that bai
+        return -1;
+    }
+
+    char line[512];
+    int inserted = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        char *word;
+        char *difficulty;
+        char *category;
+        if (!storage_parse_word_line(line, &word, &difficulty, &category) || strlen(word) >= MEM_WORD_SIZE)
+        {
+            continue;
+        }
+
+        // Upsert theo word (ON DUPLICATE KEY UPDATE)
+        int id = index_find(&store->word_index, &store->words, word);
+        if (id == 0)
+        {
+            id = table_append(&store->words);
+            if (id < 0)
+            {
+                break;
+            }
+            strcpy(((mem_word_t *)table_row(&store->words, id))->word, word);
+            if (index_add(&store->word_index, &store->words, id) != 0)
+            {
+                store->words.count--;
+                break;
+            }
+        }
+        mem_word_t *entry = (mem_word_t *)table_row(&store->words, id);
+        snprintf(entry->difficulty, sizeof(entry->difficulty), "%s", difficulty);
+        snprintf(entry->category, sizeof(entry->category), "%s", category);
+        inserted++;
+    }
+
+    fclose(f);
+    printf("Words system: da nap %d tu tu '%s' vao bo nho\n", inserted, filepath);
+    return inserted;
+}
+
+static int word_matches(const mem_word_t *word, const char *difficulty)
+{
+    return !storage_difficulty_is_valid(difficulty) || strcmp(word->difficulty, difficulty) == 0;
+}
+
+static int memory_get_random_word(void *ctx, const char *difficulty, char *out_word, size_t out_word_size)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!out_word || out_word_size == 0)
+    {
+        return -1;
+    }
+    out_word[0] = '\0';
+
+    int matching = 0;
+    for (int id = 1; id <= store->words.count; id++)
+    {
+        matching += word_matches((mem_word_t *)table_row(&store->words, id), difficulty);
+    }
+    if (matching == 0)
+    {
+        return -1;
+    }
+
+    int pick = rand() % matching;
+    for (int id = 1; id <= store->words.count; id++)
+    {
+        mem_word_t *word = (mem_word_t *)table_row(&store->words, id);
+        if (word_matches(word, difficulty) && pick-- == 0)
+        {
+            snprintf(out_word, out_word_size, "%s", word->word);
+            word->times_used++;
+            break;
+        }
+    }
+    return 0;
+}
+
+static int memory_get_all_words_by_difficulty(void *ctx, const char *difficulty,
+                                              char words[][64], char categories[][64], int max_words)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!words || !categories || max_words <= 0)
+    {
+        return -1;
+    }
+    int count = 0;
+    for (int id = 1; id <= store->words.count && count < max_words; id++)
+    {
+        mem_word_t *word = (mem_word_t *)table_row(&store->words, id);
+        if (word_matches(word, difficulty))
+        {
+            // Cot word dai toi 100, mang cua caller 64 nhu ban MySQL: cat bot
+            snprintf(words[count], 64, "%.63s", word->word);
+            snprintf(categories[count], 64, "%.63s", word->category);
+            count++;
+        }
+    }
+    return count;
+}
+
+static int memory_create_room(void *ctx, const char *room_code, int host_id, int max_players, int total_rounds)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!room_code || strlen(room_code) >= MEM_ROOM_CODE_SIZE || !table_row(&store->users, host_id))
+    {
+        return -1;
+    }
+    int id = table_append(&store->rooms);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_room_t *room = (mem_room_t *)table_row(&store->rooms, id);
+    strcpy(room->room_code, room_code);
+    room->host_id = host_id;
+    room->max_players = max_players;
+    room->total_rounds = total_rounds;
+    strcpy(room->status, "waiting");
+    return id;
+}
+
+static int memory_set_room_status(void *ctx, int db_room_id, const char *status)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    mem_room_t *room = (mem_room_t *)table_row(&store->rooms, db_room_id);
+    if (!room || !status || strlen(status) >= MEM_STATUS_SIZE)
+    {
+        return -1;
+    }
+    strcpy(room->status, status);
+    return 0;
+}
+
+static int memory_add_room_player(void *ctx, int db_room_id, int user_id, int join_order)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!table_row(&store->rooms, db_room_id) || !table_row(&store->users, user_id))
+    {
+        return -1;
+    }
+    int id = table_append(&store->room_players);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_room_player_t *player = (mem_room_player_t *)table_row(&store->room_players, id);
+    player->room_id = db_room_id;
+    player->user_id = user_id;
+    player->join_order = join_order;
+    return id;
+}
+
+static int memory_update_room_player_score(void *ctx, int player_db_id, int score)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    mem_room_player_t *player = (mem_room_player_t *)table_row(&store->room_players, player_db_id);
+    if (!player)
+    {
+        return -1;
+    }
+    player->score = score;
+    return 0;
+}
+
+static int memory_create_game_round(void *ctx, int db_room_id, int round_number, int turn_index,
+                                    int draw_player_db_id, const char *word)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!word || !table_row(&store->rooms, db_room_id) || !table_row(&store->room_players, draw_player_db_id))
+    {
+        return -1;
+    }
+    int id = table_append(&store->rounds);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_round_t *round = (mem_round_t *)table_row(&store->rounds, id);
+    round->room_id = db_room_id;
+    round->round_number = round_number;
+    round->turn_index = turn_index;
+    round->draw_id = draw_player_db_id;
+    snprintf(round->word, sizeof(round->word), "%s", word);
+    return id;
+}
+
+static int memory_save_guess(void *ctx, int db_round_id, int player_db_id, const char *guess_text, int is_correct)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!guess_text || !table_row(&store->rounds, db_round_id) || !table_row(&store->room_players, player_db_id))
+    {
+        return -1;
+    }
+    int id = table_append(&store->guesses);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_guess_t *guess = (mem_guess_t *)table_row(&store->guesses, id);
+    guess->round_id = db_round_id;
+    guess->player_id = player_db_id;
+    guess->is_correct = is_correct ? 1 : 0;
+    snprintf(guess->guess_text, sizeof(guess->guess_text), "%s", guess_text);
+    return id;
+}
+
+static int memory_save_score_detail(void *ctx, int db_round_id, int player_db_id, int score)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!table_row(&store->rounds, db_round_id) || !table_row(&store->room_players, player_db_id))
+    {
+        return -1;
+    }
+    int id = table_append(&store->score_details);
+    if (id < 0)
+    {
+        return -1;
+    }
+    mem_score_detail_t *detail = (mem_score_detail_t *)table_row(&store->score_details, id);
+    detail->round_id = db_round_id;
+    detail->player_id = player_db_id;
+    detail->score = score;
+    return id;
+}
+
+static int memory_save_chat_message(void *ctx, int db_room_id, int player_db_id, const char *message_text)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!message_text || strlen(message_text) > 500 || !table_row(&store->rooms, db_room_id) ||
+        !table_row(&store->room_players, player_db_id))
+    {
+        return -1;
+    }
+    char *text = strdup(message_text);
+    if (!text)
+    {
+        return -1;
+    }
+    int id = table_append(&store->chat);
+    if (id < 0)
+    {
+        free(text);
+        return -1;
+    }
+    mem_chat_t *chat = (mem_chat_t *)table_row(&store->chat, id);
+    chat->room_id = db_room_id;
+    chat->player_id = player_db_id;
+    chat->message_text = text;
+    return id;
+}
+
+static int memory_save_game_history(void *ctx, int user_id, int score, int rank)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    if (!table_row(&store->users, user_id))
+    {
+        return 0;
+    }
+    int id = table_append(&store->history);
+    if (id < 0)
+    {
+        return 0;
+    }
+    // table_append co the realloc bang history, khong anh huong con tro vao bang users
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, user_id);
+    mem_history_t *entry = (mem_history_t *)table_row(&store->history, id);
+    entry->user_id = user_id;
+    entry->score = score;
+    entry->rank = rank;
+    entry->prev = user->last_history;
+    user->last_history = id;
+
+    // finished_at theo gio dia phuong nhu DATE_FORMAT cua MySQL
+    time_t now = (time_t)(utils_wall_ms() / 1000);
+    struct tm tm_now;
+    localtime_r(&now, &tm_now);
+    strftime(entry->finished_at, sizeof(entry->finished_at), "%Y-%m-%d %H:%M:%S", &tm_now);
+    return 1;
+}
+
+static int memory_get_game_history(void *ctx, int user_id, game_history_entry_t *entries, int max_entries)
+{
+    mem_store_t *store = (mem_store_t *)ctx;
+    mem_user_t *user = (mem_user_t *)table_row(&store->users, user_id);
+    if (!user || !entries || max_entries <= 0)
+    {
+        return -1;
+    }
+    int count = 0;
+    for (int id = user->last_history; id != 0 && count < max_entries; count++)
+    {
+        const mem_history_t *entry = (const mem_history_t *)table_row(&store->history, id);
+        entries[count].score = entry->score;
+        entries[count].rank = entry->rank;
+        memcpy(entries[count].finished_at, entry->finished_at, sizeof(entries[count].finished_at));
+        id = entry->prev;
+    }
+    return count;
+}
+
+const storage_backend_t storage_memory_backend = {
+    .name = "memory",
+    .open = memory_open,
+    .close = memory_close,
+    .ping = NULL,
+    .flush = NULL,
+    .next_deadline_ms = NULL,
+    .register_user = memory_register_user,
+    .authenticate_user = memory_authenticate_user,
+    .change_password = memory_change_password,
+    .update_user_stats = memory_update_user_stats,
+    .load_words_from_file = memory_load_words_from_file,
+    .get_random_word = memory_get_random_word,
+    .get_all_words_by_difficulty = memory_get_all_words_by_difficulty,
+    .create_room = memory_create_room,
+    .set_room_status = memory_set_room_status,
+    .add_room_player = memory_add_room_player,
+    .update_room_player_score = memory_update_room_player_score,
+    .create_game_round = memory_create_game_round,
+    .save_guess = memory_save_guess,
+    .save_score_detail = memory_save_score_detail,
+    .save_chat_message = memory_save_chat_message,
+    .save_game_history = memory_save_game_history,
+    .get_game_history = memory_get_game_history,
+};
@@ -0,0 +1,141 @@
+#include "../include/storage.h"
+#include "../include/database.h"
+#include <stdio.h>
+
+// Backend MySQL: boc cac ham db_* cua database.c, ctx la db_connection_t*
+
+static void *mysql_backend_open(const char *arg)
+{
+    (void)arg;
+    // database.c dung port 3308 (docker-compose mapping) khi goi mysql_real_connect
+    db_connection_t *db = db_connect("127.0.0.1", "root", "123456", "draw_guess");
+    if (!db)
+    {
+        fprintf(stderr, "Khong the ket noi den MySQL\n");
+    }
+    return db;
+}
+
+static void mysql_backend_close(void *ctx)
+{
+    db_disconnect((db_connection_t *)ctx);
+}
+
+// Ket noi lai neu mat: storage dung ping de biet khi nao phat lai journal
+static int mysql_backend_ping(void *ctx)
+{
+    return db_check_and_reconnect((db_connection_t *)ctx) ? 0 : -1;
+}
+
+static int mysql_backend_register_user(void *ctx, const char *username, const char *password_hash)
+{
+    return db_register_user((db_connection_t *)ctx, username, password_hash);
+}
+
+static int mysql_backend_authenticate_user(void *ctx, const char *username, const char *password_hash)
+{
+    return db_authenticate_user((db_connection_t *)ctx, username, password_hash);
+}
+
+static int mysql_backend_change_password(void *ctx, int user_id, const char *old_password_hash, const char *new_password_hash)
+{
+    return db_change_password((db_connection_t *)ctx, user_id, old_password_hash, new_password_hash);
+}
+
+static int mysql_backend_update_user_stats(void *ctx, int user_id, int score, int is_win)
+{
+    return db_update_user_stats((db_connection_t *)ctx, user_id, score, is_win);
+}
+
+static int mysql_backend_load_words_from_file(void *ctx, const char *filepath)
+{
+    return db_load_words_from_file((db_connection_t *)ctx, filepath);
+}
+
+static int mysql_backend_get_random_word(void *ctx, const char *difficulty, char *out_word, size_t out_word_size)
+{
+    return db_get_random_word((db_connection_t *)ctx, difficulty, out_word, out_word_size);
+}
+
+static int mysql_backend_get_all_words_by_difficulty(void *ctx, const char *difficulty,
+                                                     char words[][64], char categories[][64], int max_words)
+{
+    return db_get_all_words_by_difficulty((db_connection_t *)ctx, difficulty, words, categories, max_words);
+}
+
+static int mysql_backend_create_room(void *ctx, const char *room_code, int host_id, int max_players, int total_rounds)
+{
+    return db_create_room((db_connection_t *)ctx, room_code, host_id, max_players, total_rounds);
+}
+
+static int mysql_backend_set_room_status(void *ctx, int db_room_id, const char *status)
+{
+    return db_set_room_status((db_connection_t *)ctx, db_room_id, status);
+}
+
+static int mysql_backend_add_room_player(void *ctx, int db_room_id, int user_id, int join_order)
+{
+    return db_add_room_player((db_connection_t *)ctx, db_room_id, user_id, join_order);
+}
+
+static int mysql_backend_update_room_player_score(void *ctx, int player_db_id, int score)
+{
+    return db_update_room_player_score((db_connection_t *)ctx, player_db_id, score);
+}
+
+static int mysql_backend_create_game_round(void *ctx, int db_room_id, int round_number, int turn_index,
+                                           int draw_player_db_id, const char *word)
+{
+    return db_create_game_round((db_connection_t *)ctx, db_room_id, round_number, turn_index, draw_player_db_id, word);
+}
+
+static int mysql_backend_save_guess(void *ctx, int db_round_id, int player_db_id, const char *guess_text, int is_correct)
+{
+    return db_save_guess((db_connection_t *)ctx, db_round_id, player_db_id, guess_text, is_correct);
+}
+
+static int mysql_backend_save_score_detail(void *ctx, int db_round_id, int player_db_id, int score)
+{
+    return db_save_score_detail((db_connection_t *)ctx, db_round_id, player_db_id, score);
+}
+
+static int mysql_backend_save_chat_message(void *ctx, int db_room_id, int player_db_id, const char *message_text)
+{
+    return db_save_chat_message((db_connection_t *)ctx, db_room_id, player_db_id, message_text);
+}
+
+static int mysql_backend_save_game_history(void *ctx, int user_id, int score, int rank)
+{
+    return db_save_game_history((db_connection_t *)ctx, user_id, score, rank);
+}
+
+static int mysql_backend_get_game_history(void *ctx, int user_id, game_history_entry_t *entries, int max_entries)
+{
+    return db_get_game_history((db_connection_t *)ctx, user_id, entries, max_entries);
+}
+
+const storage_backend_t storage_mysql_backend = {
+    .name = "mysql",
+    .open = mysql_backend_open,
+    .close = mysql_backend_close,
+    .ping = mysql_backend_ping,
+    .flush = NULL,
+    .next_deadline_ms = NULL,
+    .register_user = mysql_backend_register_user,
+    .authenticate_user = mysql_backend_authenticate_user,
+    .change_password = mysql_backend_change_password,
+    .update_user_stats = mysql_backend_update_user_stats,
+    .load_words_from_file = mysql_backend_load_words_from_file,
+    .get_random_word = mysql_backend_get_random_word,
+    .get_all_words_by_difficulty = mysql_backend_get_all_words_by_difficulty,
+    .create_room = mysql_backend_create_room,
+    .set_room_status = mysql_backend_set_room_status,
+    .add_room_player = mysql_backend_add_room_player,
+    .update_room_player_score = mysql_backend_update_room_player_score,
+    .create_game_round = mysql_backend_create_game_round,
+    .save_guess = mysql_backend_save_guess,
+    .save_score_detail = mysql_backend_save_score_detail,
+    .save_chat_message = mysql_backend_save_chat_message,
+    .save_game_history = mysql_backend_save_game_history,
+    .get_game_history = mysql_backend_get_game_history,
+};
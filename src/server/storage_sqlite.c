@@ -0,0 +1,683 @@
+#include "../include/storage.h"
+#include "../include/metrics.h"
+#include "../include/utils.h"
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Backend SQLite nhung trong tien trinh (--storage=sqlite[:PATH]) cho cai dat mot may:
+// khong can MySQL/docker, moi thao tac la mot lenh prepared san (vai chuc us).
+//
+// - WAL + synchronous=NORMAL: ghi khong cho fsync tung giao dich, doc khong chan ghi,
+//   sao luu/xem bang sqlite3 trong luc server chay van duoc
+// - Ghi game (round, doan, diem, chat, lich su) gom trong mot giao dich, commit khi du
+//   SQLITE_BATCH_MAX_WRITES lenh hoac giao dich mo qua SQLITE_BATCH_MAX_MS (storage_flush
+//   tu vong lap su kien). Server chet dot ngot mat toi da mot batch; dang ky va doi mat
+//   khau commit ngay
+// - Schema giong database/schema.sql + db_ensure_schema (cot total_*), username/word
+//   COLLATE NOCASE nhu collation mac dinh cua MySQL, khoa ngoai bat bang PRAGMA
+
+#define SQLITE_DEFAULT_PATH         "draw_guess.db"
+#define SQLITE_BATCH_MAX_WRITES     256
+#define SQLITE_BATCH_MAX_MS         100
+#define SQLITE_BUSY_TIMEOUT_MS      1000
+#define SQLITE_COMMIT_RETRY_MS      500     // COMMIT loi (SQLITE_BUSY...): thu lai sau khoang nay
+
+static const char *const SCHEMA_SQL =
+    "CREATE TABLE IF NOT EXISTS users ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " username TEXT NOT NULL UNIQUE COLLATE NOCASE,"
+    " password_hash TEXT NOT NULL,"
+    " created_at TEXT DEFAULT (datetime('now','localtime')),"
+    " total_games INTEGER NOT NULL DEFAULT 0,"
+    " total_wins INTEGER NOT NULL DEFAULT 0,"
+    " total_score INTEGER NOT NULL DEFAULT 0);"
+    "CREATE TABLE IF NOT EXISTS rooms ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " room_code TEXT NOT NULL UNIQUE,"
+    " host_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
+    " max_players INTEGER NOT NULL,"
+    " total_rounds INTEGER NOT NULL,"
+    " status TEXT DEFAULT 'waiting' CHECK (status IN ('waiting','in_progress','finished')),"
+    " created_at TEXT DEFAULT (datetime('now','localtime')));"
+    "CREATE TABLE IF NOT EXISTS room_players ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " room_id INTEGER NOT NULL REFERENCES rooms(id) ON DELETE CASCADE,"
+    " user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
+    " join_order INTEGER NOT NULL,"
+    " score INTEGER DEFAULT 0,"
+    " is_ready INTEGER DEFAULT 0,"
+    " connected INTEGER DEFAULT 1);"
+    "CREATE TABLE IF NOT EXISTS game_rounds ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " room_id INTEGER NOT NULL REFERENCES rooms(id) ON DELETE CASCADE,"
+    " round_number INTEGER NOT NULL,"
+    " turn_index INTEGER NOT NULL,"
+    " draw_id INTEGER NOT NULL REFERENCES room_players(id) ON DELETE CASCADE,"
+    " word TEXT NOT NULL,"
+    " started_at TEXT DEFAULT (datetime('now','localtime')),"
+    " ended_at TEXT NULL);"
+    "CREATE TABLE IF NOT EXISTS guesses ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " round_id INTEGER NOT NULL REFERENCES game_rounds(id) ON DELETE CASCADE,"
+    " player_id INTEGER NOT NULL REFERENCES room_players(id) ON DELETE CASCADE,"
+    " guess_text TEXT NOT NULL,"
+    " is_correct INTEGER NOT NULL,"
+    " guessed_at TEXT DEFAULT (datetime('now','localtime')));"
+    "CREATE TABLE IF NOT EXISTS score_details ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " round_id INTEGER NOT NULL REFERENCES game_rounds(id) ON DELETE CASCADE,"
+    " player_id INTEGER NOT NULL REFERENCES room_players(id) ON DELETE CASCADE,"
+    " score INTEGER NOT NULL,"
+    " awarded_at TEXT DEFAULT (datetime('now','localtime')));"
+    "CREATE TABLE IF NOT EXISTS chat_messages ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " room_id INTEGER NOT NULL REFERENCES rooms(id) ON DELETE CASCADE,"
+    " player_id INTEGER NOT NULL REFERENCES room_players(id) ON DELETE CASCADE,"
+    " message_text TEXT NOT NULL,"
+    " sent_at TEXT DEFAULT (datetime('now','localtime')));"
+    "CREATE TABLE IF NOT EXISTS words ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " word TEXT NOT NULL UNIQUE COLLATE NOCASE,"
+    " difficulty TEXT NOT NULL DEFAULT 'medium' CHECK (difficulty IN ('easy','medium','hard')),"
+    " category TEXT NOT NULL DEFAULT 'general',"
+    " times_used INTEGER NOT NULL DEFAULT 0);"
+    "CREATE INDEX IF NOT EXISTS idx_words_difficulty ON words(difficulty);"
+    "CREATE TABLE IF NOT EXISTS game_history ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT,"
+    " user_id INTEGER NOT NULL REFERENCES users(id) ON DELETE CASCADE,"
+    " score INTEGER NOT NULL,"
+    " player_rank INTEGER NOT NULL,"
+    " finished_at TEXT DEFAULT (datetime('now','localtime')));"
+    "CREATE INDEX IF NOT EXISTS idx_user_id ON game_history(user_id);"
+    "CREATE INDEX IF NOT EXISTS idx_finished_at ON game_history(finished_at);";
+
+// Cac lenh prepared mot lan luc mo, dung lai (reset) cho moi lan goi
+typedef enum
+{
+    ST_BEGIN,
+    ST_COMMIT,
+    ST_USER_INSERT,
+    ST_USER_AUTH,
+    ST_USER_PASSWORD,
+    ST_USER_STATS,
+    ST_WORD_UPSERT,
+    ST_WORD_RANDOM,
+    ST_WORD_USED,
+    ST_WORD_LIST,
+    ST_ROOM_INSERT,
+    ST_ROOM_STATUS,
+    ST_PLAYER_INSERT,
+    ST_PLAYER_SCORE,
+    ST_ROUND_INSERT,
+    ST_GUESS_INSERT,
+    ST_SCORE_INSERT,
+    ST_CHAT_INSERT,
+    ST_HISTORY_INSERT,
+    ST_HISTORY_SELECT,
+    ST_COUNT
+} stmt_id_t;
+
+// ?1 IS NULL: khong loc theo difficulty (NULL, rong hoac khong hop le)
+static const char *const STATEMENT_SQL[ST_COUNT] = {
+    [ST_BEGIN] = "BEGIN",
+    [ST_COMMIT] = "COMMIT",
+    [ST_USER_INSERT] = "INSERT INTO users (username, password_hash) VALUES (?1, ?2)",
+    [ST_USER_AUTH] = "SELECT id FROM users WHERE username = ?1 AND password_hash = ?2",
+    [ST_USER_PASSWORD] = "UPDATE users SET password_hash = ?3 WHERE id = ?1 AND password_hash = ?2",
+    [ST_USER_STATS] = "UPDATE users SET total_games = total_games + 1, total_wins = total_wins + ?2, "
+                      "total_score = total_score + ?3 WHERE id = ?1",
+    [ST_WORD_UPSERT] = "INSERT INTO words (word, difficulty, category) VALUES (?1, ?2, ?3) "
+                       "ON CONFLICT(word) DO UPDATE SET difficulty = excluded.difficulty, category = excluded.category",
+    [ST_WORD_RANDOM] = "SELECT id, word FROM words WHERE ?1 IS NULL OR difficulty = ?1 ORDER BY RANDOM() LIMIT 1",
+    [ST_WORD_USED] = "UPDATE words SET times_used = times_used + 1 WHERE id = ?1",
+    [ST_WORD_LIST] = "SELECT word, category FROM words WHERE ?1 IS NULL OR difficulty = ?1 ORDER BY id LIMIT ?2",
+    [ST_ROOM_INSERT] = "INSERT INTO rooms (room_code, host_id, max_players, total_rounds, status) "
+                       "VALUES (?1, ?2, ?3, ?4, 'waiting')",
+    [ST_ROOM_STATUS] = "UPDATE rooms SET status = ?2 WHERE id = ?1",
+    [ST_PLAYER_INSERT] = "INSERT INTO room_players (room_id, user_id, join_order, score, is_ready, connected) "
+                         "VALUES (?1, ?2, ?3, 0, 1, 1)",
+    [ST_PLAYER_SCORE] = "UPDATE room_players SET score = ?2 WHERE id = ?1",
+    [ST_ROUND_INSERT] = "INSERT INTO game_rounds (room_id, round_number, turn_index, draw_id, word) "
+                        "VALUES (?1, ?2, ?3, ?4, ?5)",
+    [ST_GUESS_INSERT] = "INSERT INTO guesses (round_id, player_id, guess_text, is_correct) VALUES (?1, ?2, ?3, ?4)",
+    [ST_SCORE_INSERT] = "INSERT INTO score_details (round_id, player_id, score) VALUES (?1, ?2, ?3)",
+    [ST_CHAT_INSERT] = "INSERT INTO chat_messages (room_id, player_id, message_text) VALUES (?1, ?2, ?3)",
+    [ST_HISTORY_INSERT] = "INSERT INTO game_history (user_id, score, player_rank) VALUES (?1, ?2, ?3)",
+    [ST_HISTORY_SELECT] = "SELECT score, player_rank, finished_at FROM game_history WHERE user_id = ?1 "
+                          "ORDER BY finished_at DESC, id DESC LIMIT ?2",
+};
+
+typedef struct
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmts[ST_COUNT];
+    int in_batch;                   // Dang trong giao dich gom ghi
+    int batch_writes;               // So lenh ghi trong giao dich hien tai
+    uint64_t batch_start_ms;
+} sqlite_store_t;
+
+// Lay lenh da prepared, xoa tham so cu
+static sqlite3_stmt *stmt_get(sqlite_store_t *store, stmt_id_t id)
+{
+    sqlite3_stmt *stmt = store->stmts[id];
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return stmt;
+}
+
+static void bind_text_or_null(sqlite3_stmt *stmt, int index, const char *text)
+{
+    if (text)
+    {
+        sqlite3_bind_text(stmt, index, text, -1, SQLITE_STATIC);
+    }
+    else
+    {
+        sqlite3_bind_null(stmt, index);
+    }
+}
+
+// Chay lenh khong tra dong, tinh vao metrics DB nhu db_execute_query
+static int stmt_exec(sqlite_store_t *store, sqlite3_stmt *stmt)
+{
+    uint64_t start_ns = utils_now_ns();
+    int rc = sqlite3_step(stmt);
+    int ok = rc == SQLITE_DONE;
+    metrics_record_db_query(utils_now_ns() - start_ns, ok);
+    if (!ok && rc != SQLITE_CONSTRAINT)
+    {
+        fprintf(stderr, "sqlite: %s\nSQL: %s\n", sqlite3_errmsg(store->db), sqlite3_sql(stmt));
+    }
+    sqlite3_reset(stmt);
+    return ok ? 0 : -1;
+}
+
+static int batch_commit(sqlite_store_t *store)
+{
+    if (!store->in_batch)
+    {
+        return 0;
+    }
+    if (stmt_exec(store, stmt_get(store, ST_COMMIT)) != 0)
+    {
+        if (sqlite3_get_autocommit(store->db))
+        {
+            // SQLITE_FULL/IOERR...: SQLite da rollback, thu COMMIT lai chi bao "no transaction is active"
+            fprintf(stderr, "sqlite: giao dich bi rollback, mat %d lenh ghi\n", store->batch_writes);
+            store->in_batch = 0;
+            store->batch_writes = 0;
+            return -1;
+        }
+        // Giao dich van mo (SQLITE_BUSY...): doi han commit de vong lap khong quay voi timeout 0
+        store->batch_start_ms = utils_now_ms() + SQLITE_COMMIT_RETRY_MS - SQLITE_BATCH_MAX_MS;
+        return -1;
+    }
+    store->in_batch = 0;
+    store->batch_writes = 0;
+    return 0;
+}
+
+// Mo giao dich gom ghi neu chua co
+static void batch_begin(sqlite_store_t *store)
+{
+    if (store->in_batch)
+    {
+        return;
+    }
+    if (stmt_exec(store, stmt_get(store, ST_BEGIN)) == 0)
+    {
+        store->in_batch = 1;
+        store->batch_writes = 0;
+        store->batch_start_ms = utils_now_ms();
+    }
+}
+
+// Chay mot lenh ghi trong batch, commit khi batch du lon
+static int batch_exec(sqlite_store_t *store, sqlite3_stmt *stmt)
+{
+    batch_begin(store);
+    int result = stmt_exec(store, stmt);
+    if (store->in_batch && ++store->batch_writes >= SQLITE_BATCH_MAX_WRITES)
+    {
+        batch_commit(store);
+    }
+    return result;
+}
+
+// Lenh INSERT trong batch: tra ve id dong moi hoac -1
+static int batch_insert(sqlite_store_t *store, sqlite3_stmt *stmt)
+{
+    if (batch_exec(store, stmt) != 0)
+    {
+        return -1;
+    }
+    return (int)sqlite3_last_insert_rowid(store->db);
+}
+
+// Lenh UPDATE trong batch: 0 neu co dong bi doi, -1 neu loi hoac khong co dong nao
+static int batch_update(sqlite_store_t *store, sqlite3_stmt *stmt)
+{
+    if (batch_exec(store, stmt) != 0)
+    {
+        return -1;
+    }
+    return sqlite3_changes(store->db) > 0 ? 0 : -1;
+}
+
+static void sqlite_backend_close(void *ctx)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (store->stmts[ST_COMMIT])
+    {
+        batch_commit(store);
+    }
+    for (int i = 0; i < ST_COUNT; i++)
+    {
+        sqlite3_finalize(store->stmts[i]);
+    }
+    sqlite3_close(store->db);
+    free(store);
+}
+
+static void *sqlite_backend_open(const char *arg)
+{
+    const char *path = (arg && arg[0] != '\0') ? arg : SQLITE_DEFAULT_PATH;
+    sqlite_store_t *store = (sqlite_store_t *)calloc(1, sizeof(sqlite_store_t));
+    if (!store)
+    {
+        fprintf(stderr, "sqlite: khong the cap phat\n");
+        return NULL;
+    }
+
+    // Server don luong: tat mutex cua SQLite
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path, &store->db, flags, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "sqlite: khong the mo %s: %s\n", path,
+                store->db ? sqlite3_errmsg(store->db) : "out of memory");
+        sqlite_backend_close(store);
+        return NULL;
+    }
+    sqlite3_busy_timeout(store->db, SQLITE_BUSY_TIMEOUT_MS);
+
+    char *err = NULL;
+    if (sqlite3_exec(store->db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys=ON;",
+                     NULL, NULL, &err) != SQLITE_OK ||
+        sqlite3_exec(store->db, SCHEMA_SQL, NULL, NULL, &err) != SQLITE_OK)
+    {
+        fprintf(stderr, "sqlite: khong the khoi tao schema trong %s: %s\n", path, err ? err : "?");
+        sqlite3_free(err);
+        sqlite_backend_close(store);
+        return NULL;
+    }
+
+    for (int i = 0; i < ST_COUNT; i++)
+    {
+        if (sqlite3_prepare_v3(store->db, STATEMENT_SQL[i], -1, SQLITE_PREPARE_PERSISTENT,
+                               &store->stmts[i], NULL) != SQLITE_OK)
+        {
+            fprintf(stderr, "sqlite: loi prepare: %s\nSQL: %s\n", sqlite3_errmsg(store->db), STATEMENT_SQL[i]);
+            sqlite_backend_close(store);
+            return NULL;
+        }
+    }
+
+    printf("Da mo SQLite database: %s (WAL)\n", path);
+    return store;
+}
+
+static int sqlite_backend_flush(void *ctx)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!store->in_batch || utils_now_ms() < store->batch_start_ms + SQLITE_BATCH_MAX_MS)
+    {
+        return 0;
+    }
+    return batch_commit(store);
+}
+
+static uint64_t sqlite_backend_next_deadline_ms(void *ctx)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    return store->in_batch ? store->batch_start_ms + SQLITE_BATCH_MAX_MS : 0;
+}
+
+static int sqlite_backend_register_user(void *ctx, const char *username, const char *password_hash)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!username || !password_hash)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_USER_INSERT);
+    sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, password_hash, -1, SQLITE_STATIC);
+    int user_id = batch_insert(store, stmt);
+    // Tai khoan phai ben vung truoc khi bao thanh cong cho client
+    if (user_id > 0 && batch_commit(store) != 0)
+    {
+        return -1;
+    }
+    return user_id;
+}
+
+static int sqlite_backend_authenticate_user(void *ctx, const char *username, const char *password_hash)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!username || !password_hash)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_USER_AUTH);
+    sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, password_hash, -1, SQLITE_STATIC);
+
+    uint64_t start_ns = utils_now_ns();
+    int rc = sqlite3_step(stmt);
+    int user_id = rc == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+    metrics_record_db_query(utils_now_ns() - start_ns, rc == SQLITE_ROW || rc == SQLITE_DONE);
+    sqlite3_reset(stmt);
+    return user_id;
+}
+
+static int sqlite_backend_change_password(void *ctx, int user_id, const char *old_password_hash,
+                                          const char *new_password_hash)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (user_id <= 0 || !old_password_hash || !new_password_hash)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_USER_PASSWORD);
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_text(stmt, 2, old_password_hash, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, new_password_hash, -1, SQLITE_STATIC);
+    int result = batch_update(store, stmt);
+    if (result == 0 && batch_commit(store) != 0)
+    {
+        return -1;
+    }
+    return result;
+}
+
+static int sqlite_backend_update_user_stats(void *ctx, int user_id, int score, int is_win)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    sqlite3_stmt *stmt = stmt_get(store, ST_USER_STATS);
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_int(stmt, 2, is_win ? 1 : 0);
+    sqlite3_bind_int(stmt, 3, score);
+    return batch_update(store, stmt);
+}
+
+static int sqlite_backend_load_words_from_file(void *ctx, const char *filepath)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!filepath)
+    {
+        return -1;
+    }
+    FILE *f = fopen(filepath, "r");
+    if (!f)
+    {
+        // Caller thu nhieu duong dan, tu in canh bao neu tat ca deu that bai
+        return -1;
+    }
+
+    char line[512];
+    int inserted = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        char *word;
+        char *difficulty;
+        char *category;
+        if (!storage_parse_word_line(line, &word, &difficulty, &category))
+        {
+            continue;
+        }
+        sqlite3_stmt *stmt = stmt_get(store, ST_WORD_UPSERT);
+        sqlite3_bind_text(stmt, 1, word, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, difficulty, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, category, -1, SQLITE_STATIC);
+        if (batch_exec(store, stmt) == 0)
+        {
+            inserted++;
+        }
+    }
+    fclose(f);
+    batch_commit(store);
+
+    printf("Words system: da nap %d tu tu '%s' vao SQLite\n", inserted, filepath);
+    return inserted;
+}
+
+static const char *difficulty_filter(const char *difficulty)
+{
+    return storage_difficulty_is_valid(difficulty) ? difficulty : NULL;
+}
+
+static int sqlite_backend_get_random_word(void *ctx, const char *difficulty, char *out_word, size_t out_word_size)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!out_word || out_word_size == 0)
+    {
+        return -1;
+    }
+    out_word[0] = '\0';
+
+    sqlite3_stmt *stmt = stmt_get(store, ST_WORD_RANDOM);
+    bind_text_or_null(stmt, 1, difficulty_filter(difficulty));
+    uint64_t start_ns = utils_now_ns();
+    int rc = sqlite3_step(stmt);
+    metrics_record_db_query(utils_now_ns() - start_ns, rc == SQLITE_ROW || rc == SQLITE_DONE);
+    if (rc != SQLITE_ROW)
+    {
+        sqlite3_reset(stmt);
+        return -1;
+    }
+    int word_id = sqlite3_column_int(stmt, 0);
+    snprintf(out_word, out_word_size, "%s", (const char *)sqlite3_column_text(stmt, 1));
+    sqlite3_reset(stmt);
+
+    stmt = stmt_get(store, ST_WORD_USED);
+    sqlite3_bind_int(stmt, 1, word_id);
+    batch_exec(store, stmt);
+    return 0;
+}
+
+static int sqlite_backend_get_all_words_by_difficulty(void *ctx, const char *difficulty,
+                                                      char words[][64], char categories[][64], int max_words)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!words || !categories || max_words <= 0)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_WORD_LIST);
+    bind_text_or_null(stmt, 1, difficulty_filter(difficulty));
+    sqlite3_bind_int(stmt, 2, max_words);
+
+    uint64_t start_ns = utils_now_ns();
+    int count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        snprintf(words[count], 64, "%.63s", (const char *)sqlite3_column_text(stmt, 0));
+        snprintf(categories[count], 64, "%.63s", (const char *)sqlite3_column_text(stmt, 1));
+        count++;
+    }
+    metrics_record_db_query(utils_now_ns() - start_ns, rc == SQLITE_DONE);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? count : -1;
+}
+
+static int sqlite_backend_create_room(void *ctx, const char *room_code, int host_id, int max_players, int total_rounds)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!room_code || host_id <= 0)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_ROOM_INSERT);
+    sqlite3_bind_text(stmt, 1, room_code, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, host_id);
+    sqlite3_bind_int(stmt, 3, max_players);
+    sqlite3_bind_int(stmt, 4, total_rounds);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_set_room_status(void *ctx, int db_room_id, const char *status)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!status)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_ROOM_STATUS);
+    sqlite3_bind_int(stmt, 1, db_room_id);
+    sqlite3_bind_text(stmt, 2, status, -1, SQLITE_STATIC);
+    return batch_update(store, stmt);
+}
+
+static int sqlite_backend_add_room_player(void *ctx, int db_room_id, int user_id, int join_order)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    sqlite3_stmt *stmt = stmt_get(store, ST_PLAYER_INSERT);
+    sqlite3_bind_int(stmt, 1, db_room_id);
+    sqlite3_bind_int(stmt, 2, user_id);
+    sqlite3_bind_int(stmt, 3, join_order);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_update_room_player_score(void *ctx, int player_db_id, int score)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    sqlite3_stmt *stmt = stmt_get(store, ST_PLAYER_SCORE);
+    sqlite3_bind_int(stmt, 1, player_db_id);
+    sqlite3_bind_int(stmt, 2, score);
+    return batch_update(store, stmt);
+}
+
+static int sqlite_backend_create_game_round(void *ctx, int db_room_id, int round_number, int turn_index,
+                                            int draw_player_db_id, const char *word)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!word)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_ROUND_INSERT);
+    sqlite3_bind_int(stmt, 1, db_room_id);
+    sqlite3_bind_int(stmt, 2, round_number);
+    sqlite3_bind_int(stmt, 3, turn_index);
+    sqlite3_bind_int(stmt, 4, draw_player_db_id);
+    sqlite3_bind_text(stmt, 5, word, -1, SQLITE_STATIC);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_save_guess(void *ctx, int db_round_id, int player_db_id, const char *guess_text,
+                                     int is_correct)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!guess_text)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_GUESS_INSERT);
+    sqlite3_bind_int(stmt, 1, db_round_id);
+    sqlite3_bind_int(stmt, 2, player_db_id);
+    sqlite3_bind_text(stmt, 3, guess_text, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 4, is_correct ? 1 : 0);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_save_score_detail(void *ctx, int db_round_id, int player_db_id, int score)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    sqlite3_stmt *stmt = stmt_get(store, ST_SCORE_INSERT);
+    sqlite3_bind_int(stmt, 1, db_round_id);
+    sqlite3_bind_int(stmt, 2, player_db_id);
+    sqlite3_bind_int(stmt, 3, score);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_save_chat_message(void *ctx, int db_room_id, int player_db_id, const char *message_text)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (!message_text)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_CHAT_INSERT);
+    sqlite3_bind_int(stmt, 1, db_room_id);
+    sqlite3_bind_int(stmt, 2, player_db_id);
+    sqlite3_bind_text(stmt, 3, message_text, -1, SQLITE_STATIC);
+    return batch_insert(store, stmt);
+}
+
+static int sqlite_backend_save_game_history(void *ctx, int user_id, int score, int rank)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    sqlite3_stmt *stmt = stmt_get(store, ST_HISTORY_INSERT);
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_int(stmt, 2, score);
+    sqlite3_bind_int(stmt, 3, rank);
+    return batch_insert(store, stmt) > 0 ? 1 : 0;
+}
+
+static int sqlite_backend_get_game_history(void *ctx, int user_id, game_history_entry_t *entries, int max_entries)
+{
+    sqlite_store_t *store = (sqlite_store_t *)ctx;
+    if (user_id <= 0 || !entries || max_entries <= 0)
+    {
+        return -1;
+    }
+    sqlite3_stmt *stmt = stmt_get(store, ST_HISTORY_SELECT);
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_int(stmt, 2, max_entries);
+
+    uint64_t start_ns = utils_now_ns();
+    int count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        entries[count].score = sqlite3_column_int(stmt, 0);
+        entries[count].rank = sqlite3_column_int(stmt, 1);
+        const unsigned char *finished_at = sqlite3_column_text(stmt, 2);
+        snprintf(entries[count].finished_at, sizeof(entries[count].finished_at), "%s",
+                 finished_at ? (const char *)finished_at : "");
+        count++;
+    }
+    metrics_record_db_query(utils_now_ns() - start_ns, rc == SQLITE_DONE);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? count : -1;
+}
+
+const storage_backend_t storage_sqlite_backend = {
+    .name = "sqlite",
+    .open = sqlite_backend_open,
+    .close = sqlite_backend_close,
+    .ping = NULL,
+    .flush = sqlite_backend_flush,
+    .next_deadline_ms = sqlite_backend_next_deadline_ms,
+    .register_user = sqlite_backend_register_user,
+    .authenticate_user = sqlite_backend_authenticate_user,
+    .change_password = sqlite_backend_change_password,
+    .update_user_stats = sqlite_backend_update_user_stats,
+    .load_words_from_file = sqlite_backend_load_words_from_file,
+    .get_random_word = sqlite_backend_get_random_word,
+    .get_all_words_by_difficulty = sqlite_backend_get_all_words_by_difficulty,
+    .create_room = sqlite_backend_create_room,
+    .set_room_status = sqlite_backend_set_room_status,
+    .add_room_player = sqlite_backend_add_room_player,
+    .update_room_player_score = sqlite_backend_update_room_player_score,
+    .create_game_round = sqlite_backend_create_game_round,
+    .save_guess = sqlite_backend_save_guess,
+    .save_score_detail = sqlite_backend_save_score_detail,
+    .save_chat_message = sqlite_backend_save_chat_message,
+    .save_game_history = sqlite_backend_save_game_history,
+    .get_game_history = sqlite_backend_get_game_history,
+};
@@ -0,0 +1,354 @@
+#include "../include/stroke.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bo dem tam cho RDP, tai su dung giua cac lan goi (server chay 1 thread)
+static uint8_t *rdp_keep = NULL;
+static int *rdp_stack = NULL;
+static int rdp_capacity = 0;
+
+static int rdp_reserve(int count)
+{
+    if (count <= rdp_capacity)
+    {
+        return 0;
+    }
+
+    int new_capacity = rdp_capacity > 0 ? rdp_capacity : 256;
+    while (new_capacity < count)
+    {
+        new_capacity *= 2;
+    }
+
+    uint8_t *keep = (uint8_t *)realloc(rdp_keep, (size_t)new_capacity);
+    if (!keep)
+    {
+        return -1;
+    }
+    rdp_keep = keep;
+
+    // Moi muc trong stack la mot cap (dau, cuoi)
+    int *stack = (int *)realloc(rdp_stack, (size_t)new_capacity * 2 * sizeof(int));
+    if (!stack)
+    {
+        return -1;
+    }
+    rdp_stack = stack;
+
+    rdp_capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * Binh phuong khoang cach tu diem p toi doan thang [a, b]
+ * Dung doan thang (khong phai duong thang) de xu ly net khep kin (a == b)
+ */
+static double segment_distance_sq(stroke_point_t p, stroke_point_t a, stroke_point_t b)
+{
+    double dx = (double)b.x - a.x;
+    double dy = (double)b.y - a.y;
+    double px = (double)p.x - a.x;
+    double py = (double)p.y - a.y;
+    double len2 = dx * dx + dy * dy;
+
+    if (len2 > 0.0)
+    {
+        double t = (px * dx + py * dy) / len2;
+        if (t > 1.0)
+        {
+            px = (double)p.x - b.x;
+            py = (double)p.y - b.y;
+        }
+        else if (t > 0.0)
+        {
+            px -= t * dx;
+            py -= t * dy;
+        }
+    }
+    return px * px + py * py;
+}
+
+// Don gian hoa polyline bang Ramer-Douglas-Peucker
+int stroke_simplify_rdp(stroke_point_t *points, int count, double tolerance)
+{
+    if (!points || count <= 2 || tolerance <= 0.0)
+    {
+        return count;
+    }
+
+    if (rdp_reserve(count) != 0)
+    {
+        fprintf(stderr, "Khong the cap phat bo nho cho RDP (%d diem)\n", count);
+        return count;
+    }
+
+    double tol2 = tolerance * tolerance;
+    memset(rdp_keep, 0, (size_t)count);
+    rdp_keep[0] = 1;
+    rdp_keep[count - 1] = 1;
+
+    // Stack cac khoang [first, last] can xet; moi lan tach toi da sinh 2 khoang,
+    // tong so khoang dang cho khong vuot qua so diem
+    int top = 0;
+    rdp_stack[top++] = 0;
+    rdp_stack[top++] = count - 1;
+
+    while (top > 0)
+    {
+        int last = rdp_stack[--top];
+        int first = rdp_stack[--top];
+
+        double max_dist = 0.0;
+        int index = -1;
+        for (int i = first + 1; i < last; i++)
+        {
+            double d = segment_distance_sq(points[i], points[first], points[last]);
+            if (d > max_dist)
+            {
+                max_dist = d;
+                index = i;
+            }
+        }
+
+        if (index >= 0 && max_dist > tol2)
+        {
+            rdp_keep[index] = 1;
+            if (index - first > 1)
+            {
+                rdp_stack[top++] = first;
+                rdp_stack[top++] = index;
+            }
+            if (last - index > 1)
+            {
+                rdp_stack[top++] = index;
+                rdp_stack[top++] = last;
+            }
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (rdp_keep[i])
+        {
+            points[kept++] = points[i];
+        }
+    }
+    return kept;
+}
+
+// Tao log net ve
+stroke_log_t *stroke_log_create(double tolerance)
+{
+    stroke_log_t *log = (stroke_log_t *)calloc(1, sizeof(stroke_log_t));
+    if (!log)
+    {
+        fprintf(stderr, "Khong the cap phat bo nho cho stroke log\n");
+        return NULL;
+    }
+    log->tolerance = tolerance;
+    return log;
+}
+
+// Huy log net ve
+void stroke_log_destroy(stroke_log_t *log)
+{
+    if (!log)
+    {
+        return;
+    }
+
+    for (int i = 0; i < log->capacity; i++)
+    {
+        free(log->strokes[i].points);
+    }
+    free(log->strokes);
+    free(log);
+}
+
+// Xoa cac net, giu lai bo nho
+void stroke_log_reset(stroke_log_t *log)
+{
+    if (!log)
+    {
+        return;
+    }
+
+    for (int i = 0; i < log->stroke_count; i++)
+    {
+        log->strokes[i].point_count = 0;
+    }
+    log->stroke_count = 0;
+    log->last_open = false;
+    log->raw_points = 0;
+    log->stored_points = 0;
+    log->overflow = false;
+}
+
+// Dong net dang mo va don gian hoa
+void stroke_log_finish(stroke_log_t *log)
+{
+    if (!log || !log->last_open || log->stroke_count == 0)
+    {
+        return;
+    }
+
+    stroke_t *stroke = &log->strokes[log->stroke_count - 1];
+    int before = stroke->point_count;
+    stroke->point_count = stroke_simplify_rdp(stroke->points, stroke->point_count, log->tolerance);
+    log->stored_points -= (size_t)(before - stroke->point_count);
+    log->last_open = false;
+}
+
+static int stroke_push_point(stroke_t *stroke, uint16_t x, uint16_t y)
+{
+    if (stroke->point_count >= stroke->capacity)
+    {
+        int new_capacity = stroke->capacity > 0 ? stroke->capacity * 2 : 32;
+        stroke_point_t *points = (stroke_point_t *)realloc(stroke->points,
+                                                           (size_t)new_capacity * sizeof(stroke_point_t));
+        if (!points)
+        {
+            return -1;
+        }
+        stroke->points = points;
+        stroke->capacity = new_capacity;
+    }
+
+    stroke->points[stroke->point_count].x = x;
+    stroke->points[stroke->point_count].y = y;
+    stroke->point_count++;
+    return 0;
+}
+
+// Mo net moi o cuoi log (tai su dung slot cu neu co)
+static stroke_t *stroke_log_open(stroke_log_t *log, const draw_action_t *action)
+{
+    if (log->stroke_count >= log->capacity)
+    {
+        int new_capacity = log->capacity > 0 ? log->capacity * 2 : 16;
+        stroke_t *strokes = (stroke_t *)realloc(log->strokes, (size_t)new_capacity * sizeof(stroke_t));
+        if (!strokes)
+        {
+            return NULL;
+        }
+        memset(strokes + log->capacity, 0, (size_t)(new_capacity - log->capacity) * sizeof(stroke_t));
+        log->strokes = strokes;
+        log->capacity = new_capacity;
+    }
+
+    stroke_t *stroke = &log->strokes[log->stroke_count++];
+    stroke->action = action->action;
+    stroke->color = action->color;
+    stroke->width = action->width;
+    stroke->point_count = 0;
+    log->last_open = true;
+    return stroke;
+}
+
+// Ghi hanh dong ve vao log
+int stroke_log_append(stroke_log_t *log, const draw_action_t *action)
+{
+    if (!log || !action)
+    {
+        return -1;
+    }
+
+    switch (action->action)
+    {
+    case DRAW_ACTION_CLEAR:
+        // Moi net truoc CLEAR deu khong con hien thi
+        stroke_log_reset(log);
+        return 0;
+
+    case DRAW_ACTION_MOVE:
+        stroke_log_finish(log);
+        return 0;
+
+    case DRAW_ACTION_LINE:
+    case DRAW_ACTION_ERASE:
+        break;
+
+    default:
+        return -1;
+    }
+
+    if (log->overflow || log->stored_points + 2 > STROKE_LOG_MAX_POINTS)
+    {
+        log->overflow = true;
+        return -1;
+    }
+
+    log->raw_points++;
+
+    // Noi tiep net dang mo neu lien mach va cung kieu but
+    if (log->last_open && log->stroke_count > 0)
+    {
+        stroke_t *last = &log->strokes[log->stroke_count - 1];
+        stroke_point_t tail = last->points[last->point_count - 1];
+        if (last->action == action->action && last->color == action->color &&
+            last->width == action->width && tail.x == action->x1 && tail.y == action->y1)
+        {
+            if (stroke_push_point(last, action->x2, action->y2) != 0)
+            {
+                return -1;
+            }
+            log->stored_points++;
+            return 0;
+        }
+    }
+
+    stroke_log_finish(log);
+
+    stroke_t *stroke = stroke_log_open(log, action);
+    if (!stroke)
+    {
+        return -1;
+    }
+    if (stroke_push_point(stroke, action->x1, action->y1) != 0 ||
+        stroke_push_point(stroke, action->x2, action->y2) != 0)
+    {
+        log->stroke_count--;
+        log->last_open = false;
+        return -1;
+    }
+
+    // Diem dau cua net duoc tinh vao so diem tho
+    log->raw_points++;
+    log->stored_points += 2;
+    return 0;
+}
+
+// Tai tao cac doan thang tu log
+int stroke_log_replay(const stroke_log_t *log, stroke_segment_cb cb, void *ctx)
+{
+    if (!log || !cb)
+    {
+        return 0;
+    }
+
+    int segments = 0;
+    for (int s = 0; s < log->stroke_count; s++)
+    {
+        const stroke_t *stroke = &log->strokes[s];
+        draw_action_t action;
+        action.action = stroke->action;
+        action.color = stroke->color;
+        action.width = stroke->width;
+
+        for (int i = 1; i < stroke->point_count; i++)
+        {
+            action.x1 = stroke->points[i - 1].x;
+            action.y1 = stroke->points[i - 1].y;
+            action.x2 = stroke->points[i].x;
+            action.y2 = stroke->points[i].y;
+            segments++;
+            if (cb(&action, ctx) != 0)
+            {
+                return segments;
+            }
+        }
+    }
+    return segments;
+}
@@ -0,0 +1,159 @@
+#include "../include/timerheap.h"
+#include <stdlib.h>
+#include <string.h>
+
+int timerheap_init(timerheap_t *heap, int capacity)
+{
+    memset(heap, 0, sizeof(*heap));
+    if (capacity <= 0)
+    {
+        return -1;
+    }
+
+    heap->entries = malloc((size_t)capacity * sizeof(timerheap_entry_t));
+    heap->pos = malloc((size_t)capacity * sizeof(int));
+    if (!heap->entries || !heap->pos)
+    {
+        timerheap_free(heap);
+        return -1;
+    }
+    for (int i = 0; i < capacity; i++)
+    {
+        heap->pos[i] = -1;
+    }
+    heap->capacity = capacity;
+    return 0;
+}
+
+void timerheap_free(timerheap_t *heap)
+{
+    free(heap->entries);
+    free(heap->pos);
+    memset(heap, 0, sizeof(*heap));
+}
+
+// Dat entry vao vi tri i va cap nhat chi muc id -> vi tri
+static void place(timerheap_t *heap, int i, timerheap_entry_t entry)
+{
+    heap->entries[i] = entry;
+    heap->pos[entry.id] = i;
+}
+
+static void sift_up(timerheap_t *heap, int i)
+{
+    timerheap_entry_t entry = heap->entries[i];
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (heap->entries[parent].deadline_ms <= entry.deadline_ms)
+        {
+            break;
+        }
+        place(heap, i, heap->entries[parent]);
+        i = parent;
+    }
+    place(heap, i, entry);
+}
+
+static void sift_down(timerheap_t *heap, int i)
+{
+    timerheap_entry_t entry = heap->entries[i];
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->size)
+        {
+            break;
+        }
+        if (child + 1 < heap->size && heap->entries[child + 1].deadline_ms < heap->entries[child].deadline_ms)
+        {
+            child++;
+        }
+        if (entry.deadline_ms <= heap->entries[child].deadline_ms)
+        {
+            break;
+        }
+        place(heap, i, heap->entries[child]);
+        i = child;
+    }
+    place(heap, i, entry);
+}
+
+int timerheap_set(timerheap_t *heap, int id, uint64_t deadline_ms)
+{
+    if (!heap->entries || id < 0 || id >= heap->capacity)
+    {
+        return -1;
+    }
+
+    int i = heap->pos[id];
+    if (i < 0)
+    {
+        i = heap->size++;
+        place(heap, i, (timerheap_entry_t){.deadline_ms = deadline_ms, .id = id});
+        sift_up(heap, i);
+        return 0;
+    }
+
+    uint64_t old = heap->entries[i].deadline_ms;
+    heap->entries[i].deadline_ms = deadline_ms;
+    if (deadline_ms < old)
+    {
+        sift_up(heap, i);
+    }
+    else
+    {
+        sift_down(heap, i);
+    }
+    return 0;
+}
+
+void timerheap_remove(timerheap_t *heap, int id)
+{
+    if (!heap->entries || id < 0 || id >= heap->capacity || heap->pos[id] < 0)
+    {
+        return;
+    }
+
+    int i = heap->pos[id];
+    heap->pos[id] = -1;
+    heap->size--;
+    if (i == heap->size)
+    {
+        return;
+    }
+
+    // Dua phan tu cuoi vao cho trong roi can bang theo ca hai chieu
+    int moved = heap->entries[heap->size].id;
+    place(heap, i, heap->entries[heap->size]);
+    sift_up(heap, i);
+    sift_down(heap, heap->pos[moved]);
+}
+
+int timerheap_peek(const timerheap_t *heap, int *id_out, uint64_t *deadline_out)
+{
+    if (heap->size == 0)
+    {
+        return -1;
+    }
+    if (id_out)
+    {
+        *id_out = heap->entries[0].id;
+    }
+    if (deadline_out)
+    {
+        *deadline_out = heap->entries[0].deadline_ms;
+    }
+    return 0;
+}
+
+int timerheap_pop_expired(timerheap_t *heap, uint64_t now_ms)
+{
+    if (heap->size == 0 || heap->entries[0].deadline_ms > now_ms)
+    {
+        return -1;
+    }
+    int id = heap->entries[0].id;
+    timerheap_remove(heap, id);
+    return id;
+}
@@ -0,0 +1,87 @@
+#include "../include/utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define VIRTUAL_CLOCK_START_NS 1000000000ull
+
+// Dong ho ao: virtual_ns = 0 nghia la dung clock_gettime
+static uint64_t virtual_ns = 0;
+static uint64_t virtual_wall_ms = 0;
+
+// Thoi gian monotonic (ms)
+uint64_t utils_now_ms(void)
+{
+    if (virtual_ns)
+    {
+        return virtual_ns / 1000000u;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+// Thoi gian thuc (ms), co the nhay khi doi gio he thong
+uint64_t utils_wall_ms(void)
+{
+    if (virtual_ns)
+    {
+        return virtual_wall_ms + (virtual_ns - VIRTUAL_CLOCK_START_NS) / 1000000u;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+// Monotonic (ns), dung cho histogram do tre (clock_gettime qua vDSO, khong syscall)
+uint64_t utils_now_ns(void)
+{
+    if (virtual_ns)
+    {
+        return virtual_ns;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void utils_clock_set_virtual(uint64_t wall_start_ms)
+{
+    virtual_ns = VIRTUAL_CLOCK_START_NS;
+    virtual_wall_ms = wall_start_ms;
+}
+
+void utils_clock_advance_ms(uint64_t ms)
+{
+    if (virtual_ns)
+    {
+        virtual_ns += ms * 1000000u;
+    }
+}
+
+void utils_clock_set_real(void)
+{
+    virtual_ns = 0;
+}
+
+// Doan tu: chuan hoa ve chu thuong roi so sanh (ban sao cat o 127 byte)
+int utils_words_equal_ci(const char *a, const char *b)
+{
+    if (!a || !b)
+    {
+        return 0;
+    }
+    char aa[128], bb[128];
+    snprintf(aa, sizeof(aa), "%s", a);
+    snprintf(bb, sizeof(bb), "%s", b);
+    for (char *s = aa; *s; s++)
+    {
+        *s = (char)tolower((unsigned char)*s);
+    }
+    for (char *s = bb; *s; s++)
+    {
+        *s = (char)tolower((unsigned char)*s);
+    }
+    return strcmp(aa, bb) == 0;
+}
@@ -0,0 +1,222 @@
+#include "../include/canvas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <zstd.h>
+
+// Bien dich: gcc -Iinclude test/test_canvas.c server/canvas.c server/drawing.c -lzstd -lm -o test_canvas
+
+static uint8_t pixel_at(const canvas_t *canvas, int x, int y)
+{
+    return canvas->pixels[(size_t)y * canvas->width + x];
+}
+
+/**
+ * Test 1: Tao canvas
+ * Muc dich: Canvas moi phai toan nen, palette chi co index 0
+ */
+void test_create_canvas()
+{
+    printf("Test 1: Create canvas... ");
+    canvas_t *canvas = canvas_create(MAX_CANVAS_WIDTH, MAX_CANVAS_HEIGHT);
+    assert(canvas != NULL);
+    assert(canvas->width == MAX_CANVAS_WIDTH);
+    assert(canvas->height == MAX_CANVAS_HEIGHT);
+    assert(canvas->palette_count == 1);
+    assert(pixel_at(canvas, 0, 0) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, MAX_CANVAS_WIDTH - 1, MAX_CANVAS_HEIGHT - 1) == CANVAS_BACKGROUND_INDEX);
+
+    // Kich thuoc khong hop le
+    assert(canvas_create(0, 10) == NULL);
+    assert(canvas_create(MAX_CANVAS_WIDTH + 1, 10) == NULL);
+
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Ve LINE ngang va doc
+ * Muc dich: Kiem tra cac pixel tren duong va do day cua net
+ */
+void test_draw_line()
+{
+    printf("Test 2: Draw LINE... ");
+    canvas_t *canvas = canvas_create(200, 100);
+    draw_action_t action;
+
+    // Duong ngang do rong 1: chi to dung hang y=10
+    drawing_create_line_action(10, 10, 50, 10, 0xFF0000FF, 1, &action);
+    assert(canvas_apply_action(canvas, &action) == 0);
+    uint8_t red = canvas_color_index(canvas, 0xFF0000FF);
+    assert(red == 1);
+    for (int x = 10; x <= 50; x++)
+    {
+        assert(pixel_at(canvas, x, 10) == red);
+    }
+    assert(pixel_at(canvas, 9, 10) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, 51, 10) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, 30, 9) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, 30, 11) == CANVAS_BACKGROUND_INDEX);
+
+    // Duong doc do rong 5: ban kinh 2.5 -> x tu 98 den 102
+    drawing_create_line_action(100, 20, 100, 80, 0x0000FFFF, 5, &action);
+    canvas_apply_action(canvas, &action);
+    uint8_t blue = canvas_color_index(canvas, 0x0000FFFF);
+    assert(blue == 2);
+    for (int x = 98; x <= 102; x++)
+    {
+        assert(pixel_at(canvas, x, 50) == blue);
+    }
+    assert(pixel_at(canvas, 97, 50) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, 103, 50) == CANVAS_BACKGROUND_INDEX);
+    // Dau tron: (100, 18) nam trong ban kinh, (98, 18) thi khong
+    assert(pixel_at(canvas, 100, 18) == blue);
+    assert(pixel_at(canvas, 98, 18) == CANVAS_BACKGROUND_INDEX);
+
+    // Duong cheo di qua trung diem
+    drawing_create_line_action(0, 0, 60, 60, 0xFF0000FF, 3, &action);
+    canvas_apply_action(canvas, &action);
+    assert(pixel_at(canvas, 30, 30) == red);
+    assert(pixel_at(canvas, 40, 20) == CANVAS_BACKGROUND_INDEX);
+
+    assert(canvas->stroke_count == 3);
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: ERASE va CLEAR
+ * Muc dich: ERASE ve mau nen, CLEAR xoa toan bo va reset palette
+ */
+void test_erase_and_clear()
+{
+    printf("Test 3: ERASE and CLEAR... ");
+    canvas_t *canvas = canvas_create(100, 100);
+    draw_action_t action;
+
+    drawing_create_line_action(0, 50, 99, 50, 0x000000FF, 9, &action);
+    canvas_apply_action(canvas, &action);
+    assert(pixel_at(canvas, 50, 50) != CANVAS_BACKGROUND_INDEX);
+
+    drawing_create_erase_action(50, 40, 50, 60, 5, &action);
+    canvas_apply_action(canvas, &action);
+    assert(pixel_at(canvas, 50, 50) == CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, 20, 50) != CANVAS_BACKGROUND_INDEX);
+
+    drawing_create_clear_action(&action);
+    canvas_apply_action(canvas, &action);
+    assert(pixel_at(canvas, 20, 50) == CANVAS_BACKGROUND_INDEX);
+    assert(canvas->palette_count == 1);
+    assert(canvas->stroke_count == 0);
+
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Cat net ve tai bien canvas
+ * Muc dich: Net ve sat bien khong duoc ghi ra ngoai bo dem
+ */
+void test_clip_edges()
+{
+    printf("Test 4: Clip at canvas edges... ");
+    canvas_t *canvas = canvas_create(MAX_CANVAS_WIDTH, MAX_CANVAS_HEIGHT);
+    draw_action_t action;
+
+    drawing_create_line_action(0, 0, MAX_CANVAS_WIDTH - 1, MAX_CANVAS_HEIGHT - 1,
+                               0x00FF00FF, MAX_BRUSH_WIDTH, &action);
+    assert(canvas_apply_action(canvas, &action) == 0);
+    assert(pixel_at(canvas, 0, 0) != CANVAS_BACKGROUND_INDEX);
+    assert(pixel_at(canvas, MAX_CANVAS_WIDTH - 1, MAX_CANVAS_HEIGHT - 1) != CANVAS_BACKGROUND_INDEX);
+
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 5: Palette day
+ * Muc dich: Khi het cho trong palette, mau moi duoc anh xa ve mau gan nhat
+ */
+void test_palette_full()
+{
+    printf("Test 5: Palette full... ");
+    canvas_t *canvas = canvas_create(10, 10);
+
+    for (uint32_t i = 1; i < CANVAS_PALETTE_SIZE; i++)
+    {
+        assert(canvas_color_index(canvas, i << 8) == i);
+    }
+    assert(canvas->palette_count == CANVAS_PALETTE_SIZE);
+
+    // 0x000A00FF gan voi (10 << 8) nhat
+    assert(canvas_color_index(canvas, (10u << 8) | 0x01) == 10);
+
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 6: Snapshot nen zstd va cache
+ * Muc dich: Giai nen snapshot phai ra dung pixel, snapshot duoc cache den net ve tiep theo
+ */
+void test_snapshot()
+{
+    printf("Test 6: Snapshot... ");
+    canvas_t *canvas = canvas_create(320, 240);
+    draw_action_t action;
+
+    drawing_create_line_action(10, 10, 300, 200, 0xFF0000FF, 7, &action);
+    canvas_apply_action(canvas, &action);
+
+    const uint8_t *snap = NULL;
+    size_t snap_len = 0;
+    assert(canvas_get_snapshot(canvas, &snap, &snap_len) == 0);
+    assert(snap_len > CANVAS_SNAPSHOT_HEADER_SIZE);
+    assert(snap_len < (size_t)320 * 240 / 10);
+
+    // Header
+    assert(((snap[0] << 8) | snap[1]) == 320);
+    assert(((snap[2] << 8) | snap[3]) == 240);
+    int palette_count = (snap[4] << 8) | snap[5];
+    assert(palette_count == 2);
+    const uint8_t *entry = snap + CANVAS_SNAPSHOT_HEADER_SIZE + 4;
+    assert(entry[0] == 0xFF && entry[1] == 0x00 && entry[2] == 0x00 && entry[3] == 0xFF);
+
+    // Giai nen va so sanh pixel
+    size_t header_len = CANVAS_SNAPSHOT_HEADER_SIZE + (size_t)palette_count * 4;
+    uint8_t *raw = malloc((size_t)320 * 240);
+    size_t n = ZSTD_decompress(raw, (size_t)320 * 240, snap + header_len, snap_len - header_len);
+    assert(!ZSTD_isError(n));
+    assert(n == (size_t)320 * 240);
+    assert(memcmp(raw, canvas->pixels, n) == 0);
+    free(raw);
+
+    // Khong co net moi -> tra ve cung buffer cache
+    const uint8_t *again = NULL;
+    size_t again_len = 0;
+    canvas_get_snapshot(canvas, &again, &again_len);
+    assert(again == snap && again_len == snap_len);
+
+    // Net moi -> snapshot bi danh dau dirty
+    canvas_apply_action(canvas, &action);
+    assert(canvas->snapshot_dirty == true);
+
+    canvas_destroy(canvas);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Canvas Module Tests ===\n\n");
+
+    test_create_canvas();
+    test_draw_line();
+    test_erase_and_clear();
+    test_clip_edges();
+    test_palette_full();
+    test_snapshot();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include "../include/capture.h"
+#include "../common/protocol.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+// Bien dich: gcc -Iinclude test/test_capture.c server/capture.c server/sha256.c server/utils.c -o test_capture
+
+#define TEST_PATH "/tmp/test_capture.dgcap"
+
+/**
+ * Test 1: Ghi va doc lai
+ * Muc dich: Moi loai ban ghi giu nguyen truong, thoi gian tich luy dung, varint lon khong mat bit
+ */
+void test_round_trip()
+{
+    printf("Test 1: Write/read round trip... ");
+    capture_writer_t w;
+    assert(capture_writer_open(&w, TEST_PATH, CAPTURE_FLAG_ANONYMIZED) == 0);
+
+    uint8_t big[70000];
+    for (size_t i = 0; i < sizeof(big); i++)
+    {
+        big[i] = (uint8_t)(i * 7);
+    }
+    uint8_t draw[14] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+    capture_record_t in[] = {
+        {.kind = CAPTURE_OPEN, .session = 1, .t_us = 0},
+        {.kind = CAPTURE_FRAME, .session = 1, .t_us = 150, .type = MSG_DRAW_DATA, .len = sizeof(draw), .payload = draw},
+        {.kind = CAPTURE_FRAME, .session = 1, .t_us = 150, .type = MSG_LOBBY_SUBSCRIBE, .len = 0, .payload = NULL},
+        {.kind = CAPTURE_ROOM, .session = 1, .t_us = 200, .room_id = 42},
+        {.kind = CAPTURE_FRAME, .session = 300000, .t_us = 5000000000ull, .type = MSG_CHAT_MESSAGE,
+         .len = sizeof(big), .payload = big},
+        {.kind = CAPTURE_CLOSE, .session = 1, .t_us = 5000000001ull},
+    };
+    const int count = (int)(sizeof(in) / sizeof(in[0]));
+    for (int i = 0; i < count; i++)
+    {
+        assert(capture_writer_write(&w, &in[i]) == 0);
+    }
+    assert(w.records == (uint64_t)count);
+    assert(capture_writer_close(&w) == 0);
+
+    capture_reader_t r;
+    assert(capture_reader_open(&r, TEST_PATH) == 0);
+    assert(r.flags == CAPTURE_FLAG_ANONYMIZED && r.start_wall_ms > 0);
+    capture_record_t out;
+    for (int i = 0; i < count; i++)
+    {
+        assert(capture_reader_next(&r, &out) == 1);
+        assert(out.kind == in[i].kind && out.session == in[i].session && out.t_us == in[i].t_us);
+        if (out.kind == CAPTURE_FRAME)
+        {
+            assert(out.type == in[i].type && out.len == in[i].len);
+            assert(out.len == 0 || memcmp(out.payload, in[i].payload, out.len) == 0);
+        }
+        if (out.kind == CAPTURE_ROOM)
+        {
+            assert(out.room_id == 42);
+        }
+    }
+    assert(capture_reader_next(&r, &out) == 0);
+    capture_reader_close(&r);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: File hong
+ * Muc dich: Sai magic bi tu choi, file cat cut giua ban ghi tra ve -1 thay vi du lieu rac
+ */
+void test_corrupt()
+{
+    printf("Test 2: Bad magic / truncated file... ");
+    FILE *f = fopen(TEST_PATH, "wb");
+    fputs("NOT A CAPTURE FILE", f);
+    fclose(f);
+    capture_reader_t r;
+    assert(capture_reader_open(&r, TEST_PATH) == -1);
+
+    capture_writer_t w;
+    assert(capture_writer_open(&w, TEST_PATH, 0) == 0);
+    uint8_t payload[100] = {0};
+    capture_record_t rec = {.kind = CAPTURE_FRAME, .session = 1, .t_us = 10, .type = MSG_DRAW_DATA,
+                            .len = sizeof(payload), .payload = payload};
+    assert(capture_writer_write(&w, &rec) == 0);
+    assert(capture_writer_write(&w, &rec) == 0);
+    assert(capture_writer_close(&w) == 0);
+    assert(truncate(TEST_PATH, CAPTURE_HEADER_SIZE + 150) == 0);
+
+    assert(capture_reader_open(&r, TEST_PATH) == 0);
+    capture_record_t out;
+    assert(capture_reader_next(&r, &out) == 1);
+    assert(capture_reader_next(&r, &out) == -1);
+    capture_reader_close(&r);
+    printf("PASSED\n");
+}
+
+static void make_login(uint8_t *payload, const char *username, const char *password)
+{
+    memset(payload, 0, 96);
+    strcpy((char *)payload, username);
+    strcpy((char *)payload + MAX_USERNAME_LEN, password);
+    strcpy((char *)payload + MAX_USERNAME_LEN + MAX_PASSWORD_LEN, "avt1.jpg");
+}
+
+/**
+ * Test 3: Mat khau
+ * Muc dich: Khong an danh van thay mat khau, giu username va avatar
+ */
+void test_password_scrub()
+{
+    printf("Test 3: Password always scrubbed... ");
+    uint8_t login[96];
+    make_login(login, "alice", "secret99");
+    capture_scrub(NULL, MSG_LOGIN_REQUEST, login, sizeof(login));
+    assert(strcmp((char *)login, "alice") == 0);
+    assert(strcmp((char *)login + MAX_USERNAME_LEN, CAPTURE_REPLAY_PASSWORD) == 0);
+    assert(strcmp((char *)login + MAX_USERNAME_LEN + MAX_PASSWORD_LEN, "avt1.jpg") == 0);
+
+    uint8_t change[MAX_PASSWORD_LEN * 2] = {0};
+    strcpy((char *)change, "oldpass1");
+    strcpy((char *)change + MAX_PASSWORD_LEN, "newpass2");
+    capture_scrub(NULL, MSG_CHANGE_PASSWORD_REQUEST, change, sizeof(change));
+    assert(strcmp((char *)change, CAPTURE_REPLAY_PASSWORD) == 0);
+    assert(strcmp((char *)change + MAX_PASSWORD_LEN, CAPTURE_REPLAY_PASSWORD) == 0);
+
+    // Payload ngan hon layout: khong ghi ra ngoai
+    uint8_t short_login[10] = "bob";
+    capture_scrub(NULL, MSG_LOGIN_REQUEST, short_login, sizeof(short_login));
+    assert(strcmp((char *)short_login, "bob") == 0);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: An danh
+ * Muc dich: Cung gia tri cho cung bi danh, chat giu do dai va khoang trang, salt khac cho bi danh khac
+ */
+void test_anonymize()
+{
+    printf("Test 4: Anonymize usernames/chat/rooms... ");
+    capture_anonymizer_t a;
+    capture_anonymizer_init(&a);
+
+    uint8_t first[96], second[96];
+    make_login(first, "alice", "secret99");
+    make_login(second, "alice", "other123");
+    capture_scrub(&a, MSG_LOGIN_REQUEST, first, sizeof(first));
+    capture_scrub(&a, MSG_LOGIN_REQUEST, second, sizeof(second));
+    assert(strncmp((char *)first, "u_", 2) == 0 && strlen((char *)first) == 12);
+    assert(strcmp((char *)first, (char *)second) == 0);
+    assert(strcmp((char *)first + MAX_USERNAME_LEN, CAPTURE_REPLAY_PASSWORD) == 0);
+
+    uint8_t reg[MAX_USERNAME_LEN + MAX_PASSWORD_LEN + MAX_EMAIL_LEN] = {0};
+    strcpy((char *)reg, "alice");
+    strcpy((char *)reg + MAX_USERNAME_LEN + MAX_PASSWORD_LEN, "alice@mail.com");
+    capture_scrub(&a, MSG_REGISTER_REQUEST, reg, sizeof(reg));
+    assert(strcmp((char *)reg, (char *)first) == 0);
+    const char *email = (const char *)reg + MAX_USERNAME_LEN + MAX_PASSWORD_LEN;
+    assert(strstr(email, "@example.invalid") && !strstr(email, "alice"));
+
+    uint8_t room[MAX_ROOM_NAME_LEN + 2 + 16] = {0};  // room_name, max_players, rounds, difficulty
+    strcpy((char *)room, "alice's room");
+    room[MAX_ROOM_NAME_LEN] = 6;
+    capture_scrub(&a, MSG_CREATE_ROOM, room, sizeof(room));
+    assert(strncmp((char *)room, "room_", 5) == 0 && room[MAX_ROOM_NAME_LEN] == 6);
+
+    char chat[] = "xin chao  xin";
+    capture_scrub(&a, MSG_CHAT_MESSAGE, (uint8_t *)chat, strlen(chat));
+    assert(strlen(chat) == 13 && chat[3] == ' ' && chat[8] == ' ' && chat[9] == ' ');
+    assert(strncmp(chat, "xin", 3) != 0 && strncmp(chat, chat + 10, 3) == 0);
+
+    capture_anonymizer_t b;
+    capture_anonymizer_init(&b);
+    make_login(second, "alice", "secret99");
+    capture_scrub(&b, MSG_LOGIN_REQUEST, second, sizeof(second));
+    assert(strcmp((char *)first, (char *)second) != 0);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 5: Capture phia server
+ * Muc dich: Slot client tai su dung duoc so phien moi, payload goc khong bi sua khi xoa mat khau
+ */
+void test_server_capture()
+{
+    printf("Test 5: Server-side capture sessions... ");
+    assert(capture_start(TEST_PATH, 0) == 0);
+    assert(capture_active());
+    uint8_t login[96];
+    make_login(login, "alice", "secret99");
+    capture_session_open(3);
+    capture_frame(3, MSG_LOGIN_REQUEST, login, sizeof(login));
+    capture_room_created(3, 7);
+    capture_session_close(3);
+    capture_frame(3, MSG_CHAT_MESSAGE, (const uint8_t *)"hi", 2);  // Slot da dong: bo qua
+    capture_session_open(3);
+    capture_stop();
+    assert(!capture_active());
+    assert(strcmp((char *)login + MAX_USERNAME_LEN, "secret99") == 0);
+
+    capture_reader_t r;
+    assert(capture_reader_open(&r, TEST_PATH) == 0);
+    capture_record_t out;
+    capture_kind_t kinds[] = {CAPTURE_OPEN, CAPTURE_FRAME, CAPTURE_ROOM, CAPTURE_CLOSE, CAPTURE_OPEN};
+    uint32_t sessions[] = {1, 1, 1, 1, 2};
+    for (int i = 0; i < 5; i++)
+    {
+        assert(capture_reader_next(&r, &out) == 1);
+        assert(out.kind == kinds[i] && out.session == sessions[i]);
+        if (out.kind == CAPTURE_FRAME)
+        {
+            assert(strcmp((const char *)out.payload + MAX_USERNAME_LEN, CAPTURE_REPLAY_PASSWORD) == 0);
+        }
+    }
+    assert(capture_reader_next(&r, &out) == 0);
+    capture_reader_close(&r);
+    remove(TEST_PATH);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Capture Tests ===\n\n");
+
+    test_round_trip();
+    test_corrupt();
+    test_password_scrub();
+    test_anonymize();
+    test_server_capture();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "../common/protocol.h"
+#include "../common/wire.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,13 @@
 #define SERVER_IP "127.0.0.1"
 #define SERVER_PORT 8080
 
+// Bien dich: gcc -Icommon test/test_client.c common/wire.c -o test_client
+
+// Capability client nay hieu duoc (gui trong HELLO)
+#define CLIENT_CAPS (CAP_COMPACT_STRINGS)
+
+static uint32_t negotiated_caps = 0;
+
 /**
  * Ket noi den server
  */
@@ -126,15 +134,70 @@ int send_message(int sockfd, uint8_t type, const uint8_t* payload, uint16_t payl
         
         printf("✓ Nhan response: type=0x%02X, length=%d\n", type, length);
         
-        // Parse response dua tren type (giu nguyen code cu)
+        // Parse response dua tren type
+        wire_reader_t r;
+        wire_reader_init(&r, buffer + 3, (size_t)bytes_read - 3 < length ? (size_t)bytes_read - 3 : length);
         switch (type) {
-            // ... cac case khac giu nguyen ...
+            case MSG_HELLO_ACK: {
+                uint16_t version = wire_get_u16(&r);
+                negotiated_caps = wire_get_u32(&r);
+                printf("  Protocol v%u, caps=0x%08X\n", version, negotiated_caps);
+                break;
+            }
+            case MSG_CREATE_ROOM:
+            case MSG_JOIN_ROOM:
+            case MSG_LEAVE_ROOM: {
+                if (!(negotiated_caps & CAP_COMPACT_STRINGS)) {
+                    break;
+                }
+                char message[WIRE_MAX_STRING_LEN + 1];
+                uint8_t status = wire_get_u8(&r);
+                int32_t room_id = type == MSG_LEAVE_ROOM ? 0 : wire_get_i32(&r);
+                wire_get_string(&r, message, sizeof(message));
+                printf("  status=%u, room_id=%d, message=%s\n", status, room_id, message);
+                break;
+            }
+            case MSG_CHAT_BROADCAST: {
+                if (!(negotiated_caps & CAP_COMPACT_STRINGS)) {
+                    break;
+                }
+                char username[MAX_USERNAME_LEN];
+                char text[MAX_MESSAGE_LEN];
+                wire_get_string(&r, username, sizeof(username));
+                wire_get_string(&r, text, sizeof(text));
+                uint64_t ts_ms = wire_get_u64(&r);
+                printf("  [%llu] %s: %s\n", (unsigned long long)ts_ms, username, text);
+                break;
+            }
+            default:
+                break;
+        }
+        if (r.overflow) {
+            printf("✗ Loi: Payload type 0x%02X bi thieu du lieu\n", type);
         }
         
         return 0;  // Da nhan duoc message mong doi
     }
 }
 
+/**
+ * Gui HELLO va doi HELLO_ACK (thoa thuan capability)
+ */
+int send_hello(int sockfd) {
+    uint8_t payload[6];
+    wire_writer_t w;
+    wire_writer_init(&w, payload, sizeof(payload));
+    wire_put_u16(&w, PROTOCOL_VERSION);
+    wire_put_u32(&w, CLIENT_CAPS);
+
+    if (send_message(sockfd, MSG_HELLO, payload, (uint16_t)w.len) < 0) {
+        return -1;
+    }
+
+    uint8_t expected = MSG_HELLO_ACK;
+    return receive_response(sockfd, &expected);
+}
+
 /**
  * Test LOGIN
  */
@@ -245,6 +308,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (send_hello(sockfd) < 0) {
+        close(sockfd);
+        return 1;
+    }
+
     int result = 0;
     bool is_logged_in = false;
     
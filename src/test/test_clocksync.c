@@ -0,0 +1,117 @@
+#include "../include/clocksync.h"
+#include <stdio.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_clocksync.c server/clocksync.c -o test_clocksync
+
+/**
+ * Test 1: Mot mau PING/PONG
+ * Muc dich: RTT tru thoi gian client giu PING, offset = dong ho client - server
+ */
+void test_single_sample()
+{
+    printf("Test 1: Single sample... ");
+    clocksync_t cs;
+    clocksync_reset(&cs);
+    assert(clocksync_rtt_ms(&cs) == 0);
+
+    // Server gui luc 1000, client (nhanh hon 5000ms) nhan luc 6020, gui lai luc 6030, server nhan luc 1050
+    // (monotonic va dong ho thuc trung nhau de de doc)
+    uint32_t seq = clocksync_start_ping(&cs, 1000, 1000);
+    assert(clocksync_on_pong(&cs, seq, 1000, 6020, 6030, 1050, 1050) == 0);
+    assert(cs.rtt_ms == 40);
+    assert(cs.offset_ms == 5000);
+    assert(clocksync_rtt_ms(&cs) == 40 && cs.min_rtt_ms == 40);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: PONG khong khop
+ * Muc dich: Seq/origin sai hoac PONG lap lai bi bo qua, PING khong tra loi duoc dem la mat
+ */
+void test_mismatch_and_loss()
+{
+    printf("Test 2: Mismatch and loss... ");
+    clocksync_t cs;
+    clocksync_reset(&cs);
+    assert(clocksync_on_pong(&cs, 1, 0, 0, 0, 10, 10) == -1);
+
+    uint32_t seq = clocksync_start_ping(&cs, 100, 100);
+    assert(clocksync_on_pong(&cs, seq + 1, 100, 0, 0, 120, 120) == -1);
+    assert(clocksync_on_pong(&cs, seq, 99, 0, 0, 120, 120) == -1);
+
+    // PING tiep theo khi chua co PONG: PING truoc bi tinh mat
+    seq = clocksync_start_ping(&cs, 5100, 5100);
+    assert(cs.lost == 1);
+    assert(clocksync_on_pong(&cs, seq, 5100, 5110, 5110, 5120, 5120) == 0);
+    assert(clocksync_on_pong(&cs, seq, 5100, 5110, 5110, 5120, 5120) == -1);
+    assert(cs.samples == 1);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Lam muot RTT
+ * Muc dich: srtt theo EWMA 1/8, offset chi lay tu mau RTT thap
+ */
+void test_smoothing()
+{
+    printf("Test 3: Smoothing... ");
+    clocksync_t cs;
+    clocksync_reset(&cs);
+    uint64_t now = 1000;
+    for (int i = 0; i < 20; i++)
+    {
+        uint32_t seq = clocksync_start_ping(&cs, now, now);
+        assert(clocksync_on_pong(&cs, seq, now, now + 50, now + 50, now + 100, now + 100) == 0);
+        now += CLOCKSYNC_PING_INTERVAL_MS;
+    }
+    assert(cs.srtt_ms == 100 && cs.offset_ms == 0);
+
+    // Mot mau cham bat doi xung: srtt tang 1/8, offset khong bi keo lech
+    uint32_t seq = clocksync_start_ping(&cs, now, now);
+    assert(clocksync_on_pong(&cs, seq, now, now + 850, now + 850, now + 900, now + 900) == 0);
+    assert(cs.rtt_ms == 900 && cs.srtt_ms == 200);
+    assert(cs.offset_ms == 0 && cs.min_rtt_ms == 100);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Dong ho that
+ * Muc dich: Server uptime 1 gio (monotonic), dong ho thuc epoch; client cham 1234ms tra PONG bang
+ * Date.now(): offset la do lech dong ho thuc, khong phai epoch - uptime; RTT van theo monotonic
+ */
+void test_realistic_skew()
+{
+    printf("Test 4: Realistic skew... ");
+    clocksync_t cs;
+    clocksync_reset(&cs);
+    uint64_t mono = 3600000;
+    uint64_t wall = 1760000000000ULL;
+    int64_t skew = -1234;
+
+    uint32_t seq = clocksync_start_ping(&cs, mono, wall);
+    // Di 30ms, client giu 5ms, ve 30ms
+    uint64_t client_recv = (uint64_t)((int64_t)wall + 30 + skew);
+    uint64_t client_send = client_recv + 5;
+    assert(clocksync_on_pong(&cs, seq, wall, client_recv, client_send, mono + 65, wall + 65) == 0);
+    assert(cs.rtt_ms == 60);
+    assert(cs.offset_ms == skew);
+
+    // PONG chep origin_ms la monotonic (client/server cu) khong khop PING dang cho
+    seq = clocksync_start_ping(&cs, mono + 5000, wall + 5000);
+    assert(clocksync_on_pong(&cs, seq, mono + 5000, client_recv, client_send, mono + 5065, wall + 5065) == -1);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Clock Sync Tests ===\n\n");
+
+    test_single_sample();
+    test_mismatch_and_loss();
+    test_smoothing();
+    test_realistic_skew();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "../common/codec.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Icommon test/test_codec.c common/codec.c common/wire.c -o test_codec
+
+/**
+ * Test 1: Round-trip schema co chuoi co dinh
+ * Muc dich: Encode/decode giu nguyen gia tri, kich thuoc dung bang struct packed cu
+ */
+void test_fixed_round_trip()
+{
+    printf("Test 1: Fixed layout round-trip... ");
+    msg_game_start_t in = {
+        .drawer_id = -7,
+        .word_length = 5,
+        .time_limit = 90,
+        .round_start_ms = 1700000000123ULL,
+        .current_round = 3,
+        .player_count = 4,
+        .total_rounds = 2,
+    };
+    strcpy(in.word, "apple");
+    strcpy(in.category, "fruit");
+
+    uint8_t buf[CODEC_GAME_START_MAX_SIZE];
+    size_t len = msg_game_start_encode(&in, buf, sizeof(buf));
+    assert(len == 149);
+    // drawer_id big-endian, word bat dau o offset 21
+    assert(buf[0] == 0xFF && buf[3] == 0xF9);
+    assert(memcmp(buf + 21, "apple", 6) == 0);
+
+    msg_game_start_t out;
+    assert(msg_game_start_decode(buf, len, &out) == (int)len);
+    assert(out.drawer_id == -7 && out.time_limit == 90);
+    assert(out.round_start_ms == 1700000000123ULL);
+    assert(out.current_round == 3 && out.total_rounds == 2);
+    assert(strcmp(out.word, "apple") == 0 && strcmp(out.category, "fruit") == 0);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Round-trip schema chuoi gon (_v2)
+ * Muc dich: Chuoi [len:1][bytes] chi ton len + 1 byte
+ */
+void test_compact_round_trip()
+{
+    printf("Test 2: Compact layout round-trip... ");
+    msg_chat_broadcast_v2_t in = {.timestamp = 42};
+    strcpy(in.username, "bob");
+    strcpy(in.message, "hello");
+
+    uint8_t buf[CODEC_CHAT_BROADCAST_V2_MAX_SIZE];
+    size_t len = msg_chat_broadcast_v2_encode(&in, buf, sizeof(buf));
+    assert(len == (1 + 3) + (1 + 5) + 8);
+
+    msg_chat_broadcast_v2_t out;
+    assert(msg_chat_broadcast_v2_decode(buf, len, &out) == (int)len);
+    assert(strcmp(out.username, "bob") == 0);
+    assert(strcmp(out.message, "hello") == 0);
+    assert(out.timestamp == 42);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Danh sach header + phan tu
+ * Muc dich: msg_*_write/read noi tiep nhau tren cung writer/reader
+ */
+void test_list()
+{
+    printf("Test 3: Header + entries... ");
+    uint8_t buf[128];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    msg_game_end_header_t header = {.winner_id = 2, .score_count = 2};
+    msg_game_end_header_write(&header, &w);
+    for (int i = 0; i < 2; i++)
+    {
+        msg_score_entry_t entry = {.user_id = i + 1, .score = (i + 1) * -10};
+        msg_score_entry_write(&entry, &w);
+    }
+    assert(!w.overflow && w.len == 6 + 2 * 8);
+
+    wire_reader_t r;
+    wire_reader_init(&r, buf, w.len);
+    msg_game_end_header_t h;
+    msg_game_end_header_read(&r, &h);
+    assert(h.winner_id == 2 && h.score_count == 2);
+    for (int i = 0; i < h.score_count; i++)
+    {
+        msg_score_entry_t e;
+        msg_score_entry_read(&r, &e);
+        assert(e.user_id == i + 1 && e.score == (i + 1) * -10);
+    }
+    assert(!r.overflow && r.pos == r.len);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Payload thieu va buffer khong du
+ * Muc dich: Decode tra ve -1, encode tra ve 0, khong doc/ghi ngoai buffer
+ */
+void test_truncated()
+{
+    printf("Test 4: Truncated payload / small buffer... ");
+    msg_login_request_t req = {0};
+    strcpy(req.username, "alice");
+    uint8_t buf[CODEC_LOGIN_REQUEST_MAX_SIZE];
+    assert(msg_login_request_encode(&req, buf, sizeof(buf)) == sizeof(buf));
+    assert(msg_login_request_encode(&req, buf, sizeof(buf) - 1) == 0);
+
+    msg_login_request_t out;
+    assert(msg_login_request_decode(buf, sizeof(buf) - 1, &out) == -1);
+    assert(msg_login_request_decode(buf, sizeof(buf), &out) == (int)sizeof(buf));
+    assert(strcmp(out.username, "alice") == 0);
+
+    // Chuoi co dinh khong co '\0' tren wire van null-terminated sau decode
+    memset(buf, 'x', sizeof(buf));
+    assert(msg_login_request_decode(buf, sizeof(buf), &out) == (int)sizeof(buf));
+    assert(strlen(out.username) == MAX_USERNAME_LEN - 1);
+
+    // Tien to chuoi gon vuot cuoi payload
+    const uint8_t bad[] = {0, 0, 0, 0, 1, 200, 'a'};
+    msg_room_response_v2_t resp;
+    assert(msg_room_response_v2_decode(bad, sizeof(bad), &resp) == -1);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Codec Tests ===\n\n");
+
+    test_fixed_round_trip();
+    test_compact_round_trip();
+    test_list();
+    test_truncated();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "../include/compress.h"
+#include "../common/protocol.h"
+#include "../common/codec.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude -Icommon test/test_compress.c server/compress.c common/codec.c common/wire.c -o test_compress -lz
+
+// Giai nen payload MSG_COMPRESSED giong gateway (inflateRawSync)
+static size_t inflate_payload(const uint8_t *in, size_t in_len, uint8_t *out, size_t capacity)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    assert(inflateInit2(&zs, -15) == Z_OK);
+    zs.next_in = (Bytef *)in;
+    zs.avail_in = (uInt)in_len;
+    zs.next_out = out;
+    zs.avail_out = (uInt)capacity;
+    assert(inflate(&zs, Z_FINISH) == Z_STREAM_END);
+    size_t len = zs.total_out;
+    inflateEnd(&zs);
+    return len;
+}
+
+/**
+ * Test 1: Round-trip payload danh sach
+ * Muc dich: Header [type][raw_len] dung, giai nen raw deflate ra dung payload goc
+ */
+void test_round_trip()
+{
+    printf("Test 1: Compress round-trip... ");
+    uint8_t payload[2048];
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (i % 64) < 8 ? (uint8_t)('a' + i % 8) : 0; // chuoi char[64] dem '\0'
+    }
+
+    compress_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    uint8_t out[4096];
+    assert(compress_bound(sizeof(payload)) <= sizeof(out));
+    size_t len = compress_payload(&ctx, MSG_ROOM_LIST_RESPONSE, payload, sizeof(payload), out, sizeof(out));
+    assert(len > COMPRESS_HEADER_SIZE && len < sizeof(payload));
+
+    msg_compressed_header_t header;
+    assert(msg_compressed_header_decode(out, len, &header) == COMPRESS_HEADER_SIZE);
+    assert(header.type == MSG_ROOM_LIST_RESPONSE && header.raw_len == sizeof(payload));
+
+    uint8_t raw[4096];
+    assert(inflate_payload(out + COMPRESS_HEADER_SIZE, len - COMPRESS_HEADER_SIZE, raw, sizeof(raw)) == sizeof(payload));
+    assert(memcmp(raw, payload, sizeof(payload)) == 0);
+    assert(ctx.messages == 1 && ctx.raw_bytes == sizeof(payload) && ctx.wire_bytes == len);
+    compress_ctx_free(&ctx);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Context dung lai cho nhieu message
+ * Muc dich: Moi message la stream doc lap, giai nen rieng tung message duoc
+ */
+void test_reuse()
+{
+    printf("Test 2: Context reuse, independent streams... ");
+    compress_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    uint8_t payload[1024];
+    uint8_t out[2048];
+    uint8_t raw[2048];
+
+    for (int round = 0; round < 3; round++)
+    {
+        memset(payload, 'A' + round, sizeof(payload));
+        size_t len = compress_payload(&ctx, MSG_GAME_HISTORY_RESPONSE, payload, sizeof(payload), out, sizeof(out));
+        assert(len > 0);
+        assert(inflate_payload(out + COMPRESS_HEADER_SIZE, len - COMPRESS_HEADER_SIZE, raw, sizeof(raw)) == sizeof(payload));
+        assert(memcmp(raw, payload, sizeof(payload)) == 0);
+    }
+    assert(ctx.messages == 3);
+    compress_ctx_free(&ctx);
+    assert(!ctx.initialized);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Du lieu khong nen duoc va buffer khong du
+ * Muc dich: Tra ve 0 de server gui payload goc
+ */
+void test_not_worth()
+{
+    printf("Test 3: Incompressible payload / small buffer... ");
+    compress_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    uint8_t payload[1024];
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        payload[i] = (uint8_t)x;
+    }
+    uint8_t out[2048];
+    assert(compress_payload(&ctx, MSG_ROOM_LIST_RESPONSE, payload, sizeof(payload), out, sizeof(out)) == 0);
+
+    memset(payload, 0, sizeof(payload));
+    assert(compress_payload(&ctx, MSG_ROOM_LIST_RESPONSE, payload, sizeof(payload), out, COMPRESS_HEADER_SIZE + 2) == 0);
+    assert(ctx.messages == 0);
+    compress_ctx_free(&ctx);
+
+    assert(compress_type_eligible(MSG_ROOM_LIST_RESPONSE));
+    assert(!compress_type_eligible(MSG_DRAW_BROADCAST));
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Compress Tests ===\n\n");
+
+    test_round_trip();
+    test_reuse();
+    test_not_worth();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include "../include/journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_journal.c server/journal.c server/utils.c -lz -o test_journal
+
+#define TEST_JOURNAL_PATH "/tmp/test_journal.jnl"
+
+// Ghi lai cac ban ghi duoc phat lai; stop_after >= 0: tra ve -1 tu ban ghi thu stop_after
+typedef struct {
+    char seen[64][32];
+    int count;
+    int stop_after;
+} replay_log_t;
+
+static int record_apply(const uint8_t *payload, uint32_t len, void *arg)
+{
+    replay_log_t *log = (replay_log_t *)arg;
+    if (log->stop_after >= 0 && log->count >= log->stop_after)
+    {
+        return -1;
+    }
+    assert(len < sizeof(log->seen[0]));
+    memcpy(log->seen[log->count], payload, len);
+    log->seen[log->count][len] = '\0';
+    log->count++;
+    return 0;
+}
+
+static void append_str(const char *s)
+{
+    assert(journal_append((const uint8_t *)s, (uint32_t)strlen(s)) == 0);
+}
+
+static long file_size(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+/**
+ * Test 1: Ghi va mo lai
+ * Muc dich: Ban ghi nam trong buffer den khi flush, con nguyen sau khi dong/mo lai
+ */
+void test_append_reopen()
+{
+    printf("Test 1: Append/flush/reopen... ");
+    remove(TEST_JOURNAL_PATH);
+    assert(!journal_active());
+    assert(journal_append((const uint8_t *)"x", 1) == -1);
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_active() && journal_pending() == 0);
+    assert(file_size(TEST_JOURNAL_PATH) == JOURNAL_HEADER_SIZE);
+
+    append_str("guess:1");
+    append_str("chat:2");
+    assert(journal_pending() == 2);
+    assert(file_size(TEST_JOURNAL_PATH) == JOURNAL_HEADER_SIZE);
+    assert(journal_flush() == 0);
+    assert(file_size(TEST_JOURNAL_PATH) == JOURNAL_HEADER_SIZE + 2 * JOURNAL_RECORD_HEADER_SIZE + 13);
+    append_str("history:3");
+    journal_close();
+    assert(!journal_active() && journal_pending() == 0);
+
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 3);
+    static uint8_t big[JOURNAL_MAX_PAYLOAD + 1];
+    assert(journal_append(big, JOURNAL_MAX_PAYLOAD + 1) == -1);
+    journal_close();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Phat lai
+ * Muc dich: Dung thu tu ghi; dung giua chung thi lan sau tiep tuc dung cho, ke ca sau khi mo lai;
+ * phat lai het thi file cat ve header
+ */
+void test_replay()
+{
+    printf("Test 2: Replay order/resume/truncate... ");
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    append_str("buffered:4");
+
+    replay_log_t log = {.stop_after = 2};
+    assert(journal_replay(record_apply, &log, 1000000000ULL) == 2);
+    assert(strcmp(log.seen[0], "guess:1") == 0 && strcmp(log.seen[1], "chat:2") == 0);
+    assert(journal_pending() == 2);
+    journal_close();
+
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 2);
+    log.stop_after = -1;
+    assert(journal_replay(record_apply, &log, 1000000000ULL) == 2);
+    assert(strcmp(log.seen[2], "history:3") == 0 && strcmp(log.seen[3], "buffered:4") == 0);
+    assert(journal_pending() == 0);
+    assert(file_size(TEST_JOURNAL_PATH) == JOURNAL_HEADER_SIZE);
+    assert(journal_replay(record_apply, &log, 1000000000ULL) == 0);
+
+    // Het ngan sach thoi gian van xu ly it nhat mot ban ghi moi lan
+    append_str("a");
+    append_str("b");
+    assert(journal_replay(record_apply, &log, 0) == 1);
+    assert(journal_replay(record_apply, &log, 0) == 1);
+    assert(log.count == 6 && strcmp(log.seen[5], "b") == 0);
+    journal_close();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: File hong
+ * Muc dich: Ban ghi cuoi ghi do (crash) bi cat khi mo lai, sai CRC khong duoc phat lai,
+ * file khong phai journal bi tu choi
+ */
+void test_corruption()
+{
+    printf("Test 3: Torn tail/CRC/bad header... ");
+    remove(TEST_JOURNAL_PATH);
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    append_str("ok:1");
+    append_str("ok:2");
+    journal_close();
+    long good_size = file_size(TEST_JOURNAL_PATH);
+
+    // Ban ghi thu ba chi ghi duoc mot nua
+    FILE *f = fopen(TEST_JOURNAL_PATH, "ab");
+    assert(f);
+    const uint8_t torn[] = {0, 0, 0, 10, 0x12, 0x34, 0x56, 0x78, 'p', 'a'};
+    fwrite(torn, 1, sizeof(torn), f);
+    fclose(f);
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 2);
+    assert(file_size(TEST_JOURNAL_PATH) == good_size);
+    append_str("ok:3");
+    journal_close();
+
+    // Lat mot bit trong payload ban ghi thu hai: chi ban ghi dau con hop le
+    f = fopen(TEST_JOURNAL_PATH, "r+b");
+    assert(f);
+    fseek(f, JOURNAL_HEADER_SIZE + JOURNAL_RECORD_HEADER_SIZE + 4 + JOURNAL_RECORD_HEADER_SIZE, SEEK_SET);
+    fputc('X', f);
+    fclose(f);
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 1);
+    replay_log_t log = {.stop_after = -1};
+    assert(journal_replay(record_apply, &log, 1000000000ULL) == 1);
+    assert(log.count == 1 && strcmp(log.seen[0], "ok:1") == 0);
+    journal_close();
+
+    f = fopen(TEST_JOURNAL_PATH, "wb");
+    assert(f);
+    fputs("not a journal file", f);
+    fclose(f);
+    assert(journal_open(TEST_JOURNAL_PATH) == -1);
+    assert(!journal_active());
+    remove(TEST_JOURNAL_PATH);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Buffer day
+ * Muc dich: Ghi nhieu hon JOURNAL_BUFFER_SIZE tu flush giua chung, khong mat ban ghi nao
+ */
+void test_buffer_full()
+{
+    printf("Test 4: Buffer overflow flush... ");
+    remove(TEST_JOURNAL_PATH);
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    static uint8_t payload[1000];
+    int records = 3 * JOURNAL_BUFFER_SIZE / (int)sizeof(payload);
+    for (int i = 0; i < records; i++)
+    {
+        payload[0] = (uint8_t)i;
+        assert(journal_append(payload, sizeof(payload)) == 0);
+    }
+    assert(journal_pending() == (uint64_t)records);
+    journal_close();
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == (uint64_t)records);
+    journal_close();
+    remove(TEST_JOURNAL_PATH);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 5: Offset cu trong header
+ * Muc dich: Crash sau khi cat file nhung truoc khi ghi lai header (offset > kich thuoc file);
+ * header phai duoc sua ngay khi mo de ban ghi moi khong bi mat o lan mo sau
+ */
+void test_stale_offset()
+{
+    printf("Test 5: Stale header offset... ");
+    remove(TEST_JOURNAL_PATH);
+    FILE *f = fopen(TEST_JOURNAL_PATH, "wb");
+    assert(f);
+    uint8_t header[JOURNAL_HEADER_SIZE] = {0};
+    memcpy(header, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN);
+    header[5] = JOURNAL_VERSION;
+    header[15] = 60;
+    fwrite(header, 1, sizeof(header), f);
+    fclose(f);
+
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 0);
+    for (int i = 0; i < 10; i++)
+    {
+        append_str("stale");
+    }
+    assert(journal_flush() == 0);
+    journal_close();
+
+    assert(journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(journal_pending() == 10);
+    replay_log_t log = {.stop_after = -1};
+    assert(journal_replay(record_apply, &log, 1000000000ULL) == 10);
+    assert(journal_pending() == 0);
+    journal_close();
+    remove(TEST_JOURNAL_PATH);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Journal Tests ===\n\n");
+
+    test_append_reopen();
+    test_replay();
+    test_corruption();
+    test_buffer_full();
+    test_stale_offset();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
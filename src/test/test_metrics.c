@@ -0,0 +1,158 @@
+#include "../include/metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_metrics.c server/metrics.c server/utils.c -o test_metrics
+
+/**
+ * Test 1: Chi so bucket log-linear
+ * Muc dich: Gia tri nho chinh xac tung don vi, gia tri lon sai so <= 1/LATENCY_SUB_COUNT
+ */
+void test_bucket_index()
+{
+    printf("Test 1: Bucket index... ");
+    for (uint64_t v = 0; v < LATENCY_SUB_COUNT; v++)
+    {
+        assert(latency_bucket_index(v) == (int)v);
+    }
+
+    // Cac bucket lien tiep, don dieu, can duoi <= gia tri < can duoi bucket ke tiep
+    const uint64_t samples[] = {8, 9, 15, 16, 17, 1000, 12345, 999999, 1234567890ULL};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        uint64_t v = samples[i];
+        int idx = latency_bucket_index(v);
+        assert(idx > 0 && idx < LATENCY_BUCKETS - 1);
+        assert(latency_bucket_lower(idx) <= v && v < latency_bucket_lower(idx + 1));
+        assert((double)(v - latency_bucket_lower(idx)) <= (double)v / LATENCY_SUB_COUNT);
+    }
+    assert(latency_bucket_index(16) == latency_bucket_index(17));
+    assert(latency_bucket_index(15) + 1 == latency_bucket_index(16));
+
+    // Vuot LATENCY_MAX_MSB don vao bucket cuoi
+    assert(latency_bucket_index(UINT64_MAX) == LATENCY_BUCKETS - 1);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Phan vi
+ * Muc dich: p50/p99 nam trong sai so bucket, khong vuot max
+ */
+void test_quantile()
+{
+    printf("Test 2: Quantiles... ");
+    latency_hist_t hist;
+    memset(&hist, 0, sizeof(hist));
+    assert(latency_hist_quantile(&hist, 0.5) == 0);
+
+    // 1..1000 us
+    for (uint64_t us = 1; us <= 1000; us++)
+    {
+        latency_hist_record(&hist, us * 1000);
+    }
+    assert(hist.count == 1000 && hist.max_ns == 1000000);
+
+    uint64_t p50 = latency_hist_quantile(&hist, 0.50);
+    uint64_t p99 = latency_hist_quantile(&hist, 0.99);
+    assert(p50 > 500000 * 7 / 8 && p50 < 500000 * 9 / 8);
+    assert(p99 > 990000 * 7 / 8 && p99 <= 1000000);
+    assert(latency_hist_quantile(&hist, 1.0) == 1000000);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Dispatch va thoi gian DB
+ * Muc dich: Truy van DB trong handler tinh cho dung type, ngoai handler chi tinh tong
+ */
+void test_dispatch()
+{
+    printf("Test 3: Dispatch + DB attribution... ");
+    metrics_reset();
+
+    uint64_t start = metrics_dispatch_begin(0x01);
+    metrics_record_db_query(2000000, 1);
+    metrics_record_db_query(1000000, 0);
+    metrics_dispatch_end(0x01, 100, start, 0);
+
+    start = metrics_dispatch_begin(0x01);
+    metrics_dispatch_end(0x01, 50, start, -1);
+
+    metrics_record_db_query(500000, 1); // Ngoai handler
+    metrics_record_rejected(0x20, 10);
+
+    const metrics_t *m = metrics_get();
+    assert(m->types[0x01].calls == 2 && m->types[0x01].errors == 1);
+    assert(m->types[0x01].bytes_in == 150);
+    assert(m->types[0x01].db_queries == 2 && m->types[0x01].db_ns == 3000000);
+    assert(m->types[0x01].latency.count == 2);
+    assert(m->types[0x20].rejected == 1 && m->types[0x20].calls == 0);
+    assert(m->db_queries == 3 && m->db_errors == 1);
+    assert(m->db_latency.sum_ns == 3500000);
+
+    assert(metrics_take_dump_request() == 0);
+    metrics_request_dump();
+    assert(metrics_take_dump_request() == 1);
+    assert(metrics_take_dump_request() == 0);
+    printf("PASSED\n");
+}
+
+static const char *test_type_name(uint8_t type)
+{
+    return type == 0x01 ? "MSG_LOGIN_REQUEST" : NULL;
+}
+
+/**
+ * Test 4: Xuat Prometheus text
+ * Muc dich: Counter/summary theo type co nhan, type chua co so lieu bi bo qua, buffer tu gian
+ */
+void test_prometheus()
+{
+    printf("Test 4: Prometheus exposition... ");
+    metrics_reset();
+    uint64_t start = metrics_dispatch_begin(0x01);
+    metrics_dispatch_end(0x01, 64, start, 0);
+    metrics_record_sent(0x21, 10);
+    metrics_record_sent(0x21, 30);
+    metrics_record_broadcast(4);
+    metrics_record_loop(1500);
+
+    metrics_text_t text = {0};
+    metrics_write_prometheus(&text, test_type_name);
+    assert(!text.failed && strlen(text.data) == text.len);
+
+    assert(strstr(text.data, "# TYPE drawguess_messages_received_total counter\n"));
+    assert(strstr(text.data, "drawguess_messages_received_total{type=\"0x01\",name=\"MSG_LOGIN_REQUEST\"} 1\n"));
+    assert(strstr(text.data, "drawguess_received_bytes_total{type=\"0x01\",name=\"MSG_LOGIN_REQUEST\"} 64\n"));
+    assert(strstr(text.data, "drawguess_sent_bytes_total{type=\"0x21\"} 40\n"));
+    assert(!strstr(text.data, "drawguess_messages_received_total{type=\"0x21\""));
+    assert(strstr(text.data, "drawguess_handler_seconds_count{type=\"0x01\",name=\"MSG_LOGIN_REQUEST\"} 1\n"));
+    assert(strstr(text.data, "drawguess_broadcast_fanout{quantile=\"0.99\"} 4\n"));
+    assert(strstr(text.data, "drawguess_event_loop_seconds_count 1\n"));
+
+    // Noi qua dung luong ban dau (4096) van giu du noi dung
+    size_t before = text.len;
+    for (int i = 0; i < 1000; i++)
+    {
+        metrics_text_appendf(&text, "line %d\n", i);
+    }
+    assert(!text.failed && text.capacity > 4096);
+    assert(strstr(text.data + before, "line 999\n") && strlen(text.data) == text.len);
+
+    metrics_text_free(&text);
+    assert(text.data == NULL && text.len == 0);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Metrics Tests ===\n\n");
+
+    test_bucket_index();
+    test_quantile();
+    test_dispatch();
+    test_prometheus();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
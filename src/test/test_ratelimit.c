@@ -0,0 +1,97 @@
+#include "../include/ratelimit.h"
+#include "../common/protocol.h"
+#include <stdio.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_ratelimit.c server/ratelimit.c -o test_ratelimit
+
+/**
+ * Test 1: Phan nhom message
+ * Muc dich: Cac message ton tai nguyen thuoc dung nhom, LOGOUT/PING/PONG khong bi gioi han
+ */
+void test_class_mapping()
+{
+    printf("Test 1: Class mapping... ");
+    assert(ratelimit_class_for(MSG_DRAW_DATA) == RATE_CLASS_DRAW);
+    assert(ratelimit_class_for(MSG_CHAT_MESSAGE) == RATE_CLASS_CHAT);
+    assert(ratelimit_class_for(MSG_GUESS_WORD) == RATE_CLASS_CHAT);
+    assert(ratelimit_class_for(MSG_ROOM_LIST_REQUEST) == RATE_CLASS_LOBBY);
+    assert(ratelimit_class_for(MSG_JOIN_ROOM) == RATE_CLASS_ROOM);
+    assert(ratelimit_class_for(MSG_LOGIN_REQUEST) == RATE_CLASS_AUTH);
+    assert(ratelimit_class_for(MSG_LOGOUT) == RATE_CLASS_NONE);
+    assert(ratelimit_class_for(MSG_PING) == RATE_CLASS_NONE);
+    assert(ratelimit_class_for(MSG_PONG) == RATE_CLASS_NONE);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Burst va nap lai token
+ * Muc dich: Cho phep dung burst message, sau do nap theo rate
+ */
+void test_consume_and_refill()
+{
+    printf("Test 2: Consume and refill... ");
+    rate_limit_policy_t policy = {10, 5};  // 10/giay, burst 5
+    rate_bucket_t bucket = {5000, 1000};
+
+    for (int i = 0; i < 5; i++)
+    {
+        assert(ratelimit_consume(&bucket, &policy, 1000) == true);
+    }
+    assert(ratelimit_consume(&bucket, &policy, 1000) == false);
+
+    // 100ms sau: nap du 1 token
+    assert(ratelimit_consume(&bucket, &policy, 1100) == true);
+    assert(ratelimit_consume(&bucket, &policy, 1100) == false);
+
+    // Sau thoi gian dai: khong vuot qua burst
+    for (int i = 0; i < 5; i++)
+    {
+        assert(ratelimit_consume(&bucket, &policy, 60000) == true);
+    }
+    assert(ratelimit_consume(&bucket, &policy, 60000) == false);
+
+    // rate = 0: khong gioi han
+    rate_limit_policy_t off = {0, 0};
+    rate_bucket_t empty = {0, 0};
+    assert(ratelimit_consume(&empty, &off, 0) == true);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Parse tuy chon dong lenh
+ */
+void test_parse_option()
+{
+    printf("Test 3: Parse option... ");
+    rate_limit_policy_t policies[RATE_CLASS_COUNT];
+    ratelimit_default_policies(policies);
+
+    assert(ratelimit_parse_option("draw=200/400", policies) == 0);
+    assert(policies[RATE_CLASS_DRAW].rate_per_sec == 200);
+    assert(policies[RATE_CLASS_DRAW].burst == 400);
+
+    assert(ratelimit_parse_option("chat=3", policies) == 0);
+    assert(policies[RATE_CLASS_CHAT].burst == 6);
+
+    assert(ratelimit_parse_option("lobby=0", policies) == 0);
+    assert(policies[RATE_CLASS_LOBBY].rate_per_sec == 0);
+
+    assert(ratelimit_parse_option("unknown=1/2", policies) == -1);
+    assert(ratelimit_parse_option("draw", policies) == -1);
+    assert(ratelimit_parse_option("draw=abc", policies) == -1);
+    assert(ratelimit_parse_option("draw=10/0", policies) == -1);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Rate Limit Tests ===\n\n");
+
+    test_class_mapping();
+    test_consume_and_refill();
+    test_parse_option();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "../include/stall.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_stall.c server/stall.c server/metrics.c server/utils.c -o test_stall
+
+/**
+ * Test 1: Nguong
+ * Muc dich: Chi khoang thoi gian >= nguong moi ghi, nguong 0 tat han
+ */
+void test_threshold()
+{
+    printf("Test 1: Threshold... ");
+    stall_configure(50);
+    assert(!stall_exceeds(49999999));
+    assert(stall_exceeds(50000000));
+    stall_configure(0);
+    assert(!stall_exceeds(UINT64_MAX));
+    stall_configure(STALL_DEFAULT_THRESHOLD_MS);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Ring buffer
+ * Muc dich: Giu STALL_RING_SIZE ban ghi moi nhat, snapshot moi nhat truoc
+ */
+void test_ring()
+{
+    printf("Test 2: Ring wrap-around... ");
+    stall_reset();
+    stall_record_t out[STALL_RING_SIZE];
+    assert(stall_snapshot(out, STALL_RING_SIZE) == 0);
+
+    const int pushed = STALL_RING_SIZE + 10;
+    for (int i = 0; i < pushed; i++)
+    {
+        stall_record_t record = {.kind = STALL_KIND_MESSAGE, .duration_ns = (uint64_t)i, .client_index = i};
+        stall_push(&record);
+    }
+    assert(stall_total() == (uint64_t)pushed);
+
+    int count = stall_snapshot(out, STALL_RING_SIZE);
+    assert(count == STALL_RING_SIZE);
+    assert(out[0].seq == (uint64_t)pushed && out[0].client_index == pushed - 1);
+    assert(out[count - 1].seq == (uint64_t)(pushed - STALL_RING_SIZE + 1));
+    assert(out[0].wall_ms > 0);
+
+    // Gioi han max
+    assert(stall_snapshot(out, 3) == 3 && out[2].client_index == pushed - 3);
+    printf("PASSED\n");
+}
+
+static const char *test_type_name(uint8_t type)
+{
+    return type == 0x01 ? "MSG_LOGIN_REQUEST" : NULL;
+}
+
+/**
+ * Test 3: Xuat van ban
+ * Muc dich: Ban ghi message co type/client/phong/DB, ban ghi vong lap co thoi gian tung pha
+ */
+void test_text()
+{
+    printf("Test 3: Text dump... ");
+    stall_reset();
+    stall_record_t slow = {
+        .kind = STALL_KIND_MESSAGE,
+        .duration_ns = 120000000,
+        .msg_type = 0x01,
+        .payload_len = 96,
+        .client_index = 3,
+        .user_id = 42,
+        .room_id = 7,
+        .db_queries = 2,
+        .db_ns = 110000000,
+    };
+    stall_push(&slow);
+    stall_record_t loop = {
+        .kind = STALL_KIND_LOOP,
+        .duration_ns = 130000000,
+        .messages = 5,
+        .db_queries = 2,
+        .phase_ns = {[STALL_PHASE_CLIENTS] = 125000000, [STALL_PHASE_TICK] = 4000000, [STALL_PHASE_LOBBY] = 1000000},
+    };
+    stall_push(&loop);
+
+    metrics_text_t text = {0};
+    stall_write_text(&text, test_type_name);
+    assert(!text.failed);
+    assert(strstr(text.data, "2 ban ghi"));
+    assert(strstr(text.data, "message 0x01 MSG_LOGIN_REQUEST 120.000ms client=3 user=42 room=7 payload=96 db=2 (110.000ms)"));
+    assert(strstr(text.data, "loop 130.000ms messages=5 db=2"));
+    assert(strstr(text.data, "clients=125.000ms tick=4.000ms lobby=1.000ms"));
+    // Moi nhat truoc
+    assert(strstr(text.data, "loop") < strstr(text.data, "message 0x01"));
+    metrics_text_free(&text);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Stall Detector Tests ===\n\n");
+
+    test_threshold();
+    test_ring();
+    test_text();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,482 @@
+#include "../include/storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_storage.c server/storage.c server/storage_memory.c server/storage_sqlite.c server/journal.c server/metrics.c server/utils.c -lsqlite3 -lz -o test_storage
+// (khong link storage_mysql.c: backend "mysql" duoi day la ban gia de thu journal)
+
+#define TEST_WORDS_PATH "/tmp/test_storage_words.txt"
+#define TEST_SQLITE_PATH "/tmp/test_storage.db"
+#define TEST_JOURNAL_PATH "/tmp/test_storage.jnl"
+
+// ============================================
+// Backend "mysql" gia: bang trong bo nho, ping va ghi dieu khien duoc
+// ============================================
+
+static int stub_up = 1;             // 0: ping va moi ghi that bai nhu khi MySQL mat ket noi
+static int stub_calls = 0;          // So lan storage.c goi vao backend (ke ca ping)
+static char stub_log[16][32];       // Noi dung doan/chat da den backend, theo thu tu
+static int stub_log_count = 0;
+
+static void stub_record(const char *text)
+{
+    assert(stub_log_count < 16);
+    snprintf(stub_log[stub_log_count++], sizeof(stub_log[0]), "%s", text);
+}
+
+static void *stub_open(const char *arg)
+{
+    return storage_memory_backend.open(arg);
+}
+
+static void stub_close(void *ctx)
+{
+    storage_memory_backend.close(ctx);
+}
+
+static int stub_ping(void *ctx)
+{
+    (void)ctx;
+    stub_calls++;
+    return stub_up ? 0 : -1;
+}
+
+static int stub_register_user(void *ctx, const char *username, const char *password_hash)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.register_user(ctx, username, password_hash) : -1;
+}
+
+static int stub_update_user_stats(void *ctx, int user_id, int score, int is_win)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.update_user_stats(ctx, user_id, score, is_win) : -1;
+}
+
+static int stub_create_room(void *ctx, const char *room_code, int host_id, int max_players, int total_rounds)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.create_room(ctx, room_code, host_id, max_players, total_rounds) : -1;
+}
+
+static int stub_set_room_status(void *ctx, int db_room_id, const char *status)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.set_room_status(ctx, db_room_id, status) : -1;
+}
+
+static int stub_add_room_player(void *ctx, int db_room_id, int user_id, int join_order)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.add_room_player(ctx, db_room_id, user_id, join_order) : -1;
+}
+
+static int stub_update_room_player_score(void *ctx, int player_db_id, int score)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.update_room_player_score(ctx, player_db_id, score) : -1;
+}
+
+static int stub_create_game_round(void *ctx, int db_room_id, int round_number, int turn_index,
+                                  int draw_player_db_id, const char *word)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.create_game_round(ctx, db_room_id, round_number, turn_index,
+                                                              draw_player_db_id, word)
+                   : -1;
+}
+
+static int stub_save_guess(void *ctx, int db_round_id, int player_db_id, const char *guess_text, int is_correct)
+{
+    stub_calls++;
+    if (!stub_up)
+    {
+        return -1;
+    }
+    stub_record(guess_text);
+    return storage_memory_backend.save_guess(ctx, db_round_id, player_db_id, guess_text, is_correct);
+}
+
+static int stub_save_score_detail(void *ctx, int db_round_id, int player_db_id, int score)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.save_score_detail(ctx, db_round_id, player_db_id, score) : -1;
+}
+
+static int stub_save_chat_message(void *ctx, int db_room_id, int player_db_id, const char *message_text)
+{
+    stub_calls++;
+    if (!stub_up)
+    {
+        return -1;
+    }
+    stub_record(message_text);
+    return storage_memory_backend.save_chat_message(ctx, db_room_id, player_db_id, message_text);
+}
+
+static int stub_save_game_history(void *ctx, int user_id, int score, int rank)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.save_game_history(ctx, user_id, score, rank) : 0;
+}
+
+static int stub_get_game_history(void *ctx, int user_id, game_history_entry_t *entries, int max_entries)
+{
+    stub_calls++;
+    return stub_up ? storage_memory_backend.get_game_history(ctx, user_id, entries, max_entries) : -1;
+}
+
+// Test chi dung cac thao tac tren; tu, dang nhap, doi mat khau khong goi toi
+const storage_backend_t storage_mysql_backend = {
+    .name = "mysql",
+    .open = stub_open,
+    .close = stub_close,
+    .ping = stub_ping,
+    .flush = NULL,
+    .next_deadline_ms = NULL,
+    .register_user = stub_register_user,
+    .authenticate_user = NULL,
+    .change_password = NULL,
+    .update_user_stats = stub_update_user_stats,
+    .load_words_from_file = NULL,
+    .get_random_word = NULL,
+    .get_all_words_by_difficulty = NULL,
+    .create_room = stub_create_room,
+    .set_room_status = stub_set_room_status,
+    .add_room_player = stub_add_room_player,
+    .update_room_player_score = stub_update_room_player_score,
+    .create_game_round = stub_create_game_round,
+    .save_guess = stub_save_guess,
+    .save_score_detail = stub_save_score_detail,
+    .save_chat_message = stub_save_chat_message,
+    .save_game_history = stub_save_game_history,
+    .get_game_history = stub_get_game_history,
+};
+
+static void remove_sqlite_files(void)
+{
+    remove(TEST_SQLITE_PATH);
+    remove(TEST_SQLITE_PATH "-wal");
+    remove(TEST_SQLITE_PATH "-shm");
+}
+
+/**
+ * Test 1: Chon backend
+ * Muc dich: Ten la bi tu choi, chua mo backend thi moi thao tac that bai nhu khi mat DB
+ */
+void test_open_close()
+{
+    printf("Test 1: Open/close backend... ");
+    assert(!storage_available());
+    assert(strcmp(storage_backend_name(), "none") == 0);
+    assert(storage_register_user("alice", "hash") == -1);
+    assert(storage_save_game_history(1, 10, 1) == 0);
+    assert(storage_open("oracle") == -1);
+    assert(!storage_available());
+
+    assert(storage_open("memory") == 0);
+    assert(storage_available());
+    assert(strcmp(storage_backend_name(), "memory") == 0);
+    assert(storage_ping() == 0);
+    storage_close();
+    assert(!storage_available());
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Nguoi dung
+ * Muc dich: Trung ten (khong phan biet hoa thuong) bi tu choi, sai mat khau that bai,
+ * doi mat khau can mat khau cu dung, chi muc giu dung sau nhieu lan mo rong
+ */
+void test_users()
+{
+    printf("Test 2: Register/login/change password... ");
+    assert(storage_open("memory") == 0);
+    int alice = storage_register_user("alice", "hash_a");
+    assert(alice > 0);
+    assert(storage_register_user("ALICE", "other") == -1);
+    assert(storage_authenticate_user("alice", "hash_a") == alice);
+    assert(storage_authenticate_user("Alice", "hash_a") == alice);
+    assert(storage_authenticate_user("alice", "wrong") == -1);
+    assert(storage_authenticate_user("bob", "hash_a") == -1);
+
+    assert(storage_change_password(alice, "wrong", "hash_b") == -1);
+    assert(storage_change_password(alice, "hash_a", "hash_b") == 0);
+    assert(storage_authenticate_user("alice", "hash_a") == -1);
+    assert(storage_authenticate_user("alice", "hash_b") == alice);
+    assert(storage_change_password(9999, "hash_b", "x") == -1);
+
+    char name[32];
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(name, sizeof(name), "user%d", i);
+        assert(storage_register_user(name, "h") == alice + 1 + i);
+    }
+    for (int i = 0; i < 1000; i += 37)
+    {
+        snprintf(name, sizeof(name), "user%d", i);
+        assert(storage_authenticate_user(name, "h") == alice + 1 + i);
+    }
+    storage_close();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Tu vung
+ * Muc dich: Nap file bo dong trong/ghi chu, cap nhat tu trung, loc theo difficulty,
+ * difficulty sai thi lay tat ca
+ */
+void test_words()
+{
+    printf("Test 3: Word list... ");
+    FILE *f = fopen(TEST_WORDS_PATH, "w");
+    assert(f);
+    fputs("# comment\n\ncat|easy|animal\n  dog | easy | animal \nrocket|hard|object\n"
+          "cat|medium|pet\nbook\n", f);
+    fclose(f);
+
+    assert(storage_open("memory") == 0);
+    assert(storage_load_words_from_file("/tmp/khong_ton_tai.txt") == -1);
+    assert(storage_load_words_from_file(TEST_WORDS_PATH) == 5);
+
+    char words[10][64], categories[10][64];
+    assert(storage_get_all_words_by_difficulty(NULL, words, categories, 10) == 4);
+    assert(strcmp(words[0], "cat") == 0 && strcmp(categories[0], "pet") == 0);
+    assert(strcmp(words[3], "book") == 0 && strcmp(categories[3], "general") == 0);
+    assert(storage_get_all_words_by_difficulty("easy", words, categories, 10) == 1);
+    assert(strcmp(words[0], "dog") == 0);
+    assert(storage_get_all_words_by_difficulty("medium", words, categories, 10) == 2);
+    assert(storage_get_all_words_by_difficulty("bogus", words, categories, 10) == 4);
+    assert(storage_get_all_words_by_difficulty(NULL, words, categories, 2) == 2);
+
+    char word[64];
+    assert(storage_get_random_word("hard", word, sizeof(word)) == 0 && strcmp(word, "rocket") == 0);
+    assert(storage_get_random_word("", word, sizeof(word)) == 0 && word[0] != '\0');
+    storage_close();
+
+    assert(storage_open("memory") == 0);
+    assert(storage_get_random_word(NULL, word, sizeof(word)) == -1);
+    storage_close();
+    remove(TEST_WORDS_PATH);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Phong, round, doan, chat
+ * Muc dich: Khoa ngoai duoc kiem tra nhu schema.sql, id tang dan
+ */
+void test_game_records()
+{
+    printf("Test 4: Rooms/rounds/guesses/chat... ");
+    assert(storage_open("memory") == 0);
+    int host = storage_register_user("host", "h");
+    int guest = storage_register_user("guest", "h");
+    assert(storage_create_room("R1", 12345, 4, 2) == -1);
+    int room = storage_create_room("R1", host, 4, 2);
+    assert(room > 0);
+    assert(storage_set_room_status(room, "in_progress") == 0);
+    assert(storage_set_room_status(room + 1, "finished") == -1);
+
+    int p1 = storage_add_room_player(room, host, 1);
+    int p2 = storage_add_room_player(room, guest, 2);
+    assert(p1 > 0 && p2 == p1 + 1);
+    assert(storage_add_room_player(room + 1, guest, 3) == -1);
+    assert(storage_update_room_player_score(p2, 15) == 0);
+    assert(storage_update_room_player_score(p2 + 10, 15) == -1);
+
+    int round = storage_create_game_round(room, 1, 0, p1, "cat");
+    assert(round > 0);
+    assert(storage_create_game_round(room, 1, 0, p2 + 10, "cat") == -1);
+    assert(storage_save_guess(round, p2, "dog", 0) > 0);
+    assert(storage_save_guess(round, p2, "cat", 1) > 0);
+    assert(storage_save_guess(round + 1, p2, "cat", 1) == -1);
+    assert(storage_save_score_detail(round, p2, 10) > 0);
+    assert(storage_save_score_detail(round, p1, 5) > 0);
+    assert(storage_save_chat_message(room, p2, "xin chao") == 1);
+    assert(storage_save_chat_message(room, p2, "lan nua") == 2);
+    assert(storage_save_chat_message(room, 0, "x") == -1);
+    assert(storage_update_user_stats(host, 5, 0) == 0);
+    assert(storage_update_user_stats(99999, 5, 0) == -1);
+    storage_close();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 5: Lich su
+ * Muc dich: Moi nhat truoc, gioi han so entry, user khong ton tai that bai
+ */
+void test_history()
+{
+    printf("Test 5: Game history... ");
+    assert(storage_open("memory") == 0);
+    int alice = storage_register_user("alice", "h");
+    int bob = storage_register_user("bob", "h");
+    assert(storage_save_game_history(99999, 10, 1) == 0);
+    for (int i = 0; i < 5; i++)
+    {
+        assert(storage_save_game_history(alice, i * 10, i + 1) == 1);
+        assert(storage_save_game_history(bob, i, 2) == 1);
+    }
+
+    game_history_entry_t entries[10];
+    assert(storage_get_game_history(alice, entries, 10) == 5);
+    assert(entries[0].score == 40 && entries[0].rank == 5);
+    assert(entries[4].score == 0 && entries[4].rank == 1);
+    assert(strlen(entries[0].finished_at) == 19 && entries[0].finished_at[4] == '-');
+    assert(storage_get_game_history(bob, entries, 3) == 3);
+    assert(entries[0].score == 4 && entries[2].score == 2);
+    int carol = storage_register_user("carol", "h");
+    assert(storage_get_game_history(carol, entries, 10) == 0);
+    assert(storage_get_game_history(99999, entries, 10) == -1);
+    storage_close();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 6: SQLite
+ * Muc dich: Cung quy uoc voi memory (trung ten, khoa ngoai, lich su moi nhat truoc),
+ * ghi gom van doc lai duoc truoc khi commit, du lieu con sau khi dong/mo lai file
+ */
+void test_sqlite()
+{
+    printf("Test 6: SQLite backend... ");
+    remove_sqlite_files();
+    assert(storage_open("sqlite:" TEST_SQLITE_PATH) == 0);
+    assert(strcmp(storage_backend_name(), "sqlite") == 0);
+    int alice = storage_register_user("alice", "hash_a");
+    assert(alice > 0);
+    assert(storage_register_user("ALICE", "other") == -1);
+    assert(storage_authenticate_user("Alice", "hash_a") == alice);
+    assert(storage_change_password(alice, "wrong", "hash_b") == -1);
+    assert(storage_change_password(alice, "hash_a", "hash_b") == 0);
+
+    int room = storage_create_room("R1", alice, 4, 2);
+    assert(room > 0);
+    assert(storage_create_room("R2", 12345, 4, 2) == -1);
+    int player = storage_add_room_player(room, alice, 1);
+    assert(player > 0);
+    int round = storage_create_game_round(room, 1, 0, player, "cat");
+    assert(round > 0);
+    assert(storage_save_guess(round + 1, player, "cat", 1) == -1);
+    // 300 lan ghi > mot batch: commit giua chung khong lam mat ghi nao
+    for (int i = 0; i < 300; i++)
+    {
+        assert(storage_save_guess(round, player, "dog", 0) > 0);
+    }
+    assert(storage_save_chat_message(room, player, "xin chao") > 0);
+    assert(storage_update_user_stats(alice, 10, 1) == 0);
+    assert(storage_update_user_stats(99999, 10, 1) == -1);
+    for (int i = 0; i < 5; i++)
+    {
+        assert(storage_save_game_history(alice, i * 10, i + 1) == 1);
+    }
+    assert(storage_save_game_history(99999, 10, 1) == 0);
+
+    game_history_entry_t entries[10];
+    assert(storage_get_game_history(alice, entries, 3) == 3);
+    assert(entries[0].score == 40 && entries[2].score == 20);
+    assert(storage_flush() == 0);
+    storage_close();
+
+    assert(storage_open("sqlite:" TEST_SQLITE_PATH) == 0);
+    assert(storage_authenticate_user("alice", "hash_b") == alice);
+    assert(storage_get_game_history(alice, entries, 10) == 5);
+    assert(entries[0].score == 40 && entries[4].score == 0);
+    assert(strlen(entries[0].finished_at) == 19 && entries[0].finished_at[4] == '-');
+    assert(storage_add_room_player(room, alice, 2) == player + 1);
+    storage_close();
+    remove_sqlite_files();
+    printf("PASSED\n");
+}
+
+/**
+ * Test 7: Journal khi mat ket noi
+ * Muc dich: Ghi that bai + ping that bai -> vao journal, khong cham backend nua cho den luc thu lai;
+ * khi con su kien cho, ghi moi cung vao journal de phat lai dung thu tu;
+ * su kien backend tu choi (khoa ngoai) bi bo thay vi chan journal mai
+ */
+void test_journal_outage()
+{
+    printf("Test 7: Journal on backend outage... ");
+    remove(TEST_JOURNAL_PATH);
+    stub_up = 1;
+    assert(storage_open("mysql") == 0);
+    assert(storage_journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(storage_journal_pending() == 0);
+    int alice = storage_register_user("alice", "h");
+    int room = storage_create_room("R1", alice, 4, 2);
+    int player = storage_add_room_player(room, alice, 1);
+    int round = storage_create_game_round(room, 1, 0, player, "cat");
+    assert(alice > 0 && room > 0 && player > 0 && round > 0);
+    assert(storage_save_chat_message(room, player, "truoc") == 1);
+
+    // Ghi dau tien that bai: mot lan ghi + mot ping, roi vao journal voi ket qua "chua co id"
+    stub_up = 0;
+    int calls = stub_calls;
+    assert(storage_save_chat_message(room, player, "mot") == 0);
+    assert(stub_calls == calls + 2);
+    assert(storage_journal_pending() == 1);
+    // Dang mat ket noi: ghi vao thang journal, doc/ping/tao id that bai ngay khong goi backend
+    assert(storage_save_guess(round, player, "hai", 0) == 0);
+    assert(storage_save_game_history(alice, 10, 1) == 1);
+    game_history_entry_t entries[4];
+    assert(storage_get_game_history(alice, entries, 4) == -1);
+    assert(storage_create_game_round(room, 2, 1, player, "dog") == -1);
+    assert(storage_ping() == -1);
+    assert(stub_calls == calls + 2);
+    assert(storage_journal_pending() == 3);
+
+    // Backend song lai nhung chua den luc thu lai: van giu thu tu, ghi moi xep sau
+    stub_up = 1;
+    assert(storage_flush() == 0);
+    assert(storage_save_chat_message(room, player, "ba") == 0);
+    assert(storage_save_guess(round + 100, player, "bi tu choi", 0) == 0);
+    assert(storage_journal_pending() == 5);
+    assert(stub_calls == calls + 2);
+
+    // Mo lai journal (nhu khoi dong lai server) khi backend van mat: ping ngay va danh dau mat ket noi
+    stub_up = 0;
+    assert(storage_journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(storage_get_game_history(alice, entries, 4) == -1);
+
+    // Mo lai khi backend song: thu ket noi ngay thay vi cho JOURNAL_RETRY_MS, doc dung duoc ngay
+    // (lich su dang cho trong journal chua thay) truoc khi phat lai
+    stub_up = 1;
+    assert(storage_journal_open(TEST_JOURNAL_PATH) == 0);
+    assert(storage_journal_pending() == 5);
+    assert(storage_get_game_history(alice, entries, 4) == 0);
+    int log_start = stub_log_count;
+    for (int i = 0; i < 10 && storage_journal_pending() > 0; i++)
+    {
+        assert(storage_flush() == 0);
+    }
+    assert(storage_journal_pending() == 0);
+    assert(stub_log_count == log_start + 4);
+    assert(strcmp(stub_log[log_start], "mot") == 0 && strcmp(stub_log[log_start + 1], "hai") == 0);
+    assert(strcmp(stub_log[log_start + 2], "ba") == 0 && strcmp(stub_log[log_start + 3], "bi tu choi") == 0);
+    assert(storage_get_game_history(alice, entries, 4) == 1 && entries[0].score == 10);
+
+    // Journal trong: ghi lai di thang backend va co id
+    assert(storage_save_chat_message(room, player, "bon") == 4);
+    storage_close();
+    remove(TEST_JOURNAL_PATH);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Storage Tests (memory, sqlite, journal) ===\n\n");
+
+    test_open_close();
+    test_users();
+    test_words();
+    test_game_records();
+    test_history();
+    test_sqlite();
+    test_journal_outage();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
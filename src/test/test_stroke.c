@@ -0,0 +1,150 @@
+#include "../include/stroke.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_stroke.c server/stroke.c server/drawing.c -o test_stroke
+
+/**
+ * Test 1: RDP voi cac diem thang hang
+ * Muc dich: Duong thang chi con lai 2 diem dau/cuoi
+ */
+void test_rdp_collinear()
+{
+    printf("Test 1: RDP collinear... ");
+    stroke_point_t points[50];
+    for (int i = 0; i < 50; i++)
+    {
+        points[i].x = (uint16_t)(10 + i * 2);
+        points[i].y = (uint16_t)(20 + i);
+    }
+
+    int kept = stroke_simplify_rdp(points, 50, 1.0);
+    assert(kept == 2);
+    assert(points[0].x == 10 && points[0].y == 20);
+    assert(points[1].x == 108 && points[1].y == 69);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: RDP giu goc
+ * Muc dich: Hinh chu L giu lai diem goc, tolerance <= 0 giu nguyen
+ */
+void test_rdp_corner()
+{
+    printf("Test 2: RDP keeps corner... ");
+    stroke_point_t points[21];
+    for (int i = 0; i <= 10; i++)
+    {
+        points[i].x = (uint16_t)(i * 10);
+        points[i].y = 0;
+    }
+    for (int i = 1; i <= 10; i++)
+    {
+        points[10 + i].x = 100;
+        points[10 + i].y = (uint16_t)(i * 10);
+    }
+
+    stroke_point_t copy[21];
+    memcpy(copy, points, sizeof(points));
+    assert(stroke_simplify_rdp(copy, 21, 0.0) == 21);
+
+    int kept = stroke_simplify_rdp(points, 21, 1.0);
+    assert(kept == 3);
+    assert(points[1].x == 100 && points[1].y == 0);
+
+    // Net khep kin (diem dau == diem cuoi) van giu diem xa nhat
+    stroke_point_t loop[5] = {{0, 0}, {50, 0}, {50, 50}, {0, 50}, {0, 0}};
+    assert(stroke_simplify_rdp(loop, 5, 1.0) >= 3);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Gom doan thanh net
+ * Muc dich: Doan lien mach cung but noi vao net, doi mau hoac ngat quang mo net moi
+ */
+void test_log_append()
+{
+    printf("Test 3: Stroke log append... ");
+    stroke_log_t *log = stroke_log_create(1.0);
+    draw_action_t a;
+
+    // 10 doan thang hang lien mach
+    for (int i = 0; i < 10; i++)
+    {
+        drawing_create_line_action((uint16_t)(i * 5), 100, (uint16_t)((i + 1) * 5), 100, 0x000000FF, 3, &a);
+        assert(stroke_log_append(log, &a) == 0);
+    }
+    assert(log->stroke_count == 1);
+    assert(log->strokes[0].point_count == 11);
+    assert(log->raw_points == 11);
+
+    // Doi mau -> net moi, net cu duoc don gian hoa
+    drawing_create_line_action(50, 100, 60, 110, 0xFF0000FF, 3, &a);
+    stroke_log_append(log, &a);
+    assert(log->stroke_count == 2);
+    assert(log->strokes[0].point_count == 2);
+
+    // MOVE dong net
+    a.action = DRAW_ACTION_MOVE;
+    stroke_log_append(log, &a);
+    assert(log->last_open == false);
+    assert(log->stored_points == 4);
+
+    // CLEAR xoa log
+    drawing_create_clear_action(&a);
+    stroke_log_append(log, &a);
+    assert(log->stroke_count == 0);
+    assert(log->stored_points == 0);
+
+    stroke_log_destroy(log);
+    printf("PASSED\n");
+}
+
+static int count_segment(const draw_action_t *action, void *ctx)
+{
+    int *count = (int *)ctx;
+    assert(action->action == DRAW_ACTION_LINE);
+    assert(drawing_validate_action(action));
+    (*count)++;
+    return 0;
+}
+
+/**
+ * Test 4: Phat lai log
+ * Muc dich: So doan phat lai bang so diem giu lai tru so net
+ */
+void test_log_replay()
+{
+    printf("Test 4: Stroke log replay... ");
+    stroke_log_t *log = stroke_log_create(1.0);
+    draw_action_t a;
+
+    for (int i = 0; i < 20; i++)
+    {
+        drawing_create_line_action((uint16_t)(i * 4), (uint16_t)(i * 4), (uint16_t)((i + 1) * 4),
+                                   (uint16_t)((i + 1) * 4), 0x00FF00FF, 5, &a);
+        stroke_log_append(log, &a);
+    }
+    stroke_log_finish(log);
+
+    int segments = 0;
+    assert(stroke_log_replay(log, count_segment, &segments) == 1);
+    assert(segments == 1);
+
+    stroke_log_destroy(log);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Stroke Module Tests ===\n\n");
+
+    test_rdp_collinear();
+    test_rdp_corner();
+    test_log_append();
+    test_log_replay();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
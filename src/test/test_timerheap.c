@@ -0,0 +1,128 @@
+#include "../include/timerheap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+// Bien dich: gcc -Iinclude test/test_timerheap.c server/timerheap.c -o test_timerheap
+
+/**
+ * Test 1: Lay timer theo thu tu han chot
+ * Muc dich: pop_expired chi tra ve timer da den han, theo thu tu tang dan
+ */
+void test_order()
+{
+    printf("Test 1: Expiry order... ");
+    timerheap_t heap;
+    assert(timerheap_init(&heap, 8) == 0);
+    timerheap_set(&heap, 3, 300);
+    timerheap_set(&heap, 1, 100);
+    timerheap_set(&heap, 5, 500);
+    timerheap_set(&heap, 2, 200);
+
+    int id;
+    uint64_t deadline;
+    assert(timerheap_peek(&heap, &id, &deadline) == 0 && id == 1 && deadline == 100);
+    assert(timerheap_pop_expired(&heap, 50) == -1);
+    assert(timerheap_pop_expired(&heap, 250) == 1);
+    assert(timerheap_pop_expired(&heap, 250) == 2);
+    assert(timerheap_pop_expired(&heap, 250) == -1);
+    assert(heap.size == 2);
+    timerheap_free(&heap);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Doi han va huy timer
+ * Muc dich: Dat lai id da co chi cap nhat vi tri, huy id o giua heap giu dung thu tu
+ */
+void test_update_remove()
+{
+    printf("Test 2: Reschedule and remove... ");
+    timerheap_t heap;
+    assert(timerheap_init(&heap, 8) == 0);
+    for (int i = 0; i < 8; i++)
+    {
+        timerheap_set(&heap, i, (uint64_t)(100 + i * 10));
+    }
+    timerheap_set(&heap, 0, 1000); // Doi timer som nhat ra sau cung
+    timerheap_set(&heap, 7, 5);    // Doi timer muon nhat len dau
+    timerheap_remove(&heap, 3);
+    timerheap_remove(&heap, 3);    // Huy hai lan khong sao
+    assert(heap.size == 7);
+    assert(timerheap_set(&heap, 8, 1) == -1);
+
+    const int expected[] = {7, 1, 2, 4, 5, 6, 0};
+    for (int i = 0; i < 7; i++)
+    {
+        assert(timerheap_pop_expired(&heap, 10000) == expected[i]);
+    }
+    assert(timerheap_peek(&heap, NULL, NULL) == -1);
+    timerheap_free(&heap);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Thao tac ngau nhien
+ * Muc dich: Heap luon tra ve han chot nho nhat so voi mang tham chieu
+ */
+void test_random()
+{
+    printf("Test 3: Random operations... ");
+    enum { N = 64 };
+    timerheap_t heap;
+    assert(timerheap_init(&heap, N) == 0);
+    uint64_t ref[N];
+    for (int i = 0; i < N; i++)
+    {
+        ref[i] = 0; // 0 = khong co timer
+    }
+
+    srand(42);
+    for (int step = 0; step < 20000; step++)
+    {
+        int id = rand() % N;
+        if (rand() % 3 == 0)
+        {
+            timerheap_remove(&heap, id);
+            ref[id] = 0;
+        }
+        else
+        {
+            uint64_t deadline = 1 + (uint64_t)(rand() % 100000);
+            timerheap_set(&heap, id, deadline);
+            ref[id] = deadline;
+        }
+
+        uint64_t min = 0;
+        for (int i = 0; i < N; i++)
+        {
+            if (ref[i] && (!min || ref[i] < min))
+            {
+                min = ref[i];
+            }
+        }
+        uint64_t top;
+        if (min == 0)
+        {
+            assert(timerheap_peek(&heap, NULL, &top) == -1);
+        }
+        else
+        {
+            assert(timerheap_peek(&heap, NULL, &top) == 0 && top == min);
+        }
+    }
+    timerheap_free(&heap);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Timer Heap Tests ===\n\n");
+
+    test_order();
+    test_update_remove();
+    test_random();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "../common/wire.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Bien dich: gcc -Icommon test/test_wire.c common/wire.c -o test_wire
+
+/**
+ * Test 1: So nguyen big-endian
+ * Muc dich: Ghi roi doc lai dung gia tri va dung thu tu byte tren wire
+ */
+void test_integers()
+{
+    printf("Test 1: Integers round-trip... ");
+    uint8_t buf[32];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u8(&w, 0xAB);
+    wire_put_u16(&w, 0x1234);
+    wire_put_u32(&w, 0xDEADBEEF);
+    wire_put_i32(&w, -2);
+    wire_put_u64(&w, 0x0102030405060708ULL);
+    assert(!w.overflow);
+    assert(w.len == 1 + 2 + 4 + 4 + 8);
+    assert(buf[1] == 0x12 && buf[2] == 0x34);
+    assert(buf[3] == 0xDE && buf[6] == 0xEF);
+
+    wire_reader_t r;
+    wire_reader_init(&r, buf, w.len);
+    assert(wire_get_u8(&r) == 0xAB);
+    assert(wire_get_u16(&r) == 0x1234);
+    assert(wire_get_u32(&r) == 0xDEADBEEF);
+    assert(wire_get_i32(&r) == -2);
+    assert(wire_get_u64(&r) == 0x0102030405060708ULL);
+    assert(!r.overflow && r.pos == r.len);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 2: Chuoi co tien to do dai
+ * Muc dich: Chuoi rong, NULL va chuoi thuong chi ton len + 1 byte
+ */
+void test_strings()
+{
+    printf("Test 2: Length-prefixed strings... ");
+    uint8_t buf[64];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_string(&w, "alice", 31);
+    wire_put_string(&w, "", 31);
+    wire_put_string(&w, NULL, 31);
+    assert(!w.overflow);
+    assert(w.len == 6 + 1 + 1);
+    assert(buf[0] == 5 && memcmp(buf + 1, "alice", 5) == 0);
+
+    char out[32];
+    wire_reader_t r;
+    wire_reader_init(&r, buf, w.len);
+    assert(wire_get_string(&r, out, sizeof(out)) == 5);
+    assert(strcmp(out, "alice") == 0);
+    assert(wire_get_string(&r, out, sizeof(out)) == 0 && out[0] == '\0');
+    assert(wire_get_string(&r, out, sizeof(out)) == 0);
+
+    // Buffer dich nho hon chuoi: cat nhung van null-terminated
+    wire_reader_init(&r, buf, w.len);
+    assert(wire_get_string(&r, out, 3) == 2);
+    assert(strcmp(out, "al") == 0);
+    assert(r.pos == 6);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 3: Cat chuoi UTF-8
+ * Muc dich: Khong cat doi ky tu nhieu byte khi vuot max_len
+ */
+void test_utf8_truncation()
+{
+    printf("Test 3: UTF-8 truncation... ");
+    // "ab" + U+1EC7 (3 byte: E1 BB 87)
+    const char *s = "ab\xE1\xBB\x87";
+    uint8_t buf[16];
+    wire_writer_t w;
+
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_string(&w, s, 4);
+    assert(buf[0] == 2);
+
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_string(&w, s, 5);
+    assert(buf[0] == 5);
+
+    // Gioi han tren cua tien to 1 byte
+    char long_str[400];
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = '\0';
+    uint8_t big[300];
+    wire_writer_init(&w, big, sizeof(big));
+    wire_put_string(&w, long_str, 1000);
+    assert(big[0] == WIRE_MAX_STRING_LEN);
+    assert(w.len == 1 + WIRE_MAX_STRING_LEN);
+    printf("PASSED\n");
+}
+
+/**
+ * Test 4: Tran buffer
+ * Muc dich: Writer/reader danh dau overflow thay vi ghi/doc ngoai buffer
+ */
+void test_overflow()
+{
+    printf("Test 4: Overflow detection... ");
+    uint8_t buf[4];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u16(&w, 1);
+    wire_put_string(&w, "hello", 31);
+    assert(w.overflow);
+    assert(w.len <= sizeof(buf));
+
+    // Tien to noi co 10 byte nhung payload chi con 3
+    const uint8_t truncated[] = {10, 'a', 'b', 'c'};
+    char out[16];
+    wire_reader_t r;
+    wire_reader_init(&r, truncated, sizeof(truncated));
+    assert(wire_get_string(&r, out, sizeof(out)) == -1);
+    assert(r.overflow && out[0] == '\0');
+    assert(wire_get_u32(&r) == 0);
+    printf("PASSED\n");
+}
+
+int main()
+{
+    printf("=== Wire Encoding Tests ===\n\n");
+
+    test_integers();
+    test_strings();
+    test_utf8_truncation();
+    test_overflow();
+
+    printf("\n=== Tat ca tests PASSED! ===\n");
+    return 0;
+}
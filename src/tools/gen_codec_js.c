@@ -0,0 +1,144 @@
+#include "../common/schema.h"
+#include <stdio.h>
+
+// Sinh gateway/codec.js tu common/schema.h (cung nguon voi codec C)
+// Bien dich + chay: make codec-js
+
+#define JS_FIELD(kind, name, size) \
+    printf("        ['%s', '%s', %d],\n", #kind, #name, (int)(size));
+
+#define JS_SCHEMA(name, NAME) \
+    printf("    %s: [\n", #name); \
+    SCHEMA_##NAME(JS_FIELD) \
+    printf("    ],\n");
+
+static const char *js_header =
+    "// FILE SINH TU DONG tu common/schema.h boi tools/gen_codec_js.c - KHONG SUA TAY\n"
+    "// Chay lai: make codec-js\n"
+    "//\n"
+    "// Moi schema la danh sach [kind, name, size] theo thu tu tren wire:\n"
+    "//   U8, U16, U32, I32, U64  so nguyen big-endian (U64 tra ve Number)\n"
+    "//   FSTR                    char[size] co dinh, dem '\\0'\n"
+    "//   STR                     [len:1][UTF-8 bytes], toi da size - 1 bytes\n"
+    "'use strict';\n"
+    "\n"
+    "const SCHEMAS = {\n";
+
+static const char *js_runtime =
+    "};\n"
+    "\n"
+    "function fieldSize(kind, size) {\n"
+    "    switch (kind) {\n"
+    "        case 'U8': return 1;\n"
+    "        case 'U16': return 2;\n"
+    "        case 'U32': case 'I32': return 4;\n"
+    "        case 'U64': return 8;\n"
+    "        default: return size;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// So byte toi da tren wire (= chinh xac neu schema khong co STR)\n"
+    "function maxSize(name) {\n"
+    "    return SCHEMAS[name].reduce((sum, [kind, , size]) => sum + fieldSize(kind, size), 0);\n"
+    "}\n"
+    "\n"
+    "// Cat chuoi UTF-8 toi da maxBytes, khong cat doi ky tu nhieu byte\n"
+    "function utf8Truncate(value, maxBytes) {\n"
+    "    let bytes = Buffer.from(value == null ? '' : String(value), 'utf8');\n"
+    "    if (bytes.length <= maxBytes) return bytes;\n"
+    "    let len = maxBytes;\n"
+    "    while (len > 0 && (bytes[len] & 0xC0) === 0x80) len--;\n"
+    "    return bytes.subarray(0, len);\n"
+    "}\n"
+    "\n"
+    "// Doc mot schema tu payload bat dau tai state.offset (state.offset duoc cap nhat)\n"
+    "// Nem RangeError neu payload thieu du lieu\n"
+    "function read(name, payload, state) {\n"
+    "    const out = {};\n"
+    "    for (const [kind, field, size] of SCHEMAS[name]) {\n"
+    "        const need = kind === 'STR' ? 1 : fieldSize(kind, size);\n"
+    "        if (state.offset + need > payload.length) {\n"
+    "            throw new RangeError(`${name}.${field} exceeds payload`);\n"
+    "        }\n"
+    "        switch (kind) {\n"
+    "            case 'U8': out[field] = payload.readUInt8(state.offset); break;\n"
+    "            case 'U16': out[field] = payload.readUInt16BE(state.offset); break;\n"
+    "            case 'U32': out[field] = payload.readUInt32BE(state.offset); break;\n"
+    "            case 'I32': out[field] = payload.readInt32BE(state.offset); break;\n"
+    "            case 'U64':\n"
+    "                out[field] = payload.readUInt32BE(state.offset) * 4294967296 +\n"
+    "                    payload.readUInt32BE(state.offset + 4);\n"
+    "                break;\n"
+    "            case 'FSTR': {\n"
+    "                const raw = payload.subarray(state.offset, state.offset + size);\n"
+    "                const end = raw.indexOf(0);\n"
+    "                out[field] = raw.subarray(0, end < 0 ? raw.length : end).toString('utf8');\n"
+    "                break;\n"
+    "            }\n"
+    "            case 'STR': {\n"
+    "                const len = payload.readUInt8(state.offset);\n"
+    "                if (state.offset + 1 + len > payload.length) {\n"
+    "                    throw new RangeError(`${name}.${field} exceeds payload`);\n"
+    "                }\n"
+    "                out[field] = payload.subarray(state.offset + 1, state.offset + 1 + len).toString('utf8');\n"
+    "                state.offset += len;\n"
+    "                break;\n"
+    "            }\n"
+    "        }\n"
+    "        state.offset += need;\n"
+    "    }\n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "function decode(name, payload) {\n"
+    "    return read(name, payload, { offset: 0 });\n"
+    "}\n"
+    "\n"
+    "// Ma hoa mot schema thanh Buffer (truong thieu = 0 / chuoi rong)\n"
+    "function encode(name, values) {\n"
+    "    const buffer = Buffer.alloc(maxSize(name));\n"
+    "    let offset = 0;\n"
+    "    for (const [kind, field, size] of SCHEMAS[name]) {\n"
+    "        const value = values[field];\n"
+    "        switch (kind) {\n"
+    "            case 'U8': buffer.writeUInt8((value || 0) & 0xFF, offset); break;\n"
+    "            case 'U16': buffer.writeUInt16BE((value || 0) & 0xFFFF, offset); break;\n"
+    "            case 'U32': buffer.writeUInt32BE((value || 0) >>> 0, offset); break;\n"
+    "            case 'I32': buffer.writeInt32BE((value || 0) | 0, offset); break;\n"
+    "            case 'U64': {\n"
+    "                const v = value || 0;\n"
+    "                buffer.writeUInt32BE(Math.floor(v / 4294967296) >>> 0, offset);\n"
+    "                buffer.writeUInt32BE(v >>> 0, offset + 4);\n"
+    "                break;\n"
+    "            }\n"
+    "            case 'FSTR':\n"
+    "                utf8Truncate(value, size - 1).copy(buffer, offset);\n"
+    "                break;\n"
+    "            case 'STR': {\n"
+    "                const bytes = utf8Truncate(value, size - 1);\n"
+    "                buffer.writeUInt8(bytes.length, offset);\n"
+    "                bytes.copy(buffer, offset + 1);\n"
+    "                offset += bytes.length + 1;\n"
+    "                continue;\n"
+    "            }\n"
+    "        }\n"
+    "        offset += fieldSize(kind, size);\n"
+    "    }\n"
+    "    return buffer.subarray(0, offset);\n"
+    "}\n"
+    "\n"
+    "module.exports = {\n"
+    "    SCHEMAS,\n"
+    "    maxSize,\n"
+    "    read,\n"
+    "    decode,\n"
+    "    encode\n"
+    "};\n";
+
+int main(void)
+{
+    fputs(js_header, stdout);
+    PROTOCOL_SCHEMAS(JS_SCHEMA)
+    fputs(js_runtime, stdout);
+    return 0;
+}